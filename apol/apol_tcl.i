@@ -108,7 +108,7 @@ static char *tcl_get_error(void)
 	 * open.
 	 */
 	apol_policy_t *apol_tcl_open_policy(const apol_policy_path_t *ppath, Tcl_Interp *interp) {
-		apol_policy_t *p = apol_policy_create_from_policy_path(ppath, QPOL_POLICY_OPTION_NO_NEVERALLOWS,
+		apol_policy_t *p = apol_policy_create_from_policy_path(ppath, QPOL_POLICY_OPTION_NO_NEVERALLOWS | QPOL_POLICY_OPTION_SORTED_RULES,
 								       apol_tcl_route_apol_to_string, interp);
 		if (p == NULL && message == NULL) {  // Assume lower level has generated error message
 			if (errno != 0) {   // otherwise take a guess at it
@@ -320,6 +320,27 @@ static char *tcl_get_error(void)
 	char *apol_tcl_syn_terule_render(apol_policy_t *policy, qpol_syn_terule_t *rule) {
 		return apol_tcl_malloc_to_new(apol_syn_terule_render(policy, rule));
 	}
+
+	/**
+	 * Return the policy's memory usage as a Tcl list of name,
+	 * bytes, and count triples.
+	 */
+	char *apol_tcl_get_memory_usage(apol_policy_t *policy) {
+		apol_vector_t *v = apol_policy_get_memory_usage(policy);
+		char *s = NULL;
+		size_t i, len = 0;
+		if (v == NULL) {
+			return apol_tcl_malloc_to_new(NULL);
+		}
+		for (i = 0; i < apol_vector_get_size(v); i++) {
+			const apol_memory_usage_t *u = static_cast<const apol_memory_usage_t *>(apol_vector_get_element(v, i));
+			if (apol_str_appendf(&s, &len, "{%s} %zu %zu ", u->name, u->bytes, u->count) < 0) {
+				break;
+			}
+		}
+		apol_vector_destroy(&v);
+		return apol_tcl_malloc_to_new(s);
+	}
 %}
 %newobject apol_tcl_avrule_render(apol_policy_t *policy, qpol_avrule_t *rule);
 char *apol_tcl_avrule_render(apol_policy_t *policy, qpol_avrule_t *rule);
@@ -329,6 +350,8 @@ char *apol_tcl_terule_render(apol_policy_t *policy, qpol_terule_t *rule);
 char *apol_tcl_syn_avrule_render(apol_policy_t *policy, qpol_syn_avrule_t *rule);
 %newobject apol_tcl_syn_terule_render(apol_policy_t *policy, qpol_syn_terule_t *rule);
 char *apol_tcl_syn_terule_render(apol_policy_t *policy, qpol_syn_terule_t *rule);
+%newobject apol_tcl_get_memory_usage(apol_policy_t *policy);
+char *apol_tcl_get_memory_usage(apol_policy_t *policy);
 
 
 void apol_tcl_avrule_sort(apol_policy_t *policy, apol_vector_t *v);
@@ -175,7 +175,7 @@ proc ApolTop::loadNeverAllows {} {
     if {![is_capable "neverallow"]} {
         Apol_Progress_Dialog::wait "Loading neverallow rules" "Rebuilding policy" \
             {
-                $::ApolTop::qpolicy rebuild 0
+                $::ApolTop::qpolicy rebuild $::QPOL_POLICY_OPTION_SORTED_RULES
                 _toplevel_update_stats
             }
     }
@@ -958,6 +958,23 @@ proc ApolTop::_show_policy_summary {} {
         incr i
     }
     grid $f $g -sticky nw -padx 4
+
+    set ltext "Memory Usage (bytes, objects):"
+    set rtext {}
+    set total 0
+    foreach {name bytes count} [apol_tcl_get_memory_usage $::ApolTop::policy] {
+        append ltext "\n    $name:"
+        append rtext "\n$bytes\t$count"
+        incr total $bytes
+    }
+    append ltext "\n    total:"
+    append rtext "\n$total"
+    set m [frame $w.memory]
+    label $m.l -justify left -text $ltext
+    label $m.r -justify left -text $rtext
+    grid $m.l $m.r -sticky w -padx 4 -pady 2
+    grid [Separator $w.sep2] - -sticky ew -pady 5
+    grid $m - -sticky nw -padx 4
     $dialog draw
 }
 
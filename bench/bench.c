@@ -0,0 +1,78 @@
+/**
+ * @file
+ *
+ * Timing and reporting routines shared by the SETools benchmarks.
+ *
+ * Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+
+static long bench_peak_rss(void)
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) < 0) {
+		return -1;
+	}
+	return usage.ru_maxrss;
+}
+
+void bench_now(bench_mark_t * m)
+{
+	m->peak_rss_kb = bench_peak_rss();
+	clock_gettime(CLOCK_MONOTONIC, &m->time);
+}
+
+double bench_elapsed_ms(const bench_mark_t * start, const bench_mark_t * end)
+{
+	return (end->time.tv_sec - start->time.tv_sec) * 1000.0 + (end->time.tv_nsec - start->time.tv_nsec) / 1000000.0;
+}
+
+long bench_peak_rss_growth(const bench_mark_t * start, const bench_mark_t * end)
+{
+	if (start->peak_rss_kb < 0 || end->peak_rss_kb < 0) {
+		return -1;
+	}
+	return end->peak_rss_kb - start->peak_rss_kb;
+}
+
+void bench_print_header(void)
+{
+	printf("label\tbenchmark\twall_ms\tpeak_rss_growth_kb\tcount\tper_sec\n");
+	fflush(stdout);
+}
+
+void bench_print_ms(const char *label, const char *name, double ms, long peak_rss_growth_kb, size_t count)
+{
+	double rate = 0.0;
+	if (ms > 0.0) {
+		rate = count * 1000.0 / ms;
+	}
+	printf("%s\t%s\t%.3f\t%ld\t%zu\t%.0f\n", label, name, ms, peak_rss_growth_kb, count, rate);
+	fflush(stdout);
+}
+
+void bench_print_result(const char *label, const char *name, const bench_mark_t * start, const bench_mark_t * end,
+			size_t count)
+{
+	bench_print_ms(label, name, bench_elapsed_ms(start, end), bench_peak_rss_growth(start, end), count);
+}
@@ -0,0 +1,100 @@
+/**
+ * @file
+ *
+ * Timing and reporting routines shared by the SETools benchmarks.
+ * Every benchmark writes one tab-separated line of label, benchmark
+ * name, wall clock milliseconds, growth in peak resident set size in
+ * kilobytes while the operation ran, the number of items that the operation found or processed, and
+ * that number divided by the elapsed seconds.
+ *
+ * Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SETOOLS_BENCH_H
+#define SETOOLS_BENCH_H
+
+#ifdef	__cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <time.h>
+
+/** A reading of the clock and of the process's peak memory use. */
+	typedef struct bench_mark
+	{
+		struct timespec time;
+		/** peak resident set size in kilobytes, or -1 if unknown */
+		long peak_rss_kb;
+	} bench_mark_t;
+
+/**
+ * Read the monotonic clock and this process's peak resident set
+ * size.
+ */
+	extern void bench_now(bench_mark_t * m);
+
+/**
+ * Return the number of milliseconds between two readings of
+ * bench_now().
+ */
+	extern double bench_elapsed_ms(const bench_mark_t * start, const bench_mark_t * end);
+
+/**
+ * Return how many kilobytes the peak resident set size grew between
+ * two readings of bench_now(), or -1 if it could not be determined.
+ * The peak only ever rises, so an operation that reuses memory freed
+ * by an earlier one reports less than it allocated.
+ */
+	extern long bench_peak_rss_growth(const bench_mark_t * start, const bench_mark_t * end);
+
+/**
+ * Write the line of column names.
+ */
+	extern void bench_print_header(void);
+
+/**
+ * Write one benchmark's result line.
+ *
+ * @param label Value of the first column, identifying the data set.
+ * @param name Name of the benchmark.
+ * @param start Clock reading from before the operation.
+ * @param end Clock reading from after the operation.
+ * @param count Number of items that the operation found or processed.
+ */
+	extern void bench_print_result(const char *label, const char *name, const bench_mark_t * start,
+				       const bench_mark_t * end, size_t count);
+
+/**
+ * Write the result line of a benchmark that was timed by other
+ * means, such as a library's own phase statistics.
+ *
+ * @param label Value of the first column, identifying the data set.
+ * @param name Name of the benchmark.
+ * @param ms Elapsed wall clock milliseconds.
+ * @param peak_rss_growth_kb Growth in peak resident set size, or -1
+ * if unknown.
+ * @param count Number of items that the operation found or processed.
+ */
+	extern void bench_print_ms(const char *label, const char *name, double ms, long peak_rss_growth_kb, size_t count);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,424 @@
+/**
+ * @file
+ *
+ * Generate a synthetic SELinux audit log for benchmarking libseaudit.
+ * The log mixes AVC denials and grants for file, directory,
+ * capability, network, and IPC accesses, each with the fields that
+ * the kernel reports for that kind of object, along with occasional
+ * boolean changes and policy loads.  Either the syslog format (as
+ * written by klogd) or the auditd format (as written to audit.log)
+ * may be produced.  The same options and seed always produce the same
+ * log.
+ *
+ * Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* size of a scale 1 log */
+#define DEFAULT_MESSAGES 100000
+/* same as gen-policy's default, so that type names match its policies */
+#define DEFAULT_TYPES 3000
+#define DEFAULT_HOSTS 4
+#define DEFAULT_GRANTED 5
+
+/** one boolean change is written per this many messages */
+#define MESSAGES_PER_BOOL 1000
+/** one policy load is written per this many messages */
+#define MESSAGES_PER_LOAD 20000
+/** number of booleans from which changes are drawn */
+#define NUM_BOOLS 200
+
+/** 2010-01-01 00:00:00 UTC */
+#define START_TIME 1262304000
+
+enum gen_opt
+{
+	OPT_MESSAGES = 256, OPT_TYPES, OPT_HOSTS, OPT_GRANTED, OPT_FORMAT, OPT_SCALE, OPT_SEED
+};
+
+static struct option const longopts[] = {
+	{"messages", required_argument, NULL, OPT_MESSAGES},
+	{"types", required_argument, NULL, OPT_TYPES},
+	{"hosts", required_argument, NULL, OPT_HOSTS},
+	{"granted", required_argument, NULL, OPT_GRANTED},
+	{"format", required_argument, NULL, OPT_FORMAT},
+	{"scale", required_argument, NULL, OPT_SCALE},
+	{"seed", required_argument, NULL, OPT_SEED},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0}
+};
+
+typedef enum gen_format
+{
+	GEN_FORMAT_SYSLOG, GEN_FORMAT_AUDITD
+} gen_format_e;
+
+/** kinds of AVC messages, each with a different set of fields */
+typedef enum gen_avc_kind
+{
+	GEN_AVC_FILE, GEN_AVC_DIR, GEN_AVC_EXEC, GEN_AVC_CAP, GEN_AVC_NET, GEN_AVC_NODE, GEN_AVC_IPC, GEN_AVC_NUM
+} gen_avc_kind_e;
+
+/** relative likelihood of each kind of AVC message */
+static const unsigned int avc_weights[GEN_AVC_NUM] = { 40, 20, 8, 10, 10, 6, 6 };
+
+static const char *const file_perms[] = { "read", "write", "getattr", "open", "append", "unlink", "lock", "ioctl" };
+static const char *const dir_perms[] = { "search", "read", "write", "add_name", "remove_name", "getattr" };
+static const char *const exec_perms[] = { "execute", "execute_no_trans", "entrypoint" };
+static const char *const cap_names[] = { "chown", "dac_override", "dac_read_search", "fowner", "kill", "setuid", "net_admin",
+	"sys_admin"
+};
+static const unsigned int cap_nums[] = { 0, 1, 2, 3, 5, 7, 12, 21 };
+static const char *const net_perms[] = { "name_connect", "name_bind", "recv_msg", "send_msg" };
+static const char *const ipc_perms[] = { "read", "write", "associate", "unix_read", "unix_write" };
+static const char *const comms[] = {
+	"httpd", "sshd", "crond", "named", "smbd", "postfix", "sendmail", "mysqld", "cupsd", "dhclient",
+	"rpcbind", "ntpd", "syslogd", "hald", "dbus-daemon", "java", "python", "bash", "xauth", "mount"
+};
+static const char *const devs[] = { "sda1", "sda2", "dm-0", "dm-1", "tmpfs" };
+static const char *const months[] = {
+	"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+#define NUM_OF(a) (sizeof(a) / sizeof(a[0]))
+
+typedef struct gen
+{
+	size_t num_types, num_hosts;
+	unsigned int granted;
+	gen_format_e format;
+	uint64_t rng;
+	/** current time and audit serial number */
+	time_t now;
+	unsigned int msec, serial;
+} gen_t;
+
+static void usage(const char *program_name, int brief)
+{
+	printf("Usage: %s [OPTIONS]\n", program_name);
+	if (brief) {
+		printf("\n   Try %s --help for more help.\n\n", program_name);
+		return;
+	}
+	printf("Write a synthetic SELinux audit log to standard output.\n\n");
+	printf("  --messages=N       number of AVC messages (default %d)\n", DEFAULT_MESSAGES);
+	printf("  --types=N          number of types in contexts (default %d)\n", DEFAULT_TYPES);
+	printf("  --hosts=N          number of host names (default %d)\n", DEFAULT_HOSTS);
+	printf("  --granted=PERCENT  percentage of AVCs that are grants (default %d)\n", DEFAULT_GRANTED);
+	printf("  --format=FORMAT    syslog (default) or auditd\n");
+	printf("  --scale=N          multiply the default number of messages by N\n");
+	printf("  --seed=N           seed for the random number generator\n");
+	printf("  -h, --help         print this help text and exit\n\n");
+}
+
+/** xorshift64* */
+static uint64_t gen_next(uint64_t * state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * UINT64_C(2685821657736338717);
+}
+
+static size_t gen_uniform(uint64_t * state, size_t n)
+{
+	return (size_t) (gen_next(state) % n);
+}
+
+/**
+ * Pick a type index such that low numbered types are much more
+ * common, as a few domains account for most of a real log.
+ */
+static size_t gen_pick_type(gen_t * g)
+{
+	return gen_uniform(&g->rng, gen_uniform(&g->rng, g->num_types) + 1);
+}
+
+static gen_avc_kind_e gen_pick_kind(gen_t * g)
+{
+	unsigned int total = 0, r;
+	size_t i;
+	for (i = 0; i < GEN_AVC_NUM; i++) {
+		total += avc_weights[i];
+	}
+	r = (unsigned int)gen_uniform(&g->rng, total);
+	for (i = 0; r >= avc_weights[i]; i++) {
+		r -= avc_weights[i];
+	}
+	return (gen_avc_kind_e) i;
+}
+
+/**
+ * Advance the clock and write the header that precedes a message's
+ * body.  Syslog lines begin with the date, host, and kernel; auditd
+ * records begin with the record type.  Both then carry the audit
+ * timestamp and serial number.
+ */
+static void gen_header(gen_t * g, const char *record_type)
+{
+	struct tm tm;
+	g->msec += (unsigned int)gen_uniform(&g->rng, 2000);
+	g->now += g->msec / 1000;
+	g->msec %= 1000;
+	g->serial++;
+	if (g->format == GEN_FORMAT_AUDITD) {
+		printf("type=%s msg=audit(%lu.%03u:%u): ", record_type, (unsigned long)g->now, g->msec, g->serial);
+	} else {
+		gmtime_r(&g->now, &tm);
+		printf("%s %2d %02d:%02d:%02d host%zu kernel: audit(%lu.%03u:%u): ", months[tm.tm_mon], tm.tm_mday, tm.tm_hour,
+		       tm.tm_min, tm.tm_sec, gen_uniform(&g->rng, g->num_hosts), (unsigned long)g->now, g->msec, g->serial);
+	}
+}
+
+/**
+ * Write a syslog line without an audit header, as the kernel does
+ * for boolean changes and policy loads.
+ */
+static void gen_kernel_header(gen_t * g)
+{
+	struct tm tm;
+	gmtime_r(&g->now, &tm);
+	printf("%s %2d %02d:%02d:%02d host%zu kernel: ", months[tm.tm_mon], tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+	       gen_uniform(&g->rng, g->num_hosts));
+}
+
+/**
+ * Write one to three distinct permissions from a list.
+ */
+static void gen_perms(gen_t * g, const char *const *perms, size_t num_perms)
+{
+	size_t first = gen_uniform(&g->rng, num_perms), num = gen_uniform(&g->rng, 3) + 1, i;
+	if (num > num_perms) {
+		num = num_perms;
+	}
+	for (i = 0; i < num; i++) {
+		printf(" %s", perms[(first + i) % num_perms]);
+	}
+}
+
+static void gen_avc(gen_t * g)
+{
+	gen_avc_kind_e kind = gen_pick_kind(g);
+	size_t src = gen_pick_type(g), tgt = gen_pick_type(g), cap;
+	const char *comm = comms[src % NUM_OF(comms)], *tclass;
+	unsigned int pid = 1000 + (unsigned int)gen_uniform(&g->rng, 30000);
+
+	gen_header(g, "AVC");
+	printf("avc:  %s  {", gen_uniform(&g->rng, 100) < g->granted ? "granted" : "denied");
+	switch (kind) {
+	case GEN_AVC_FILE:
+		gen_perms(g, file_perms, NUM_OF(file_perms));
+		printf(" } for  pid=%u comm=\"%s\" name=\"file%zu\" dev=%s ino=%lu", pid, comm, gen_uniform(&g->rng, 1000),
+		       devs[tgt % NUM_OF(devs)], (unsigned long)gen_uniform(&g->rng, 1000000) + 1);
+		tclass = "file";
+		break;
+	case GEN_AVC_DIR:
+		gen_perms(g, dir_perms, NUM_OF(dir_perms));
+		printf(" } for  pid=%u comm=\"%s\" name=\"dir%zu\" dev=%s ino=%lu", pid, comm, gen_uniform(&g->rng, 100),
+		       devs[tgt % NUM_OF(devs)], (unsigned long)gen_uniform(&g->rng, 1000000) + 1);
+		tclass = "dir";
+		break;
+	case GEN_AVC_EXEC:
+		gen_perms(g, exec_perms, NUM_OF(exec_perms));
+		/* older kernels report the full path, which may contain spaces */
+		printf(" } for  pid=%u comm=\"%s\" path=\"/usr/lib/type%zu/bin/%s%s\" dev=%s ino=%lu", pid, comm, tgt, comm,
+		       gen_uniform(&g->rng, 10) == 0 ? " helper" : "", devs[tgt % NUM_OF(devs)],
+		       (unsigned long)gen_uniform(&g->rng, 1000000) + 1);
+		tclass = "file";
+		break;
+	case GEN_AVC_CAP:
+		cap = gen_uniform(&g->rng, NUM_OF(cap_names));
+		printf(" %s } for  pid=%u comm=\"%s\" capability=%u", cap_names[cap], pid, comm, cap_nums[cap]);
+		/* capability checks are always upon the subject itself */
+		tgt = src;
+		tclass = "capability";
+		break;
+	case GEN_AVC_NET:
+		gen_perms(g, net_perms, NUM_OF(net_perms));
+		printf(" } for  pid=%u comm=\"%s\" laddr=10.0.%zu.%zu lport=%zu faddr=10.1.%zu.%zu fport=%zu", pid, comm,
+		       gen_uniform(&g->rng, 256), gen_uniform(&g->rng, 256), gen_uniform(&g->rng, 64512) + 1024,
+		       gen_uniform(&g->rng, 256), gen_uniform(&g->rng, 256), gen_uniform(&g->rng, 1024));
+		tclass = "tcp_socket";
+		break;
+	case GEN_AVC_NODE:
+		printf(" name_bind } for  pid=%u comm=\"%s\" src=%zu saddr=10.0.%zu.%zu netif=eth%zu", pid, comm,
+		       gen_uniform(&g->rng, 1024), gen_uniform(&g->rng, 256), gen_uniform(&g->rng, 256), gen_uniform(&g->rng, 2));
+		tclass = "udp_socket";
+		break;
+	case GEN_AVC_IPC:
+	default:
+		gen_perms(g, ipc_perms, NUM_OF(ipc_perms));
+		printf(" } for  pid=%u comm=\"%s\" key=%zu", pid, comm, gen_uniform(&g->rng, 100000));
+		tclass = "sem";
+		break;
+	}
+	printf(" scontext=%s_u:%s_r:type%zu_t:s0 tcontext=system_u:%s:type%zu_t:s0 tclass=%s\n",
+	       src % 5 == 0 ? "user" : "system", src % 5 == 0 ? "user" : "system", src, kind == GEN_AVC_CAP
+	       || kind == GEN_AVC_IPC ? "system_r" : "object_r", tgt, tclass);
+	if (g->format == GEN_FORMAT_AUDITD) {
+		/* auditd follows each AVC with the system call record,
+		 * which libseaudit skips */
+		printf("type=SYSCALL msg=audit(%lu.%03u:%u): arch=40000003 syscall=5 success=no exit=-13 a0=bf8d5a7c a1=8000"
+		       " a2=0 a3=8000 items=0 ppid=1 pid=%u auid=4294967295 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0"
+		       " sgid=0 fsgid=0 tty=(none) comm=\"%s\" exe=\"/usr/sbin/%s\" subj=system_u:system_r:type%zu_t:s0"
+		       " key=(null)\n", (unsigned long)g->now, g->msec, g->serial, pid, comm, comm, src);
+	}
+}
+
+static void gen_bool(gen_t * g)
+{
+	size_t num = gen_uniform(&g->rng, 3) + 1, first = gen_uniform(&g->rng, NUM_BOOLS), i;
+	if (g->format == GEN_FORMAT_AUDITD) {
+		/* auditd records each change separately */
+		for (i = 0; i < num; i++) {
+			unsigned int val = (unsigned int)gen_uniform(&g->rng, 2);
+			gen_header(g, "MAC_CONFIG_CHANGE");
+			printf("bool=bool%zu val=%u old_val=%u auid=500 ses=1\n", (first + i) % NUM_BOOLS, val, !val);
+		}
+		return;
+	}
+	gen_kernel_header(g);
+	printf("security: committed booleans {");
+	for (i = 0; i < num; i++) {
+		printf(" bool%zu:%zu%s", (first + i) % NUM_BOOLS, gen_uniform(&g->rng, 2), i + 1 < num ? "," : "");
+	}
+	printf(" }\n");
+}
+
+static void gen_load(gen_t * g)
+{
+	size_t types = g->num_types + gen_uniform(&g->rng, 10);
+	if (g->format == GEN_FORMAT_AUDITD) {
+		gen_header(g, "MAC_POLICY_LOAD");
+		printf("policy loaded auid=500 ses=1\n");
+		return;
+	}
+	/* the kernel splits the summary across two lines */
+	gen_kernel_header(g);
+	printf("security:  3 users, 6 roles, %zu types, %d bools, 1 sens, 256 cats\n", types, NUM_BOOLS);
+	gen_kernel_header(g);
+	printf("security:  59 classes, %zu rules\n", types * 20);
+}
+
+static size_t parse_size(const char *arg, const char *name)
+{
+	char *end;
+	unsigned long n;
+	errno = 0;
+	n = strtoul(arg, &end, 10);
+	if (errno != 0 || *arg == '\0' || *end != '\0') {
+		fprintf(stderr, "Invalid value for --%s: %s\n", name, arg);
+		exit(1);
+	}
+	return (size_t) n;
+}
+
+int main(int argc, char **argv)
+{
+	gen_t g;
+	size_t i, scale = 1, messages = 0;
+	int optc, have_messages = 0;
+	uint64_t seed = 1;
+
+	memset(&g, 0, sizeof(g));
+	g.num_types = DEFAULT_TYPES;
+	g.num_hosts = DEFAULT_HOSTS;
+	g.granted = DEFAULT_GRANTED;
+	g.format = GEN_FORMAT_SYSLOG;
+	while ((optc = getopt_long(argc, argv, "h", longopts, NULL)) != -1) {
+		switch (optc) {
+		case OPT_MESSAGES:
+			messages = parse_size(optarg, "messages");
+			have_messages = 1;
+			break;
+		case OPT_TYPES:
+			g.num_types = parse_size(optarg, "types");
+			break;
+		case OPT_HOSTS:
+			g.num_hosts = parse_size(optarg, "hosts");
+			break;
+		case OPT_GRANTED:
+			g.granted = (unsigned int)parse_size(optarg, "granted");
+			break;
+		case OPT_FORMAT:
+			if (strcmp(optarg, "syslog") == 0) {
+				g.format = GEN_FORMAT_SYSLOG;
+			} else if (strcmp(optarg, "auditd") == 0) {
+				g.format = GEN_FORMAT_AUDITD;
+			} else {
+				fprintf(stderr, "Invalid value for --format: %s\n", optarg);
+				exit(1);
+			}
+			break;
+		case OPT_SCALE:
+			scale = parse_size(optarg, "scale");
+			break;
+		case OPT_SEED:
+			seed = parse_size(optarg, "seed");
+			break;
+		case 'h':
+			usage(argv[0], 0);
+			exit(0);
+		default:
+			usage(argv[0], 1);
+			exit(1);
+		}
+	}
+	if (optind < argc) {
+		usage(argv[0], 1);
+		exit(1);
+	}
+	if (!have_messages) {
+		messages = DEFAULT_MESSAGES * scale;
+	}
+	if (g.num_types == 0 || g.num_hosts == 0) {
+		fprintf(stderr, "A log needs at least one type and one host.\n");
+		exit(1);
+	}
+	if (g.granted > 100) {
+		fprintf(stderr, "Invalid value for --granted: %u\n", g.granted);
+		exit(1);
+	}
+	/* a zero state would make xorshift return zeroes forever */
+	g.rng = seed * UINT64_C(0x9e3779b97f4a7c15) + 1;
+	g.now = START_TIME;
+
+	gen_load(&g);
+	for (i = 1; i <= messages; i++) {
+		gen_avc(&g);
+		if (i % MESSAGES_PER_BOOL == 0) {
+			gen_bool(&g);
+		}
+		if (i % MESSAGES_PER_LOAD == 0) {
+			gen_load(&g);
+		}
+	}
+	if (fflush(stdout) != 0 || ferror(stdout)) {
+		fprintf(stderr, "Could not write log: %s\n", strerror(errno));
+		exit(1);
+	}
+	return 0;
+}
@@ -0,0 +1,290 @@
+/**
+ * @file
+ *
+ * Generate a synthetic labeled directory tree for benchmarking
+ * libsefs.  Files are spread across a tree of directories, some of
+ * them symbolic links, and each is given an SELinux context through
+ * its security.selinux extended attribute.  A file_contexts file
+ * whose entries describe the tree's labeling is written to standard
+ * output.  The same options and seed always produce the same tree.
+ *
+ * Setting security.selinux requires privilege, and on an SELinux
+ * system the contexts must also be valid for the loaded policy; when
+ * labeling is refused the tree keeps whatever labels the system gave
+ * it.
+ *
+ * Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+/* size of a scale 1 tree */
+#define DEFAULT_FILES 20000
+#define DEFAULT_FANOUT 16
+/* same as gen-policy's default, so that type names match its policies */
+#define DEFAULT_TYPES 3000
+
+/** one file per this many is a shared library with its own type */
+#define FILES_PER_LIB 8
+/** one file per this many is a symbolic link */
+#define FILES_PER_LINK 50
+
+#define XATTR_NAME_SELINUX "security.selinux"
+
+/** room for a root and a relative path, each up to PATH_MAX, and a
+ *  file name */
+#define GEN_PATH_MAX (2 * PATH_MAX + 32)
+
+enum gen_opt
+{
+	OPT_FILES = 256, OPT_FANOUT, OPT_TYPES, OPT_SCALE, OPT_SEED
+};
+
+static struct option const longopts[] = {
+	{"files", required_argument, NULL, OPT_FILES},
+	{"fanout", required_argument, NULL, OPT_FANOUT},
+	{"types", required_argument, NULL, OPT_TYPES},
+	{"scale", required_argument, NULL, OPT_SCALE},
+	{"seed", required_argument, NULL, OPT_SEED},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0}
+};
+
+typedef struct gen
+{
+	size_t num_files, fanout, num_types, num_dirs;
+	/** offset added to each directory's type, chosen by the seed */
+	size_t type_offset;
+	/** non-zero once labeling has been refused, to stop trying */
+	int no_label;
+	size_t num_labeled, num_entries;
+} gen_t;
+
+static void usage(const char *program_name, int brief)
+{
+	printf("Usage: %s [OPTIONS] ROOT\n", program_name);
+	if (brief) {
+		printf("\n   Try %s --help for more help.\n\n", program_name);
+		return;
+	}
+	printf("Create a synthetic labeled directory tree within the existing directory\n");
+	printf("ROOT, and write a file_contexts describing it to standard output.\n\n");
+	printf("  --files=N          number of files (default %d)\n", DEFAULT_FILES);
+	printf("  --fanout=N         files and subdirectories per directory (default %d)\n", DEFAULT_FANOUT);
+	printf("  --types=N          number of types in contexts (default %d)\n", DEFAULT_TYPES);
+	printf("  --scale=N          multiply the default number of files by N\n");
+	printf("  --seed=N           seed that chooses the types of directories\n");
+	printf("  -h, --help         print this help text and exit\n\n");
+}
+
+static size_t gen_dir_type(const gen_t * g, size_t dir)
+{
+	return (dir + g->type_offset) % g->num_types;
+}
+
+/**
+ * Write the path of a directory, relative to the root; directory 0 is
+ * the root itself and directory k is a child of directory
+ * (k - 1) / fanout.
+ */
+static void gen_dir_path(const gen_t * g, size_t dir, char *buf, size_t len)
+{
+	char tmp[PATH_MAX];
+	buf[0] = '\0';
+	while (dir > 0) {
+		snprintf(tmp, sizeof(tmp), "/d%zu%s", dir, buf);
+		snprintf(buf, len, "%s", tmp);
+		dir = (dir - 1) / g->fanout;
+	}
+}
+
+static void gen_label(gen_t * g, const char *path, size_t type)
+{
+	char con[64];
+	if (g->no_label) {
+		return;
+	}
+	snprintf(con, sizeof(con), "system_u:object_r:type%zu_t:s0", type);
+	if (lsetxattr(path, XATTR_NAME_SELINUX, con, strlen(con) + 1, 0) < 0) {
+		fprintf(stderr, "Could not label %s (%s); leaving the tree's existing labels.\n", path, strerror(errno));
+		g->no_label = 1;
+		return;
+	}
+	g->num_labeled++;
+}
+
+/**
+ * Write a path to standard output as a file_contexts regular
+ * expression.
+ */
+static void gen_print_regex(const char *path)
+{
+	for (; *path != '\0'; path++) {
+		if (strchr(".^$*+?()[]{}|\\", *path) != NULL) {
+			putchar('\\');
+		}
+		putchar(*path);
+	}
+}
+
+static int gen_dir(gen_t * g, const char *root, size_t dir)
+{
+	char rel[PATH_MAX], path[GEN_PATH_MAX];
+	size_t type = gen_dir_type(g, dir);
+	gen_dir_path(g, dir, rel, sizeof(rel));
+	snprintf(path, sizeof(path), "%s%s", root, rel);
+	if (dir > 0 && mkdir(path, 0755) < 0 && errno != EEXIST) {
+		fprintf(stderr, "Could not create %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	gen_label(g, path, type);
+	gen_print_regex(path);
+	printf("(/.*)?\tsystem_u:object_r:type%zu_t:s0\n", type);
+	gen_print_regex(path);
+	printf("/.*\\.so\t--\tsystem_u:object_r:type%zu_t:s0\n", (type + 1) % g->num_types);
+	g->num_entries += 2;
+	return 0;
+}
+
+static int gen_file(gen_t * g, const char *root, size_t file)
+{
+	char rel[PATH_MAX], path[GEN_PATH_MAX], target[32];
+	size_t dir = file / g->fanout, type = gen_dir_type(g, dir);
+	int fd;
+	gen_dir_path(g, dir, rel, sizeof(rel));
+	if (file % FILES_PER_LINK == FILES_PER_LINK - 1) {
+		snprintf(path, sizeof(path), "%s%s/l%zu", root, rel, file);
+		snprintf(target, sizeof(target), "f%zu", file - 1);
+		if (symlink(target, path) < 0 && errno != EEXIST) {
+			fprintf(stderr, "Could not create %s: %s\n", path, strerror(errno));
+			return -1;
+		}
+	} else {
+		if (file % FILES_PER_LIB == FILES_PER_LIB - 1) {
+			snprintf(path, sizeof(path), "%s%s/f%zu.so", root, rel, file);
+			type = (type + 1) % g->num_types;
+		} else {
+			snprintf(path, sizeof(path), "%s%s/f%zu", root, rel, file);
+		}
+		if ((fd = open(path, O_WRONLY | O_CREAT, 0644)) < 0) {
+			fprintf(stderr, "Could not create %s: %s\n", path, strerror(errno));
+			return -1;
+		}
+		close(fd);
+	}
+	gen_label(g, path, type);
+	return 0;
+}
+
+static size_t parse_size(const char *arg, const char *name)
+{
+	char *end;
+	unsigned long n;
+	errno = 0;
+	n = strtoul(arg, &end, 10);
+	if (errno != 0 || *arg == '\0' || *end != '\0') {
+		fprintf(stderr, "Invalid value for --%s: %s\n", name, arg);
+		exit(1);
+	}
+	return (size_t) n;
+}
+
+int main(int argc, char **argv)
+{
+	gen_t g;
+	size_t i, scale = 1, files = 0;
+	int optc, have_files = 0;
+	uint64_t seed = 1;
+	char root[PATH_MAX];
+
+	memset(&g, 0, sizeof(g));
+	g.fanout = DEFAULT_FANOUT;
+	g.num_types = DEFAULT_TYPES;
+	while ((optc = getopt_long(argc, argv, "h", longopts, NULL)) != -1) {
+		switch (optc) {
+		case OPT_FILES:
+			files = parse_size(optarg, "files");
+			have_files = 1;
+			break;
+		case OPT_FANOUT:
+			g.fanout = parse_size(optarg, "fanout");
+			break;
+		case OPT_TYPES:
+			g.num_types = parse_size(optarg, "types");
+			break;
+		case OPT_SCALE:
+			scale = parse_size(optarg, "scale");
+			break;
+		case OPT_SEED:
+			seed = parse_size(optarg, "seed");
+			break;
+		case 'h':
+			usage(argv[0], 0);
+			exit(0);
+		default:
+			usage(argv[0], 1);
+			exit(1);
+		}
+	}
+	if (argc - optind != 1) {
+		usage(argv[0], 1);
+		exit(1);
+	}
+	if (realpath(argv[optind], root) == NULL) {
+		fprintf(stderr, "Could not open %s: %s\n", argv[optind], strerror(errno));
+		exit(1);
+	}
+	g.num_files = (have_files ? files : DEFAULT_FILES * scale);
+	if (g.fanout < 2 || g.num_types < 2) {
+		fprintf(stderr, "The fan-out and number of types must be at least 2.\n");
+		exit(1);
+	}
+	g.num_dirs = g.num_files / g.fanout + 1;
+	g.type_offset = (size_t) (seed % g.num_types);
+
+	/* parents are always created before their children */
+	for (i = 0; i < g.num_dirs; i++) {
+		if (gen_dir(&g, root, i) < 0) {
+			exit(1);
+		}
+	}
+	for (i = 0; i < g.num_files; i++) {
+		if (gen_file(&g, root, i) < 0) {
+			exit(1);
+		}
+	}
+	if (fflush(stdout) != 0 || ferror(stdout)) {
+		fprintf(stderr, "Could not write file contexts: %s\n", strerror(errno));
+		exit(1);
+	}
+	fprintf(stderr, "Created %zu directories and %zu files, labeled %zu, with %zu file context entries.\n", g.num_dirs,
+		g.num_files, g.num_labeled, g.num_entries);
+	return 0;
+}
@@ -0,0 +1,542 @@
+/**
+ * @file
+ *
+ * Generate a synthetic policy.conf for benchmarking.  The size and
+ * shape of the policy are set by command line options; the same
+ * options and seed always produce the same policy, so results may be
+ * compared across builds.  A second, slightly different policy for
+ * semantic diffing may be produced by passing --mutate.
+ *
+ * Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* sizes of a scale 1 policy, roughly that of a current reference policy */
+#define DEFAULT_TYPES 3000
+#define DEFAULT_ATTRIBS 600
+#define DEFAULT_FANOUT 4
+#define DEFAULT_RULES 60000
+#define DEFAULT_BOOLS 200
+#define DEFAULT_CATS 256
+
+/** percentage of rules placed within conditional blocks */
+#define COND_PERCENT 10
+/** one domain transition is generated per this many types */
+#define TYPES_PER_TRANSITION 4
+
+enum gen_opt
+{
+	OPT_TYPES = 256, OPT_ATTRIBS, OPT_FANOUT, OPT_RULES, OPT_BOOLS, OPT_CATS, OPT_SCALE, OPT_SEED, OPT_MUTATE
+};
+
+static struct option const longopts[] = {
+	{"types", required_argument, NULL, OPT_TYPES},
+	{"attributes", required_argument, NULL, OPT_ATTRIBS},
+	{"fanout", required_argument, NULL, OPT_FANOUT},
+	{"rules", required_argument, NULL, OPT_RULES},
+	{"bools", required_argument, NULL, OPT_BOOLS},
+	{"categories", required_argument, NULL, OPT_CATS},
+	{"scale", required_argument, NULL, OPT_SCALE},
+	{"seed", required_argument, NULL, OPT_SEED},
+	{"mutate", required_argument, NULL, OPT_MUTATE},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0}
+};
+
+typedef struct gen_class
+{
+	const char *name;
+	const char *const *perms;
+	size_t num_perms;
+	/** relative likelihood of a rule using this class */
+	unsigned int weight;
+} gen_class_t;
+
+static const char *const file_perms[] = {
+	"ioctl", "read", "write", "create", "getattr", "setattr", "lock", "relabelfrom", "relabelto",
+	"append", "unlink", "link", "rename", "execute", "execute_no_trans", "entrypoint"
+};
+static const char *const dir_perms[] = {
+	"ioctl", "read", "write", "create", "getattr", "setattr", "lock", "relabelfrom", "relabelto",
+	"append", "unlink", "link", "rename", "execute", "add_name", "remove_name", "search", "rmdir"
+};
+static const char *const process_perms[] = {
+	"fork", "transition", "signal", "ptrace", "setexec", "getattr", "dyntransition"
+};
+static const char *const filesystem_perms[] = {
+	"mount", "unmount", "getattr", "relabelfrom", "relabelto", "associate"
+};
+
+/** number of permissions within the file common */
+#define NUM_COMMON_PERMS 14
+
+static const gen_class_t classes[] = {
+	{"file", file_perms, sizeof(file_perms) / sizeof(file_perms[0]), 6},
+	{"dir", dir_perms, sizeof(dir_perms) / sizeof(dir_perms[0]), 3},
+	{"process", process_perms, sizeof(process_perms) / sizeof(process_perms[0]), 2},
+	{"filesystem", filesystem_perms, sizeof(filesystem_perms) / sizeof(filesystem_perms[0]), 1}
+};
+
+#define NUM_CLASSES (sizeof(classes) / sizeof(classes[0]))
+#define CLASS_FILE 0
+#define CLASS_PROCESS 2
+
+typedef struct gen
+{
+	size_t num_types, num_attribs, fanout, num_rules, num_bools, num_cats;
+	/** percentage of elements to alter, or 0 for the original policy */
+	unsigned int mutate;
+	/** generator for the policy's structure; identical for the
+	 *  original and the mutated policy */
+	uint64_t rng;
+	/** generator that decides what to mutate */
+	uint64_t mutate_rng;
+	/** open-addressed set of (source, target, class) keys of type
+	 *  rules already written, to avoid conflicting type rules */
+	uint64_t *te_keys;
+	size_t te_keys_cap;
+} gen_t;
+
+static void usage(const char *program_name, int brief)
+{
+	printf("Usage: %s [OPTIONS]\n", program_name);
+	if (brief) {
+		printf("\n   Try %s --help for more help.\n\n", program_name);
+		return;
+	}
+	printf("Write a synthetic policy.conf to standard output.\n\n");
+	printf("  --types=N          number of types (default %d)\n", DEFAULT_TYPES);
+	printf("  --attributes=N     number of attributes (default %d)\n", DEFAULT_ATTRIBS);
+	printf("  --fanout=N         average attributes per type (default %d)\n", DEFAULT_FANOUT);
+	printf("  --rules=N          number of av and type rules (default %d)\n", DEFAULT_RULES);
+	printf("  --bools=N          number of booleans (default %d)\n", DEFAULT_BOOLS);
+	printf("  --categories=N     number of MLS categories, 0 for non-MLS (default %d)\n", DEFAULT_CATS);
+	printf("  --scale=N          multiply the default types, attributes, rules,\n");
+	printf("                     and booleans by N\n");
+	printf("  --seed=N           seed for the random number generator\n");
+	printf("  --mutate=PERCENT   alter about PERCENT of the policy, for diffing\n");
+	printf("                     against the unmutated policy with the same seed\n");
+	printf("  -h, --help         print this help text and exit\n\n");
+}
+
+/** xorshift64* */
+static uint64_t gen_next(uint64_t * state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * UINT64_C(2685821657736338717);
+}
+
+static size_t gen_uniform(uint64_t * state, size_t n)
+{
+	return (size_t) (gen_next(state) % n);
+}
+
+/**
+ * Return non-zero if the current element of the policy should be
+ * altered.  The mutation generator is only consulted when mutating,
+ * so that the structure generator stays in step with the original.
+ */
+static int gen_mutated(gen_t * g)
+{
+	return g->mutate > 0 && gen_uniform(&g->mutate_rng, 100) < g->mutate;
+}
+
+static const char *gen_mls(const gen_t * g)
+{
+	return g->num_cats > 0 ? ":s0" : "";
+}
+
+/**
+ * Record a type rule's key.  Return 0 if the key is new, 1 if a rule
+ * with the same key was already written.
+ */
+static int gen_te_key_insert(gen_t * g, size_t src, size_t tgt, size_t cls)
+{
+	uint64_t key = ((uint64_t) src << 36) ^ ((uint64_t) tgt << 8) ^ (uint64_t) cls ^ (UINT64_C(1) << 63);
+	size_t i = (size_t) ((key * UINT64_C(0x9e3779b97f4a7c15)) >> 20) & (g->te_keys_cap - 1);
+	while (g->te_keys[i] != 0) {
+		if (g->te_keys[i] == key) {
+			return 1;
+		}
+		i = (i + 1) & (g->te_keys_cap - 1);
+	}
+	g->te_keys[i] = key;
+	return 0;
+}
+
+static void gen_print_type_or_attrib(gen_t * g, size_t which)
+{
+	if (which < g->num_types) {
+		printf("type%zu_t", which);
+	} else {
+		printf("attr%zu", which - g->num_types);
+	}
+}
+
+/**
+ * Pick a rule's source or target: a type, or occasionally an
+ * attribute.  Attributes are numbered after the types.
+ */
+static size_t gen_pick_subject(gen_t * g)
+{
+	if (g->num_attribs > 0 && gen_uniform(&g->rng, 4) == 0) {
+		return g->num_types + gen_uniform(&g->rng, g->num_attribs);
+	}
+	return gen_uniform(&g->rng, g->num_types);
+}
+
+static size_t gen_pick_class(gen_t * g)
+{
+	size_t i, total = 0, n;
+	for (i = 0; i < NUM_CLASSES; i++) {
+		total += classes[i].weight;
+	}
+	n = gen_uniform(&g->rng, total);
+	for (i = 0; n >= classes[i].weight; i++) {
+		n -= classes[i].weight;
+	}
+	return i;
+}
+
+static void gen_print_perms(uint32_t perms, const gen_class_t * c)
+{
+	size_t i, num = 0;
+	for (i = 0; i < c->num_perms; i++) {
+		if (perms & (UINT32_C(1) << i)) {
+			num++;
+		}
+	}
+	fputs(num > 1 ? "{" : "", stdout);
+	for (i = 0; i < c->num_perms; i++) {
+		if (perms & (UINT32_C(1) << i)) {
+			printf(num > 1 ? " %s" : "%s", c->perms[i]);
+		}
+	}
+	fputs(num > 1 ? " }" : "", stdout);
+}
+
+static void gen_header(const gen_t * g)
+{
+	size_t i, j;
+	for (i = 0; i < NUM_CLASSES; i++) {
+		printf("class %s\n", classes[i].name);
+	}
+	printf("\nsid kernel\nsid unlabeled\nsid fs\n\n");
+	printf("common file {");
+	for (i = 0; i < NUM_COMMON_PERMS; i++) {
+		printf(" %s", file_perms[i]);
+	}
+	printf(" }\n");
+	for (i = 0; i < NUM_CLASSES; i++) {
+		const gen_class_t *c = classes + i;
+		if (strcmp(c->name, "file") == 0 || strcmp(c->name, "dir") == 0) {
+			printf("class %s inherits file {", c->name);
+			j = NUM_COMMON_PERMS;
+		} else {
+			printf("class %s {", c->name);
+			j = 0;
+		}
+		for (; j < c->num_perms; j++) {
+			printf(" %s", c->perms[j]);
+		}
+		printf(" }\n");
+	}
+	if (g->num_cats > 0) {
+		printf("\nsensitivity s0;\ndominance { s0 }\n");
+		for (i = 0; i < g->num_cats; i++) {
+			printf("category c%zu;\n", i);
+		}
+		printf("level s0:c0.c%zu;\n", g->num_cats - 1);
+		printf("mlsconstrain file { write } ( h1 dom h2 );\n");
+	}
+	printf("\n");
+}
+
+static void gen_types(gen_t * g)
+{
+	size_t i, j, k, num, *chosen = NULL;
+	for (i = 0; i < g->num_attribs; i++) {
+		printf("attribute attr%zu;\n", i);
+	}
+	if (g->num_attribs > 0 && (chosen = malloc((2 * g->fanout + 1) * sizeof(*chosen))) == NULL) {
+		fprintf(stderr, "%s\n", strerror(errno));
+		exit(1);
+	}
+	for (i = 0; i < g->num_types; i++) {
+		printf("type type%zu_t", i);
+		num = (g->num_attribs > 0 ? gen_uniform(&g->rng, 2 * g->fanout + 1) : 0);
+		for (j = 0; j < num; j++) {
+			chosen[j] = gen_uniform(&g->rng, g->num_attribs);
+			for (k = 0; k < j && chosen[k] != chosen[j]; k++) ;
+			if (k < j) {
+				continue;
+			}
+			/* the mutated policy drops some type's last attribute */
+			if (j == num - 1 && gen_mutated(g)) {
+				continue;
+			}
+			printf(", attr%zu", chosen[j]);
+		}
+		printf(";\n");
+	}
+	free(chosen);
+	for (i = 0; i < g->num_bools; i++) {
+		printf("bool bool%zu %s;\n", i, gen_uniform(&g->rng, 2) ? "true" : "false");
+	}
+	printf("\n");
+}
+
+/**
+ * Write one av or type rule.  Conditional rules are wrapped within
+ * their own conditional block.
+ */
+static void gen_rule(gen_t * g)
+{
+	static const char *const av_kinds[] = { "allow", "allow", "allow", "allow", "allow", "allow",
+		"allow", "allow", "dontaudit", "auditallow"
+	};
+	static const char *const te_kinds[] = { "type_transition", "type_change", "type_member" };
+	size_t kind = gen_uniform(&g->rng, 20), cls = gen_pick_class(g), src, tgt;
+	const gen_class_t *c = classes + cls;
+	int cond = (g->num_bools > 0 && gen_uniform(&g->rng, 100) < COND_PERCENT);
+	size_t b1 = (g->num_bools > 0 ? gen_uniform(&g->rng, g->num_bools) : 0);
+	size_t b2 = (g->num_bools > 0 ? gen_uniform(&g->rng, g->num_bools) : 0);
+	int two_bools = (gen_uniform(&g->rng, 4) == 0 && b1 != b2);
+	if (kind < 17) {
+		uint32_t perms = 0;
+		size_t i, num_perms = 1 + gen_uniform(&g->rng, 4);
+		int self = (gen_uniform(&g->rng, 10) == 0);
+		src = gen_pick_subject(g);
+		tgt = gen_pick_subject(g);
+		for (i = 0; i < num_perms; i++) {
+			perms |= UINT32_C(1) << gen_uniform(&g->rng, c->num_perms);
+		}
+		if (gen_mutated(g)) {
+			if (gen_uniform(&g->mutate_rng, 2)) {
+				return;
+			}
+			perms ^= UINT32_C(1) << gen_uniform(&g->mutate_rng, c->num_perms);
+			if (perms == 0) {
+				return;
+			}
+		}
+		if (cond) {
+			printf(two_bools ? "if (bool%zu && bool%zu) {\n" : "if (bool%zu) {\n", b1, b2);
+		}
+		printf("%s ", av_kinds[kind % (sizeof(av_kinds) / sizeof(av_kinds[0]))]);
+		gen_print_type_or_attrib(g, src);
+		printf(" ");
+		if (self) {
+			printf("self");
+		} else {
+			gen_print_type_or_attrib(g, tgt);
+		}
+		printf(":%s ", c->name);
+		gen_print_perms(perms, c);
+		printf(";\n");
+	} else {
+		/* type rules name only types, so that no two expand
+		 * into conflicting rules */
+		size_t dflt;
+		src = gen_uniform(&g->rng, g->num_types);
+		tgt = gen_uniform(&g->rng, g->num_types);
+		dflt = gen_uniform(&g->rng, g->num_types);
+		if (gen_te_key_insert(g, src, tgt, cls)) {
+			return;
+		}
+		if (gen_mutated(g)) {
+			if (gen_uniform(&g->mutate_rng, 2)) {
+				return;
+			}
+			dflt = gen_uniform(&g->mutate_rng, g->num_types);
+		}
+		if (cond) {
+			printf(two_bools ? "if (bool%zu && bool%zu) {\n" : "if (bool%zu) {\n", b1, b2);
+		}
+		printf("%s type%zu_t type%zu_t:%s type%zu_t;\n", te_kinds[kind - 17], src, tgt, c->name, dflt);
+	}
+	if (cond) {
+		printf("}\n");
+	}
+}
+
+/**
+ * Write the rules for a complete domain transition, starting from
+ * type0_t and then cycling through all types.
+ */
+static void gen_transition(gen_t * g, size_t i)
+{
+	size_t dom = i % g->num_types;
+	size_t ep = gen_uniform(&g->rng, g->num_types);
+	size_t new_dom = gen_uniform(&g->rng, g->num_types);
+	int has_type_trans = !gen_te_key_insert(g, dom, ep, CLASS_PROCESS);
+	if (gen_mutated(g)) {
+		return;
+	}
+	printf("allow type%zu_t type%zu_t:file { getattr read execute };\n", dom, ep);
+	printf("allow type%zu_t type%zu_t:process transition;\n", dom, new_dom);
+	printf("allow type%zu_t type%zu_t:file entrypoint;\n", new_dom, ep);
+	if (has_type_trans) {
+		printf("type_transition type%zu_t type%zu_t:process type%zu_t;\n", dom, ep, new_dom);
+	}
+}
+
+static void gen_footer(const gen_t * g)
+{
+	size_t i;
+	const char *mls = gen_mls(g);
+	printf("\n");
+	for (i = 0; i < g->num_types; i++) {
+		printf("role system_r types type%zu_t;\n", i);
+	}
+	printf("\nuser system_u roles { system_r }");
+	if (g->num_cats > 0) {
+		printf(" level s0 range s0 - s0:c0.c%zu", g->num_cats - 1);
+	}
+	printf(";\n\n");
+	printf("sid kernel system_u:system_r:type0_t%s\n", mls);
+	printf("sid unlabeled system_u:object_r:type0_t%s\n", mls);
+	printf("sid fs system_u:object_r:type0_t%s\n\n", mls);
+	printf("fs_use_xattr ext3 system_u:object_r:type0_t%s;\n", mls);
+	printf("genfscon proc / system_u:object_r:type0_t%s\n", mls);
+	for (i = 0; i <= g->num_types / 100; i++) {
+		printf("portcon tcp %zu system_u:object_r:type%zu_t%s\n", 1024 + i, i % g->num_types, mls);
+	}
+	printf("nodecon 127.0.0.1 255.255.255.255 system_u:object_r:type0_t%s\n", mls);
+}
+
+static size_t parse_size(const char *arg, const char *name)
+{
+	char *end;
+	unsigned long n;
+	errno = 0;
+	n = strtoul(arg, &end, 10);
+	if (errno != 0 || *arg == '\0' || *end != '\0') {
+		fprintf(stderr, "Invalid value for --%s: %s\n", name, arg);
+		exit(1);
+	}
+	return (size_t) n;
+}
+
+int main(int argc, char **argv)
+{
+	gen_t g;
+	size_t i, scale = 1, num_trans;
+	/* options given explicitly, which are not scaled */
+	size_t types = 0, attribs = 0, rules = 0, bools = 0;
+	int optc, have_types = 0, have_attribs = 0, have_rules = 0, have_bools = 0;
+	uint64_t seed = 1;
+
+	memset(&g, 0, sizeof(g));
+	g.fanout = DEFAULT_FANOUT;
+	g.num_cats = DEFAULT_CATS;
+	while ((optc = getopt_long(argc, argv, "h", longopts, NULL)) != -1) {
+		switch (optc) {
+		case OPT_TYPES:
+			types = parse_size(optarg, "types");
+			have_types = 1;
+			break;
+		case OPT_ATTRIBS:
+			attribs = parse_size(optarg, "attributes");
+			have_attribs = 1;
+			break;
+		case OPT_FANOUT:
+			g.fanout = parse_size(optarg, "fanout");
+			break;
+		case OPT_RULES:
+			rules = parse_size(optarg, "rules");
+			have_rules = 1;
+			break;
+		case OPT_BOOLS:
+			bools = parse_size(optarg, "bools");
+			have_bools = 1;
+			break;
+		case OPT_CATS:
+			g.num_cats = parse_size(optarg, "categories");
+			break;
+		case OPT_SCALE:
+			scale = parse_size(optarg, "scale");
+			break;
+		case OPT_SEED:
+			seed = parse_size(optarg, "seed");
+			break;
+		case OPT_MUTATE:
+			g.mutate = (unsigned int)parse_size(optarg, "mutate");
+			break;
+		case 'h':
+			usage(argv[0], 0);
+			exit(0);
+		default:
+			usage(argv[0], 1);
+			exit(1);
+		}
+	}
+	if (optind < argc) {
+		usage(argv[0], 1);
+		exit(1);
+	}
+	g.num_types = (have_types ? types : DEFAULT_TYPES * scale);
+	g.num_attribs = (have_attribs ? attribs : DEFAULT_ATTRIBS * scale);
+	g.num_rules = (have_rules ? rules : DEFAULT_RULES * scale);
+	g.num_bools = (have_bools ? bools : DEFAULT_BOOLS * scale);
+	if (g.num_types == 0) {
+		fprintf(stderr, "A policy needs at least one type.\n");
+		exit(1);
+	}
+	if (g.mutate > 100) {
+		fprintf(stderr, "Invalid value for --mutate: %u\n", g.mutate);
+		exit(1);
+	}
+	/* a zero state would make xorshift return zeroes forever */
+	g.rng = seed * UINT64_C(0x9e3779b97f4a7c15) + 1;
+	g.mutate_rng = (seed ^ UINT64_C(0x5deece66d)) * UINT64_C(0x9e3779b97f4a7c15) + 1;
+	num_trans = g.num_types / TYPES_PER_TRANSITION + 1;
+	for (g.te_keys_cap = 64; g.te_keys_cap < 2 * (g.num_rules + num_trans); g.te_keys_cap *= 2) ;
+	if ((g.te_keys = calloc(g.te_keys_cap, sizeof(*g.te_keys))) == NULL) {
+		fprintf(stderr, "%s\n", strerror(errno));
+		exit(1);
+	}
+
+	printf("# synthetic policy: %zu types, %zu attributes, fan-out %zu, %zu rules, %zu booleans, %zu categories,"
+	       " seed %llu, mutate %u%%\n\n", g.num_types, g.num_attribs, g.fanout, g.num_rules, g.num_bools, g.num_cats,
+	       (unsigned long long)seed, g.mutate);
+	gen_header(&g);
+	gen_types(&g);
+	for (i = 0; i < num_trans; i++) {
+		gen_transition(&g, i);
+	}
+	for (i = 0; i < g.num_rules; i++) {
+		gen_rule(&g);
+	}
+	gen_footer(&g);
+	free(g.te_keys);
+	if (fflush(stdout) != 0 || ferror(stdout)) {
+		fprintf(stderr, "Could not write policy: %s\n", strerror(errno));
+		exit(1);
+	}
+	return 0;
+}
@@ -0,0 +1,396 @@
+/**
+ * @file
+ *
+ * Time libseaudit's handling of an audit log: parsing it from a file
+ * and from memory, building models that filter and sort its
+ * messages, recomputing a model after its filter changes, and writing
+ * reports.  Results are written in the format described in bench.h;
+ * counts are numbers of messages, so that the last column gives
+ * messages per second.
+ *
+ * Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+/* libapol */
+#include <apol/policy.h>
+#include <apol/util.h>
+#include <apol/vector.h>
+
+/* libseaudit */
+#include <seaudit/avc_message.h>
+#include <seaudit/filter.h>
+#include <seaudit/log.h>
+#include <seaudit/model.h>
+#include <seaudit/parse.h>
+#include <seaudit/report.h>
+#include <seaudit/sort.h>
+
+/* other */
+#include "bench.h"
+#include <errno.h>
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_CONFIG TOP_SRCDIR "/seaudit/seaudit-report.conf"
+#define DEFAULT_STYLESHEET TOP_SRCDIR "/seaudit/seaudit-report.css"
+
+/** the filter accepts denials from this many of gen-auditlog's most
+ *  common source types */
+#define FILTER_TYPES 10
+
+typedef struct bench
+{
+	const char *label;
+	const char *config, *stylesheet;
+	seaudit_log_t *log;
+	/** number of messages in the log */
+	size_t num_messages;
+} bench_t;
+
+static struct option const longopts[] = {
+	{"config", required_argument, NULL, 'c'},
+	{"stylesheet", required_argument, NULL, 's'},
+	{"label", required_argument, NULL, 'l'},
+	{"header", no_argument, NULL, 'H'},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0}
+};
+
+static void usage(const char *program_name, int brief)
+{
+	printf("Usage: %s [OPTIONS] LOG\n", program_name);
+	if (brief) {
+		printf("\n   Try %s --help for more help.\n\n", program_name);
+		return;
+	}
+	printf("Time libseaudit operations upon an audit log.\n\n");
+	printf("  -c FILE, --config=FILE      report configuration file\n");
+	printf("                              (default %s)\n", DEFAULT_CONFIG);
+	printf("  -s FILE, --stylesheet=FILE  stylesheet for the HTML report\n");
+	printf("                              (default %s)\n", DEFAULT_STYLESHEET);
+	printf("  -l TEXT, --label=TEXT       value of the first column of each line\n");
+	printf("  -H, --header                print a header line first\n");
+	printf("  -h, --help                  print this help text and exit\n\n");
+}
+
+/**
+ * Pass errors through to standard error; discard the warnings that
+ * libseaudit issues for each message it cannot parse.
+ */
+static void bench_msg(void *arg __attribute__ ((unused)), const seaudit_log_t * log __attribute__ ((unused)), int level,
+		      const char *fmt, va_list va_args)
+{
+	/* libseaudit's message levels are the same as libapol's */
+	if (level == APOL_MSG_ERR) {
+		fprintf(stderr, "ERROR: ");
+		vfprintf(stderr, fmt, va_args);
+		fprintf(stderr, "\n");
+	}
+}
+
+/**
+ * Read an entire file into memory, so that parsing may be timed
+ * apart from reading.
+ */
+static char *bench_slurp(const char *file, size_t * len)
+{
+	FILE *f = fopen(file, "r");
+	char *buf = NULL, *b;
+	size_t cap = 0, n;
+	*len = 0;
+	if (f == NULL) {
+		fprintf(stderr, "ERROR: Could not open %s: %s\n", file, strerror(errno));
+		return NULL;
+	}
+	do {
+		if (*len == cap) {
+			cap = (cap == 0 ? 1 << 20 : cap * 2);
+			if ((b = realloc(buf, cap)) == NULL) {
+				fprintf(stderr, "ERROR: %s\n", strerror(errno));
+				free(buf);
+				fclose(f);
+				return NULL;
+			}
+			buf = b;
+		}
+		n = fread(buf + *len, 1, cap - *len, f);
+		*len += n;
+	} while (n > 0);
+	if (ferror(f)) {
+		fprintf(stderr, "ERROR: Could not read %s: %s\n", file, strerror(errno));
+		free(buf);
+		buf = NULL;
+	}
+	fclose(f);
+	return buf;
+}
+
+/**
+ * Time a model's computation of its messages.
+ *
+ * @return Number of messages shown by the model, or < 0 on error.
+ */
+static long bench_model(const bench_t * b, seaudit_model_t * model, bench_mark_t * start, bench_mark_t * end)
+{
+	apol_vector_t *v;
+	long n;
+	bench_now(start);
+	if ((v = seaudit_model_get_messages(b->log, model)) == NULL) {
+		return -1;
+	}
+	bench_now(end);
+	n = (long)apol_vector_get_size(v);
+	apol_vector_destroy(&v);
+	return n;
+}
+
+static int bench_parse(bench_t * b, const char *file)
+{
+	bench_mark_t start, end, model_start, model_end;
+	seaudit_model_t *model = NULL;
+	apol_vector_t *malformed = NULL;
+	FILE *f;
+	long n;
+	int retval = -1;
+	if ((b->log = seaudit_log_create(bench_msg, NULL)) == NULL) {
+		fprintf(stderr, "ERROR: %s\n", strerror(errno));
+		return -1;
+	}
+	if ((f = fopen(file, "r")) == NULL) {
+		fprintf(stderr, "ERROR: Could not open %s: %s\n", file, strerror(errno));
+		return -1;
+	}
+	bench_now(&start);
+	if (seaudit_log_parse(b->log, f) < 0) {
+		fclose(f);
+		return -1;
+	}
+	bench_now(&end);
+	fclose(f);
+
+	/* the first model over a log also counts its messages */
+	if ((model = seaudit_model_create("all", b->log)) == NULL || (n = bench_model(b, model, &model_start, &model_end)) < 0) {
+		goto cleanup;
+	}
+	b->num_messages = (size_t) n;
+	bench_print_result(b->label, "log_parse", &start, &end, b->num_messages);
+	bench_print_result(b->label, "model_all", &model_start, &model_end, b->num_messages);
+	if ((malformed = seaudit_model_get_malformed_messages(b->log, model)) == NULL) {
+		goto cleanup;
+	}
+	if (apol_vector_get_size(malformed) > 0) {
+		fprintf(stderr, "WARNING: %zu malformed messages in %s\n", apol_vector_get_size(malformed), file);
+	}
+	retval = 0;
+      cleanup:
+	apol_vector_destroy(&malformed);
+	seaudit_model_destroy(&model);
+	return retval;
+}
+
+static int bench_parse_buffer(bench_t * b, const char *file)
+{
+	bench_mark_t start, end;
+	seaudit_log_t *log = NULL;
+	char *buf;
+	size_t len;
+	int retval = -1;
+	if ((buf = bench_slurp(file, &len)) == NULL) {
+		return -1;
+	}
+	if ((log = seaudit_log_create(bench_msg, NULL)) == NULL) {
+		fprintf(stderr, "ERROR: %s\n", strerror(errno));
+		goto cleanup;
+	}
+	bench_now(&start);
+	if (seaudit_log_parse_buffer(log, buf, len) < 0) {
+		goto cleanup;
+	}
+	bench_now(&end);
+	bench_print_result(b->label, "log_parse_buffer", &start, &end, b->num_messages);
+	retval = 0;
+      cleanup:
+	seaudit_log_destroy(&log);
+	free(buf);
+	return retval;
+}
+
+/**
+ * Time a filtered model, then the recomputation after its filters
+ * are changed to hide, rather than show, the messages they accept.
+ */
+static int bench_filter(const bench_t * b)
+{
+	bench_mark_t start, end;
+	seaudit_model_t *model = NULL;
+	seaudit_filter_t *filter = NULL;
+	apol_vector_t *types = NULL;
+	char name[32];
+	int i, retval = -1;
+	if ((types = apol_vector_create(free)) == NULL) {
+		goto cleanup;
+	}
+	for (i = 0; i < FILTER_TYPES; i++) {
+		char *s;
+		snprintf(name, sizeof(name), "type%d_t", i);
+		if ((s = strdup(name)) == NULL || apol_vector_append(types, s) < 0) {
+			free(s);
+			goto cleanup;
+		}
+	}
+	if ((model = seaudit_model_create("filtered", b->log)) == NULL || (filter = seaudit_filter_create("bench")) == NULL ||
+	    seaudit_filter_set_source_type(filter, types) < 0 || seaudit_filter_set_message_type(filter, SEAUDIT_AVC_DENIED) < 0 ||
+	    seaudit_model_append_filter(model, filter) < 0) {
+		seaudit_filter_destroy(&filter);
+		goto cleanup;
+	}
+	if (bench_model(b, model, &start, &end) < 0) {
+		goto cleanup;
+	}
+	bench_print_result(b->label, "model_filter", &start, &end, b->num_messages);
+	if (seaudit_model_set_filter_visible(model, SEAUDIT_FILTER_VISIBLE_HIDE) < 0 || bench_model(b, model, &start, &end) < 0) {
+		goto cleanup;
+	}
+	bench_print_result(b->label, "model_refresh", &start, &end, b->num_messages);
+	retval = 0;
+      cleanup:
+	if (retval < 0) {
+		fprintf(stderr, "ERROR: Could not filter messages: %s\n", strerror(errno));
+	}
+	seaudit_model_destroy(&model);
+	apol_vector_destroy(&types);
+	return retval;
+}
+
+/**
+ * Time a model with and without sorts.  Appending a sort marks the
+ * model dirty, so the sorted timing also includes refiltering every
+ * message; the sort's own cost is the difference between the
+ * model_unsorted and model_sort lines.
+ */
+static int bench_sort(const bench_t * b)
+{
+	bench_mark_t start, end;
+	seaudit_model_t *model = NULL;
+	seaudit_sort_t *by_type = NULL, *by_date = NULL;
+	int retval = -1;
+	if ((model = seaudit_model_create("sorted", b->log)) == NULL || bench_model(b, model, &start, &end) < 0) {
+		goto cleanup;
+	}
+	bench_print_result(b->label, "model_unsorted", &start, &end, b->num_messages);
+	if ((by_type = seaudit_sort_by_source_type(1)) == NULL || seaudit_model_append_sort(model, by_type) < 0) {
+		seaudit_sort_destroy(&by_type);
+		goto cleanup;
+	}
+	if ((by_date = seaudit_sort_by_date(-1)) == NULL || seaudit_model_append_sort(model, by_date) < 0) {
+		seaudit_sort_destroy(&by_date);
+		goto cleanup;
+	}
+	if (bench_model(b, model, &start, &end) < 0) {
+		goto cleanup;
+	}
+	bench_print_result(b->label, "model_sort", &start, &end, b->num_messages);
+	retval = 0;
+      cleanup:
+	if (retval < 0) {
+		fprintf(stderr, "ERROR: Could not sort messages: %s\n", strerror(errno));
+	}
+	seaudit_model_destroy(&model);
+	return retval;
+}
+
+static int bench_report(const bench_t * b, const char *name, seaudit_report_format_e format)
+{
+	bench_mark_t start, end;
+	seaudit_model_t *model = NULL;
+	seaudit_report_t *report = NULL;
+	int retval = -1;
+	if ((model = seaudit_model_create("report", b->log)) == NULL || (report = seaudit_report_create(model)) == NULL ||
+	    seaudit_report_set_format(b->log, report, format) < 0 ||
+	    seaudit_report_set_configuration(b->log, report, b->config) < 0 ||
+	    seaudit_report_set_stylesheet(b->log, report, b->stylesheet, 1) < 0 ||
+	    seaudit_report_set_malformed(b->log, report, 1) < 0) {
+		goto cleanup;
+	}
+	bench_now(&start);
+	if (seaudit_report_write(b->log, report, "/dev/null") < 0) {
+		goto cleanup;
+	}
+	bench_now(&end);
+	bench_print_result(b->label, name, &start, &end, b->num_messages);
+	retval = 0;
+      cleanup:
+	seaudit_report_destroy(&report);
+	seaudit_model_destroy(&model);
+	return retval;
+}
+
+int main(int argc, char **argv)
+{
+	bench_t b;
+	int optc, header = 0, retval = 1;
+
+	memset(&b, 0, sizeof(b));
+	b.label = "-";
+	b.config = DEFAULT_CONFIG;
+	b.stylesheet = DEFAULT_STYLESHEET;
+	while ((optc = getopt_long(argc, argv, "c:s:l:Hh", longopts, NULL)) != -1) {
+		switch (optc) {
+		case 'c':
+			b.config = optarg;
+			break;
+		case 's':
+			b.stylesheet = optarg;
+			break;
+		case 'l':
+			b.label = optarg;
+			break;
+		case 'H':
+			header = 1;
+			break;
+		case 'h':
+			usage(argv[0], 0);
+			exit(0);
+		default:
+			usage(argv[0], 1);
+			exit(1);
+		}
+	}
+	if (argc - optind != 1) {
+		usage(argv[0], 1);
+		exit(1);
+	}
+	if (header) {
+		bench_print_header();
+	}
+
+	if (bench_parse(&b, argv[optind]) < 0 || bench_parse_buffer(&b, argv[optind]) < 0 || bench_filter(&b) < 0 ||
+	    bench_sort(&b) < 0 || bench_report(&b, "report_text", SEAUDIT_REPORT_FORMAT_TEXT) < 0 ||
+	    bench_report(&b, "report_html", SEAUDIT_REPORT_FORMAT_HTML) < 0) {
+		goto cleanup;
+	}
+	retval = 0;
+      cleanup:
+	seaudit_log_destroy(&b.log);
+	return retval;
+}
@@ -0,0 +1,297 @@
+/**
+ * @file
+ *
+ * Time libsefs's file context lists: loading and querying a
+ * file_contexts file, walking and querying a labeled directory tree,
+ * and creating, saving, loading, and querying a database of that
+ * tree.  Results are written in the format described in bench.h;
+ * counts are numbers of file context entries or files processed, so
+ * that the last column gives entries or files per second.
+ *
+ * Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <sefs/db.hh>
+#include <sefs/entry.hh>
+#include <sefs/fcfile.hh>
+#include <sefs/filesystem.hh>
+#include <sefs/query.hh>
+
+#include "bench.h"
+
+using namespace std;
+
+#include <errno.h>
+#include <getopt.h>
+#include <iostream>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEFAULT_DB "bench-sefs.db"
+/* with the default seed, gen-fstree labels the root of its tree with this type */
+#define DEFAULT_TYPE "type1_t"
+/* matches the directories of one of gen-fstree's subtrees */
+#define BENCH_PATH "/d1/"
+
+static struct option const longopts[] = {
+	{"database", required_argument, NULL, 'd'},
+	{"type", required_argument, NULL, 't'},
+	{"label", required_argument, NULL, 'l'},
+	{"header", no_argument, NULL, 'H'},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0}
+};
+
+static void usage(const char *program_name, bool brief)
+{
+	cout << "Usage: " << program_name << " [OPTIONS] FILE_CONTEXTS [DIR]" << endl << endl;
+	if (brief)
+	{
+		cout << "\tTry " << program_name << " --help for more help." << endl << endl;
+		return;
+	}
+	cout << "Time libsefs operations upon a file_contexts file and, if given, the" << endl;
+	cout << "labeled directory tree DIR." << endl << endl;
+	cout << "  -d FILE, --database=FILE  temporary database (default " << DEFAULT_DB << ")" << endl;
+	cout << "  -t TYPE, --type=TYPE      type to query (default " << DEFAULT_TYPE << ")" << endl;
+	cout << "  -l TEXT, --label=TEXT     value of the first column of each line" << endl;
+	cout << "  -H, --header              print a header line first" << endl;
+	cout << "  -h, --help                print this help text and exit" << endl << endl;
+}
+
+/**
+ * Pass errors through to standard error; discard warnings, such as
+ * for files upon unknown devices.
+ */
+static void bench_msg(void *varg __attribute__ ((unused)), const struct sefs_fclist *fclist __attribute__ ((unused)), int level,
+		      const char *fmt, va_list va_args)
+{
+	if (level == SEFS_MSG_ERR)
+	{
+		fprintf(stderr, "ERROR: ");
+		vfprintf(stderr, fmt, va_args);
+		fprintf(stderr, "\n");
+	}
+}
+
+static int bench_count(sefs_fclist * fclist __attribute__ ((unused)), const sefs_entry * e __attribute__ ((unused)), void *arg)
+{
+	size_t *count = static_cast < size_t * >(arg);
+	(*count)++;
+	return 0;
+}
+
+/**
+ * Time a query upon a file context list.
+ *
+ * @param label Value of the first column.
+ * @param name Name of the benchmark.
+ * @param fclist List to query.
+ * @param query Query to run, or NULL for all entries.
+ * @param processed Number of entries or files that the query
+ * examines, or 0 to report the number that it matched.
+ *
+ * @return Number of matching entries, or < 0 on error.
+ */
+static long bench_query(const char *label, const char *name, sefs_fclist * fclist, sefs_query * query, size_t processed)
+{
+	bench_mark_t start, end;
+	size_t count = 0;
+	bench_now(&start);
+	if (fclist->runQueryMap(query, bench_count, &count) < 0)
+	{
+		return -1;
+	}
+	bench_now(&end);
+	bench_print_result(label, name, &start, &end, processed > 0 ? processed : count);
+	return static_cast < long >(count);
+}
+
+/**
+ * Time the file_contexts benchmarks.
+ */
+static int bench_fcfile(const char *label, const char *file, const char *type)
+{
+	bench_mark_t start, end;
+	sefs_fcfile *fcfile = NULL;
+	sefs_query *query = NULL;
+	long num_entries;
+	int retval = -1;
+	try
+	{
+		size_t count = 0;
+		bench_now(&start);
+		fcfile = new sefs_fcfile(file, bench_msg, NULL);
+		bench_now(&end);
+		if (fcfile->runQueryMap(NULL, bench_count, &count) < 0)
+		{
+			throw runtime_error(strerror(errno));
+		}
+		bench_print_result(label, "fcfile_load", &start, &end, count);
+		if ((num_entries = bench_query(label, "fcfile_query_all", fcfile, NULL, 0)) < 0)
+		{
+			throw runtime_error(strerror(errno));
+		}
+
+		query = new sefs_query();
+		query->type(type, false);
+		if (bench_query(label, "fcfile_query_type", fcfile, query, num_entries) < 0)
+		{
+			throw runtime_error(strerror(errno));
+		}
+		delete query;
+		query = new sefs_query();
+		query->path(BENCH_PATH);
+		query->regex(true);
+		if (bench_query(label, "fcfile_query_path", fcfile, query, num_entries) < 0)
+		{
+			throw runtime_error(strerror(errno));
+		}
+		retval = 0;
+	}
+	catch(...)
+	{
+		cerr << "ERROR: Could not query " << file << endl;
+	}
+	delete query;
+	delete fcfile;
+	return retval;
+}
+
+/**
+ * Time the filesystem and database benchmarks.
+ */
+static int bench_filesystem(const char *label, const char *root, const char *db_file, const char *type)
+{
+	bench_mark_t start, end;
+	sefs_filesystem *fs = NULL;
+	sefs_db *db = NULL;
+	sefs_query *query = NULL;
+	long num_files;
+	int retval = -1;
+	try
+	{
+		fs = new sefs_filesystem(root, bench_msg, NULL);
+	}
+	catch(...)
+	{
+		// without labels there is nothing to walk; not an error
+		// for the benchmark as a whole
+		cerr << "WARNING: Could not read the contexts of " << root << "; skipping filesystem benchmarks." << endl;
+		return 0;
+	}
+	try
+	{
+		if ((num_files = bench_query(label, "fs_walk", fs, NULL, 0)) < 0)
+		{
+			throw runtime_error(strerror(errno));
+		}
+		query = new sefs_query();
+		query->type(type, false);
+		if (bench_query(label, "fs_query_type", fs, query, num_files) < 0)
+		{
+			throw runtime_error(strerror(errno));
+		}
+
+		bench_now(&start);
+		db = new sefs_db(fs, bench_msg, NULL);
+		bench_now(&end);
+		bench_print_result(label, "db_create", &start, &end, num_files);
+		unlink(db_file);
+		bench_now(&start);
+		db->save(db_file);
+		bench_now(&end);
+		bench_print_result(label, "db_save", &start, &end, num_files);
+		delete db;
+		db = NULL;
+
+		bench_now(&start);
+		db = new sefs_db(db_file, bench_msg, NULL);
+		bench_now(&end);
+		bench_print_result(label, "db_load", &start, &end, num_files);
+		if (bench_query(label, "db_query_all", db, NULL, 0) < 0 || bench_query(label, "db_query_type", db, query, num_files) < 0)
+		{
+			throw runtime_error(strerror(errno));
+		}
+		retval = 0;
+	}
+	catch(...)
+	{
+		cerr << "ERROR: Could not index " << root << endl;
+	}
+	unlink(db_file);
+	delete query;
+	delete db;
+	delete fs;
+	return retval;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *label = "-", *db_file = DEFAULT_DB, *type = DEFAULT_TYPE;
+	bool header = false;
+	int optc;
+
+	while ((optc = getopt_long(argc, argv, "d:t:l:Hh", longopts, NULL)) != -1)
+	{
+		switch (optc)
+		{
+		case 'd':
+			db_file = optarg;
+			break;
+		case 't':
+			type = optarg;
+			break;
+		case 'l':
+			label = optarg;
+			break;
+		case 'H':
+			header = true;
+			break;
+		case 'h':
+			usage(argv[0], false);
+			exit(0);
+		default:
+			usage(argv[0], true);
+			exit(1);
+		}
+	}
+	if (argc - optind < 1 || argc - optind > 2)
+	{
+		usage(argv[0], true);
+		exit(1);
+	}
+	if (header)
+	{
+		bench_print_header();
+	}
+
+	if (bench_fcfile(label, argv[optind], type) < 0)
+	{
+		exit(1);
+	}
+	if (argc - optind == 2 && bench_filesystem(label, argv[optind + 1], db_file, type) < 0)
+	{
+		exit(1);
+	}
+	return 0;
+}
@@ -0,0 +1,470 @@
+/**
+ * @file
+ *
+ * Time SETools' key operations upon a policy: loading, building the
+ * extended image and syntactic rule table, rule queries of varying
+ * selectivity, information flow, domain transition and relabel
+ * analyses, and semantic diffing.  Results are written in the format
+ * described in bench.h, counting the items that each operation found
+ * or built.
+ *
+ * Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+/* libapol */
+#include <apol/avrule-query.h>
+#include <apol/domain-trans-analysis.h>
+#include <apol/infoflow-analysis.h>
+#include <apol/perm-map.h>
+#include <apol/policy.h>
+#include <apol/policy-path.h>
+#include <apol/relabel-analysis.h>
+#include <apol/terule-query.h>
+#include <apol/vector.h>
+
+/* libqpol */
+#include <qpol/policy.h>
+#include <qpol/policy_extend.h>
+
+/* libpoldiff */
+#include <poldiff/poldiff.h>
+
+/* other */
+#include "bench.h"
+#include <errno.h>
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_PERMMAP TOP_SRCDIR "/apol/perm_maps/apol_perm_mapping_ver24"
+
+/* names written by gen-policy; type0_t always starts a domain transition */
+#define BENCH_TYPE "type0_t"
+#define BENCH_ATTRIB "attr0"
+
+typedef struct bench
+{
+	const char *label;
+	const char *permmap;
+	apol_policy_t *policy;
+} bench_t;
+
+static struct option const longopts[] = {
+	{"binary", required_argument, NULL, 'b'},
+	{"permmap", required_argument, NULL, 'p'},
+	{"label", required_argument, NULL, 'l'},
+	{"header", no_argument, NULL, 'H'},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0}
+};
+
+static void usage(const char *program_name, int brief)
+{
+	printf("Usage: %s [OPTIONS] POLICY [MODIFIED_POLICY]\n", program_name);
+	if (brief) {
+		printf("\n   Try %s --help for more help.\n\n", program_name);
+		return;
+	}
+	printf("Time SETools operations upon a source policy.  If a modified policy is\n");
+	printf("given, also time a semantic diff between the two.\n\n");
+	printf("  -b FILE, --binary=FILE    also time loading this binary policy\n");
+	printf("  -p FILE, --permmap=FILE   permission map for information flow\n");
+	printf("                            (default %s)\n", DEFAULT_PERMMAP);
+	printf("  -l TEXT, --label=TEXT     value of the first column of each line\n");
+	printf("  -H, --header              print a header line first\n");
+	printf("  -h, --help                print this help text and exit\n\n");
+}
+
+static void bench_report(const bench_t * b, const char *name, const bench_mark_t * start, const bench_mark_t * end,
+			 size_t count)
+{
+	bench_print_result(b->label, name, start, end, count);
+}
+
+/**
+ * Pass errors through to standard error; discard everything else.
+ */
+static void bench_msg(void *varg __attribute__ ((unused)), const apol_policy_t * p __attribute__ ((unused)), int level,
+		      const char *fmt, va_list argp)
+{
+	if (level == APOL_MSG_ERR) {
+		fprintf(stderr, "ERROR: ");
+		vfprintf(stderr, fmt, argp);
+		fprintf(stderr, "\n");
+	}
+}
+
+static void bench_poldiff_msg(void *arg __attribute__ ((unused)), const poldiff_t * diff __attribute__ ((unused)), int level,
+			      const char *fmt, va_list va_args)
+{
+	/* libpoldiff's message levels are the same as libapol's */
+	if (level == APOL_MSG_ERR) {
+		fprintf(stderr, "ERROR: ");
+		vfprintf(stderr, fmt, va_args);
+		fprintf(stderr, "\n");
+	}
+}
+
+static size_t bench_memory_count(const apol_policy_t * p, qpol_memory_category_e category)
+{
+	qpol_memory_usage_t usage[QPOL_MEMORY_NUM_CATEGORIES];
+	if (qpol_policy_get_memory_usage(apol_policy_get_qpol(p), usage) < 0) {
+		return 0;
+	}
+	return usage[category].count;
+}
+
+/**
+ * Add up the steps of a policy's most recent load that build its
+ * extended image, as recorded in the policy's stats.
+ *
+ * @return 0 if the load's phases were found, < 0 if not.
+ */
+static int bench_extend_phases(const apol_policy_t * p, double *ms, long *rss_growth_kb)
+{
+	qpol_stats_t *stats = qpol_policy_get_stats(apol_policy_get_qpol(p));
+	const qpol_stats_phase_t *load = NULL, *phase;
+	size_t i;
+	*ms = 0.0;
+	*rss_growth_kb = 0;
+	if (stats == NULL) {
+		return -1;
+	}
+	/* a phase ends after every phase nested within it, so the load's
+	 * steps immediately precede it */
+	for (i = qpol_stats_get_num_phases(stats); i > 0; i--) {
+		phase = qpol_stats_get_phase(stats, i - 1);
+		if (load == NULL) {
+			if (strcmp(phase->name, "load") == 0) {
+				load = phase;
+			}
+			continue;
+		}
+		if (phase->depth <= load->depth) {
+			break;
+		}
+		if (phase->depth == load->depth + 1 &&
+		    (strcmp(phase->name, "attributes") == 0 || strcmp(phase->name, "conditional rules") == 0)) {
+			*ms += phase->elapsed_ms;
+			*rss_growth_kb += phase->peak_rss_growth_kb;
+		}
+	}
+	return (load == NULL ? -1 : 0);
+}
+
+static apol_policy_t *bench_load(bench_t * b, const char *file)
+{
+	apol_policy_path_t *path = apol_policy_path_create(APOL_POLICY_PATH_TYPE_MONOLITHIC, file, NULL);
+	apol_policy_t *p;
+	if (path == NULL) {
+		fprintf(stderr, "ERROR: %s\n", strerror(errno));
+		return NULL;
+	}
+	p = apol_policy_create_from_policy_path(path, 0, bench_msg, NULL);
+	apol_policy_path_destroy(&path);
+	if (p == NULL) {
+		fprintf(stderr, "ERROR: Could not open %s\n", file);
+	}
+	return p;
+}
+
+static int bench_load_source(bench_t * b, const char *file)
+{
+	bench_mark_t start, end;
+	double ms;
+	long rss_growth_kb;
+	bench_now(&start);
+	if ((b->policy = bench_load(b, file)) == NULL) {
+		return -1;
+	}
+	bench_now(&end);
+	bench_report(b, "load_source", &start, &end, bench_memory_count(b->policy, QPOL_MEMORY_AVTAB));
+	if (bench_extend_phases(b->policy, &ms, &rss_growth_kb) == 0) {
+		bench_print_ms(b->label, "policy_extend", ms, rss_growth_kb, bench_memory_count(b->policy, QPOL_MEMORY_ATTR_MAPS));
+	}
+	return 0;
+}
+
+static int bench_load_binary(bench_t * b, const char *file)
+{
+	bench_mark_t start, end;
+	apol_policy_t *p;
+	bench_now(&start);
+	if ((p = bench_load(b, file)) == NULL) {
+		return -1;
+	}
+	bench_now(&end);
+	bench_report(b, "load_binary", &start, &end, bench_memory_count(p, QPOL_MEMORY_AVTAB));
+	apol_policy_destroy(&p);
+	return 0;
+}
+
+static int bench_syn_rule_table(bench_t * b)
+{
+	bench_mark_t start, end;
+	bench_now(&start);
+	if (qpol_policy_build_syn_rule_table(apol_policy_get_qpol(b->policy)) < 0) {
+		fprintf(stderr, "ERROR: Could not build syntactic rule table: %s\n", strerror(errno));
+		return -1;
+	}
+	bench_now(&end);
+	bench_report(b, "syn_rule_table", &start, &end, bench_memory_count(b->policy, QPOL_MEMORY_SYN_RULES));
+	return 0;
+}
+
+/**
+ * Time an av rule query.  Either of source and target may be NULL
+ * to leave that criterion unset.
+ */
+static int bench_avrule_query(bench_t * b, const char *name, const char *source, const char *target)
+{
+	bench_mark_t start, end;
+	apol_avrule_query_t *q = apol_avrule_query_create();
+	apol_vector_t *v = NULL;
+	int retval = -1;
+	if (q == NULL || apol_avrule_query_set_source(b->policy, q, source, 0) < 0 ||
+	    apol_avrule_query_set_target(b->policy, q, target, 0) < 0) {
+		goto cleanup;
+	}
+	bench_now(&start);
+	if (apol_avrule_get_by_query(b->policy, q, &v) < 0) {
+		goto cleanup;
+	}
+	bench_now(&end);
+	bench_report(b, name, &start, &end, apol_vector_get_size(v));
+	retval = 0;
+      cleanup:
+	apol_avrule_query_destroy(&q);
+	apol_vector_destroy(&v);
+	return retval;
+}
+
+static int bench_terule_query(bench_t * b, const char *name, const char *source, const char *target)
+{
+	bench_mark_t start, end;
+	apol_terule_query_t *q = apol_terule_query_create();
+	apol_vector_t *v = NULL;
+	int retval = -1;
+	if (q == NULL || apol_terule_query_set_source(b->policy, q, source, 0) < 0 ||
+	    apol_terule_query_set_target(b->policy, q, target, 0) < 0) {
+		goto cleanup;
+	}
+	bench_now(&start);
+	if (apol_terule_get_by_query(b->policy, q, &v) < 0) {
+		goto cleanup;
+	}
+	bench_now(&end);
+	bench_report(b, name, &start, &end, apol_vector_get_size(v));
+	retval = 0;
+      cleanup:
+	apol_terule_query_destroy(&q);
+	apol_vector_destroy(&v);
+	return retval;
+}
+
+static int bench_infoflow(bench_t * b, const char *name, unsigned int mode)
+{
+	bench_mark_t start, end;
+	apol_infoflow_analysis_t *ia = apol_infoflow_analysis_create();
+	apol_infoflow_graph_t *g = NULL;
+	apol_vector_t *v = NULL;
+	int retval = -1;
+	if (ia == NULL || apol_infoflow_analysis_set_mode(b->policy, ia, mode) < 0 ||
+	    apol_infoflow_analysis_set_dir(b->policy, ia, APOL_INFOFLOW_OUT) < 0 ||
+	    apol_infoflow_analysis_set_type(b->policy, ia, BENCH_TYPE) < 0) {
+		goto cleanup;
+	}
+	bench_now(&start);
+	if (apol_infoflow_analysis_do(b->policy, ia, &v, &g) < 0) {
+		goto cleanup;
+	}
+	bench_now(&end);
+	bench_report(b, name, &start, &end, apol_vector_get_size(v));
+	retval = 0;
+      cleanup:
+	apol_infoflow_analysis_destroy(&ia);
+	apol_infoflow_graph_destroy(&g);
+	apol_vector_destroy(&v);
+	return retval;
+}
+
+static int bench_dta(bench_t * b)
+{
+	bench_mark_t start, end;
+	apol_domain_trans_analysis_t *dta = NULL;
+	apol_vector_t *v = NULL;
+	int retval = -1;
+	bench_now(&start);
+	if (apol_policy_build_domain_trans_table(b->policy) < 0) {
+		goto cleanup;
+	}
+	bench_now(&end);
+	bench_report(b, "dta_table", &start, &end, 0);
+	if ((dta = apol_domain_trans_analysis_create()) == NULL ||
+	    apol_domain_trans_analysis_set_direction(b->policy, dta, APOL_DOMAIN_TRANS_DIRECTION_FORWARD) < 0 ||
+	    apol_domain_trans_analysis_set_start_type(b->policy, dta, BENCH_TYPE) < 0) {
+		goto cleanup;
+	}
+	bench_now(&start);
+	if (apol_domain_trans_analysis_do(b->policy, dta, &v) < 0) {
+		goto cleanup;
+	}
+	bench_now(&end);
+	bench_report(b, "dta_forward", &start, &end, apol_vector_get_size(v));
+	retval = 0;
+      cleanup:
+	apol_domain_trans_analysis_destroy(&dta);
+	apol_vector_destroy(&v);
+	return retval;
+}
+
+static int bench_relabel(bench_t * b, const char *name, unsigned int dir)
+{
+	bench_mark_t start, end;
+	apol_relabel_analysis_t *r = apol_relabel_analysis_create();
+	apol_vector_t *v = NULL;
+	int retval = -1;
+	if (r == NULL || apol_relabel_analysis_set_dir(b->policy, r, dir) < 0 ||
+	    apol_relabel_analysis_set_type(b->policy, r, BENCH_TYPE) < 0) {
+		goto cleanup;
+	}
+	bench_now(&start);
+	if (apol_relabel_analysis_do(b->policy, r, &v) < 0) {
+		goto cleanup;
+	}
+	bench_now(&end);
+	bench_report(b, name, &start, &end, apol_vector_get_size(v));
+	retval = 0;
+      cleanup:
+	apol_relabel_analysis_destroy(&r);
+	apol_vector_destroy(&v);
+	return retval;
+}
+
+/**
+ * Time a semantic diff.  The diff takes ownership of both policies,
+ * so this must be the last benchmark.
+ */
+static int bench_poldiff(bench_t * b, const char *mod_file)
+{
+	bench_mark_t start, end;
+	apol_policy_t *mod;
+	poldiff_t *diff = NULL;
+	size_t stats[5], count;
+	int retval = -1, i;
+	bench_now(&start);
+	if ((mod = bench_load(b, mod_file)) == NULL) {
+		return -1;
+	}
+	bench_now(&end);
+	bench_report(b, "load_modified", &start, &end, bench_memory_count(mod, QPOL_MEMORY_AVTAB));
+	if ((diff = poldiff_create(b->policy, mod, bench_poldiff_msg, NULL)) == NULL) {
+		apol_policy_destroy(&mod);
+		return -1;
+	}
+	b->policy = NULL;
+	bench_now(&start);
+	if (poldiff_run(diff, POLDIFF_DIFF_ALL) < 0 || poldiff_get_stats(diff, POLDIFF_DIFF_ALL, stats) < 0) {
+		goto cleanup;
+	}
+	bench_now(&end);
+	for (i = 0, count = 0; i < 5; i++) {
+		count += stats[i];
+	}
+	bench_report(b, "poldiff_run", &start, &end, count);
+	retval = 0;
+      cleanup:
+	poldiff_destroy(&diff);
+	return retval;
+}
+
+int main(int argc, char **argv)
+{
+	bench_t b;
+	const char *binary = NULL;
+	int optc, header = 0;
+
+	memset(&b, 0, sizeof(b));
+	b.label = "-";
+	b.permmap = DEFAULT_PERMMAP;
+	while ((optc = getopt_long(argc, argv, "b:p:l:Hh", longopts, NULL)) != -1) {
+		switch (optc) {
+		case 'b':
+			binary = optarg;
+			break;
+		case 'p':
+			b.permmap = optarg;
+			break;
+		case 'l':
+			b.label = optarg;
+			break;
+		case 'H':
+			header = 1;
+			break;
+		case 'h':
+			usage(argv[0], 0);
+			exit(0);
+		default:
+			usage(argv[0], 1);
+			exit(1);
+		}
+	}
+	if (argc - optind < 1 || argc - optind > 2) {
+		usage(argv[0], 1);
+		exit(1);
+	}
+	if (header) {
+		bench_print_header();
+	}
+
+	if (binary != NULL && bench_load_binary(&b, binary) < 0) {
+		exit(1);
+	}
+	if (bench_load_source(&b, argv[optind]) < 0 || bench_syn_rule_table(&b) < 0 ||
+	    bench_avrule_query(&b, "avrule_all", NULL, NULL) < 0 ||
+	    bench_avrule_query(&b, "avrule_attrib", BENCH_ATTRIB, NULL) < 0 ||
+	    bench_avrule_query(&b, "avrule_type", BENCH_TYPE, NULL) < 0 ||
+	    bench_terule_query(&b, "terule_all", NULL, NULL) < 0 ||
+	    bench_terule_query(&b, "terule_attrib", BENCH_ATTRIB, NULL) < 0 ||
+	    bench_terule_query(&b, "terule_type", BENCH_TYPE, NULL) < 0) {
+		goto err;
+	}
+	if (apol_policy_open_permmap(b.policy, b.permmap) < 0) {
+		fprintf(stderr, "ERROR: Could not open permission map %s\n", b.permmap);
+		goto err;
+	}
+	if (bench_infoflow(&b, "infoflow_direct", APOL_INFOFLOW_MODE_DIRECT) < 0 ||
+	    bench_infoflow(&b, "infoflow_trans", APOL_INFOFLOW_MODE_TRANS) < 0 ||
+	    bench_dta(&b) < 0 ||
+	    bench_relabel(&b, "relabel_object", APOL_RELABEL_DIR_BOTH) < 0 ||
+	    bench_relabel(&b, "relabel_subject", APOL_RELABEL_DIR_SUBJECT) < 0) {
+		goto err;
+	}
+	if (argc - optind == 2 && bench_poldiff(&b, argv[optind + 1]) < 0) {
+		goto err;
+	}
+	apol_policy_destroy(&b.policy);
+	return 0;
+      err:
+	apol_policy_destroy(&b.policy);
+	return 1;
+}
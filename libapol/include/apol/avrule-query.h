@@ -33,6 +33,7 @@ extern "C"
 #endif
 
 #include "policy.h"
+#include "render.h"
 #include "vector.h"
 #include <qpol/policy.h>
 
@@ -354,6 +355,21 @@ extern "C"
  */
 	extern char *apol_avrule_render(const apol_policy_t * policy, const qpol_avrule_t * rule);
 
+/**
+ *  Render an avrule into a render sink, without allocating an
+ *  intermediate string.  Rendering many rules through one reused sink
+ *  avoids a malloc() and free() per rule.
+ *
+ *  @param policy Policy handler, to report errors.
+ *  @param rule The rule to render.
+ *  @param sink Sink to which to append the rule's representation.
+ *  Nothing else, such as a newline, is appended.
+ *
+ *  @return 0 on success, < 0 on failure; if the call fails, errno
+ *  will be set and the sink may hold a partially rendered rule.
+ */
+	extern int apol_avrule_render_to_sink(const apol_policy_t * policy, const qpol_avrule_t * rule, apol_render_sink_t * sink);
+
 /**
  *  Render a syntactic avrule to a string.
  *
@@ -366,6 +382,21 @@ extern "C"
 */
 	extern char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule_t * rule);
 
+/**
+ *  Render a syntactic avrule into a render sink, without allocating an
+ *  intermediate string.  Rendering many rules through one reused sink
+ *  avoids a malloc() and free() per rule.
+ *
+ *  @param policy Policy handler, to report errors.
+ *  @param rule The rule to render.
+ *  @param sink Sink to which to append the rule's representation.
+ *  Nothing else, such as a newline, is appended.
+ *
+ *  @return 0 on success, < 0 on failure; if the call fails, errno
+ *  will be set and the sink may hold a partially rendered rule.
+ */
+	extern int apol_syn_avrule_render_to_sink(const apol_policy_t * policy, const qpol_syn_avrule_t * rule, apol_render_sink_t * sink);
+
 #ifdef	__cplusplus
 }
 #endif
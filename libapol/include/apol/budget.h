@@ -0,0 +1,127 @@
+/**
+ *  @file
+ *  Contains the API for work budgets.  A budget limits how long a
+ *  single call to a search may run, how many nodes it may expand, and
+ *  how many results it may return.  A search that exhausts its budget
+ *  returns the results found so far and keeps its state, so that the
+ *  caller may resume it later.  Limits apply to each call separately:
+ *  every call, including those that resume a search, is measured
+ *  anew from when it begins.
+ *
+ *  The transitive information flow searches (see
+ *  apol_infoflow_analysis_set_budget()) and the domain transition
+ *  analysis (see apol_domain_trans_analysis_set_budget()) honor
+ *  budgets.  A budget may be shared by several analyses, but must not
+ *  be used by two searches running at the same time.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef APOL_BUDGET_H
+#define APOL_BUDGET_H
+
+#ifdef	__cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+
+	typedef struct apol_budget apol_budget_t;
+
+/*
+ * Limits of a budget, as returned by apol_budget_get_spent().
+ */
+#define APOL_BUDGET_TIME    0x01
+#define APOL_BUDGET_NODES   0x02
+#define APOL_BUDGET_RESULTS 0x04
+
+/**
+ *  Allocate and initialize a budget with no limits.
+ *
+ *  @return A pointer to a newly created budget on success and NULL
+ *  on failure.  If the call fails, errno will be set.  The caller is
+ *  responsible for calling apol_budget_destroy() to free memory
+ *  used.
+ */
+	extern apol_budget_t *apol_budget_create(void);
+
+/**
+ *  Free a budget.  Searches that were given the budget must not be
+ *  run or resumed afterwards.
+ *
+ *  @param budget Pointer to the budget to free.  The pointer will be
+ *  set to NULL afterwards.  If already NULL then this function does
+ *  nothing.
+ */
+	extern void apol_budget_destroy(apol_budget_t ** budget);
+
+/**
+ *  Set the longest time that a single call may run.  The time is
+ *  checked between units of work, so a call may overrun it by the
+ *  time taken to expand one node.
+ *
+ *  @param budget Budget to modify.
+ *  @param msec Limit in milliseconds, or 0 for no limit.
+ *
+ *  @return 0 on success, < 0 on error; if the call fails, errno will
+ *  be set.
+ */
+	extern int apol_budget_set_time_limit(apol_budget_t * budget, unsigned int msec);
+
+/**
+ *  Set the greatest number of nodes that a single call may expand.
+ *  For an information flow search a node is a type within the flow
+ *  graph; for a domain transition analysis it is a candidate end
+ *  type, or when searching in reverse a candidate entrypoint type.
+ *
+ *  @param budget Budget to modify.
+ *  @param max_nodes Limit, or 0 for no limit.
+ *
+ *  @return 0 on success, < 0 on error; if the call fails, errno will
+ *  be set.
+ */
+	extern int apol_budget_set_max_nodes(apol_budget_t * budget, size_t max_nodes);
+
+/**
+ *  Set the number of results after which a single call stops.  A
+ *  unit of work that yields several results is not split, so a call
+ *  may return slightly more than this many results.
+ *
+ *  @param budget Budget to modify.
+ *  @param max_results Limit, or 0 for no limit.
+ *
+ *  @return 0 on success, < 0 on error; if the call fails, errno will
+ *  be set.
+ */
+	extern int apol_budget_set_max_results(apol_budget_t * budget, size_t max_results);
+
+/**
+ *  Get the limits that stopped the most recent call that used this
+ *  budget.
+ *
+ *  @param budget Budget to query.
+ *
+ *  @return A bitwise-or of APOL_BUDGET_TIME, APOL_BUDGET_NODES, and
+ *  APOL_BUDGET_RESULTS, or 0 if that call finished its search or
+ *  budget is NULL.
+ */
+	extern unsigned int apol_budget_get_spent(const apol_budget_t * budget);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
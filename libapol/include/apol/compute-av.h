@@ -0,0 +1,183 @@
+/**
+ *  @file
+ *  Public interface for computing access vectors offline, in the same
+ *  manner as the kernel's security server.  Given a source context,
+ *  a target context, and an object class, libapol combines the
+ *  policy's av rules (including conditional rules enabled by the
+ *  current boolean values), type bounds, permissive types, and
+ *  constraints into a single decision.  Decisions are kept in a
+ *  least-recently-used cache, much like the kernel's access vector
+ *  cache, so that repeatedly checking the same kinds of accesses
+ *  (e.g., every message in an audit log) is cheap.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef APOL_COMPUTE_AV_H
+#define APOL_COMPUTE_AV_H
+
+#ifdef	__cplusplus
+extern "C"
+{
+#endif
+
+#include "policy.h"
+#include "context-query.h"
+#include "vector.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * The result of computing access vectors.  Each field is an access
+ * vector for the object class, in which permission value v is bit
+ * (v - 1); use apol_class_av_to_perms() to convert them into names.
+ */
+	typedef struct apol_av_decision
+	{
+	/** permissions granted by allow rules, within the source type's
+	 *  bounds, and not denied by any constraint */
+		uint32_t allowed;
+	/** permissions whose grants are audited */
+		uint32_t auditallow;
+	/** permissions whose denials are audited; a permission absent
+	 *  from this vector is dontaudit'ed */
+		uint32_t auditdeny;
+	/** permissions granted by allow rules but then denied by
+	 *  constraints; these are not in allowed */
+		uint32_t constrained;
+	/** non-zero if the source type is permissive, in which case the
+	 *  kernel would only log denials rather than enforce them */
+		int permissive;
+	} apol_av_decision_t;
+
+/** counters describing the access vector cache's effectiveness */
+	typedef struct apol_avc_stats
+	{
+	/** number of decisions requested */
+		size_t lookups;
+	/** number of decisions found in the cache */
+		size_t hits;
+	/** number of decisions that had to be computed */
+		size_t misses;
+	/** number of cached decisions discarded to make room */
+		size_t evictions;
+	/** maximum number of decisions that the cache holds */
+		size_t capacity;
+	/** number of decisions currently cached */
+		size_t size;
+	} apol_avc_stats_t;
+
+/**
+ * Compute the access vectors that a policy grants for a source
+ * context upon a target context and object class.  Conditional rules
+ * are applied according to the policy's current boolean values; if
+ * those values change then the cache is flushed automatically.
+ *
+ * @param p Policy to use.  The policy must have rules loaded.
+ * @param scontext Source context.  It must have a user, role, and
+ * type (not an attribute), and if the policy is MLS a range whose
+ * levels are not literal (see apol_context_convert()).
+ * @param tcontext Target context, with the same requirements as the
+ * source context.
+ * @param obj_class Name of the object class.
+ * @param avd Location to write the decision.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+	extern int apol_compute_av(apol_policy_t * p, const apol_context_t * scontext, const apol_context_t * tcontext,
+				   const char *obj_class, apol_av_decision_t * avd);
+
+/**
+ * Compute access vectors for many accesses at once.  This is
+ * equivalent to calling apol_compute_av() upon each triple, except
+ * that consecutive elements sharing the same context pointers are
+ * only resolved once.
+ *
+ * @param p Policy to use.
+ * @param scontexts Array of source contexts.
+ * @param tcontexts Array of target contexts.
+ * @param obj_classes Array of object class names.
+ * @param num Number of elements in each array.
+ * @param avds Array of num decisions to write.
+ *
+ * @return 0 on success, < 0 on error.  On error the contents of avds
+ * are undefined.
+ */
+	extern int apol_compute_av_batch(apol_policy_t * p, const apol_context_t * const *scontexts,
+					 const apol_context_t * const *tcontexts, const char *const *obj_classes, size_t num,
+					 apol_av_decision_t * avds);
+
+/**
+ * Convert permission names into an access vector for a class.
+ *
+ * @param p Policy containing the class.
+ * @param obj_class Name of the object class.
+ * @param perms Vector of permission names (char *), either unique to
+ * the class or inherited from its common.
+ * @param av Location to write the access vector.
+ *
+ * @return 0 on success, < 0 on error (including if any permission
+ * does not belong to the class).
+ */
+	extern int apol_class_perms_to_av(apol_policy_t * p, const char *obj_class, const apol_vector_t * perms, uint32_t * av);
+
+/**
+ * Convert an access vector for a class into permission names.
+ *
+ * @param p Policy containing the class.
+ * @param obj_class Name of the object class.
+ * @param av Access vector to convert.
+ *
+ * @return A vector of permission names (char *), or NULL on error.
+ * The strings belong to the policy, but the caller must call
+ * apol_vector_destroy() upon the vector afterwards.
+ */
+	extern apol_vector_t *apol_class_av_to_perms(apol_policy_t * p, const char *obj_class, uint32_t av);
+
+/**
+ * Set the maximum number of decisions that the policy's access
+ * vector cache holds.  This flushes the cache.
+ *
+ * @param p Policy whose cache to resize.
+ * @param capacity New capacity.  Pass 0 to disable caching.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+	extern int apol_avc_set_capacity(apol_policy_t * p, size_t capacity);
+
+/**
+ * Discard all decisions in the policy's access vector cache.  The
+ * cache's counters are not reset.  Callers need not flush the cache
+ * after changing boolean values.
+ *
+ * @param p Policy whose cache to flush.
+ */
+	extern void apol_avc_flush(apol_policy_t * p);
+
+/**
+ * Get the counters of the policy's access vector cache.
+ *
+ * @param p Policy whose cache to query.
+ * @param stats Location to write the counters.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+	extern int apol_avc_get_stats(const apol_policy_t * p, apol_avc_stats_t * stats);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -32,7 +32,9 @@ extern "C"
 #endif
 
 #include "policy.h"
+#include "context-query.h"
 #include "vector.h"
+#include <stdint.h>
 
 	typedef struct apol_constraint_query apol_constraint_query_t;
 	typedef struct apol_validatetrans_query apol_validatetrans_query_t;
@@ -181,6 +183,100 @@ extern "C"
  */
 	extern int apol_validatetrans_query_set_regex(const apol_policy_t * p, apol_validatetrans_query_t * vt, int is_regex);
 
+/******************** constraint evaluation ********************/
+
+/**
+ * Compile every constraint and validatetrans statement within the
+ * policy into a form that may be evaluated quickly.  Names within
+ * each expression are resolved into bitsets indexed by user, role,
+ * and type value (with attributes expanded), permissions into
+ * bitmasks, and role dominance into a table.  Evaluation then
+ * neither allocates memory nor looks up names, other than those of
+ * the contexts being evaluated.
+ *
+ * The compiled form is built as needed by the functions below; call
+ * this function to pay its cost up front.  The policy keeps the
+ * compiled form until the policy is destroyed.  Note that evaluation
+ * is not thread-safe.
+ *
+ * @param p Policy whose constraints to compile.
+ *
+ * @return 0 on success (or if already compiled), < 0 on error.
+ */
+	extern int apol_policy_build_constraint_program(apol_policy_t * p);
+
+/**
+ * Determine which permissions would be removed by the policy's
+ * constraints when a source context accesses a target context, as
+ * the kernel does after consulting the access vector rules.  A
+ * permission is removed if any constraint naming that permission
+ * evaluates to false.
+ *
+ * @param p Policy containing the constraints.
+ * @param scontext Source context.  Its user, role, and type must be
+ * set, and for MLS policies so must its range.  Literal ranges must
+ * have been converted with apol_context_convert().
+ * @param tcontext Target context, with the same requirements as
+ * scontext.
+ * @param obj_class Name of the object class being accessed.
+ * @param perms Vector of permission names (char *) being requested.
+ * @param denied Reference to a vector into which to write those
+ * elements of perms that the constraints remove, in the same order.
+ * The strings are not duplicated, so the vector must not outlive
+ * perms.  The caller must call apol_vector_destroy() afterwards.
+ * This will be set to NULL upon error.
+ *
+ * @return 0 on success (including no permissions removed), < 0 on
+ * error.
+ */
+	extern int apol_constraint_compute_denied(apol_policy_t * p, const apol_context_t * scontext,
+						  const apol_context_t * tcontext, const char *obj_class, const apol_vector_t * perms,
+						  apol_vector_t ** denied);
+
+/**
+ * Determine which permissions the policy's constraints remove for
+ * many pairs of contexts at once.  This behaves as if
+ * apol_constraint_compute_denied() were called upon each pair, but
+ * the class and permissions are resolved only once and a context is
+ * not resolved again when it is the same object as in the previous
+ * pair.  Thus callers should group pairs by source context.
+ *
+ * @param p Policy containing the constraints.
+ * @param scontexts Array of num source contexts.
+ * @param tcontexts Array of num target contexts.
+ * @param num Number of context pairs.
+ * @param obj_class Name of the object class being accessed.
+ * @param perms Vector of at most 32 permission names (char *) being
+ * requested.
+ * @param denied Array of num entries into which to write the removed
+ * permissions.  Bit i of an entry is set if element i of perms is
+ * removed for that pair.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+	extern int apol_constraint_compute_denied_batch(apol_policy_t * p, const apol_context_t * const *scontexts,
+							const apol_context_t * const *tcontexts, size_t num,
+							const char *obj_class, const apol_vector_t * perms, uint32_t * denied);
+
+/**
+ * Determine if the policy's validatetrans statements permit an
+ * object of a class to be relabeled from one context to another.
+ *
+ * @param p Policy containing the validatetrans statements.
+ * @param oldcontext The object's current context.  The requirements
+ * upon contexts are the same as for apol_constraint_compute_denied().
+ * @param newcontext The object's new context.
+ * @param taskcontext Context of the process performing the
+ * relabel.
+ * @param obj_class Name of the object's class.
+ *
+ * @return 1 if the transition is permitted, 0 if a validatetrans
+ * statement forbids it, < 0 on error.
+ */
+	extern int apol_validatetrans_check(apol_policy_t * p, const apol_context_t * oldcontext,
+					    const apol_context_t * newcontext, const apol_context_t * taskcontext,
+					    const char *obj_class);
+
 #ifdef	__cplusplus
 }
 #endif
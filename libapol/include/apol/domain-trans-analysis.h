@@ -31,6 +31,7 @@ extern "C"
 {
 #endif
 
+#include "budget.h"
 #include "policy.h"
 #include "vector.h"
 #include <qpol/policy.h>
@@ -154,6 +155,24 @@ extern "C"
 	extern int apol_domain_trans_analysis_set_result_regex(const apol_policy_t * policy, apol_domain_trans_analysis_t * dta,
 							       const char *regex);
 
+/**
+ *  Limit each call of the analysis by a budget.  A candidate end
+ *  type, or when searching in reverse a candidate entrypoint type,
+ *  counts as one node.  When searching for invalid transitions no
+ *  results are returned until the search finishes, since the last
+ *  step of the search may add orphan type_transition rules to any of
+ *  them; the budget's limit on results then has no effect.
+ *  @param policy Policy handler, to report errors.
+ *  @param dta Domain transition analysis to set.
+ *  @param budget Budget to use, or NULL for no limits.  The caller
+ *  retains ownership of the budget, which must outlive the analysis
+ *  or be replaced before it is destroyed.
+ *  @return 0 on success, and < 0 on failure; if the call fails,
+ *  errno will be set.
+ */
+	extern int apol_domain_trans_analysis_set_budget(const apol_policy_t * policy, apol_domain_trans_analysis_t * dta,
+							 apol_budget_t * budget);
+
 /**
  *  Set the analysis to return only types having access (via allow
  *  rules) to this type. <b>This is only valid for forward
@@ -247,14 +266,37 @@ extern "C"
  *  apol_domain_trans_result_t. The vector will be allocated by this
  *  function.  The caller must call apol_vector_destroy()
  *  afterwards. This will be set to NULL upon error.
- *  @return 0 on success and < 0 on failure; if the call fails,
- *  errno will be set and *results will be NULL.
+ *  @return 0 on success, 1 if the analysis's budget ran out first,
+ *  and < 0 on failure; if the call fails, errno will be set and
+ *  *results will be NULL.  In the second case *results holds the
+ *  transitions found so far; call apol_domain_trans_analysis_resume()
+ *  to find the rest.
  *
  *  @see apol_policy_reset_domain_trans_table()
  */
 	extern int apol_domain_trans_analysis_do(apol_policy_t * policy, apol_domain_trans_analysis_t * dta,
 						 apol_vector_t ** results);
 
+/**
+ *  Continue a domain transition analysis that ran out of budget, with
+ *  a new budget period.  The analysis holds the state of the search
+ *  until it finishes or apol_domain_trans_analysis_do() is called
+ *  again.  The policy's domain transition table must not be reset
+ *  while a search is suspended; if it was then the search is
+ *  abandoned and this returns < 0 with errno set to ESTALE.
+ *  @param policy Policy containing the table to use.
+ *  @param dta Analysis whose search ran out of budget.
+ *  @param results Pointer to a vector of apol_domain_trans_result_t
+ *  to which to append new results.  If the pointer is NULL then this
+ *  will allocate and return a new vector.  The caller must call
+ *  apol_vector_destroy() afterwards.
+ *  @return 0 if the search finished or if no search was suspended, 1
+ *  if the budget ran out again, and < 0 on failure; if the call
+ *  fails, errno will be set and the suspended search is abandoned.
+ */
+	extern int apol_domain_trans_analysis_resume(apol_policy_t * policy, apol_domain_trans_analysis_t * dta,
+						     apol_vector_t ** results);
+
 /***************** functions for accessing results ************************/
 
 /**
@@ -0,0 +1,192 @@
+/**
+ *  @file
+ *  Contains the API for an unordered hash set.  Like the binary
+ *  search tree, the set guarantees uniqueness of all entries within,
+ *  but lookups and insertions take constant time on average.  Use
+ *  this instead of a BST when the elements' order does not matter.
+ *  Note that hash set functions are not thread-safe.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef APOL_HASHSET_H
+#define APOL_HASHSET_H
+
+#ifdef	__cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+
+	typedef struct apol_hashset apol_hashset_t;
+
+	typedef size_t(apol_hashset_hash_func) (const void *elem, void *data);
+	typedef int (apol_hashset_comp_func) (const void *a, const void *b, void *data);
+	typedef void (apol_hashset_free_func) (void *elem);
+
+#include "vector.h"
+
+/**
+ *  Allocate and initialize an empty hash set.
+ *
+ *  @param hash A hash call back for the type of element stored in
+ *  the set.  Elements that compare equal must hash to the same
+ *  value.  If this is NULL then hash the pointer address.
+ *  @param cmp A comparison call back for the type of element stored
+ *  in the set.  The expected return value from this function is 0
+ *  if the two arguments are equal and non-zero otherwise.  If this is
+ *  NULL then do pointer address comparison.
+ *  @param fr Function to call when destroying the set.  Each element
+ *  of the set will be passed into this function; it should free the
+ *  memory used by that element.  If this parameter is NULL, the
+ *  elements will not be freed.
+ *
+ *  @return A pointer to a newly created hash set on success and NULL
+ *  on failure.  If the call fails, errno will be set.  The caller is
+ *  responsible for calling apol_hashset_destroy() to free memory
+ *  used.
+ */
+	extern apol_hashset_t *apol_hashset_create(apol_hashset_hash_func * hash, apol_hashset_comp_func * cmp,
+						   apol_hashset_free_func * fr);
+
+/**
+ *  Hash a pointer address.  Hash functions for elements keyed upon
+ *  some other object's address (e.g., a qpol_type_t pointer) may
+ *  use this.  This is also the hash used when apol_hashset_create()
+ *  is given a NULL hash function.
+ *
+ *  @param ptr Address to hash.
+ *
+ *  @return Hash value for the address.
+ */
+	extern size_t apol_hashset_ptr_hash(const void *ptr);
+
+/**
+ *  Free a hash set and any memory used by it.  This will invoke the
+ *  free function that was given when the set was created upon each
+ *  element.
+ *
+ *  @param h Pointer to the hash set to free.  The pointer will be set
+ *  to NULL afterwards.  If already NULL then this function does
+ *  nothing.
+ */
+	extern void apol_hashset_destroy(apol_hashset_t ** h);
+
+/**
+ *  Allocate and return a vector that has been initialized with the
+ *  contents of a hash set.  If change_owner is zero then this
+ *  function will make a <b>shallow copy of the set's contents</b>;
+ *  the set will still <em>own</em> the objects.  Otherwise the vector
+ *  will gain ownership of the items; the set can then be destroyed
+ *  safely without affecting the vector.  The resulting vector is
+ *  <b>not</b> sorted.
+ *
+ *  @param h Hash set from which to copy.
+ *  @param change_owner If zero then do a shallow copy, else change
+ *  item ownership.
+ *
+ *  @return A pointer to a newly created vector on success and NULL on
+ *  failure.  If the call fails, errno will be set.  The caller is
+ *  responsible for calling apol_vector_destroy() to free memory used
+ *  by the vector.
+ */
+	extern apol_vector_t *apol_hashset_get_vector(apol_hashset_t * h, int change_owner);
+
+/**
+ *  Get the number of elements stored in the hash set.
+ *
+ *  @param h The hash set from which to get the number of elements.
+ *  Must be non-NULL.
+ *
+ *  @return The number of elements in the set; if h is NULL, return 0
+ *  and set errno.
+ */
+	extern size_t apol_hashset_get_size(const apol_hashset_t * h);
+
+/**
+ *  Find an element within a hash set and return it.
+ *
+ *  @param h The hash set from which to get the element.
+ *  @param elem The element to find.  (This will be the first
+ *  parameter to the hash function and the second parameter to the
+ *  comparison function given in apol_hashset_create().)
+ *  @param data Arbitrary data to pass as the hash and comparison
+ *  functions' last parameter.
+ *  @param result Location to write the found element.  This value is
+ *  undefined if the key did not match any elements.
+ *
+ *  @return 0 if element was found, or < 0 if not found.
+ */
+	extern int apol_hashset_get_element(const apol_hashset_t * h, const void *elem, void *data, void **result);
+
+/**
+ *  Insert an element into the hash set.  If the element already
+ *  exists then do not insert it again.
+ *
+ *  @param h The hash set to which to add the element.
+ *  @param elem The element to add.  Must be non-NULL.
+ *  @param data Arbitrary data to pass as the hash and comparison
+ *  functions' last parameter.
+ *
+ *  @return 0 if the item was inserted, 1 if the item already exists
+ *  (and thus not inserted).  On failure return < 0, set errno, and h
+ *  will be unchanged.
+ */
+	extern int apol_hashset_insert(apol_hashset_t * h, void *elem, void *data);
+
+/**
+ *  Insert an element into the hash set, and then get the element back
+ *  out.  If the element did not already exist, then this function
+ *  behaves the same as apol_hashset_insert().  If however the element
+ *  did exist, then the passed in element is freed (as per the set's
+ *  free function) and then the existing element is returned.
+ *
+ *  @param h The hash set to which to add the element.
+ *  @param elem Reference to an element to add.  If the element is
+ *  new, then the pointer remains unchanged.  Otherwise set the
+ *  reference to the element already within the set.
+ *  @param data Arbitrary data to pass as the hash and comparison
+ *  functions' last parameter.
+ *
+ *  @return 0 if the item was inserted, 1 if the item already exists
+ *  (and thus not inserted).  On failure return < 0, set errno, and h
+ *  will be unchanged.
+ */
+	extern int apol_hashset_insert_and_get(apol_hashset_t * h, void **elem, void *data);
+
+/**
+ *  Map a function across all the elements of the hash set, in no
+ *  particular order.
+ *
+ *  @param h Hash set upon which to map against.
+ *  @param fn Function pointer that takes 2 arguments, first is a
+ *  pointer to an element of the set, second is an arbitrary data
+ *  element.  The function may change the element, but it must not
+ *  affect the element's hash value or equality.  This function
+ *  should return >= 0 on success; a return of < 0 signals error and
+ *  ends the mapping over the set.
+ *  @param data Arbitrary data to pass as fn's second parameter.
+ *
+ *  @return Result of the last call to fn() (i.e., >= 0 on success < 0
+ *  on failure).  If the set is empty then return 0.
+ */
+	extern int apol_hashset_map(const apol_hashset_t * h, int (*fn) (void *, void *), void *data);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif				       /* APOL_HASHSET_H */
@@ -32,6 +32,7 @@ extern "C"
 {
 #endif
 
+#include "budget.h"
 #include "policy.h"
 #include "vector.h"
 #include <qpol/policy.h>
@@ -88,7 +89,10 @@ extern "C"
  * apol_infoflow_graph_destroy() afterwards.  This will be set to NULL
  * upon error.
  *
- * @return 0 on success, negative on error.
+ * @return 0 on success, 1 if the analysis's budget ran out before a
+ * transitive search finished, negative on error.  In the second case
+ * v holds the results found so far; call
+ * apol_infoflow_analysis_resume() with g to continue the search.
  */
 	extern int apol_infoflow_analysis_do(const apol_policy_t * p,
 					     const apol_infoflow_analysis_t * ia, apol_vector_t ** v, apol_infoflow_graph_t ** g);
@@ -107,7 +111,10 @@ extern "C"
  * apol_vector_destroy() afterwards.  This will be set to NULL upon no
  * results or upon error.
  *
- * @return 0 on success, negative on error.
+ * @return 0 on success, 1 if the graph's budget ran out before a
+ * transitive search finished, negative on error.  In the second case
+ * v holds the results found so far; call
+ * apol_infoflow_analysis_resume() to continue the search.
  */
 	extern int apol_infoflow_analysis_do_more(const apol_policy_t * p, apol_infoflow_graph_t * g, const char *type,
 						  apol_vector_t ** v);
@@ -146,11 +153,34 @@ extern "C"
  * will allocate and return a new vector.  It is the caller's
  * responsibility to call apol_vector_destroy() afterwards.
  *
- * @return 0 on success, < 0 on error.
+ * @return 0 on success, 1 if the graph's budget ran out before the
+ * search from the current start state finished, < 0 on error.  In
+ * the second case the next call continues that search instead of
+ * restarting.
  */
 	extern int apol_infoflow_analysis_trans_further_next(const apol_policy_t * p, apol_infoflow_graph_t * g,
 							     apol_vector_t ** v);
 
+/**
+ * Continue a transitive search of an infoflow graph that ran out of
+ * budget, with a new budget period.  The graph holds the state of the
+ * search; it is discarded by apol_infoflow_analysis_do_more() and
+ * apol_infoflow_analysis_trans_further_prepare().  Results are only
+ * returned once the shortest path to their end type is known, so a
+ * call may return no results even though the search made progress.
+ *
+ * @param p Policy from which infoflow rules derived.
+ * @param g Transitive infoflow graph whose search ran out of budget.
+ * @param v Pointer to a vector of apol_infoflow_result_t to which
+ * append new results.  If the pointer is NULL then this will
+ * allocate and return a new vector.  It is the caller's
+ * responsibility to call apol_vector_destroy() afterwards.
+ *
+ * @return 0 if the search finished or if no search was suspended, 1
+ * if the budget ran out again, < 0 on error.
+ */
+	extern int apol_infoflow_analysis_resume(const apol_policy_t * p, apol_infoflow_graph_t * g, apol_vector_t ** v);
+
 /********** functions to create/modify an analysis object **********/
 
 /**
@@ -265,6 +295,22 @@ extern "C"
  */
 	extern int apol_infoflow_analysis_set_min_weight(const apol_policy_t * p, apol_infoflow_analysis_t * ia, int min_weight);
 
+/**
+ * Limit each call of a transitive information flow search by a
+ * budget.  The graph built by apol_infoflow_analysis_do() keeps the
+ * budget, and uses it for apol_infoflow_analysis_do_more(),
+ * apol_infoflow_analysis_trans_further_next(), and
+ * apol_infoflow_analysis_resume().  Direct searches are not limited.
+ *
+ * @param p Policy handler, to report errors.
+ * @param ia Infoflow analysis to set.
+ * @param budget Budget to use, or NULL for no limits.  The caller
+ * retains ownership of the budget, which must outlive the graph.
+ * @return Always 0.
+ */
+	extern int apol_infoflow_analysis_set_budget(const apol_policy_t * p, apol_infoflow_analysis_t * ia,
+						     apol_budget_t * budget);
+
 /**
  * Set an information flow analysis to return only types matching a
  * regular expression.  Note that the regexp will also match types'
@@ -357,6 +357,90 @@ extern "C"
  */
 	extern char *apol_nodecon_render(const apol_policy_t * p, const qpol_nodecon_t * nodecon);
 
+/******************** portcon and nodecon lookups ********************/
+
+/**
+ * Build the index used to resolve ports and addresses to portcons and
+ * nodecons, if not already built.  The lookup functions below build
+ * the index upon first use, so calling this is only needed to control
+ * when that cost is paid.  The index is kept until the policy is
+ * destroyed.
+ *
+ * @param p Policy for which to build the index.
+ *
+ * @return 0 on success, < 0 on error (in which case errno will be
+ * set).
+ */
+	extern int apol_policy_build_netcon_index(apol_policy_t * p);
+
+/**
+ * Find the portcon that labels a port.  If several portcons' ranges
+ * contain the port then the narrowest range wins, and among equally
+ * narrow ranges the one appearing first in the policy wins.
+ *
+ * @param p Policy within which to look up the port.
+ * @param proto Protocol of the port (e.g., IPPROTO_TCP).
+ * @param port Port number.
+ * @param portcon Location to write the matching portcon, or NULL if
+ * no portcon contains the port.  The portcon is owned by the policy.
+ *
+ * @return 0 on success (including no match), < 0 on error.
+ */
+	extern int apol_portcon_lookup(apol_policy_t * p, uint8_t proto, uint16_t port, const qpol_portcon_t ** portcon);
+
+/**
+ * Find the portcons that label many ports at once.  This behaves as
+ * if apol_portcon_lookup() were called upon each protocol and port
+ * pair, but is faster when consecutive pairs share a protocol.
+ *
+ * @param p Policy within which to look up the ports.
+ * @param protos Array of num protocols.
+ * @param ports Array of num port numbers.
+ * @param num Number of protocol and port pairs.
+ * @param portcons Array of num entries into which to write the
+ * matching portcons, or NULL for pairs with no match.
+ *
+ * @return 0 on success (including no matches), < 0 on error.
+ */
+	extern int apol_portcon_lookup_batch(apol_policy_t * p, const uint8_t * protos, const uint16_t * ports, size_t num,
+					     const qpol_portcon_t ** portcons);
+
+/**
+ * Find the nodecon that labels an address.  The nodecon with the
+ * longest netmask containing the address wins.  Among nodecons with
+ * equally long netmasks the one appearing first in the policy wins.
+ *
+ * @param p Policy within which to look up the address.
+ * @param proto Protocol of the address, either QPOL_IPV4 or
+ * QPOL_IPV6.
+ * @param addr Address in qpol byte order (as returned by
+ * apol_str_to_internal_ip()).  For QPOL_IPV4 only the first element
+ * is used; for QPOL_IPV6 all four are used.
+ * @param nodecon Location to write the matching nodecon, or NULL if
+ * no nodecon contains the address.  The nodecon is owned by the
+ * policy's index; do not free it.
+ *
+ * @return 0 on success (including no match), < 0 on error.
+ */
+	extern int apol_nodecon_lookup(apol_policy_t * p, int proto, const uint32_t * addr, const qpol_nodecon_t ** nodecon);
+
+/**
+ * Find the nodecons that label many addresses at once.  This behaves
+ * as if apol_nodecon_lookup() were called upon each address.
+ *
+ * @param p Policy within which to look up the addresses.
+ * @param protos Array of num protocols, each QPOL_IPV4 or QPOL_IPV6.
+ * @param addrs Array of 4 * num elements; address i occupies
+ * elements 4 * i through 4 * i + 3.
+ * @param num Number of addresses.
+ * @param nodecons Array of num entries into which to write the
+ * matching nodecons, or NULL for addresses with no match.
+ *
+ * @return 0 on success (including no matches), < 0 on error.
+ */
+	extern int apol_nodecon_lookup_batch(apol_policy_t * p, const int *protos, const uint32_t * addrs, size_t num,
+					     const qpol_nodecon_t ** nodecons);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -76,6 +76,7 @@ extern "C"
 #include "ftrule-query.h"
 #include "range_trans-query.h"
 #include "constraint-query.h"
+#include "compute-av.h"
 
 #include "domain-trans-analysis.h"
 #include "infoflow-analysis.h"
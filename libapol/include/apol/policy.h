@@ -35,6 +35,7 @@ extern "C"
 #endif
 
 #include "policy-path.h"
+#include "vector.h"
 #include <stdarg.h>
 #include <qpol/policy.h>
 
@@ -111,6 +112,20 @@ extern "C"
  */
 	extern qpol_policy_t *apol_policy_get_qpol(const apol_policy_t * policy);
 
+/**
+ * Given a policy, return the object into which it records its phases
+ * of work: the qpol policy's load or rebuild, followed by libapol's
+ * queries and analyses.  Each phase reports its elapsed time, the
+ * rules scanned and matched, the nodes expanded by searches, cache
+ * hits and misses, and peak memory use.
+ *
+ * @param policy Policy whose stats to get.
+ *
+ * @return The policy's stats object, or NULL on error.  Do not
+ * destroy it; it is destroyed along with the policy.
+ */
+	extern qpol_stats_t *apol_policy_get_stats(const apol_policy_t * policy);
+
 /**
  * Given a policy, return 1 if the policy within is MLS, 0 if not.  If
  * it cannot be determined or upon error, return < 0.
@@ -130,6 +145,37 @@ extern "C"
  */
 	extern char *apol_policy_get_version_type_mls_str(const apol_policy_t * p);
 
+/** memory used by one part of a loaded policy */
+	typedef struct apol_memory_usage
+	{
+	/** name of the part, such as "av table" or "permission map" */
+		const char *name;
+	/** approximate number of bytes allocated for the part */
+		size_t bytes;
+	/** number of objects (rules, symbols, cached decisions, and so
+	 *  forth) held by the part */
+		size_t count;
+	} apol_memory_usage_t;
+
+/**
+ * Report how much memory a policy uses.  The policy's qpol
+ * structures (symbol tables, av tables, conditionals, the syntactic
+ * rule table, and so forth) are listed first, in the order of
+ * qpol_memory_category_e, followed by libapol's caches: the
+ * permission map, the domain transition table, the netcon index, the
+ * constraint program, the access vector cache, and the relabel
+ * index.  A cache that has not been built reports zero bytes.
+ *
+ * Byte counts are estimates calculated from the sizes of the
+ * structures within each part; they exclude allocator overhead.
+ *
+ * @param p Policy to examine.
+ *
+ * @return A vector of apol_memory_usage_t, or NULL upon error.  The
+ * caller must call apol_vector_destroy() upon the vector afterwards.
+ */
+	extern apol_vector_t *apol_policy_get_memory_usage(const apol_policy_t * p);
+
 #define APOL_MSG_ERR 1
 #define APOL_MSG_WARN 2
 #define APOL_MSG_INFO 3
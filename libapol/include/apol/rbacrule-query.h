@@ -34,6 +34,7 @@ extern "C"
 #endif
 
 #include "policy.h"
+#include "render.h"
 #include "vector.h"
 #include <qpol/policy.h>
 
@@ -144,6 +145,21 @@ extern "C"
  */
 	extern char *apol_role_allow_render(const apol_policy_t * policy, const qpol_role_allow_t * rule);
 
+/**
+ *  Render a role allow rule into a render sink, without allocating an
+ *  intermediate string.  Rendering many rules through one reused sink
+ *  avoids a malloc() and free() per rule.
+ *
+ *  @param policy Policy handler, to report errors.
+ *  @param rule The rule to render.
+ *  @param sink Sink to which to append the rule's representation.
+ *  Nothing else, such as a newline, is appended.
+ *
+ *  @return 0 on success, < 0 on failure; if the call fails, errno
+ *  will be set and the sink may hold a partially rendered rule.
+ */
+	extern int apol_role_allow_render_to_sink(const apol_policy_t * policy, const qpol_role_allow_t * rule, apol_render_sink_t * sink);
+
 /******************** role_transition queries ********************/
 
 /**
@@ -272,6 +288,21 @@ extern "C"
  */
 	extern char *apol_role_trans_render(const apol_policy_t * policy, const qpol_role_trans_t * rule);
 
+/**
+ *  Render a role transition rule into a render sink, without allocating an
+ *  intermediate string.  Rendering many rules through one reused sink
+ *  avoids a malloc() and free() per rule.
+ *
+ *  @param policy Policy handler, to report errors.
+ *  @param rule The rule to render.
+ *  @param sink Sink to which to append the rule's representation.
+ *  Nothing else, such as a newline, is appended.
+ *
+ *  @return 0 on success, < 0 on failure; if the call fails, errno
+ *  will be set and the sink may hold a partially rendered rule.
+ */
+	extern int apol_role_trans_render_to_sink(const apol_policy_t * policy, const qpol_role_trans_t * rule, apol_render_sink_t * sink);
+
 #ifdef	__cplusplus
 }
 #endif
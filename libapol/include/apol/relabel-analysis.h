@@ -153,6 +153,50 @@ extern "C"
  */
 	extern int apol_relabel_analysis_set_result_regex(const apol_policy_t * p, apol_relabel_analysis_t * r, const char *result);
 
+/**
+ * Build an index of the policy's allow rules that grant relabelto or
+ * relabelfrom permissions.  Once the index exists,
+ * apol_relabel_analysis_do() consults it instead of searching every
+ * rule, which greatly speeds up running many analyses against the
+ * same policy.  The index is kept until the policy is destroyed;
+ * calling this function again does nothing.
+ *
+ * @param p Policy to index.
+ *
+ * @return 0 on success, negative on error.
+ */
+	extern int apol_policy_build_relabel_index(apol_policy_t * p);
+
+/******************** transitive relabel analysis ********************/
+
+/**
+ * Find every type that an object may eventually be relabeled into,
+ * through any chain of subjects.  An object of type A may be
+ * relabeled to type B if some subject has relabelfrom permission
+ * upon A and relabelto permission upon B, for the same object class.
+ * This function follows such steps repeatedly; because relabeling
+ * never changes an object's class, each chain stays within one
+ * class.  The relabel index is built first if needed.
+ *
+ * @param p Policy within which to look up allow rules.
+ * @param type Name of the starting type.  If this is an attribute
+ * then start from each of its types.
+ * @param obj_class If non-NULL, only follow relabels of this class.
+ * Otherwise follow relabels of every class.
+ * @param dir APOL_RELABEL_DIR_TO to find the types that the starting
+ * type may become, or APOL_RELABEL_DIR_FROM to find the types that
+ * may become the starting type.
+ * @param v Reference to a vector of qpol_type_t pointers, which will
+ * never include the starting type(s) nor attributes.  The vector will
+ * be allocated by this function; the caller must call
+ * apol_vector_destroy() afterwards.  This will be set to NULL upon
+ * error.
+ *
+ * @return 0 on success, negative on error.
+ */
+	extern int apol_relabel_closure(apol_policy_t * p, const char *type, const char *obj_class, unsigned int dir,
+					apol_vector_t ** v);
+
 /******************** functions to access relabel results ********************/
 
 /**
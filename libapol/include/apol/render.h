@@ -38,8 +38,11 @@ extern "C"
 #include "policy.h"
 #include "mls-query.h"
 #include <qpol/policy.h>
+#include <stdio.h>
 #include <stdlib.h>
 
+	typedef struct apol_render_sink apol_render_sink_t;
+
 /**
  * Given an IPv4 address (or mask) in qpol byte order, allocate and
  * return a string representing that address.
@@ -75,6 +78,151 @@ extern "C"
  */
 	extern char *apol_qpol_context_render(const apol_policy_t * p, const qpol_context_t * context);
 
+/**
+ * Allocate and return a render sink that accumulates output into a
+ * growable in-memory buffer.  The buffer is retained between calls
+ * to apol_render_sink_clear(), so rendering many objects through the
+ * same sink reallocates only when an object is longer than any
+ * rendered before it.
+ *
+ * @return A newly allocated sink, or NULL on error (in which case
+ * errno will be set).  The caller must call
+ * apol_render_sink_destroy() afterwards.
+ */
+	extern apol_render_sink_t *apol_render_sink_create_buffer(void);
+
+/**
+ * Allocate and return a render sink that writes its output to an
+ * open stream.  Output is staged in an internal buffer and written
+ * to the stream in large blocks.
+ *
+ * @param fp Stream to which to write.  The sink does not take
+ * ownership of the stream; it will not be closed when the sink is
+ * destroyed.
+ *
+ * @return A newly allocated sink, or NULL on error (in which case
+ * errno will be set).  The caller must call
+ * apol_render_sink_destroy() afterwards.
+ */
+	extern apol_render_sink_t *apol_render_sink_create_file(FILE * fp);
+
+/**
+ * Allocate and return a render sink that writes its output to an
+ * open file descriptor, bypassing stdio altogether.  Output is
+ * staged in an internal buffer and written in large blocks.
+ *
+ * @param fd File descriptor to which to write.  The sink does not
+ * take ownership of the descriptor; it will not be closed when the
+ * sink is destroyed.
+ *
+ * @return A newly allocated sink, or NULL on error (in which case
+ * errno will be set).  The caller must call
+ * apol_render_sink_destroy() afterwards.
+ */
+	extern apol_render_sink_t *apol_render_sink_create_fd(int fd);
+
+/**
+ * Flush any pending output and then free all memory used by a render
+ * sink.  Errors from the final flush are ignored; call
+ * apol_render_sink_flush() first to detect them.
+ *
+ * @param sink Reference to the sink to destroy.  The pointer will be
+ * set to NULL afterwards.  If already NULL then do nothing.
+ */
+	extern void apol_render_sink_destroy(apol_render_sink_t ** sink);
+
+/**
+ * Append a string to a render sink.
+ *
+ * @param sink Sink to which to append.
+ * @param str String to append.
+ *
+ * @return 0 on success, < 0 on error (in which case errno will be
+ * set).
+ */
+	extern int apol_render_sink_append(apol_render_sink_t * sink, const char *str);
+
+/**
+ * Append a formatted string to a render sink, as per printf(3).
+ *
+ * @param sink Sink to which to append.
+ * @param fmt Format string for the remaining arguments.
+ *
+ * @return 0 on success, < 0 on error (in which case errno will be
+ * set).
+ */
+	extern int apol_render_sink_appendf(apol_render_sink_t * sink, const char *fmt, ...);
+
+/* declaration duplicated below to satisfy doxygen */
+	extern int apol_render_sink_appendf(apol_render_sink_t * sink, const char *fmt, ...) __attribute__ ((format(printf, 2, 3)));
+
+/**
+ * Append a single character to a render sink.
+ *
+ * @param sink Sink to which to append.
+ * @param c Character to append.
+ *
+ * @return 0 on success, < 0 on error (in which case errno will be
+ * set).
+ */
+	extern int apol_render_sink_putc(apol_render_sink_t * sink, char c);
+
+/**
+ * Write all pending output of a stream or file descriptor sink to
+ * its destination.  For buffer sinks this does nothing.
+ *
+ * @param sink Sink to flush.
+ *
+ * @return 0 on success, < 0 on error (in which case errno will be
+ * set).
+ */
+	extern int apol_render_sink_flush(apol_render_sink_t * sink);
+
+/**
+ * Get the contents of a buffer sink.  For stream and file descriptor
+ * sinks this is only the output not yet flushed.
+ *
+ * @param sink Sink from which to get contents.
+ *
+ * @return The sink's contents, which will be the empty string if
+ * nothing has been appended.  The string is owned by the sink and
+ * is valid until the next call that modifies the sink.  Returns NULL
+ * if sink is NULL.
+ */
+	extern const char *apol_render_sink_get_string(const apol_render_sink_t * sink);
+
+/**
+ * Get the number of characters within a buffer sink, not counting
+ * the trailing nul character.  For stream and file descriptor sinks
+ * this is only the number of characters not yet flushed.
+ *
+ * @param sink Sink from which to get the length.
+ *
+ * @return Length of the sink's contents, or 0 if sink is NULL.
+ */
+	extern size_t apol_render_sink_get_length(const apol_render_sink_t * sink);
+
+/**
+ * Discard the contents of a render sink, keeping its allocated
+ * buffer for reuse.  For stream and file descriptor sinks any output
+ * not yet flushed is discarded.
+ *
+ * @param sink Sink to clear.
+ */
+	extern void apol_render_sink_clear(apol_render_sink_t * sink);
+
+/**
+ * Remove the contents of a buffer sink and return them to the
+ * caller.  The sink is left empty and may continue to be used
+ * afterwards.
+ *
+ * @param sink Sink from which to take the contents.
+ *
+ * @return A newly allocated string, which the caller must free, or
+ * NULL on error (in which case errno will be set).
+ */
+	extern char *apol_render_sink_take_string(apol_render_sink_t * sink);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -0,0 +1,140 @@
+/**
+ *  @file
+ *  Contains the API for a string pool.  A pool interns strings: each
+ *  distinct string is copied into the pool exactly once, so that
+ *  callers may compare interned strings by pointer.  Every string
+ *  also receives a small integer identifier, assigned in insertion
+ *  order starting at 0, that remains valid for the life of the pool.
+ *  Interned strings are never moved or freed until the pool itself
+ *  is destroyed.  Note that string pool functions are not
+ *  thread-safe.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef APOL_STRPOOL_H
+#define APOL_STRPOOL_H
+
+#ifdef	__cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+
+	typedef struct apol_strpool apol_strpool_t;
+
+#include "vector.h"
+
+/**
+ *  Allocate and initialize an empty string pool.
+ *
+ *  @return A pointer to a newly created pool on success and NULL on
+ *  failure.  If the call fails, errno will be set.  The caller is
+ *  responsible for calling apol_strpool_destroy() to free memory
+ *  used.
+ */
+	extern apol_strpool_t *apol_strpool_create(void);
+
+/**
+ *  Free a string pool and all strings interned within it.
+ *
+ *  @param pool Pointer to the pool to free.  The pointer will be set
+ *  to NULL afterwards.  If already NULL then this function does
+ *  nothing.
+ */
+	extern void apol_strpool_destroy(apol_strpool_t ** pool);
+
+/**
+ *  Get the number of distinct strings stored in the pool.
+ *
+ *  @param pool The pool from which to get the number of strings.
+ *  Must be non-NULL.
+ *
+ *  @return The number of strings in the pool; if pool is NULL,
+ *  return 0 and set errno.
+ */
+	extern size_t apol_strpool_get_size(const apol_strpool_t * pool);
+
+/**
+ *  Intern a string.  If an equal string is not yet in the pool then
+ *  copy it into the pool.  The caller retains ownership of str.
+ *
+ *  @param pool The pool to which to add the string.
+ *  @param str The string to add.
+ *  @param result If non-NULL, location to write the pool's copy of
+ *  the string.  The pool owns this copy; do not modify or free it.
+ *
+ *  @return 0 if the string was inserted, 1 if the string already
+ *  exists (and thus not inserted).  On failure return < 0, set errno,
+ *  and pool will be unchanged.
+ */
+	extern int apol_strpool_insert(apol_strpool_t * pool, const char *str, char **result);
+
+/**
+ *  Find a string within the pool and return the pool's copy of it.
+ *
+ *  @param pool The pool from which to get the string.
+ *  @param str The string to find.
+ *  @param result Location to write the pool's copy of the string.
+ *  This value is undefined if the string is not in the pool.
+ *
+ *  @return 0 if the string was found, or < 0 if not found.
+ */
+	extern int apol_strpool_get_element(const apol_strpool_t * pool, const char *str, char **result);
+
+/**
+ *  Find a string within the pool and return its identifier.
+ *
+ *  @param pool The pool from which to get the identifier.
+ *  @param str The string to find.
+ *  @param id Location to write the string's identifier.  This value
+ *  is undefined if the string is not in the pool.
+ *
+ *  @return 0 if the string was found, or < 0 if not found.
+ */
+	extern int apol_strpool_get_id(const apol_strpool_t * pool, const char *str, size_t * id);
+
+/**
+ *  Return the string with the given identifier.
+ *
+ *  @param pool The pool from which to get the string.
+ *  @param id Identifier of the string, as returned by
+ *  apol_strpool_get_id().
+ *
+ *  @return The pool's copy of the string, or NULL if id is out of
+ *  range.  The pool owns the string; do not modify or free it.
+ */
+	extern char *apol_strpool_get_string(const apol_strpool_t * pool, size_t id);
+
+/**
+ *  Allocate and return a vector of all strings within the pool,
+ *  sorted alphabetically.  This is a <b>shallow copy</b>; the pool
+ *  still owns the strings.
+ *
+ *  @param pool Pool from which to copy.
+ *
+ *  @return A pointer to a newly created vector on success and NULL on
+ *  failure.  If the call fails, errno will be set.  The caller is
+ *  responsible for calling apol_vector_destroy() to free memory used
+ *  by the vector.
+ */
+	extern apol_vector_t *apol_strpool_get_vector(const apol_strpool_t * pool);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif				       /* APOL_STRPOOL_H */
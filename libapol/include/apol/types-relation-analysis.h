@@ -73,6 +73,32 @@ extern "C"
 	extern int apol_types_relation_analysis_do(apol_policy_t * p,
 						   const apol_types_relation_analysis_t * tr, apol_types_relation_result_t ** r);
 
+/**
+ * Execute a two types relationship analysis between the first type
+ * and each of several other types.  This is equivalent to calling
+ * apol_types_relation_analysis_do() once per other type, except that
+ * work that depends only upon the first type (e.g., its information
+ * flow graph and its access pool) is done once for all of them.
+ * Independent parts of the analysis are run concurrently; see
+ * apol_types_relation_analysis_set_threads().  The analysis's second
+ * type is ignored.
+ *
+ * @param p Policy within which to look up relationships.
+ * @param tr A non-NULL structure containing parameters for analysis.
+ * Its first type must be set.
+ * @param others Vector of other types' names (char *).
+ * @param v Reference to a vector of apol_types_relation_result_t, one
+ * per element of others and in the same order.  The vector will be
+ * allocated by this function; the caller must call
+ * apol_vector_destroy() upon it afterwards, which also destroys the
+ * results.  This will be set to NULL upon error.
+ *
+ * @return 0 on success, negative on error.
+ */
+	extern int apol_types_relation_analysis_do_batch(apol_policy_t * p,
+							 const apol_types_relation_analysis_t * tr, const apol_vector_t * others,
+							 apol_vector_t ** v);
+
 /**
  * Allocate and return a new two types relationship analysis
  * structure.  All fields are cleared; one must fill in the details of
@@ -137,6 +163,25 @@ extern "C"
 	extern int apol_types_relation_analysis_set_analyses(const apol_policy_t * p, apol_types_relation_analysis_t * tr,
 							     unsigned int analyses);
 
+/**
+ * Set the maximum number of threads with which to run a types
+ * relationship analysis.  Graph searches that modify shared state
+ * (transitive information flow and domain transitions) always run
+ * within a single thread, but concurrently with the other analyses.
+ * Messages raised by other threads are passed to the policy's
+ * callback once the analysis has finished.
+ *
+ * @param p Policy handler, to report errors.
+ * @param tr Types relation analysis to set.
+ * @param num_threads Maximum number of threads, 1 to run the analysis
+ * sequentially, or 0 to use one thread per online processor (the
+ * default).
+ *
+ * @return Always 0.
+ */
+	extern int apol_types_relation_analysis_set_threads(const apol_policy_t * p, apol_types_relation_analysis_t * tr,
+							    size_t num_threads);
+
 /*************** functions to access types relation results ***************/
 
 /**
@@ -329,6 +329,16 @@ extern "C"
  */
 	extern void *apol_str_strdup(const void *elem, void *unused __attribute__ ((unused)));
 
+/**
+ * Hash a string, for use by hash tables keyed by name.  This is the
+ * 32-bit FNV-1a hash, widened to size_t.
+ *
+ * @param s String to hash.
+ *
+ * @return The string's hash value.
+ */
+	extern size_t apol_str_hash(const char *s);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -268,6 +268,19 @@ extern "C"
  */
 	extern int apol_vector_remove(apol_vector_t * v, const size_t idx);
 
+/**
+ *  Shrink a vector by removing every element at or after the given
+ *  index.  The vector's free function, if any, will be called upon
+ *  each removed element.  The vector's capacity is not changed.
+ *
+ *  @param v The vector from which to remove elements.
+ *  @param size New size of the vector.  If this is not less than the
+ *  vector's current size then the vector is unchanged.
+ *
+ *  @return 0 on success, < 0 on error.  On error errno will be set.
+ */
+	extern int apol_vector_truncate(apol_vector_t * v, size_t size);
+
 /**
  *  Compare two vectors, determining if one is different than the
  *  other.  This uses a callback to compare elements across the
@@ -296,7 +309,8 @@ extern "C"
 
 /**
  *  Sort the vector's elements within place, using an unstable sorting
- *  algorithm.
+ *  algorithm.  This takes O(n log n) time in the worst case, even if
+ *  the vector is already sorted, and uses O(log n) stack space.
  *
  *  @param v The vector to sort.
  *  @param cmp A comparison call back for the type of element stored
@@ -310,6 +324,49 @@ extern "C"
  */
 	extern void apol_vector_sort(apol_vector_t * v, apol_vector_comp_func * cmp, void *data);
 
+/**
+ *  Sort the vector's elements within place, using a stable sorting
+ *  algorithm; elements that compare equal retain their relative
+ *  order.  This takes O(n log n) time and allocates temporary space
+ *  for n pointers.
+ *
+ *  @param v The vector to sort.
+ *  @param cmp A comparison call back for the type of element stored
+ *  in the vector.  The expected return value from this function is
+ *  less than, equal to, or greater than 0 if the first argument is
+ *  less than, equal to, or greater than the second respectively.  If
+ *  this is NULL then treat the vector's contents as unsigned integers
+ *  and sort in increasing order.
+ *  @param data Arbitrary data to pass as the comparison function's
+ *  third paramater.
+ *
+ *  @return 0 on success, < 0 on error.  On error errno will be set
+ *  and the vector is unchanged.
+ */
+	extern int apol_vector_sort_stable(apol_vector_t * v, apol_vector_comp_func * cmp, void *data);
+
+/**
+ *  Sort the vector's elements within place, splitting the work
+ *  across multiple threads.  The result is the same as
+ *  apol_vector_sort_stable().  Vectors that are too small to benefit
+ *  from threading are sorted by the calling thread alone.
+ *
+ *  @param v The vector to sort.
+ *  @param cmp A comparison call back for the type of element stored
+ *  in the vector, as per apol_vector_sort_stable().  It will be
+ *  called concurrently from several threads, and thus must not
+ *  modify any shared state.
+ *  @param data Arbitrary data to pass as the comparison function's
+ *  third paramater.
+ *  @param num_threads Maximum number of threads to use, including
+ *  the calling thread.  If 0 then use the number of online
+ *  processors.
+ *
+ *  @return 0 on success, < 0 on error.  On error errno will be set
+ *  and the vector is unchanged.
+ */
+	extern int apol_vector_sort_parallel(apol_vector_t * v, apol_vector_comp_func * cmp, void *data, size_t num_threads);
+
 /**
  *  Sort the vector's elements within place (see apol_vector_sort()),
  *  and then compact vector by removing duplicate entries.  The
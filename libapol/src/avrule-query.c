@@ -64,6 +64,9 @@ static int rule_select(const apol_policy_t * p, apol_vector_t * v, uint32_t rule
 		       const apol_vector_t * perm_list, const char *bool_name)
 {
 	qpol_iterator_t *iter = NULL, *perm_iter = NULL;
+	void *batch[APOL_QUERY_ITER_BATCH];
+	int num_items, b, by_source = 0;
+	size_t num_passes = 1, pass;
 	const int only_enabled = flags & APOL_QUERY_ONLY_ENABLED;
 	const int is_regex = flags & APOL_QUERY_REGEX;
 	const int source_as_any = flags & APOL_QUERY_SOURCE_AS_ANY;
@@ -74,111 +77,129 @@ static int rule_select(const apol_policy_t * p, apol_vector_t * v, uint32_t rule
 	if ((flags & APOL_QUERY_MATCH_ALL_PERMS) && perm_list != NULL) {
 		num_perms_to_match = apol_vector_get_size(perm_list);
 	}
-	if (qpol_policy_get_avrule_iter(p->p, rule_type, &iter) < 0) {
-		goto cleanup;
+	/* with a sorted rule snapshot it is cheaper to look up the
+	 * rules of each candidate source than to scan every rule */
+	if (source_list != NULL && !source_as_any && qpol_policy_has_sorted_rule_table(p->p)) {
+		num_passes = apol_vector_get_size(source_list);
+		by_source = 1;
 	}
-	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
-		qpol_avrule_t *rule;
-		uint32_t is_enabled;
-		const qpol_cond_t *cond = NULL;
-		int match_source = 0, match_target = 0, match_bool = 0;
-		size_t match_perm = 0, i;
-		if (qpol_iterator_get_item(iter, (void **)&rule) < 0) {
-			goto cleanup;
-		}
-
-		if (qpol_avrule_get_is_enabled(p->p, rule, &is_enabled) < 0) {
-			goto cleanup;
-		}
-		if (!is_enabled && only_enabled) {
-			continue;
-		}
-
-		if (bool_name != NULL) {
-			if (qpol_avrule_get_cond(p->p, rule, &cond) < 0) {
-				goto cleanup;
-			}
-			if (cond == NULL) {
-				continue;	/* skip unconditional rule */
-			}
-			match_bool = apol_compare_cond_expr(p, cond, bool_name, is_regex, &bool_regex);
-			if (match_bool < 0) {
+	for (pass = 0; pass < num_passes; pass++) {
+		if (by_source) {
+			const qpol_type_t *source = apol_vector_get_element(source_list, pass);
+			if (qpol_policy_get_avrule_iter_by_source(p->p, rule_type, source, &iter) < 0) {
 				goto cleanup;
-			} else if (match_bool == 0) {
-				continue;
 			}
+		} else if (qpol_policy_get_avrule_iter(p->p, rule_type, &iter) < 0) {
+			goto cleanup;
 		}
+		while ((num_items = qpol_iterator_next_batch(iter, batch, APOL_QUERY_ITER_BATCH)) > 0) {
+			apol_stats_add(p, QPOL_STATS_RULES_SCANNED, num_items);
+			for (b = 0; b < num_items; b++) {
+				qpol_avrule_t *rule = batch[b];
+				uint32_t is_enabled;
+				const qpol_cond_t *cond = NULL;
+				int match_source = 0, match_target = 0, match_bool = 0;
+				size_t match_perm = 0, i;
+				if (qpol_avrule_get_is_enabled(p->p, rule, &is_enabled) < 0) {
+					goto cleanup;
+				}
+				if (!is_enabled && only_enabled) {
+					continue;
+				}
 
-		if (source_list == NULL) {
-			match_source = 1;
-		} else {
-			const qpol_type_t *source_type;
-			if (qpol_avrule_get_source_type(p->p, rule, &source_type) < 0) {
-				goto cleanup;
-			}
-			if (apol_vector_get_index(source_list, source_type, NULL, NULL, &i) == 0) {
-				match_source = 1;
-			}
-		}
+				if (bool_name != NULL) {
+					if (qpol_avrule_get_cond(p->p, rule, &cond) < 0) {
+						goto cleanup;
+					}
+					if (cond == NULL) {
+						continue;	/* skip unconditional rule */
+					}
+					match_bool = apol_compare_cond_expr(p, cond, bool_name, is_regex, &bool_regex);
+					if (match_bool < 0) {
+						goto cleanup;
+					} else if (match_bool == 0) {
+						continue;
+					}
+				}
 
-		/* if source did not match, but treating source symbol
-		 * as any field, then delay rejecting this rule until
-		 * the target has been checked */
-		if (!source_as_any && !match_source) {
-			continue;
-		}
+				if (source_list == NULL || by_source) {
+					/* the per-source iterator only returns
+					 * rules of this pass's source */
+					match_source = 1;
+				} else {
+					const qpol_type_t *source_type;
+					if (qpol_avrule_get_source_type(p->p, rule, &source_type) < 0) {
+						goto cleanup;
+					}
+					if (apol_vector_get_index(source_list, source_type, NULL, NULL, &i) == 0) {
+						match_source = 1;
+					}
+				}
 
-		if (target_list == NULL || (source_as_any && match_source)) {
-			match_target = 1;
-		} else {
-			const qpol_type_t *target_type;
-			if (qpol_avrule_get_target_type(p->p, rule, &target_type) < 0) {
-				goto cleanup;
-			}
-			if (apol_vector_get_index(target_list, target_type, NULL, NULL, &i) == 0) {
-				match_target = 1;
-			}
-		}
+				/* if source did not match, but treating source symbol
+				 * as any field, then delay rejecting this rule until
+				 * the target has been checked */
+				if (!source_as_any && !match_source) {
+					continue;
+				}
 
-		if (!match_target) {
-			continue;
-		}
+				if (target_list == NULL || (source_as_any && match_source)) {
+					match_target = 1;
+				} else {
+					const qpol_type_t *target_type;
+					if (qpol_avrule_get_target_type(p->p, rule, &target_type) < 0) {
+						goto cleanup;
+					}
+					if (apol_vector_get_index(target_list, target_type, NULL, NULL, &i) == 0) {
+						match_target = 1;
+					}
+				}
 
-		if (class_list != NULL) {
-			const qpol_class_t *obj_class;
-			if (qpol_avrule_get_object_class(p->p, rule, &obj_class) < 0) {
-				goto cleanup;
-			}
-			if (apol_vector_get_index(class_list, obj_class, NULL, NULL, &i) < 0) {
-				continue;
-			}
-		}
+				if (!match_target) {
+					continue;
+				}
 
-		if (perm_list != NULL) {
-			for (i = 0; i < apol_vector_get_size(perm_list) && match_perm < num_perms_to_match; i++) {
-				char *perm = (char *)apol_vector_get_element(perm_list, i);
-				if (qpol_avrule_get_perm_iter(p->p, rule, &perm_iter) < 0) {
-					goto cleanup;
+				if (class_list != NULL) {
+					const qpol_class_t *obj_class;
+					if (qpol_avrule_get_object_class(p->p, rule, &obj_class) < 0) {
+						goto cleanup;
+					}
+					if (apol_vector_get_index(class_list, obj_class, NULL, NULL, &i) < 0) {
+						continue;
+					}
+				}
+
+				if (perm_list != NULL) {
+					for (i = 0; i < apol_vector_get_size(perm_list) && match_perm < num_perms_to_match; i++) {
+						char *perm = (char *)apol_vector_get_element(perm_list, i);
+						if (qpol_avrule_get_perm_iter(p->p, rule, &perm_iter) < 0) {
+							goto cleanup;
+						}
+						int match = apol_compare_iter(p, perm_iter, perm, 0, NULL, 1);
+						if (match < 0) {
+							goto cleanup;
+						} else if (match > 0) {
+							match_perm++;
+						}
+						qpol_iterator_destroy(&perm_iter);
+					}
+				} else {
+					match_perm = num_perms_to_match;
 				}
-				int match = apol_compare_iter(p, perm_iter, perm, 0, NULL, 1);
-				if (match < 0) {
+				if (match_perm < num_perms_to_match) {
+					continue;
+				}
+
+				if (apol_vector_append(v, rule)) {
+					ERR(p, "%s", strerror(ENOMEM));
 					goto cleanup;
-				} else if (match > 0) {
-					match_perm++;
 				}
-				qpol_iterator_destroy(&perm_iter);
 			}
-		} else {
-			match_perm = num_perms_to_match;
 		}
-		if (match_perm < num_perms_to_match) {
-			continue;
-		}
-
-		if (apol_vector_append(v, rule)) {
-			ERR(p, "%s", strerror(ENOMEM));
+		if (num_items < 0) {
 			goto cleanup;
 		}
+		qpol_iterator_destroy(&iter);
 	}
 
 	retv = 0;
@@ -196,6 +217,7 @@ int apol_avrule_get_by_query(const apol_policy_t * p, const apol_avrule_query_t
 	char *bool_name = NULL;
 	*v = NULL;
 	unsigned int flags = 0;
+	size_t depth = apol_stats_begin(p, "avrule query");
 
 	uint32_t rule_type = QPOL_RULE_ALLOW | QPOL_RULE_AUDITALLOW | QPOL_RULE_DONTAUDIT;
 //	if (qpol_policy_has_capability(apol_policy_get_qpol(p), QPOL_CAP_NEVERALLOW)) {
@@ -249,6 +271,10 @@ int apol_avrule_get_by_query(const apol_policy_t * p, const apol_avrule_query_t
 
 	retval = 0;
       cleanup:
+	if (retval == 0) {
+		apol_stats_add(p, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*v));
+	}
+	apol_stats_end(p, depth);
 	if (retval != 0) {
 		apol_vector_destroy(v);
 	}
@@ -272,6 +298,7 @@ int apol_syn_avrule_get_by_query(const apol_policy_t * p, const apol_avrule_quer
 	*v = NULL;
 	size_t i;
 	unsigned int flags = 0;
+	size_t depth = apol_stats_begin(p, "syntactic avrule query");
 
 	if (!p || !qpol_policy_has_capability(apol_policy_get_qpol(p), QPOL_CAP_SYN_RULES)) {
 		ERR(p, "%s", strerror(EINVAL));
@@ -428,6 +455,10 @@ int apol_syn_avrule_get_by_query(const apol_policy_t * p, const apol_avrule_quer
 
 	retval = 0;
       cleanup:
+	if (retval == 0) {
+		apol_stats_add(p, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*v));
+	}
+	apol_stats_end(p, depth);
 	if (retval != 0) {
 		apol_vector_destroy(v);
 	}
@@ -738,38 +769,37 @@ apol_vector_t *apol_avrule_list_to_syn_avrules(const apol_policy_t * p, const ap
 	return v;
 }
 
-char *apol_avrule_render(const apol_policy_t * policy, const qpol_avrule_t * rule)
+int apol_avrule_render_to_sink(const apol_policy_t * policy, const qpol_avrule_t * rule, apol_render_sink_t * sink)
 {
-	char *tmp = NULL;
 	const char *rule_type_str, *tmp_name = NULL;
 	int error = 0;
 	uint32_t rule_type = 0;
 	const qpol_type_t *type = NULL;
 	const qpol_class_t *obj_class = NULL;
 	qpol_iterator_t *iter = NULL;
-	size_t tmp_sz = 0, num_perms = 0;
+	size_t num_perms = 0;
 
-	if (!policy || !rule) {
+	if (!policy || !rule || !sink) {
 		ERR(policy, "%s", strerror(EINVAL));
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 
 	/* rule type */
 	if (qpol_avrule_get_rule_type(policy->p, rule, &rule_type)) {
-		return NULL;
+		return -1;
 	}
 	if (!(rule_type &= (QPOL_RULE_ALLOW | QPOL_RULE_NEVERALLOW | QPOL_RULE_AUDITALLOW | QPOL_RULE_DONTAUDIT))) {
 		ERR(policy, "%s", "Invalid AV rule type");
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 	if (!(rule_type_str = apol_rule_type_to_str(rule_type))) {
 		ERR(policy, "%s", "Could not get AV rule type's string");
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s ", rule_type_str)) {
+	if (apol_render_sink_appendf(sink, "%s ", rule_type_str)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -784,7 +814,7 @@ char *apol_avrule_render(const apol_policy_t * policy, const qpol_avrule_t * rul
 		error = errno;
 		goto err;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+	if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -799,7 +829,7 @@ char *apol_avrule_render(const apol_policy_t * policy, const qpol_avrule_t * rul
 		error = errno;
 		goto err;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s : ", tmp_name)) {
+	if (apol_render_sink_appendf(sink, "%s : ", tmp_name)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -814,7 +844,7 @@ char *apol_avrule_render(const apol_policy_t * policy, const qpol_avrule_t * rul
 		error = errno;
 		goto err;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+	if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -831,7 +861,7 @@ char *apol_avrule_render(const apol_policy_t * policy, const qpol_avrule_t * rul
 		goto err;
 	}
 	if (num_perms > 1) {
-		if (apol_str_append(&tmp, &tmp_sz, "{ ")) {
+		if (apol_render_sink_append(sink, "{ ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -844,7 +874,7 @@ char *apol_avrule_render(const apol_policy_t * policy, const qpol_avrule_t * rul
 			ERR(policy, "%s", strerror(error));
 			goto err;
 		}
-		if (apol_str_appendf(&tmp, &tmp_sz, "%s ", perm_name)) {
+		if (apol_render_sink_appendf(sink, "%s ", perm_name)) {
 			error = errno;
 			free(perm_name);
 			ERR(policy, "%s", strerror(error));
@@ -854,62 +884,81 @@ char *apol_avrule_render(const apol_policy_t * policy, const qpol_avrule_t * rul
 		tmp_name = NULL;
 	}
 	if (num_perms > 1) {
-		if (apol_str_append(&tmp, &tmp_sz, "} ")) {
+		if (apol_render_sink_append(sink, "} ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
 		}
 	}
 
-	if (apol_str_append(&tmp, &tmp_sz, ";")) {
+	if (apol_render_sink_append(sink, ";")) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
 	}
 
 	qpol_iterator_destroy(&iter);
-	return tmp;
+	return 0;
 
       err:
-	free(tmp);
 	qpol_iterator_destroy(&iter);
 	errno = error;
-	return NULL;
+	return -1;
 }
 
-char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule_t * rule)
+char *apol_avrule_render(const apol_policy_t * policy, const qpol_avrule_t * rule)
 {
+	apol_render_sink_t *sink = NULL;
 	char *tmp = NULL;
+	int error;
+
+	if ((sink = apol_render_sink_create_buffer()) == NULL) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return NULL;
+	}
+	if (apol_avrule_render_to_sink(policy, rule, sink) == 0 && (tmp = apol_render_sink_take_string(sink)) == NULL) {
+		ERR(policy, "%s", strerror(errno));
+	}
+	error = errno;
+	apol_render_sink_destroy(&sink);
+	errno = error;
+	return tmp;
+}
+
+int apol_syn_avrule_render_to_sink(const apol_policy_t * policy, const qpol_syn_avrule_t * rule, apol_render_sink_t * sink)
+{
 	const char *rule_type_str, *tmp_name = NULL;
 	int error = 0;
 	uint32_t rule_type = 0, star = 0, comp = 0, self = 0;
 	const qpol_type_t *type = NULL;
 	const qpol_class_t *obj_class = NULL;
 	qpol_iterator_t *iter = NULL, *iter2 = NULL;
-	size_t tmp_sz = 0, iter_sz = 0, iter2_sz = 0;
+	size_t iter_sz = 0, iter2_sz = 0;
 	const qpol_type_set_t *set = NULL;
 
-	if (!policy || !rule) {
+	if (!policy || !rule || !sink) {
 		ERR(policy, "%s", strerror(EINVAL));
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 
 	/* rule type */
 	if (qpol_syn_avrule_get_rule_type(policy->p, rule, &rule_type)) {
-		return NULL;
+		return -1;
 	}
 	if (!(rule_type &= (QPOL_RULE_ALLOW | QPOL_RULE_NEVERALLOW | QPOL_RULE_AUDITALLOW | QPOL_RULE_DONTAUDIT))) {
 		ERR(policy, "%s", "Invalid AV rule type");
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 	if (!(rule_type_str = apol_rule_type_to_str(rule_type))) {
 		ERR(policy, "%s", "Could not get AV rule type's string");
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s ", rule_type_str)) {
+	if (apol_render_sink_appendf(sink, "%s ", rule_type_str)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -925,7 +974,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 		goto err;
 	}
 	if (star) {
-		if (apol_str_append(&tmp, &tmp_sz, "* ")) {
+		if (apol_render_sink_append(sink, "* ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -936,7 +985,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 			goto err;
 		}
 		if (comp) {
-			if (apol_str_append(&tmp, &tmp_sz, "~")) {
+			if (apol_render_sink_append(sink, "~")) {
 				error = errno;
 				ERR(policy, "%s", strerror(ENOMEM));
 				goto err;
@@ -956,7 +1005,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 			goto err;
 		}
 		if (iter_sz + iter2_sz > 1) {
-			if (apol_str_append(&tmp, &tmp_sz, "{ ")) {
+			if (apol_render_sink_append(sink, "{ ")) {
 				error = errno;
 				ERR(policy, "%s", strerror(ENOMEM));
 				goto err;
@@ -972,7 +1021,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 				error = errno;
 				goto err;
 			}
-			if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+			if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -988,7 +1037,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 				error = errno;
 				goto err;
 			}
-			if (apol_str_appendf(&tmp, &tmp_sz, "-%s ", tmp_name)) {
+			if (apol_render_sink_appendf(sink, "-%s ", tmp_name)) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -997,7 +1046,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 		qpol_iterator_destroy(&iter);
 		qpol_iterator_destroy(&iter2);
 		if (iter_sz + iter2_sz > 1) {
-			if (apol_str_append(&tmp, &tmp_sz, "} ")) {
+			if (apol_render_sink_append(sink, "} ")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -1015,7 +1064,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 		goto err;
 	}
 	if (star) {
-		if (apol_str_append(&tmp, &tmp_sz, "* ")) {
+		if (apol_render_sink_append(sink, "* ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -1026,7 +1075,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 			goto err;
 		}
 		if (comp) {
-			if (apol_str_append(&tmp, &tmp_sz, "~")) {
+			if (apol_render_sink_append(sink, "~")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -1050,7 +1099,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 			goto err;
 		}
 		if (iter_sz + iter2_sz + self > 1) {
-			if (apol_str_append(&tmp, &tmp_sz, "{ ")) {
+			if (apol_render_sink_append(sink, "{ ")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -1066,7 +1115,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 				error = errno;
 				goto err;
 			}
-			if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+			if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -1082,7 +1131,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 				error = errno;
 				goto err;
 			}
-			if (apol_str_appendf(&tmp, &tmp_sz, "-%s ", tmp_name)) {
+			if (apol_render_sink_appendf(sink, "-%s ", tmp_name)) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -1091,14 +1140,14 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 		qpol_iterator_destroy(&iter);
 		qpol_iterator_destroy(&iter2);
 		if (self) {
-			if (apol_str_append(&tmp, &tmp_sz, "self ")) {
+			if (apol_render_sink_append(sink, "self ")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
 			}
 		}
 		if (iter_sz + iter2_sz + self > 1) {
-			if (apol_str_append(&tmp, &tmp_sz, "} ")) {
+			if (apol_render_sink_append(sink, "} ")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -1106,7 +1155,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 		}
 	}
 
-	if (apol_str_append(&tmp, &tmp_sz, ": ")) {
+	if (apol_render_sink_append(sink, ": ")) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -1123,7 +1172,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 		goto err;
 	}
 	if (iter_sz > 1) {
-		if (apol_str_append(&tmp, &tmp_sz, "{ ")) {
+		if (apol_render_sink_append(sink, "{ ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -1139,7 +1188,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 			error = errno;
 			goto err;
 		}
-		if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+		if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -1147,7 +1196,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 	}
 	qpol_iterator_destroy(&iter);
 	if (iter_sz > 1) {
-		if (apol_str_append(&tmp, &tmp_sz, "} ")) {
+		if (apol_render_sink_append(sink, "} ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -1165,7 +1214,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 		goto err;
 	}
 	if (iter_sz > 1) {
-		if (apol_str_append(&tmp, &tmp_sz, "{ ")) {
+		if (apol_render_sink_append(sink, "{ ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -1177,7 +1226,7 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 			ERR(policy, "%s", strerror(error));
 			goto err;
 		}
-		if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+		if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -1185,25 +1234,45 @@ char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule
 	}
 	qpol_iterator_destroy(&iter);
 	if (iter_sz > 1) {
-		if (apol_str_append(&tmp, &tmp_sz, "} ")) {
+		if (apol_render_sink_append(sink, "} ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
 		}
 	}
 
-	if (apol_str_append(&tmp, &tmp_sz, ";")) {
+	if (apol_render_sink_append(sink, ";")) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
 	}
 
-	return tmp;
+	return 0;
 
       err:
-	free(tmp);
 	qpol_iterator_destroy(&iter);
 	qpol_iterator_destroy(&iter2);
 	errno = error;
-	return NULL;
+	return -1;
+}
+
+char *apol_syn_avrule_render(const apol_policy_t * policy, const qpol_syn_avrule_t * rule)
+{
+	apol_render_sink_t *sink = NULL;
+	char *tmp = NULL;
+	int error;
+
+	if ((sink = apol_render_sink_create_buffer()) == NULL) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return NULL;
+	}
+	if (apol_syn_avrule_render_to_sink(policy, rule, sink) == 0 && (tmp = apol_render_sink_take_string(sink)) == NULL) {
+		ERR(policy, "%s", strerror(errno));
+	}
+	error = errno;
+	apol_render_sink_destroy(&sink);
+	errno = error;
+	return tmp;
 }
@@ -350,3 +350,11 @@ int apol_bst_inorder_map(const apol_bst_t * b, int (*fn) (void *, void *), void
 		return -1;
 	return bst_inorder_map(b->head, fn, data);
 }
+
+size_t bst_get_footprint(const apol_bst_t * b)
+{
+	if (b == NULL) {
+		return 0;
+	}
+	return sizeof(*b) + b->size * sizeof(bst_node_t);
+}
@@ -0,0 +1,135 @@
+/**
+ *  @file
+ *  Implementation of work budgets for resumable searches.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "policy-query-internal.h"
+
+#include <apol/budget.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct apol_budget
+{
+	/** limits; 0 means no limit */
+	unsigned int time_limit;
+	size_t max_nodes, max_results;
+	/** when the current call began */
+	struct timespec start;
+	/** nodes expanded during the current call */
+	size_t nodes;
+	/** number of results held by the caller's vector when the
+	 *  current call began */
+	size_t results_base;
+	/** limits that stopped the current call */
+	unsigned int spent;
+};
+
+apol_budget_t *apol_budget_create(void)
+{
+	return calloc(1, sizeof(apol_budget_t));
+}
+
+void apol_budget_destroy(apol_budget_t ** budget)
+{
+	if (budget != NULL && *budget != NULL) {
+		free(*budget);
+		*budget = NULL;
+	}
+}
+
+int apol_budget_set_time_limit(apol_budget_t * budget, unsigned int msec)
+{
+	if (budget == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	budget->time_limit = msec;
+	return 0;
+}
+
+int apol_budget_set_max_nodes(apol_budget_t * budget, size_t max_nodes)
+{
+	if (budget == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	budget->max_nodes = max_nodes;
+	return 0;
+}
+
+int apol_budget_set_max_results(apol_budget_t * budget, size_t max_results)
+{
+	if (budget == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	budget->max_results = max_results;
+	return 0;
+}
+
+unsigned int apol_budget_get_spent(const apol_budget_t * budget)
+{
+	if (budget == NULL) {
+		return 0;
+	}
+	return budget->spent;
+}
+
+/******************** functions used by searches ********************/
+
+void apol_budget_begin(apol_budget_t * budget, size_t num_results)
+{
+	if (budget != NULL) {
+		clock_gettime(CLOCK_MONOTONIC, &budget->start);
+		budget->nodes = 0;
+		budget->results_base = num_results;
+		budget->spent = 0;
+	}
+}
+
+void apol_budget_add_nodes(apol_budget_t * budget, size_t n)
+{
+	if (budget != NULL) {
+		budget->nodes += n;
+	}
+}
+
+int apol_budget_is_spent(apol_budget_t * budget, size_t num_results)
+{
+	struct timespec now;
+	double elapsed;
+	if (budget == NULL) {
+		return 0;
+	}
+	if (budget->max_nodes > 0 && budget->nodes >= budget->max_nodes) {
+		budget->spent |= APOL_BUDGET_NODES;
+	}
+	if (budget->max_results > 0 && num_results >= budget->results_base &&
+	    num_results - budget->results_base >= budget->max_results) {
+		budget->spent |= APOL_BUDGET_RESULTS;
+	}
+	if (budget->time_limit > 0) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		elapsed = (now.tv_sec - budget->start.tv_sec) * 1000.0 + (now.tv_nsec - budget->start.tv_nsec) / 1000000.0;
+		if (elapsed >= budget->time_limit) {
+			budget->spent |= APOL_BUDGET_TIME;
+		}
+	}
+	return budget->spent != 0;
+}
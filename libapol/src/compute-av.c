@@ -0,0 +1,480 @@
+/**
+ *  @file
+ *  Implementation of offline access vector computation and its
+ *  least-recently-used decision cache.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "policy-query-internal.h"
+#include <apol/compute-av.h>
+#include <errno.h>
+#include <string.h>
+
+/** number of decisions cached unless the caller says otherwise */
+#define AVC_DEFAULT_CAPACITY 512
+
+/** a cache key is the source and target context keys and the class value */
+#define AVC_KEY_SIZE (2 * CONSTRAINT_KEY_SIZE + 1)
+
+typedef struct avc_entry
+{
+	uint32_t key[AVC_KEY_SIZE];
+	apol_av_decision_t avd;
+	/** next entry within the same hash bucket */
+	struct avc_entry *chain;
+	/** neighbors within the recently used list */
+	struct avc_entry *prev, *next;
+} avc_entry_t;
+
+struct apol_avc
+{
+	/** preallocated entries; the first size of them are in use */
+	avc_entry_t *entries;
+	/** hash buckets; the number of buckets is a power of 2 */
+	avc_entry_t **buckets;
+	size_t num_buckets;
+	/** most and least recently used entries */
+	avc_entry_t *head, *tail;
+	/** the policy's conditional sequence number when the cache was
+	 *  last flushed */
+	unsigned int cond_seqno;
+	apol_avc_stats_t stats;
+};
+
+void avc_destroy(apol_avc_t ** avc)
+{
+	if (avc == NULL || *avc == NULL) {
+		return;
+	}
+	free((*avc)->entries);
+	free((*avc)->buckets);
+	free(*avc);
+	*avc = NULL;
+}
+
+static void avc_clear(apol_avc_t * avc)
+{
+	if (avc->num_buckets > 0) {
+		memset(avc->buckets, 0, avc->num_buckets * sizeof(*avc->buckets));
+	}
+	avc->head = avc->tail = NULL;
+	avc->stats.size = 0;
+}
+
+void avc_get_memory_usage(const apol_avc_t * avc, apol_memory_usage_t * usage)
+{
+	if (avc == NULL) {
+		return;
+	}
+	usage->bytes += sizeof(*avc) + avc->stats.capacity * sizeof(*avc->entries) + avc->num_buckets * sizeof(*avc->buckets);
+	usage->count += avc->stats.size;
+}
+
+/**
+ * Allocate a cache's entries and buckets for a given capacity,
+ * discarding any cached decisions.
+ */
+static int avc_alloc(const apol_policy_t * p, apol_avc_t * avc, size_t capacity)
+{
+	avc_entry_t *entries = NULL;
+	avc_entry_t **buckets = NULL;
+	size_t num_buckets = 0;
+	if (capacity > 0) {
+		num_buckets = 1;
+		while (num_buckets < capacity) {
+			num_buckets *= 2;
+		}
+		if ((entries = malloc(capacity * sizeof(*entries))) == NULL ||
+		    (buckets = calloc(num_buckets, sizeof(*buckets))) == NULL) {
+			int error = errno;
+			ERR(p, "%s", strerror(error));
+			free(entries);
+			errno = error;
+			return -1;
+		}
+	}
+	free(avc->entries);
+	free(avc->buckets);
+	avc->entries = entries;
+	avc->buckets = buckets;
+	avc->num_buckets = num_buckets;
+	avc->stats.capacity = capacity;
+	avc_clear(avc);
+	return 0;
+}
+
+/**
+ * Get a policy's cache, creating it if needed.  Flush it if the
+ * policy's boolean values have changed since it was last used; it is
+ * discarded altogether if the policy has been rebuilt.
+ */
+static apol_avc_t *avc_get(apol_policy_t * p)
+{
+	unsigned int seqno;
+	apol_policy_check_rebuild(p);
+	if (qpol_policy_get_cond_seqno(p->p, &seqno) < 0) {
+		return NULL;
+	}
+	if (p->avc == NULL) {
+		if ((p->avc = calloc(1, sizeof(*p->avc))) == NULL) {
+			ERR(p, "%s", strerror(errno));
+			return NULL;
+		}
+		if (avc_alloc(p, p->avc, AVC_DEFAULT_CAPACITY) < 0) {
+			avc_destroy(&p->avc);
+			return NULL;
+		}
+		p->avc->cond_seqno = seqno;
+	} else if (p->avc->cond_seqno != seqno) {
+		avc_clear(p->avc);
+		p->avc->cond_seqno = seqno;
+	}
+	return p->avc;
+}
+
+static size_t avc_hash(const uint32_t * key)
+{
+	/* FNV-1a over the key's words */
+	uint32_t hash = 2166136261U;
+	size_t i;
+	for (i = 0; i < AVC_KEY_SIZE; i++) {
+		hash = (hash ^ key[i]) * 16777619U;
+	}
+	return hash ^ (hash >> 16);
+}
+
+static void avc_unlink(apol_avc_t * avc, avc_entry_t * e)
+{
+	if (e->prev != NULL) {
+		e->prev->next = e->next;
+	} else {
+		avc->head = e->next;
+	}
+	if (e->next != NULL) {
+		e->next->prev = e->prev;
+	} else {
+		avc->tail = e->prev;
+	}
+}
+
+static void avc_push_front(apol_avc_t * avc, avc_entry_t * e)
+{
+	e->prev = NULL;
+	e->next = avc->head;
+	if (avc->head != NULL) {
+		avc->head->prev = e;
+	} else {
+		avc->tail = e;
+	}
+	avc->head = e;
+}
+
+/**
+ * Find a cached decision, marking it as the most recently used.
+ *
+ * @return The entry, or NULL if not cached.
+ */
+static avc_entry_t *avc_lookup(apol_avc_t * avc, const uint32_t * key)
+{
+	avc_entry_t *e;
+	if (avc->num_buckets == 0) {
+		return NULL;
+	}
+	for (e = avc->buckets[avc_hash(key) & (avc->num_buckets - 1)]; e != NULL; e = e->chain) {
+		if (memcmp(e->key, key, sizeof(e->key)) == 0) {
+			if (e != avc->head) {
+				avc_unlink(avc, e);
+				avc_push_front(avc, e);
+			}
+			return e;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Add a decision to the cache, evicting the least recently used
+ * decision if the cache is full.
+ */
+static void avc_insert(apol_avc_t * avc, const uint32_t * key, const apol_av_decision_t * avd)
+{
+	avc_entry_t *e, **link;
+	if (avc->stats.capacity == 0) {
+		return;
+	}
+	if (avc->stats.size < avc->stats.capacity) {
+		e = avc->entries + avc->stats.size++;
+	} else {
+		e = avc->tail;
+		for (link = avc->buckets + (avc_hash(e->key) & (avc->num_buckets - 1)); *link != e; link = &(*link)->chain) ;
+		*link = e->chain;
+		avc_unlink(avc, e);
+		avc->stats.evictions++;
+	}
+	memcpy(e->key, key, sizeof(e->key));
+	e->avd = *avd;
+	link = avc->buckets + (avc_hash(key) & (avc->num_buckets - 1));
+	e->chain = *link;
+	*link = e;
+	avc_push_front(avc, e);
+}
+
+/**
+ * Look up a class by name, writing its value into the last word of a
+ * cache key.
+ */
+static int compute_av_get_class(apol_policy_t * p, const char *obj_class, const qpol_class_t ** datum, uint32_t * key)
+{
+	if (obj_class == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	if (qpol_policy_get_class_by_name(p->p, obj_class, datum) < 0 ||
+	    qpol_class_get_value(p->p, *datum, key + 2 * CONSTRAINT_KEY_SIZE) < 0) {
+		return -1;
+	}
+	return 0;
+}
+
+static int compute_av_get_type(apol_policy_t * p, const apol_context_t * context, const qpol_type_t ** type)
+{
+	unsigned char isattr;
+	if (qpol_policy_get_type_by_name(p->p, apol_context_get_type(context), type) < 0 ||
+	    qpol_type_get_isattr(p->p, *type, &isattr) < 0) {
+		return -1;
+	}
+	if (isattr) {
+		ERR(p, "%s", "Contexts may not use attributes to compute access vectors.");
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Compute a decision for contexts that were already resolved into
+ * the policy's constraint program, consulting the cache first.
+ */
+static int compute_av_decide(apol_policy_t * p, apol_avc_t * avc, const uint32_t * key, const apol_context_t * scontext,
+			     const apol_context_t * tcontext, const qpol_class_t * obj_class, apol_av_decision_t * avd)
+{
+	const qpol_type_t *stype, *ttype;
+	unsigned char permissive;
+	avc_entry_t *e;
+
+	avc->stats.lookups++;
+	if ((e = avc_lookup(avc, key)) != NULL) {
+		avc->stats.hits++;
+		apol_stats_add(p, QPOL_STATS_CACHE_HITS, 1);
+		*avd = e->avd;
+		return 0;
+	}
+	avc->stats.misses++;
+	apol_stats_add(p, QPOL_STATS_CACHE_MISSES, 1);
+	if (compute_av_get_type(p, scontext, &stype) < 0 || compute_av_get_type(p, tcontext, &ttype) < 0 ||
+	    qpol_policy_compute_av(p->p, stype, ttype, obj_class, &avd->allowed, &avd->auditallow, &avd->auditdeny) < 0 ||
+	    qpol_type_get_ispermissive(p->p, stype, &permissive) < 0) {
+		return -1;
+	}
+	avd->permissive = permissive;
+	avd->constrained = constraint_program_denied(p, key[2 * CONSTRAINT_KEY_SIZE], avd->allowed);
+	avd->allowed &= ~avd->constrained;
+	avc_insert(avc, key, avd);
+	return 0;
+}
+
+int apol_compute_av(apol_policy_t * p, const apol_context_t * scontext, const apol_context_t * tcontext, const char *obj_class,
+		    apol_av_decision_t * avd)
+{
+	const qpol_class_t *datum;
+	uint32_t key[AVC_KEY_SIZE];
+	apol_avc_t *avc;
+
+	if (p == NULL || avd == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	memset(avd, 0, sizeof(*avd));
+	if ((avc = avc_get(p)) == NULL || compute_av_get_class(p, obj_class, &datum, key) < 0 ||
+	    constraint_program_resolve_context(p, scontext, 0, key) < 0 ||
+	    constraint_program_resolve_context(p, tcontext, 1, key + CONSTRAINT_KEY_SIZE) < 0) {
+		return -1;
+	}
+	return compute_av_decide(p, avc, key, scontext, tcontext, datum, avd);
+}
+
+int apol_compute_av_batch(apol_policy_t * p, const apol_context_t * const *scontexts, const apol_context_t * const *tcontexts,
+			  const char *const *obj_classes, size_t num, apol_av_decision_t * avds)
+{
+	const qpol_class_t *datum = NULL;
+	uint32_t key[AVC_KEY_SIZE];
+	apol_avc_t *avc;
+	size_t i;
+
+	if (p == NULL || (num > 0 && (scontexts == NULL || tcontexts == NULL || obj_classes == NULL || avds == NULL))) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	if ((avc = avc_get(p)) == NULL) {
+		return -1;
+	}
+	for (i = 0; i < num; i++) {
+		memset(avds + i, 0, sizeof(avds[i]));
+		if ((i == 0 || obj_classes[i] != obj_classes[i - 1]) && compute_av_get_class(p, obj_classes[i], &datum, key) < 0) {
+			return -1;
+		}
+		if ((i == 0 || scontexts[i] != scontexts[i - 1]) && constraint_program_resolve_context(p, scontexts[i], 0, key) < 0) {
+			return -1;
+		}
+		if ((i == 0 || tcontexts[i] != tcontexts[i - 1]) &&
+		    constraint_program_resolve_context(p, tcontexts[i], 1, key + CONSTRAINT_KEY_SIZE) < 0) {
+			return -1;
+		}
+		if (compute_av_decide(p, avc, key, scontexts[i], tcontexts[i], datum, avds + i) < 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int apol_class_perms_to_av(apol_policy_t * p, const char *obj_class, const apol_vector_t * perms, uint32_t * av)
+{
+	const qpol_class_t *datum;
+	uint32_t value;
+	size_t i;
+
+	if (av != NULL) {
+		*av = 0;
+	}
+	if (p == NULL || obj_class == NULL || perms == NULL || av == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	if (qpol_policy_get_class_by_name(p->p, obj_class, &datum) < 0) {
+		return -1;
+	}
+	for (i = 0; i < apol_vector_get_size(perms); i++) {
+		const char *perm = apol_vector_get_element(perms, i);
+		if (qpol_class_get_perm_value(p->p, datum, perm, &value) < 0) {
+			ERR(p, "%s is not a permission of class %s.", perm, obj_class);
+			errno = EINVAL;
+			return -1;
+		}
+		*av |= 1U << (value - 1);
+	}
+	return 0;
+}
+
+/**
+ * Append to a vector the permissions from an iterator whose bits are
+ * set within an access vector.
+ */
+static int compute_av_add_perms(apol_policy_t * p, const qpol_class_t * datum, qpol_iterator_t * iter, uint32_t av,
+				apol_vector_t * v)
+{
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		char *perm;
+		uint32_t value;
+		if (qpol_iterator_get_item(iter, (void **)&perm) < 0 || qpol_class_get_perm_value(p->p, datum, perm, &value) < 0) {
+			return -1;
+		}
+		if ((av & (1U << (value - 1))) && apol_vector_append(v, perm) < 0) {
+			ERR(p, "%s", strerror(errno));
+			return -1;
+		}
+	}
+	return 0;
+}
+
+apol_vector_t *apol_class_av_to_perms(apol_policy_t * p, const char *obj_class, uint32_t av)
+{
+	const qpol_class_t *datum;
+	const qpol_common_t *common;
+	qpol_iterator_t *iter = NULL;
+	apol_vector_t *v = NULL;
+	int error = 0;
+
+	if (p == NULL || obj_class == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((v = apol_vector_create(NULL)) == NULL) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
+		goto err;
+	}
+	if (qpol_policy_get_class_by_name(p->p, obj_class, &datum) < 0 || qpol_class_get_common(p->p, datum, &common) < 0) {
+		error = errno;
+		goto err;
+	}
+	if (common != NULL &&
+	    (qpol_common_get_perm_iter(p->p, common, &iter) < 0 || compute_av_add_perms(p, datum, iter, av, v) < 0)) {
+		error = errno;
+		goto err;
+	}
+	qpol_iterator_destroy(&iter);
+	if (qpol_class_get_perm_iter(p->p, datum, &iter) < 0 || compute_av_add_perms(p, datum, iter, av, v) < 0) {
+		error = errno;
+		goto err;
+	}
+	qpol_iterator_destroy(&iter);
+	return v;
+      err:
+	qpol_iterator_destroy(&iter);
+	apol_vector_destroy(&v);
+	errno = error;
+	return NULL;
+}
+
+int apol_avc_set_capacity(apol_policy_t * p, size_t capacity)
+{
+	apol_avc_t *avc;
+	if (p == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	if ((avc = avc_get(p)) == NULL) {
+		return -1;
+	}
+	return avc_alloc(p, avc, capacity);
+}
+
+void apol_avc_flush(apol_policy_t * p)
+{
+	if (p != NULL && p->avc != NULL) {
+		avc_clear(p->avc);
+	}
+}
+
+int apol_avc_get_stats(const apol_policy_t * p, apol_avc_stats_t * stats)
+{
+	if (p == NULL || stats == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (p->avc == NULL) {
+		memset(stats, 0, sizeof(*stats));
+		stats->capacity = AVC_DEFAULT_CAPACITY;
+		return 0;
+	}
+	*stats = p->avc->stats;
+	return 0;
+}
@@ -29,6 +29,8 @@
  */
 
 #include "policy-query-internal.h"
+#include "vector-internal.h"
+#include <apol/hashset.h>
 #include <errno.h>
 #include <string.h>
 
@@ -215,3 +217,1111 @@ int apol_validatetrans_query_set_regex(const apol_policy_t * p, apol_validatetra
 {
 	return apol_query_set_regex(p, &vt->flags, is_regex);
 }
+
+/******************** constraint evaluation ********************/
+
+/** deepest evaluation stack that a compiled expression may need */
+#define CONSTRAINT_MAX_DEPTH 32
+
+#define CONSTRAINT_WORDS(n) (((n) + 31) / 32)
+
+/** context fields that attribute comparisons and name tests read */
+enum constraint_field
+{ CONSTRAINT_USER = 0, CONSTRAINT_ROLE, CONSTRAINT_TYPE, CONSTRAINT_NUM_FIELDS };
+
+/** contexts that an expression may refer to; for validatetrans these
+ *  are the old, new, and task contexts */
+enum constraint_slot
+{ CONSTRAINT_SOURCE = 0, CONSTRAINT_TARGET, CONSTRAINT_EXTRA, CONSTRAINT_NUM_SLOTS };
+
+/**
+ * A compiled expression node.  All names are resolved when compiled,
+ * so that evaluating a node is a single comparison or bit test.
+ */
+typedef struct constraint_insn
+{
+	/** one of QPOL_CEXPR_TYPE_* */
+	unsigned char expr_type;
+	/** one of QPOL_CEXPR_OP_* */
+	unsigned char op;
+	/** context field to compare or test; for an attribute
+	 *  comparison of MLS levels this is CONSTRAINT_NUM_FIELDS */
+	unsigned char field;
+	/** context slot that a name test reads, or the slots and
+	 *  levels (0 for low, 1 for high) that a level comparison
+	 *  reads */
+	unsigned char slot1, level1, slot2, level2;
+	/** for name tests, bitset of matching names indexed by value - 1 */
+	uint32_t *names;
+} constraint_insn_t;
+
+/** a compiled constraint or validatetrans statement */
+typedef struct constraint_prog
+{
+	/** permissions that the constraint governs, as an access
+	 *  vector (permission value v is bit v - 1) */
+	uint32_t perms;
+	constraint_insn_t *insns;
+	size_t num_insns;
+} constraint_prog_t;
+
+typedef struct constraint_class
+{
+	const qpol_class_t *datum;
+	constraint_prog_t *constraints;
+	size_t num_constraints;
+	constraint_prog_t *validatetrans;
+	size_t num_validatetrans;
+} constraint_class_t;
+
+/** a context resolved into values */
+typedef struct constraint_context
+{
+	uint32_t fields[CONSTRAINT_NUM_FIELDS];
+	/** sensitivity values of the low and high levels */
+	uint32_t sens[2];
+	/** category bitsets of the low and high levels */
+	uint32_t *cats[2];
+} constraint_context_t;
+
+/** a distinct MLS level seen while resolving contexts */
+typedef struct constraint_level
+{
+	/** small integer identifying this level, starting at 1 */
+	uint32_t id;
+	uint32_t sens;
+	uint32_t *cats;
+} constraint_level_t;
+
+struct apol_constraint_program
+{
+	/** array of compiled classes, indexed by class value - 1 */
+	constraint_class_t *classes;
+	size_t num_classes;
+	int mls;
+	/** highest user, role, and type values */
+	uint32_t num_values[CONSTRAINT_NUM_FIELDS];
+	/** for each role, a bitset of the roles that it dominates */
+	uint32_t *role_dominates;
+	size_t role_words;
+	/** highest category value, and words per category bitset */
+	uint32_t num_cats;
+	size_t cat_words;
+	/** storage for the contexts' category bitsets */
+	uint32_t *cat_buf;
+	/** contexts being evaluated */
+	constraint_context_t contexts[CONSTRAINT_NUM_SLOTS];
+	/** set of constraint_level_t, so that each distinct level may
+	 *  be identified by a single integer */
+	apol_hashset_t *levels;
+};
+
+static int constraint_get_bit(const uint32_t * set, uint32_t num, uint32_t value)
+{
+	if (value == 0 || value > num) {
+		return 0;
+	}
+	value--;
+	return (set[value / 32] >> (value % 32)) & 1;
+}
+
+static void constraint_set_bit(uint32_t * set, uint32_t value)
+{
+	value--;
+	set[value / 32] |= 1U << (value % 32);
+}
+
+static void constraint_class_destroy(constraint_class_t * cls)
+{
+	size_t i;
+	for (i = 0; i < cls->num_constraints + cls->num_validatetrans; i++) {
+		constraint_prog_t *cp =
+			(i < cls->num_constraints ? cls->constraints + i : cls->validatetrans + i - cls->num_constraints);
+		size_t j;
+		for (j = 0; j < cp->num_insns; j++) {
+			free(cp->insns[j].names);
+		}
+		free(cp->insns);
+	}
+	free(cls->constraints);
+	free(cls->validatetrans);
+}
+
+static void constraint_level_free(void *elem)
+{
+	constraint_level_t *level = elem;
+	if (level != NULL) {
+		free(level->cats);
+		free(level);
+	}
+}
+
+static size_t constraint_level_hash(const void *elem, void *data)
+{
+	const constraint_level_t *level = elem;
+	const apol_constraint_program_t *prog = data;
+	size_t hash = level->sens, i;
+	for (i = 0; i < prog->cat_words; i++) {
+		hash = hash * 31 + level->cats[i];
+	}
+	return hash;
+}
+
+static int constraint_level_comp(const void *a, const void *b, void *data)
+{
+	const constraint_level_t *l1 = a, *l2 = b;
+	const apol_constraint_program_t *prog = data;
+	if (l1->sens != l2->sens) {
+		return 1;
+	}
+	return memcmp(l1->cats, l2->cats, prog->cat_words * sizeof(uint32_t));
+}
+
+void constraint_program_destroy(apol_constraint_program_t ** prog)
+{
+	size_t i;
+	if (prog == NULL || *prog == NULL) {
+		return;
+	}
+	for (i = 0; i < (*prog)->num_classes; i++) {
+		constraint_class_destroy((*prog)->classes + i);
+	}
+	free((*prog)->classes);
+	free((*prog)->role_dominates);
+	free((*prog)->cat_buf);
+	apol_hashset_destroy(&(*prog)->levels);
+	free(*prog);
+	*prog = NULL;
+}
+
+static size_t constraint_prog_memory(const apol_constraint_program_t * prog, const constraint_prog_t * cp)
+{
+	size_t i, bytes = (cp->num_insns + 1) * sizeof(*cp->insns);
+	for (i = 0; i < cp->num_insns; i++) {
+		const constraint_insn_t *insn = cp->insns + i;
+		if (insn->names != NULL) {
+			bytes += (CONSTRAINT_WORDS(prog->num_values[insn->field]) + 1) * sizeof(uint32_t);
+		}
+	}
+	return bytes;
+}
+
+static int constraint_level_memory(void *a __attribute__ ((unused)), void *data)
+{
+	const apol_constraint_program_t *prog = ((void **)data)[0];
+	apol_memory_usage_t *usage = ((void **)data)[1];
+	usage->bytes += sizeof(constraint_level_t) + prog->cat_words * sizeof(uint32_t) + 1;
+	return 0;
+}
+
+void constraint_program_get_memory_usage(const apol_constraint_program_t * prog, apol_memory_usage_t * usage)
+{
+	size_t i, j;
+	void *data[2];
+	if (prog == NULL) {
+		return;
+	}
+	usage->bytes += sizeof(*prog) + (prog->num_classes + 1) * sizeof(*prog->classes);
+	for (i = 0; i < prog->num_classes; i++) {
+		const constraint_class_t *cls = prog->classes + i;
+		usage->bytes += (cls->num_constraints + 1) * sizeof(*cls->constraints);
+		for (j = 0; j < cls->num_constraints; j++) {
+			usage->bytes += constraint_prog_memory(prog, cls->constraints + j);
+		}
+		usage->bytes += (cls->num_validatetrans + 1) * sizeof(*cls->validatetrans);
+		for (j = 0; j < cls->num_validatetrans; j++) {
+			usage->bytes += constraint_prog_memory(prog, cls->validatetrans + j);
+		}
+		usage->count += cls->num_constraints + cls->num_validatetrans;
+	}
+	usage->bytes += (prog->num_values[CONSTRAINT_ROLE] * prog->role_words + 1) * sizeof(uint32_t);
+	usage->bytes += (CONSTRAINT_NUM_SLOTS * 2 * prog->cat_words + 1) * sizeof(uint32_t);
+	usage->bytes += hashset_get_footprint(prog->levels);
+	data[0] = (void *)prog;
+	data[1] = usage;
+	apol_hashset_map(prog->levels, constraint_level_memory, data);
+}
+
+static int constraint_get_iter(const apol_policy_t * p, int field, qpol_iterator_t ** iter)
+{
+	switch (field) {
+	case CONSTRAINT_USER:
+		return qpol_policy_get_user_iter(p->p, iter);
+	case CONSTRAINT_ROLE:
+		return qpol_policy_get_role_iter(p->p, iter);
+	default:
+		return qpol_policy_get_type_iter(p->p, iter);
+	}
+}
+
+static int constraint_get_value(const apol_policy_t * p, int field, const void *datum, uint32_t * value)
+{
+	switch (field) {
+	case CONSTRAINT_USER:
+		return qpol_user_get_value(p->p, (const qpol_user_t *)datum, value);
+	case CONSTRAINT_ROLE:
+		return qpol_role_get_value(p->p, (const qpol_role_t *)datum, value);
+	default:
+		return qpol_type_get_value(p->p, (const qpol_type_t *)datum, value);
+	}
+}
+
+/**
+ * Look up a user, role, or type by name and get its value.
+ */
+static int constraint_lookup(const apol_policy_t * p, int field, const char *name, uint32_t * value)
+{
+	const qpol_user_t *user;
+	const qpol_role_t *role;
+	const qpol_type_t *type;
+	switch (field) {
+	case CONSTRAINT_USER:
+		if (qpol_policy_get_user_by_name(p->p, name, &user) < 0) {
+			return -1;
+		}
+		return qpol_user_get_value(p->p, user, value);
+	case CONSTRAINT_ROLE:
+		if (qpol_policy_get_role_by_name(p->p, name, &role) < 0) {
+			return -1;
+		}
+		return qpol_role_get_value(p->p, role, value);
+	default:
+		if (qpol_policy_get_type_by_name(p->p, name, &type) < 0) {
+			return -1;
+		}
+		return qpol_type_get_value(p->p, type, value);
+	}
+}
+
+/**
+ * Record the highest user, role, type, and category values, and
+ * build the role dominance table.
+ */
+static int constraint_program_init(const apol_policy_t * p, apol_constraint_program_t * prog)
+{
+	qpol_iterator_t *iter = NULL, *dom_iter = NULL;
+	const qpol_role_t *role;
+	const qpol_cat_t *cat;
+	uint32_t value, dom_value;
+	size_t i, j;
+	int field, retval = -1;
+
+	prog->mls = apol_policy_is_mls(p);
+	for (field = 0; field < CONSTRAINT_NUM_FIELDS; field++) {
+		if (constraint_get_iter(p, field, &iter) < 0) {
+			goto cleanup;
+		}
+		for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+			void *datum;
+			if (qpol_iterator_get_item(iter, &datum) < 0 || constraint_get_value(p, field, datum, &value) < 0) {
+				goto cleanup;
+			}
+			if (value > prog->num_values[field]) {
+				prog->num_values[field] = value;
+			}
+		}
+		qpol_iterator_destroy(&iter);
+	}
+
+	/* by convention a role always dominates itself */
+	prog->role_words = CONSTRAINT_WORDS(prog->num_values[CONSTRAINT_ROLE]);
+	if ((prog->role_dominates = calloc(prog->num_values[CONSTRAINT_ROLE] * prog->role_words + 1, sizeof(uint32_t))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	if (qpol_policy_get_role_iter(p->p, &iter) < 0) {
+		goto cleanup;
+	}
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		uint32_t *row;
+		if (qpol_iterator_get_item(iter, (void **)&role) < 0 || qpol_role_get_value(p->p, role, &value) < 0 ||
+		    qpol_role_get_dominate_iter(p->p, role, &dom_iter) < 0) {
+			goto cleanup;
+		}
+		row = prog->role_dominates + (value - 1) * prog->role_words;
+		constraint_set_bit(row, value);
+		for (; !qpol_iterator_end(dom_iter); qpol_iterator_next(dom_iter)) {
+			const qpol_role_t *dom;
+			if (qpol_iterator_get_item(dom_iter, (void **)&dom) < 0 || qpol_role_get_value(p->p, dom, &dom_value) < 0) {
+				goto cleanup;
+			}
+			constraint_set_bit(row, dom_value);
+		}
+		qpol_iterator_destroy(&dom_iter);
+	}
+	qpol_iterator_destroy(&iter);
+
+	if (prog->mls) {
+		if (qpol_policy_get_cat_iter(p->p, &iter) < 0) {
+			goto cleanup;
+		}
+		for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+			if (qpol_iterator_get_item(iter, (void **)&cat) < 0 || qpol_cat_get_value(p->p, cat, &value) < 0) {
+				goto cleanup;
+			}
+			if (value > prog->num_cats) {
+				prog->num_cats = value;
+			}
+		}
+		qpol_iterator_destroy(&iter);
+	}
+	prog->cat_words = CONSTRAINT_WORDS(prog->num_cats);
+	if ((prog->cat_buf = calloc(CONSTRAINT_NUM_SLOTS * 2 * prog->cat_words + 1, sizeof(uint32_t))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	for (i = 0; i < CONSTRAINT_NUM_SLOTS; i++) {
+		for (j = 0; j < 2; j++) {
+			prog->contexts[i].cats[j] = prog->cat_buf + (i * 2 + j) * prog->cat_words;
+		}
+	}
+	if ((prog->levels = apol_hashset_create(constraint_level_hash, constraint_level_comp, constraint_level_free)) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	retval = 0;
+      cleanup:
+	qpol_iterator_destroy(&iter);
+	qpol_iterator_destroy(&dom_iter);
+	return retval;
+}
+
+/**
+ * Compile the names of a name test into a bitset.  The set is taken
+ * from the expanded expression, so that attributes, '*', '~', and
+ * subtracted types match as the kernel would match them.
+ */
+static int constraint_compile_names(const apol_policy_t * p, const apol_constraint_program_t * prog,
+				    const qpol_constraint_expr_node_t * expr, constraint_insn_t * insn)
+{
+	uint32_t *values = NULL;
+	size_t i, num_values, words = CONSTRAINT_WORDS(prog->num_values[insn->field]) + 1;
+	int retval = -1;
+
+	if ((insn->names = calloc(words, sizeof(uint32_t))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	if (qpol_constraint_expr_node_get_values(p->p, expr, &values, &num_values) < 0) {
+		goto cleanup;
+	}
+	for (i = 0; i < num_values; i++) {
+		/* no context can hold a value beyond those in use */
+		if (values[i] <= prog->num_values[insn->field]) {
+			constraint_set_bit(insn->names, values[i]);
+		}
+	}
+	retval = 0;
+      cleanup:
+	free(values);
+	return retval;
+}
+
+/**
+ * Compile a constraint or validatetrans expression, checking that it
+ * is well formed along the way.
+ *
+ * @param p Policy containing the expression.
+ * @param prog Program being compiled.
+ * @param iter Iterator of qpol_constraint_expr_node_t, in postfix
+ * order.
+ * @param is_vtrans Non-zero if the expression belongs to a
+ * validatetrans statement, and thus may refer to a third context.
+ * @param cp Compiled statement to which to write instructions.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int constraint_compile_expr(const apol_policy_t * p, const apol_constraint_program_t * prog, qpol_iterator_t * iter,
+				   int is_vtrans, constraint_prog_t * cp)
+{
+	const qpol_constraint_expr_node_t *expr;
+	size_t size, depth = 0;
+	uint32_t expr_type, sym, op, base;
+
+	if (qpol_iterator_get_size(iter, &size) < 0) {
+		return -1;
+	}
+	if ((cp->insns = calloc(size + 1, sizeof(*cp->insns))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		return -1;
+	}
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		constraint_insn_t *insn = cp->insns + cp->num_insns;
+		if (qpol_iterator_get_item(iter, (void **)&expr) < 0 ||
+		    qpol_constraint_expr_node_get_expr_type(p->p, expr, &expr_type) < 0 ||
+		    qpol_constraint_expr_node_get_sym_type(p->p, expr, &sym) < 0 ||
+		    qpol_constraint_expr_node_get_op(p->p, expr, &op) < 0) {
+			return -1;
+		}
+		cp->num_insns++;
+		insn->expr_type = expr_type;
+		insn->op = op;
+		switch (expr_type) {
+		case QPOL_CEXPR_TYPE_NOT:
+			if (depth < 1) {
+				goto malformed;
+			}
+			break;
+		case QPOL_CEXPR_TYPE_AND:
+		case QPOL_CEXPR_TYPE_OR:
+			if (depth < 2) {
+				goto malformed;
+			}
+			depth--;
+			break;
+		case QPOL_CEXPR_TYPE_ATTR:
+			insn->slot1 = CONSTRAINT_SOURCE;
+			insn->slot2 = CONSTRAINT_TARGET;
+			switch (sym) {
+			case QPOL_CEXPR_SYM_USER:
+				insn->field = CONSTRAINT_USER;
+				break;
+			case QPOL_CEXPR_SYM_ROLE:
+				insn->field = CONSTRAINT_ROLE;
+				break;
+			case QPOL_CEXPR_SYM_TYPE:
+				insn->field = CONSTRAINT_TYPE;
+				break;
+			case QPOL_CEXPR_SYM_L1L2:
+			case QPOL_CEXPR_SYM_L1H2:
+			case QPOL_CEXPR_SYM_H1L2:
+			case QPOL_CEXPR_SYM_H1H2:
+				insn->field = CONSTRAINT_NUM_FIELDS;
+				insn->level1 = (sym == QPOL_CEXPR_SYM_H1L2 || sym == QPOL_CEXPR_SYM_H1H2);
+				insn->level2 = (sym == QPOL_CEXPR_SYM_L1H2 || sym == QPOL_CEXPR_SYM_H1H2);
+				break;
+			case QPOL_CEXPR_SYM_L1H1:
+			case QPOL_CEXPR_SYM_L2H2:
+				insn->field = CONSTRAINT_NUM_FIELDS;
+				insn->slot1 = insn->slot2 = (sym == QPOL_CEXPR_SYM_L1H1 ? CONSTRAINT_SOURCE : CONSTRAINT_TARGET);
+				insn->level1 = 0;
+				insn->level2 = 1;
+				break;
+			default:
+				goto malformed;
+			}
+			if (insn->field < CONSTRAINT_NUM_FIELDS && insn->field != CONSTRAINT_ROLE &&
+			    op != QPOL_CEXPR_OP_EQ && op != QPOL_CEXPR_OP_NEQ) {
+				goto malformed;
+			}
+			if (insn->field == CONSTRAINT_NUM_FIELDS && !prog->mls) {
+				goto malformed;
+			}
+			if (++depth > CONSTRAINT_MAX_DEPTH) {
+				goto malformed;
+			}
+			break;
+		case QPOL_CEXPR_TYPE_NAMES:
+			insn->slot1 = CONSTRAINT_SOURCE;
+			if (sym & QPOL_CEXPR_SYM_TARGET) {
+				insn->slot1 = CONSTRAINT_TARGET;
+			} else if (sym & QPOL_CEXPR_SYM_XTARGET) {
+				if (!is_vtrans) {
+					goto malformed;
+				}
+				insn->slot1 = CONSTRAINT_EXTRA;
+			}
+			base = sym & ~(QPOL_CEXPR_SYM_TARGET | QPOL_CEXPR_SYM_XTARGET);
+			if (base == QPOL_CEXPR_SYM_USER) {
+				insn->field = CONSTRAINT_USER;
+			} else if (base == QPOL_CEXPR_SYM_ROLE) {
+				insn->field = CONSTRAINT_ROLE;
+			} else if (base == QPOL_CEXPR_SYM_TYPE) {
+				insn->field = CONSTRAINT_TYPE;
+			} else {
+				goto malformed;
+			}
+			if ((op != QPOL_CEXPR_OP_EQ && op != QPOL_CEXPR_OP_NEQ) || ++depth > CONSTRAINT_MAX_DEPTH) {
+				goto malformed;
+			}
+			if (constraint_compile_names(p, prog, expr, insn) < 0) {
+				return -1;
+			}
+			break;
+		default:
+			goto malformed;
+		}
+	}
+	if (depth != 1) {
+		goto malformed;
+	}
+	return 0;
+      malformed:
+	ERR(p, "%s", "Constraint expression is malformed.");
+	errno = EINVAL;
+	return -1;
+}
+
+static int constraint_add_perms(const apol_policy_t * p, qpol_iterator_t * iter, apol_vector_t * v)
+{
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		char *perm;
+		if (qpol_iterator_get_item(iter, (void **)&perm) < 0) {
+			return -1;
+		}
+		if (apol_vector_append(v, perm) < 0) {
+			ERR(p, "%s", strerror(errno));
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Convert a vector of permission names into an access vector.
+ *
+ * @param p Policy, to report errors.
+ * @param cls Class whose permissions to use.
+ * @param perms Vector of permission names.
+ * @param bits If non-NULL, array into which to write each
+ * permission's bit.
+ * @param mask Location to write the union of all the bits.
+ *
+ * @return 0 on success, < 0 if a permission does not belong to the
+ * class.
+ */
+static int constraint_resolve_perms(const apol_policy_t * p, const constraint_class_t * cls, const apol_vector_t * perms,
+				    uint32_t * bits, uint32_t * mask)
+{
+	uint32_t value;
+	size_t i;
+	*mask = 0;
+	for (i = 0; i < apol_vector_get_size(perms); i++) {
+		const char *perm = apol_vector_get_element(perms, i);
+		if (qpol_class_get_perm_value(p->p, cls->datum, perm, &value) < 0) {
+			ERR(p, "%s is not a permission of the class.", perm);
+			errno = EINVAL;
+			return -1;
+		}
+		if (bits != NULL) {
+			bits[i] = 1U << (value - 1);
+		}
+		*mask |= 1U << (value - 1);
+	}
+	return 0;
+}
+
+/**
+ * Compile one class's constraints and validatetrans statements.
+ */
+static int constraint_compile_class(const apol_policy_t * p, const apol_constraint_program_t * prog, const qpol_class_t * obj_class,
+				    constraint_class_t * cls)
+{
+	qpol_iterator_t *iter = NULL, *sub_iter = NULL;
+	qpol_constraint_t *constr = NULL;
+	qpol_validatetrans_t *vtrans = NULL;
+	apol_vector_t *perms = NULL;
+	size_t size;
+	int retval = -1;
+
+	cls->datum = obj_class;
+	if (qpol_class_get_constraint_iter(p->p, obj_class, &iter) < 0 || qpol_iterator_get_size(iter, &size) < 0) {
+		goto cleanup;
+	}
+	if ((cls->constraints = calloc(size + 1, sizeof(*cls->constraints))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		constraint_prog_t *cp = cls->constraints + cls->num_constraints;
+		if (qpol_iterator_get_item(iter, (void **)&constr) < 0) {
+			goto cleanup;
+		}
+		cls->num_constraints++;
+		if (qpol_constraint_get_perm_iter(p->p, constr, &sub_iter) < 0) {
+			goto cleanup;
+		}
+		if ((perms = apol_vector_create(free)) == NULL) {
+			ERR(p, "%s", strerror(errno));
+			goto cleanup;
+		}
+		if (constraint_add_perms(p, sub_iter, perms) < 0 || constraint_resolve_perms(p, cls, perms, NULL, &cp->perms) < 0) {
+			goto cleanup;
+		}
+		apol_vector_destroy(&perms);
+		qpol_iterator_destroy(&sub_iter);
+		if (qpol_constraint_get_expr_iter(p->p, constr, &sub_iter) < 0 ||
+		    constraint_compile_expr(p, prog, sub_iter, 0, cp) < 0) {
+			goto cleanup;
+		}
+		qpol_iterator_destroy(&sub_iter);
+		free(constr);
+		constr = NULL;
+	}
+	qpol_iterator_destroy(&iter);
+
+	if (qpol_class_get_validatetrans_iter(p->p, obj_class, &iter) < 0 || qpol_iterator_get_size(iter, &size) < 0) {
+		goto cleanup;
+	}
+	if ((cls->validatetrans = calloc(size + 1, sizeof(*cls->validatetrans))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		constraint_prog_t *cp = cls->validatetrans + cls->num_validatetrans;
+		if (qpol_iterator_get_item(iter, (void **)&vtrans) < 0) {
+			goto cleanup;
+		}
+		cls->num_validatetrans++;
+		if (qpol_validatetrans_get_expr_iter(p->p, vtrans, &sub_iter) < 0 ||
+		    constraint_compile_expr(p, prog, sub_iter, 1, cp) < 0) {
+			goto cleanup;
+		}
+		qpol_iterator_destroy(&sub_iter);
+		free(vtrans);
+		vtrans = NULL;
+	}
+	retval = 0;
+      cleanup:
+	free(constr);
+	free(vtrans);
+	apol_vector_destroy(&perms);
+	qpol_iterator_destroy(&iter);
+	qpol_iterator_destroy(&sub_iter);
+	return retval;
+}
+
+int apol_policy_build_constraint_program(apol_policy_t * p)
+{
+	apol_constraint_program_t *prog = NULL;
+	qpol_iterator_t *iter = NULL;
+	const qpol_class_t *obj_class;
+	uint32_t value;
+	size_t size;
+	int error = 0;
+
+	if (!p) {
+		errno = EINVAL;
+		return -1;
+	}
+	apol_policy_check_rebuild(p);
+	if (p->constraint_program != NULL) {
+		return 0;
+	}
+	if ((prog = calloc(1, sizeof(*prog))) == NULL) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
+		goto err;
+	}
+	if (constraint_program_init(p, prog) < 0 || qpol_policy_get_class_iter(p->p, &iter) < 0 ||
+	    qpol_iterator_get_size(iter, &size) < 0) {
+		error = errno;
+		goto err;
+	}
+	/* class values are dense, so the number of classes is also the
+	 * highest class value */
+	if ((prog->classes = calloc(size + 1, sizeof(*prog->classes))) == NULL) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
+		goto err;
+	}
+	prog->num_classes = size;
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		if (qpol_iterator_get_item(iter, (void **)&obj_class) < 0 || qpol_class_get_value(p->p, obj_class, &value) < 0) {
+			error = errno;
+			goto err;
+		}
+		if (value == 0 || value > size) {
+			error = EINVAL;
+			ERR(p, "%s", "Class values are not dense.");
+			goto err;
+		}
+		if (constraint_compile_class(p, prog, obj_class, prog->classes + value - 1) < 0) {
+			error = errno;
+			goto err;
+		}
+	}
+	qpol_iterator_destroy(&iter);
+	p->constraint_program = prog;
+	return 0;
+      err:
+	qpol_iterator_destroy(&iter);
+	constraint_program_destroy(&prog);
+	errno = error;
+	return -1;
+}
+
+/**
+ * Resolve an MLS level into its sensitivity value and category
+ * bitset.
+ */
+static int constraint_resolve_level(const apol_policy_t * p, const apol_constraint_program_t * prog,
+				    const apol_mls_level_t * level, uint32_t * sens, uint32_t * cats)
+{
+	const apol_vector_t *cat_names;
+	const qpol_level_t *datum;
+	const qpol_cat_t *cat;
+	uint32_t value;
+	size_t i;
+	if (qpol_policy_get_level_by_name(p->p, apol_mls_level_get_sens(level), &datum) < 0 ||
+	    qpol_level_get_value(p->p, datum, sens) < 0) {
+		return -1;
+	}
+	if ((cat_names = apol_mls_level_get_cats(level)) == NULL) {
+		ERR(p, "%s", "Literal MLS levels must be converted before evaluating constraints.");
+		errno = EINVAL;
+		return -1;
+	}
+	memset(cats, 0, prog->cat_words * sizeof(*cats));
+	for (i = 0; i < apol_vector_get_size(cat_names); i++) {
+		if (qpol_policy_get_cat_by_name(p->p, apol_vector_get_element(cat_names, i), &cat) < 0 ||
+		    qpol_cat_get_value(p->p, cat, &value) < 0) {
+			return -1;
+		}
+		if (value > 0 && value <= prog->num_cats) {
+			constraint_set_bit(cats, value);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Get the identifier of a resolved level, assigning a new one if the
+ * level has not been seen before.
+ */
+static int constraint_intern_level(const apol_policy_t * p, apol_constraint_program_t * prog, uint32_t sens, uint32_t * cats,
+				   uint32_t * id)
+{
+	constraint_level_t probe, *level = NULL;
+	probe.sens = sens;
+	probe.cats = cats;
+	if (apol_hashset_get_element(prog->levels, &probe, prog, (void **)&level) == 0) {
+		*id = level->id;
+		return 0;
+	}
+	if ((level = calloc(1, sizeof(*level))) == NULL ||
+	    (level->cats = malloc(prog->cat_words * sizeof(uint32_t) + 1)) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		free(level);
+		return -1;
+	}
+	memcpy(level->cats, cats, prog->cat_words * sizeof(uint32_t));
+	level->sens = sens;
+	level->id = apol_hashset_get_size(prog->levels) + 1;
+	if (apol_hashset_insert(prog->levels, level, prog) < 0) {
+		ERR(p, "%s", strerror(errno));
+		constraint_level_free(level);
+		return -1;
+	}
+	*id = level->id;
+	return 0;
+}
+
+/**
+ * Resolve a context into one of the program's context slots.
+ *
+ * @param key If non-NULL, an array of CONSTRAINT_KEY_SIZE integers
+ * to which to write the context's user, role, and type values and
+ * the identifiers of its low and high levels (0 if the policy is not
+ * MLS).  Contexts that resolve to equal keys behave identically in
+ * all constraints.
+ */
+static int constraint_resolve_context(const apol_policy_t * p, apol_constraint_program_t * prog,
+				      const apol_context_t * context, int slot, uint32_t * key)
+{
+	constraint_context_t *c = prog->contexts + slot;
+	const char *names[CONSTRAINT_NUM_FIELDS];
+	const apol_mls_range_t *range;
+	const apol_mls_level_t *levels[2];
+	int i;
+
+	if (context == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	names[CONSTRAINT_USER] = apol_context_get_user(context);
+	names[CONSTRAINT_ROLE] = apol_context_get_role(context);
+	names[CONSTRAINT_TYPE] = apol_context_get_type(context);
+	for (i = 0; i < CONSTRAINT_NUM_FIELDS; i++) {
+		if (names[i] == NULL) {
+			ERR(p, "%s", "Contexts must have a user, role, and type to evaluate constraints.");
+			errno = EINVAL;
+			return -1;
+		}
+		if (constraint_lookup(p, i, names[i], &c->fields[i]) < 0) {
+			return -1;
+		}
+		if (key != NULL) {
+			key[i] = c->fields[i];
+		}
+	}
+	if (!prog->mls) {
+		if (key != NULL) {
+			key[CONSTRAINT_NUM_FIELDS] = key[CONSTRAINT_NUM_FIELDS + 1] = 0;
+		}
+		return 0;
+	}
+	if ((range = apol_context_get_range(context)) == NULL || (levels[0] = apol_mls_range_get_low(range)) == NULL) {
+		ERR(p, "%s", "Contexts must have a range to evaluate MLS constraints.");
+		errno = EINVAL;
+		return -1;
+	}
+	if ((levels[1] = apol_mls_range_get_high(range)) == NULL) {
+		levels[1] = levels[0];
+	}
+	for (i = 0; i < 2; i++) {
+		if (constraint_resolve_level(p, prog, levels[i], &c->sens[i], c->cats[i]) < 0) {
+			return -1;
+		}
+		if (key != NULL && constraint_intern_level(p, prog, c->sens[i], c->cats[i], key + CONSTRAINT_NUM_FIELDS + i) < 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Determine if one level dominates another: its sensitivity is at
+ * least as high and its categories are a superset.
+ */
+static int constraint_level_dom(const apol_constraint_program_t * prog, const constraint_context_t * c1, int l1,
+				const constraint_context_t * c2, int l2)
+{
+	size_t i;
+	if (c1->sens[l1] < c2->sens[l2]) {
+		return 0;
+	}
+	for (i = 0; i < prog->cat_words; i++) {
+		if (c2->cats[l2][i] & ~c1->cats[l1][i]) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int constraint_role_dom(const apol_constraint_program_t * prog, uint32_t r1, uint32_t r2)
+{
+	if (r1 == 0 || r1 > prog->num_values[CONSTRAINT_ROLE]) {
+		return 0;
+	}
+	return constraint_get_bit(prog->role_dominates + (r1 - 1) * prog->role_words, prog->num_values[CONSTRAINT_ROLE], r2);
+}
+
+static int constraint_eval_attr(const apol_constraint_program_t * prog, const constraint_insn_t * insn)
+{
+	const constraint_context_t *c1 = prog->contexts + insn->slot1, *c2 = prog->contexts + insn->slot2;
+	int dom, domby;
+	if (insn->field < CONSTRAINT_NUM_FIELDS) {
+		uint32_t v1 = c1->fields[insn->field], v2 = c2->fields[insn->field];
+		if (insn->field == CONSTRAINT_ROLE && insn->op != QPOL_CEXPR_OP_EQ && insn->op != QPOL_CEXPR_OP_NEQ) {
+			dom = constraint_role_dom(prog, v1, v2);
+			domby = constraint_role_dom(prog, v2, v1);
+		} else {
+			return (insn->op == QPOL_CEXPR_OP_EQ ? v1 == v2 : v1 != v2);
+		}
+	} else {
+		dom = constraint_level_dom(prog, c1, insn->level1, c2, insn->level2);
+		domby = constraint_level_dom(prog, c2, insn->level2, c1, insn->level1);
+	}
+	switch (insn->op) {
+	case QPOL_CEXPR_OP_EQ:
+		return dom && domby;
+	case QPOL_CEXPR_OP_NEQ:
+		return !(dom && domby);
+	case QPOL_CEXPR_OP_DOM:
+		return dom;
+	case QPOL_CEXPR_OP_DOMBY:
+		return domby;
+	default:
+		return !dom && !domby;
+	}
+}
+
+/**
+ * Evaluate a compiled statement against the contexts currently
+ * resolved into the program's slots.
+ *
+ * @return Non-zero if the statement is satisfied, 0 if not.
+ */
+static int constraint_eval(const apol_constraint_program_t * prog, const constraint_prog_t * cp)
+{
+	unsigned char stack[CONSTRAINT_MAX_DEPTH];
+	size_t i, sp = 0;
+	for (i = 0; i < cp->num_insns; i++) {
+		const constraint_insn_t *insn = cp->insns + i;
+		switch (insn->expr_type) {
+		case QPOL_CEXPR_TYPE_NOT:
+			stack[sp - 1] = !stack[sp - 1];
+			break;
+		case QPOL_CEXPR_TYPE_AND:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] && stack[sp];
+			break;
+		case QPOL_CEXPR_TYPE_OR:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] || stack[sp];
+			break;
+		case QPOL_CEXPR_TYPE_ATTR:
+			stack[sp++] = constraint_eval_attr(prog, insn);
+			break;
+		default:
+			stack[sp++] = (constraint_get_bit(insn->names, prog->num_values[insn->field],
+							  prog->contexts[insn->slot1].fields[insn->field]) ==
+				       (insn->op == QPOL_CEXPR_OP_EQ));
+			break;
+		}
+	}
+	return stack[0];
+}
+
+/**
+ * Evaluate a class's constraints against the source and target
+ * contexts currently resolved into the program.
+ *
+ * @return Bitmask of the requested permissions that the constraints
+ * remove.
+ */
+static uint32_t constraint_denied_mask(const apol_constraint_program_t * prog, const constraint_class_t * cls,
+				       uint32_t requested)
+{
+	uint32_t denied = 0;
+	size_t i;
+	for (i = 0; i < cls->num_constraints; i++) {
+		const constraint_prog_t *cp = cls->constraints + i;
+		/* skip constraints that cannot remove anything more */
+		if ((cp->perms & requested & ~denied) && !constraint_eval(prog, cp)) {
+			denied |= cp->perms;
+		}
+	}
+	return denied & requested;
+}
+
+static const constraint_class_t *constraint_get_class(apol_policy_t * p, const char *obj_class)
+{
+	const qpol_class_t *datum;
+	uint32_t value;
+	if (apol_policy_build_constraint_program(p) < 0) {
+		return NULL;
+	}
+	if (obj_class == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return NULL;
+	}
+	if (qpol_policy_get_class_by_name(p->p, obj_class, &datum) < 0 || qpol_class_get_value(p->p, datum, &value) < 0) {
+		return NULL;
+	}
+	return p->constraint_program->classes + value - 1;
+}
+
+int apol_constraint_compute_denied(apol_policy_t * p, const apol_context_t * scontext, const apol_context_t * tcontext,
+				   const char *obj_class, const apol_vector_t * perms, apol_vector_t ** denied)
+{
+	const constraint_class_t *cls;
+	uint32_t requested, removed, value;
+	size_t i;
+	if (denied != NULL) {
+		*denied = NULL;
+	}
+	if (p == NULL || perms == NULL || denied == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	if ((cls = constraint_get_class(p, obj_class)) == NULL || constraint_resolve_perms(p, cls, perms, NULL, &requested) < 0 ||
+	    constraint_resolve_context(p, p->constraint_program, scontext, CONSTRAINT_SOURCE, NULL) < 0 ||
+	    constraint_resolve_context(p, p->constraint_program, tcontext, CONSTRAINT_TARGET, NULL) < 0) {
+		return -1;
+	}
+	removed = constraint_denied_mask(p->constraint_program, cls, requested);
+	if ((*denied = apol_vector_create(NULL)) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		return -1;
+	}
+	for (i = 0; i < apol_vector_get_size(perms); i++) {
+		char *perm = apol_vector_get_element(perms, i);
+		qpol_class_get_perm_value(p->p, cls->datum, perm, &value);
+		if ((removed & (1U << (value - 1))) && apol_vector_append(*denied, perm) < 0) {
+			int error = errno;
+			ERR(p, "%s", strerror(error));
+			apol_vector_destroy(denied);
+			errno = error;
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int apol_constraint_compute_denied_batch(apol_policy_t * p, const apol_context_t * const *scontexts,
+					 const apol_context_t * const *tcontexts, size_t num, const char *obj_class,
+					 const apol_vector_t * perms, uint32_t * denied)
+{
+	const constraint_class_t *cls;
+	apol_constraint_program_t *prog;
+	uint32_t bits[32], requested, removed;
+	size_t i, j, num_perms;
+	if (p == NULL || (num > 0 && (scontexts == NULL || tcontexts == NULL || denied == NULL)) || perms == NULL ||
+	    (num_perms = apol_vector_get_size(perms)) > 32) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	if ((cls = constraint_get_class(p, obj_class)) == NULL || constraint_resolve_perms(p, cls, perms, bits, &requested) < 0) {
+		return -1;
+	}
+	prog = p->constraint_program;
+	for (i = 0; i < num; i++) {
+		if ((i == 0 || scontexts[i] != scontexts[i - 1]) &&
+		    constraint_resolve_context(p, prog, scontexts[i], CONSTRAINT_SOURCE, NULL) < 0) {
+			return -1;
+		}
+		if ((i == 0 || tcontexts[i] != tcontexts[i - 1]) &&
+		    constraint_resolve_context(p, prog, tcontexts[i], CONSTRAINT_TARGET, NULL) < 0) {
+			return -1;
+		}
+		removed = constraint_denied_mask(prog, cls, requested);
+		denied[i] = 0;
+		for (j = 0; j < num_perms; j++) {
+			if (removed & bits[j]) {
+				denied[i] |= 1U << j;
+			}
+		}
+	}
+	return 0;
+}
+
+int apol_validatetrans_check(apol_policy_t * p, const apol_context_t * oldcontext, const apol_context_t * newcontext,
+			     const apol_context_t * taskcontext, const char *obj_class)
+{
+	const constraint_class_t *cls;
+	apol_constraint_program_t *prog;
+	size_t i;
+	if (p == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	if ((cls = constraint_get_class(p, obj_class)) == NULL) {
+		return -1;
+	}
+	prog = p->constraint_program;
+	if (constraint_resolve_context(p, prog, oldcontext, CONSTRAINT_SOURCE, NULL) < 0 ||
+	    constraint_resolve_context(p, prog, newcontext, CONSTRAINT_TARGET, NULL) < 0 ||
+	    constraint_resolve_context(p, prog, taskcontext, CONSTRAINT_EXTRA, NULL) < 0) {
+		return -1;
+	}
+	for (i = 0; i < cls->num_validatetrans; i++) {
+		if (!constraint_eval(prog, cls->validatetrans + i)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int constraint_program_resolve_context(apol_policy_t * p, const apol_context_t * context, int is_target, uint32_t * key)
+{
+	if (apol_policy_build_constraint_program(p) < 0) {
+		return -1;
+	}
+	return constraint_resolve_context(p, p->constraint_program, context, (is_target ? CONSTRAINT_TARGET : CONSTRAINT_SOURCE),
+					  key);
+}
+
+uint32_t constraint_program_denied(const apol_policy_t * p, uint32_t class_value, uint32_t requested)
+{
+	const apol_constraint_program_t *prog = p->constraint_program;
+	if (prog == NULL || class_value == 0 || class_value > prog->num_classes) {
+		return 0;
+	}
+	return constraint_denied_mask(prog, prog->classes + class_value - 1, requested);
+}
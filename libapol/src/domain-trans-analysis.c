@@ -25,8 +25,10 @@
 
 #include "policy-query-internal.h"
 #include "domain-trans-analysis-internal.h"
+#include "vector-internal.h"
 #include <apol/domain-trans-analysis.h>
 #include <apol/bst.h>
+#include <apol/hashset.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,8 +39,10 @@
 /* private data structure definitions */
 struct apol_domain_trans_table
 {
-	apol_bst_t *domain_table;
-	apol_bst_t *entrypoint_table;
+	apol_hashset_t *domain_table;
+	apol_hashset_t *entrypoint_table;
+	/** incremented each time the table's used flags are cleared */
+	unsigned int reset_seqno;
 };
 
 typedef struct dom_node
@@ -82,6 +86,23 @@ struct apol_domain_trans_analysis
 	apol_vector_t *access_classes;
 	apol_vector_t *access_perms;
 	regex_t *result_regex;
+	apol_budget_t *budget;
+	/* state of an analysis that ran out of budget, kept so that
+	 * apol_domain_trans_analysis_resume() can continue it */
+	const qpol_type_t *search_type;
+	/** every transition found so far, of type apol_domain_trans_result_t */
+	apol_vector_t *local_results;
+	/** index of the candidate type at which to continue */
+	size_t next_unit;
+	/** number of local results already validated */
+	size_t num_validated;
+	/** number of local results already filtered */
+	size_t num_collected;
+	apol_avrule_query_t *accessq;
+	/** table searched, and its reset_seqno, when the search was suspended */
+	const apol_domain_trans_table_t *table;
+	unsigned int table_seqno;
+	bool suspended;
 };
 
 struct apol_domain_trans_result
@@ -198,6 +219,12 @@ static int dom_node_cmp(const void *a, const void *b, void *data __attribute__ (
 	return 0;
 }
 
+static size_t dom_node_hash(const void *a, void *data __attribute__ ((unused)))
+{
+	const dom_node_t *an = a;
+	return apol_hashset_ptr_hash(an->type);
+}
+
 static void dom_node_free(void *x)
 {
 	if (!x)
@@ -254,6 +281,12 @@ static int ep_node_cmp(const void *a, const void *b, void *data __attribute__ ((
 	return 0;
 }
 
+static size_t ep_node_hash(const void *a, void *data __attribute__ ((unused)))
+{
+	const ep_node_t *an = a;
+	return apol_hashset_ptr_hash(an->type);
+}
+
 static void ep_node_free(void *x)
 {
 	if (!x)
@@ -313,12 +346,12 @@ static apol_domain_trans_table_t *apol_domain_trans_table_new(apol_policy_t * po
 		goto cleanup;
 	}
 
-	if (!(new_table->domain_table = apol_bst_create(dom_node_cmp, dom_node_free))) {
+	if (!(new_table->domain_table = apol_hashset_create(dom_node_hash, dom_node_cmp, dom_node_free))) {
 		ERR(policy, "%s", strerror(ENOMEM));
 		error = ENOMEM;
 		goto cleanup;
 	}
-	if (!(new_table->entrypoint_table = apol_bst_create(ep_node_cmp, ep_node_free))) {
+	if (!(new_table->entrypoint_table = apol_hashset_create(ep_node_hash, ep_node_cmp, ep_node_free))) {
 		ERR(policy, "%s", strerror(ENOMEM));
 		error = ENOMEM;
 		goto cleanup;
@@ -369,10 +402,10 @@ static int table_add_avrule(apol_policy_t * policy, apol_domain_trans_table_t *
 		for (size_t i = 0; i < apol_vector_get_size(sources); i++) {
 			dom_node_t *dnode = NULL;
 			dom_node_t dummy = { apol_vector_get_element(sources, i), NULL, NULL, NULL };
-			if (apol_bst_get_element(dta_table->domain_table, &dummy, NULL, (void **)&dnode)) {
+			if (apol_hashset_get_element(dta_table->domain_table, &dummy, NULL, (void **)&dnode)) {
 				dom_node_t *new_dnode = NULL;
 				if (!(new_dnode = dom_node_create(dummy.type)) ||
-				    apol_bst_insert(dta_table->domain_table, (void *)new_dnode, NULL)) {
+				    apol_hashset_insert(dta_table->domain_table, (void *)new_dnode, NULL)) {
 					error = errno;
 					dom_node_free(new_dnode);
 					goto err;
@@ -413,10 +446,10 @@ static int table_add_avrule(apol_policy_t * policy, apol_domain_trans_table_t *
 		for (size_t i = 0; i < apol_vector_get_size(targets); i++) {
 			ep_node_t *enode = NULL;
 			ep_node_t dummy = { apol_vector_get_element(targets, i), NULL, NULL };
-			if (apol_bst_get_element(dta_table->entrypoint_table, &dummy, NULL, (void **)&enode)) {
+			if (apol_hashset_get_element(dta_table->entrypoint_table, &dummy, NULL, (void **)&enode)) {
 				ep_node_t *new_enode = NULL;
 				if (!(new_enode = ep_node_create(dummy.type)) ||
-				    apol_bst_insert(dta_table->entrypoint_table, (void *)new_enode, NULL)) {
+				    apol_hashset_insert(dta_table->entrypoint_table, (void *)new_enode, NULL)) {
 					error = errno;
 					ep_node_free(new_enode);
 					goto err;
@@ -462,10 +495,10 @@ static int table_add_terule(apol_policy_t * policy, apol_domain_trans_table_t *
 	for (size_t i = 0; i < apol_vector_get_size(targets); i++) {
 		ep_node_t *enode = NULL;
 		ep_node_t dummy = { apol_vector_get_element(targets, i), NULL, NULL };
-		if (apol_bst_get_element(dta_table->entrypoint_table, &dummy, NULL, (void **)&enode)) {
+		if (apol_hashset_get_element(dta_table->entrypoint_table, &dummy, NULL, (void **)&enode)) {
 			ep_node_t *new_enode = NULL;
 			if (!(new_enode = ep_node_create(dummy.type)) ||
-			    apol_bst_insert(dta_table->entrypoint_table, (void *)new_enode, NULL)) {
+			    apol_hashset_insert(dta_table->entrypoint_table, (void *)new_enode, NULL)) {
 				error = errno;
 				ep_node_free(new_enode);
 				goto err;
@@ -524,6 +557,7 @@ int apol_policy_build_domain_trans_table(apol_policy_t * policy)
 	apol_terule_query_t *teq = NULL;
 	apol_vector_t *avrules = NULL;
 	apol_vector_t *terules = NULL;
+	size_t depth;
 
 	if (!policy) {
 		ERR(policy, "%s", strerror(EINVAL));
@@ -535,6 +569,7 @@ int apol_policy_build_domain_trans_table(apol_policy_t * policy)
 		return 0;	       /* already built */
 	}
 
+	depth = apol_stats_begin(policy, "domain transition table");
 	apol_domain_trans_table_t *dta_table = policy->domain_trans_table = apol_domain_trans_table_new(policy);
 	if (!policy->domain_trans_table) {
 		error = errno;
@@ -578,6 +613,7 @@ int apol_policy_build_domain_trans_table(apol_policy_t * policy)
 	}
 	apol_vector_destroy(&terules);
 
+	apol_stats_end(policy, depth);
 	return 0;
 
       err:
@@ -587,6 +623,7 @@ int apol_policy_build_domain_trans_table(apol_policy_t * policy)
 	apol_vector_destroy(&terules);
 	domain_trans_table_destroy(&dta_table);
 	policy->domain_trans_table = NULL;
+	apol_stats_end(policy, depth);
 	errno = error;
 	return -1;
 }
@@ -601,18 +638,55 @@ void domain_trans_table_destroy(apol_domain_trans_table_t ** table)
 	if (!table || !(*table))
 		return;
 
-	apol_bst_destroy(&(*table)->domain_table);
-	apol_bst_destroy(&(*table)->entrypoint_table);
+	apol_hashset_destroy(&(*table)->domain_table);
+	apol_hashset_destroy(&(*table)->entrypoint_table);
 	free(*table);
 	*table = NULL;
 }
 
+static void rule_tree_memory(const apol_bst_t * tree, size_t node_size, apol_memory_usage_t * usage)
+{
+	usage->bytes += bst_get_footprint(tree) + apol_bst_get_size(tree) * node_size;
+	usage->count += apol_bst_get_size(tree);
+}
+
+static int dom_node_memory(void *a, void *data)
+{
+	const dom_node_t *n = a;
+	apol_memory_usage_t *usage = data;
+	usage->bytes += sizeof(*n) + vector_get_footprint(n->setexec_rules);
+	usage->count += apol_vector_get_size(n->setexec_rules);
+	rule_tree_memory(n->process_transition_tree, sizeof(avrule_node_t), usage);
+	rule_tree_memory(n->entrypoint_tree, sizeof(avrule_node_t), usage);
+	return 0;
+}
+
+static int ep_node_memory(void *a, void *data)
+{
+	const ep_node_t *n = a;
+	apol_memory_usage_t *usage = data;
+	usage->bytes += sizeof(*n);
+	rule_tree_memory(n->execute_tree, sizeof(avrule_node_t), usage);
+	rule_tree_memory(n->type_transition_tree, sizeof(terule_node_t), usage);
+	return 0;
+}
+
+void domain_trans_table_get_memory_usage(const apol_domain_trans_table_t * table, apol_memory_usage_t * usage)
+{
+	if (!table)
+		return;
+	usage->bytes += sizeof(*table) + hashset_get_footprint(table->domain_table) + hashset_get_footprint(table->entrypoint_table);
+	apol_hashset_map(table->domain_table, dom_node_memory, usage);
+	apol_hashset_map(table->entrypoint_table, ep_node_memory, usage);
+}
+
 void apol_policy_reset_domain_trans_table(apol_policy_t * policy)
 {
 	if (!policy || !policy->domain_trans_table)
 		return;
-	apol_bst_inorder_map(policy->domain_trans_table->domain_table, dom_node_reset, NULL);
-	apol_bst_inorder_map(policy->domain_trans_table->entrypoint_table, ep_node_reset, NULL);
+	apol_hashset_map(policy->domain_trans_table->domain_table, dom_node_reset, NULL);
+	apol_hashset_map(policy->domain_trans_table->entrypoint_table, ep_node_reset, NULL);
+	policy->domain_trans_table->reset_seqno++;
 	return;
 }
 
@@ -653,6 +727,8 @@ void apol_domain_trans_analysis_destroy(apol_domain_trans_analysis_t ** dta)
 	apol_vector_destroy(&((*dta)->access_classes));
 	apol_vector_destroy(&((*dta)->access_perms));
 	apol_regex_destroy(&((*dta)->result_regex));
+	apol_vector_destroy(&((*dta)->local_results));
+	apol_avrule_query_destroy(&((*dta)->accessq));
 	free(*dta);
 	*dta = NULL;
 }
@@ -985,9 +1061,10 @@ static int domain_trans_table_find_orphan_type_transitions(apol_policy_t * polic
 	qpol_policy_get_type_by_name(apol_policy_get_qpol(policy), dta->start_type, &search);
 	apol_domain_trans_result_t *tmp_result = NULL;
 	//walk ep table
-	apol_vector_t *epnodes = apol_bst_get_vector(policy->domain_trans_table->entrypoint_table, 0);
+	apol_vector_t *epnodes = apol_hashset_get_vector(policy->domain_trans_table->entrypoint_table, 0);
 	if (!epnodes)
 		return -1;
+	apol_vector_sort(epnodes, ep_node_cmp, NULL);
 	for (size_t i = 0; i < apol_vector_get_size(epnodes); i++) {
 		ep_node_t *node = apol_vector_get_element(epnodes, i);
 		//find any unused type transitions
@@ -1031,7 +1108,7 @@ static int domain_trans_table_find_orphan_type_transitions(apol_policy_t * polic
 			//check for proc_trans and setexec
 			dom_node_t dummy = { tmp_result->start_type, NULL, NULL, NULL };
 			dom_node_t *start_node = NULL;
-			apol_bst_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL, (void **)&start_node);
+			apol_hashset_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL, (void **)&start_node);
 			if (start_node) {
 				//only copy setexec_rules if a new result will be added
 				if (add && apol_vector_get_size(start_node->setexec_rules)) {
@@ -1078,10 +1155,174 @@ static int domain_trans_table_find_orphan_type_transitions(apol_policy_t * polic
 	return -1;
 }
 
+static void domain_trans_analysis_reset(apol_domain_trans_analysis_t * dta)
+{
+	apol_vector_destroy(&dta->local_results);
+	apol_avrule_query_destroy(&dta->accessq);
+	dta->search_type = NULL;
+	dta->next_unit = dta->num_validated = dta->num_collected = 0;
+	dta->table = NULL;
+	dta->table_seqno = 0;
+	dta->suspended = false;
+}
+
+/**
+ *  Mark as valid every newly found transition that has all of the
+ *  rules it needs.
+ */
+static void domain_trans_analysis_validate(apol_policy_t * policy, apol_domain_trans_analysis_t * dta,
+					   apol_vector_t * local_results)
+{
+	for (size_t i = dta->num_validated; i < apol_vector_get_size(local_results); i++) {
+		apol_domain_trans_result_t *res = apol_vector_get_element(local_results, i);
+		if (res->start_type && res->ep_type && res->end_type && apol_vector_get_size(res->proc_trans_rules) &&
+		    apol_vector_get_size(res->ep_rules) && apol_vector_get_size(res->exec_rules) &&
+		    (requires_setexec_or_type_trans(policy)
+		     ? (apol_vector_get_size(res->setexec_rules) || apol_vector_get_size(res->type_trans_rules)) : true)) {
+			res->valid = true;
+		}
+	}
+	dta->num_validated = apol_vector_get_size(local_results);
+}
+
+/**
+ *  Apply the validity, result type, and access filters to a
+ *  transition.
+ *
+ *  @return 1 if the transition should be returned, 0 if not, < 0 on
+ *  error.
+ */
+static int domain_trans_analysis_filter(apol_policy_t * policy, apol_domain_trans_analysis_t * dta,
+					apol_domain_trans_result_t * res)
+{
+	const qpol_type_t *type = NULL;
+	const char *end_name = NULL;
+	int compval;
+
+	if (dta->valid != APOL_DOMAIN_TRANS_SEARCH_BOTH && res->valid != (dta->valid == APOL_DOMAIN_TRANS_SEARCH_VALID)) {
+		return 0;
+	}
+
+	if (dta->result) {
+		if (dta->direction == APOL_DOMAIN_TRANS_DIRECTION_REVERSE) {
+			type = res->start_type;
+		} else {
+			type = res->end_type;
+		}
+		compval = apol_compare_type(policy, type, dta->result, APOL_QUERY_REGEX, &dta->result_regex);
+		if (compval <= 0) {
+			return compval;
+		}
+	}
+
+	size_t num_atypes = apol_vector_get_size(dta->access_types);
+	size_t num_aclasses = apol_vector_get_size(dta->access_classes);
+	size_t num_aprems = apol_vector_get_size(dta->access_perms);
+	if (dta->direction != APOL_DOMAIN_TRANS_DIRECTION_FORWARD || !num_atypes || !num_aclasses || !num_aprems) {
+		return 1;
+	}
+	if (!dta->accessq) {
+		if (!(dta->accessq = apol_avrule_query_create()))
+			return -1;
+		apol_avrule_query_set_rules(policy, dta->accessq, QPOL_RULE_ALLOW);
+		for (size_t i = 0; i < num_aclasses; i++) {
+			if (apol_avrule_query_append_class
+			    (policy, dta->accessq, (char *)apol_vector_get_element(dta->access_classes, i))) {
+				return -1;
+			}
+		}
+		for (size_t i = 0; i < num_aprems; i++) {
+			if (apol_avrule_query_append_perm(policy, dta->accessq, (char *)apol_vector_get_element(dta->access_perms, i))) {
+				return -1;
+			}
+		}
+	}
+	if (qpol_type_get_name(apol_policy_get_qpol(policy), res->end_type, &end_name) ||
+	    apol_avrule_query_set_source(policy, dta->accessq, end_name, 1)) {
+		return -1;
+	}
+	apol_vector_t *tmp_access = apol_vector_create(NULL);
+	if (!tmp_access)
+		return -1;
+	for (size_t j = 0; j < num_atypes; j++) {
+		if (apol_avrule_query_set_target(policy, dta->accessq, (char *)apol_vector_get_element(dta->access_types, j), 1)) {
+			apol_vector_destroy(&tmp_access);
+			return -1;
+		}
+		apol_vector_t *cur_tgt_v = NULL;
+		apol_avrule_get_by_query(policy, dta->accessq, &cur_tgt_v);
+		apol_vector_cat(tmp_access, cur_tgt_v);
+		apol_vector_destroy(&cur_tgt_v);
+	}
+	if (apol_vector_get_size(tmp_access)) {
+		apol_vector_destroy(&res->access_rules);
+		res->access_rules = tmp_access;
+		return 1;
+	}
+	apol_vector_destroy(&tmp_access);
+	return 0;
+}
+
+/**
+ *  Append to the caller's vector copies of those newly found
+ *  transitions that pass the analysis's filters.
+ */
+static int domain_trans_analysis_collect(apol_policy_t * policy, apol_domain_trans_analysis_t * dta, apol_vector_t * out)
+{
+	for (; dta->num_collected < apol_vector_get_size(dta->local_results); dta->num_collected++) {
+		apol_domain_trans_result_t *res = apol_vector_get_element(dta->local_results, dta->num_collected);
+		int keep = domain_trans_analysis_filter(policy, dta, res);
+		if (keep < 0) {
+			return -1;
+		} else if (keep == 0) {
+			continue;
+		}
+		apol_domain_trans_result_t *copy = apol_domain_trans_result_create_from_domain_trans_result(res);
+		if (!copy || apol_vector_append(out, (void *)copy)) {
+			int error = errno;
+			domain_trans_result_free(copy);
+			errno = error;
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ *  Check the analysis's budget before examining a candidate type.  If
+ *  the budget has run out then the results found so far are returned
+ *  to the caller and the candidate is remembered, so that the
+ *  analysis may be resumed from it.
+ *
+ *  When searching for invalid transitions the results are held back
+ *  instead, because the final pass for orphan type_transition rules
+ *  may still add rules to any of them; they are all returned by the
+ *  slice that completes the search.
+ *
+ *  @return 0 to continue, 1 if the budget has run out, < 0 on error.
+ */
+static int domain_trans_analysis_check_budget(apol_policy_t * policy, apol_domain_trans_analysis_t * dta, apol_vector_t * out,
+					      size_t unit)
+{
+	if (!dta->budget)
+		return 0;
+	if (unit > dta->next_unit) {
+		domain_trans_analysis_validate(policy, dta, dta->local_results);
+		if (!(dta->valid & APOL_DOMAIN_TRANS_SEARCH_INVALID) && domain_trans_analysis_collect(policy, dta, out))
+			return -1;
+		if (apol_budget_is_spent(dta->budget, apol_vector_get_size(out))) {
+			dta->next_unit = unit;
+			return 1;
+		}
+	}
+	apol_budget_add_nodes(dta->budget, 1);
+	return 0;
+}
+
 static int domain_trans_table_get_all_forward_trans(apol_policy_t * policy, apol_domain_trans_analysis_t * dta,
-						    apol_vector_t * local_results, const qpol_type_t * start_type)
+						    apol_vector_t * local_results, const qpol_type_t * start_type, apol_vector_t * out)
 {
-	int error = 0;
+	int error = 0, suspended = 0;
 	//create template result this will hold common data for each step and be copied as needed
 	apol_domain_trans_result_t *tmpl_result = domain_trans_result_create();
 	if (!tmpl_result) {
@@ -1091,7 +1332,7 @@ static int domain_trans_table_get_all_forward_trans(apol_policy_t * policy, apol
 	//find start node
 	dom_node_t dummy = { start_type, NULL, NULL, NULL };
 	dom_node_t *start_node = NULL;
-	apol_bst_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL, (void **)&start_node);
+	apol_hashset_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL, (void **)&start_node);
 	if (start_node) {
 		tmpl_result->start_type = start_type;
 		//if needed and present record setexec
@@ -1110,11 +1351,20 @@ static int domain_trans_table_get_all_forward_trans(apol_policy_t * policy, apol
 		}
 		apol_vector_destroy(&proc_trans_rules);
 		apol_vector_sort_uniquify(potential_end_types, NULL, NULL);
+		apol_stats_add(policy, QPOL_STATS_NODES_EXPANDED, apol_vector_get_size(potential_end_types));
 		//for each end check ep
-		for (size_t i = 0; i < apol_vector_get_size(potential_end_types); i++) {
+		for (size_t i = dta->next_unit; i < apol_vector_get_size(potential_end_types); i++) {
+			if ((suspended = domain_trans_analysis_check_budget(policy, dta, out, i)) != 0) {
+				if (suspended < 0) {
+					error = errno;
+					apol_vector_destroy(&potential_end_types);
+					goto err;
+				}
+				break;
+			}
 			dummy.type = tmpl_result->end_type = apol_vector_get_element(potential_end_types, i);
 			dom_node_t *end_node = NULL;
-			apol_bst_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL, (void **)&end_node);
+			apol_hashset_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL, (void **)&end_node);
 			const qpol_type_t *end_type = dummy.type;
 			if (end_type == start_type)
 				continue;
@@ -1157,13 +1407,14 @@ static int domain_trans_table_get_all_forward_trans(apol_policy_t * policy, apol
 				}
 				apol_vector_destroy(&eprules);
 				apol_vector_sort_uniquify(potential_ep_types, NULL, NULL);
+				apol_stats_add(policy, QPOL_STATS_NODES_EXPANDED, apol_vector_get_size(potential_ep_types));
 				//for each ep find exec by start
 				for (size_t j = 0; j < apol_vector_get_size(potential_ep_types); j++) {
 					tmpl_result->ep_type = apol_vector_get_element(potential_ep_types, j);
 					ep_node_t edummy =
 						{ (const qpol_type_t *)apol_vector_get_element(potential_ep_types, j), NULL, NULL };
 					ep_node_t *epnode = NULL;
-					apol_bst_get_element(policy->domain_trans_table->entrypoint_table, (void *)&edummy, NULL,
+					apol_hashset_get_element(policy->domain_trans_table->entrypoint_table, (void *)&edummy, NULL,
 							     (void **)&epnode);
 					//get all entrypoint rules for ths end (may be multiple due to attributes)
 					apol_vector_destroy(&tmpl_result->ep_rules);
@@ -1316,19 +1567,10 @@ static int domain_trans_table_get_all_forward_trans(apol_policy_t * policy, apol
 			}
 		}
 		apol_vector_destroy(&potential_end_types);
-		//validate all
-		for (size_t i = 0; i < apol_vector_get_size(local_results); i++) {
-			apol_domain_trans_result_t *res = apol_vector_get_element(local_results, i);
-			if (res->start_type && res->ep_type && res->end_type && apol_vector_get_size(res->proc_trans_rules) &&
-			    apol_vector_get_size(res->ep_rules) && apol_vector_get_size(res->exec_rules) &&
-			    (requires_setexec_or_type_trans(policy)
-			     ? (apol_vector_get_size(res->setexec_rules) || apol_vector_get_size(res->type_trans_rules)) : true)) {
-				res->valid = true;
-			}
-		}
 	}
-	//iff looking for invalid find orphan type_transition rules
-	if (dta->valid & APOL_DOMAIN_TRANS_SEARCH_INVALID) {
+	domain_trans_analysis_validate(policy, dta, local_results);
+	//iff looking for invalid find orphan type_transition rules, once all else is found
+	if (!suspended && (dta->valid & APOL_DOMAIN_TRANS_SEARCH_INVALID)) {
 		if (domain_trans_table_find_orphan_type_transitions(policy, dta, local_results)) {
 			error = errno;
 			goto err;
@@ -1336,7 +1578,7 @@ static int domain_trans_table_get_all_forward_trans(apol_policy_t * policy, apol
 	}
 	apol_domain_trans_result_destroy(&tmpl_result);
 
-	return 0;
+	return suspended;
       err:
 	apol_domain_trans_result_destroy(&tmpl_result);
 	errno = error;
@@ -1344,9 +1586,9 @@ static int domain_trans_table_get_all_forward_trans(apol_policy_t * policy, apol
 }
 
 static int domain_trans_table_get_all_reverse_trans(apol_policy_t * policy, apol_domain_trans_analysis_t * dta,
-						    apol_vector_t * local_results, const qpol_type_t * end_type)
+						    apol_vector_t * local_results, const qpol_type_t * end_type, apol_vector_t * out)
 {
-	int error = 0;
+	int error = 0, suspended = 0;
 	//create template result this will hold common data for each step and be copied as needed
 	apol_domain_trans_result_t *tmpl_result = domain_trans_result_create();
 	if (!tmpl_result) {
@@ -1356,7 +1598,7 @@ static int domain_trans_table_get_all_reverse_trans(apol_policy_t * policy, apol
 	//find end node
 	dom_node_t dummy = { end_type, NULL, NULL, NULL };
 	dom_node_t *end_node = NULL;
-	apol_bst_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL, (void **)&end_node);
+	apol_hashset_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL, (void **)&end_node);
 	if (end_node) {
 		tmpl_result->end_type = end_type;
 		//collect potential entrypoint types
@@ -1378,7 +1620,16 @@ static int domain_trans_table_get_all_reverse_trans(apol_policy_t * policy, apol
 		}
 		apol_vector_destroy(&eprules);
 		apol_vector_sort_uniquify(potential_ep_types, NULL, NULL);
-		for (size_t i = 0; i < apol_vector_get_size(potential_ep_types); i++) {
+		apol_stats_add(policy, QPOL_STATS_NODES_EXPANDED, apol_vector_get_size(potential_ep_types));
+		for (size_t i = dta->next_unit; i < apol_vector_get_size(potential_ep_types); i++) {
+			if ((suspended = domain_trans_analysis_check_budget(policy, dta, out, i)) != 0) {
+				if (suspended < 0) {
+					error = errno;
+					apol_vector_destroy(&potential_ep_types);
+					goto err;
+				}
+				break;
+			}
 			tmpl_result->ep_type = apol_vector_get_element(potential_ep_types, i);
 			//get all ep rules for this end (may be multiple due to attributes)
 			eprules = find_avrules_in_node((void *)end_node, APOL_DOMAIN_TRANS_RULE_ENTRYPOINT, tmpl_result->ep_type);
@@ -1398,7 +1649,7 @@ static int domain_trans_table_get_all_reverse_trans(apol_policy_t * policy, apol
 			apol_vector_sort_uniquify(tmpl_result->ep_rules, NULL, NULL);
 			ep_node_t edummy = { tmpl_result->ep_type, NULL, NULL };
 			ep_node_t *epnode = NULL;
-			apol_bst_get_element(policy->domain_trans_table->entrypoint_table, (void *)&edummy, NULL, (void **)&epnode);
+			apol_hashset_get_element(policy->domain_trans_table->entrypoint_table, (void *)&edummy, NULL, (void **)&epnode);
 			//for each ep find exec rules to generate list of potential start types
 			if (epnode) {
 				apol_vector_t *execrules = apol_bst_get_vector(epnode->execute_tree, 0);
@@ -1420,6 +1671,7 @@ static int domain_trans_table_get_all_reverse_trans(apol_policy_t * policy, apol
 				}
 				apol_vector_destroy(&execrules);
 				apol_vector_sort_uniquify(potential_start_types, NULL, NULL);
+				apol_stats_add(policy, QPOL_STATS_NODES_EXPANDED, apol_vector_get_size(potential_start_types));
 				for (size_t k = 0; k < apol_vector_get_size(potential_start_types); k++) {
 					tmpl_result->start_type = apol_vector_get_element(potential_start_types, k);
 					//no transition to self
@@ -1471,7 +1723,7 @@ static int domain_trans_table_get_all_reverse_trans(apol_policy_t * policy, apol
 					apol_vector_sort_uniquify(tmpl_result->type_trans_rules, NULL, NULL);
 					dummy.type = tmpl_result->start_type;
 					dom_node_t *start_node = NULL;
-					apol_bst_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL,
+					apol_hashset_get_element(policy->domain_trans_table->domain_table, (void *)&dummy, NULL,
 							     (void **)&start_node);
 					if (start_node) {
 						//for each start check setexec if needed
@@ -1595,20 +1847,10 @@ static int domain_trans_table_get_all_reverse_trans(apol_policy_t * policy, apol
 			}
 		}
 		apol_vector_destroy(&potential_ep_types);
-
-		//validate all
-		for (size_t i = 0; i < apol_vector_get_size(local_results); i++) {
-			apol_domain_trans_result_t *res = apol_vector_get_element(local_results, i);
-			if (res->start_type && res->ep_type && res->end_type && apol_vector_get_size(res->proc_trans_rules) &&
-			    apol_vector_get_size(res->ep_rules) && apol_vector_get_size(res->exec_rules) &&
-			    (requires_setexec_or_type_trans(policy)
-			     ? (apol_vector_get_size(res->setexec_rules) || apol_vector_get_size(res->type_trans_rules)) : true)) {
-				res->valid = true;
-			}
-		}
 	}
-	//iff looking for invalid find orphan type_transition rules
-	if (dta->valid & APOL_DOMAIN_TRANS_SEARCH_INVALID) {
+	domain_trans_analysis_validate(policy, dta, local_results);
+	//iff looking for invalid find orphan type_transition rules, once all else is found
+	if (!suspended && (dta->valid & APOL_DOMAIN_TRANS_SEARCH_INVALID)) {
 		if (domain_trans_table_find_orphan_type_transitions(policy, dta, local_results)) {
 			error = errno;
 			goto err;
@@ -1616,7 +1858,7 @@ static int domain_trans_table_get_all_reverse_trans(apol_policy_t * policy, apol
 	}
 
 	apol_domain_trans_result_destroy(&tmpl_result);
-	return 0;
+	return suspended;
 
       err:
 	apol_domain_trans_result_destroy(&tmpl_result);
@@ -1624,11 +1866,43 @@ static int domain_trans_table_get_all_reverse_trans(apol_policy_t * policy, apol
 	return -1;
 }
 
+/**
+ *  Run, or continue, the analysis's search within its budget, and
+ *  append the transitions found to out.
+ *
+ *  @return 0 if the search is complete, 1 if the budget ran out
+ *  first, < 0 on error.
+ */
+static int domain_trans_analysis_run(apol_policy_t * policy, apol_domain_trans_analysis_t * dta, apol_vector_t * out)
+{
+	int retval;
+	apol_budget_begin(dta->budget, apol_vector_get_size(out));
+	/* get all transitions for the requested direction */
+	if (dta->direction == APOL_DOMAIN_TRANS_DIRECTION_REVERSE) {
+		retval = domain_trans_table_get_all_reverse_trans(policy, dta, dta->local_results, dta->search_type, out);
+	} else {
+		retval = domain_trans_table_get_all_forward_trans(policy, dta, dta->local_results, dta->search_type, out);
+	}
+	if (retval < 0) {
+		return -1;
+	}
+	if (retval == 0) {
+		if (domain_trans_analysis_collect(policy, dta, out))
+			return -1;
+		domain_trans_analysis_reset(dta);
+	} else {
+		if (!(dta->valid & APOL_DOMAIN_TRANS_SEARCH_INVALID) && domain_trans_analysis_collect(policy, dta, out))
+			return -1;
+		dta->table = policy->domain_trans_table;
+		dta->table_seqno = policy->domain_trans_table->reset_seqno;
+		dta->suspended = true;
+	}
+	return retval;
+}
+
 int apol_domain_trans_analysis_do(apol_policy_t * policy, apol_domain_trans_analysis_t * dta, apol_vector_t ** results)
 {
-	apol_vector_t *local_results = NULL;
-	apol_avrule_query_t *accessq = NULL;
-	int error = 0;
+	int error = 0, retval;
 	if (!results)
 		*results = NULL;
 	if (!policy || !dta || !results) {
@@ -1637,10 +1911,14 @@ int apol_domain_trans_analysis_do(apol_policy_t * policy, apol_domain_trans_anal
 		return -1;
 	}
 
+	size_t depth = apol_stats_begin(policy, "domain transition analysis");
+
 	/* build table if not already present */
 	if (!(policy->domain_trans_table)) {
-		if (apol_policy_build_domain_trans_table(policy))
+		if (apol_policy_build_domain_trans_table(policy)) {
+			apol_stats_end(policy, depth);
 			return -1;     /* errors already reported by build function */
+		}
 	}
 
 	/* validate analysis options */
@@ -1675,133 +1953,78 @@ int apol_domain_trans_analysis_do(apol_policy_t * policy, apol_domain_trans_anal
 		goto err;
 	}
 
-	local_results = apol_vector_create(domain_trans_result_free);
-	/* get all transitions for the requested direction */
-	if (dta->direction == APOL_DOMAIN_TRANS_DIRECTION_REVERSE) {
-		if (domain_trans_table_get_all_reverse_trans(policy, dta, local_results, start_type)) {
-			error = errno;
-			goto err;
-		}
-	} else {
-		if (domain_trans_table_get_all_forward_trans(policy, dta, local_results, start_type)) {
-			error = errno;
-			goto err;
-		}
-	}
-
-	/* if requested, filter by validity */
-	if (dta->valid != APOL_DOMAIN_TRANS_SEARCH_BOTH) {
-		for (size_t i = 0; i < apol_vector_get_size(local_results); /* increment later */ ) {
-			apol_domain_trans_result_t *res = apol_vector_get_element(local_results, i);
-			if (res->valid != (dta->valid == APOL_DOMAIN_TRANS_SEARCH_VALID)) {
-				apol_vector_remove(local_results, i);
-				domain_trans_result_free(res);
-			} else {
-				i++;
-			}
-		}
-	}
-
-	/* if filtering by result type, do that now */
-	if (dta->result) {
-		for (size_t i = 0; i < apol_vector_get_size(local_results); /* increment later */ ) {
-			apol_domain_trans_result_t *res = apol_vector_get_element(local_results, i);
-			const qpol_type_t *type = NULL;
-			if (dta->direction == APOL_DOMAIN_TRANS_DIRECTION_REVERSE) {
-				type = res->start_type;
-			} else {
-				type = res->end_type;
-			}
-			int compval = apol_compare_type(policy, type, dta->result, APOL_QUERY_REGEX, &dta->result_regex);
-			if (compval < 0) {
-				error = errno;
-				goto err;
-			} else if (compval > 0) {
-				i++;
-			} else {
-				apol_vector_remove(local_results, i);
-				domain_trans_result_free(res);
-			}
-		}
-	}
-
-	/* finally do access filtering */
-	if (dta->direction == APOL_DOMAIN_TRANS_DIRECTION_FORWARD && num_atypes && num_aclasses && num_aprems) {
-		accessq = apol_avrule_query_create();
-		apol_avrule_query_set_rules(policy, accessq, QPOL_RULE_ALLOW);
-		for (size_t i = 0; i < num_aclasses; i++) {
-			if (apol_avrule_query_append_class
-			    (policy, accessq, (char *)apol_vector_get_element(dta->access_classes, i))) {
-				error = errno;
-				goto err;
-			}
-		}
-		for (size_t i = 0; i < num_aprems; i++) {
-			if (apol_avrule_query_append_perm(policy, accessq, (char *)apol_vector_get_element(dta->access_perms, i))) {
-				error = errno;
-				goto err;
-			}
-		}
-		for (size_t i = 0; i < apol_vector_get_size(local_results); /* increment later */ ) {
-			const char *end_name = NULL;
-			apol_domain_trans_result_t *res = apol_vector_get_element(local_results, i);
-			if (qpol_type_get_name(apol_policy_get_qpol(policy), res->end_type, &end_name) ||
-			    apol_avrule_query_set_source(policy, accessq, end_name, 1)) {
-				error = errno;
-				goto err;
-			}
-			apol_vector_t *tmp_access = apol_vector_create(NULL);
-			for (size_t j = 0; j < num_atypes; j++) {
-				if (apol_avrule_query_set_target
-				    (policy, accessq, (char *)apol_vector_get_element(dta->access_types, j), 1)) {
-					error = errno;
-					apol_vector_destroy(&tmp_access);
-					goto err;
-				}
-				apol_vector_t *cur_tgt_v = NULL;
-				apol_avrule_get_by_query(policy, accessq, &cur_tgt_v);
-				apol_vector_cat(tmp_access, cur_tgt_v);
-				apol_vector_destroy(&cur_tgt_v);
-			}
-			if (apol_vector_get_size(tmp_access)) {
-				res->access_rules = tmp_access;
-				tmp_access = NULL;
-				i++;
-			} else {
-				apol_vector_remove(local_results, i);
-				domain_trans_result_free(res);
-			}
-			apol_vector_destroy(&tmp_access);
-		}
-		apol_avrule_query_destroy(&accessq);
-	}
-
-	*results = apol_vector_create(domain_trans_result_free);
-	if (!(*results)) {
+	domain_trans_analysis_reset(dta);
+	if (!(dta->local_results = apol_vector_create(domain_trans_result_free)) ||
+	    !(*results = apol_vector_create(domain_trans_result_free))) {
 		error = errno;
 		goto err;
 	}
-	for (size_t i = 0; i < apol_vector_get_size(local_results); i++) {
-		apol_domain_trans_result_t *res =
-			apol_domain_trans_result_create_from_domain_trans_result((apol_domain_trans_result_t *)
-										 apol_vector_get_element(local_results, i));
-		if (!res || apol_vector_append(*results, (void *)res)) {
-			error = errno;
-			domain_trans_result_free(res);
-			goto err;
-		}
+	dta->search_type = start_type;
+	if ((retval = domain_trans_analysis_run(policy, dta, *results)) < 0) {
+		error = errno;
+		goto err;
 	}
-	apol_vector_destroy(&local_results);
 
-	return 0;
+	apol_stats_add(policy, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*results));
+	apol_stats_end(policy, depth);
+	return retval;
       err:
-	apol_vector_destroy(&local_results);
+	domain_trans_analysis_reset(dta);
 	apol_vector_destroy(results);
-	apol_avrule_query_destroy(&accessq);
+	apol_stats_end(policy, depth);
 	errno = error;
 	return -1;
 }
 
+int apol_domain_trans_analysis_resume(apol_policy_t * policy, apol_domain_trans_analysis_t * dta, apol_vector_t ** results)
+{
+	int retval;
+	if (!policy || !dta || !results) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	if (*results == NULL && (*results = apol_vector_create(domain_trans_result_free)) == NULL) {
+		ERR(policy, "%s", strerror(errno));
+		return -1;
+	}
+	if (!dta->suspended) {
+		/* nothing left to do */
+		return 0;
+	}
+	if (dta->table != policy->domain_trans_table || dta->table_seqno != policy->domain_trans_table->reset_seqno) {
+		/* the used flags that the search depends upon have been lost */
+		domain_trans_analysis_reset(dta);
+		ERR(policy, "%s", "The domain transition table was reset; the analysis must be restarted.");
+		errno = ESTALE;
+		return -1;
+	}
+
+	size_t depth = apol_stats_begin(policy, "domain transition analysis");
+	size_t old_size = apol_vector_get_size(*results);
+	if ((retval = domain_trans_analysis_run(policy, dta, *results)) < 0) {
+		int error = errno;
+		domain_trans_analysis_reset(dta);
+		apol_stats_end(policy, depth);
+		errno = error;
+		return -1;
+	}
+	apol_stats_add(policy, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*results) - old_size);
+	apol_stats_end(policy, depth);
+	return retval;
+}
+
+int apol_domain_trans_analysis_set_budget(const apol_policy_t * policy, apol_domain_trans_analysis_t * dta, apol_budget_t * budget)
+{
+	if (!dta) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	dta->budget = budget;
+	return 0;
+}
+
 /* result */
 
 const qpol_type_t *apol_domain_trans_result_get_start_type(const apol_domain_trans_result_t * dtr)
@@ -1919,15 +2142,15 @@ int apol_domain_trans_table_verify_trans(apol_policy_t * policy, const qpol_type
 	dom_node_t start_dummy = { start_dom, NULL, NULL, NULL };
 	dom_node_t *start_node = NULL;
 	if (start_dom)
-		apol_bst_get_element(policy->domain_trans_table->domain_table, (void *)&start_dummy, NULL, (void **)&start_node);
+		apol_hashset_get_element(policy->domain_trans_table->domain_table, (void *)&start_dummy, NULL, (void **)&start_node);
 	ep_node_t ep_dummy = { ep_type, NULL, NULL };
 	ep_node_t *ep_node = NULL;
 	if (ep_type)
-		apol_bst_get_element(policy->domain_trans_table->entrypoint_table, (void *)&ep_dummy, NULL, (void **)&ep_node);
+		apol_hashset_get_element(policy->domain_trans_table->entrypoint_table, (void *)&ep_dummy, NULL, (void **)&ep_node);
 	dom_node_t end_dummy = { end_dom, NULL, NULL, NULL };
 	dom_node_t *end_node = NULL;
 	if (end_dom)
-		apol_bst_get_element(policy->domain_trans_table->domain_table, (void *)&end_dummy, NULL, (void **)&end_node);
+		apol_hashset_get_element(policy->domain_trans_table->domain_table, (void *)&end_dummy, NULL, (void **)&end_node);
 
 	bool tt = false, sx = false, ex = false, pt = false, ep = false;
 
@@ -0,0 +1,308 @@
+/**
+ *  @file
+ *  Implementation of an unordered hash set, using open addressing
+ *  with linear probing.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <apol/hashset.h>
+#include <apol/vector.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "vector-internal.h"
+
+/** initial number of slots; must be a power of 2 */
+#define HASHSET_INITIAL_CAPACITY 16
+
+/**
+ *  Generic hash set structure.  Stores elements as void*.  Because
+ *  elements may not be NULL, an empty slot is one whose element is
+ *  NULL.  There is no removal, so no tombstones are needed.
+ */
+struct apol_hashset
+{
+	/** Hash function for elements, or NULL to hash addresses. */
+	apol_hashset_hash_func *hash;
+	/** Equality function for elements, or NULL to compare addresses. */
+	apol_hashset_comp_func *cmp;
+	/** Destroy function for the elements, or NULL to not free each element. */
+	apol_hashset_free_func *fr;
+	/** The number of elements currently stored in the set. */
+	size_t size;
+	/** The number of slots allocated; always a power of 2. */
+	size_t capacity;
+	/** Array of slots. */
+	void **elems;
+	/** Hash value of each occupied slot, so that growing the set
+	 *  need not recompute them. */
+	size_t *hashes;
+};
+
+size_t apol_hashset_ptr_hash(const void *ptr)
+{
+	/* mix the bits so that aligned addresses do not collide in
+	 * the low order bits */
+	uint64_t x = (uint64_t) (uintptr_t) ptr;
+	x ^= x >> 33;
+	x *= UINT64_C(0xff51afd7ed558ccd);
+	x ^= x >> 33;
+	return (size_t)x;
+}
+
+static size_t hashset_hash(const apol_hashset_t * h, const void *elem, void *data)
+{
+	if (h->hash != NULL) {
+		return h->hash(elem, data);
+	}
+	return apol_hashset_ptr_hash(elem);
+}
+
+/**
+ * Find the slot holding an element equal to elem, or the empty slot
+ * where it would be inserted.
+ *
+ * @param h Hash set to search.  Must have at least one empty slot.
+ * @param elem Element to find.
+ * @param hash Hash value of elem.
+ * @param data Arbitrary data to pass to the comparison function.
+ *
+ * @return Index of the matching or empty slot.
+ */
+static size_t hashset_find_slot(const apol_hashset_t * h, const void *elem, size_t hash, void *data)
+{
+	size_t mask = h->capacity - 1;
+	size_t i = hash & mask;
+	while (h->elems[i] != NULL) {
+		if (h->hashes[i] == hash) {
+			if (h->cmp == NULL) {
+				if (h->elems[i] == elem) {
+					break;
+				}
+			} else if (h->cmp(h->elems[i], elem, data) == 0) {
+				break;
+			}
+		}
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+/**
+ * Double the number of slots in a hash set, moving every element to
+ * its new slot.
+ *
+ * @param h Hash set to grow.
+ *
+ * @return 0 on success, < 0 on error (in which case h is unchanged).
+ */
+static int hashset_grow(apol_hashset_t * h)
+{
+	size_t new_capacity = (h->capacity == 0 ? HASHSET_INITIAL_CAPACITY : h->capacity * 2);
+	size_t mask = new_capacity - 1, i, j;
+	void **new_elems;
+	size_t *new_hashes;
+
+	if ((new_elems = calloc(new_capacity, sizeof(*new_elems))) == NULL) {
+		return -1;
+	}
+	if ((new_hashes = malloc(new_capacity * sizeof(*new_hashes))) == NULL) {
+		free(new_elems);
+		return -1;
+	}
+	for (i = 0; i < h->capacity; i++) {
+		if (h->elems[i] == NULL) {
+			continue;
+		}
+		j = h->hashes[i] & mask;
+		while (new_elems[j] != NULL) {
+			j = (j + 1) & mask;
+		}
+		new_elems[j] = h->elems[i];
+		new_hashes[j] = h->hashes[i];
+	}
+	free(h->elems);
+	free(h->hashes);
+	h->elems = new_elems;
+	h->hashes = new_hashes;
+	h->capacity = new_capacity;
+	return 0;
+}
+
+apol_hashset_t *apol_hashset_create(apol_hashset_hash_func * hash, apol_hashset_comp_func * cmp, apol_hashset_free_func * fr)
+{
+	apol_hashset_t *h = NULL;
+	if ((h = calloc(1, sizeof(*h))) == NULL) {
+		return NULL;
+	}
+	h->hash = hash;
+	h->cmp = cmp;
+	h->fr = fr;
+	if (hashset_grow(h) < 0) {
+		free(h);
+		return NULL;
+	}
+	return h;
+}
+
+void apol_hashset_destroy(apol_hashset_t ** h)
+{
+	size_t i;
+	if (!h || !(*h))
+		return;
+	if ((*h)->fr != NULL) {
+		for (i = 0; i < (*h)->capacity; i++) {
+			if ((*h)->elems[i] != NULL) {
+				(*h)->fr((*h)->elems[i]);
+			}
+		}
+	}
+	free((*h)->elems);
+	free((*h)->hashes);
+	free(*h);
+	*h = NULL;
+}
+
+apol_vector_t *apol_hashset_get_vector(apol_hashset_t * h, int change_owner)
+{
+	apol_vector_t *v = NULL;
+	size_t i;
+	if (!h) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((v = apol_vector_create_with_capacity(h->size, NULL)) == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < h->capacity; i++) {
+		if (h->elems[i] != NULL && apol_vector_append(v, h->elems[i]) < 0) {
+			int error = errno;
+			apol_vector_destroy(&v);
+			errno = error;
+			return NULL;
+		}
+	}
+	if (change_owner) {
+		vector_set_free_func(v, h->fr);
+		h->fr = NULL;
+	}
+	return v;
+}
+
+size_t apol_hashset_get_size(const apol_hashset_t * h)
+{
+	if (!h) {
+		errno = EINVAL;
+		return 0;
+	} else {
+		return h->size;
+	}
+}
+
+int apol_hashset_get_element(const apol_hashset_t * h, const void *elem, void *data, void **result)
+{
+	size_t i;
+	if (!h || !result) {
+		errno = EINVAL;
+		return -1;
+	}
+	i = hashset_find_slot(h, elem, hashset_hash(h, elem, data), data);
+	if (h->elems[i] == NULL) {
+		return -1;
+	}
+	*result = h->elems[i];
+	return 0;
+}
+
+/**
+ * Insert an element into a hash set, or find the existing equal
+ * element.
+ *
+ * @param h Hash set to modify.
+ * @param elem Reference to the element to add.  If an equal element
+ * already exists then set the reference to that element.
+ * @param data Arbitrary data to pass to the hash and comparison
+ * functions.
+ * @param fr If non-NULL and an equal element already exists, call
+ * this upon the passed in element.
+ *
+ * @return 0 if inserted, 1 if it already existed, < 0 on error.
+ */
+static int hashset_insert(apol_hashset_t * h, void **elem, void *data, apol_hashset_free_func * fr)
+{
+	size_t hash, i;
+	hash = hashset_hash(h, *elem, data);
+	i = hashset_find_slot(h, *elem, hash, data);
+	if (h->elems[i] != NULL) {
+		if (fr != NULL) {
+			fr(*elem);
+		}
+		*elem = h->elems[i];
+		return 1;
+	}
+	/* keep the load factor at or below 3/4 */
+	if ((h->size + 1) * 4 > h->capacity * 3) {
+		if (hashset_grow(h) < 0) {
+			return -1;
+		}
+		i = hashset_find_slot(h, *elem, hash, data);
+	}
+	h->elems[i] = *elem;
+	h->hashes[i] = hash;
+	h->size++;
+	return 0;
+}
+
+int apol_hashset_insert(apol_hashset_t * h, void *elem, void *data)
+{
+	if (!h || !elem) {
+		errno = EINVAL;
+		return -1;
+	}
+	return hashset_insert(h, &elem, data, NULL);
+}
+
+int apol_hashset_insert_and_get(apol_hashset_t * h, void **elem, void *data)
+{
+	if (!h || !elem || !(*elem)) {
+		errno = EINVAL;
+		return -1;
+	}
+	return hashset_insert(h, elem, data, h->fr);
+}
+
+int apol_hashset_map(const apol_hashset_t * h, int (*fn) (void *, void *), void *data)
+{
+	size_t i;
+	int retval = 0;
+	if (h == NULL || fn == NULL)
+		return -1;
+	for (i = 0; i < h->capacity; i++) {
+		if (h->elems[i] != NULL && (retval = fn(h->elems[i], data)) < 0) {
+			return retval;
+		}
+	}
+	return retval;
+}
+
+size_t hashset_get_footprint(const apol_hashset_t * h)
+{
+	if (h == NULL) {
+		return 0;
+	}
+	return sizeof(*h) + h->capacity * (sizeof(*h->elems) + sizeof(*h->hashes));
+}
@@ -25,7 +25,7 @@
 #include "policy-query-internal.h"
 #include "infoflow-analysis-internal.h"
 #include "queue.h"
-#include <apol/bst.h>
+#include <apol/hashset.h>
 #include <apol/perm-map.h>
 
 #include <assert.h>
@@ -50,6 +50,14 @@
 #define APOL_INFOFLOW_COLOR_BLACK 2
 #define APOL_INFOFLOW_COLOR_RED   3
 
+/*
+ * These defines record which search, if any, ran out of budget and
+ * may be resumed.
+ */
+#define APOL_INFOFLOW_SEARCH_NONE    0
+#define APOL_INFOFLOW_SEARCH_TRANS   1
+#define APOL_INFOFLOW_SEARCH_FURTHER 2
+
 typedef struct apol_infoflow_node apol_infoflow_node_t;
 typedef struct apol_infoflow_edge apol_infoflow_edge_t;
 
@@ -59,9 +67,9 @@ struct apol_infoflow_graph
 	apol_vector_t *nodes;
 	/** vector of apol_infoflow_edge_t */
 	apol_vector_t *edges;
-	/** temporary BST of apol_infoflow_node_t used while building
-         *  the graph */
-	apol_bst_t *nodes_bst;
+	/** temporary hash set of apol_infoflow_node_t used while
+         *  building the graph */
+	apol_hashset_t *nodes_set;
 
 	unsigned int mode, direction;
 	regex_t *regex;
@@ -76,6 +84,24 @@ struct apol_infoflow_graph
 #ifdef HAVE_RAND_R
 	unsigned int seed;
 #endif
+
+	/** budget limiting each call of a transitive search, or NULL */
+	apol_budget_t *budget;
+	/** one of APOL_INFOFLOW_SEARCH_NONE, APOL_INFOFLOW_SEARCH_TRANS,
+	 * or APOL_INFOFLOW_SEARCH_FURTHER, for a search that ran out of
+	 * budget */
+	int search;
+	/** vector of apol_infoflow_node_t from which a suspended
+	 * transitive search begins, and the index of the current one */
+	apol_vector_t *trans_start;
+	size_t trans_current;
+	/** queue of a suspended search, or NULL if not yet begun or if
+	 * finding the paths to the search's end nodes */
+	apol_queue_t *queue;
+	/** non-zero if the current start node's paths are being found,
+	 * and the index within nodes of the next end node to examine */
+	int collecting;
+	size_t collect_next;
 };
 
 struct apol_infoflow_node
@@ -121,6 +147,7 @@ struct apol_infoflow_analysis
 	char *type, *result;
 	apol_vector_t *intermed, *class_perms;
 	int min_weight;
+	apol_budget_t *budget;
 };
 
 /**
@@ -226,30 +253,38 @@ static void apol_infoflow_node_free(void *data)
 	}
 }
 
-struct apol_infoflow_node_key
-{
-	const qpol_type_t *type;
-	int node_type;
-};
-
 /**
- * Given an infoflow node and a key, returns 0 if they are the same,
- * non-zero if not.
+ * Given two infoflow nodes, returns 0 if they have the same type and
+ * node type, non-zero if not.
  *
  * @param a Existing node within the infoflow graph.
- * @param b <i>Unused.</i>
- * @param data Pointer to a struct infoflow_node_key.
+ * @param b Node to compare against.
+ * @param data <i>Unused.</i>
  *
- * @return 0 if the key matches a, non-zero if not.
+ * @return 0 if the nodes match, non-zero if not.
  */
-static int apol_infoflow_node_compare(const void *a, const void *b __attribute__ ((unused)), void *data)
+static int apol_infoflow_node_compare(const void *a, const void *b, void *data __attribute__ ((unused)))
 {
-	apol_infoflow_node_t *node = (apol_infoflow_node_t *) a;
-	struct apol_infoflow_node_key *key = (struct apol_infoflow_node_key *)data;
-	if (node->type != key->type) {
-		return (int)((char *)node->type - (char *)key->type);
+	const apol_infoflow_node_t *n1 = (const apol_infoflow_node_t *)a;
+	const apol_infoflow_node_t *n2 = (const apol_infoflow_node_t *)b;
+	if (n1->type != n2->type) {
+		return (int)((char *)n1->type - (char *)n2->type);
 	}
-	return node->node_type - key->node_type;
+	return n1->node_type - n2->node_type;
+}
+
+/**
+ * Hash an infoflow node by its type and node type.
+ *
+ * @param a Node to hash.
+ * @param data <i>Unused.</i>
+ *
+ * @return Hash value for the node.
+ */
+static size_t apol_infoflow_node_hash(const void *a, void *data __attribute__ ((unused)))
+{
+	const apol_infoflow_node_t *node = (const apol_infoflow_node_t *)a;
+	return apol_hashset_ptr_hash(node->type) ^ (size_t) node->node_type;
 }
 
 /**
@@ -269,9 +304,10 @@ static int apol_infoflow_node_compare(const void *a, const void *b __attribute__
 static apol_infoflow_node_t *apol_infoflow_graph_create_node(const apol_policy_t * p,
 							     apol_infoflow_graph_t * g, const qpol_type_t * type, int node_type)
 {
-	struct apol_infoflow_node_key key = { type, node_type };
-	apol_infoflow_node_t *node = NULL;
-	if (apol_bst_get_element(g->nodes_bst, NULL, &key, (void **)&node) == 0) {
+	apol_infoflow_node_t key, *node = NULL;
+	key.type = type;
+	key.node_type = node_type;
+	if (apol_hashset_get_element(g->nodes_set, &key, NULL, (void **)&node) == 0) {
 		return node;
 	}
 	if ((node = calloc(1, sizeof(*node))) == NULL ||
@@ -282,7 +318,7 @@ static apol_infoflow_node_t *apol_infoflow_graph_create_node(const apol_policy_t
 	}
 	node->type = type;
 	node->node_type = node_type;
-	if (apol_bst_insert(g->nodes_bst, node, &key) != 0) {
+	if (apol_hashset_insert(g->nodes_set, node, NULL) != 0) {
 		ERR(p, "%s", strerror(errno));
 		apol_infoflow_node_free(node);
 		return NULL;
@@ -299,8 +335,8 @@ static apol_infoflow_node_t *apol_infoflow_graph_create_node(const apol_policy_t
  * @param g Infoflow to which add the node.
  * @param type Type for the new node.  If this is an attribute then it
  * will be expanded into its component types.
- * @param types If non-NULL, a BST of qpol_type_t pointers.  Only
- * create and return nodes which are members of this tree.
+ * @param types If non-NULL, a hash set of qpol_type_t pointers.  Only
+ * create and return nodes which are members of this set.
  * @param node_type Node type, one of APOL_INFOFLOW_NODE_SOURCE or
  * APOL_INFOFLOW_NODE_TARGET.
  *
@@ -309,7 +345,7 @@ static apol_infoflow_node_t *apol_infoflow_graph_create_node(const apol_policy_t
  * calling apol_vector_destroy() upon the return value.
  */
 static apol_vector_t *apol_infoflow_graph_create_nodes(const apol_policy_t * p,
-						       apol_infoflow_graph_t * g, const qpol_type_t * type, apol_bst_t * types,
+						       apol_infoflow_graph_t * g, const qpol_type_t * type, apol_hashset_t * types,
 						       int node_type)
 {
 	unsigned char isattr;
@@ -331,7 +367,7 @@ static apol_vector_t *apol_infoflow_graph_create_nodes(const apol_policy_t * p,
 		for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
 			qpol_iterator_get_item(iter, (void **)&t);
 			void *result;
-			if (types != NULL && apol_bst_get_element(types, t, NULL, &result) < 0) {
+			if (types != NULL && apol_hashset_get_element(types, t, NULL, &result) < 0) {
 				continue;
 			}
 			if ((node = apol_infoflow_graph_create_node(p, g, t, node_type)) == NULL || apol_vector_append(v, node) < 0) {
@@ -346,7 +382,7 @@ static apol_vector_t *apol_infoflow_graph_create_nodes(const apol_policy_t * p,
 		 * algorithm will do that with
 		 * apol_infoflow_graph_get_nodes_for_type() and
 		 * apol_infoflow_analysis_direct_expand().  for
-		 * transitive searches the \a types BST was checked in
+		 * transitive searches the \a types hash set was checked in
 		 * apol_infoflow_graph_check_types() if \a type is
 		 * just a type.
 		 */
@@ -465,7 +501,7 @@ static apol_infoflow_edge_t *apol_infoflow_graph_create_edge(const apol_policy_t
  * @param p Policy containing rules.
  * @param g Information flow graph being created.
  * @param rule AV rule to use.
- * @param types BST of qpol_type_t pointers; while adding avrules to
+ * @param types Hash set of qpol_type_t pointers; while adding avrules to
  * the graph, only add those whose source and/or target is a member of
  * \a types, if \a types is non-NULL.
  * @param found_read Non-zero to indicate that this rule performs a
@@ -482,7 +518,7 @@ static apol_infoflow_edge_t *apol_infoflow_graph_create_edge(const apol_policy_t
 static int apol_infoflow_graph_connect_nodes(const apol_policy_t * p,
 					     apol_infoflow_graph_t * g,
 					     const qpol_avrule_t * rule,
-					     apol_bst_t * types, int found_read, int read_len, int found_write, int write_len)
+					     apol_hashset_t * types, int found_read, int read_len, int found_write, int write_len)
 {
 	const qpol_type_t *src_type, *tgt_type;
 	apol_vector_t *src_nodes = NULL, *tgt_nodes = NULL;
@@ -539,7 +575,7 @@ static int apol_infoflow_graph_connect_nodes(const apol_policy_t * p,
  * @param p Policy from which to create the infoflow graph.
  * @param g Infoflow graph being created.
  * @param rule AV rule to add.
- * @param types BST of qpol_type_t pointers; while adding avrules to
+ * @param types Hash set of qpol_type_t pointers; while adding avrules to
  * the graph, only add those whose source and/or target is a member of
  * \a types, if \a types is non-NULL.
  * @param max_len Maximum permission length (i.e., inverse of
@@ -549,7 +585,7 @@ static int apol_infoflow_graph_connect_nodes(const apol_policy_t * p,
  * @return 0 on success, < 0 on error.
  */
 static int apol_infoflow_graph_create_avrule(const apol_policy_t * p, apol_infoflow_graph_t * g, const qpol_avrule_t * rule,
-					     apol_bst_t * types, int max_len)
+					     apol_hashset_t * types, int max_len)
 {
 	const qpol_class_t *obj_class;
 	qpol_iterator_t *perm_iter = NULL;
@@ -614,25 +650,25 @@ static int apol_infoflow_graph_create_avrule(const apol_policy_t * p, apol_infof
 }
 
 /**
- * Given a vector of strings representing types, return a BST of
+ * Given a vector of strings representing types, return a hash set of
  * qpol_type_t pointers consisting of those types, those types'
  * attributes, and those types' aliases.
  *
  * @param p Policy within which to look up types,
  * @param v Vector of type strings.
  *
- * @return BST of qpol_type_t pointers, or NULL on error.  The caller
- * is responsible for calling apol_bst_destroy() upon the returned
+ * @return Hash set of qpol_type_t pointers, or NULL on error.  The
+ * caller is responsible for calling apol_hashset_destroy() upon the returned
  * value.
  */
-static apol_bst_t *apol_infoflow_graph_create_required_types(const apol_policy_t * p, const apol_vector_t * v)
+static apol_hashset_t *apol_infoflow_graph_create_required_types(const apol_policy_t * p, const apol_vector_t * v)
 {
-	apol_bst_t *types = NULL;
+	apol_hashset_t *types = NULL;
 	apol_vector_t *expanded_types = NULL;
 	size_t i;
 	char *s;
 	int retval = -1;
-	if ((types = apol_bst_create(NULL, NULL)) == NULL) {
+	if ((types = apol_hashset_create(NULL, NULL, NULL)) == NULL) {
 		ERR(p, "%s", strerror(errno));
 		goto cleanup;
 	}
@@ -644,7 +680,7 @@ static apol_bst_t *apol_infoflow_graph_create_required_types(const apol_policy_t
 		}
 		for (size_t j = 0; j < apol_vector_get_size(expanded_types); j++) {
 			qpol_type_t *t = (qpol_type_t *) apol_vector_get_element(expanded_types, j);
-			if (apol_bst_insert(types, t, NULL) < 0) {
+			if (apol_hashset_insert(types, t, NULL) < 0) {
 				ERR(p, "%s", strerror(errno));
 				goto cleanup;
 			}
@@ -655,7 +691,7 @@ static apol_bst_t *apol_infoflow_graph_create_required_types(const apol_policy_t
       cleanup:
 	apol_vector_destroy(&expanded_types);
 	if (retval != 0) {
-		apol_bst_destroy(&types);
+		apol_hashset_destroy(&types);
 	}
 	return types;
 }
@@ -666,12 +702,12 @@ static apol_bst_t *apol_infoflow_graph_create_required_types(const apol_policy_t
  *
  * @param p Policy to which look up classes and permissions.
  * @param rule AV rule to check.
- * @param types BST of qpol_type_t, of which both the source and
+ * @param types Hash set of qpol_type_t, of which both the source and
  * target types must be members.  If NULL allow all types.
  *
  * @return 1 if rule matches, 0 if not, < 0 on error.
  */
-static int apol_infoflow_graph_check_types(const apol_policy_t * p, const qpol_avrule_t * rule, const apol_bst_t * types)
+static int apol_infoflow_graph_check_types(const apol_policy_t * p, const qpol_avrule_t * rule, const apol_hashset_t * types)
 {
 	const qpol_type_t *source, *target;
 	void *result;
@@ -683,7 +719,7 @@ static int apol_infoflow_graph_check_types(const apol_policy_t * p, const qpol_a
 	if (qpol_avrule_get_source_type(p->p, rule, &source) < 0 || qpol_avrule_get_target_type(p->p, rule, &target) < 0) {
 		goto cleanup;
 	}
-	if (apol_bst_get_element(types, source, NULL, &result) < 0 || apol_bst_get_element(types, target, NULL, &result) < 0) {
+	if (apol_hashset_get_element(types, source, NULL, &result) < 0 || apol_hashset_get_element(types, target, NULL, &result) < 0) {
 		retval = 0;
 		goto cleanup;
 	}
@@ -770,10 +806,13 @@ static int apol_infoflow_graph_check_class_perms(const apol_policy_t * p, const
  */
 static int apol_infoflow_graph_create(const apol_policy_t * p, const apol_infoflow_analysis_t * ia, apol_infoflow_graph_t ** g)
 {
-	apol_bst_t *types = NULL;
+	apol_hashset_t *types = NULL;
 	qpol_iterator_t *iter = NULL;
+	void *batch[APOL_QUERY_ITER_BATCH];
+	int num_items, b;
 	int max_len = APOL_PERMMAP_MAX_WEIGHT - ia->min_weight + 1;
 	int compval, retval = -1;
+	size_t depth = apol_stats_begin(p, "infoflow graph");
 
 	*g = NULL;
 	if (p->pmap == NULL) {
@@ -788,12 +827,13 @@ static int apol_infoflow_graph_create(const apol_policy_t * p, const apol_infofl
 	}
 
 	if ((*g = calloc(1, sizeof(**g))) == NULL ||
-	    ((*g)->nodes_bst = apol_bst_create(apol_infoflow_node_compare, apol_infoflow_node_free)) == NULL) {
+	    ((*g)->nodes_set = apol_hashset_create(apol_infoflow_node_hash, apol_infoflow_node_compare, apol_infoflow_node_free)) == NULL) {
 		ERR(p, "%s", strerror(errno));
 		goto cleanup;
 	}
 	(*g)->mode = ia->mode;
 	(*g)->direction = ia->direction;
+	(*g)->budget = ia->budget;
 	if (ia->result != NULL && ia->result[0] != '\0') {
 		if (((*g)->regex = malloc(sizeof(regex_t))) == NULL || regcomp((*g)->regex, ia->result, REG_EXTENDED | REG_NOSUB)) {
 			ERR(p, "%s", strerror(errno));
@@ -809,47 +849,69 @@ static int apol_infoflow_graph_create(const apol_policy_t * p, const apol_infofl
 		goto cleanup;
 	}
 
-	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
-		qpol_avrule_t *rule;
-		if (qpol_iterator_get_item(iter, (void **)&rule) < 0) {
-			goto cleanup;
-		}
-		compval = apol_infoflow_graph_check_types(p, rule, types);
-		if (compval < 0) {
-			goto cleanup;
-		} else if (compval == 0) {
-			continue;
-		}
-		compval = apol_infoflow_graph_check_class_perms(p, rule, ia->class_perms);
-		if (compval < 0) {
-			goto cleanup;
-		} else if (compval == 0) {
-			continue;
-		}
-		if (apol_infoflow_graph_create_avrule(p, *g, rule, types, max_len) < 0) {
-			goto cleanup;
+	while ((num_items = qpol_iterator_next_batch(iter, batch, APOL_QUERY_ITER_BATCH)) > 0) {
+		apol_stats_add(p, QPOL_STATS_RULES_SCANNED, num_items);
+		for (b = 0; b < num_items; b++) {
+			qpol_avrule_t *rule = batch[b];
+			compval = apol_infoflow_graph_check_types(p, rule, types);
+			if (compval < 0) {
+				goto cleanup;
+			} else if (compval == 0) {
+				continue;
+			}
+			compval = apol_infoflow_graph_check_class_perms(p, rule, ia->class_perms);
+			if (compval < 0) {
+				goto cleanup;
+			} else if (compval == 0) {
+				continue;
+			}
+			if (apol_infoflow_graph_create_avrule(p, *g, rule, types, max_len) < 0) {
+				goto cleanup;
+			}
+			apol_stats_add(p, QPOL_STATS_RULES_MATCHED, 1);
 		}
 	}
+	if (num_items < 0) {
+		goto cleanup;
+	}
 
-	if (((*g)->nodes = apol_bst_get_vector((*g)->nodes_bst, 1)) == NULL) {
+	if (((*g)->nodes = apol_hashset_get_vector((*g)->nodes_set, 1)) == NULL) {
 		ERR(p, "%s", strerror(errno));
 		goto cleanup;
 	}
-	apol_bst_destroy(&(*g)->nodes_bst);
+	apol_hashset_destroy(&(*g)->nodes_set);
 	retval = 0;
       cleanup:
-	apol_bst_destroy(&types);
+	apol_hashset_destroy(&types);
 	qpol_iterator_destroy(&iter);
 	if (retval < 0) {
 		apol_infoflow_graph_destroy(g);
 	}
+	apol_stats_end(p, depth);
 	return retval;
 }
 
+/**
+ * Discard the state of any search of an infoflow graph that ran out
+ * of budget.
+ *
+ * @param g Infoflow graph to reset.
+ */
+static void apol_infoflow_graph_search_reset(apol_infoflow_graph_t * g)
+{
+	g->search = APOL_INFOFLOW_SEARCH_NONE;
+	apol_vector_destroy(&g->trans_start);
+	g->trans_current = 0;
+	apol_queue_destroy(&g->queue);
+	g->collecting = 0;
+	g->collect_next = 0;
+}
+
 void apol_infoflow_graph_destroy(apol_infoflow_graph_t ** g)
 {
 	if (g != NULL && *g != NULL) {
-		apol_bst_destroy(&(*g)->nodes_bst);
+		apol_infoflow_graph_search_reset(*g);
+		apol_hashset_destroy(&(*g)->nodes_set);
 		apol_vector_destroy(&(*g)->nodes);
 		apol_vector_destroy(&(*g)->edges);
 		apol_vector_destroy(&(*g)->further_start);
@@ -1162,6 +1224,7 @@ static int apol_infoflow_analysis_direct(const apol_policy_t * p,
 	if (apol_infoflow_graph_get_nodes_for_type(p, g, start_type, nodes) < 0) {
 		goto cleanup;
 	}
+	apol_stats_add(p, QPOL_STATS_NODES_EXPANDED, apol_vector_get_size(nodes));
 
 	if (g->direction == APOL_INFOFLOW_IN || g->direction == APOL_INFOFLOW_EITHER || g->direction == APOL_INFOFLOW_BOTH) {
 		for (i = 0; i < apol_vector_get_size(nodes); i++) {
@@ -1581,6 +1644,12 @@ static int apol_infoflow_analysis_trans_expand(const apol_policy_t * p,
  * most normal sparse graphs are significantly better than the worst
  * case.
  *
+ * The search stops early if the graph's budget runs out, leaving
+ * its state within the graph so that calling this function again
+ * with the same start node continues it.  The queue is kept between
+ * calls while labels are corrected; once it empties, the paths to
+ * each end node are appended to the results.
+ *
  * @param p Policy to analyze.
  * @param g Information flow graph to analyze.
  * @param start Node from which to begin search.
@@ -1588,89 +1657,139 @@ static int apol_infoflow_analysis_trans_expand(const apol_policy_t * p,
  * The caller is responsible for calling apol_infoflow_results_free()
  * upon each element afterwards.
  *
- * @return 0 on success, < 0 on error.
+ * @return 0 on success, 1 if the budget ran out before the search
+ * finished, < 0 on error.
  */
 static int apol_infoflow_analysis_trans_shortest_path(const apol_policy_t * p,
 						      apol_infoflow_graph_t * g,
 						      apol_infoflow_node_t * start, apol_vector_t * results)
 {
 	apol_vector_t *edge_list;
-	apol_queue_t *queue = NULL;
 	apol_infoflow_node_t *node, *cur_node;
 	apol_infoflow_edge_t *edge;
 	size_t i;
 	int retval = -1;
 
-	if ((queue = apol_queue_create()) == NULL) {
-		ERR(p, "%s", strerror(ENOMEM));
-		goto cleanup;
-	}
-	if (apol_infoflow_graph_trans_init(p, g, start, queue) < 0) {
-		goto cleanup;
-	}
-
-	while ((cur_node = apol_queue_remove(queue)) != NULL) {
-		cur_node->color = APOL_INFOFLOW_COLOR_GREY;
-		if (g->direction == APOL_INFOFLOW_OUT) {
-			edge_list = cur_node->out_edges;
-		} else {
-			edge_list = cur_node->in_edges;
+	if (!g->collecting) {
+		if (g->queue == NULL) {
+			if ((g->queue = apol_queue_create()) == NULL) {
+				ERR(p, "%s", strerror(ENOMEM));
+				goto cleanup;
+			}
+			if (apol_infoflow_graph_trans_init(p, g, start, g->queue) < 0) {
+				goto cleanup;
+			}
 		}
-		for (i = 0; i < apol_vector_get_size(edge_list); i++) {
-			edge = (apol_infoflow_edge_t *) apol_vector_get_element(edge_list, i);
+
+		while ((cur_node = apol_queue_remove(g->queue)) != NULL) {
+			apol_stats_add(p, QPOL_STATS_NODES_EXPANDED, 1);
+			apol_budget_add_nodes(g->budget, 1);
+			cur_node->color = APOL_INFOFLOW_COLOR_GREY;
 			if (g->direction == APOL_INFOFLOW_OUT) {
-				node = edge->end_node;
+				edge_list = cur_node->out_edges;
 			} else {
-				node = edge->start_node;
-			}
-			if (node == start) {
-				continue;
+				edge_list = cur_node->in_edges;
 			}
+			for (i = 0; i < apol_vector_get_size(edge_list); i++) {
+				edge = (apol_infoflow_edge_t *) apol_vector_get_element(edge_list, i);
+				if (g->direction == APOL_INFOFLOW_OUT) {
+					node = edge->end_node;
+				} else {
+					node = edge->start_node;
+				}
+				if (node == start) {
+					continue;
+				}
 
-			if (node->distance > cur_node->distance + edge->length) {
-				node->distance = cur_node->distance + edge->length;
-				node->parent = cur_node;
-				/* If this node has been inserted into
-				 * the queue before insert it at the
-				 * beginning, otherwise it goes to the
-				 * end.  See the comment at the
-				 * beginning of the function for
-				 * why. */
-				if (node->color != APOL_INFOFLOW_COLOR_RED) {
-					if (node->color == APOL_INFOFLOW_COLOR_GREY) {
-						if (apol_queue_push(queue, node) < 0) {
-							ERR(p, "%s", strerror(ENOMEM));
-							goto cleanup;
-						}
-					} else {
-						if (apol_queue_insert(queue, node) < 0) {
-							ERR(p, "%s", strerror(ENOMEM));
-							goto cleanup;
+				if (node->distance > cur_node->distance + edge->length) {
+					node->distance = cur_node->distance + edge->length;
+					node->parent = cur_node;
+					/* If this node has been inserted into
+					 * the queue before insert it at the
+					 * beginning, otherwise it goes to the
+					 * end.  See the comment at the
+					 * beginning of the function for
+					 * why. */
+					if (node->color != APOL_INFOFLOW_COLOR_RED) {
+						if (node->color == APOL_INFOFLOW_COLOR_GREY) {
+							if (apol_queue_push(g->queue, node) < 0) {
+								ERR(p, "%s", strerror(ENOMEM));
+								goto cleanup;
+							}
+						} else {
+							if (apol_queue_insert(g->queue, node) < 0) {
+								ERR(p, "%s", strerror(ENOMEM));
+								goto cleanup;
+							}
 						}
+						node->color = APOL_INFOFLOW_COLOR_RED;
 					}
-					node->color = APOL_INFOFLOW_COLOR_RED;
 				}
 			}
+			if (apol_budget_is_spent(g->budget, apol_vector_get_size(results))) {
+				return 1;
+			}
 		}
+		apol_queue_destroy(&g->queue);
+		g->collecting = 1;
+		g->collect_next = 0;
 	}
 
 	/* Find all of the paths and add them to the results vector */
-	for (i = 0; i < apol_vector_get_size(g->nodes); i++) {
-		cur_node = (apol_infoflow_node_t *) apol_vector_get_element(g->nodes, i);
+	while (g->collect_next < apol_vector_get_size(g->nodes)) {
+		cur_node = (apol_infoflow_node_t *) apol_vector_get_element(g->nodes, g->collect_next);
+		g->collect_next++;
 		if (cur_node->parent == NULL || cur_node == start) {
 			continue;
 		}
 		if (apol_infoflow_analysis_trans_expand(p, g, start, cur_node, results) < 0) {
 			goto cleanup;
 		}
+		if (apol_budget_is_spent(g->budget, apol_vector_get_size(results))) {
+			return 1;
+		}
 	}
-
+	g->collecting = 0;
 	retval = 0;
       cleanup:
-	apol_queue_destroy(&queue);
+	if (retval < 0) {
+		apol_queue_destroy(&g->queue);
+		g->collecting = 0;
+	}
 	return retval;
 }
 
+/**
+ * Continue a transitive information flow analysis from the start
+ * node at which it stopped, until either every start node has been
+ * searched or the graph's budget runs out.
+ *
+ * @param p Policy to analyze.
+ * @param g Information flow graph to analyze, prepared by
+ * apol_infoflow_analysis_trans().
+ * @param results Non-NULL vector to which append infoflow results.
+ *
+ * @return 0 on success, 1 if the budget ran out before the search
+ * finished, < 0 on error.
+ */
+static int apol_infoflow_analysis_trans_continue(const apol_policy_t * p, apol_infoflow_graph_t * g, apol_vector_t * results)
+{
+	apol_infoflow_node_t *start_node;
+	int retval;
+	while (g->trans_current < apol_vector_get_size(g->trans_start)) {
+		start_node = (apol_infoflow_node_t *) apol_vector_get_element(g->trans_start, g->trans_current);
+		if ((retval = apol_infoflow_analysis_trans_shortest_path(p, g, start_node, results)) != 0) {
+			if (retval < 0) {
+				apol_infoflow_graph_search_reset(g);
+			}
+			return retval;
+		}
+		g->trans_current++;
+	}
+	apol_infoflow_graph_search_reset(g);
+	return 0;
+}
+
 /**
  * Perform a transitive information flow analysis upon the given
  * infoflow graph.
@@ -1682,36 +1801,32 @@ static int apol_infoflow_analysis_trans_shortest_path(const apol_policy_t * p,
  * The caller is responsible for calling apol_infoflow_results_free()
  * upon each element afterwards.
  *
- * @return 0 on success, < 0 on error.
+ * @return 0 on success, 1 if the graph's budget ran out before the
+ * search finished, < 0 on error.
  */
 static int apol_infoflow_analysis_trans(const apol_policy_t * p,
 					apol_infoflow_graph_t * g, const char *start_type, apol_vector_t * results)
 {
-	apol_vector_t *start_nodes = NULL;
-	apol_infoflow_node_t *start_node;
-	size_t i;
 	int retval = -1;
 
 	if (g->direction != APOL_INFOFLOW_IN && g->direction != APOL_INFOFLOW_OUT) {
 		ERR(p, "%s", strerror(EINVAL));
 		goto cleanup;
 	}
-	if ((start_nodes = apol_vector_create(NULL)) == NULL) {
+	apol_infoflow_graph_search_reset(g);
+	if ((g->trans_start = apol_vector_create(NULL)) == NULL) {
 		ERR(p, "%s", strerror(errno));
 		goto cleanup;
 	}
-	if (apol_infoflow_graph_get_nodes_for_type(p, g, start_type, start_nodes) < 0) {
+	if (apol_infoflow_graph_get_nodes_for_type(p, g, start_type, g->trans_start) < 0) {
 		goto cleanup;
 	}
-	for (i = 0; i < apol_vector_get_size(start_nodes); i++) {
-		start_node = (apol_infoflow_node_t *) apol_vector_get_element(start_nodes, i);
-		if (apol_infoflow_analysis_trans_shortest_path(p, g, start_node, results) < 0) {
-			goto cleanup;
-		}
-	}
-	retval = 0;
+	g->search = APOL_INFOFLOW_SEARCH_TRANS;
+	retval = apol_infoflow_analysis_trans_continue(p, g, results);
       cleanup:
-	apol_vector_destroy(&start_nodes);
+	if (retval < 0) {
+		apol_infoflow_graph_search_reset(g);
+	}
 	return retval;
 }
 
@@ -1771,25 +1886,44 @@ static apol_vector_t *apol_infoflow_trans_further_shuffle(const apol_policy_t *
 	return new_v;
 }
 
+/**
+ * Perform one breadth-first search of a further transitive infoflow
+ * analysis, from a start node to each of the graph's further end
+ * nodes, visiting neighbors in random order.  The search stops early
+ * if the graph's budget runs out, keeping its queue within the graph
+ * so that calling this function again with the same start node
+ * continues it.
+ *
+ * @param p Policy to analyze.
+ * @param g Information flow graph to analyze.
+ * @param start Node from which to begin search.
+ * @param results Non-NULL vector to which append infoflow results.
+ *
+ * @return 0 on success, 1 if the budget ran out before the search
+ * finished, < 0 on error.
+ */
 static int apol_infoflow_analysis_trans_further(const apol_policy_t * p,
 						apol_infoflow_graph_t * g, apol_infoflow_node_t * start, apol_vector_t * results)
 {
 	apol_vector_t *edge_list = NULL;
-	apol_queue_t *queue = NULL;
 	apol_infoflow_node_t *node, *cur_node;
 	apol_infoflow_edge_t *edge;
 	size_t i;
 	int retval = -1;
 
-	if ((queue = apol_queue_create()) == NULL) {
-		ERR(p, "%s", strerror(ENOMEM));
-		goto cleanup;
-	}
-	if (apol_infoflow_graph_trans_further_init(p, g, start, queue) < 0) {
-		goto cleanup;
+	if (g->queue == NULL) {
+		if ((g->queue = apol_queue_create()) == NULL) {
+			ERR(p, "%s", strerror(ENOMEM));
+			goto cleanup;
+		}
+		if (apol_infoflow_graph_trans_further_init(p, g, start, g->queue) < 0) {
+			goto cleanup;
+		}
 	}
 
-	while ((cur_node = apol_queue_remove(queue)) != NULL) {
+	while ((cur_node = apol_queue_remove(g->queue)) != NULL) {
+		apol_stats_add(p, QPOL_STATS_NODES_EXPANDED, 1);
+		apol_budget_add_nodes(g->budget, 1);
 		if (cur_node != start &&
 		    apol_vector_get_index(g->further_end, cur_node, NULL, NULL, &i) == 0 &&
 		    apol_infoflow_analysis_trans_expand(p, g, start, cur_node, results) < 0) {
@@ -1816,18 +1950,21 @@ static int apol_infoflow_analysis_trans_further(const apol_policy_t * p,
 				node->color = APOL_INFOFLOW_COLOR_GREY;
 				node->distance = cur_node->distance + 1;
 				node->parent = cur_node;
-				if (apol_queue_push(queue, node) < 0) {
+				if (apol_queue_push(g->queue, node) < 0) {
 					ERR(p, "%s", strerror(ENOMEM));
 					goto cleanup;
 				}
 			}
 		}
 		apol_vector_destroy(&edge_list);
+		if (apol_budget_is_spent(g->budget, apol_vector_get_size(results))) {
+			return 1;
+		}
 	}
 	retval = 0;
       cleanup:
 	apol_vector_destroy(&edge_list);
-	apol_queue_destroy(&queue);
+	apol_queue_destroy(&g->queue);
 	return retval;
 }
 
@@ -1837,6 +1974,7 @@ int apol_infoflow_analysis_do(const apol_policy_t * p, const apol_infoflow_analy
 			      apol_infoflow_graph_t ** g)
 {
 	int retval = -1;
+	size_t depth = apol_stats_begin(p, "infoflow analysis");
 	if (v != NULL) {
 		*v = NULL;
 	}
@@ -1853,9 +1991,10 @@ int apol_infoflow_analysis_do(const apol_policy_t * p, const apol_infoflow_analy
 	INFO(p, "%s", "Searching information flow graph.");
 	retval = apol_infoflow_analysis_do_more(p, *g, ia->type, v);
       cleanup:
-	if (retval != 0) {
+	if (retval < 0) {
 		apol_infoflow_graph_destroy(g);
 	}
+	apol_stats_end(p, depth);
 	return retval;
 }
 
@@ -1863,6 +2002,7 @@ int apol_infoflow_analysis_do_more(const apol_policy_t * p, apol_infoflow_graph_
 {
 	const qpol_type_t *start_type;
 	int retval = -1;
+	size_t depth = apol_stats_begin(p, "infoflow search");
 	if (v != NULL) {
 		*v = NULL;
 	}
@@ -1880,17 +2020,25 @@ int apol_infoflow_analysis_do_more(const apol_policy_t * p, apol_infoflow_graph_
 		goto cleanup;
 	}
 
-	if ((g->mode == APOL_INFOFLOW_MODE_DIRECT &&
-	     apol_infoflow_analysis_direct(p, g, type, *v) < 0) ||
-	    (g->mode == APOL_INFOFLOW_MODE_TRANS && apol_infoflow_analysis_trans(p, g, type, *v) < 0)) {
+	apol_infoflow_graph_search_reset(g);
+	apol_budget_begin(g->budget, 0);
+	if (g->mode == APOL_INFOFLOW_MODE_DIRECT) {
+		retval = apol_infoflow_analysis_direct(p, g, type, *v);
+	} else if (g->mode == APOL_INFOFLOW_MODE_TRANS) {
+		retval = apol_infoflow_analysis_trans(p, g, type, *v);
+	} else {
+		retval = 0;
+	}
+	if (retval < 0) {
 		goto cleanup;
 	}
 
-	retval = 0;
+	apol_stats_add(p, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*v));
       cleanup:
-	if (retval != 0) {
+	if (retval < 0) {
 		apol_vector_destroy(v);
 	}
+	apol_stats_end(p, depth);
 	return retval;
 }
 
@@ -1908,6 +2056,7 @@ int apol_infoflow_analysis_trans_further_prepare(const apol_policy_t * p,
 		ERR(p, "%s", "May only perform further infoflow analysis when the graph is transitive.");
 		goto cleanup;
 	}
+	apol_infoflow_graph_search_reset(g);
 	apol_vector_destroy(&g->further_start);
 	apol_vector_destroy(&g->further_end);
 	if ((g->further_start = apol_vector_create(NULL)) == NULL || (g->further_end = apol_vector_create(NULL)) == NULL) {
@@ -1928,28 +2077,75 @@ int apol_infoflow_analysis_trans_further_next(const apol_policy_t * p, apol_info
 {
 	apol_infoflow_node_t *start_node;
 	int retval = -1;
+	size_t depth, num_results;
 	if (p == NULL || g == NULL || v == NULL) {
 		ERR(p, "%s", strerror(EINVAL));
 		errno = EINVAL;
 		return -1;
 	}
+	depth = apol_stats_begin(p, "infoflow further search");
 	if (*v == NULL) {
 		*v = apol_vector_create(infoflow_result_free);
 	}
+	num_results = apol_vector_get_size(*v);
 	if (g->further_start == NULL) {
 		ERR(p, "%s", "Infoflow graph was not prepared yet.");
 		goto cleanup;
 	}
+	/* continue a search that ran out of budget; otherwise begin
+	 * anew from the next start node */
+	if (g->search != APOL_INFOFLOW_SEARCH_FURTHER) {
+		apol_infoflow_graph_search_reset(g);
+	}
+	apol_budget_begin(g->budget, num_results);
 	start_node = apol_vector_get_element(g->further_start, g->current_start);
-	if (apol_infoflow_analysis_trans_further(p, g, start_node, *v) < 0) {
+	if ((retval = apol_infoflow_analysis_trans_further(p, g, start_node, *v)) < 0) {
+		apol_infoflow_graph_search_reset(g);
 		goto cleanup;
 	}
-	g->current_start++;
-	if (g->current_start >= apol_vector_get_size(g->further_start)) {
-		g->current_start = 0;
+	if (retval == 0) {
+		g->search = APOL_INFOFLOW_SEARCH_NONE;
+		g->current_start++;
+		if (g->current_start >= apol_vector_get_size(g->further_start)) {
+			g->current_start = 0;
+		}
+	} else {
+		g->search = APOL_INFOFLOW_SEARCH_FURTHER;
 	}
+	apol_stats_add(p, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*v) - num_results);
+      cleanup:
+	apol_stats_end(p, depth);
+	return retval;
+}
+
+int apol_infoflow_analysis_resume(const apol_policy_t * p, apol_infoflow_graph_t * g, apol_vector_t ** v)
+{
+	int retval = -1;
+	size_t depth, num_results;
+	if (p == NULL || g == NULL || v == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	if (g->search == APOL_INFOFLOW_SEARCH_FURTHER) {
+		return apol_infoflow_analysis_trans_further_next(p, g, v);
+	}
+	depth = apol_stats_begin(p, "infoflow search");
+	if (*v == NULL && (*v = apol_vector_create(infoflow_result_free)) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	num_results = apol_vector_get_size(*v);
 	retval = 0;
+	if (g->search == APOL_INFOFLOW_SEARCH_TRANS) {
+		apol_budget_begin(g->budget, num_results);
+		if ((retval = apol_infoflow_analysis_trans_continue(p, g, *v)) < 0) {
+			goto cleanup;
+		}
+		apol_stats_add(p, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*v) - num_results);
+	}
       cleanup:
+	apol_stats_end(p, depth);
 	return retval;
 }
 
@@ -2107,6 +2303,13 @@ int apol_infoflow_analysis_set_min_weight(const apol_policy_t * p
 	return 0;
 }
 
+int apol_infoflow_analysis_set_budget(const apol_policy_t * p
+				      __attribute__ ((unused)), apol_infoflow_analysis_t * ia, apol_budget_t * budget)
+{
+	ia->budget = budget;
+	return 0;
+}
+
 int apol_infoflow_analysis_set_result_regex(const apol_policy_t * p, apol_infoflow_analysis_t * ia, const char *result)
 {
 	return apol_query_set(p, &ia->result, NULL, result);
@@ -29,6 +29,7 @@
  */
 
 #include "policy-query-internal.h"
+#include "vector-internal.h"
 #include <apol/render.h>
 
 #include <errno.h>
@@ -590,3 +591,510 @@ char *apol_nodecon_render(const apol_policy_t * p, const qpol_nodecon_t * nodeco
 	free(context_str);
 	return retval;
 }
+
+/******************** portcon and nodecon lookups ********************/
+
+/** number of address bits for each nodecon protocol */
+#define NETCON_IPV4_BITS 32
+#define NETCON_IPV6_BITS 128
+
+/**
+ * One portcon within the interval tree.  The tree is implicit: the
+ * entries of each protocol are sorted by low port, and the root of
+ * any range of entries is its middle element.
+ */
+typedef struct portcon_entry
+{
+	uint8_t proto;
+	uint16_t low, high;
+	/** largest high port within the subtree rooted at this entry */
+	uint16_t max_high;
+	/** position of the portcon within the policy, to break ties */
+	size_t order;
+	const qpol_portcon_t *portcon;
+} portcon_entry_t;
+
+/**
+ * Node within a binary radix trie of nodecon address prefixes.  A
+ * child index of 0 means no child, as the root is never a child.
+ */
+typedef struct nodecon_trie_node
+{
+	size_t child[2];
+	/** nodecon whose prefix ends at this node, or NULL */
+	const qpol_nodecon_t *nodecon;
+	/** position of the nodecon within the policy */
+	size_t order;
+} nodecon_trie_node_t;
+
+/** A nodecon whose netmask is not a prefix. */
+typedef struct nodecon_odd
+{
+	const qpol_nodecon_t *nodecon;
+	unsigned char proto;
+	uint32_t *addr, *mask;
+	/** number of one bits within mask */
+	size_t len;
+	/** position of the nodecon within the policy */
+	size_t order;
+} nodecon_odd_t;
+
+typedef struct nodecon_trie
+{
+	nodecon_trie_node_t *nodes;
+	size_t num_nodes, cap_nodes;
+} nodecon_trie_t;
+
+struct apol_netcon_index
+{
+	/** all portcons, sorted by protocol then by low port */
+	portcon_entry_t *ports;
+	size_t num_ports;
+	/** one trie for QPOL_IPV4 and one for QPOL_IPV6 */
+	nodecon_trie_t tries[2];
+	/** vector of nodecon_odd_t, for nodecons whose masks are not a
+	 *  prefix; these are checked linearly, in policy order */
+	apol_vector_t *odd_nodecons;
+	/** every nodecon; qpol hands out copies, so the index owns them */
+	apol_vector_t *nodecons;
+};
+
+static int portcon_entry_comp(const void *a, const void *b)
+{
+	const portcon_entry_t *x = a, *y = b;
+	if (x->proto != y->proto)
+		return (x->proto < y->proto ? -1 : 1);
+	if (x->low != y->low)
+		return (x->low < y->low ? -1 : 1);
+	if (x->order != y->order)
+		return (x->order < y->order ? -1 : 1);
+	return 0;
+}
+
+/**
+ * Fill in the max_high of the implicit subtree covering entries
+ * [lo, hi).
+ *
+ * @return The largest high port within the subtree, or 0 if empty.
+ */
+static uint16_t portcon_tree_build(portcon_entry_t * e, size_t lo, size_t hi)
+{
+	size_t mid;
+	uint16_t m, sub;
+	if (lo >= hi)
+		return 0;
+	mid = lo + (hi - lo) / 2;
+	m = e[mid].high;
+	if ((sub = portcon_tree_build(e, lo, mid)) > m)
+		m = sub;
+	if ((sub = portcon_tree_build(e, mid + 1, hi)) > m)
+		m = sub;
+	e[mid].max_high = m;
+	return m;
+}
+
+/**
+ * Find the narrowest portcon within entries [lo, hi) whose range
+ * contains port.  Among equally narrow ranges the one appearing
+ * first in the policy wins.
+ */
+static void portcon_tree_stab(const portcon_entry_t * e, size_t lo, size_t hi, uint16_t port, const portcon_entry_t ** best)
+{
+	size_t mid;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (e[mid].max_high < port)
+			return;
+		portcon_tree_stab(e, lo, mid, port, best);
+		if (e[mid].low > port)
+			return;	       /* so does everything to the right */
+		if (e[mid].high >= port) {
+			const portcon_entry_t *b = *best;
+			if (b == NULL || e[mid].high - e[mid].low < b->high - b->low ||
+			    (e[mid].high - e[mid].low == b->high - b->low && e[mid].order < b->order)) {
+				*best = e + mid;
+			}
+		}
+		lo = mid + 1;
+	}
+}
+
+/**
+ * Find the range of entries [*lo, *hi) with the given protocol.
+ */
+static void portcon_proto_range(const apol_netcon_index_t * idx, uint8_t proto, size_t * lo, size_t * hi)
+{
+	size_t l = 0, h = idx->num_ports, m;
+	while (l < h) {
+		m = l + (h - l) / 2;
+		if (idx->ports[m].proto < proto)
+			l = m + 1;
+		else
+			h = m;
+	}
+	*lo = l;
+	h = idx->num_ports;
+	while (l < h) {
+		m = l + (h - l) / 2;
+		if (idx->ports[m].proto <= proto)
+			l = m + 1;
+		else
+			h = m;
+	}
+	*hi = l;
+}
+
+static int netcon_index_add_portcons(const apol_policy_t * p, apol_netcon_index_t * idx)
+{
+	qpol_iterator_t *iter = NULL;
+	size_t n, i, lo, hi;
+	int retval = -1;
+	if (qpol_policy_get_portcon_iter(p->p, &iter) < 0 || qpol_iterator_get_size(iter, &n) < 0) {
+		goto cleanup;
+	}
+	if (n > 0 && (idx->ports = calloc(n, sizeof(*idx->ports))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	for (i = 0; !qpol_iterator_end(iter) && i < n; qpol_iterator_next(iter), i++) {
+		qpol_portcon_t *portcon;
+		portcon_entry_t *e = idx->ports + i;
+		if (qpol_iterator_get_item(iter, (void **)&portcon) < 0 ||
+		    qpol_portcon_get_protocol(p->p, portcon, &e->proto) < 0 ||
+		    qpol_portcon_get_low_port(p->p, portcon, &e->low) < 0 || qpol_portcon_get_high_port(p->p, portcon, &e->high) < 0) {
+			goto cleanup;
+		}
+		e->order = i;
+		e->portcon = portcon;
+	}
+	idx->num_ports = i;
+	qsort(idx->ports, idx->num_ports, sizeof(*idx->ports), portcon_entry_comp);
+	for (lo = 0; lo < idx->num_ports; lo = hi) {
+		for (hi = lo + 1; hi < idx->num_ports && idx->ports[hi].proto == idx->ports[lo].proto; hi++) ;
+		portcon_tree_build(idx->ports, lo, hi);
+	}
+	retval = 0;
+      cleanup:
+	qpol_iterator_destroy(&iter);
+	return retval;
+}
+
+/**
+ * Return bit i of an address in qpol byte order, counting from the
+ * most significant bit of the first byte.
+ */
+static int netcon_addr_bit(const uint32_t * addr, size_t i)
+{
+	const unsigned char *b = (const unsigned char *)addr;
+	return (b[i / 8] >> (7 - i % 8)) & 1;
+}
+
+/**
+ * Determine the prefix length of a netmask.
+ *
+ * @return Number of leading one bits, or -1 if the mask has a one
+ * bit after its first zero bit.
+ */
+static int netcon_mask_prefix(const uint32_t * mask, size_t bits)
+{
+	size_t i, len = 0;
+	while (len < bits && netcon_addr_bit(mask, len))
+		len++;
+	for (i = len; i < bits; i++) {
+		if (netcon_addr_bit(mask, i))
+			return -1;
+	}
+	return (int)len;
+}
+
+static size_t netcon_popcount(const uint32_t * mask, size_t bits)
+{
+	size_t i, n = 0;
+	for (i = 0; i < bits; i++)
+		n += netcon_addr_bit(mask, i);
+	return n;
+}
+
+/**
+ * Determine if an address falls within a nodecon's network, as the
+ * kernel does: the address masked by the netmask must equal the
+ * nodecon's address.
+ */
+static int netcon_addr_match(const uint32_t * addr, const uint32_t * naddr, const uint32_t * mask, size_t bits)
+{
+	size_t i;
+	for (i = 0; i < bits / 32; i++) {
+		if ((addr[i] & mask[i]) != naddr[i])
+			return 0;
+	}
+	return 1;
+}
+
+static int nodecon_trie_new_node(nodecon_trie_t * t, size_t * node)
+{
+	if (t->num_nodes >= t->cap_nodes) {
+		size_t new_cap = (t->cap_nodes == 0 ? 64 : t->cap_nodes * 2);
+		nodecon_trie_node_t *n;
+		if ((n = realloc(t->nodes, new_cap * sizeof(*n))) == NULL) {
+			return -1;
+		}
+		t->nodes = n;
+		t->cap_nodes = new_cap;
+	}
+	memset(t->nodes + t->num_nodes, 0, sizeof(*t->nodes));
+	*node = t->num_nodes++;
+	return 0;
+}
+
+/**
+ * Add a nodecon's prefix to a trie.  If another nodecon already has
+ * the same prefix then the earlier one is kept, for the kernel uses
+ * the first match.
+ */
+static int nodecon_trie_insert(nodecon_trie_t * t, const uint32_t * addr, size_t len, const qpol_nodecon_t * nodecon, size_t order)
+{
+	size_t i, node = 0, next;
+	if (t->num_nodes == 0 && nodecon_trie_new_node(t, &node) < 0) {
+		return -1;
+	}
+	for (i = 0; i < len; i++) {
+		int bit = netcon_addr_bit(addr, i);
+		if ((next = t->nodes[node].child[bit]) == 0) {
+			if (nodecon_trie_new_node(t, &next) < 0) {
+				return -1;
+			}
+			t->nodes[node].child[bit] = next;
+		}
+		node = next;
+	}
+	if (t->nodes[node].nodecon == NULL) {
+		t->nodes[node].nodecon = nodecon;
+		t->nodes[node].order = order;
+	}
+	return 0;
+}
+
+/**
+ * Find the longest prefix within a trie that contains an address.
+ *
+ * @return The deepest matching node, or NULL if none matched.
+ */
+static const nodecon_trie_node_t *nodecon_trie_lookup(const nodecon_trie_t * t, const uint32_t * addr, size_t bits, size_t * len)
+{
+	const nodecon_trie_node_t *best = NULL;
+	size_t i, node = 0;
+	if (t->num_nodes == 0)
+		return NULL;
+	for (i = 0;; i++) {
+		if (t->nodes[node].nodecon != NULL) {
+			best = t->nodes + node;
+			*len = i;
+		}
+		if (i >= bits || (node = t->nodes[node].child[netcon_addr_bit(addr, i)]) == 0)
+			break;
+	}
+	return best;
+}
+
+static int netcon_index_add_nodecons(const apol_policy_t * p, apol_netcon_index_t * idx)
+{
+	qpol_iterator_t *iter = NULL;
+	qpol_nodecon_t *nodecon = NULL;
+	size_t order;
+	int retval = -1, prefix;
+	if (qpol_policy_get_nodecon_iter(p->p, &iter) < 0) {
+		return -1;
+	}
+	if ((idx->nodecons = apol_vector_create(free)) == NULL || (idx->odd_nodecons = apol_vector_create(free)) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	for (order = 0; !qpol_iterator_end(iter); qpol_iterator_next(iter), order++) {
+		unsigned char proto, proto_a, proto_m;
+		uint32_t *addr, *mask;
+		size_t bits;
+		if (qpol_iterator_get_item(iter, (void **)&nodecon) < 0) {
+			goto cleanup;
+		}
+		if (apol_vector_append(idx->nodecons, nodecon) < 0) {
+			ERR(p, "%s", strerror(errno));
+			free(nodecon);
+			goto cleanup;
+		}
+		if (qpol_nodecon_get_protocol(p->p, nodecon, &proto) < 0 ||
+		    qpol_nodecon_get_addr(p->p, nodecon, &addr, &proto_a) < 0 ||
+		    qpol_nodecon_get_mask(p->p, nodecon, &mask, &proto_m) < 0) {
+			goto cleanup;
+		}
+		if (proto != QPOL_IPV4 && proto != QPOL_IPV6) {
+			continue;
+		}
+		bits = (proto == QPOL_IPV4 ? NETCON_IPV4_BITS : NETCON_IPV6_BITS);
+		/* an address with bits outside of its mask can never match */
+		if (!netcon_addr_match(addr, addr, mask, bits)) {
+			continue;
+		}
+		if ((prefix = netcon_mask_prefix(mask, bits)) < 0) {
+			nodecon_odd_t *odd;
+			if ((odd = malloc(sizeof(*odd))) == NULL) {
+				ERR(p, "%s", strerror(errno));
+				goto cleanup;
+			}
+			odd->nodecon = nodecon;
+			odd->proto = proto;
+			odd->addr = addr;
+			odd->mask = mask;
+			odd->len = netcon_popcount(mask, bits);
+			odd->order = order;
+			if (apol_vector_append(idx->odd_nodecons, odd) < 0) {
+				ERR(p, "%s", strerror(errno));
+				free(odd);
+				goto cleanup;
+			}
+		} else if (nodecon_trie_insert(idx->tries + proto, addr, (size_t)prefix, nodecon, order) < 0) {
+			ERR(p, "%s", strerror(errno));
+			goto cleanup;
+		}
+	}
+	retval = 0;
+      cleanup:
+	qpol_iterator_destroy(&iter);
+	return retval;
+}
+
+void netcon_index_destroy(apol_netcon_index_t ** idx)
+{
+	if (!idx || !(*idx))
+		return;
+	free((*idx)->ports);
+	free((*idx)->tries[QPOL_IPV4].nodes);
+	free((*idx)->tries[QPOL_IPV6].nodes);
+	apol_vector_destroy(&(*idx)->odd_nodecons);
+	apol_vector_destroy(&(*idx)->nodecons);
+	free(*idx);
+	*idx = NULL;
+}
+
+void netcon_index_get_memory_usage(const apol_netcon_index_t * idx, apol_memory_usage_t * usage)
+{
+	size_t i;
+	if (!idx)
+		return;
+	usage->bytes += sizeof(*idx) + idx->num_ports * sizeof(*idx->ports);
+	for (i = 0; i < 2; i++) {
+		usage->bytes += idx->tries[i].cap_nodes * sizeof(*idx->tries[i].nodes);
+	}
+	usage->bytes += vector_get_footprint(idx->odd_nodecons) + apol_vector_get_size(idx->odd_nodecons) * sizeof(nodecon_odd_t);
+	usage->bytes += vector_get_footprint(idx->nodecons);
+	usage->count += idx->num_ports + apol_vector_get_size(idx->nodecons);
+}
+
+int apol_policy_build_netcon_index(apol_policy_t * p)
+{
+	apol_netcon_index_t *idx = NULL;
+	if (!p) {
+		errno = EINVAL;
+		return -1;
+	}
+	apol_policy_check_rebuild(p);
+	if (p->netcon_index != NULL) {
+		return 0;
+	}
+	if ((idx = calloc(1, sizeof(*idx))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		return -1;
+	}
+	if (netcon_index_add_portcons(p, idx) < 0 || netcon_index_add_nodecons(p, idx) < 0) {
+		int error = errno;
+		netcon_index_destroy(&idx);
+		errno = error;
+		return -1;
+	}
+	p->netcon_index = idx;
+	return 0;
+}
+
+int apol_portcon_lookup(apol_policy_t * p, uint8_t proto, uint16_t port, const qpol_portcon_t ** portcon)
+{
+	return apol_portcon_lookup_batch(p, &proto, &port, 1, portcon);
+}
+
+int apol_portcon_lookup_batch(apol_policy_t * p, const uint8_t * protos, const uint16_t * ports, size_t num,
+			      const qpol_portcon_t ** portcons)
+{
+	const apol_netcon_index_t *idx;
+	size_t i, lo = 0, hi = 0;
+	if (!p || (num > 0 && (!protos || !ports || !portcons))) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	if (apol_policy_build_netcon_index(p) < 0) {
+		return -1;
+	}
+	idx = p->netcon_index;
+	for (i = 0; i < num; i++) {
+		const portcon_entry_t *best = NULL;
+		/* observed tuples tend to arrive grouped by protocol, so
+		 * reuse the previous protocol's range when possible */
+		if (i == 0 || protos[i] != protos[i - 1]) {
+			portcon_proto_range(idx, protos[i], &lo, &hi);
+		}
+		portcon_tree_stab(idx->ports, lo, hi, ports[i], &best);
+		portcons[i] = (best == NULL ? NULL : best->portcon);
+	}
+	return 0;
+}
+
+int apol_nodecon_lookup(apol_policy_t * p, int proto, const uint32_t * addr, const qpol_nodecon_t ** nodecon)
+{
+	return apol_nodecon_lookup_batch(p, &proto, addr, 1, nodecon);
+}
+
+int apol_nodecon_lookup_batch(apol_policy_t * p, const int *protos, const uint32_t * addrs, size_t num,
+			      const qpol_nodecon_t ** nodecons)
+{
+	const apol_netcon_index_t *idx;
+	size_t i, j;
+	if (!p || (num > 0 && (!protos || !addrs || !nodecons))) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	for (i = 0; i < num; i++) {
+		if (protos[i] != QPOL_IPV4 && protos[i] != QPOL_IPV6) {
+			ERR(p, "%s", strerror(EINVAL));
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	if (apol_policy_build_netcon_index(p) < 0) {
+		return -1;
+	}
+	idx = p->netcon_index;
+	for (i = 0; i < num; i++) {
+		const uint32_t *addr = addrs + 4 * i;
+		size_t bits = (protos[i] == QPOL_IPV4 ? NETCON_IPV4_BITS : NETCON_IPV6_BITS);
+		size_t best_len = 0, best_order = 0;
+		const nodecon_trie_node_t *node = nodecon_trie_lookup(idx->tries + protos[i], addr, bits, &best_len);
+		nodecons[i] = NULL;
+		if (node != NULL) {
+			nodecons[i] = node->nodecon;
+			best_order = node->order;
+		}
+		/* non-prefix masks are rare; compare them by how many
+		 * mask bits they set */
+		for (j = 0; j < apol_vector_get_size(idx->odd_nodecons); j++) {
+			const nodecon_odd_t *odd = apol_vector_get_element(idx->odd_nodecons, j);
+			if (odd->proto != protos[i] || !netcon_addr_match(addr, odd->addr, odd->mask, bits)) {
+				continue;
+			}
+			if (nodecons[i] == NULL || odd->len > best_len || (odd->len == best_len && odd->order < best_order)) {
+				nodecons[i] = odd->nodecon;
+				best_len = odd->len;
+				best_order = odd->order;
+			}
+		}
+	}
+	return 0;
+}
@@ -24,6 +24,7 @@
  */
 
 #include "policy-query-internal.h"
+#include "vector-internal.h"
 
 #include <apol/perm-map.h>
 
@@ -248,6 +249,23 @@ void permmap_destroy(apol_permmap_t ** p)
 	*p = NULL;
 }
 
+void permmap_get_memory_usage(const apol_permmap_t * pmap, apol_memory_usage_t * usage)
+{
+	size_t i, j;
+	if (pmap == NULL)
+		return;
+	usage->bytes += sizeof(*pmap) + vector_get_footprint(pmap->classes);
+	for (i = 0; i < apol_vector_get_size(pmap->classes); i++) {
+		const apol_permmap_class_t *pc = apol_vector_get_element(pmap->classes, i);
+		usage->bytes += sizeof(*pc) + vector_get_footprint(pc->perms);
+		for (j = 0; j < apol_vector_get_size(pc->perms); j++) {
+			const apol_permmap_perm_t *pp = apol_vector_get_element(pc->perms, j);
+			usage->bytes += sizeof(*pp) + strlen(pp->name) + 1;
+		}
+		usage->count += apol_vector_get_size(pc->perms);
+	}
+}
+
 /**
  * Searches through the permission map within a policy, returning the
  * record for a given object class.
@@ -35,6 +35,7 @@ extern "C"
 
 #include <config.h>
 
+#include <apol/budget.h>
 #include <apol/policy.h>
 #include <apol/policy-query.h>
 #include <apol/util.h>
@@ -50,6 +51,18 @@ extern "C"
 /* forward declaration. the definition resides within domain-trans-analysis.c */
 	typedef struct apol_domain_trans_table apol_domain_trans_table_t;
 
+/* forward declaration. the definition resides within netcon-query.c */
+	typedef struct apol_netcon_index apol_netcon_index_t;
+
+/* forward declaration. the definition resides within constraint-query.c */
+	typedef struct apol_constraint_program apol_constraint_program_t;
+
+/* forward declaration. the definition resides within relabel-analysis.c */
+	typedef struct apol_relabel_index apol_relabel_index_t;
+
+/* forward declaration. the definition resides within compute-av.c */
+	typedef struct apol_avc apol_avc_t;
+
 /* declared in perm-map.c */
 	typedef struct apol_permmap apol_permmap_t;
 
@@ -63,6 +76,18 @@ extern "C"
 		struct apol_permmap *pmap;
 	/** for domain trans analysis; table built as needed */
 		struct apol_domain_trans_table *domain_trans_table;
+	/** for portcon and nodecon lookups; index built as needed */
+		struct apol_netcon_index *netcon_index;
+	/** for constraint evaluation; compiled as needed */
+		struct apol_constraint_program *constraint_program;
+	/** cache of computed access vectors; created as needed */
+		struct apol_avc *avc;
+	/** for relabel analysis; index built as needed */
+		struct apol_relabel_index *relabel_index;
+	/** rebuild sequence number of p when the netcon index,
+	 *  constraint program, access vector cache, and relabel index
+	 *  were made */
+		unsigned int rebuild_seqno;
 	};
 
 /** Every query allows the treatment of strings as regular expressions
@@ -83,6 +108,10 @@ extern "C"
 
 #define APOL_QUERY_MATCH_ALL_PERMS 0x1000
 
+/** Number of items fetched at a time by queries that walk qpol
+ *  iterators with qpol_iterator_next_batch(). */
+#define APOL_QUERY_ITER_BATCH 256
+
 /**
  * Destroy a compiled regular expression, setting it to NULL
  * afterwards.	Does nothing if the reference is NULL.
@@ -523,6 +552,174 @@ extern "C"
  */
 	void domain_trans_table_destroy(apol_domain_trans_table_t ** table);
 
+/**
+ *  Destroy a policy's portcon and nodecon lookup index, freeing all
+ *  memory used.
+ *  @param idx Reference pointer to the index to be destroyed.
+ */
+	void netcon_index_destroy(apol_netcon_index_t ** idx);
+
+/**
+ *  Destroy a policy's compiled constraints, freeing all memory used.
+ *  @param prog Reference pointer to the program to be destroyed.
+ */
+	void constraint_program_destroy(apol_constraint_program_t ** prog);
+
+/** number of integers written by constraint_program_resolve_context() */
+#define CONSTRAINT_KEY_SIZE 5
+
+/**
+ *  Resolve a context into the policy's compiled constraints, as the
+ *  source or target of subsequent calls to
+ *  constraint_program_denied().  The constraints are compiled first
+ *  if needed.
+ *  @param p Policy whose constraints to use.
+ *  @param context Context to resolve.  It must have a user, role,
+ *  and type, and if the policy is MLS a range whose levels are not
+ *  literal.
+ *  @param is_target Non-zero to resolve the target context, zero
+ *  for the source.
+ *  @param key Array of CONSTRAINT_KEY_SIZE integers to which to write
+ *  a key for the context.  Contexts with equal keys are
+ *  indistinguishable to the policy's rules and constraints.
+ *  @return 0 on success, < 0 on error.
+ */
+	int constraint_program_resolve_context(apol_policy_t * p, const apol_context_t * context, int is_target, uint32_t * key);
+
+/**
+ *  Evaluate a class's constraints against the source and target
+ *  contexts last given to constraint_program_resolve_context().
+ *  @param p Policy whose constraints to use.
+ *  @param class_value Value of the class.
+ *  @param requested Access vector of permissions to check.
+ *  @return Access vector of the requested permissions that the
+ *  constraints deny.
+ */
+	uint32_t constraint_program_denied(const apol_policy_t * p, uint32_t class_value, uint32_t requested);
+
+/**
+ *  Destroy a policy's relabel rule index, freeing all memory used.
+ *  @param idx Reference pointer to the index to be destroyed.
+ */
+	void relabel_index_destroy(apol_relabel_index_t ** idx);
+
+/**
+ *  Destroy a policy's access vector cache, freeing all memory used.
+ *  @param avc Reference pointer to the cache to be destroyed.
+ */
+	void avc_destroy(apol_avc_t ** avc);
+
+/**
+ *  Discard the netcon index, constraint program, access vector
+ *  cache, and relabel index if the qpol policy has been rebuilt since
+ *  they were made, for they refer to the items of the old policy.
+ *  Call this before using any of them.
+ *  @param p Policy whose caches to check.
+ */
+	void apol_policy_check_rebuild(apol_policy_t * p);
+
+/**
+ *  Add the memory used by a policy's permission map to a running
+ *  total.  The count is the number of mapped permissions.
+ *  @param pmap Permission map to examine, or NULL if not loaded.
+ *  @param usage Total to which to add.
+ */
+	void permmap_get_memory_usage(const apol_permmap_t * pmap, apol_memory_usage_t * usage);
+
+/**
+ *  Add the memory used by a domain transition table to a running
+ *  total.  The count is the number of rules within the table.
+ *  @param table Table to examine, or NULL if not built.
+ *  @param usage Total to which to add.
+ */
+	void domain_trans_table_get_memory_usage(const apol_domain_trans_table_t * table, apol_memory_usage_t * usage);
+
+/**
+ *  Add the memory used by a netcon index to a running total.  The
+ *  count is the number of portcons and nodecons indexed.
+ *  @param idx Index to examine, or NULL if not built.
+ *  @param usage Total to which to add.
+ */
+	void netcon_index_get_memory_usage(const apol_netcon_index_t * idx, apol_memory_usage_t * usage);
+
+/**
+ *  Add the memory used by a constraint program to a running total.
+ *  The count is the number of compiled constraints and
+ *  validatetrans statements.
+ *  @param prog Program to examine, or NULL if not compiled.
+ *  @param usage Total to which to add.
+ */
+	void constraint_program_get_memory_usage(const apol_constraint_program_t * prog, apol_memory_usage_t * usage);
+
+/**
+ *  Add the memory used by a relabel index to a running total.  The
+ *  count is the number of indexed rules.
+ *  @param idx Index to examine, or NULL if not built.
+ *  @param usage Total to which to add.
+ */
+	void relabel_index_get_memory_usage(const apol_relabel_index_t * idx, apol_memory_usage_t * usage);
+
+/**
+ *  Add the memory used by an access vector cache to a running total.
+ *  The count is the number of cached decisions.
+ *  @param avc Cache to examine, or NULL if not created.
+ *  @param usage Total to which to add.
+ */
+	void avc_get_memory_usage(const apol_avc_t * avc, apol_memory_usage_t * usage);
+
+/**
+ *  Begin a phase of work within the policy's stats object.  Unlike
+ *  qpol_stats_begin(), failures are ignored and errno is preserved.
+ *  @param p Policy doing the work, or NULL to do nothing.
+ *  @param name Name of the phase; a string literal.
+ *  @return Number of phases open before this one, to be passed to
+ *  apol_stats_end().
+ */
+	size_t apol_stats_begin(const apol_policy_t * p, const char *name);
+
+/**
+ *  End the phase begun by apol_stats_begin(), along with any phases
+ *  left open within it.  errno is preserved.
+ *  @param p Policy doing the work, or NULL to do nothing.
+ *  @param depth Value returned by apol_stats_begin().
+ */
+	void apol_stats_end(const apol_policy_t * p, size_t depth);
+
+/**
+ *  Add to a counter of the innermost phase of the policy's stats.
+ *  @param p Policy doing the work, or NULL to do nothing.
+ *  @param counter Counter to increase.
+ *  @param n Amount to add.
+ */
+	void apol_stats_add(const apol_policy_t * p, qpol_stats_counter_e counter, size_t n);
+
+/**
+ *  Begin a call that is limited by a budget, resetting the budget's
+ *  clock and counts.
+ *  @param budget Budget limiting the call, or NULL to do nothing.
+ *  @param num_results Number of results already held by the vector
+ *  to which the call appends its results.
+ */
+	void apol_budget_begin(apol_budget_t * budget, size_t num_results);
+
+/**
+ *  Count nodes expanded by the current call.
+ *  @param budget Budget limiting the call, or NULL to do nothing.
+ *  @param n Number of nodes expanded.
+ */
+	void apol_budget_add_nodes(apol_budget_t * budget, size_t n);
+
+/**
+ *  Determine if the current call has spent its budget.  Searches call
+ *  this after each unit of work, so that every call makes progress.
+ *  @param budget Budget limiting the call, or NULL for no limit.
+ *  @param num_results Number of results now held by the vector to
+ *  which the call appends its results.
+ *  @return Non-zero if any limit was reached, 0 if the call may
+ *  continue.
+ */
+	int apol_budget_is_spent(apol_budget_t * budget, size_t num_results);
+
 #ifdef	__cplusplus
 }
 #endif
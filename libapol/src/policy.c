@@ -31,10 +31,24 @@
 #include <qpol/policy.h>
 #include <qpol/policy_extend.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+/** memory usage categories that libapol reports after libqpol's */
+enum apol_memory_category
+{
+	APOL_MEMORY_PERMMAP = 0,
+	APOL_MEMORY_DOMAIN_TRANS_TABLE,
+	APOL_MEMORY_NETCON_INDEX,
+	APOL_MEMORY_CONSTRAINT_PROGRAM,
+	APOL_MEMORY_AVC,
+	APOL_MEMORY_RELABEL_INDEX,
+	APOL_MEMORY_NUM_CATEGORIES
+};
 
 static void apol_handle_default_callback(void *varg __attribute__ ((unused)), const apol_policy_t * p
 					 __attribute__ ((unused)), int level, const char *fmt, va_list va_args)
@@ -72,6 +86,131 @@ static void qpol_handle_route_to_callback(void *varg, const qpol_policy_t * poli
 	}
 }
 
+/** modules being loaded by policy_load_modules() */
+struct policy_module_load
+{
+	/** vector of module paths (char *) */
+	const apol_vector_t *paths;
+	/** array of loaded modules, one per path */
+	qpol_module_t **mods;
+	/** array of errnos, one per path, or 0 if that module loaded */
+	int *errors;
+	/** index of the next module to load */
+	size_t next;
+	pthread_mutex_t lock;
+};
+
+static void *policy_load_modules_thread(void *arg)
+{
+	struct policy_module_load *load = arg;
+	size_t i;
+	for (;;) {
+		pthread_mutex_lock(&load->lock);
+		i = load->next++;
+		pthread_mutex_unlock(&load->lock);
+		if (i >= apol_vector_get_size(load->paths)) {
+			break;
+		}
+		if (qpol_module_create_from_file(apol_vector_get_element(load->paths, i), load->mods + i)) {
+			load->errors[i] = (errno != 0 ? errno : EIO);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Load module packages and append them to a modular policy.  Each
+ * package is read and parsed independently, so they are loaded
+ * concurrently, one thread per online processor.  Modules are then
+ * appended in the order given, regardless of the order in which they
+ * finished loading.
+ *
+ * @param policy Policy to which to append modules.
+ * @param paths Vector of module package paths (char *).
+ *
+ * @return 0 on success, < 0 on error.  Every module that could not be
+ * loaded is reported, and no modules are appended.
+ */
+static int policy_load_modules(apol_policy_t * policy, const apol_vector_t * paths)
+{
+	struct policy_module_load load;
+	pthread_t *threads = NULL;
+	size_t num_modules = apol_vector_get_size(paths), num_threads, num_started = 0, i, depth;
+	long ncpu;
+	int error = 0, retval = -1;
+
+	depth = apol_stats_begin(policy, "load modules");
+	memset(&load, 0, sizeof(load));
+	load.paths = paths;
+	if ((load.mods = calloc(num_modules + 1, sizeof(*load.mods))) == NULL ||
+	    (load.errors = calloc(num_modules + 1, sizeof(*load.errors))) == NULL) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		goto cleanup;
+	}
+	if (pthread_mutex_init(&load.lock, NULL) != 0) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		goto cleanup;
+	}
+	for (i = 0; i < num_modules; i++) {
+		INFO(policy, "Loading module %s.", (char *)apol_vector_get_element(paths, i));
+	}
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	num_threads = (ncpu > 0 ? (size_t)ncpu : 1);
+	if (num_threads > num_modules) {
+		num_threads = num_modules;
+	}
+	/* if a thread cannot be created then the remaining threads take
+	 * up its share of the modules */
+	if (num_threads > 1 && (threads = calloc(num_threads - 1, sizeof(*threads))) != NULL) {
+		for (; num_started < num_threads - 1; num_started++) {
+			if (pthread_create(threads + num_started, NULL, policy_load_modules_thread, &load) != 0) {
+				break;
+			}
+		}
+	}
+	policy_load_modules_thread(&load);
+	for (i = 0; i < num_started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&load.lock);
+
+	for (i = 0; i < num_modules; i++) {
+		if (load.errors[i] != 0) {
+			ERR(policy, "Error loading module %s: %s", (char *)apol_vector_get_element(paths, i),
+			    strerror(load.errors[i]));
+			if (error == 0) {
+				error = load.errors[i];
+			}
+		}
+	}
+	if (error != 0) {
+		goto cleanup;
+	}
+	for (i = 0; i < num_modules; i++) {
+		if (qpol_policy_append_module(policy->p, load.mods[i])) {
+			error = errno;
+			ERR(policy, "Error loading module %s.", (char *)apol_vector_get_element(paths, i));
+			goto cleanup;
+		}
+		/* the policy now owns the module */
+		load.mods[i] = NULL;
+	}
+
+	retval = 0;
+      cleanup:
+	for (i = 0; load.mods != NULL && i < num_modules; i++) {
+		qpol_module_destroy(load.mods + i);
+	}
+	free(load.mods);
+	free(load.errors);
+	free(threads);
+	apol_stats_end(policy, depth);
+	errno = error;
+	return retval;
+}
+
 apol_policy_t *apol_policy_create_from_policy_path(const apol_policy_path_t * path, const int options,
 						   apol_callback_fn_t msg_callback, void *varg)
 {
@@ -108,23 +247,11 @@ apol_policy_t *apol_policy_create_from_policy_path(const apol_policy_path_t * pa
 			INFO(policy, "%s is not a base policy.", primary_path);
 			return policy;
 		}
-		const apol_vector_t *modules = apol_policy_path_get_modules(path);
-		size_t i;
-		for (i = 0; i < apol_vector_get_size(modules); i++) {
-			const char *module_path = apol_vector_get_element(modules, i);
-			qpol_module_t *mod = NULL;
-			INFO(policy, "Loading module %s.", module_path);
-			if (qpol_module_create_from_file(module_path, &mod)) {
-				ERR(policy, "Error loading module %s.", module_path);
-				apol_policy_destroy(&policy);
-				return NULL;
-			}
-			if (qpol_policy_append_module(policy->p, mod)) {
-				ERR(policy, "Error loading module %s.", module_path);
-				apol_policy_destroy(&policy);
-				qpol_module_destroy(&mod);
-				return NULL;
-			}
+		if (policy_load_modules(policy, apol_policy_path_get_modules(path)) < 0) {
+			int error = errno;
+			apol_policy_destroy(&policy);
+			errno = error;
+			return NULL;
 		}
 		INFO(policy, "%s", "Linking modules into base policy.");
 		if (qpol_policy_rebuild(policy->p, options)) {
@@ -141,11 +268,28 @@ void apol_policy_destroy(apol_policy_t ** policy)
 		qpol_policy_destroy(&((*policy)->p));
 		permmap_destroy(&(*policy)->pmap);
 		domain_trans_table_destroy(&(*policy)->domain_trans_table);
+		netcon_index_destroy(&(*policy)->netcon_index);
+		constraint_program_destroy(&(*policy)->constraint_program);
+		avc_destroy(&(*policy)->avc);
+		relabel_index_destroy(&(*policy)->relabel_index);
 		free(*policy);
 		*policy = NULL;
 	}
 }
 
+void apol_policy_check_rebuild(apol_policy_t * p)
+{
+	unsigned int seqno;
+	if (qpol_policy_get_rebuild_seqno(p->p, &seqno) < 0 || seqno == p->rebuild_seqno) {
+		return;
+	}
+	netcon_index_destroy(&p->netcon_index);
+	constraint_program_destroy(&p->constraint_program);
+	avc_destroy(&p->avc);
+	relabel_index_destroy(&p->relabel_index);
+	p->rebuild_seqno = seqno;
+}
+
 int apol_policy_get_policy_type(const apol_policy_t * policy)
 {
 	if (policy == NULL) {
@@ -173,6 +317,46 @@ qpol_policy_t *apol_policy_get_qpol(const apol_policy_t * policy)
 	return policy->p;
 }
 
+qpol_stats_t *apol_policy_get_stats(const apol_policy_t * policy)
+{
+	if (policy == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return qpol_policy_get_stats(policy->p);
+}
+
+size_t apol_stats_begin(const apol_policy_t * p, const char *name)
+{
+	qpol_stats_t *stats;
+	size_t depth;
+	int error = errno;
+	if (p == NULL) {
+		return 0;
+	}
+	stats = qpol_policy_get_stats(p->p);
+	depth = qpol_stats_get_depth(stats);
+	qpol_stats_begin(stats, name);
+	errno = error;
+	return depth;
+}
+
+void apol_stats_end(const apol_policy_t * p, size_t depth)
+{
+	int error = errno;
+	if (p != NULL) {
+		qpol_stats_end_to(qpol_policy_get_stats(p->p), depth);
+	}
+	errno = error;
+}
+
+void apol_stats_add(const apol_policy_t * p, qpol_stats_counter_e counter, size_t n)
+{
+	if (p != NULL) {
+		qpol_stats_add(qpol_policy_get_stats(p->p), counter, n);
+	}
+}
+
 int apol_policy_is_mls(const apol_policy_t * p)
 {
 	if (p == NULL) {
@@ -213,6 +397,73 @@ char *apol_policy_get_version_type_mls_str(const apol_policy_t * p)
 	return strdup(buf);
 }
 
+apol_vector_t *apol_policy_get_memory_usage(const apol_policy_t * p)
+{
+	qpol_memory_usage_t qusage[QPOL_MEMORY_NUM_CATEGORIES];
+	apol_memory_usage_t *u = NULL;
+	apol_vector_t *v = NULL;
+	size_t i;
+	int error = 0;
+	if (p == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (qpol_policy_get_memory_usage(p->p, qusage) < 0) {
+		return NULL;
+	}
+	if ((v = apol_vector_create_with_capacity(QPOL_MEMORY_NUM_CATEGORIES + APOL_MEMORY_NUM_CATEGORIES, free)) == NULL) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
+		goto err;
+	}
+	for (i = 0; i < QPOL_MEMORY_NUM_CATEGORIES + APOL_MEMORY_NUM_CATEGORIES; i++) {
+		if ((u = calloc(1, sizeof(*u))) == NULL || apol_vector_append(v, u) < 0) {
+			error = errno;
+			ERR(p, "%s", strerror(error));
+			free(u);
+			goto err;
+		}
+		if (i < QPOL_MEMORY_NUM_CATEGORIES) {
+			u->name = qpol_memory_category_get_name(i);
+			u->bytes = qusage[i].bytes;
+			u->count = qusage[i].count;
+			continue;
+		}
+		switch ((enum apol_memory_category)(i - QPOL_MEMORY_NUM_CATEGORIES)) {
+		case APOL_MEMORY_PERMMAP:
+			u->name = "permission map";
+			permmap_get_memory_usage(p->pmap, u);
+			break;
+		case APOL_MEMORY_DOMAIN_TRANS_TABLE:
+			u->name = "domain transition table";
+			domain_trans_table_get_memory_usage(p->domain_trans_table, u);
+			break;
+		case APOL_MEMORY_NETCON_INDEX:
+			u->name = "netcon index";
+			netcon_index_get_memory_usage(p->netcon_index, u);
+			break;
+		case APOL_MEMORY_CONSTRAINT_PROGRAM:
+			u->name = "constraint program";
+			constraint_program_get_memory_usage(p->constraint_program, u);
+			break;
+		case APOL_MEMORY_AVC:
+			u->name = "access vector cache";
+			avc_get_memory_usage(p->avc, u);
+			break;
+		case APOL_MEMORY_RELABEL_INDEX:
+		default:
+			u->name = "relabel index";
+			relabel_index_get_memory_usage(p->relabel_index, u);
+			break;
+		}
+	}
+	return v;
+      err:
+	apol_vector_destroy(&v);
+	errno = error;
+	return NULL;
+}
+
 void apol_handle_msg(const apol_policy_t * p, int level, const char *fmt, ...)
 {
 	va_list ap;
@@ -232,34 +232,32 @@ int apol_range_trans_query_set_regex(const apol_policy_t * p, apol_range_trans_q
 	return apol_query_set_regex(p, &r->flags, is_regex);
 }
 
-char *apol_range_trans_render(const apol_policy_t * policy, const qpol_range_trans_t * rule)
+int apol_range_trans_render_to_sink(const apol_policy_t * policy, const qpol_range_trans_t * rule, apol_render_sink_t * sink)
 {
-	char *tmp = NULL;
 	const char *tmp_name = NULL;
 	int error = 0;
-	size_t tmp_sz = 0;
 	const qpol_type_t *type = NULL;
 	const qpol_class_t *target_class = NULL;
 	const qpol_mls_range_t *range = NULL;
 	apol_mls_range_t *arange = NULL;
 
-	if (!policy || !rule) {
+	if (!policy || !rule || !sink) {
 		ERR(policy, "%s", strerror(EINVAL));
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 
 	/* range_transition */
-	if (apol_str_append(&tmp, &tmp_sz, "range_transition ")) {
+	if (apol_render_sink_append(sink, "range_transition ")) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
-		return NULL;
+		return -1;
 	}
 
 	/* source type */
 	if (qpol_range_trans_get_source_type(policy->p, rule, &type) ||
 	    qpol_type_get_name(policy->p, type, &tmp_name) ||
-	    apol_str_append(&tmp, &tmp_sz, tmp_name) || apol_str_append(&tmp, &tmp_sz, " ")) {
+	    apol_render_sink_append(sink, tmp_name) || apol_render_sink_append(sink, " ")) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -268,7 +266,7 @@ char *apol_range_trans_render(const apol_policy_t * policy, const qpol_range_tra
 	/* target type */
 	if (qpol_range_trans_get_target_type(policy->p, rule, &type) ||
 	    qpol_type_get_name(policy->p, type, &tmp_name) ||
-	    apol_str_append(&tmp, &tmp_sz, tmp_name) || apol_str_append(&tmp, &tmp_sz, " : ")) {
+	    apol_render_sink_append(sink, tmp_name) || apol_render_sink_append(sink, " : ")) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -277,7 +275,7 @@ char *apol_range_trans_render(const apol_policy_t * policy, const qpol_range_tra
 	/* target class */
 	if (qpol_range_trans_get_target_class(policy->p, rule, &target_class) ||
 	    qpol_class_get_name(policy->p, target_class, &tmp_name) ||
-	    apol_str_append(&tmp, &tmp_sz, tmp_name) || apol_str_append(&tmp, &tmp_sz, " ")) {
+	    apol_render_sink_append(sink, tmp_name) || apol_render_sink_append(sink, " ")) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -301,18 +299,38 @@ char *apol_range_trans_render(const apol_policy_t * policy, const qpol_range_tra
 		goto err;
 	}
 	apol_mls_range_destroy(&arange);
-	if (apol_str_append(&tmp, &tmp_sz, tmp_range_str) || apol_str_append(&tmp, &tmp_sz, ";")) {
+	if (apol_render_sink_append(sink, tmp_range_str) || apol_render_sink_append(sink, ";")) {
 		free(tmp_range_str);
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
 	}
 	free(tmp_range_str);
-	return tmp;
+	return 0;
 
       err:
 	apol_mls_range_destroy(&arange);
-	free(tmp);
 	errno = error;
-	return NULL;
+	return -1;
+}
+
+char *apol_range_trans_render(const apol_policy_t * policy, const qpol_range_trans_t * rule)
+{
+	apol_render_sink_t *sink = NULL;
+	char *tmp = NULL;
+	int error;
+
+	if ((sink = apol_render_sink_create_buffer()) == NULL) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return NULL;
+	}
+	if (apol_range_trans_render_to_sink(policy, rule, sink) == 0 && (tmp = apol_render_sink_take_string(sink)) == NULL) {
+		ERR(policy, "%s", strerror(errno));
+	}
+	error = errno;
+	apol_render_sink_destroy(&sink);
+	errno = error;
+	return tmp;
 }
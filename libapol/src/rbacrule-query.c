@@ -170,43 +170,63 @@ int apol_role_allow_query_set_regex(const apol_policy_t * p, apol_role_allow_que
 	return apol_query_set_regex(p, &r->flags, is_regex);
 }
 
-char *apol_role_allow_render(const apol_policy_t * policy, const qpol_role_allow_t * rule)
+int apol_role_allow_render_to_sink(const apol_policy_t * policy, const qpol_role_allow_t * rule, apol_render_sink_t * sink)
 {
-	char *tmp = NULL;
 	const char *source_name = NULL, *target_name = NULL;
 	const qpol_role_t *role = NULL;
 
-	if (!policy || !rule) {
+	if (!policy || !rule || !sink) {
 		ERR(policy, "%s", strerror(EINVAL));
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 
 	/* source role */
 	if (qpol_role_allow_get_source_role(policy->p, rule, &role)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 	if (qpol_role_get_name(policy->p, role, &source_name)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 
 	/* target role */
 	if (qpol_role_allow_get_target_role(policy->p, rule, &role)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 	if (qpol_role_get_name(policy->p, role, &target_name)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 
-	if (asprintf(&tmp, "allow %s %s;", source_name, target_name) < 0) {
+	if (apol_render_sink_appendf(sink, "allow %s %s;", source_name, target_name) < 0) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 
+	return 0;
+}
+
+char *apol_role_allow_render(const apol_policy_t * policy, const qpol_role_allow_t * rule)
+{
+	apol_render_sink_t *sink = NULL;
+	char *tmp = NULL;
+	int error;
+
+	if ((sink = apol_render_sink_create_buffer()) == NULL) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return NULL;
+	}
+	if (apol_role_allow_render_to_sink(policy, rule, sink) == 0 && (tmp = apol_render_sink_take_string(sink)) == NULL) {
+		ERR(policy, "%s", strerror(errno));
+	}
+	error = errno;
+	apol_render_sink_destroy(&sink);
+	errno = error;
 	return tmp;
 }
 
@@ -366,52 +386,72 @@ int apol_role_trans_query_set_regex(const apol_policy_t * p, apol_role_trans_que
 	return apol_query_set_regex(p, &r->flags, is_regex);
 }
 
-char *apol_role_trans_render(const apol_policy_t * policy, const qpol_role_trans_t * rule)
+int apol_role_trans_render_to_sink(const apol_policy_t * policy, const qpol_role_trans_t * rule, apol_render_sink_t * sink)
 {
-	char *tmp = NULL;
 	const char *source_name = NULL, *target_name = NULL, *default_name = NULL;
 	const qpol_role_t *role = NULL;
 	const qpol_type_t *type = NULL;
 
-	if (!policy || !rule) {
+	if (!policy || !rule || !sink) {
 		ERR(policy, "%s", strerror(EINVAL));
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 
 	/* source role */
 	if (qpol_role_trans_get_source_role(policy->p, rule, &role)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 	if (qpol_role_get_name(policy->p, role, &source_name)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 
 	/* target type */
 	if (qpol_role_trans_get_target_type(policy->p, rule, &type)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 	if (qpol_type_get_name(policy->p, type, &target_name)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 
 	/* default role */
 	if (qpol_role_trans_get_default_role(policy->p, rule, &role)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 	if (qpol_role_get_name(policy->p, role, &default_name)) {
 		ERR(policy, "%s", strerror(errno));
-		return NULL;
+		return -1;
 	}
 
-	if (asprintf(&tmp, "role_transition %s %s %s;", source_name, target_name, default_name) < 0) {
+	if (apol_render_sink_appendf(sink, "role_transition %s %s %s;", source_name, target_name, default_name) < 0) {
 		ERR(policy, "%s", strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+char *apol_role_trans_render(const apol_policy_t * policy, const qpol_role_trans_t * rule)
+{
+	apol_render_sink_t *sink = NULL;
+	char *tmp = NULL;
+	int error;
+
+	if ((sink = apol_render_sink_create_buffer()) == NULL) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
 		return NULL;
 	}
+	if (apol_role_trans_render_to_sink(policy, rule, sink) == 0 && (tmp = apol_render_sink_take_string(sink)) == NULL) {
+		ERR(policy, "%s", strerror(errno));
+	}
+	error = errno;
+	apol_render_sink_destroy(&sink);
+	errno = error;
 	return tmp;
 }
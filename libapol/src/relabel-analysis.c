@@ -70,7 +70,8 @@ struct apol_relabel_result_pair
  * @param avrule Rule to examine.
  *
  * @return One of APOL_RELABEL_DIR_TO, APOL_RELABEL_DIR_FROM,
- * APOL_RELABEL_DIR_BOTH, or < 0 if direction could not be determined.
+ * APOL_RELABEL_DIR_BOTH, 0 if the rule grants neither permission, or
+ * < 0 if direction could not be determined.
  */
 static int relabel_analysis_get_direction(const apol_policy_t * p, const qpol_avrule_t * avrule)
 {
@@ -93,6 +94,7 @@ static int relabel_analysis_get_direction(const apol_policy_t * p, const qpol_av
 		free(perm);
 		perm = NULL;
 	}
+	retval = 0;
 	if (to && from) {
 		retval = APOL_RELABEL_DIR_BOTH;
 	} else if (to) {
@@ -269,14 +271,17 @@ static int relabel_analysis_compare_type_to_vector(const apol_policy_t * p, cons
  * @param p Policy containing avrule.
  * @param r Relabel analysis query object, containing filtering options.
  * @param ruleA First AV rule to add.
+ * @param dirA Relabel direction of ruleA.
  * @param ruleB Other AV rule to add.
+ * @param dirB Relabel direction of ruleB.
  * @param result Results vector being built.
  *
  * @return 0 on success, < 0 on error.
  */
 static int append_avrules_to_object_vector(const apol_policy_t * p,
 					   apol_relabel_analysis_t * r,
-					   const qpol_avrule_t * ruleA, const qpol_avrule_t * ruleB, apol_vector_t * results)
+					   const qpol_avrule_t * ruleA, int dirA, const qpol_avrule_t * ruleB, int dirB,
+					   apol_vector_t * results)
 {
 	const qpol_type_t *sourceA, *sourceB, *target, *intermed;
 	unsigned char isattrA, isattrB;
@@ -284,7 +289,7 @@ static int append_avrules_to_object_vector(const apol_policy_t * p,
 	size_t i;
 	apol_relabel_result_t *result;
 	apol_relabel_result_pair_t *pair = NULL;
-	int retval = -1, compval, dirA, dirB;
+	int retval = -1, compval;
 	if (qpol_avrule_get_target_type(p->p, ruleB, &target) < 0 || (target_v = apol_query_expand_type(p, target)) == NULL) {
 		goto cleanup;
 	}
@@ -319,9 +324,6 @@ static int append_avrules_to_object_vector(const apol_policy_t * p,
 		if ((result = relabel_result_get_node(p, results, target)) == NULL) {
 			goto cleanup;
 		}
-		if ((dirA = relabel_analysis_get_direction(p, ruleA)) < 0 || (dirB = relabel_analysis_get_direction(p, ruleB)) < 0) {
-			goto cleanup;
-		}
 		if ((pair = calloc(1, sizeof(*pair))) == NULL) {
 			ERR(p, "%s", strerror(ENOMEM));
 			goto cleanup;
@@ -376,7 +378,7 @@ static int relabel_analysis_matchup(const apol_policy_t * p,
 	const qpol_class_t *a_class, *b_class;
 	apol_vector_t *start_v = NULL;
 	size_t i, j;
-	int compval, retval = -1;
+	int compval, dirA, dirB, retval = -1;
 
 	if (apol_query_get_type(p, r->type, &start_type) < 0) {
 		goto cleanup;
@@ -411,7 +413,9 @@ static int relabel_analysis_matchup(const apol_policy_t * p,
 			    b_target == start_type || a_class != b_class) {
 				continue;
 			}
-			if (append_avrules_to_object_vector(p, r, a_avrule, b_avrule, v) < 0) {
+			if ((dirA = relabel_analysis_get_direction(p, a_avrule)) < 0 ||
+			    (dirB = relabel_analysis_get_direction(p, b_avrule)) < 0 ||
+			    append_avrules_to_object_vector(p, r, a_avrule, dirA, b_avrule, dirB, v) < 0) {
 				goto cleanup;
 			}
 		}
@@ -510,22 +514,21 @@ static int relabel_analysis_object(const apol_policy_t * p,
  * @param p Policy containing avrule.
  * @param r Relabel analysis query object, containing filtering options.
  * @param avrule AV rule to add.
+ * @param dir Relabel direction of avrule.
  * @param result Results vector being built.
  *
  * @return 0 on success, < 0 on error.
  */
 static int append_avrule_to_subject_vector(const apol_policy_t * p,
-					   apol_relabel_analysis_t * r, const qpol_avrule_t * avrule, apol_vector_t * results)
+					   apol_relabel_analysis_t * r, const qpol_avrule_t * avrule, int dir,
+					   apol_vector_t * results)
 {
 	const qpol_type_t *target;
 	apol_vector_t *target_v = NULL, *result_list = NULL;
 	size_t i;
 	apol_relabel_result_t *result;
 	apol_relabel_result_pair_t *pair = NULL;
-	int retval = -1, dir, compval;
-	if ((dir = relabel_analysis_get_direction(p, avrule)) < 0) {
-		goto cleanup;
-	}
+	int retval = -1, compval;
 	if (qpol_avrule_get_target_type(p->p, avrule, &target) < 0 || (target_v = apol_query_expand_type(p, target)) == NULL) {
 		goto cleanup;
 	}
@@ -595,7 +598,7 @@ static int relabel_analysis_subject(const apol_policy_t * p, apol_relabel_analys
 	apol_vector_t *avrules_v = NULL;
 	const qpol_avrule_t *avrule;
 	size_t i;
-	int retval = -1;
+	int dir, retval = -1;
 
 	if ((a = apol_avrule_query_create()) == NULL) {
 		ERR(p, "%s", strerror(ENOMEM));
@@ -617,7 +620,7 @@ static int relabel_analysis_subject(const apol_policy_t * p, apol_relabel_analys
 
 	for (i = 0; i < apol_vector_get_size(avrules_v); i++) {
 		avrule = (qpol_avrule_t *) apol_vector_get_element(avrules_v, i);
-		if (append_avrule_to_subject_vector(p, r, avrule, v) < 0) {
+		if ((dir = relabel_analysis_get_direction(p, avrule)) < 0 || append_avrule_to_subject_vector(p, r, avrule, dir, v) < 0) {
 			goto cleanup;
 		}
 	}
@@ -629,13 +632,383 @@ static int relabel_analysis_subject(const apol_policy_t * p, apol_relabel_analys
 	return retval;
 }
 
+/******************** relabel rule index ********************/
+
+/** an allow rule that grants relabelto, relabelfrom, or both */
+typedef struct relabel_rule
+{
+	const qpol_avrule_t *rule;
+	const qpol_type_t *source, *target;
+	uint32_t source_val, target_val, class_val;
+	/** one of APOL_RELABEL_DIR_TO, APOL_RELABEL_DIR_FROM, or
+	 *  APOL_RELABEL_DIR_BOTH */
+	int dir;
+} relabel_rule_t;
+
+/**
+ * Every allow rule that grants relabelto or relabelfrom, bucketed by
+ * source and by target type value.  Within each bucket the rules keep
+ * their policy order, so that analyses find the same results in the
+ * same order as when searching all rules.
+ */
+struct apol_relabel_index
+{
+	relabel_rule_t *rules;
+	size_t num_rules;
+	/** highest type (or attribute) value and highest class value */
+	uint32_t num_types, num_classes;
+	/** type or attribute for each value; index 0 is unused */
+	const qpol_type_t **types;
+	unsigned char *isattr;
+	/** the rules whose source has value v are
+	 *  by_source[by_source_start[v]] through
+	 *  by_source[by_source_start[v + 1] - 1]; likewise for targets */
+	size_t *by_source_start, *by_source;
+	size_t *by_target_start, *by_target;
+	/** for a type, the values of its attributes; for an attribute,
+	 *  the values of its types; arranged like by_source */
+	size_t *expand_start;
+	uint32_t *expand;
+};
+
+void relabel_index_destroy(apol_relabel_index_t ** idx)
+{
+	if (idx != NULL && *idx != NULL) {
+		free((*idx)->rules);
+		free((*idx)->types);
+		free((*idx)->isattr);
+		free((*idx)->by_source_start);
+		free((*idx)->by_source);
+		free((*idx)->by_target_start);
+		free((*idx)->by_target);
+		free((*idx)->expand_start);
+		free((*idx)->expand);
+		free(*idx);
+		*idx = NULL;
+	}
+}
+
+void relabel_index_get_memory_usage(const apol_relabel_index_t * idx, apol_memory_usage_t * usage)
+{
+	if (idx == NULL) {
+		return;
+	}
+	usage->bytes += sizeof(*idx) + idx->num_rules * sizeof(*idx->rules);
+	usage->bytes += (idx->num_types + 1) * (sizeof(*idx->types) + sizeof(*idx->isattr));
+	/* both bucket arrays and the expansion offsets */
+	usage->bytes += 3 * (idx->num_types + 2) * sizeof(size_t);
+	usage->bytes += 2 * (idx->num_rules + 1) * sizeof(size_t);
+	if (idx->expand_start != NULL) {
+		usage->bytes += idx->expand_start[idx->num_types + 1] * sizeof(*idx->expand);
+	}
+	usage->count += idx->num_rules;
+}
+
+/**
+ * Bucket an index's rules by either their source or target values.
+ *
+ * @param idx Index whose rules to bucket.
+ * @param by_target If non-zero bucket by target, else by source.
+ * @param start Reference to the bucket offsets to allocate.
+ * @param list Reference to the rule indices to allocate.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int relabel_index_bucket(apol_relabel_index_t * idx, int by_target, size_t ** start, size_t ** list)
+{
+	size_t i, *fill = NULL;
+	uint32_t val;
+	if ((*start = calloc(idx->num_types + 2, sizeof(**start))) == NULL ||
+	    (*list = malloc((idx->num_rules + 1) * sizeof(**list))) == NULL ||
+	    (fill = malloc((idx->num_types + 1) * sizeof(*fill))) == NULL) {
+		return -1;
+	}
+	for (i = 0; i < idx->num_rules; i++) {
+		val = (by_target ? idx->rules[i].target_val : idx->rules[i].source_val);
+		(*start)[val + 1]++;
+	}
+	for (val = 1; val <= idx->num_types + 1; val++) {
+		(*start)[val] += (*start)[val - 1];
+	}
+	memcpy(fill, *start, (idx->num_types + 1) * sizeof(*fill));
+	for (i = 0; i < idx->num_rules; i++) {
+		val = (by_target ? idx->rules[i].target_val : idx->rules[i].source_val);
+		(*list)[fill[val]++] = i;
+	}
+	free(fill);
+	return 0;
+}
+
+/**
+ * Get the types for which a type value stands: the value itself for a
+ * type, or the types within an attribute.
+ *
+ * @param idx Index to consult.
+ * @param val Reference to a type or attribute value.
+ * @param num Location to write the number of types.
+ *
+ * @return Array of type values.
+ */
+static const uint32_t *relabel_index_get_types(const apol_relabel_index_t * idx, const uint32_t * val, size_t * num)
+{
+	if (idx->isattr[*val]) {
+		*num = idx->expand_start[*val + 1] - idx->expand_start[*val];
+		return idx->expand + idx->expand_start[*val];
+	}
+	*num = 1;
+	return val;
+}
+
+/**
+ * Append to a vector the indexed rules within a single bucket that
+ * grant any of the given directions and have a permitted class.
+ *
+ * @param idx Index to consult.
+ * @param by_target If non-zero use the target buckets, else the
+ * source buckets.
+ * @param val Type value whose bucket to search.
+ * @param dir Bitmask of relabel directions.
+ * @param class_val If non-zero, only append rules for this class.
+ * @param class_ok If non-NULL, only append rules for classes whose
+ * values are marked within this array.
+ * @param v Vector of relabel_rule_t pointers to which to append.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int relabel_index_append_bucket(const apol_relabel_index_t * idx, int by_target, uint32_t val, int dir,
+				       uint32_t class_val, const unsigned char *class_ok, apol_vector_t * v)
+{
+	const size_t *start = (by_target ? idx->by_target_start : idx->by_source_start);
+	const size_t *list = (by_target ? idx->by_target : idx->by_source);
+	size_t i;
+	for (i = start[val]; i < start[val + 1]; i++) {
+		relabel_rule_t *rule = idx->rules + list[i];
+		if (!(rule->dir & dir) || (class_val != 0 && rule->class_val != class_val) ||
+		    (class_ok != NULL && !class_ok[rule->class_val])) {
+			continue;
+		}
+		if (apol_vector_append(v, rule) < 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Append to a vector the indexed rules for a type value and,
+ * indirectly, for each of its attributes (or for an attribute each
+ * of its types).  Values already stamped with mark are skipped, so
+ * that no rule is appended twice.  Afterwards, sort the vector to
+ * restore policy order.
+ *
+ * @param stamp Array of marks, one per type value.
+ * @param mark Mark for the current search.
+ *
+ * @return 0 on success, < 0 on error.
+ *
+ * @see relabel_index_append_bucket() for the other parameters.
+ */
+static int relabel_index_append_indirect(const apol_relabel_index_t * idx, int by_target, uint32_t val, int dir,
+					 uint32_t class_val, const unsigned char *class_ok, uint32_t * stamp, uint32_t mark,
+					 apol_vector_t * v)
+{
+	size_t i;
+	uint32_t ex;
+	if (stamp[val] != mark) {
+		stamp[val] = mark;
+		if (relabel_index_append_bucket(idx, by_target, val, dir, class_val, class_ok, v) < 0) {
+			return -1;
+		}
+	}
+	for (i = idx->expand_start[val]; i < idx->expand_start[val + 1]; i++) {
+		ex = idx->expand[i];
+		if (stamp[ex] == mark) {
+			continue;
+		}
+		stamp[ex] = mark;
+		if (relabel_index_append_bucket(idx, by_target, ex, dir, class_val, class_ok, v) < 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Convert a relabel analysis's class names into an array of flags,
+ * one per class value.  As when querying rules, names that are not
+ * classes are ignored.
+ *
+ * @param p Policy containing the classes.
+ * @param classes Vector of class names, or NULL.
+ * @param class_ok Reference to the array to allocate.  This will be
+ * NULL if all classes are permitted.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int relabel_index_get_classes(const apol_policy_t * p, const apol_vector_t * classes, unsigned char **class_ok)
+{
+	const qpol_class_t *obj_class;
+	uint32_t val;
+	size_t i;
+	*class_ok = NULL;
+	if (classes == NULL || apol_vector_get_size(classes) == 0) {
+		return 0;
+	}
+	if ((*class_ok = calloc(p->relabel_index->num_classes + 1, sizeof(**class_ok))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		return -1;
+	}
+	for (i = 0; i < apol_vector_get_size(classes); i++) {
+		if (qpol_policy_get_class_by_name(p->p, apol_vector_get_element(classes, i), &obj_class) == 0 &&
+		    qpol_class_get_value(p->p, obj_class, &val) == 0 && val <= p->relabel_index->num_classes) {
+			(*class_ok)[val] = 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Perform an object relabel analysis in one direction using the
+ * policy's relabel index.  This finds the same results as
+ * relabel_analysis_object(), but only examines rules that involve the
+ * starting type or the subjects that may relabel it.
+ *
+ * @param p Policy with a relabel index.
+ * @param r Relabel analysis query object.
+ * @param v Vector of apol_relabel_result_t nodes.
+ * @param direction Either APOL_RELABEL_DIR_TO or APOL_RELABEL_DIR_FROM.
+ * @param subjects_v If not NULL, then a vector of qpol_type_t pointers.
+ * @param class_ok Permitted classes, from relabel_index_get_classes().
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int relabel_analysis_object_indexed(const apol_policy_t * p,
+					   apol_relabel_analysis_t * r,
+					   apol_vector_t * v, int direction, const apol_vector_t * subjects_v,
+					   const unsigned char *class_ok)
+{
+	const apol_relabel_index_t *idx = p->relabel_index;
+	const qpol_type_t *start_type;
+	const relabel_rule_t *a_rule, *b_rule;
+	apol_vector_t *a_rules = NULL, *b_rules = NULL;
+	const uint32_t *types;
+	uint32_t start_val, mark = 0, *stamp = NULL;
+	int perm1 = (direction == APOL_RELABEL_DIR_TO ? APOL_RELABEL_DIR_FROM : APOL_RELABEL_DIR_TO);
+	size_t i, j, num_types;
+	int compval, retval = -1;
+
+	if (apol_query_get_type(p, r->type, &start_type) < 0 || qpol_type_get_value(p->p, start_type, &start_val) < 0) {
+		goto cleanup;
+	}
+	if ((stamp = calloc(idx->num_types + 1, sizeof(*stamp))) == NULL || (a_rules = apol_vector_create(NULL)) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	if (relabel_index_append_indirect(idx, 1, start_val, perm1, 0, class_ok, stamp, ++mark, a_rules) < 0) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	apol_vector_sort(a_rules, NULL, NULL);
+
+	for (i = 0; i < apol_vector_get_size(a_rules); i++) {
+		a_rule = apol_vector_get_element(a_rules, i);
+		compval = relabel_analysis_compare_type_to_vector(p, subjects_v, a_rule->source);
+		if (compval < 0) {
+			goto cleanup;
+		} else if (compval == 0) {
+			continue;
+		}
+
+		/* find each B s.t. B(s) covers a type of A(s) and
+		 * B(t) != r->type and B(o) = A(o) */
+		if ((b_rules = apol_vector_create(NULL)) == NULL) {
+			ERR(p, "%s", strerror(errno));
+			goto cleanup;
+		}
+		types = relabel_index_get_types(idx, &a_rule->source_val, &num_types);
+		mark++;
+		for (j = 0; j < num_types; j++) {
+			if (relabel_index_append_indirect(idx, 0, types[j], direction, a_rule->class_val, NULL, stamp, mark, b_rules) <
+			    0) {
+				ERR(p, "%s", strerror(errno));
+				goto cleanup;
+			}
+		}
+		apol_vector_sort(b_rules, NULL, NULL);
+		for (j = 0; j < apol_vector_get_size(b_rules); j++) {
+			b_rule = apol_vector_get_element(b_rules, j);
+			if (b_rule->target == start_type) {
+				continue;
+			}
+			if (append_avrules_to_object_vector(p, r, a_rule->rule, a_rule->dir, b_rule->rule, b_rule->dir, v) < 0) {
+				goto cleanup;
+			}
+		}
+		apol_vector_destroy(&b_rules);
+	}
+
+	retval = 0;
+      cleanup:
+	free(stamp);
+	apol_vector_destroy(&a_rules);
+	apol_vector_destroy(&b_rules);
+	return retval;
+}
+
+/**
+ * Perform a subject relabel analysis using the policy's relabel
+ * index.  This finds the same results as relabel_analysis_subject().
+ *
+ * @param p Policy with a relabel index.
+ * @param r Structure containing parameters for subject relabel analysis.
+ * @param v Target vector to which append discovered rules.
+ * @param class_ok Permitted classes, from relabel_index_get_classes().
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int relabel_analysis_subject_indexed(const apol_policy_t * p, apol_relabel_analysis_t * r, apol_vector_t * v,
+					    const unsigned char *class_ok)
+{
+	const apol_relabel_index_t *idx = p->relabel_index;
+	const qpol_type_t *start_type;
+	const relabel_rule_t *rule;
+	apol_vector_t *rules = NULL;
+	uint32_t start_val, *stamp = NULL;
+	size_t i;
+	int retval = -1;
+
+	if (apol_query_get_type(p, r->type, &start_type) < 0 || qpol_type_get_value(p->p, start_type, &start_val) < 0) {
+		goto cleanup;
+	}
+	if ((stamp = calloc(idx->num_types + 1, sizeof(*stamp))) == NULL || (rules = apol_vector_create(NULL)) == NULL ||
+	    relabel_index_append_indirect(idx, 0, start_val, APOL_RELABEL_DIR_BOTH, 0, class_ok, stamp, 1, rules) < 0) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	apol_vector_sort(rules, NULL, NULL);
+	for (i = 0; i < apol_vector_get_size(rules); i++) {
+		rule = apol_vector_get_element(rules, i);
+		if (append_avrule_to_subject_vector(p, r, rule->rule, rule->dir, v) < 0) {
+			goto cleanup;
+		}
+	}
+
+	retval = 0;
+      cleanup:
+	free(stamp);
+	apol_vector_destroy(&rules);
+	return retval;
+}
+
 /******************** public functions below ********************/
 
 int apol_relabel_analysis_do(const apol_policy_t * p, apol_relabel_analysis_t * r, apol_vector_t ** v)
 {
 	apol_vector_t *subjects_v = NULL;
 	const qpol_type_t *start_type;
+	unsigned char *class_ok = NULL;
 	int retval = -1;
+	size_t depth = apol_stats_begin(p, "relabel analysis");
 	*v = NULL;
 
 	if (r->mode == 0 || r->type == NULL) {
@@ -650,16 +1023,37 @@ int apol_relabel_analysis_do(const apol_policy_t * p, apol_relabel_analysis_t *
 		ERR(p, "%s", strerror(ENOMEM));
 		goto cleanup;
 	}
+	/* the index is a cache, so dropping a stale one does not change
+	 * the policy as the caller sees it */
+	apol_policy_check_rebuild((apol_policy_t *) p);
+	if (p->relabel_index != NULL && relabel_index_get_classes(p, r->classes, &class_ok) < 0) {
+		goto cleanup;
+	}
 
 	if (r->mode == APOL_RELABEL_MODE_OBJ) {
 		if (r->subjects != NULL && (subjects_v = relabel_analysis_get_type_vector(p, r->subjects)) == NULL) {
 			goto cleanup;
 		}
-		if ((r->direction & APOL_RELABEL_DIR_TO) && relabel_analysis_object(p, r, *v, APOL_RELABEL_DIR_TO, subjects_v) < 0) {
-			goto cleanup;
+		if (r->direction & APOL_RELABEL_DIR_TO) {
+			if (p->relabel_index != NULL) {
+				if (relabel_analysis_object_indexed(p, r, *v, APOL_RELABEL_DIR_TO, subjects_v, class_ok) < 0) {
+					goto cleanup;
+				}
+			} else if (relabel_analysis_object(p, r, *v, APOL_RELABEL_DIR_TO, subjects_v) < 0) {
+				goto cleanup;
+			}
+		}
+		if (r->direction & APOL_RELABEL_DIR_FROM) {
+			if (p->relabel_index != NULL) {
+				if (relabel_analysis_object_indexed(p, r, *v, APOL_RELABEL_DIR_FROM, subjects_v, class_ok) < 0) {
+					goto cleanup;
+				}
+			} else if (relabel_analysis_object(p, r, *v, APOL_RELABEL_DIR_FROM, subjects_v) < 0) {
+				goto cleanup;
+			}
 		}
-		if ((r->direction & APOL_RELABEL_DIR_FROM) &&
-		    relabel_analysis_object(p, r, *v, APOL_RELABEL_DIR_FROM, subjects_v) < 0) {
+	} else if (p->relabel_index != NULL) {
+		if (relabel_analysis_subject_indexed(p, r, *v, class_ok) < 0) {
 			goto cleanup;
 		}
 	} else {
@@ -668,9 +1062,328 @@ int apol_relabel_analysis_do(const apol_policy_t * p, apol_relabel_analysis_t *
 		}
 	}
 
+	apol_stats_add(p, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*v));
 	retval = 0;
       cleanup:
 	apol_vector_destroy(&subjects_v);
+	free(class_ok);
+	if (retval != 0) {
+		apol_vector_destroy(v);
+	}
+	apol_stats_end(p, depth);
+	return retval;
+}
+
+int apol_policy_build_relabel_index(apol_policy_t * p)
+{
+	apol_relabel_index_t *idx = NULL;
+	qpol_iterator_t *iter = NULL, *sub_iter = NULL;
+	const qpol_type_t *type;
+	const qpol_class_t *obj_class;
+	unsigned char isalias;
+	uint32_t val, sub_val;
+	size_t num_expand = 0, expand_cap = 0, rules_cap = 0;
+	int dir, error = 0;
+
+	if (p == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	apol_policy_check_rebuild(p);
+	if (p->relabel_index != NULL) {
+		return 0;
+	}
+	if ((idx = calloc(1, sizeof(*idx))) == NULL) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
+		goto err;
+	}
+
+	/* record every type and attribute by value, skipping aliases */
+	if (qpol_policy_get_type_iter(p->p, &iter) < 0) {
+		error = errno;
+		goto err;
+	}
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		if (qpol_iterator_get_item(iter, (void **)&type) < 0 ||
+		    qpol_type_get_isalias(p->p, type, &isalias) < 0 || qpol_type_get_value(p->p, type, &val) < 0) {
+			error = errno;
+			goto err;
+		}
+		if (!isalias && val > idx->num_types) {
+			idx->num_types = val;
+		}
+	}
+	qpol_iterator_destroy(&iter);
+	if ((idx->types = calloc(idx->num_types + 1, sizeof(*idx->types))) == NULL ||
+	    (idx->isattr = calloc(idx->num_types + 1, sizeof(*idx->isattr))) == NULL ||
+	    (idx->expand_start = calloc(idx->num_types + 2, sizeof(*idx->expand_start))) == NULL) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
+		goto err;
+	}
+	if (qpol_policy_get_type_iter(p->p, &iter) < 0) {
+		error = errno;
+		goto err;
+	}
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		if (qpol_iterator_get_item(iter, (void **)&type) < 0 ||
+		    qpol_type_get_isalias(p->p, type, &isalias) < 0 || qpol_type_get_value(p->p, type, &val) < 0) {
+			error = errno;
+			goto err;
+		}
+		if (isalias) {
+			continue;
+		}
+		idx->types[val] = type;
+		if (qpol_type_get_isattr(p->p, type, &idx->isattr[val]) < 0) {
+			error = errno;
+			goto err;
+		}
+	}
+	qpol_iterator_destroy(&iter);
+
+	/* note each type's attributes and each attribute's types */
+	for (val = 1; val <= idx->num_types; val++) {
+		idx->expand_start[val] = num_expand;
+		if ((type = idx->types[val]) == NULL) {
+			continue;
+		}
+		if ((idx->isattr[val] && qpol_type_get_type_iter(p->p, type, &sub_iter) < 0) ||
+		    (!idx->isattr[val] && qpol_type_get_attr_iter(p->p, type, &sub_iter) < 0)) {
+			error = errno;
+			goto err;
+		}
+		for (; !qpol_iterator_end(sub_iter); qpol_iterator_next(sub_iter)) {
+			const qpol_type_t *t;
+			if (qpol_iterator_get_item(sub_iter, (void **)&t) < 0 || qpol_type_get_value(p->p, t, &sub_val) < 0) {
+				error = errno;
+				goto err;
+			}
+			if (sub_val == val || sub_val > idx->num_types) {
+				continue;
+			}
+			if (num_expand >= expand_cap) {
+				uint32_t *e;
+				expand_cap = (expand_cap == 0 ? 1024 : expand_cap * 2);
+				if ((e = realloc(idx->expand, expand_cap * sizeof(*e))) == NULL) {
+					error = errno;
+					ERR(p, "%s", strerror(error));
+					goto err;
+				}
+				idx->expand = e;
+			}
+			idx->expand[num_expand++] = sub_val;
+		}
+		qpol_iterator_destroy(&sub_iter);
+	}
+	idx->expand_start[idx->num_types + 1] = num_expand;
+
+	if (qpol_policy_get_class_iter(p->p, &iter) < 0) {
+		error = errno;
+		goto err;
+	}
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		if (qpol_iterator_get_item(iter, (void **)&obj_class) < 0 || qpol_class_get_value(p->p, obj_class, &val) < 0) {
+			error = errno;
+			goto err;
+		}
+		if (val > idx->num_classes) {
+			idx->num_classes = val;
+		}
+	}
+	qpol_iterator_destroy(&iter);
+
+	/* keep each allow rule that grants relabelto or relabelfrom */
+	if (qpol_policy_get_avrule_iter(p->p, QPOL_RULE_ALLOW, &iter) < 0) {
+		error = errno;
+		goto err;
+	}
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		const qpol_avrule_t *rule;
+		relabel_rule_t *r;
+		if (qpol_iterator_get_item(iter, (void **)&rule) < 0 || (dir = relabel_analysis_get_direction(p, rule)) < 0) {
+			error = errno;
+			goto err;
+		}
+		if (dir == 0) {
+			continue;
+		}
+		if (idx->num_rules >= rules_cap) {
+			relabel_rule_t *rules;
+			rules_cap = (rules_cap == 0 ? 256 : rules_cap * 2);
+			if ((rules = realloc(idx->rules, rules_cap * sizeof(*rules))) == NULL) {
+				error = errno;
+				ERR(p, "%s", strerror(error));
+				goto err;
+			}
+			idx->rules = rules;
+		}
+		r = idx->rules + idx->num_rules;
+		r->rule = rule;
+		r->dir = dir;
+		if (qpol_avrule_get_source_type(p->p, rule, &r->source) < 0 ||
+		    qpol_avrule_get_target_type(p->p, rule, &r->target) < 0 ||
+		    qpol_avrule_get_object_class(p->p, rule, &obj_class) < 0 ||
+		    qpol_type_get_value(p->p, r->source, &r->source_val) < 0 ||
+		    qpol_type_get_value(p->p, r->target, &r->target_val) < 0 ||
+		    qpol_class_get_value(p->p, obj_class, &r->class_val) < 0) {
+			error = errno;
+			goto err;
+		}
+		if (r->source_val > idx->num_types || r->target_val > idx->num_types || r->class_val > idx->num_classes) {
+			error = EINVAL;
+			ERR(p, "%s", strerror(error));
+			goto err;
+		}
+		idx->num_rules++;
+	}
+	qpol_iterator_destroy(&iter);
+
+	if (relabel_index_bucket(idx, 0, &idx->by_source_start, &idx->by_source) < 0 ||
+	    relabel_index_bucket(idx, 1, &idx->by_target_start, &idx->by_target) < 0) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
+		goto err;
+	}
+	p->relabel_index = idx;
+	return 0;
+      err:
+	qpol_iterator_destroy(&iter);
+	qpol_iterator_destroy(&sub_iter);
+	relabel_index_destroy(&idx);
+	errno = error;
+	return -1;
+}
+
+int apol_relabel_closure(apol_policy_t * p, const char *type, const char *obj_class, unsigned int dir, apol_vector_t ** v)
+{
+	const apol_relabel_index_t *idx;
+	const qpol_type_t *start_type;
+	const qpol_class_t *c;
+	apol_vector_t *a_rules = NULL, *b_rules = NULL;
+	const relabel_rule_t *a_rule, *b_rule;
+	const uint32_t *types, *subjs, *targets;
+	uint32_t start_val, first_class, last_class, class_val, cur, mark = 0;
+	uint32_t *stamp = NULL, *type_seen = NULL, *subj_seen = NULL, *queue = NULL;
+	unsigned char *found = NULL, *class_used = NULL;
+	int perm1, perm2, retval = -1;
+	size_t i, j, k, l, num_types, num_subjs, num_targets, head, tail;
+
+	if (v != NULL) {
+		*v = NULL;
+	}
+	if (p == NULL || type == NULL || v == NULL || (dir != APOL_RELABEL_DIR_TO && dir != APOL_RELABEL_DIR_FROM)) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	if (apol_policy_build_relabel_index(p) < 0 ||
+	    apol_query_get_type(p, type, &start_type) < 0 || qpol_type_get_value(p->p, start_type, &start_val) < 0) {
+		return -1;
+	}
+	idx = p->relabel_index;
+	if (obj_class != NULL) {
+		if (qpol_policy_get_class_by_name(p->p, obj_class, &c) < 0 || qpol_class_get_value(p->p, c, &first_class) < 0) {
+			return -1;
+		}
+		last_class = first_class;
+	} else {
+		first_class = 1;
+		last_class = idx->num_classes;
+	}
+	/* an object moves from type X to type Y when a subject may
+	 * relabel it away from X and on to Y (or for the reverse search,
+	 * on to X and away from Y) */
+	perm1 = (dir == APOL_RELABEL_DIR_TO ? APOL_RELABEL_DIR_FROM : APOL_RELABEL_DIR_TO);
+	perm2 = dir;
+
+	if ((*v = apol_vector_create(NULL)) == NULL ||
+	    (stamp = calloc(idx->num_types + 1, sizeof(*stamp))) == NULL ||
+	    (type_seen = calloc(idx->num_types + 1, sizeof(*type_seen))) == NULL ||
+	    (subj_seen = calloc(idx->num_types + 1, sizeof(*subj_seen))) == NULL ||
+	    (queue = malloc((idx->num_types + 1) * sizeof(*queue))) == NULL ||
+	    (found = calloc(idx->num_types + 1, sizeof(*found))) == NULL ||
+	    (class_used = calloc(idx->num_classes + 1, sizeof(*class_used))) == NULL) {
+		ERR(p, "%s", strerror(errno));
+		goto cleanup;
+	}
+	for (i = 0; i < idx->num_rules; i++) {
+		class_used[idx->rules[i].class_val] = 1;
+	}
+
+	/* breadth-first search through each class separately, for
+	 * relabeling never changes an object's class; type_seen and
+	 * subj_seen hold the class value of the latest search to visit
+	 * each type */
+	types = relabel_index_get_types(idx, &start_val, &num_types);
+	for (class_val = first_class; class_val <= last_class; class_val++) {
+		if (!class_used[class_val]) {
+			continue;
+		}
+		head = tail = 0;
+		for (i = 0; i < num_types; i++) {
+			if (type_seen[types[i]] != class_val) {
+				type_seen[types[i]] = class_val;
+				queue[tail++] = types[i];
+			}
+		}
+		while (head < tail) {
+			cur = queue[head++];
+			if ((a_rules = apol_vector_create(NULL)) == NULL ||
+			    relabel_index_append_indirect(idx, 1, cur, perm1, class_val, NULL, stamp, ++mark, a_rules) < 0) {
+				ERR(p, "%s", strerror(errno));
+				goto cleanup;
+			}
+			for (i = 0; i < apol_vector_get_size(a_rules); i++) {
+				a_rule = apol_vector_get_element(a_rules, i);
+				subjs = relabel_index_get_types(idx, &a_rule->source_val, &num_subjs);
+				for (j = 0; j < num_subjs; j++) {
+					if (subj_seen[subjs[j]] == class_val) {
+						continue;
+					}
+					subj_seen[subjs[j]] = class_val;
+					if ((b_rules = apol_vector_create(NULL)) == NULL ||
+					    relabel_index_append_indirect(idx, 0, subjs[j], perm2, class_val, NULL, stamp, ++mark,
+									  b_rules) < 0) {
+						ERR(p, "%s", strerror(errno));
+						goto cleanup;
+					}
+					for (k = 0; k < apol_vector_get_size(b_rules); k++) {
+						b_rule = apol_vector_get_element(b_rules, k);
+						targets = relabel_index_get_types(idx, &b_rule->target_val, &num_targets);
+						for (l = 0; l < num_targets; l++) {
+							if (type_seen[targets[l]] != class_val) {
+								type_seen[targets[l]] = class_val;
+								found[targets[l]] = 1;
+								queue[tail++] = targets[l];
+							}
+						}
+					}
+					apol_vector_destroy(&b_rules);
+				}
+			}
+			apol_vector_destroy(&a_rules);
+		}
+	}
+
+	for (cur = 1; cur <= idx->num_types; cur++) {
+		if (found[cur] && apol_vector_append(*v, (void *)idx->types[cur]) < 0) {
+			ERR(p, "%s", strerror(errno));
+			goto cleanup;
+		}
+	}
+	retval = 0;
+      cleanup:
+	apol_vector_destroy(&a_rules);
+	apol_vector_destroy(&b_rules);
+	free(stamp);
+	free(type_seen);
+	free(subj_seen);
+	free(queue);
+	free(found);
+	free(class_used);
 	if (retval != 0) {
 		apol_vector_destroy(v);
 	}
@@ -31,8 +31,10 @@
 #include <apol/render.h>
 
 #include <errno.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #ifndef WORDS_BIGENDIAN
 extern void swab(const void *from, void *to, ssize_t n);
@@ -156,3 +158,294 @@ char *apol_qpol_context_render(const apol_policy_t * p, const qpol_context_t * c
 	apol_context_destroy(&c);
 	return rendered_context;
 }
+
+/** initial size of a render sink's buffer, in bytes */
+#define RENDER_SINK_INITIAL_SIZE 256
+/** stream and file descriptor sinks write out their buffer once it
+ *  holds at least this many bytes */
+#define RENDER_SINK_FLUSH_SIZE 65536
+
+typedef enum render_sink_kind
+{
+	RENDER_SINK_BUFFER, RENDER_SINK_FILE, RENDER_SINK_FD
+} render_sink_kind_e;
+
+struct apol_render_sink
+{
+	render_sink_kind_e kind;
+	/** destination stream, for RENDER_SINK_FILE */
+	FILE *fp;
+	/** destination descriptor, for RENDER_SINK_FD */
+	int fd;
+	/** pending output, always nul-terminated if non-NULL */
+	char *buf;
+	/** number of characters in buf, not counting the nul */
+	size_t len;
+	/** number of bytes allocated to buf */
+	size_t size;
+};
+
+static apol_render_sink_t *render_sink_create(render_sink_kind_e kind, FILE * fp, int fd)
+{
+	apol_render_sink_t *sink = NULL;
+	if ((sink = calloc(1, sizeof(*sink))) == NULL) {
+		return NULL;
+	}
+	if ((sink->buf = malloc(RENDER_SINK_INITIAL_SIZE)) == NULL) {
+		free(sink);
+		return NULL;
+	}
+	sink->buf[0] = '\0';
+	sink->size = RENDER_SINK_INITIAL_SIZE;
+	sink->kind = kind;
+	sink->fp = fp;
+	sink->fd = fd;
+	return sink;
+}
+
+apol_render_sink_t *apol_render_sink_create_buffer(void)
+{
+	return render_sink_create(RENDER_SINK_BUFFER, NULL, -1);
+}
+
+apol_render_sink_t *apol_render_sink_create_file(FILE * fp)
+{
+	if (fp == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return render_sink_create(RENDER_SINK_FILE, fp, -1);
+}
+
+apol_render_sink_t *apol_render_sink_create_fd(int fd)
+{
+	if (fd < 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return render_sink_create(RENDER_SINK_FD, NULL, fd);
+}
+
+/**
+ * Write a stream or file descriptor sink's pending output to its
+ * destination, without flushing the destination itself.  Upon error
+ * only the output that was not written remains pending.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int render_sink_drain(apol_render_sink_t * sink)
+{
+	size_t written = 0;
+	ssize_t n;
+	int retval = 0, error = 0;
+	if (sink->len == 0 || sink->kind == RENDER_SINK_BUFFER) {
+		return 0;
+	}
+	if (sink->kind == RENDER_SINK_FILE) {
+		if ((written = fwrite(sink->buf, 1, sink->len, sink->fp)) != sink->len) {
+			error = errno;
+			retval = -1;
+		}
+	} else {
+		while (written < sink->len) {
+			if ((n = write(sink->fd, sink->buf + written, sink->len - written)) < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				error = errno;
+				retval = -1;
+				break;
+			}
+			written += (size_t)n;
+		}
+	}
+	/* keep the unwritten tail, so that a later drain does not
+	 * write the same output twice */
+	memmove(sink->buf, sink->buf + written, sink->len - written);
+	sink->len -= written;
+	sink->buf[sink->len] = '\0';
+	if (retval < 0) {
+		errno = error;
+	}
+	return retval;
+}
+
+/**
+ * Ensure that a sink has room to append n more characters (plus the
+ * trailing nul).  Stream and file descriptor sinks first write out
+ * their pending output once it has grown large, so that their buffer
+ * stays bounded.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int render_sink_reserve(apol_render_sink_t * sink, size_t n)
+{
+	size_t new_size;
+	char *b;
+	if (sink->kind != RENDER_SINK_BUFFER && sink->len + n >= RENDER_SINK_FLUSH_SIZE) {
+		if (render_sink_drain(sink) < 0) {
+			return -1;
+		}
+	}
+	if (sink->buf != NULL && sink->len + n < sink->size) {
+		return 0;
+	}
+	new_size = (sink->size == 0 ? RENDER_SINK_INITIAL_SIZE : sink->size);
+	while (sink->len + n >= new_size) {
+		new_size *= 2;
+	}
+	if ((b = realloc(sink->buf, new_size)) == NULL) {
+		return -1;
+	}
+	if (sink->buf == NULL) {
+		b[0] = '\0';
+	}
+	sink->buf = b;
+	sink->size = new_size;
+	return 0;
+}
+
+void apol_render_sink_destroy(apol_render_sink_t ** sink)
+{
+	if (!sink || !(*sink))
+		return;
+	render_sink_drain(*sink);
+	if ((*sink)->kind == RENDER_SINK_FILE) {
+		fflush((*sink)->fp);
+	}
+	free((*sink)->buf);
+	free(*sink);
+	*sink = NULL;
+}
+
+int apol_render_sink_append(apol_render_sink_t * sink, const char *str)
+{
+	size_t n;
+	if (!sink || !str) {
+		errno = EINVAL;
+		return -1;
+	}
+	n = strlen(str);
+	if (render_sink_reserve(sink, n) < 0) {
+		return -1;
+	}
+	memcpy(sink->buf + sink->len, str, n + 1);
+	sink->len += n;
+	return 0;
+}
+
+int apol_render_sink_appendf(apol_render_sink_t * sink, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+	if (!sink || !fmt) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (sink->buf == NULL && render_sink_reserve(sink, 0) < 0) {
+		return -1;
+	}
+	/* optimistically format into the space already available, and
+	 * only grow the buffer if that was not enough */
+	va_start(ap, fmt);
+	n = vsnprintf(sink->buf + sink->len, sink->size - sink->len, fmt, ap);
+	va_end(ap);
+	if (n < 0) {
+		sink->buf[sink->len] = '\0';
+		return -1;
+	}
+	if ((size_t)n >= sink->size - sink->len ||
+	    (sink->kind != RENDER_SINK_BUFFER && sink->len + n >= RENDER_SINK_FLUSH_SIZE)) {
+		sink->buf[sink->len] = '\0';
+		if (render_sink_reserve(sink, (size_t)n) < 0) {
+			return -1;
+		}
+		va_start(ap, fmt);
+		n = vsnprintf(sink->buf + sink->len, sink->size - sink->len, fmt, ap);
+		va_end(ap);
+		if (n < 0) {
+			sink->buf[sink->len] = '\0';
+			return -1;
+		}
+	}
+	sink->len += (size_t)n;
+	return 0;
+}
+
+int apol_render_sink_putc(apol_render_sink_t * sink, char c)
+{
+	if (!sink) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (render_sink_reserve(sink, 1) < 0) {
+		return -1;
+	}
+	sink->buf[sink->len++] = c;
+	sink->buf[sink->len] = '\0';
+	return 0;
+}
+
+int apol_render_sink_flush(apol_render_sink_t * sink)
+{
+	if (!sink) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (render_sink_drain(sink) < 0) {
+		return -1;
+	}
+	if (sink->kind == RENDER_SINK_FILE && fflush(sink->fp) != 0) {
+		return -1;
+	}
+	return 0;
+}
+
+const char *apol_render_sink_get_string(const apol_render_sink_t * sink)
+{
+	if (!sink) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return (sink->buf == NULL ? "" : sink->buf);
+}
+
+size_t apol_render_sink_get_length(const apol_render_sink_t * sink)
+{
+	if (!sink) {
+		errno = EINVAL;
+		return 0;
+	}
+	return sink->len;
+}
+
+void apol_render_sink_clear(apol_render_sink_t * sink)
+{
+	if (!sink)
+		return;
+	sink->len = 0;
+	if (sink->buf != NULL) {
+		sink->buf[0] = '\0';
+	}
+}
+
+char *apol_render_sink_take_string(apol_render_sink_t * sink)
+{
+	char *s;
+	if (!sink) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (sink->buf == NULL) {
+		return strdup("");
+	}
+	/* hand over the buffer itself, trimmed to size, rather than
+	 * copying it */
+	if ((s = realloc(sink->buf, sink->len + 1)) == NULL) {
+		s = sink->buf;
+	}
+	sink->buf = NULL;
+	sink->len = 0;
+	sink->size = 0;
+	return s;
+}
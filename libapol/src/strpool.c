@@ -0,0 +1,286 @@
+/**
+ *  @file
+ *  Implementation of a string pool.  Strings are copied into large
+ *  arena blocks and indexed by an open addressing hash table of
+ *  string identifiers.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <apol/strpool.h>
+#include <apol/util.h>
+#include <apol/vector.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** minimum size of an arena block, in bytes */
+#define STRPOOL_BLOCK_SIZE 8192
+/** initial number of hash table slots; must be a power of 2 */
+#define STRPOOL_INITIAL_CAPACITY 64
+/** marks an empty hash table slot */
+#define STRPOOL_EMPTY ((size_t) -1)
+
+typedef struct strpool_block
+{
+	struct strpool_block *next;
+	size_t used, size;
+	/* string storage follows the header */
+} strpool_block_t;
+
+struct apol_strpool
+{
+	/** singly linked list of arena blocks, most recent first */
+	strpool_block_t *blocks;
+	/** array of interned strings, indexed by identifier */
+	char **strs;
+	/** hash of each interned string, indexed by identifier */
+	size_t *hashes;
+	/** number of interned strings */
+	size_t size;
+	/** number of entries allocated for strs and hashes */
+	size_t strs_cap;
+	/** hash table of string identifiers, or STRPOOL_EMPTY */
+	size_t *slots;
+	/** number of hash table slots; always a power of 2 */
+	size_t capacity;
+};
+
+/**
+ * Find the slot holding the identifier of a string equal to str, or
+ * the empty slot where it would be inserted.
+ */
+static size_t strpool_find_slot(const apol_strpool_t * pool, const char *str, size_t hash)
+{
+	size_t mask = pool->capacity - 1;
+	size_t i = hash & mask, id;
+	while ((id = pool->slots[i]) != STRPOOL_EMPTY) {
+		if (pool->hashes[id] == hash && strcmp(pool->strs[id], str) == 0) {
+			break;
+		}
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+/**
+ * Double the number of hash table slots, rehashing every string
+ * from its saved hash value.
+ *
+ * @return 0 on success, < 0 on error (in which case pool is unchanged).
+ */
+static int strpool_grow_table(apol_strpool_t * pool)
+{
+	size_t new_capacity = (pool->capacity == 0 ? STRPOOL_INITIAL_CAPACITY : pool->capacity * 2);
+	size_t mask = new_capacity - 1, i, id;
+	size_t *new_slots;
+	if ((new_slots = malloc(new_capacity * sizeof(*new_slots))) == NULL) {
+		return -1;
+	}
+	for (i = 0; i < new_capacity; i++) {
+		new_slots[i] = STRPOOL_EMPTY;
+	}
+	for (id = 0; id < pool->size; id++) {
+		i = pool->hashes[id] & mask;
+		while (new_slots[i] != STRPOOL_EMPTY) {
+			i = (i + 1) & mask;
+		}
+		new_slots[i] = id;
+	}
+	free(pool->slots);
+	pool->slots = new_slots;
+	pool->capacity = new_capacity;
+	return 0;
+}
+
+/**
+ * Copy a string into the pool's arena, allocating a new block if
+ * the current one is full.
+ *
+ * @return The arena's copy of the string, or NULL on error.
+ */
+static char *strpool_copy(apol_strpool_t * pool, const char *str)
+{
+	size_t len = strlen(str) + 1;
+	strpool_block_t *b = pool->blocks;
+	char *s;
+	if (b == NULL || b->size - b->used < len) {
+		size_t size = (len > STRPOOL_BLOCK_SIZE ? len : STRPOOL_BLOCK_SIZE);
+		if ((b = malloc(sizeof(*b) + size)) == NULL) {
+			return NULL;
+		}
+		b->used = 0;
+		b->size = size;
+		b->next = pool->blocks;
+		pool->blocks = b;
+	}
+	s = (char *)(b + 1) + b->used;
+	memcpy(s, str, len);
+	b->used += len;
+	return s;
+}
+
+apol_strpool_t *apol_strpool_create(void)
+{
+	apol_strpool_t *pool = NULL;
+	if ((pool = calloc(1, sizeof(*pool))) == NULL) {
+		return NULL;
+	}
+	if (strpool_grow_table(pool) < 0) {
+		free(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+void apol_strpool_destroy(apol_strpool_t ** pool)
+{
+	strpool_block_t *b, *next;
+	if (!pool || !(*pool))
+		return;
+	for (b = (*pool)->blocks; b != NULL; b = next) {
+		next = b->next;
+		free(b);
+	}
+	free((*pool)->strs);
+	free((*pool)->hashes);
+	free((*pool)->slots);
+	free(*pool);
+	*pool = NULL;
+}
+
+size_t apol_strpool_get_size(const apol_strpool_t * pool)
+{
+	if (!pool) {
+		errno = EINVAL;
+		return 0;
+	} else {
+		return pool->size;
+	}
+}
+
+int apol_strpool_insert(apol_strpool_t * pool, const char *str, char **result)
+{
+	size_t hash, i;
+	char *s;
+	if (!pool || !str) {
+		errno = EINVAL;
+		return -1;
+	}
+	hash = apol_str_hash(str);
+	i = strpool_find_slot(pool, str, hash);
+	if (pool->slots[i] != STRPOOL_EMPTY) {
+		if (result != NULL) {
+			*result = pool->strs[pool->slots[i]];
+		}
+		return 1;
+	}
+
+	/* make room for the new entry before copying anything, so that
+	 * the pool is unchanged upon failure */
+	if (pool->size >= pool->strs_cap) {
+		size_t new_cap = (pool->strs_cap == 0 ? STRPOOL_INITIAL_CAPACITY : pool->strs_cap * 2);
+		char **new_strs;
+		size_t *new_hashes;
+		if ((new_strs = realloc(pool->strs, new_cap * sizeof(*new_strs))) == NULL) {
+			return -1;
+		}
+		pool->strs = new_strs;
+		if ((new_hashes = realloc(pool->hashes, new_cap * sizeof(*new_hashes))) == NULL) {
+			return -1;
+		}
+		pool->hashes = new_hashes;
+		pool->strs_cap = new_cap;
+	}
+	/* keep the load factor at or below 1/2 */
+	if ((pool->size + 1) * 2 > pool->capacity) {
+		if (strpool_grow_table(pool) < 0) {
+			return -1;
+		}
+		i = strpool_find_slot(pool, str, hash);
+	}
+	if ((s = strpool_copy(pool, str)) == NULL) {
+		return -1;
+	}
+	pool->strs[pool->size] = s;
+	pool->hashes[pool->size] = hash;
+	pool->slots[i] = pool->size;
+	pool->size++;
+	if (result != NULL) {
+		*result = s;
+	}
+	return 0;
+}
+
+int apol_strpool_get_element(const apol_strpool_t * pool, const char *str, char **result)
+{
+	size_t id;
+	if (!result) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (apol_strpool_get_id(pool, str, &id) < 0) {
+		return -1;
+	}
+	*result = pool->strs[id];
+	return 0;
+}
+
+int apol_strpool_get_id(const apol_strpool_t * pool, const char *str, size_t * id)
+{
+	size_t i;
+	if (!pool || !str || !id) {
+		errno = EINVAL;
+		return -1;
+	}
+	i = strpool_find_slot(pool, str, apol_str_hash(str));
+	if (pool->slots[i] == STRPOOL_EMPTY) {
+		return -1;
+	}
+	*id = pool->slots[i];
+	return 0;
+}
+
+char *apol_strpool_get_string(const apol_strpool_t * pool, size_t id)
+{
+	if (!pool || id >= pool->size) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return pool->strs[id];
+}
+
+apol_vector_t *apol_strpool_get_vector(const apol_strpool_t * pool)
+{
+	apol_vector_t *v = NULL;
+	size_t id;
+	if (!pool) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((v = apol_vector_create_with_capacity(pool->size, NULL)) == NULL) {
+		return NULL;
+	}
+	for (id = 0; id < pool->size; id++) {
+		if (apol_vector_append(v, pool->strs[id]) < 0) {
+			int error = errno;
+			apol_vector_destroy(&v);
+			errno = error;
+			return NULL;
+		}
+	}
+	apol_vector_sort(v, apol_str_strcmp, NULL);
+	return v;
+}
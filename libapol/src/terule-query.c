@@ -64,117 +64,137 @@ static int rule_select(const apol_policy_t * p, apol_vector_t * v, uint32_t rule
 		       const apol_vector_t * default_list, const char *bool_name)
 {
 	qpol_iterator_t *iter = NULL;
+	void *batch[APOL_QUERY_ITER_BATCH];
+	int num_items, b, by_source = 0;
+	size_t num_passes = 1, pass;
 	int only_enabled = flags & APOL_QUERY_ONLY_ENABLED;
 	int is_regex = flags & APOL_QUERY_REGEX;
 	int source_as_any = flags & APOL_QUERY_SOURCE_AS_ANY;
 	int retv = -1;
 	regex_t *bool_regex = NULL;
 
-	if (qpol_policy_get_terule_iter(p->p, rule_type, &iter) < 0) {
-		goto cleanup;
+	/* with a sorted rule snapshot it is cheaper to look up the
+	 * rules of each candidate source than to scan every rule */
+	if (source_list != NULL && !source_as_any && qpol_policy_has_sorted_rule_table(p->p)) {
+		num_passes = apol_vector_get_size(source_list);
+		by_source = 1;
 	}
-
-	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
-		qpol_terule_t *rule;
-		uint32_t is_enabled;
-		const qpol_cond_t *cond = NULL;
-		int match_source = 0, match_target = 0, match_default = 0, match_bool = 0;
-		size_t i;
-		if (qpol_iterator_get_item(iter, (void **)&rule) < 0) {
-			goto cleanup;
-		}
-
-		if (qpol_terule_get_is_enabled(p->p, rule, &is_enabled) < 0) {
-			goto cleanup;
-		}
-		if (!is_enabled && only_enabled) {
-			continue;
-		}
-
-		if (bool_name != NULL) {
-			if (qpol_terule_get_cond(p->p, rule, &cond) < 0) {
-				goto cleanup;
-			}
-			if (cond == NULL) {
-				continue;	/* skip unconditional rule */
-			}
-			match_bool = apol_compare_cond_expr(p, cond, bool_name, is_regex, &bool_regex);
-			if (match_bool < 0) {
-				goto cleanup;
-			} else if (match_bool == 0) {
-				continue;
-			}
-		}
-
-		if (source_list == NULL) {
-			match_source = 1;
-		} else {
-			const qpol_type_t *source_type;
-			if (qpol_terule_get_source_type(p->p, rule, &source_type) < 0) {
-				goto cleanup;
-			}
-			if (apol_vector_get_index(source_list, source_type, NULL, NULL, &i) == 0) {
-				match_source = 1;
-			}
-		}
-
-		/* if source did not match, but treating source symbol
-		 * as any field, then delay rejecting this rule until
-		 * the target and default have been checked */
-		if (!source_as_any && !match_source) {
-			continue;
-		}
-
-		if (target_list == NULL || (source_as_any && match_source)) {
-			match_target = 1;
-		} else {
-			const qpol_type_t *target_type;
-			if (qpol_terule_get_target_type(p->p, rule, &target_type) < 0) {
-				goto cleanup;
-			}
-			if (apol_vector_get_index(target_list, target_type, NULL, NULL, &i) == 0) {
-				match_target = 1;
-			}
-		}
-
-		if (!source_as_any && !match_target) {
-			continue;
-		}
-
-		if (default_list == NULL || (source_as_any && match_source) || (source_as_any && match_target)) {
-			match_default = 1;
-		} else {
-			const qpol_type_t *default_type;
-			if (qpol_terule_get_default_type(p->p, rule, &default_type) < 0) {
+	for (pass = 0; pass < num_passes; pass++) {
+		if (by_source) {
+			const qpol_type_t *source = apol_vector_get_element(source_list, pass);
+			if (qpol_policy_get_terule_iter_by_source(p->p, rule_type, source, &iter) < 0) {
 				goto cleanup;
 			}
-			if (apol_vector_get_index(default_list, default_type, NULL, NULL, &i) == 0) {
-				match_default = 1;
-			}
-		}
-
-		if (!source_as_any && !match_default) {
-			continue;
-		}
-		/* at least one thing must match if source_as_any was given */
-		if (source_as_any && (!match_source && !match_target && !match_default)) {
-			continue;
+		} else if (qpol_policy_get_terule_iter(p->p, rule_type, &iter) < 0) {
+			goto cleanup;
 		}
-
-		if (class_list != NULL) {
-			const qpol_class_t *obj_class;
-			if (qpol_terule_get_object_class(p->p, rule, &obj_class) < 0) {
-				goto cleanup;
-			}
-			if (apol_vector_get_index(class_list, obj_class, NULL, NULL, &i) < 0) {
-				continue;
+		while ((num_items = qpol_iterator_next_batch(iter, batch, APOL_QUERY_ITER_BATCH)) > 0) {
+			apol_stats_add(p, QPOL_STATS_RULES_SCANNED, num_items);
+			for (b = 0; b < num_items; b++) {
+				qpol_terule_t *rule = batch[b];
+				uint32_t is_enabled;
+				const qpol_cond_t *cond = NULL;
+				int match_source = 0, match_target = 0, match_default = 0, match_bool = 0;
+				size_t i;
+				if (qpol_terule_get_is_enabled(p->p, rule, &is_enabled) < 0) {
+					goto cleanup;
+				}
+				if (!is_enabled && only_enabled) {
+					continue;
+				}
+
+				if (bool_name != NULL) {
+					if (qpol_terule_get_cond(p->p, rule, &cond) < 0) {
+						goto cleanup;
+					}
+					if (cond == NULL) {
+						continue;	/* skip unconditional rule */
+					}
+					match_bool = apol_compare_cond_expr(p, cond, bool_name, is_regex, &bool_regex);
+					if (match_bool < 0) {
+						goto cleanup;
+					} else if (match_bool == 0) {
+						continue;
+					}
+				}
+
+				if (source_list == NULL || by_source) {
+					/* the per-source iterator only returns
+					 * rules of this pass's source */
+					match_source = 1;
+				} else {
+					const qpol_type_t *source_type;
+					if (qpol_terule_get_source_type(p->p, rule, &source_type) < 0) {
+						goto cleanup;
+					}
+					if (apol_vector_get_index(source_list, source_type, NULL, NULL, &i) == 0) {
+						match_source = 1;
+					}
+				}
+
+				/* if source did not match, but treating source symbol
+				 * as any field, then delay rejecting this rule until
+				 * the target and default have been checked */
+				if (!source_as_any && !match_source) {
+					continue;
+				}
+
+				if (target_list == NULL || (source_as_any && match_source)) {
+					match_target = 1;
+				} else {
+					const qpol_type_t *target_type;
+					if (qpol_terule_get_target_type(p->p, rule, &target_type) < 0) {
+						goto cleanup;
+					}
+					if (apol_vector_get_index(target_list, target_type, NULL, NULL, &i) == 0) {
+						match_target = 1;
+					}
+				}
+
+				if (!source_as_any && !match_target) {
+					continue;
+				}
+
+				if (default_list == NULL || (source_as_any && match_source) || (source_as_any && match_target)) {
+					match_default = 1;
+				} else {
+					const qpol_type_t *default_type;
+					if (qpol_terule_get_default_type(p->p, rule, &default_type) < 0) {
+						goto cleanup;
+					}
+					if (apol_vector_get_index(default_list, default_type, NULL, NULL, &i) == 0) {
+						match_default = 1;
+					}
+				}
+
+				if (!source_as_any && !match_default) {
+					continue;
+				}
+				/* at least one thing must match if source_as_any was given */
+				if (source_as_any && (!match_source && !match_target && !match_default)) {
+					continue;
+				}
+
+				if (class_list != NULL) {
+					const qpol_class_t *obj_class;
+					if (qpol_terule_get_object_class(p->p, rule, &obj_class) < 0) {
+						goto cleanup;
+					}
+					if (apol_vector_get_index(class_list, obj_class, NULL, NULL, &i) < 0) {
+						continue;
+					}
+				}
+
+				if (apol_vector_append(v, rule)) {
+					ERR(p, "%s", strerror(ENOMEM));
+					goto cleanup;
+				}
 			}
 		}
-
-		if (apol_vector_append(v, rule)) {
-			ERR(p, "%s", strerror(ENOMEM));
+		if (num_items < 0) {
 			goto cleanup;
 		}
+		qpol_iterator_destroy(&iter);
 	}
 
 	retv = 0;
@@ -192,6 +212,7 @@ int apol_terule_get_by_query(const apol_policy_t * p, const apol_terule_query_t
 	char *bool_name = NULL;
 	*v = NULL;
 	unsigned int flags = 0;
+	size_t depth = apol_stats_begin(p, "terule query");
 
 	uint32_t rule_type = QPOL_RULE_TYPE_TRANS | QPOL_RULE_TYPE_MEMBER | QPOL_RULE_TYPE_CHANGE;
 	if (t != NULL) {
@@ -247,6 +268,10 @@ int apol_terule_get_by_query(const apol_policy_t * p, const apol_terule_query_t
 
 	retval = 0;
       cleanup:
+	if (retval == 0) {
+		apol_stats_add(p, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*v));
+	}
+	apol_stats_end(p, depth);
 	if (retval != 0) {
 		apol_vector_destroy(v);
 	}
@@ -267,6 +292,7 @@ int apol_syn_terule_get_by_query(const apol_policy_t * p, const apol_terule_quer
 	*v = NULL;
 	size_t i;
 	unsigned int flags = 0;
+	size_t depth = apol_stats_begin(p, "syntactic terule query");
 
 	if (!p || !qpol_policy_has_capability(apol_policy_get_qpol(p), QPOL_CAP_SYN_RULES)) {
 		ERR(p, "%s", strerror(EINVAL));
@@ -419,6 +445,10 @@ int apol_syn_terule_get_by_query(const apol_policy_t * p, const apol_terule_quer
 
 	retval = 0;
       cleanup:
+	if (retval == 0) {
+		apol_stats_add(p, QPOL_STATS_RULES_MATCHED, apol_vector_get_size(*v));
+	}
+	apol_stats_end(p, depth);
 	if (retval != 0) {
 		apol_vector_destroy(v);
 	}
@@ -651,38 +681,36 @@ apol_vector_t *apol_terule_list_to_syn_terules(const apol_policy_t * p, const ap
 	return v;
 }
 
-char *apol_terule_render(const apol_policy_t * policy, const qpol_terule_t * rule)
+int apol_terule_render_to_sink(const apol_policy_t * policy, const qpol_terule_t * rule, apol_render_sink_t * sink)
 {
-	char *tmp = NULL;
 	const char *tmp_name = NULL;
 	const char *rule_type_str;
 	int error = 0;
-	size_t tmp_sz = 0;
 	uint32_t rule_type = 0;
 	const qpol_type_t *type = NULL;
 	const qpol_class_t *obj_class = NULL;
 
-	if (!policy || !rule) {
+	if (!policy || !rule || !sink) {
 		ERR(policy, "%s", strerror(EINVAL));
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 
 	/* rule type */
 	if (qpol_terule_get_rule_type(policy->p, rule, &rule_type)) {
-		return NULL;
+		return -1;
 	}
 	if (!(rule_type &= (QPOL_RULE_TYPE_TRANS | QPOL_RULE_TYPE_CHANGE | QPOL_RULE_TYPE_MEMBER))) {
 		ERR(policy, "%s", "Invalid TE rule type");
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 	if (!(rule_type_str = apol_rule_type_to_str(rule_type))) {
 		ERR(policy, "%s", "Could not get TE rule type's string");
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s ", rule_type_str)) {
+	if (apol_render_sink_appendf(sink, "%s ", rule_type_str)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -697,7 +725,7 @@ char *apol_terule_render(const apol_policy_t * policy, const qpol_terule_t * rul
 		error = errno;
 		goto err;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+	if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -712,7 +740,7 @@ char *apol_terule_render(const apol_policy_t * policy, const qpol_terule_t * rul
 		error = errno;
 		goto err;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s : ", tmp_name)) {
+	if (apol_render_sink_appendf(sink, "%s : ", tmp_name)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -727,7 +755,7 @@ char *apol_terule_render(const apol_policy_t * policy, const qpol_terule_t * rul
 		error = errno;
 		goto err;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+	if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -742,23 +770,42 @@ char *apol_terule_render(const apol_policy_t * policy, const qpol_terule_t * rul
 		error = errno;
 		goto err;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s;", tmp_name)) {
+	if (apol_render_sink_appendf(sink, "%s;", tmp_name)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
 	}
 
-	return tmp;
+	return 0;
 
       err:
-	free(tmp);
 	errno = error;
-	return NULL;
+	return -1;
 }
 
-char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule_t * rule)
+char *apol_terule_render(const apol_policy_t * policy, const qpol_terule_t * rule)
 {
+	apol_render_sink_t *sink = NULL;
 	char *tmp = NULL;
+	int error;
+
+	if ((sink = apol_render_sink_create_buffer()) == NULL) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return NULL;
+	}
+	if (apol_terule_render_to_sink(policy, rule, sink) == 0 && (tmp = apol_render_sink_take_string(sink)) == NULL) {
+		ERR(policy, "%s", strerror(errno));
+	}
+	error = errno;
+	apol_render_sink_destroy(&sink);
+	errno = error;
+	return tmp;
+}
+
+int apol_syn_terule_render_to_sink(const apol_policy_t * policy, const qpol_syn_terule_t * rule, apol_render_sink_t * sink)
+{
 	const char *tmp_name = NULL;
 	const char *rule_type_str;
 	int error = 0;
@@ -766,30 +813,30 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 	const qpol_type_t *type = NULL;
 	const qpol_class_t *obj_class = NULL;
 	qpol_iterator_t *iter = NULL, *iter2 = NULL;
-	size_t tmp_sz = 0, iter_sz = 0, iter2_sz = 0;
+	size_t iter_sz = 0, iter2_sz = 0;
 	const qpol_type_set_t *set = NULL;
 
-	if (!policy || !rule) {
+	if (!policy || !rule || !sink) {
 		ERR(policy, "%s", strerror(EINVAL));
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 
 	/* rule type */
 	if (qpol_syn_terule_get_rule_type(policy->p, rule, &rule_type)) {
-		return NULL;
+		return -1;
 	}
 	if (!(rule_type &= (QPOL_RULE_TYPE_TRANS | QPOL_RULE_TYPE_CHANGE | QPOL_RULE_TYPE_MEMBER))) {
 		ERR(policy, "%s", "Invalid TE rule type");
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 	if (!(rule_type_str = apol_rule_type_to_str(rule_type))) {
 		ERR(policy, "%s", "Could not get TE rule type's string");
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s ", rule_type_str)) {
+	if (apol_render_sink_appendf(sink, "%s ", rule_type_str)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -805,7 +852,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 		goto err;
 	}
 	if (star) {
-		if (apol_str_append(&tmp, &tmp_sz, "* ")) {
+		if (apol_render_sink_append(sink, "* ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -816,7 +863,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 			goto err;
 		}
 		if (comp) {
-			if (apol_str_append(&tmp, &tmp_sz, "~")) {
+			if (apol_render_sink_append(sink, "~")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -836,7 +883,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 			goto err;
 		}
 		if (iter_sz + iter2_sz > 1) {
-			if (apol_str_append(&tmp, &tmp_sz, "{ ")) {
+			if (apol_render_sink_append(sink, "{ ")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -852,7 +899,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 				error = errno;
 				goto err;
 			}
-			if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+			if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -868,7 +915,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 				error = errno;
 				goto err;
 			}
-			if (apol_str_appendf(&tmp, &tmp_sz, "-%s ", tmp_name)) {
+			if (apol_render_sink_appendf(sink, "-%s ", tmp_name)) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -877,7 +924,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 		qpol_iterator_destroy(&iter);
 		qpol_iterator_destroy(&iter2);
 		if (iter_sz + iter2_sz > 1) {
-			if (apol_str_append(&tmp, &tmp_sz, "} ")) {
+			if (apol_render_sink_append(sink, "} ")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -895,7 +942,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 		goto err;
 	}
 	if (star) {
-		if (apol_str_append(&tmp, &tmp_sz, "* ")) {
+		if (apol_render_sink_append(sink, "* ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -906,7 +953,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 			goto err;
 		}
 		if (comp) {
-			if (apol_str_append(&tmp, &tmp_sz, "~")) {
+			if (apol_render_sink_append(sink, "~")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -926,7 +973,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 			goto err;
 		}
 		if (iter_sz + iter2_sz > 1) {
-			if (apol_str_append(&tmp, &tmp_sz, "{ ")) {
+			if (apol_render_sink_append(sink, "{ ")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -942,7 +989,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 				error = errno;
 				goto err;
 			}
-			if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+			if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -958,7 +1005,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 				error = errno;
 				goto err;
 			}
-			if (apol_str_appendf(&tmp, &tmp_sz, "-%s ", tmp_name)) {
+			if (apol_render_sink_appendf(sink, "-%s ", tmp_name)) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -967,7 +1014,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 		qpol_iterator_destroy(&iter);
 		qpol_iterator_destroy(&iter2);
 		if (iter_sz + iter2_sz > 1) {
-			if (apol_str_append(&tmp, &tmp_sz, "} ")) {
+			if (apol_render_sink_append(sink, "} ")) {
 				error = errno;
 				ERR(policy, "%s", strerror(error));
 				goto err;
@@ -975,7 +1022,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 		}
 	}
 
-	if (apol_str_append(&tmp, &tmp_sz, ": ")) {
+	if (apol_render_sink_append(sink, ": ")) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
@@ -992,7 +1039,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 		goto err;
 	}
 	if (iter_sz > 1) {
-		if (apol_str_append(&tmp, &tmp_sz, "{ ")) {
+		if (apol_render_sink_append(sink, "{ ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -1008,7 +1055,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 			error = errno;
 			goto err;
 		}
-		if (apol_str_appendf(&tmp, &tmp_sz, "%s ", tmp_name)) {
+		if (apol_render_sink_appendf(sink, "%s ", tmp_name)) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -1016,7 +1063,7 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 	}
 	qpol_iterator_destroy(&iter);
 	if (iter_sz > 1) {
-		if (apol_str_append(&tmp, &tmp_sz, "} ")) {
+		if (apol_render_sink_append(sink, "} ")) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
@@ -1032,18 +1079,38 @@ char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule
 		error = errno;
 		goto err;
 	}
-	if (apol_str_appendf(&tmp, &tmp_sz, "%s;", tmp_name)) {
+	if (apol_render_sink_appendf(sink, "%s;", tmp_name)) {
 		error = errno;
 		ERR(policy, "%s", strerror(error));
 		goto err;
 	}
 
-	return tmp;
+	return 0;
 
       err:
-	free(tmp);
 	qpol_iterator_destroy(&iter);
 	qpol_iterator_destroy(&iter2);
 	errno = error;
-	return NULL;
+	return -1;
+}
+
+char *apol_syn_terule_render(const apol_policy_t * policy, const qpol_syn_terule_t * rule)
+{
+	apol_render_sink_t *sink = NULL;
+	char *tmp = NULL;
+	int error;
+
+	if ((sink = apol_render_sink_create_buffer()) == NULL) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return NULL;
+	}
+	if (apol_syn_terule_render_to_sink(policy, rule, sink) == 0 && (tmp = apol_render_sink_take_string(sink)) == NULL) {
+		ERR(policy, "%s", strerror(errno));
+	}
+	error = errno;
+	apol_render_sink_destroy(&sink);
+	errno = error;
+	return tmp;
 }
@@ -27,12 +27,16 @@
 #include "infoflow-analysis-internal.h"
 
 #include <errno.h>
+#include <pthread.h>
 #include <string.h>
+#include <unistd.h>
 
 struct apol_types_relation_analysis
 {
 	char *typeA, *typeB;
 	unsigned int analyses;
+	/** maximum number of threads, or 0 for one per processor */
+	size_t num_threads;
 };
 
 struct apol_types_relation_result
@@ -335,61 +339,56 @@ static int apol_types_relation_access_append_rule(const apol_policy_t * p, const
 }
 
 /**
- * The following builds separate databases to hold rules for typeA and
- * typeB respectively.  The database holds a vector of pointers to
- * apol_types_relation_access_t objects.  Then compare access lists
- * for typeA and typeB, determine common and unique access and have
- * easy access to the relevant rules.
+ * Build a database to hold the allow rules whose source is a type
+ * (or one of its attributes).  The database is a vector of pointers
+ * to apol_types_relation_access_t objects, one per target type and
+ * sorted by that type, so that two types' databases may be compared
+ * to determine common and unique access and have easy access to the
+ * relevant rules.
  *
  * @param p Policy to look up av rules.
- * @param typeA First type to build access list.
- * @param typeB Other type to build access list.
- * @param accessesA Vector of apol_types_relation_access_t for typeA.
- * @param accessesB Vector of apol_types_relation_access_t for typeB.
+ * @param type Type for which to build access list.
+ * @param accesses Reference to a vector of
+ * apol_types_relation_access_t to allocate.  The caller must call
+ * apol_vector_destroy() afterwards.
  *
  * @return 0 on success, < 0 on error.
  */
-static int apol_types_relation_create_access_pools(const apol_policy_t * p,
-						   const qpol_type_t * typeA,
-						   const qpol_type_t * typeB, apol_vector_t * accessesA, apol_vector_t * accessesB)
+static int apol_types_relation_access_pool(const apol_policy_t * p, const qpol_type_t * type, apol_vector_t ** accesses)
 {
-	const char *nameA, *nameB;
+	const char *name;
 	apol_avrule_query_t *aq = NULL;
-	apol_vector_t *vA = NULL, *vB = NULL;
+	apol_vector_t *v = NULL;
 	size_t i;
 	int retval = -1;
 
-	if (qpol_type_get_name(p->p, typeA, &nameA) < 0 || qpol_type_get_name(p->p, typeB, &nameB) < 0) {
+	*accesses = NULL;
+	if (qpol_type_get_name(p->p, type, &name) < 0) {
 		goto cleanup;
 	}
-	if ((aq = apol_avrule_query_create()) == NULL) {
+	if ((aq = apol_avrule_query_create()) == NULL || (*accesses = apol_vector_create(apol_types_relation_access_free)) == NULL) {
 		ERR(p, "%s", strerror(ENOMEM));
 		goto cleanup;
 	}
 	if (apol_avrule_query_set_rules(p, aq, QPOL_RULE_ALLOW) < 0 ||
-	    apol_avrule_query_set_source(p, aq, nameA, 1) < 0 ||
-	    apol_avrule_get_by_query(p, aq, &vA) < 0 ||
-	    apol_avrule_query_set_source(p, aq, nameB, 1) < 0 || apol_avrule_get_by_query(p, aq, &vB) < 0) {
+	    apol_avrule_query_set_source(p, aq, name, 1) < 0 || apol_avrule_get_by_query(p, aq, &v) < 0) {
 		goto cleanup;
 	}
-	for (i = 0; i < apol_vector_get_size(vA); i++) {
-		qpol_avrule_t *r = (qpol_avrule_t *) apol_vector_get_element(vA, i);
-		if (apol_types_relation_access_append_rule(p, r, accessesA) < 0) {
-			goto cleanup;
-		}
-	}
-	for (i = 0; i < apol_vector_get_size(vB); i++) {
-		qpol_avrule_t *r = (qpol_avrule_t *) apol_vector_get_element(vB, i);
-		if (apol_types_relation_access_append_rule(p, r, accessesB) < 0) {
+	for (i = 0; i < apol_vector_get_size(v); i++) {
+		qpol_avrule_t *r = (qpol_avrule_t *) apol_vector_get_element(v, i);
+		if (apol_types_relation_access_append_rule(p, r, *accesses) < 0) {
 			goto cleanup;
 		}
 	}
+	apol_vector_sort(*accesses, apol_types_relation_access_compfunc2, NULL);
 
 	retval = 0;
       cleanup:
 	apol_avrule_query_destroy(&aq);
-	apol_vector_destroy(&vA);
-	apol_vector_destroy(&vB);
+	apol_vector_destroy(&v);
+	if (retval != 0) {
+		apol_vector_destroy(accesses);
+	}
 	return retval;
 }
 
@@ -432,7 +431,8 @@ static int apol_types_relation_access_append(const apol_policy_t * p, const apol
  * typeB.
  *
  * @param p Policy containing types' information.
- * @param typeA First type to check.
+ * @param accessesA Access database for the first type, from
+ * apol_types_relation_access_pool().
  * @param typeB Other type to check.
  * @param do_similar 1 if to calculate similar accesses, 0 to skip.
  * @param do_dissimilar 1 if to calculate dissimilar accesses, 0 to skip.
@@ -441,25 +441,18 @@ static int apol_types_relation_access_append(const apol_policy_t * p, const apol
  * @return 0 on success, < 0 on error.
  */
 static int apol_types_relation_accesses(const apol_policy_t * p,
-					const qpol_type_t * typeA,
+					const apol_vector_t * accessesA,
 					const qpol_type_t * typeB, int do_similar, int do_dissimilar,
 					apol_types_relation_result_t * r)
 {
-	apol_vector_t *accessesA = NULL, *accessesB = NULL;
+	apol_vector_t *accessesB = NULL;
 	apol_types_relation_access_t *a, *b;
 	size_t i, j;
 	int retval = -1;
 
-	if ((accessesA = apol_vector_create(apol_types_relation_access_free)) == NULL
-	    || (accessesB = apol_vector_create(apol_types_relation_access_free)) == NULL) {
-		ERR(p, "%s", strerror(errno));
-		goto cleanup;
-	}
-	if (apol_types_relation_create_access_pools(p, typeA, typeB, accessesA, accessesB) < 0) {
+	if (apol_types_relation_access_pool(p, typeB, &accessesB) < 0) {
 		goto cleanup;
 	}
-	apol_vector_sort(accessesA, apol_types_relation_access_compfunc2, NULL);
-	apol_vector_sort(accessesB, apol_types_relation_access_compfunc2, NULL);
 
 	if (do_similar) {
 		if ((r->simA = apol_vector_create(apol_types_relation_access_free)) == NULL
@@ -521,7 +514,6 @@ static int apol_types_relation_accesses(const apol_policy_t * p,
 
 	retval = 0;
       cleanup:
-	apol_vector_destroy(&accessesA);
 	apol_vector_destroy(&accessesB);
 	return retval;
 }
@@ -695,73 +687,101 @@ static int apol_types_relation_clone_infoflow(const apol_policy_t * p, const apo
 }
 
 /**
- * Find all direct information flows between the two types.  Create a
- * vector of apol_infoflow_result_t and set r->dirflows to that vector.
+ * Find all direct information flows into and out of a type.  These
+ * are later filtered for each other type by
+ * apol_types_relation_directflow().
  *
  * @param p Policy containing types' information.
  * @param typeA First type to check.
- * @param typeB Other type to check.
- * @param r Result structure to fill.
+ * @param v Reference to a vector of apol_infoflow_result_t to
+ * allocate.  The caller must call apol_vector_destroy() afterwards.
  *
  * @return 0 on success, < 0 on error.
  */
-static int apol_types_relation_directflow(const apol_policy_t * p,
-					  const qpol_type_t * typeA, const qpol_type_t * typeB, apol_types_relation_result_t * r)
+static int apol_types_relation_directflow_from(const apol_policy_t * p, const qpol_type_t * typeA, apol_vector_t ** v)
 {
-	const char *nameA, *nameB;
+	const char *nameA;
 	apol_infoflow_analysis_t *ia = NULL;
-	apol_vector_t *v = NULL;
 	apol_infoflow_graph_t *g = NULL;
 	int retval = -1;
 
-	if (qpol_type_get_name(p->p, typeA, &nameA) < 0 || qpol_type_get_name(p->p, typeB, &nameB) < 0) {
+	*v = NULL;
+	if (qpol_type_get_name(p->p, typeA, &nameA) < 0) {
 		goto cleanup;
 	}
-	if ((r->dirflows = apol_vector_create(infoflow_result_free)) == NULL || (ia = apol_infoflow_analysis_create()) == NULL) {
+	if ((ia = apol_infoflow_analysis_create()) == NULL) {
 		ERR(p, "%s", strerror(ENOMEM));
 		goto cleanup;
 	}
 	if (apol_infoflow_analysis_set_mode(p, ia, APOL_INFOFLOW_MODE_DIRECT) < 0 ||
 	    apol_infoflow_analysis_set_dir(p, ia, APOL_INFOFLOW_EITHER) < 0 ||
-	    apol_infoflow_analysis_set_type(p, ia, nameA) < 0 || apol_infoflow_analysis_do(p, ia, &v, &g) < 0) {
-		goto cleanup;
-	}
-	if (apol_types_relation_clone_infoflow(p, v, nameB, r->dirflows) < 0) {
+	    apol_infoflow_analysis_set_type(p, ia, nameA) < 0 || apol_infoflow_analysis_do(p, ia, v, &g) < 0) {
 		goto cleanup;
 	}
 
 	retval = 0;
       cleanup:
-	apol_vector_destroy(&v);
 	apol_infoflow_analysis_destroy(&ia);
 	apol_infoflow_graph_destroy(&g);
 	return retval;
 }
 
 /**
- * Find (some) transitive information flows between the two types.
+ * Find all direct information flows between the two types.  Create a
+ * vector of apol_infoflow_result_t and set r->dirflows to that vector.
  *
  * @param p Policy containing types' information.
- * @param typeA First type to check.
+ * @param flowsA Direct flows of the first type, from
+ * apol_types_relation_directflow_from().
  * @param typeB Other type to check.
+ * @param r Result structure to fill.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int apol_types_relation_directflow(const apol_policy_t * p,
+					  const apol_vector_t * flowsA, const qpol_type_t * typeB, apol_types_relation_result_t * r)
+{
+	const char *nameB;
+	if (qpol_type_get_name(p->p, typeB, &nameB) < 0) {
+		return -1;
+	}
+	if ((r->dirflows = apol_vector_create(infoflow_result_free)) == NULL) {
+		ERR(p, "%s", strerror(ENOMEM));
+		return -1;
+	}
+	return apol_types_relation_clone_infoflow(p, flowsA, nameB, r->dirflows);
+}
+
+/**
+ * Find (some) transitive information flows between the first type
+ * and each of the other types.  All searches share one information
+ * flow graph.  Because a search colors the graph's nodes, searches
+ * run one after another.
+ *
+ * @param p Policy containing types' information.
+ * @param typeA First type to check.
+ * @param typesB Vector of other types (qpol_type_t) to check.
  * @param do_transAB 1 if to find paths from type A to B, 0 to skip.
  * @param do_transBA 1 if to find paths from type B to A, 0 to skip.
- * @param r Result structure to fill.
+ * @param results Vector of apol_types_relation_result_t to fill, one
+ * per element of typesB.
  *
  * @return 0 on success, < 0 on error.
  */
 static int apol_types_relation_transflow(const apol_policy_t * p,
 					 const qpol_type_t * typeA,
-					 const qpol_type_t * typeB,
-					 unsigned int do_transAB, unsigned int do_transBA, apol_types_relation_result_t * r)
+					 const apol_vector_t * typesB,
+					 unsigned int do_transAB, unsigned int do_transBA, const apol_vector_t * results)
 {
 	const char *nameA, *nameB;
 	apol_infoflow_analysis_t *ia = NULL;
 	apol_vector_t *v = NULL;
 	apol_infoflow_graph_t *g = NULL;
+	apol_types_relation_result_t *r;
+	size_t i;
 	int retval = -1;
 
-	if (qpol_type_get_name(p->p, typeA, &nameA) < 0 || qpol_type_get_name(p->p, typeB, &nameB) < 0) {
+	if (qpol_type_get_name(p->p, typeA, &nameA) < 0) {
 		goto cleanup;
 	}
 	if ((ia = apol_infoflow_analysis_create()) == NULL) {
@@ -776,19 +796,29 @@ static int apol_types_relation_transflow(const apol_policy_t * p,
 		if (apol_infoflow_analysis_set_type(p, ia, nameA) < 0 || apol_infoflow_analysis_do(p, ia, &v, &g) < 0) {
 			goto cleanup;
 		}
-		if ((r->transAB = apol_vector_create(infoflow_result_free)) == NULL) {
-			ERR(p, "%s", strerror(errno));
-			goto cleanup;
+		for (i = 0; i < apol_vector_get_size(typesB); i++) {
+			r = apol_vector_get_element(results, i);
+			if (qpol_type_get_name(p->p, apol_vector_get_element(typesB, i), &nameB) < 0) {
+				goto cleanup;
+			}
+			if ((r->transAB = apol_vector_create(infoflow_result_free)) == NULL) {
+				ERR(p, "%s", strerror(errno));
+				goto cleanup;
+			}
+			if (apol_types_relation_clone_infoflow(p, v, nameB, r->transAB) < 0) {
+				goto cleanup;
+			}
 		}
-		if (apol_types_relation_clone_infoflow(p, v, nameB, r->transAB) < 0) {
+	}
+	for (i = 0; do_transBA && i < apol_vector_get_size(typesB); i++) {
+		r = apol_vector_get_element(results, i);
+		if (qpol_type_get_name(p->p, apol_vector_get_element(typesB, i), &nameB) < 0) {
 			goto cleanup;
 		}
-	}
-	if (do_transBA) {
 		apol_vector_destroy(&v);
-		if ((do_transAB &&
+		if ((g != NULL &&
 		     apol_infoflow_analysis_do_more(p, g, nameB, &v) < 0) ||
-		    (!do_transAB &&
+		    (g == NULL &&
 		     (apol_infoflow_analysis_set_type(p, ia, nameB) < 0 || apol_infoflow_analysis_do(p, ia, &v, &g) < 0))) {
 			goto cleanup;
 		}
@@ -852,28 +882,33 @@ static int apol_types_relation_clone_domaintrans(const apol_policy_t * p, const
 }
 
 /**
- * Find domain transitions between the two types.
+ * Find domain transitions between the first type and each of the
+ * other types.  The policy's domain transition table is modified by
+ * each search, so searches run one after another.
  *
  * @param p Policy containing types' information.
  * @param typeA First type to check.
- * @param typeB Other type to check.
+ * @param typesB Vector of other types (qpol_type_t) to check.
  * @param do_domainAB 1 if to find transitions from type A to B, 0 to skip.
  * @param do_domainBA 1 if to find transitions from type B to A, 0 to skip.
- * @param r Result structure to fill.
+ * @param results Vector of apol_types_relation_result_t to fill, one
+ * per element of typesB.
  *
  * @return 0 on success, < 0 on error.
  */
 static int apol_types_relation_domain(apol_policy_t * p,
 				      const qpol_type_t * typeA,
-				      const qpol_type_t * typeB,
-				      unsigned int do_domainsAB, unsigned int do_domainsBA, apol_types_relation_result_t * r)
+				      const apol_vector_t * typesB,
+				      unsigned int do_domainsAB, unsigned int do_domainsBA, const apol_vector_t * results)
 {
 	const char *nameA, *nameB;
 	apol_domain_trans_analysis_t *dta = NULL;
 	apol_vector_t *v = NULL;
+	apol_types_relation_result_t *r;
+	size_t i;
 	int retval = -1;
 
-	if (qpol_type_get_name(p->p, typeA, &nameA) < 0 || qpol_type_get_name(p->p, typeB, &nameB) < 0) {
+	if (qpol_type_get_name(p->p, typeA, &nameA) < 0) {
 		goto cleanup;
 	}
 	if ((dta = apol_domain_trans_analysis_create()) == NULL) {
@@ -889,15 +924,25 @@ static int apol_types_relation_domain(apol_policy_t * p,
 		if (apol_domain_trans_analysis_set_start_type(p, dta, nameA) < 0 || apol_domain_trans_analysis_do(p, dta, &v) < 0) {
 			goto cleanup;
 		}
-		if ((r->domsAB = apol_vector_create(domain_trans_result_free)) == NULL) {
-			ERR(p, "%s", strerror(errno));
-			goto cleanup;
+		for (i = 0; i < apol_vector_get_size(typesB); i++) {
+			r = apol_vector_get_element(results, i);
+			if (qpol_type_get_name(p->p, apol_vector_get_element(typesB, i), &nameB) < 0) {
+				goto cleanup;
+			}
+			if ((r->domsAB = apol_vector_create(domain_trans_result_free)) == NULL) {
+				ERR(p, "%s", strerror(errno));
+				goto cleanup;
+			}
+			if (apol_types_relation_clone_domaintrans(p, v, nameB, r->domsAB) < 0) {
+				goto cleanup;
+			}
 		}
-		if (apol_types_relation_clone_domaintrans(p, v, nameB, r->domsAB) < 0) {
+	}
+	for (i = 0; do_domainsBA && i < apol_vector_get_size(typesB); i++) {
+		r = apol_vector_get_element(results, i);
+		if (qpol_type_get_name(p->p, apol_vector_get_element(typesB, i), &nameB) < 0) {
 			goto cleanup;
 		}
-	}
-	if (do_domainsBA) {
 		apol_vector_destroy(&v);
 		apol_policy_reset_domain_trans_table(p);
 		if (apol_domain_trans_analysis_set_start_type(p, dta, nameB) < 0 || apol_domain_trans_analysis_do(p, dta, &v) < 0) {
@@ -918,15 +963,254 @@ static int apol_types_relation_domain(apol_policy_t * p,
 	return retval;
 }
 
+/******************** running the analyses in parallel ********************/
+
+/* kinds of jobs into which an analysis is divided; those before
+ * TYPES_RELATION_JOB_COMMON are done once, the rest once per pair */
+#define TYPES_RELATION_JOB_TRANS 0
+#define TYPES_RELATION_JOB_DOMAIN 1
+#define TYPES_RELATION_JOB_ACCESS_POOL 2
+#define TYPES_RELATION_JOB_DIRECT_FROM 3
+#define TYPES_RELATION_JOB_COMMON 4
+#define TYPES_RELATION_JOB_RULES 5
+#define TYPES_RELATION_JOB_ACCESS 6
+#define TYPES_RELATION_JOB_DIRECT 7
+
+typedef struct types_relation_job
+{
+	int kind;
+	/** index of the other type, for per-pair jobs */
+	size_t pair;
+} types_relation_job_t;
+
+/** a message raised while jobs run, held until they finish */
+typedef struct types_relation_msg
+{
+	int level;
+	char *msg;
+} types_relation_msg_t;
+
+/**
+ * State shared by every job of one analysis.  Intermediate results
+ * that depend only upon the first type are each computed by a single
+ * job and are read-only afterwards.  Jobs are started in list order,
+ * and a job that needs such an intermediate result is always listed
+ * after the job that computes it; thus waiting for it never
+ * deadlocks.
+ */
+typedef struct types_relation_batch
+{
+	apol_policy_t *p;
+	unsigned int analyses;
+	const qpol_type_t *typeA;
+	/** vector of qpol_type_t, the other types */
+	apol_vector_t *typesB;
+	/** vector of apol_types_relation_result_t, one per other type */
+	apol_vector_t *results;
+	/** vector of apol_types_relation_access_t for the first type */
+	apol_vector_t *accessesA;
+	/** vector of apol_infoflow_result_t, the first type's direct flows */
+	apol_vector_t *dirflowsA;
+	int accessesA_ready, dirflowsA_ready;
+	types_relation_job_t *jobs;
+	size_t num_jobs, next_job;
+	/** non-zero once a job has failed, with that job's errno */
+	int failed, error;
+	/** vector of types_relation_msg_t */
+	apol_vector_t *msgs;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} types_relation_batch_t;
+
+static void types_relation_msg_free(void *msg)
+{
+	if (msg != NULL) {
+		free(((types_relation_msg_t *) msg)->msg);
+		free(msg);
+	}
+}
+
+/**
+ * Message callback installed while jobs run on other threads.  The
+ * policy's own callback need not be safe to call from those threads
+ * (e.g., it may update a user interface), so messages are saved here
+ * and later passed to it by the calling thread.
+ */
+static void types_relation_batch_msg(void *varg, const apol_policy_t * p __attribute__ ((unused)), int level, const char *fmt,
+				     va_list ap)
+{
+	types_relation_batch_t *b = (types_relation_batch_t *) varg;
+	types_relation_msg_t *m;
+	if ((m = calloc(1, sizeof(*m))) == NULL) {
+		return;
+	}
+	if (vasprintf(&m->msg, fmt, ap) < 0) {
+		free(m);
+		return;
+	}
+	m->level = level;
+	pthread_mutex_lock(&b->lock);
+	if (apol_vector_append(b->msgs, m) < 0) {
+		types_relation_msg_free(m);
+	}
+	pthread_mutex_unlock(&b->lock);
+}
+
+/**
+ * Wait until the job computing an intermediate result has finished.
+ *
+ * @param b Analysis state.
+ * @param ready Flag set once the result is available.
+ *
+ * @return 0 once ready, < 0 if some job failed in the meantime.
+ */
+static int types_relation_batch_wait(types_relation_batch_t * b, const int *ready)
+{
+	int retval;
+	pthread_mutex_lock(&b->lock);
+	while (!*ready && !b->failed) {
+		pthread_cond_wait(&b->cond, &b->lock);
+	}
+	retval = (*ready ? 0 : -1);
+	pthread_mutex_unlock(&b->lock);
+	return retval;
+}
+
+/**
+ * Run a single job.
+ *
+ * @param b Analysis state.
+ * @param job Job to run.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int types_relation_run_job(types_relation_batch_t * b, const types_relation_job_t * job)
+{
+	apol_policy_t *p = b->p;
+	unsigned int a = b->analyses;
+	const qpol_type_t *typeB = NULL;
+	apol_types_relation_result_t *r = NULL;
+	if (job->kind >= TYPES_RELATION_JOB_COMMON) {
+		typeB = apol_vector_get_element(b->typesB, job->pair);
+		r = apol_vector_get_element(b->results, job->pair);
+	}
+	switch (job->kind) {
+	case TYPES_RELATION_JOB_TRANS:
+		return apol_types_relation_transflow(p, b->typeA, b->typesB, a & APOL_TYPES_RELATION_TRANS_FLOW_AB,
+						     a & APOL_TYPES_RELATION_TRANS_FLOW_BA, b->results);
+	case TYPES_RELATION_JOB_DOMAIN:
+		return apol_types_relation_domain(p, b->typeA, b->typesB, a & APOL_TYPES_RELATION_DOMAIN_TRANS_AB,
+						  a & APOL_TYPES_RELATION_DOMAIN_TRANS_BA, b->results);
+	case TYPES_RELATION_JOB_ACCESS_POOL:
+		return apol_types_relation_access_pool(p, b->typeA, &b->accessesA);
+	case TYPES_RELATION_JOB_DIRECT_FROM:
+		return apol_types_relation_directflow_from(p, b->typeA, &b->dirflowsA);
+	case TYPES_RELATION_JOB_COMMON:
+		if (((a & APOL_TYPES_RELATION_COMMON_ATTRIBS) && apol_types_relation_common_attribs(p, b->typeA, typeB, r) < 0) ||
+		    ((a & APOL_TYPES_RELATION_COMMON_ROLES) && apol_types_relation_common_roles(p, b->typeA, typeB, r) < 0) ||
+		    ((a & APOL_TYPES_RELATION_COMMON_USERS) && apol_types_relation_common_users(p, b->typeA, typeB, r) < 0)) {
+			return -1;
+		}
+		return 0;
+	case TYPES_RELATION_JOB_RULES:
+		if (((a & APOL_TYPES_RELATION_ALLOW_RULES) && apol_types_relation_allows(p, b->typeA, typeB, r) < 0) ||
+		    ((a & APOL_TYPES_RELATION_TYPE_RULES) && apol_types_relation_types(p, b->typeA, typeB, r) < 0)) {
+			return -1;
+		}
+		return 0;
+	case TYPES_RELATION_JOB_ACCESS:
+		if (types_relation_batch_wait(b, &b->accessesA_ready) < 0) {
+			return -1;
+		}
+		return apol_types_relation_accesses(p, b->accessesA, typeB, a & APOL_TYPES_RELATION_SIMILAR_ACCESS,
+						    a & APOL_TYPES_RELATION_DISSIMILAR_ACCESS, r);
+	case TYPES_RELATION_JOB_DIRECT:
+		if (types_relation_batch_wait(b, &b->dirflowsA_ready) < 0) {
+			return -1;
+		}
+		return apol_types_relation_directflow(p, b->dirflowsA, typeB, r);
+	}
+	errno = EINVAL;
+	return -1;
+}
+
+/**
+ * Repeatedly take the next job from the list and run it, until none
+ * remain or a job has failed.
+ *
+ * @param x Analysis state.
+ *
+ * @return Always NULL.
+ */
+static void *types_relation_worker(void *x)
+{
+	types_relation_batch_t *b = (types_relation_batch_t *) x;
+	types_relation_job_t *job;
+	int retv, error;
+	for (;;) {
+		pthread_mutex_lock(&b->lock);
+		if (b->failed || b->next_job >= b->num_jobs) {
+			pthread_mutex_unlock(&b->lock);
+			break;
+		}
+		job = b->jobs + b->next_job++;
+		pthread_mutex_unlock(&b->lock);
+
+		retv = types_relation_run_job(b, job);
+		error = errno;
+
+		pthread_mutex_lock(&b->lock);
+		if (retv < 0) {
+			if (!b->failed) {
+				b->failed = 1;
+				b->error = error;
+			}
+		} else if (job->kind == TYPES_RELATION_JOB_ACCESS_POOL) {
+			b->accessesA_ready = 1;
+		} else if (job->kind == TYPES_RELATION_JOB_DIRECT_FROM) {
+			b->dirflowsA_ready = 1;
+		}
+		pthread_cond_broadcast(&b->cond);
+		pthread_mutex_unlock(&b->lock);
+	}
+	return NULL;
+}
+
+/**
+ * Look up a type for a types relation analysis.
+ *
+ * @param p Policy within which to look up the type.
+ * @param name Name of the type.
+ * @param type Location to write the type.
+ *
+ * @return 0 on success, < 0 if the type does not exist or is an
+ * attribute.
+ */
+static int types_relation_get_type(const apol_policy_t * p, const char *name, const qpol_type_t ** type)
+{
+	unsigned char isattr;
+	if (apol_query_get_type(p, name, type) < 0 || qpol_type_get_isattr(p->p, *type, &isattr) < 0) {
+		return -1;
+	}
+	if (isattr) {
+		ERR(p, "Symbol %s is an attribute.", name);
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+static void types_relation_result_free(void *result)
+{
+	apol_types_relation_result_t *r = (apol_types_relation_result_t *) result;
+	apol_types_relation_result_destroy(&r);
+}
+
 /******************** public functions below ********************/
 
 int apol_types_relation_analysis_do(apol_policy_t * p, const apol_types_relation_analysis_t * tr, apol_types_relation_result_t ** r)
 {
-	const qpol_type_t *typeA, *typeB;
-	unsigned char isattrA, isattrB;
-	unsigned int do_similar_access, do_dissimilar_access;
-	unsigned int do_transAB, do_transBA;
-	unsigned int do_domainAB, do_domainBA;
+	apol_vector_t *others = NULL, *v = NULL;
 	int retval = -1;
 	*r = NULL;
 
@@ -934,62 +1218,181 @@ int apol_types_relation_analysis_do(apol_policy_t * p, const apol_types_relation
 		ERR(p, "%s", strerror(EINVAL));
 		goto cleanup;
 	}
-	if (apol_query_get_type(p, tr->typeA, &typeA) < 0 ||
-	    apol_query_get_type(p, tr->typeB, &typeB) < 0 ||
-	    qpol_type_get_isattr(p->p, typeA, &isattrA) < 0 || qpol_type_get_isattr(p->p, typeB, &isattrB) < 0) {
+	if ((others = apol_vector_create_with_capacity(1, NULL)) == NULL || apol_vector_append(others, tr->typeB) < 0) {
+		ERR(p, "%s", strerror(errno));
 		goto cleanup;
 	}
-	if (isattrA) {
-		ERR(p, "Symbol %s is an attribute.", tr->typeA);
+	if (apol_types_relation_analysis_do_batch(p, tr, others, &v) < 0) {
 		goto cleanup;
 	}
-	if (isattrB) {
-		ERR(p, "Symbol %s is an attribute.", tr->typeB);
-		goto cleanup;
+	/* take the sole result before the vector destroys it */
+	*r = apol_vector_get_element(v, 0);
+	apol_vector_remove(v, 0);
+	retval = 0;
+      cleanup:
+	apol_vector_destroy(&others);
+	apol_vector_destroy(&v);
+	return retval;
+}
+
+int apol_types_relation_analysis_do_batch(apol_policy_t * p, const apol_types_relation_analysis_t * tr,
+					  const apol_vector_t * others, apol_vector_t ** v)
+{
+	types_relation_batch_t b;
+	apol_callback_fn_t msg_callback = NULL;
+	void *msg_callback_arg = NULL;
+	pthread_t *threads = NULL;
+	const qpol_type_t *type;
+	apol_types_relation_result_t *r;
+	size_t i, num_pairs, num_threads, num_started = 0;
+	long ncpu;
+	int have_sync = 0, retval = -1, error = 0;
+
+	if (v != NULL) {
+		*v = NULL;
 	}
-	if ((*r = calloc(1, sizeof(**r))) == NULL) {
-		ERR(p, "%s", strerror(ENOMEM));
-		goto cleanup;
+	memset(&b, 0, sizeof(b));
+	if (p == NULL || tr == NULL || others == NULL || v == NULL || tr->typeA == NULL) {
+		ERR(p, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
 	}
-	if ((tr->analyses & APOL_TYPES_RELATION_COMMON_ATTRIBS) && apol_types_relation_common_attribs(p, typeA, typeB, *r) < 0) {
+	b.p = p;
+	b.analyses = tr->analyses;
+	num_pairs = apol_vector_get_size(others);
+	if (types_relation_get_type(p, tr->typeA, &b.typeA) < 0) {
+		error = errno;
 		goto cleanup;
 	}
-	if ((tr->analyses & APOL_TYPES_RELATION_COMMON_ROLES) && apol_types_relation_common_roles(p, typeA, typeB, *r) < 0) {
+	if ((b.typesB = apol_vector_create_with_capacity(num_pairs, NULL)) == NULL ||
+	    (*v = apol_vector_create_with_capacity(num_pairs, types_relation_result_free)) == NULL ||
+	    (b.msgs = apol_vector_create(types_relation_msg_free)) == NULL) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
 		goto cleanup;
 	}
-	if ((tr->analyses & APOL_TYPES_RELATION_COMMON_USERS) && apol_types_relation_common_users(p, typeA, typeB, *r) < 0) {
-		goto cleanup;
+	for (i = 0; i < num_pairs; i++) {
+		r = NULL;
+		if (types_relation_get_type(p, apol_vector_get_element(others, i), &type) < 0) {
+			error = errno;
+			goto cleanup;
+		}
+		if (apol_vector_append(b.typesB, (void *)type) < 0 ||
+		    (r = calloc(1, sizeof(*r))) == NULL || apol_vector_append(*v, r) < 0) {
+			error = errno;
+			ERR(p, "%s", strerror(error));
+			free(r);
+			goto cleanup;
+		}
 	}
-	do_similar_access = tr->analyses & APOL_TYPES_RELATION_SIMILAR_ACCESS;
-	do_dissimilar_access = tr->analyses & APOL_TYPES_RELATION_DISSIMILAR_ACCESS;
-	if ((do_similar_access || do_dissimilar_access) &&
-	    apol_types_relation_accesses(p, typeA, typeB, do_similar_access, do_dissimilar_access, *r) < 0) {
+	b.results = *v;
+
+	/* the transitive flow and domain transition jobs each run
+	 * serially through every pair, so start them first */
+	if ((b.jobs = calloc(4 + 4 * num_pairs, sizeof(*b.jobs))) == NULL) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
 		goto cleanup;
 	}
-	if ((tr->analyses & APOL_TYPES_RELATION_ALLOW_RULES) && apol_types_relation_allows(p, typeA, typeB, *r) < 0) {
-		goto cleanup;
+	if (b.analyses & (APOL_TYPES_RELATION_TRANS_FLOW_AB | APOL_TYPES_RELATION_TRANS_FLOW_BA)) {
+		b.jobs[b.num_jobs++].kind = TYPES_RELATION_JOB_TRANS;
 	}
-	if ((tr->analyses & APOL_TYPES_RELATION_TYPE_RULES) && apol_types_relation_types(p, typeA, typeB, *r) < 0) {
-		goto cleanup;
+	if (b.analyses & (APOL_TYPES_RELATION_DOMAIN_TRANS_AB | APOL_TYPES_RELATION_DOMAIN_TRANS_BA)) {
+		b.jobs[b.num_jobs++].kind = TYPES_RELATION_JOB_DOMAIN;
+	}
+	if (b.analyses & (APOL_TYPES_RELATION_SIMILAR_ACCESS | APOL_TYPES_RELATION_DISSIMILAR_ACCESS)) {
+		b.jobs[b.num_jobs++].kind = TYPES_RELATION_JOB_ACCESS_POOL;
+	}
+	if (b.analyses & APOL_TYPES_RELATION_DIRECT_FLOW) {
+		b.jobs[b.num_jobs++].kind = TYPES_RELATION_JOB_DIRECT_FROM;
+	}
+	for (i = 0; i < num_pairs; i++) {
+		if (b.analyses & (APOL_TYPES_RELATION_COMMON_ATTRIBS | APOL_TYPES_RELATION_COMMON_ROLES |
+				  APOL_TYPES_RELATION_COMMON_USERS)) {
+			b.jobs[b.num_jobs].kind = TYPES_RELATION_JOB_COMMON;
+			b.jobs[b.num_jobs++].pair = i;
+		}
+		if (b.analyses & (APOL_TYPES_RELATION_ALLOW_RULES | APOL_TYPES_RELATION_TYPE_RULES)) {
+			b.jobs[b.num_jobs].kind = TYPES_RELATION_JOB_RULES;
+			b.jobs[b.num_jobs++].pair = i;
+		}
+		if (b.analyses & (APOL_TYPES_RELATION_SIMILAR_ACCESS | APOL_TYPES_RELATION_DISSIMILAR_ACCESS)) {
+			b.jobs[b.num_jobs].kind = TYPES_RELATION_JOB_ACCESS;
+			b.jobs[b.num_jobs++].pair = i;
+		}
+		if (b.analyses & APOL_TYPES_RELATION_DIRECT_FLOW) {
+			b.jobs[b.num_jobs].kind = TYPES_RELATION_JOB_DIRECT;
+			b.jobs[b.num_jobs++].pair = i;
+		}
+	}
+
+	num_threads = tr->num_threads;
+	if (num_threads == 0) {
+		ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		num_threads = (ncpu > 0 ? (size_t)ncpu : 1);
 	}
-	if ((tr->analyses & APOL_TYPES_RELATION_DIRECT_FLOW) && apol_types_relation_directflow(p, typeA, typeB, *r) < 0) {
+	if (num_threads > b.num_jobs) {
+		num_threads = b.num_jobs;
+	}
+	if (pthread_mutex_init(&b.lock, NULL) != 0) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
 		goto cleanup;
 	}
-	do_transAB = tr->analyses & APOL_TYPES_RELATION_TRANS_FLOW_AB;
-	do_transBA = tr->analyses & APOL_TYPES_RELATION_TRANS_FLOW_BA;
-	if ((do_transAB || do_transBA) && apol_types_relation_transflow(p, typeA, typeB, do_transAB, do_transBA, *r) < 0) {
+	if (pthread_cond_init(&b.cond, NULL) != 0) {
+		error = errno;
+		ERR(p, "%s", strerror(error));
+		pthread_mutex_destroy(&b.lock);
 		goto cleanup;
 	}
-	do_domainAB = tr->analyses & APOL_TYPES_RELATION_DOMAIN_TRANS_AB;
-	do_domainBA = tr->analyses & APOL_TYPES_RELATION_DOMAIN_TRANS_BA;
-	if ((do_domainAB || do_domainBA) && apol_types_relation_domain(p, typeA, typeB, do_domainAB, do_domainBA, *r) < 0) {
+	have_sync = 1;
+	if (num_threads > 1 && (threads = calloc(num_threads - 1, sizeof(*threads))) != NULL) {
+		if (p->msg_callback != NULL) {
+			msg_callback = p->msg_callback;
+			msg_callback_arg = p->msg_callback_arg;
+			p->msg_callback = types_relation_batch_msg;
+			p->msg_callback_arg = &b;
+		}
+		/* if a thread cannot be created then the remaining
+		 * threads take up its share of the jobs */
+		for (; num_started < num_threads - 1; num_started++) {
+			if (pthread_create(threads + num_started, NULL, types_relation_worker, &b) != 0) {
+				break;
+			}
+		}
+	}
+	types_relation_worker(&b);
+	for (i = 0; i < num_started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	if (msg_callback != NULL) {
+		p->msg_callback = msg_callback;
+		p->msg_callback_arg = msg_callback_arg;
+		for (i = 0; i < apol_vector_get_size(b.msgs); i++) {
+			types_relation_msg_t *m = apol_vector_get_element(b.msgs, i);
+			apol_handle_msg(p, m->level, "%s", m->msg);
+		}
+	}
+	if (b.failed) {
+		error = b.error;
 		goto cleanup;
 	}
 
 	retval = 0;
       cleanup:
+	if (have_sync) {
+		pthread_cond_destroy(&b.cond);
+		pthread_mutex_destroy(&b.lock);
+	}
+	free(threads);
+	free(b.jobs);
+	apol_vector_destroy(&b.typesB);
+	apol_vector_destroy(&b.accessesA);
+	apol_vector_destroy(&b.dirflowsA);
+	apol_vector_destroy(&b.msgs);
 	if (retval != 0) {
-		apol_types_relation_result_destroy(r);
+		apol_vector_destroy(v);
+		errno = error;
 	}
 	return retval;
 }
@@ -1027,6 +1430,13 @@ int apol_types_relation_analysis_set_other_type(const apol_policy_t * p, apol_ty
 	return apol_query_set(p, &tr->typeB, NULL, name);
 }
 
+int apol_types_relation_analysis_set_threads(const apol_policy_t * p __attribute__ ((unused)),
+					     apol_types_relation_analysis_t * tr, size_t num_threads)
+{
+	tr->num_threads = num_threads;
+	return 0;
+}
+
 int apol_types_relation_analysis_set_analyses(const apol_policy_t * p __attribute__ ((unused)),
 					      apol_types_relation_analysis_t * tr, unsigned int analyses)
 {
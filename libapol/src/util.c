@@ -657,3 +657,13 @@ void *apol_str_strdup(const void *elem, void *unused __attribute__ ((unused)))
 {
 	return strdup((const char *)elem);
 }
+
+size_t apol_str_hash(const char *s)
+{
+	uint32_t h = 2166136261U;
+	for (; *s != '\0'; s++) {
+		h ^= (unsigned char)*s;
+		h *= 16777619U;
+	}
+	return (size_t)h;
+}
@@ -26,6 +26,10 @@
 #ifndef APOL_VECTOR_INTERNAL_H
 #define APOL_VECTOR_INTERNAL_H
 
+#include <apol/bst.h>
+#include <apol/hashset.h>
+#include <apol/vector.h>
+
 /**
  * Change the free function of a vector.  Currently, this function is
  * friends with the BST class; otherwise consider this to be a private
@@ -33,4 +37,23 @@
  */
 void vector_set_free_func(apol_vector_t * v, apol_vector_free_func * fr);
 
+/**
+ * Return the number of bytes used by a vector, not counting the
+ * elements that it stores.  A NULL vector uses no bytes.
+ */
+size_t vector_get_footprint(const apol_vector_t * v);
+
+/**
+ * Return the number of bytes used by a BST and its nodes, not
+ * counting the elements that it stores.  A NULL BST uses no bytes.
+ */
+size_t bst_get_footprint(const apol_bst_t * b);
+
+/**
+ * Return the number of bytes used by a hashset and its slots, not
+ * counting the elements that it stores.  A NULL hashset uses no
+ * bytes.
+ */
+size_t hashset_get_footprint(const apol_hashset_t * h);
+
 #endif
@@ -27,6 +27,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
 
 /** The default initial capacity of a vector; must be a positive integer */
 #define APOL_VECTOR_DFLT_INIT_CAP 10
@@ -46,6 +48,8 @@ struct apol_vector
 	apol_vector_free_func *fr;
 };
 
+static int apol_vector_grow(apol_vector_t * v);
+
 apol_vector_t *apol_vector_create(apol_vector_free_func * fr)
 {
 	return apol_vector_create_with_capacity(APOL_VECTOR_DFLT_INIT_CAP, fr);
@@ -77,19 +81,37 @@ apol_vector_t *apol_vector_create_from_iter(qpol_iterator_t * iter, apol_vector_
 {
 	size_t iter_size;
 	apol_vector_t *v;
-	void *item;
-	int error;
+	int num_items, error;
 	if (qpol_iterator_get_size(iter, &iter_size) < 0 || (v = apol_vector_create_with_capacity(iter_size, fr)) == NULL) {
 		return NULL;
 	}
-	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
-		if (qpol_iterator_get_item(iter, &item)) {
+	/* fetch items straight into the vector's array, growing it only
+	 * if the iterator's size was an underestimate */
+	for (;;) {
+		if (v->size >= v->capacity) {
+			if (qpol_iterator_end(iter)) {
+				break;
+			}
+			if (apol_vector_grow(v)) {
+				error = errno;
+				free(v->array);
+				free(v);
+				errno = error;
+				return NULL;
+			}
+		}
+		num_items = qpol_iterator_next_batch(iter, v->array + v->size, v->capacity - v->size);
+		if (num_items < 0) {
 			error = errno;
+			free(v->array);
 			free(v);
 			errno = error;
 			return NULL;
 		}
-		apol_vector_append(v, item);
+		if (num_items == 0) {
+			break;
+		}
+		v->size += num_items;
 	}
 	return v;
 }
@@ -292,35 +314,230 @@ int apol_vector_compare(const apol_vector_t * a, const apol_vector_t * b, apol_v
 	}
 }
 
-static size_t vector_qsort_partition(void **data, size_t first, size_t last, apol_vector_comp_func * cmp, void *arg)
+/** ranges of at most this many elements are insertion sorted */
+#define VECTOR_INSERTION_SORT_THRESHOLD 16
+/** vectors smaller than this are not worth sorting in parallel */
+#define VECTOR_PARALLEL_SORT_THRESHOLD 65536
+
+/**
+ * Stable insertion sort, used to finish off small ranges.
+ */
+static void vector_insertion_sort(void **a, size_t n, apol_vector_comp_func * cmp, void *arg)
+{
+	size_t i, j;
+	void *x;
+	for (i = 1; i < n; i++) {
+		x = a[i];
+		for (j = i; j > 0 && cmp(a[j - 1], x, arg) > 0; j--) {
+			a[j] = a[j - 1];
+		}
+		a[j] = x;
+	}
+}
+
+static void vector_sift_down(void **a, size_t root, size_t n, apol_vector_comp_func * cmp, void *arg)
+{
+	void *x = a[root];
+	size_t child;
+	while ((child = 2 * root + 1) < n) {
+		if (child + 1 < n && cmp(a[child], a[child + 1], arg) < 0) {
+			child++;
+		}
+		if (cmp(x, a[child], arg) >= 0) {
+			break;
+		}
+		a[root] = a[child];
+		root = child;
+	}
+	a[root] = x;
+}
+
+/**
+ * Heapsort, used by the introsort when partitioning degenerates.
+ */
+static void vector_heapsort(void **a, size_t n, apol_vector_comp_func * cmp, void *arg)
+{
+	size_t i;
+	void *t;
+	for (i = n / 2; i > 0; i--) {
+		vector_sift_down(a, i - 1, n, cmp, arg);
+	}
+	for (i = n - 1; i > 0; i--) {
+		t = a[0];
+		a[0] = a[i];
+		a[i] = t;
+		vector_sift_down(a, 0, i, cmp, arg);
+	}
+}
+
+/**
+ * Partition a range of at least 3 elements about the median of its
+ * first, middle, and last elements.
+ *
+ * @return Index p such that every element in [0, p) is no greater
+ * than every element in [p, n).  Both halves are non-empty.
+ */
+static size_t vector_introsort_partition(void **a, size_t n, apol_vector_comp_func * cmp, void *arg)
 {
-	void *pivot = data[last];
-	size_t i = first, j = last;
-	while (i < j) {
-		if (cmp(data[i], pivot, arg) <= 0) {
+	size_t mid = n / 2, i = 0, j = n - 1;
+	void *pivot, *t;
+	/* order the three samples; afterwards a[0] and a[n - 1] act
+	 * as sentinels for the scans below */
+	if (cmp(a[mid], a[0], arg) < 0) {
+		t = a[mid];
+		a[mid] = a[0];
+		a[0] = t;
+	}
+	if (cmp(a[n - 1], a[mid], arg) < 0) {
+		t = a[n - 1];
+		a[n - 1] = a[mid];
+		a[mid] = t;
+		if (cmp(a[mid], a[0], arg) < 0) {
+			t = a[mid];
+			a[mid] = a[0];
+			a[0] = t;
+		}
+	}
+	pivot = a[mid];
+	for (;;) {
+		do {
 			i++;
-		} else {
-			data[j] = data[i];
-			data[i] = data[j - 1];
+		} while (cmp(a[i], pivot, arg) < 0);
+		do {
 			j--;
+		} while (cmp(pivot, a[j], arg) < 0);
+		if (i >= j) {
+			return i;
 		}
+		t = a[i];
+		a[i] = a[j];
+		a[j] = t;
 	}
-	data[j] = pivot;
-	return j;
 }
 
-static void vector_qsort(void **data, size_t first, size_t last, apol_vector_comp_func * cmp, void *arg)
+/**
+ * Introsort: quicksort with median-of-three pivots, falling back to
+ * heapsort once the recursion exceeds depth so that the worst case
+ * remains O(n log n).  Only the smaller half is recursed into, so
+ * the stack depth is O(log n).
+ */
+static void vector_introsort(void **a, size_t n, apol_vector_comp_func * cmp, void *arg, size_t depth)
 {
-	if (first < last) {
-		size_t i = vector_qsort_partition(data, first, last, cmp, arg);
-		/* need this explicit check here, because i is an
-		 * unsigned integer, and subtracting 1 from 0 is
-		 * bad */
-		if (i > 0) {
-			vector_qsort(data, first, i - 1, cmp, arg);
+	size_t p;
+	while (n > VECTOR_INSERTION_SORT_THRESHOLD) {
+		if (depth == 0) {
+			vector_heapsort(a, n, cmp, arg);
+			return;
+		}
+		depth--;
+		p = vector_introsort_partition(a, n, cmp, arg);
+		if (p < n - p) {
+			vector_introsort(a, p, cmp, arg, depth);
+			a += p;
+			n -= p;
+		} else {
+			vector_introsort(a + p, n - p, cmp, arg, depth);
+			n = p;
 		}
-		vector_qsort(data, i + 1, last, cmp, arg);
 	}
+	vector_insertion_sort(a, n, cmp, arg);
+}
+
+/**
+ * Merge the sorted runs [0, mid) and [mid, n) of a.  Upon ties the
+ * element from the first run wins, keeping the merge stable.
+ *
+ * @param tmp Scratch space of at least mid elements.
+ */
+static void vector_merge(void **a, size_t mid, size_t n, void **tmp, apol_vector_comp_func * cmp, void *arg)
+{
+	size_t i = 0, j = mid, k = 0;
+	if (mid == 0 || mid == n || cmp(a[mid - 1], a[mid], arg) <= 0) {
+		/* runs are already in order */
+		return;
+	}
+	memcpy(tmp, a, mid * sizeof(*a));
+	while (i < mid && j < n) {
+		if (cmp(a[j], tmp[i], arg) < 0) {
+			a[k++] = a[j++];
+		} else {
+			a[k++] = tmp[i++];
+		}
+	}
+	while (i < mid) {
+		a[k++] = tmp[i++];
+	}
+}
+
+/**
+ * Stable top-down merge sort.
+ *
+ * @param tmp Scratch space of at least n elements.
+ */
+static void vector_mergesort(void **a, size_t n, void **tmp, apol_vector_comp_func * cmp, void *arg)
+{
+	size_t mid;
+	if (n <= VECTOR_INSERTION_SORT_THRESHOLD) {
+		vector_insertion_sort(a, n, cmp, arg);
+		return;
+	}
+	mid = n / 2;
+	vector_mergesort(a, mid, tmp, cmp, arg);
+	vector_mergesort(a + mid, n - mid, tmp + mid, cmp, arg);
+	vector_merge(a, mid, n, tmp, cmp, arg);
+}
+
+struct vector_sort_task
+{
+	void **a, **tmp;
+	size_t n;
+	apol_vector_comp_func *cmp;
+	void *arg;
+	/** number of threads, including the calling one, that may
+	 *  work on this range */
+	size_t num_threads;
+};
+
+static void vector_parallel_mergesort(struct vector_sort_task *t);
+
+static void *vector_parallel_mergesort_thread(void *x)
+{
+	vector_parallel_mergesort((struct vector_sort_task *)x);
+	return NULL;
+}
+
+/**
+ * Merge sort that hands the first half of each split to a new thread
+ * while the calling thread sorts the second half, until the thread
+ * budget is spent.  If a thread cannot be created then its share of
+ * the work is done by the calling thread instead.
+ */
+static void vector_parallel_mergesort(struct vector_sort_task *t)
+{
+	struct vector_sort_task left, right;
+	pthread_t tid;
+	size_t mid;
+	if (t->num_threads < 2 || t->n < VECTOR_PARALLEL_SORT_THRESHOLD / 2) {
+		vector_mergesort(t->a, t->n, t->tmp, t->cmp, t->arg);
+		return;
+	}
+	mid = t->n / 2;
+	left = *t;
+	left.n = mid;
+	left.num_threads = t->num_threads / 2;
+	right = *t;
+	right.a += mid;
+	right.tmp += mid;
+	right.n -= mid;
+	right.num_threads = t->num_threads - left.num_threads;
+	if (pthread_create(&tid, NULL, vector_parallel_mergesort_thread, &left) != 0) {
+		vector_parallel_mergesort(&left);
+		vector_parallel_mergesort(&right);
+	} else {
+		vector_parallel_mergesort(&right);
+		pthread_join(tid, NULL);
+	}
+	vector_merge(t->a, mid, t->n, t->tmp, t->cmp, t->arg);
 }
 
 /**
@@ -339,9 +556,10 @@ static int vector_int_comp(const void *a, const void *b, void *data __attribute_
 	return 0;
 }
 
-/* implemented as an in-place quicksort */
+/* implemented as an in-place introsort */
 void apol_vector_sort(apol_vector_t * v, apol_vector_comp_func * cmp, void *data)
 {
+	size_t depth = 0, n;
 	if (!v) {
 		errno = EINVAL;
 		return;
@@ -349,9 +567,63 @@ void apol_vector_sort(apol_vector_t * v, apol_vector_comp_func * cmp, void *data
 	if (cmp == NULL) {
 		cmp = vector_int_comp;
 	}
-	if (v->size > 1) {
-		vector_qsort(v->array, 0, v->size - 1, cmp, data);
+	for (n = v->size; n > 1; n >>= 1) {
+		depth += 2;
+	}
+	vector_introsort(v->array, v->size, cmp, data, depth);
+}
+
+int apol_vector_sort_stable(apol_vector_t * v, apol_vector_comp_func * cmp, void *data)
+{
+	void **tmp;
+	if (!v) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (cmp == NULL) {
+		cmp = vector_int_comp;
+	}
+	if (v->size <= VECTOR_INSERTION_SORT_THRESHOLD) {
+		vector_insertion_sort(v->array, v->size, cmp, data);
+		return 0;
+	}
+	if ((tmp = malloc(v->size * sizeof(*tmp))) == NULL) {
+		return -1;
+	}
+	vector_mergesort(v->array, v->size, tmp, cmp, data);
+	free(tmp);
+	return 0;
+}
+
+int apol_vector_sort_parallel(apol_vector_t * v, apol_vector_comp_func * cmp, void *data, size_t num_threads)
+{
+	struct vector_sort_task t;
+	long ncpu;
+	if (!v) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (num_threads == 0) {
+		ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		num_threads = (ncpu > 0 ? (size_t)ncpu : 1);
 	}
+	if (num_threads < 2 || v->size < VECTOR_PARALLEL_SORT_THRESHOLD) {
+		return apol_vector_sort_stable(v, cmp, data);
+	}
+	if (cmp == NULL) {
+		cmp = vector_int_comp;
+	}
+	t.a = v->array;
+	t.n = v->size;
+	t.cmp = cmp;
+	t.arg = data;
+	t.num_threads = num_threads;
+	if ((t.tmp = malloc(v->size * sizeof(*t.tmp))) == NULL) {
+		return -1;
+	}
+	vector_parallel_mergesort(&t);
+	free(t.tmp);
+	return 0;
 }
 
 void apol_vector_sort_uniquify(apol_vector_t * v, apol_vector_comp_func * cmp, void *data)
@@ -449,9 +721,31 @@ int apol_vector_remove(apol_vector_t * v, const size_t idx)
 	return 0;
 }
 
+int apol_vector_truncate(apol_vector_t * v, size_t size)
+{
+	if (v == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	for (; v->size > size; v->size--) {
+		if (v->fr != NULL) {
+			v->fr(v->array[v->size - 1]);
+		}
+	}
+	return 0;
+}
+
 /******************** friend function below ********************/
 
 void vector_set_free_func(apol_vector_t * v, apol_vector_free_func * fr)
 {
 	v->fr = fr;
 }
+
+size_t vector_get_footprint(const apol_vector_t * v)
+{
+	if (v == NULL) {
+		return 0;
+	}
+	return sizeof(*v) + v->capacity * sizeof(*v->array);
+}
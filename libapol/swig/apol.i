@@ -652,6 +652,15 @@ typedef struct apol_policy {} apol_policy_t;
 	void reset_domain_trans_table() {
 		apol_policy_reset_domain_trans_table(self);
 	}
+	void build_relabel_index() {
+		BEGIN_EXCEPTION
+		if (apol_policy_build_relabel_index(self)) {
+			SWIG_exception(SWIG_RuntimeError, "Could not build relabel index");
+		}
+		END_EXCEPTION
+	fail:
+		return;
+	};
 };
 
 /* apol type query */
@@ -3267,7 +3276,8 @@ typedef struct apol_relabel_analysis {} apol_relabel_analysis_t;
 	apol_vector_t *run(apol_policy_t *p) {
 		apol_vector_t *v;
 		BEGIN_EXCEPTION
-		if (apol_relabel_analysis_do(p, self, &v)) {
+		/* the index pays for itself after a single analysis */
+		if (apol_policy_build_relabel_index(p) || apol_relabel_analysis_do(p, self, &v)) {
 			SWIG_exception(SWIG_RuntimeError, "Could not run relabel analysis");
 		}
 		END_EXCEPTION
@@ -3420,6 +3430,17 @@ typedef struct apol_types_relation_analysis {} apol_types_relation_analysis_t;
 	fail:
 		return res;
 	};
+	%newobject run_batch(apol_policy_t*, apol_string_vector_t*);
+	apol_vector_t *run_batch(apol_policy_t *p, apol_string_vector_t *others) {
+		apol_vector_t *v;
+		BEGIN_EXCEPTION
+		if (apol_types_relation_analysis_do_batch(p, self, (apol_vector_t*)others, &v)) {
+			SWIG_exception(SWIG_RuntimeError, "Could not run types relation analysis");
+		}
+		END_EXCEPTION
+	fail:
+		return v;
+	};
 	void set_first_type(apol_policy_t *p, char *name) {
 		BEGIN_EXCEPTION
 		if (apol_types_relation_analysis_set_first_type(p, self, name)) {
@@ -3447,6 +3468,9 @@ typedef struct apol_types_relation_analysis {} apol_types_relation_analysis_t;
 	fail:
 		return;
 	};
+	void set_threads(apol_policy_t *p, size_t num_threads) {
+		apol_types_relation_analysis_set_threads(p, self, num_threads);
+	};
 };
 typedef struct apol_types_relation_result {} apol_types_relation_result_t;
 %extend apol_types_relation_result_t {
@@ -27,10 +27,15 @@
 
 #include <CUnit/CUnit.h>
 #include <apol/avrule-query.h>
+#include <apol/compute-av.h>
+#include <apol/mls_range.h>
 #include <apol/policy.h>
 #include <apol/policy-path.h>
+#include <apol/render.h>
+#include <apol/util.h>
 #include <qpol/policy_extend.h>
 #include <stdbool.h>
+#include <string.h>
 
 #define BIN_POLICY TEST_POLICIES "/setools-3.3/rules/rules-mls.21"
 #define SOURCE_POLICY TEST_POLICIES "/setools-3.3/rules/rules-mls.conf"
@@ -114,11 +119,211 @@ static void avrule_default(void)
 	apol_avrule_query_destroy(&aq);
 }
 
+static void avrule_render_sink(void)
+{
+	apol_avrule_query_t *aq = apol_avrule_query_create();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(aq);
+
+	apol_vector_t *v = NULL;
+	int retval = apol_avrule_get_by_query(bp, aq, &v);
+	CU_ASSERT_EQUAL_FATAL(retval, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	CU_ASSERT(apol_vector_get_size(v) > 0);
+
+	/* rendering into a reused sink must match the allocating renderer */
+	apol_render_sink_t *sink = apol_render_sink_create_buffer();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(sink);
+	CU_ASSERT_STRING_EQUAL(apol_render_sink_get_string(sink), "");
+	size_t i;
+	for (i = 0; i < apol_vector_get_size(v); i++) {
+		const qpol_avrule_t *rule = (const qpol_avrule_t *)apol_vector_get_element(v, i);
+		char *s = apol_avrule_render(bp, rule);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(s);
+		apol_render_sink_clear(sink);
+		retval = apol_avrule_render_to_sink(bp, rule, sink);
+		CU_ASSERT_EQUAL(retval, 0);
+		CU_ASSERT_STRING_EQUAL(apol_render_sink_get_string(sink), s);
+		CU_ASSERT_EQUAL(apol_render_sink_get_length(sink), strlen(s));
+		free(s);
+	}
+
+	/* appending accumulates; taking the string empties the sink */
+	apol_render_sink_clear(sink);
+	retval = apol_render_sink_append(sink, "allow");
+	CU_ASSERT_EQUAL(retval, 0);
+	retval = apol_render_sink_putc(sink, ' ');
+	CU_ASSERT_EQUAL(retval, 0);
+	for (i = 0; i < 1000; i++) {
+		retval = apol_render_sink_appendf(sink, "%zd ", i);
+		CU_ASSERT_EQUAL(retval, 0);
+	}
+	char *s = apol_render_sink_take_string(sink);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(s);
+	CU_ASSERT(strncmp(s, "allow 0 1 2 ", 12) == 0);
+	CU_ASSERT(strlen(s) == strlen("allow ") + 10 * 2 + 90 * 3 + 900 * 4);
+	free(s);
+	CU_ASSERT_EQUAL(apol_render_sink_get_length(sink), 0);
+	CU_ASSERT_STRING_EQUAL(apol_render_sink_get_string(sink), "");
+	retval = apol_render_sink_append(sink, "x");
+	CU_ASSERT(retval == 0 && strcmp(apol_render_sink_get_string(sink), "x") == 0);
+
+	apol_render_sink_destroy(&sink);
+	CU_ASSERT_PTR_NULL(sink);
+	apol_vector_destroy(&v);
+	apol_avrule_query_destroy(&aq);
+}
+
+/**
+ * Create a context with the policy's first user, that user's first
+ * role and range, and the given type.
+ */
+static apol_context_t *avrule_make_context(apol_policy_t * ap, const char *type)
+{
+	qpol_policy_t *q = apol_policy_get_qpol(ap);
+	qpol_iterator_t *iter = NULL;
+	const qpol_user_t *user;
+	const qpol_role_t *role;
+	const qpol_mls_range_t *range;
+	const char *name;
+	apol_context_t *c = apol_context_create();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(c);
+
+	CU_ASSERT_EQUAL_FATAL(qpol_policy_get_user_iter(q, &iter), 0);
+	CU_ASSERT_FATAL(!qpol_iterator_end(iter));
+	qpol_iterator_get_item(iter, (void **)&user);
+	qpol_iterator_destroy(&iter);
+	qpol_user_get_name(q, user, &name);
+	CU_ASSERT_EQUAL_FATAL(apol_context_set_user(ap, c, name), 0);
+
+	CU_ASSERT_EQUAL_FATAL(qpol_user_get_role_iter(q, user, &iter), 0);
+	CU_ASSERT_FATAL(!qpol_iterator_end(iter));
+	qpol_iterator_get_item(iter, (void **)&role);
+	qpol_iterator_destroy(&iter);
+	qpol_role_get_name(q, role, &name);
+	CU_ASSERT_EQUAL_FATAL(apol_context_set_role(ap, c, name), 0);
+
+	CU_ASSERT_EQUAL_FATAL(apol_context_set_type(ap, c, type), 0);
+	if (apol_policy_is_mls(ap)) {
+		CU_ASSERT_EQUAL_FATAL(qpol_user_get_range(q, user, &range), 0);
+		CU_ASSERT_EQUAL_FATAL(apol_context_set_range(ap, c, apol_mls_range_create_from_qpol_mls_range(ap, range)), 0);
+	}
+	return c;
+}
+
+static void avrule_compute_av(void)
+{
+	qpol_policy_t *q = apol_policy_get_qpol(bp);
+	apol_avrule_query_t *aq = apol_avrule_query_create();
+	apol_vector_t *v = NULL, *perms, *names;
+	apol_avc_stats_t stats;
+	apol_av_decision_t avd, first;
+	apol_context_t *scon = NULL, *tcon = NULL, *first_scon = NULL, *first_tcon = NULL;
+	const char *first_class = NULL;
+	size_t i, checked = 0, misses;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(aq);
+	CU_ASSERT_EQUAL_FATAL(apol_avrule_query_set_rules(bp, aq, QPOL_RULE_ALLOW), 0);
+	CU_ASSERT_EQUAL_FATAL(apol_avrule_get_by_query(bp, aq, &v), 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+
+	// every permission of an enabled allow rule between two types must
+	// be either allowed or removed by a constraint
+	for (i = 0; i < apol_vector_get_size(v) && checked < 50; i++) {
+		const qpol_avrule_t *rule = apol_vector_get_element(v, i);
+		const qpol_type_t *source, *target;
+		const qpol_class_t *obj_class;
+		const char *sname, *tname, *cname;
+		unsigned char sattr, tattr;
+		uint32_t enabled, wanted;
+		qpol_iterator_t *iter;
+
+		qpol_avrule_get_source_type(q, rule, &source);
+		qpol_avrule_get_target_type(q, rule, &target);
+		qpol_avrule_get_object_class(q, rule, &obj_class);
+		qpol_avrule_get_is_enabled(q, rule, &enabled);
+		qpol_type_get_isattr(q, source, &sattr);
+		qpol_type_get_isattr(q, target, &tattr);
+		if (!enabled || sattr || tattr) {
+			continue;
+		}
+		qpol_type_get_name(q, source, &sname);
+		qpol_type_get_name(q, target, &tname);
+		qpol_class_get_name(q, obj_class, &cname);
+		perms = apol_vector_create(free);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(perms);
+		CU_ASSERT_EQUAL_FATAL(qpol_avrule_get_perm_iter(q, rule, &iter), 0);
+		for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+			char *perm;
+			qpol_iterator_get_item(iter, (void **)&perm);
+			apol_vector_append(perms, perm);
+		}
+		qpol_iterator_destroy(&iter);
+
+		scon = avrule_make_context(bp, sname);
+		tcon = avrule_make_context(bp, tname);
+		CU_ASSERT_EQUAL_FATAL(apol_class_perms_to_av(bp, cname, perms, &wanted), 0);
+		CU_ASSERT_EQUAL_FATAL(apol_compute_av(bp, scon, tcon, cname, &avd), 0);
+		CU_ASSERT(((avd.allowed | avd.constrained) & wanted) == wanted);
+		CU_ASSERT((avd.allowed & avd.constrained) == 0);
+		names = apol_class_av_to_perms(bp, cname, wanted);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(names);
+		apol_vector_sort_uniquify(perms, apol_str_strcmp, NULL);
+		CU_ASSERT_EQUAL(apol_vector_get_size(names), apol_vector_get_size(perms));
+		apol_vector_destroy(&names);
+		apol_vector_destroy(&perms);
+
+		if (first_scon == NULL) {
+			first_scon = scon;
+			first_tcon = tcon;
+			first_class = cname;
+			first = avd;
+		} else {
+			apol_context_destroy(&scon);
+			apol_context_destroy(&tcon);
+		}
+		checked++;
+	}
+	CU_ASSERT_FATAL(checked > 0);
+
+	// asking again must be answered from the cache with the same result
+	CU_ASSERT_EQUAL(apol_avc_get_stats(bp, &stats), 0);
+	CU_ASSERT(stats.lookups == checked && stats.hits + stats.misses == stats.lookups);
+	misses = stats.misses;
+	CU_ASSERT_EQUAL(apol_compute_av_batch(bp, (const apol_context_t * const *)&first_scon,
+					      (const apol_context_t * const *)&first_tcon, &first_class, 1, &avd), 0);
+	CU_ASSERT(memcmp(&avd, &first, sizeof(avd)) == 0);
+	CU_ASSERT_EQUAL(apol_avc_get_stats(bp, &stats), 0);
+	CU_ASSERT(stats.misses == misses && stats.hits > 0);
+
+	// a one entry cache evicts, yet gives the same answers
+	CU_ASSERT_EQUAL(apol_avc_set_capacity(bp, 1), 0);
+	CU_ASSERT_EQUAL(apol_compute_av(bp, first_scon, first_tcon, first_class, &avd), 0);
+	CU_ASSERT(memcmp(&avd, &first, sizeof(avd)) == 0);
+	CU_ASSERT_EQUAL(apol_compute_av(bp, first_tcon, first_scon, first_class, &avd), 0);
+	CU_ASSERT_EQUAL(apol_compute_av(bp, first_scon, first_tcon, first_class, &avd), 0);
+	CU_ASSERT(memcmp(&avd, &first, sizeof(avd)) == 0);
+	CU_ASSERT_EQUAL(apol_avc_get_stats(bp, &stats), 0);
+	CU_ASSERT(stats.capacity == 1 && stats.size == 1);
+	if (strcmp(apol_context_get_type(first_scon), apol_context_get_type(first_tcon)) != 0) {
+		CU_ASSERT(stats.evictions >= 2);
+	}
+
+	CU_ASSERT(apol_compute_av(bp, first_scon, first_tcon, "no_such_class", &avd) < 0);
+
+	apol_context_destroy(&first_scon);
+	apol_context_destroy(&first_tcon);
+	apol_vector_destroy(&v);
+	apol_avrule_query_destroy(&aq);
+}
+
 CU_TestInfo avrule_tests[] = {
 	{"basic syntactic search", avrule_basic_syn}
 	,
 	{"default query", avrule_default}
 	,
+	{"render to sink", avrule_render_sink}
+	,
+	{"compute access vectors", avrule_compute_av}
+	,
 	CU_TEST_INFO_NULL
 };
 
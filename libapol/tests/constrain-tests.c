@@ -30,7 +30,10 @@
 #include <apol/policy-path.h>
 #include <stdbool.h>
 #include <string.h>
+#include <unistd.h>
 #include <apol/constraint-query.h>
+#include <apol/context-query.h>
+#include <apol/mls_range.h>
 #include <sepol/policydb/policydb.h>
 #include <sepol/policydb/constraint.h>
 #include <libqpol/src/queue.h>
@@ -476,6 +479,257 @@ static void constrain_binary(void)
 }
 
 
+/**
+ * Create a context from the policy's first user, that user's first
+ * role, the given type, and (for MLS policies) the user's range.
+ */
+static apol_context_t *constrain_make_context(apol_policy_t *ap, const char *type)
+{
+	qpol_policy_t *q = apol_policy_get_qpol(ap);
+	qpol_iterator_t *iter = NULL;
+	const qpol_user_t *user;
+	const qpol_role_t *role;
+	const qpol_mls_range_t *range;
+	const char *name;
+	apol_context_t *c = apol_context_create();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(c);
+
+	CU_ASSERT_EQUAL_FATAL(qpol_policy_get_user_iter(q, &iter), 0);
+	CU_ASSERT_FATAL(!qpol_iterator_end(iter));
+	qpol_iterator_get_item(iter, (void **)&user);
+	qpol_iterator_destroy(&iter);
+	qpol_user_get_name(q, user, &name);
+	CU_ASSERT_EQUAL_FATAL(apol_context_set_user(ap, c, name), 0);
+
+	CU_ASSERT_EQUAL_FATAL(qpol_user_get_role_iter(q, user, &iter), 0);
+	CU_ASSERT_FATAL(!qpol_iterator_end(iter));
+	qpol_iterator_get_item(iter, (void **)&role);
+	qpol_iterator_destroy(&iter);
+	qpol_role_get_name(q, role, &name);
+	CU_ASSERT_EQUAL_FATAL(apol_context_set_role(ap, c, name), 0);
+
+	CU_ASSERT_EQUAL_FATAL(apol_context_set_type(ap, c, type), 0);
+	if (apol_policy_is_mls(ap)) {
+		CU_ASSERT_EQUAL_FATAL(qpol_user_get_range(q, user, &range), 0);
+		CU_ASSERT_EQUAL_FATAL(apol_context_set_range(ap, c, apol_mls_range_create_from_qpol_mls_range(ap, range)), 0);
+	}
+	return c;
+}
+
+/**
+ * Find a type that is neither an attribute nor named within the
+ * "dir read" constraint.
+ */
+static const char *constrain_other_type(apol_policy_t *ap)
+{
+	qpol_policy_t *q = apol_policy_get_qpol(ap);
+	qpol_iterator_t *iter = NULL;
+	const char *name = NULL;
+	CU_ASSERT_EQUAL_FATAL(qpol_policy_get_type_iter(q, &iter), 0);
+	for (; qpol_iterator_end(iter) == 0; qpol_iterator_next(iter))
+	{
+		const qpol_type_t *type;
+		unsigned char isattr, isalias;
+		qpol_iterator_get_item(iter, (void **)&type);
+		qpol_type_get_isattr(q, type, &isattr);
+		qpol_type_get_isalias(q, type, &isalias);
+		qpol_type_get_name(q, type, &name);
+		if (!isattr && !isalias && strcmp(name, "sysadm_t") != 0 && strcmp(name, "secadm_t") != 0)
+			break;
+		name = NULL;
+	}
+	qpol_iterator_destroy(&iter);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(name);
+	return name;
+}
+
+static void constrain_eval_test(apol_policy_t *ap)
+{
+	apol_context_t *sys = constrain_make_context(ap, "sysadm_t");
+	apol_context_t *other = constrain_make_context(ap, constrain_other_type(ap));
+	apol_vector_t *perms = apol_vector_create(NULL), *denied = NULL;
+	const apol_context_t *scons[3], *tcons[3];
+	uint32_t masks[3];
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(perms);
+	CU_ASSERT_EQUAL_FATAL(apol_vector_append(perms, "read"), 0);
+	CU_ASSERT_EQUAL_FATAL(apol_policy_build_constraint_program(ap), 0);
+
+	// dir read is constrained to (t1 == { sysadm_t secadm_t })
+	CU_ASSERT_EQUAL(apol_constraint_compute_denied(ap, sys, other, "dir", perms, &denied), 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(denied);
+	CU_ASSERT_EQUAL(apol_vector_get_size(denied), 0);
+	apol_vector_destroy(&denied);
+
+	CU_ASSERT_EQUAL(apol_constraint_compute_denied(ap, other, sys, "dir", perms, &denied), 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(denied);
+	CU_ASSERT_EQUAL(apol_vector_get_size(denied), 1);
+	CU_ASSERT_STRING_EQUAL(apol_vector_get_element(denied, 0), "read");
+	apol_vector_destroy(&denied);
+
+	// the batch form must agree with the single pair form
+	scons[0] = sys;
+	scons[1] = other;
+	scons[2] = other;
+	tcons[0] = tcons[1] = other;
+	tcons[2] = sys;
+	CU_ASSERT_EQUAL(apol_constraint_compute_denied_batch(ap, scons, tcons, 3, "dir", perms, masks), 0);
+	CU_ASSERT_EQUAL(masks[0], 0);
+	CU_ASSERT_EQUAL(masks[1], 1);
+	CU_ASSERT_EQUAL(masks[2], 1);
+
+	// permissions must belong to the class
+	apol_vector_append(perms, "no_such_perm");
+	CU_ASSERT(apol_constraint_compute_denied(ap, sys, other, "dir", perms, &denied) < 0);
+	CU_ASSERT_PTR_NULL(denied);
+
+	apol_vector_destroy(&perms);
+	apol_context_destroy(&sys);
+	apol_context_destroy(&other);
+}
+
+static void constrain_eval_source(void)
+{
+	constrain_eval_test(ps);
+}
+
+static void constrain_eval_binary(void)
+{
+	constrain_eval_test(pb);
+}
+
+/*
+ * A small MLS policy whose constraints compare roles by dominance,
+ * compare levels against the target's high level, name types through
+ * attributes, '-', and '~', and restrict relabels with validatetrans.
+ */
+static const char *constrain_eval_policy =
+	"class file\nclass dir\nclass process\n"
+	"sid kernel\n"
+	"class file { read write create }\n"
+	"class dir { read search }\n"
+	"class process { transition }\n"
+	"sensitivity s0;\nsensitivity s1;\ndominance { s0 s1 }\n"
+	"category c0;\ncategory c1;\n"
+	"level s0:c0.c1;\nlevel s1:c0.c1;\n"
+	"mlsconstrain file read (l1 dom l2);\n"
+	"mlsconstrain file write (l1 domby h2);\n"
+	"mlsconstrain dir read (l1 incomp l2);\n"
+	"mlsvalidatetrans file (l1 eq l2 or t3 == admin_t);\n"
+	"attribute domain;\n"
+	"type admin_t, domain;\ntype user_t, domain;\ntype file_t;\n"
+	"role r_low types { admin_t user_t file_t };\n"
+	"role r_high types { admin_t user_t file_t };\n"
+	"role r_other types { admin_t user_t file_t };\n"
+	"dominance { role r_high { role r_low; } }\n"
+	"user u roles { r_low r_high r_other } level s0 range s0 - s1:c0.c1;\n"
+	"constrain dir search (r1 dom r2);\n"
+	"constrain process transition (r1 domby r2);\n"
+	"constrain file create (r1 incomp r2);\n"
+	"constrain dir read (t1 == { domain -user_t });\n"
+	"validatetrans dir (t3 == ~ file_t);\n"
+	"sid kernel u:r_low:admin_t:s0\n";
+
+struct constrain_eval_case
+{
+	const char *scontext, *tcontext, *obj_class, *perm;
+	int denied;
+};
+
+static const struct constrain_eval_case constrain_eval_cases[] = {
+	/* levels */
+	{"u:r_low:admin_t:s1", "u:r_low:file_t:s0", "file", "read", 0},
+	{"u:r_low:admin_t:s0", "u:r_low:file_t:s1", "file", "read", 1},
+	{"u:r_low:admin_t:s0:c0", "u:r_low:file_t:s0-s1:c0", "file", "write", 0},
+	{"u:r_low:admin_t:s0:c0", "u:r_low:file_t:s0-s1", "file", "write", 1},
+	{"u:r_low:admin_t:s1", "u:r_low:file_t:s0:c0-s1", "file", "write", 0},
+	{"u:r_low:admin_t:s0:c0", "u:r_low:file_t:s0:c1", "dir", "read", 0},
+	{"u:r_low:admin_t:s0", "u:r_low:file_t:s1", "dir", "read", 1},
+	/* types, with an attribute less one of its types */
+	{"u:r_low:user_t:s0:c0", "u:r_low:file_t:s0:c1", "dir", "read", 1},
+	/* roles */
+	{"u:r_high:admin_t:s0", "u:r_low:file_t:s0", "dir", "search", 0},
+	{"u:r_low:admin_t:s0", "u:r_high:file_t:s0", "dir", "search", 1},
+	{"u:r_low:admin_t:s0", "u:r_high:file_t:s0", "process", "transition", 0},
+	{"u:r_high:admin_t:s0", "u:r_low:file_t:s0", "process", "transition", 1},
+	{"u:r_low:admin_t:s0", "u:r_other:file_t:s0", "file", "create", 0},
+	{"u:r_low:admin_t:s0", "u:r_high:file_t:s0", "file", "create", 1},
+	{"u:r_low:admin_t:s0", "u:r_low:file_t:s0", "file", "create", 1},
+	{NULL, NULL, NULL, NULL, 0}
+};
+
+struct constrain_vtrans_case
+{
+	const char *oldcontext, *newcontext, *taskcontext, *obj_class;
+	int permitted;
+};
+
+static const struct constrain_vtrans_case constrain_vtrans_cases[] = {
+	{"u:r_low:file_t:s0", "u:r_low:file_t:s0", "u:r_low:admin_t:s0", "dir", 1},
+	{"u:r_low:file_t:s0", "u:r_low:file_t:s0", "u:r_low:file_t:s0", "dir", 0},
+	{"u:r_low:file_t:s0", "u:r_low:file_t:s0", "u:r_low:user_t:s0", "file", 1},
+	{"u:r_low:file_t:s0", "u:r_low:file_t:s1", "u:r_low:user_t:s0", "file", 0},
+	{"u:r_low:file_t:s0", "u:r_low:file_t:s1", "u:r_low:admin_t:s0", "file", 1},
+	{NULL, NULL, NULL, NULL, 0}
+};
+
+static apol_context_t *constrain_literal_context(apol_policy_t *ap, const char *literal)
+{
+	apol_context_t *c = apol_context_create_from_literal(literal);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(c);
+	CU_ASSERT_EQUAL_FATAL(apol_context_convert(ap, c), 0);
+	return c;
+}
+
+static void constrain_eval_expanded(void)
+{
+	char path[] = "/tmp/constrain-testXXXXXX";
+	apol_policy_path_t *ppath;
+	apol_policy_t *ap;
+	const struct constrain_eval_case *ec;
+	const struct constrain_vtrans_case *vc;
+	int fd = mkstemp(path);
+	FILE *f;
+
+	CU_ASSERT_FATAL(fd >= 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f = fdopen(fd, "w"));
+	fputs(constrain_eval_policy, f);
+	fclose(f);
+	ppath = apol_policy_path_create(APOL_POLICY_PATH_TYPE_MONOLITHIC, path, NULL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(ppath);
+	ap = apol_policy_create_from_policy_path(ppath, QPOL_POLICY_OPTION_NO_NEVERALLOWS, NULL, NULL);
+	apol_policy_path_destroy(&ppath);
+	unlink(path);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(ap);
+	CU_ASSERT_EQUAL_FATAL(apol_policy_build_constraint_program(ap), 0);
+
+	for (ec = constrain_eval_cases; ec->scontext != NULL; ec++) {
+		apol_context_t *s = constrain_literal_context(ap, ec->scontext);
+		apol_context_t *t = constrain_literal_context(ap, ec->tcontext);
+		apol_vector_t *perms = apol_vector_create(NULL), *denied = NULL;
+		CU_ASSERT_PTR_NOT_NULL_FATAL(perms);
+		CU_ASSERT_EQUAL_FATAL(apol_vector_append(perms, (void *)ec->perm), 0);
+		CU_ASSERT_EQUAL(apol_constraint_compute_denied(ap, s, t, ec->obj_class, perms, &denied), 0);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(denied);
+		CU_ASSERT_EQUAL(apol_vector_get_size(denied) > 0, ec->denied);
+		apol_vector_destroy(&denied);
+		apol_vector_destroy(&perms);
+		apol_context_destroy(&s);
+		apol_context_destroy(&t);
+	}
+
+	for (vc = constrain_vtrans_cases; vc->oldcontext != NULL; vc++) {
+		apol_context_t *o = constrain_literal_context(ap, vc->oldcontext);
+		apol_context_t *n = constrain_literal_context(ap, vc->newcontext);
+		apol_context_t *k = constrain_literal_context(ap, vc->taskcontext);
+		CU_ASSERT_EQUAL(apol_validatetrans_check(ap, o, n, k, vc->obj_class), vc->permitted);
+		apol_context_destroy(&o);
+		apol_context_destroy(&n);
+		apol_context_destroy(&k);
+	}
+	apol_policy_destroy(&ap);
+}
+
 static void constrain_modular(void)
 {
 	CU_PASS("Not yet implemented")
@@ -484,6 +738,9 @@ static void constrain_modular(void)
 CU_TestInfo constrain_tests[] = {
 	{"constrain from source policy", constrain_source},
 	{"constrain from binary policy", constrain_binary},
+	{"evaluate constraints from source policy", constrain_eval_source},
+	{"evaluate constraints from binary policy", constrain_eval_binary},
+	{"evaluate roles, levels, and validatetrans", constrain_eval_expanded},
 //	{"constrain from modular policy", constrain_modular},
 	CU_TEST_INFO_NULL
 };
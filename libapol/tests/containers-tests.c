@@ -0,0 +1,248 @@
+/**
+ *  @file
+ *
+ *  Test the hash set and string pool containers, and vector sorting.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <CUnit/CUnit.h>
+#include <apol/hashset.h>
+#include <apol/strpool.h>
+#include <apol/util.h>
+#include <apol/vector.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* enough entries to force several rehashes */
+#define NUM_ENTRIES 5000
+
+static size_t containers_str_hash(const void *elem, void *data __attribute__ ((unused)))
+{
+	const char *s = elem;
+	size_t h = 5381;
+	for (; *s != '\0'; s++) {
+		h = h * 33 + (unsigned char)*s;
+	}
+	return h;
+}
+
+static int containers_str_cmp(const void *a, const void *b, void *data __attribute__ ((unused)))
+{
+	return strcmp((const char *)a, (const char *)b);
+}
+
+static void containers_hashset(void)
+{
+	apol_hashset_t *h = apol_hashset_create(containers_str_hash, containers_str_cmp, free);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(h);
+	char buf[32];
+	void *result;
+	int i;
+
+	for (i = 0; i < NUM_ENTRIES; i++) {
+		snprintf(buf, sizeof(buf), "entry%d", i);
+		char *s = strdup(buf);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(s);
+		CU_ASSERT(apol_hashset_insert(h, s, NULL) == 0);
+	}
+	CU_ASSERT(apol_hashset_get_size(h) == NUM_ENTRIES);
+
+	/* a duplicate is freed and the original is returned */
+	char *dup = strdup("entry42"), *orig;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(dup);
+	result = dup;
+	CU_ASSERT(apol_hashset_insert_and_get(h, &result, NULL) == 1);
+	orig = result;
+	CU_ASSERT(strcmp(orig, "entry42") == 0);
+	CU_ASSERT(apol_hashset_get_size(h) == NUM_ENTRIES);
+
+	for (i = 0; i < NUM_ENTRIES; i++) {
+		snprintf(buf, sizeof(buf), "entry%d", i);
+		CU_ASSERT(apol_hashset_get_element(h, buf, NULL, &result) == 0);
+		CU_ASSERT_STRING_EQUAL(result, buf);
+	}
+	CU_ASSERT(apol_hashset_get_element(h, "entry42", NULL, &result) == 0 && result == orig);
+	CU_ASSERT(apol_hashset_get_element(h, "missing", NULL, &result) < 0);
+
+	apol_vector_t *v = apol_hashset_get_vector(h, 1);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	CU_ASSERT(apol_vector_get_size(v) == NUM_ENTRIES);
+	apol_hashset_destroy(&h);
+	CU_ASSERT_PTR_NULL(h);
+	/* the vector now owns the strings */
+	apol_vector_sort_uniquify(v, apol_str_strcmp, NULL);
+	CU_ASSERT(apol_vector_get_size(v) == NUM_ENTRIES);
+	apol_vector_destroy(&v);
+
+	/* pointer hashing and comparison */
+	h = apol_hashset_create(NULL, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(h);
+	CU_ASSERT(apol_hashset_insert(h, buf, NULL) == 0);
+	CU_ASSERT(apol_hashset_insert(h, buf, NULL) == 1);
+	CU_ASSERT(apol_hashset_insert(h, buf + 1, NULL) == 0);
+	CU_ASSERT(apol_hashset_get_size(h) == 2);
+	apol_hashset_destroy(&h);
+}
+
+static void containers_strpool(void)
+{
+	apol_strpool_t *pool = apol_strpool_create();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(pool);
+	char buf[32], *s, *first = NULL;
+	size_t id;
+	int i;
+
+	for (i = 0; i < NUM_ENTRIES; i++) {
+		snprintf(buf, sizeof(buf), "string%d", i);
+		CU_ASSERT(apol_strpool_insert(pool, buf, &s) == 0);
+		CU_ASSERT(s != buf && strcmp(s, buf) == 0);
+		if (i == 0) {
+			first = s;
+		}
+	}
+	CU_ASSERT(apol_strpool_get_size(pool) == NUM_ENTRIES);
+
+	/* interned strings are stable and compare by pointer */
+	CU_ASSERT(apol_strpool_insert(pool, "string0", &s) == 1);
+	CU_ASSERT(s == first);
+	CU_ASSERT(apol_strpool_insert(pool, "string1", NULL) == 1);
+	CU_ASSERT(apol_strpool_get_size(pool) == NUM_ENTRIES);
+
+	CU_ASSERT(apol_strpool_get_element(pool, "string0", &s) == 0 && s == first);
+	CU_ASSERT(apol_strpool_get_element(pool, "missing", &s) < 0);
+
+	/* identifiers follow insertion order */
+	CU_ASSERT(apol_strpool_get_id(pool, "string123", &id) == 0 && id == 123);
+	CU_ASSERT_STRING_EQUAL(apol_strpool_get_string(pool, id), "string123");
+	CU_ASSERT_PTR_NULL(apol_strpool_get_string(pool, NUM_ENTRIES));
+
+	apol_vector_t *v = apol_strpool_get_vector(pool);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	CU_ASSERT(apol_vector_get_size(v) == NUM_ENTRIES);
+	for (size_t j = 1; j < apol_vector_get_size(v); j++) {
+		CU_ASSERT(strcmp(apol_vector_get_element(v, j - 1), apol_vector_get_element(v, j)) < 0);
+	}
+	apol_vector_destroy(&v);
+
+	apol_strpool_destroy(&pool);
+	CU_ASSERT_PTR_NULL(pool);
+}
+
+struct containers_rec
+{
+	int key;
+	size_t seq;
+};
+
+static int containers_rec_cmp(const void *a, const void *b, void *data __attribute__ ((unused)))
+{
+	const struct containers_rec *r1 = a, *r2 = b;
+	return (r1->key > r2->key) - (r1->key < r2->key);
+}
+
+/**
+ * Fill a vector with records according to a pattern, sort it, and
+ * check the results.  Patterns 0 and 1 are the already sorted and
+ * reverse sorted inputs that once took quadratic time.
+ */
+static void containers_sort_pattern(int pattern, int method)
+{
+	size_t n = 200000, i;
+	struct containers_rec *recs = calloc(n, sizeof(*recs));
+	apol_vector_t *v = apol_vector_create_with_capacity(n, NULL);
+	CU_ASSERT_FATAL(recs != NULL && v != NULL);
+	for (i = 0; i < n; i++) {
+		switch (pattern) {
+		case 0:
+			recs[i].key = (int)i;
+			break;
+		case 1:
+			recs[i].key = (int)(n - i);
+			break;
+		case 2:
+			recs[i].key = rand();
+			break;
+		default:
+			recs[i].key = (int)(i % 7);
+		}
+		recs[i].seq = i;
+		CU_ASSERT(apol_vector_append(v, recs + i) == 0);
+	}
+	if (method == 0) {
+		apol_vector_sort(v, containers_rec_cmp, NULL);
+	} else if (method == 1) {
+		CU_ASSERT(apol_vector_sort_stable(v, containers_rec_cmp, NULL) == 0);
+	} else {
+		CU_ASSERT(apol_vector_sort_parallel(v, containers_rec_cmp, NULL, 4) == 0);
+	}
+	CU_ASSERT(apol_vector_get_size(v) == n);
+	for (i = 1; i < apol_vector_get_size(v); i++) {
+		struct containers_rec *r1 = apol_vector_get_element(v, i - 1);
+		struct containers_rec *r2 = apol_vector_get_element(v, i);
+		CU_ASSERT(r1->key <= r2->key);
+		if (method != 0 && r1->key == r2->key) {
+			CU_ASSERT(r1->seq < r2->seq);
+		}
+	}
+	apol_vector_destroy(&v);
+	free(recs);
+}
+
+static void containers_vector_sort(void)
+{
+	int pattern, method;
+	for (method = 0; method < 3; method++) {
+		for (pattern = 0; pattern < 4; pattern++) {
+			containers_sort_pattern(pattern, method);
+		}
+	}
+
+	apol_vector_t *v = apol_vector_create(NULL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	for (size_t i = 0; i < 1000; i++) {
+		CU_ASSERT(apol_vector_append(v, (void *)(uintptr_t) (i % 37 + 1)) == 0);
+	}
+	apol_vector_sort_uniquify(v, NULL, NULL);
+	CU_ASSERT(apol_vector_get_size(v) == 37);
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		CU_ASSERT((uintptr_t) apol_vector_get_element(v, i) == i + 1);
+	}
+	apol_vector_destroy(&v);
+}
+
+CU_TestInfo containers_tests[] = {
+	{"hash set", containers_hashset}
+	,
+	{"string pool", containers_strpool}
+	,
+	{"vector sort", containers_vector_sort}
+	,
+	CU_TEST_INFO_NULL
+};
+
+int containers_init()
+{
+	return 0;
+}
+
+int containers_cleanup()
+{
+	return 0;
+}
@@ -28,9 +28,11 @@
 
 #include <CUnit/CUnit.h>
 #include <apol/avrule-query.h>
+#include <apol/budget.h>
 #include <apol/domain-trans-analysis.h>
 #include <apol/policy.h>
 #include <apol/policy-path.h>
+#include <errno.h>
 #include <stdbool.h>
 #include <string.h>
 
@@ -484,6 +486,136 @@ static void dta_invalid(void)
 	apol_domain_trans_analysis_destroy(&d);
 }
 
+static void dta_compare_rules(const apol_vector_t * v, const apol_vector_t * w)
+{
+	CU_ASSERT_FATAL(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		CU_ASSERT(apol_vector_get_element(v, i) == apol_vector_get_element(w, i));
+	}
+}
+
+static void dta_compare_results(const apol_vector_t * v, const apol_vector_t * w)
+{
+	CU_ASSERT_FATAL(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		const apol_domain_trans_result_t *r = apol_vector_get_element(v, i);
+		const apol_domain_trans_result_t *s = apol_vector_get_element(w, i);
+		CU_ASSERT(apol_domain_trans_result_get_start_type(r) == apol_domain_trans_result_get_start_type(s));
+		CU_ASSERT(apol_domain_trans_result_get_entrypoint_type(r) == apol_domain_trans_result_get_entrypoint_type(s));
+		CU_ASSERT(apol_domain_trans_result_get_end_type(r) == apol_domain_trans_result_get_end_type(s));
+		CU_ASSERT(apol_domain_trans_result_is_trans_valid(r) == apol_domain_trans_result_is_trans_valid(s));
+		dta_compare_rules(apol_domain_trans_result_get_proc_trans_rules(r),
+				  apol_domain_trans_result_get_proc_trans_rules(s));
+		dta_compare_rules(apol_domain_trans_result_get_entrypoint_rules(r),
+				  apol_domain_trans_result_get_entrypoint_rules(s));
+		dta_compare_rules(apol_domain_trans_result_get_exec_rules(r), apol_domain_trans_result_get_exec_rules(s));
+		dta_compare_rules(apol_domain_trans_result_get_setexec_rules(r), apol_domain_trans_result_get_setexec_rules(s));
+		dta_compare_rules(apol_domain_trans_result_get_type_trans_rules(r),
+				  apol_domain_trans_result_get_type_trans_rules(s));
+	}
+}
+
+static void dta_budget(void)
+{
+	const char *start_types[] = {
+		"boat_t", "crab_t", "gull_t", "marlin_t", "ray_t", "shark_t", "tuna_t", NULL
+	};
+	const unsigned char directions[] = {
+		APOL_DOMAIN_TRANS_DIRECTION_FORWARD, APOL_DOMAIN_TRANS_DIRECTION_REVERSE, 0
+	};
+	const unsigned char searches[] = {
+		APOL_DOMAIN_TRANS_SEARCH_VALID, APOL_DOMAIN_TRANS_SEARCH_BOTH, 0
+	};
+	apol_domain_trans_analysis_t *d = apol_domain_trans_analysis_create();
+	apol_budget_t *b = apol_budget_create();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(d);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(b);
+	int retval = apol_budget_set_max_nodes(b, 1);
+	CU_ASSERT_EQUAL_FATAL(retval, 0);
+
+	for (const unsigned char *dir = directions; *dir != 0; dir++) {
+		retval = apol_domain_trans_analysis_set_direction(p, d, *dir);
+		CU_ASSERT_EQUAL_FATAL(retval, 0);
+		for (const unsigned char *search = searches; *search != 0; search++) {
+			retval = apol_domain_trans_analysis_set_valid(p, d, *search);
+			CU_ASSERT_EQUAL_FATAL(retval, 0);
+			for (const char **start = start_types; *start != NULL; start++) {
+				apol_vector_t *v = NULL, *w = NULL;
+				retval = apol_domain_trans_analysis_set_start_type(p, d, *start);
+				CU_ASSERT_EQUAL_FATAL(retval, 0);
+				retval = apol_domain_trans_analysis_set_budget(p, d, NULL);
+				CU_ASSERT_EQUAL_FATAL(retval, 0);
+				apol_policy_reset_domain_trans_table(p);
+				retval = apol_domain_trans_analysis_do(p, d, &v);
+				CU_ASSERT_EQUAL_FATAL(retval, 0);
+
+				/* one candidate type per call; the pieces must
+				 * add up to the unlimited search */
+				retval = apol_domain_trans_analysis_set_budget(p, d, b);
+				CU_ASSERT_EQUAL_FATAL(retval, 0);
+				apol_policy_reset_domain_trans_table(p);
+				retval = apol_domain_trans_analysis_do(p, d, &w);
+				while (retval == 1) {
+					CU_ASSERT(apol_budget_get_spent(b) & APOL_BUDGET_NODES);
+					if (*search & APOL_DOMAIN_TRANS_SEARCH_INVALID) {
+						/* held until the orphan rules are found */
+						CU_ASSERT(apol_vector_get_size(w) == 0);
+					}
+					retval = apol_domain_trans_analysis_resume(p, d, &w);
+				}
+				CU_ASSERT_EQUAL_FATAL(retval, 0);
+				CU_ASSERT(apol_budget_get_spent(b) == 0);
+				dta_compare_results(v, w);
+				apol_vector_destroy(&v);
+				apol_vector_destroy(&w);
+			}
+		}
+	}
+
+	/* resetting the table abandons a suspended search */
+	retval = apol_domain_trans_analysis_set_direction(p, d, APOL_DOMAIN_TRANS_DIRECTION_FORWARD);
+	CU_ASSERT_EQUAL_FATAL(retval, 0);
+	apol_vector_t *v = NULL;
+	retval = 0;
+	for (const char **start = start_types; *start != NULL && retval != 1; start++) {
+		apol_vector_destroy(&v);
+		retval = apol_domain_trans_analysis_set_start_type(p, d, *start);
+		CU_ASSERT_EQUAL_FATAL(retval, 0);
+		apol_policy_reset_domain_trans_table(p);
+		retval = apol_domain_trans_analysis_do(p, d, &v);
+	}
+	CU_ASSERT_EQUAL_FATAL(retval, 1);
+	apol_policy_reset_domain_trans_table(p);
+	retval = apol_domain_trans_analysis_resume(p, d, &v);
+	CU_ASSERT(retval < 0 && errno == ESTALE);
+	retval = apol_domain_trans_analysis_resume(p, d, &v);
+	CU_ASSERT_EQUAL(retval, 0);
+	apol_vector_destroy(&v);
+
+	apol_domain_trans_analysis_destroy(&d);
+	apol_budget_destroy(&b);
+}
+
+static void dta_memory(void)
+{
+	apol_vector_t *v = apol_policy_get_memory_usage(p);
+	size_t i, num_found = 0;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	for (i = 0; i < apol_vector_get_size(v); i++) {
+		const apol_memory_usage_t *u = apol_vector_get_element(v, i);
+		if (strcmp(u->name, "av table") == 0 || strcmp(u->name, "domain transition table") == 0) {
+			CU_ASSERT(u->bytes > 0 && u->count > 0);
+			num_found++;
+		} else if (strcmp(u->name, "relabel index") == 0) {
+			/* never built by these tests */
+			CU_ASSERT(u->bytes == 0 && u->count == 0);
+			num_found++;
+		}
+	}
+	CU_ASSERT(num_found == 3);
+	apol_vector_destroy(&v);
+}
+
 CU_TestInfo dta_tests[] = {
 	{"dta forward", dta_forward}
 	,
@@ -499,6 +631,10 @@ CU_TestInfo dta_tests[] = {
 	,
 	{"dta invalid transitions", dta_invalid}
 	,
+	{"dta budget", dta_budget}
+	,
+	{"dta memory usage", dta_memory}
+	,
 	CU_TEST_INFO_NULL
 };
 
@@ -26,11 +26,13 @@
 #include <config.h>
 
 #include <CUnit/CUnit.h>
+#include <apol/budget.h>
 #include <apol/infoflow-analysis.h>
 #include <apol/perm-map.h>
 #include <apol/policy.h>
 #include <apol/policy-path.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define BIG_POLICY TEST_POLICIES "/snapshots/fc4_targeted.policy.conf"
@@ -96,11 +98,151 @@ static void infoflow_trans_overview(void)
 	apol_infoflow_graph_destroy(&g);
 }
 
+static void infoflow_compare_steps(const apol_vector_t * v, const apol_vector_t * w)
+{
+	CU_ASSERT_FATAL(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		const apol_infoflow_step_t *s = apol_vector_get_element(v, i);
+		const apol_infoflow_step_t *t = apol_vector_get_element(w, i);
+		CU_ASSERT(apol_infoflow_step_get_start_type(s) == apol_infoflow_step_get_start_type(t));
+		CU_ASSERT(apol_infoflow_step_get_end_type(s) == apol_infoflow_step_get_end_type(t));
+		CU_ASSERT(apol_infoflow_step_get_weight(s) == apol_infoflow_step_get_weight(t));
+		const apol_vector_t *r = apol_infoflow_step_get_rules(s);
+		const apol_vector_t *u = apol_infoflow_step_get_rules(t);
+		CU_ASSERT_FATAL(apol_vector_get_size(r) == apol_vector_get_size(u));
+		for (size_t j = 0; j < apol_vector_get_size(r); j++) {
+			CU_ASSERT(apol_vector_get_element(r, j) == apol_vector_get_element(u, j));
+		}
+	}
+}
+
+/**
+ * Compare the results of a search against those of the same search
+ * run in pieces.  With full set, the paths themselves must match;
+ * otherwise only what does not depend upon the random order in which
+ * a further search visits neighbors.
+ */
+static void infoflow_compare_results(const apol_vector_t * v, const apol_vector_t * w, bool full)
+{
+	CU_ASSERT_FATAL(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		const apol_infoflow_result_t *r = apol_vector_get_element(v, i);
+		const apol_infoflow_result_t *s = apol_vector_get_element(w, i);
+		CU_ASSERT(apol_infoflow_result_get_dir(r) == apol_infoflow_result_get_dir(s));
+		CU_ASSERT(apol_infoflow_result_get_start_type(r) == apol_infoflow_result_get_start_type(s));
+		CU_ASSERT(apol_infoflow_result_get_end_type(r) == apol_infoflow_result_get_end_type(s));
+		CU_ASSERT(apol_infoflow_result_get_length(r) == apol_infoflow_result_get_length(s));
+		if (full) {
+			infoflow_compare_steps(apol_infoflow_result_get_steps(r), apol_infoflow_result_get_steps(s));
+		} else {
+			CU_ASSERT(apol_vector_get_size(apol_infoflow_result_get_steps(r)) ==
+				  apol_vector_get_size(apol_infoflow_result_get_steps(s)));
+		}
+	}
+}
+
+/**
+ * Run a search that may have run out of budget to completion.
+ */
+static int infoflow_finish(apol_infoflow_graph_t * g, apol_budget_t * b, int retval, apol_vector_t ** v, size_t * num_calls)
+{
+	while (retval == 1) {
+		CU_ASSERT(apol_budget_get_spent(b) & APOL_BUDGET_NODES);
+		(*num_calls)++;
+		retval = apol_infoflow_analysis_resume(p, g, v);
+	}
+	return retval;
+}
+
+static void infoflow_budget(void)
+{
+	apol_infoflow_analysis_t *ia = apol_infoflow_analysis_create();
+	apol_budget_t *b = apol_budget_create();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(ia);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(b);
+	int retval;
+	retval = apol_infoflow_analysis_set_mode(p, ia, APOL_INFOFLOW_MODE_TRANS);
+	CU_ASSERT_FATAL(retval == 0);
+	retval = apol_infoflow_analysis_set_dir(p, ia, APOL_INFOFLOW_IN);
+	CU_ASSERT_FATAL(retval == 0);
+	retval = apol_infoflow_analysis_set_type(p, ia, "local_login_t");
+	CU_ASSERT_FATAL(retval == 0);
+	retval = apol_budget_set_max_nodes(b, 5);
+	CU_ASSERT_FATAL(retval == 0);
+
+	/* permmap was loaded by infoflow_direct_overview() */
+	apol_vector_t *v = NULL, *w = NULL;
+	apol_infoflow_graph_t *g = NULL, *h = NULL;
+	size_t num_calls = 0;
+	retval = apol_infoflow_analysis_do(p, ia, &v, &g);
+	CU_ASSERT_FATAL(retval == 0);
+	CU_ASSERT_FATAL(apol_vector_get_size(v) > 0);
+	retval = apol_infoflow_analysis_set_budget(p, ia, b);
+	CU_ASSERT_FATAL(retval == 0);
+	retval = apol_infoflow_analysis_do(p, ia, &w, &h);
+	retval = infoflow_finish(h, b, retval, &w, &num_calls);
+	CU_ASSERT_FATAL(retval == 0);
+	CU_ASSERT(num_calls > 0);
+	CU_ASSERT(apol_budget_get_spent(b) == 0);
+	infoflow_compare_results(v, w, true);
+
+	/* the first result's end type is the target of the further
+	 * search below */
+	const apol_infoflow_result_t *r = apol_vector_get_element(v, 0);
+	const char *end_name;
+	qpol_type_get_name(apol_policy_get_qpol(p), apol_infoflow_result_get_end_type(r), &end_name);
+	char *end = strdup(end_name);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(end);
+	apol_vector_destroy(&v);
+	apol_vector_destroy(&w);
+
+	/* searching again upon the same graphs */
+	num_calls = 0;
+	retval = apol_infoflow_analysis_do_more(p, g, "sshd_t", &v);
+	CU_ASSERT_FATAL(retval == 0);
+	retval = apol_infoflow_analysis_do_more(p, h, "sshd_t", &w);
+	retval = infoflow_finish(h, b, retval, &w, &num_calls);
+	CU_ASSERT_FATAL(retval == 0);
+	CU_ASSERT(num_calls > 0);
+	infoflow_compare_results(v, w, true);
+	apol_vector_destroy(&v);
+	apol_vector_destroy(&w);
+
+	/* a further search visits neighbors in random order, so the
+	 * paths it returns may differ from run to run */
+	num_calls = 0;
+	retval = apol_infoflow_analysis_trans_further_prepare(p, g, "local_login_t", end);
+	CU_ASSERT_FATAL(retval == 0);
+	retval = apol_infoflow_analysis_trans_further_next(p, g, &v);
+	CU_ASSERT_FATAL(retval == 0);
+	retval = apol_infoflow_analysis_trans_further_prepare(p, h, "local_login_t", end);
+	CU_ASSERT_FATAL(retval == 0);
+	retval = apol_infoflow_analysis_trans_further_next(p, h, &w);
+	while (retval == 1) {
+		CU_ASSERT(apol_budget_get_spent(b) & APOL_BUDGET_NODES);
+		num_calls++;
+		retval = apol_infoflow_analysis_trans_further_next(p, h, &w);
+	}
+	CU_ASSERT_FATAL(retval == 0);
+	CU_ASSERT(num_calls > 0);
+	infoflow_compare_results(v, w, false);
+
+	free(end);
+	apol_vector_destroy(&v);
+	apol_vector_destroy(&w);
+	apol_infoflow_graph_destroy(&g);
+	apol_infoflow_graph_destroy(&h);
+	apol_infoflow_analysis_destroy(&ia);
+	apol_budget_destroy(&b);
+}
+
 CU_TestInfo infoflow_tests[] = {
 	{"infoflow direct overview", infoflow_direct_overview}
 	,
 	{"infoflow trans overview", infoflow_trans_overview}
 	,
+	{"infoflow budget", infoflow_budget}
+	,
 	CU_TEST_INFO_NULL
 };
 
@@ -29,11 +29,15 @@
 #include <CUnit/Basic.h>
 
 #include "avrule-tests.h"
+#include "containers-tests.h"
 #include "dta-tests.h"
 #include "infoflow-tests.h"
+#include "modules-tests.h"
 #include "policy-21-tests.h"
+#include "relabel-tests.h"
 #include "role-tests.h"
 #include "terule-tests.h"
+#include "types-relation-tests.h"
 #include "constrain-tests.h"
 #include "user-tests.h"
 
@@ -45,13 +49,17 @@ int main(void)
 
 	CU_SuiteInfo suites[] = {
 		{"Policy Version 21", policy_21_init, policy_21_cleanup, policy_21_tests},
+		{"Containers", containers_init, containers_cleanup, containers_tests},
 		{"AV Rule Query", avrule_init, avrule_cleanup, avrule_tests},
 		{"Domain Transition Analysis", dta_init, dta_cleanup, dta_tests},
 		{"Infoflow Analysis", infoflow_init, infoflow_cleanup, infoflow_tests},
+		{"Relabel Analysis", relabel_init, relabel_cleanup, relabel_tests},
 		{"Role Query", role_init, role_cleanup, role_tests},
 		{"TE Rule Query", terule_init, terule_cleanup, terule_tests},
+		{"Types Relation Analysis", types_relation_init, types_relation_cleanup, types_relation_tests},
 		{"User Query", user_init, user_cleanup, user_tests},
 		{"Constrain query", constrain_init, constrain_cleanup, constrain_tests},
+		{"Module Loading", modules_init, modules_cleanup, modules_tests},
 		CU_SUITE_INFO_NULL
 	};
 
@@ -0,0 +1,208 @@
+/**
+ *  @file
+ *
+ *  Test loading a modular policy path, whose module packages are
+ *  read concurrently and then appended in the path's order.
+ *
+ *  Copyright (C) 2007 Tresys Technology, LLC
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <CUnit/CUnit.h>
+#include <apol/policy.h>
+#include <apol/policy-path.h>
+#include <apol/util.h>
+#include <apol/vector.h>
+#include <qpol/module.h>
+#include <glob.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MODULES_GLOB TEST_POLICIES "/setools-3.1/modules/*.pp"
+#define MISSING_MODULE TEST_POLICIES "/setools-3.1/modules/no-such-module.pp"
+
+/** path to the base module */
+static char *base = NULL;
+/** paths to the other modules (char *), in the reverse of the order
+ *  in which a policy path lists them */
+static apol_vector_t *modules = NULL;
+
+/** Keep the text of every error message (char *) in the vector
+ *  given as varg. */
+static void modules_msg(void *varg, const apol_policy_t * p __attribute__ ((unused)), int level, const char *fmt,
+			va_list argp)
+{
+	apol_vector_t *errors = varg;
+	char *s = NULL;
+	if (level == APOL_MSG_ERR && vasprintf(&s, fmt, argp) >= 0) {
+		CU_ASSERT_FATAL(apol_vector_append(errors, s) == 0);
+	}
+}
+
+/** Return the number of error messages that report a module that
+ *  could not be loaded; if path is not NULL then count only those
+ *  about that module. */
+static size_t modules_count_errors(const apol_vector_t * errors, const char *path)
+{
+	size_t i, n = 0;
+	const char *prefix = "Error loading module ", *s;
+	for (i = 0; i < apol_vector_get_size(errors); i++) {
+		s = apol_vector_get_element(errors, i);
+		if (strncmp(s, prefix, strlen(prefix)) != 0) {
+			continue;
+		}
+		s += strlen(prefix);
+		if (path == NULL || (strncmp(s, path, strlen(path)) == 0 && s[strlen(path)] == ':')) {
+			n++;
+		}
+	}
+	return n;
+}
+
+static void modules_order(void)
+{
+	apol_policy_path_t *ppath = apol_policy_path_create(APOL_POLICY_PATH_TYPE_MODULAR, base, modules);
+	apol_policy_t *p = NULL;
+	const apol_vector_t *expected;
+	qpol_policy_t *q;
+	qpol_iterator_t *iter = NULL;
+	qpol_module_t *mod;
+	const char *path;
+	size_t i = 0;
+	int type;
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(ppath);
+	expected = apol_policy_path_get_modules(ppath);
+	CU_ASSERT_FATAL(apol_vector_get_size(expected) > 1);
+	p = apol_policy_create_from_policy_path(ppath, QPOL_POLICY_OPTION_NO_NEVERALLOWS, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(p);
+	q = apol_policy_get_qpol(p);
+
+	/* every module follows the base in the order that the policy
+	 * path lists them, whichever finished loading first */
+	CU_ASSERT_FATAL(qpol_policy_get_module_iter(q, &iter) == 0);
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		CU_ASSERT_FATAL(qpol_iterator_get_item(iter, (void **)&mod) == 0);
+		CU_ASSERT_FATAL(qpol_module_get_type(mod, &type) == 0);
+		if (type == QPOL_MODULE_BASE) {
+			continue;
+		}
+		CU_ASSERT_FATAL(i < apol_vector_get_size(expected));
+		CU_ASSERT_FATAL(qpol_module_get_path(mod, &path) == 0);
+		CU_ASSERT_STRING_EQUAL(path, (char *)apol_vector_get_element(expected, i));
+		i++;
+	}
+	CU_ASSERT(i == apol_vector_get_size(expected));
+	qpol_iterator_destroy(&iter);
+	apol_policy_destroy(&p);
+	apol_policy_path_destroy(&ppath);
+}
+
+static void modules_errors(void)
+{
+	char corrupt[] = "/tmp/modules-tests-XXXXXX";
+	const char garbage[] = "this is not a module package\n";
+	apol_vector_t *paths = NULL, *errors = NULL;
+	apol_policy_path_t *ppath = NULL;
+	apol_policy_t *p = NULL;
+	int fd;
+
+	fd = mkstemp(corrupt);
+	CU_ASSERT_FATAL(fd >= 0);
+	CU_ASSERT_FATAL(write(fd, garbage, sizeof(garbage) - 1) == (ssize_t) (sizeof(garbage) - 1));
+	close(fd);
+
+	paths = apol_vector_create_from_vector(modules, apol_str_strdup, NULL, free);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(paths);
+	CU_ASSERT_FATAL(apol_vector_append(paths, strdup(MISSING_MODULE)) == 0);
+	CU_ASSERT_FATAL(apol_vector_append(paths, strdup(corrupt)) == 0);
+	ppath = apol_policy_path_create(APOL_POLICY_PATH_TYPE_MODULAR, base, paths);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(ppath);
+	errors = apol_vector_create(free);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(errors);
+
+	/* the load fails, naming each module that could not be read
+	 * and none of those that could */
+	p = apol_policy_create_from_policy_path(ppath, QPOL_POLICY_OPTION_NO_NEVERALLOWS, modules_msg, errors);
+	CU_ASSERT_PTR_NULL(p);
+	CU_ASSERT(modules_count_errors(errors, MISSING_MODULE) == 1);
+	CU_ASSERT(modules_count_errors(errors, corrupt) == 1);
+	CU_ASSERT(modules_count_errors(errors, NULL) == 2);
+
+	apol_policy_destroy(&p);
+	apol_policy_path_destroy(&ppath);
+	apol_vector_destroy(&paths);
+	apol_vector_destroy(&errors);
+	unlink(corrupt);
+}
+
+CU_TestInfo modules_tests[] = {
+	{"appended in path order", modules_order}
+	,
+	{"every failure reported", modules_errors}
+	,
+	CU_TEST_INFO_NULL
+};
+
+int modules_init()
+{
+	qpol_module_t *mod = NULL;
+	glob_t g;
+	size_t i;
+	int type;
+
+	if (glob(MODULES_GLOB, 0, NULL, &g) != 0) {
+		return 1;
+	}
+	if ((modules = apol_vector_create(free)) == NULL) {
+		globfree(&g);
+		return 1;
+	}
+	/* list the modules backwards, so that appending them in the
+	 * order they were given differs from the policy path's order */
+	for (i = g.gl_pathc; i > 0; i--) {
+		if (qpol_module_create_from_file(g.gl_pathv[i - 1], &mod) < 0 || qpol_module_get_type(mod, &type) < 0) {
+			qpol_module_destroy(&mod);
+			globfree(&g);
+			return 1;
+		}
+		qpol_module_destroy(&mod);
+		if (type == QPOL_MODULE_BASE && base == NULL) {
+			base = strdup(g.gl_pathv[i - 1]);
+		} else if (apol_vector_append(modules, strdup(g.gl_pathv[i - 1])) < 0) {
+			globfree(&g);
+			return 1;
+		}
+	}
+	globfree(&g);
+	if (base == NULL || apol_vector_get_size(modules) < 2) {
+		return 1;
+	}
+	return 0;
+}
+
+int modules_cleanup()
+{
+	free(base);
+	base = NULL;
+	apol_vector_destroy(&modules);
+	return 0;
+}
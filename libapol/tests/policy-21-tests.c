@@ -28,8 +28,12 @@
 
 #include <CUnit/CUnit.h>
 #include <apol/policy.h>
+#include <apol/netcon-query.h>
 #include <apol/policy-path.h>
 #include <apol/range_trans-query.h>
+#include <apol/util.h>
+#include <netinet/in.h>
+#include <string.h>
 
 #define POLICY TEST_POLICIES "/setools-3.2/apol/rangetrans_testing_policy.conf"
 
@@ -150,12 +154,110 @@ static void policy_21_range_trans_socket(void)
 	apol_vector_destroy(&v);
 }
 
+static void policy_21_portcon_lookup(void)
+{
+	apol_vector_t *v = NULL;
+	int retval = apol_portcon_get_by_query(p, NULL, &v);
+	CU_ASSERT_EQUAL_FATAL(retval, 0);
+	qpol_policy_t *q = apol_policy_get_qpol(p);
+
+	/* compare the index against a linear scan for the narrowest
+	 * containing range */
+	uint8_t protos[2] = { IPPROTO_TCP, IPPROTO_UDP };
+	uint16_t ports[1024];
+	const qpol_portcon_t *found[1024];
+	size_t i, j, k;
+	for (i = 0; i < 1024; i++) {
+		ports[i] = (uint16_t) i;
+	}
+	for (k = 0; k < 2; k++) {
+		uint8_t batch_protos[1024];
+		memset(batch_protos, protos[k], sizeof(batch_protos));
+		retval = apol_portcon_lookup_batch(p, batch_protos, ports, 1024, found);
+		CU_ASSERT_EQUAL_FATAL(retval, 0);
+		for (i = 0; i < 1024; i++) {
+			const qpol_portcon_t *expected = NULL, *single = NULL;
+			int expected_width = 0x10000;
+			for (j = 0; j < apol_vector_get_size(v); j++) {
+				const qpol_portcon_t *pc = apol_vector_get_element(v, j);
+				uint8_t proto;
+				uint16_t low, high;
+				qpol_portcon_get_protocol(q, pc, &proto);
+				qpol_portcon_get_low_port(q, pc, &low);
+				qpol_portcon_get_high_port(q, pc, &high);
+				if (proto == protos[k] && low <= i && i <= high && high - low < expected_width) {
+					expected = pc;
+					expected_width = high - low;
+				}
+			}
+			CU_ASSERT_PTR_EQUAL(found[i], expected);
+			retval = apol_portcon_lookup(p, protos[k], ports[i], &single);
+			CU_ASSERT(retval == 0 && single == expected);
+		}
+	}
+	apol_vector_destroy(&v);
+}
+
+static void policy_21_nodecon_lookup(void)
+{
+	apol_vector_t *v = NULL;
+	int retval = apol_nodecon_get_by_query(p, NULL, &v);
+	CU_ASSERT_EQUAL_FATAL(retval, 0);
+	qpol_policy_t *q = apol_policy_get_qpol(p);
+
+	/* every nodecon's own address must resolve to a nodecon whose
+	 * netmask is at least as long */
+	size_t i;
+	for (i = 0; i < apol_vector_get_size(v); i++) {
+		const qpol_nodecon_t *nc = apol_vector_get_element(v, i), *found = NULL;
+		unsigned char proto, proto_a, proto_m;
+		uint32_t *addr, *mask, *found_addr, *found_mask;
+		qpol_nodecon_get_protocol(q, nc, &proto);
+		qpol_nodecon_get_addr(q, nc, &addr, &proto_a);
+		qpol_nodecon_get_mask(q, nc, &mask, &proto_m);
+		if ((addr[0] & mask[0]) != addr[0]) {
+			/* such a nodecon can never match anything */
+			continue;
+		}
+		retval = apol_nodecon_lookup(p, proto, addr, &found);
+		CU_ASSERT_EQUAL_FATAL(retval, 0);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(found);
+		qpol_nodecon_get_addr(q, found, &found_addr, &proto_a);
+		qpol_nodecon_get_mask(q, found, &found_mask, &proto_m);
+		size_t w, nbits = 0, found_bits = 0;
+		for (w = 0; w < (proto == QPOL_IPV4 ? 1 : 4); w++) {
+			CU_ASSERT_EQUAL(addr[w] & found_mask[w], found_addr[w]);
+			nbits += __builtin_popcount(mask[w]);
+			found_bits += __builtin_popcount(found_mask[w]);
+		}
+		CU_ASSERT(found_bits >= nbits);
+	}
+	apol_vector_destroy(&v);
+
+	/* an IPv6 address only resolves to IPv6 nodecons */
+	uint32_t addr[4];
+	int protos[1];
+	const qpol_nodecon_t *found[1];
+	retval = apol_str_to_internal_ip("::1", addr);
+	CU_ASSERT_FATAL(retval == QPOL_IPV6);
+	protos[0] = QPOL_IPV6;
+	retval = apol_nodecon_lookup_batch(p, protos, addr, 1, found);
+	CU_ASSERT_EQUAL(retval, 0);
+	if (found[0] != NULL) {
+		unsigned char proto;
+		qpol_nodecon_get_protocol(q, found[0], &proto);
+		CU_ASSERT_EQUAL(proto, QPOL_IPV6);
+	}
+}
+
 CU_TestInfo policy_21_tests[] = {
 	{"range_trans all", policy_21_range_trans_all},
 	{"range_trans process", policy_21_range_trans_process},
 	{"range_trans lnk_file", policy_21_range_trans_lnk_file},
 	{"range_trans process or lnk_file", policy_21_range_trans_either},
 	{"range_trans socket", policy_21_range_trans_socket},
+	{"portcon lookup", policy_21_portcon_lookup},
+	{"nodecon lookup", policy_21_nodecon_lookup},
 	CU_TEST_INFO_NULL
 };
 
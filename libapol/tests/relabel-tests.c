@@ -0,0 +1,205 @@
+/**
+ *  @file
+ *
+ *  Test the relabel analysis, both by searching the policy's rules
+ *  and by using the relabel index, and the transitive relabel
+ *  closure.
+ *
+ *  Copyright (C) 2007 Tresys Technology, LLC
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <CUnit/CUnit.h>
+#include <apol/policy.h>
+#include <apol/policy-path.h>
+#include <apol/relabel-analysis.h>
+#include <string.h>
+
+#define BIG_POLICY TEST_POLICIES "/snapshots/fc4_targeted.policy.conf"
+
+static apol_policy_t *p = NULL;
+
+struct relabel_case
+{
+	const char *type;
+	unsigned int dir;
+	const char *obj_class;
+};
+
+static const struct relabel_case relabel_cases[] = {
+	{"tmp_t", APOL_RELABEL_DIR_TO, NULL},
+	{"tmp_t", APOL_RELABEL_DIR_FROM, NULL},
+	{"etc_t", APOL_RELABEL_DIR_BOTH, NULL},
+	{"httpd_sys_content_t", APOL_RELABEL_DIR_BOTH, "file"},
+	{"httpd_sys_content_t", APOL_RELABEL_DIR_TO, "no_such_class"},
+	{"unconfined_t", APOL_RELABEL_DIR_SUBJECT, NULL},
+	{"unconfined_t", APOL_RELABEL_DIR_SUBJECT, "dir"},
+	{NULL, 0, NULL}
+};
+
+static apol_vector_t *relabel_run(const struct relabel_case *c)
+{
+	apol_relabel_analysis_t *r = apol_relabel_analysis_create();
+	apol_vector_t *v = NULL;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(r);
+	CU_ASSERT(apol_relabel_analysis_set_type(p, r, c->type) == 0);
+	CU_ASSERT(apol_relabel_analysis_set_dir(p, r, c->dir) == 0);
+	if (c->obj_class != NULL) {
+		CU_ASSERT(apol_relabel_analysis_append_class(p, r, c->obj_class) == 0);
+	}
+	CU_ASSERT(apol_relabel_analysis_do(p, r, &v) == 0);
+	apol_relabel_analysis_destroy(&r);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	return v;
+}
+
+static const apol_relabel_result_t *relabel_find(const apol_vector_t * v, const qpol_type_t * type)
+{
+	size_t i;
+	for (i = 0; i < apol_vector_get_size(v); i++) {
+		const apol_relabel_result_t *r = apol_vector_get_element(v, i);
+		if (apol_relabel_result_get_result_type(r) == type) {
+			return r;
+		}
+	}
+	return NULL;
+}
+
+static void relabel_index(void)
+{
+	apol_vector_t *searched[sizeof(relabel_cases) / sizeof(relabel_cases[0])];
+	size_t i, j;
+	for (i = 0; relabel_cases[i].type != NULL; i++) {
+		searched[i] = relabel_run(relabel_cases + i);
+	}
+	CU_ASSERT(apol_policy_build_relabel_index(p) == 0);
+	/* building it again is harmless */
+	CU_ASSERT(apol_policy_build_relabel_index(p) == 0);
+	for (i = 0; relabel_cases[i].type != NULL; i++) {
+		apol_vector_t *indexed = relabel_run(relabel_cases + i);
+		CU_ASSERT(apol_vector_get_size(indexed) == apol_vector_get_size(searched[i]));
+		for (j = 0; j < apol_vector_get_size(searched[i]); j++) {
+			const apol_relabel_result_t *a = apol_vector_get_element(searched[i], j);
+			const apol_relabel_result_t *b = relabel_find(indexed, apol_relabel_result_get_result_type(a));
+			CU_ASSERT_PTR_NOT_NULL_FATAL(b);
+			CU_ASSERT(apol_vector_get_size(apol_relabel_result_get_to(a)) ==
+				  apol_vector_get_size(apol_relabel_result_get_to(b)));
+			CU_ASSERT(apol_vector_get_size(apol_relabel_result_get_from(a)) ==
+				  apol_vector_get_size(apol_relabel_result_get_from(b)));
+			CU_ASSERT(apol_vector_get_size(apol_relabel_result_get_both(a)) ==
+				  apol_vector_get_size(apol_relabel_result_get_both(b)));
+		}
+		apol_vector_destroy(&indexed);
+		apol_vector_destroy(&searched[i]);
+	}
+	/* the class that matches nothing yields nothing */
+	CU_ASSERT(apol_vector_get_size(searched[4]) == 0);
+}
+
+static void relabel_closure(void)
+{
+	const struct relabel_case direct[] = {
+		{"tmp_t", APOL_RELABEL_DIR_TO, NULL},
+		{"tmp_t", APOL_RELABEL_DIR_FROM, NULL}
+	};
+	const qpol_type_t *tmp_t;
+	apol_vector_t *v, *closure, *file_closure;
+	size_t i, j, k;
+	CU_ASSERT_FATAL(qpol_policy_get_type_by_name(apol_policy_get_qpol(p), "tmp_t", &tmp_t) == 0);
+
+	for (i = 0; i < 2; i++) {
+		v = relabel_run(direct + i);
+		CU_ASSERT(apol_relabel_closure(p, "tmp_t", NULL, direct[i].dir, &closure) == 0);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(closure);
+		CU_ASSERT(apol_relabel_closure(p, "tmp_t", "file", direct[i].dir, &file_closure) == 0);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(file_closure);
+
+		/* every direct relabel is within the closure, which never
+		 * includes the starting type */
+		CU_ASSERT(apol_vector_get_size(closure) >= apol_vector_get_size(v));
+		for (j = 0; j < apol_vector_get_size(v); j++) {
+			const apol_relabel_result_t *r = apol_vector_get_element(v, j);
+			CU_ASSERT(apol_vector_get_index(closure, apol_relabel_result_get_result_type(r), NULL, NULL, &k) == 0);
+		}
+		CU_ASSERT(apol_vector_get_index(closure, tmp_t, NULL, NULL, &k) < 0);
+		/* restricting the class can only shrink the closure */
+		for (j = 0; j < apol_vector_get_size(file_closure); j++) {
+			CU_ASSERT(apol_vector_get_index(closure, apol_vector_get_element(file_closure, j), NULL, NULL, &k) == 0);
+		}
+		apol_vector_destroy(&file_closure);
+		apol_vector_destroy(&closure);
+		apol_vector_destroy(&v);
+	}
+
+	CU_ASSERT(apol_relabel_closure(p, "tmp_t", NULL, APOL_RELABEL_DIR_BOTH, &closure) < 0);
+	CU_ASSERT_PTR_NULL(closure);
+	CU_ASSERT(apol_relabel_closure(p, "no_such_type_t", NULL, APOL_RELABEL_DIR_TO, &closure) < 0);
+	CU_ASSERT_PTR_NULL(closure);
+}
+
+/**
+ * Rebuilding the qpol policy frees the rules and types held by the
+ * index; the next analysis must build a new one instead.
+ */
+static void relabel_rebuild(void)
+{
+	qpol_policy_t *q = apol_policy_get_qpol(p);
+	unsigned int before, after;
+	apol_vector_t *v, *w;
+	CU_ASSERT(apol_policy_build_relabel_index(p) == 0);
+	v = relabel_run(relabel_cases);
+	CU_ASSERT_FATAL(qpol_policy_get_rebuild_seqno(q, &before) == 0);
+	CU_ASSERT_FATAL(qpol_policy_rebuild(q, 0) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_rebuild_seqno(q, &after) == 0);
+	CU_ASSERT(after != before);
+	w = relabel_run(relabel_cases);
+	CU_ASSERT(apol_vector_get_size(w) == apol_vector_get_size(v));
+	apol_vector_destroy(&v);
+	apol_vector_destroy(&w);
+	CU_ASSERT(apol_relabel_closure(p, "tmp_t", NULL, APOL_RELABEL_DIR_TO, &v) == 0);
+	apol_vector_destroy(&v);
+	CU_ASSERT(qpol_policy_rebuild(q, QPOL_POLICY_OPTION_NO_NEVERALLOWS) == 0);
+}
+
+CU_TestInfo relabel_tests[] = {
+	{"index matches search", relabel_index},
+	{"transitive closure", relabel_closure},
+	{"index after rebuild", relabel_rebuild},
+	CU_TEST_INFO_NULL
+};
+
+int relabel_init()
+{
+	apol_policy_path_t *ppath = apol_policy_path_create(APOL_POLICY_PATH_TYPE_MONOLITHIC, BIG_POLICY, NULL);
+	if (ppath == NULL) {
+		return 1;
+	}
+
+	if ((p = apol_policy_create_from_policy_path(ppath, QPOL_POLICY_OPTION_NO_NEVERALLOWS, NULL, NULL)) == NULL) {
+		apol_policy_path_destroy(&ppath);
+		return 1;
+	}
+	apol_policy_path_destroy(&ppath);
+	return 0;
+}
+
+int relabel_cleanup()
+{
+	apol_policy_destroy(&p);
+	return 0;
+}
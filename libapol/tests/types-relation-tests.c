@@ -0,0 +1,263 @@
+/**
+ *  @file
+ *
+ *  Test the types relation analysis, both pair by pair and in
+ *  batches, sequentially and with several threads.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <CUnit/CUnit.h>
+#include <apol/domain-trans-analysis.h>
+#include <apol/infoflow-analysis.h>
+#include <apol/perm-map.h>
+#include <apol/policy.h>
+#include <apol/policy-path.h>
+#include <apol/types-relation-analysis.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define BIG_POLICY TEST_POLICIES "/snapshots/fc4_targeted.policy.conf"
+#define PERMMAP TOP_SRCDIR "/apol/perm_maps/apol_perm_mapping_ver19"
+
+#define FIRST_TYPE "local_login_t"
+
+static const char *other_types[] = {
+	"agp_device_t", "sshd_t", "etc_t", "shadow_t", "unconfined_t", NULL
+};
+
+static apol_policy_t *p = NULL;
+
+/**
+ * Compare two vectors of pointers into the policy, element by
+ * element.
+ */
+static void types_relation_compare_ptrs(const apol_vector_t * v, const apol_vector_t * w)
+{
+	CU_ASSERT_FATAL(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		CU_ASSERT(apol_vector_get_element(v, i) == apol_vector_get_element(w, i));
+	}
+}
+
+static void types_relation_compare_accesses(const apol_vector_t * v, const apol_vector_t * w)
+{
+	CU_ASSERT_FATAL(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		const apol_types_relation_access_t *a = apol_vector_get_element(v, i);
+		const apol_types_relation_access_t *b = apol_vector_get_element(w, i);
+		CU_ASSERT(apol_types_relation_access_get_type(a) == apol_types_relation_access_get_type(b));
+		types_relation_compare_ptrs(apol_types_relation_access_get_rules(a), apol_types_relation_access_get_rules(b));
+	}
+}
+
+static void types_relation_compare_flows(const apol_vector_t * v, const apol_vector_t * w)
+{
+	CU_ASSERT_FATAL(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		const apol_infoflow_result_t *r = apol_vector_get_element(v, i);
+		const apol_infoflow_result_t *s = apol_vector_get_element(w, i);
+		CU_ASSERT(apol_infoflow_result_get_dir(r) == apol_infoflow_result_get_dir(s));
+		CU_ASSERT(apol_infoflow_result_get_start_type(r) == apol_infoflow_result_get_start_type(s));
+		CU_ASSERT(apol_infoflow_result_get_end_type(r) == apol_infoflow_result_get_end_type(s));
+		CU_ASSERT(apol_infoflow_result_get_length(r) == apol_infoflow_result_get_length(s));
+		const apol_vector_t *steps_r = apol_infoflow_result_get_steps(r);
+		const apol_vector_t *steps_s = apol_infoflow_result_get_steps(s);
+		CU_ASSERT_FATAL(apol_vector_get_size(steps_r) == apol_vector_get_size(steps_s));
+		for (size_t j = 0; j < apol_vector_get_size(steps_r); j++) {
+			const apol_infoflow_step_t *a = apol_vector_get_element(steps_r, j);
+			const apol_infoflow_step_t *b = apol_vector_get_element(steps_s, j);
+			CU_ASSERT(apol_infoflow_step_get_start_type(a) == apol_infoflow_step_get_start_type(b));
+			CU_ASSERT(apol_infoflow_step_get_end_type(a) == apol_infoflow_step_get_end_type(b));
+			CU_ASSERT(apol_infoflow_step_get_weight(a) == apol_infoflow_step_get_weight(b));
+			types_relation_compare_ptrs(apol_infoflow_step_get_rules(a), apol_infoflow_step_get_rules(b));
+		}
+	}
+}
+
+static void types_relation_compare_domains(const apol_vector_t * v, const apol_vector_t * w)
+{
+	CU_ASSERT_FATAL(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		const apol_domain_trans_result_t *r = apol_vector_get_element(v, i);
+		const apol_domain_trans_result_t *s = apol_vector_get_element(w, i);
+		CU_ASSERT(apol_domain_trans_result_get_start_type(r) == apol_domain_trans_result_get_start_type(s));
+		CU_ASSERT(apol_domain_trans_result_get_entrypoint_type(r) == apol_domain_trans_result_get_entrypoint_type(s));
+		CU_ASSERT(apol_domain_trans_result_get_end_type(r) == apol_domain_trans_result_get_end_type(s));
+		CU_ASSERT(apol_domain_trans_result_is_trans_valid(r) == apol_domain_trans_result_is_trans_valid(s));
+		types_relation_compare_ptrs(apol_domain_trans_result_get_proc_trans_rules(r),
+					    apol_domain_trans_result_get_proc_trans_rules(s));
+		types_relation_compare_ptrs(apol_domain_trans_result_get_entrypoint_rules(r),
+					    apol_domain_trans_result_get_entrypoint_rules(s));
+		types_relation_compare_ptrs(apol_domain_trans_result_get_exec_rules(r),
+					    apol_domain_trans_result_get_exec_rules(s));
+		types_relation_compare_ptrs(apol_domain_trans_result_get_setexec_rules(r),
+					    apol_domain_trans_result_get_setexec_rules(s));
+		types_relation_compare_ptrs(apol_domain_trans_result_get_type_trans_rules(r),
+					    apol_domain_trans_result_get_type_trans_rules(s));
+	}
+}
+
+static void types_relation_compare(const apol_types_relation_result_t * r, const apol_types_relation_result_t * s)
+{
+	CU_ASSERT_PTR_NOT_NULL_FATAL(r);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(s);
+	types_relation_compare_ptrs(apol_types_relation_result_get_attributes(r), apol_types_relation_result_get_attributes(s));
+	types_relation_compare_ptrs(apol_types_relation_result_get_roles(r), apol_types_relation_result_get_roles(s));
+	types_relation_compare_ptrs(apol_types_relation_result_get_users(r), apol_types_relation_result_get_users(s));
+	types_relation_compare_accesses(apol_types_relation_result_get_similar_first(r),
+					apol_types_relation_result_get_similar_first(s));
+	types_relation_compare_accesses(apol_types_relation_result_get_similar_other(r),
+					apol_types_relation_result_get_similar_other(s));
+	types_relation_compare_accesses(apol_types_relation_result_get_dissimilar_first(r),
+					apol_types_relation_result_get_dissimilar_first(s));
+	types_relation_compare_accesses(apol_types_relation_result_get_dissimilar_other(r),
+					apol_types_relation_result_get_dissimilar_other(s));
+	types_relation_compare_ptrs(apol_types_relation_result_get_allowrules(r), apol_types_relation_result_get_allowrules(s));
+	types_relation_compare_ptrs(apol_types_relation_result_get_typerules(r), apol_types_relation_result_get_typerules(s));
+	types_relation_compare_flows(apol_types_relation_result_get_directflows(r), apol_types_relation_result_get_directflows(s));
+	types_relation_compare_flows(apol_types_relation_result_get_transflowsAB(r),
+				     apol_types_relation_result_get_transflowsAB(s));
+	types_relation_compare_flows(apol_types_relation_result_get_transflowsBA(r),
+				     apol_types_relation_result_get_transflowsBA(s));
+	types_relation_compare_domains(apol_types_relation_result_get_domainsAB(r), apol_types_relation_result_get_domainsAB(s));
+	types_relation_compare_domains(apol_types_relation_result_get_domainsBA(r), apol_types_relation_result_get_domainsBA(s));
+}
+
+static void types_relation_result_free(void *elem)
+{
+	apol_types_relation_result_t *r = elem;
+	apol_types_relation_result_destroy(&r);
+}
+
+/**
+ * Run the analysis once per other type, returning a vector of
+ * apol_types_relation_result_t in the same order as other_types.
+ */
+static apol_vector_t *types_relation_do_pairs(apol_types_relation_analysis_t * tr)
+{
+	apol_vector_t *v = apol_vector_create(types_relation_result_free);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	for (const char **other = other_types; *other != NULL; other++) {
+		apol_types_relation_result_t *r = NULL;
+		int retval = apol_types_relation_analysis_set_other_type(p, tr, *other);
+		CU_ASSERT_FATAL(retval == 0);
+		retval = apol_types_relation_analysis_do(p, tr, &r);
+		CU_ASSERT_FATAL(retval == 0);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(r);
+		retval = apol_vector_append(v, r);
+		CU_ASSERT_FATAL(retval == 0);
+	}
+	return v;
+}
+
+static apol_vector_t *types_relation_do_batch(apol_types_relation_analysis_t * tr)
+{
+	apol_vector_t *others = apol_vector_create(NULL), *v = NULL;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(others);
+	for (const char **other = other_types; *other != NULL; other++) {
+		int retval = apol_vector_append(others, (void *)*other);
+		CU_ASSERT_FATAL(retval == 0);
+	}
+	int retval = apol_types_relation_analysis_do_batch(p, tr, others, &v);
+	apol_vector_destroy(&others);
+	CU_ASSERT_FATAL(retval == 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	return v;
+}
+
+static void types_relation_compare_all(const apol_vector_t * v, const apol_vector_t * w)
+{
+	CU_ASSERT_FATAL(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v); i++) {
+		types_relation_compare(apol_vector_get_element(v, i), apol_vector_get_element(w, i));
+	}
+}
+
+static void types_relation_batch(void)
+{
+	apol_types_relation_analysis_t *tr = apol_types_relation_analysis_create();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(tr);
+	int retval = apol_types_relation_analysis_set_first_type(p, tr, FIRST_TYPE);
+	CU_ASSERT_FATAL(retval == 0);
+	apol_types_relation_analysis_set_threads(p, tr, 1);
+
+	apol_vector_t *v = types_relation_do_pairs(tr);
+	apol_vector_t *w = types_relation_do_batch(tr);
+	types_relation_compare_all(v, w);
+	apol_vector_destroy(&v);
+	apol_vector_destroy(&w);
+	apol_types_relation_analysis_destroy(&tr);
+}
+
+static void types_relation_threads(void)
+{
+	apol_types_relation_analysis_t *tr = apol_types_relation_analysis_create();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(tr);
+	int retval = apol_types_relation_analysis_set_first_type(p, tr, FIRST_TYPE);
+	CU_ASSERT_FATAL(retval == 0);
+
+	apol_types_relation_analysis_set_threads(p, tr, 1);
+	apol_vector_t *v = types_relation_do_pairs(tr);
+	apol_vector_t *w = types_relation_do_batch(tr);
+
+	/* more threads than there are independent analyses */
+	apol_types_relation_analysis_set_threads(p, tr, 8);
+	apol_vector_t *x = types_relation_do_pairs(tr);
+	apol_vector_t *y = types_relation_do_batch(tr);
+	types_relation_compare_all(v, x);
+	types_relation_compare_all(w, y);
+
+	apol_vector_destroy(&v);
+	apol_vector_destroy(&w);
+	apol_vector_destroy(&x);
+	apol_vector_destroy(&y);
+	apol_types_relation_analysis_destroy(&tr);
+}
+
+CU_TestInfo types_relation_tests[] = {
+	{"batch versus pairs", types_relation_batch}
+	,
+	{"one thread versus several", types_relation_threads}
+	,
+	CU_TEST_INFO_NULL
+};
+
+int types_relation_init()
+{
+	apol_policy_path_t *ppath = apol_policy_path_create(APOL_POLICY_PATH_TYPE_MONOLITHIC, BIG_POLICY, NULL);
+	if (ppath == NULL) {
+		return 1;
+	}
+
+	if ((p = apol_policy_create_from_policy_path(ppath, QPOL_POLICY_OPTION_NO_NEVERALLOWS, NULL, NULL)) == NULL) {
+		apol_policy_path_destroy(&ppath);
+		return 1;
+	}
+	apol_policy_path_destroy(&ppath);
+
+	if (apol_policy_open_permmap(p, PERMMAP) < 0) {
+		return 1;
+	}
+	return 0;
+}
+
+int types_relation_cleanup()
+{
+	apol_policy_destroy(&p);
+	return 0;
+}
@@ -0,0 +1,30 @@
+/**
+ *  @file
+ *
+ *  Declarations for libapol types relation analysis tests.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TYPES_RELATION_TESTS_H
+#define TYPES_RELATION_TESTS_H
+
+#include <CUnit/CUnit.h>
+
+extern CU_TestInfo types_relation_tests[];
+extern int types_relation_init();
+extern int types_relation_cleanup();
+
+#endif
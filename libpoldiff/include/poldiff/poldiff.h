@@ -87,6 +87,7 @@ extern "C"
 #include <poldiff/user_diff.h>
 #include <poldiff/type_map.h>
 #include <poldiff/util.h>
+#include <poldiff/component_record.h>
 
 /* NOTE: while defined OCONS are not currently supported */
 #define POLDIFF_DIFF_CLASSES       0x00000001U
@@ -167,6 +168,43 @@ extern "C"
  */
 	extern int poldiff_run(poldiff_t * diff, uint32_t flags);
 
+/**
+ *  Callback function signature for receiving differences as
+ *  poldiff_run() finds them.
+ *  @param diff The policy difference structure being run.
+ *  @param rec Component record for the kind of difference found.  Use
+ *  its functions to get the item's form and string representation.
+ *  @param item The difference found (e.g., a poldiff_avrule_t).  If
+ *  the stream does not retain results then the item is destroyed
+ *  after this function returns.
+ *  @param arg Argument given to poldiff_set_stream_callback().
+ *  @return 0 to continue, or < 0 to stop poldiff_run() with an error;
+ *  on error the callback should set errno.
+ */
+	typedef int (*poldiff_stream_fn_t) (const poldiff_t * diff, const poldiff_component_record_t * rec, const void *item,
+					    void *arg);
+
+/**
+ *  Register a function to receive each difference as it is found
+ *  during poldiff_run().  Items are delivered grouped by component,
+ *  in the order the component's diff finds them (which is not
+ *  necessarily the order of the component's result vector).
+ *  Statistics (see poldiff_get_stats()) are always kept.  If
+ *  differences are not retained then the result vectors (e.g.,
+ *  poldiff_get_avrule_vector_allow()) will be empty, and
+ *  poldiff_enable_line_numbers() has nothing upon which to act; this
+ *  keeps memory use independent of the number of differences.
+ *  @param diff The policy difference structure.
+ *  @param fn Function to call for each difference, or NULL to stop
+ *  streaming.
+ *  @param arg Arbitrary argument to pass as fn's last parameter.
+ *  @param retain If non-zero then also keep each difference within
+ *  the policy difference structure, as if no callback were set.
+ *  @return 0 on success and < 0 on error; if the call fails, errno
+ *  will be set.
+ */
+	extern int poldiff_set_stream_callback(poldiff_t * diff, poldiff_stream_fn_t fn, void *arg, int retain);
+
 /**
  *  Determine if a particular policy component/rule diff was actually
  *  run yet or not.
@@ -195,6 +233,20 @@ extern "C"
  */
 	extern int poldiff_get_stats(const poldiff_t * diff, uint32_t flags, size_t stats[5]);
 
+/**
+ *  Get the object into which poldiff_create() and poldiff_run()
+ *  record their phases of work: inferring and building the type map,
+ *  and one phase for each component diffed.  A component's phase
+ *  counts the items scanned in both policies, and as matched those
+ *  items found in both.  Loading and rebuilding each policy are
+ *  recorded within that policy's own stats; see
+ *  apol_policy_get_stats().
+ *  @param diff The policy difference structure.
+ *  @return The stats object, or NULL on error.  Do not destroy it; it
+ *  is destroyed along with the difference structure.
+ */
+	extern qpol_stats_t *poldiff_get_run_stats(const poldiff_t * diff);
+
 /**
  *  Enable line numbers for all rule differences.  If not called, line
  *  numbers will not be available when displaying differences.  This
@@ -52,14 +52,14 @@ struct poldiff_avrule
 	uint32_t spec;
 	/* pointer into policy's symbol table */
 	const char *source, *target;
-	/** the class string is pointer into the class_bst BST */
+	/** the class string is pointer into the class_strs pool */
 	char *cls;
 	poldiff_form_e form;
-	/** vector of pointers into the perm_bst BST (char *) */
+	/** vector of pointers into the perm_strs pool (char *) */
 	apol_vector_t *unmodified_perms;
-	/** vector of pointers into the perm_bst BST (char *) */
+	/** vector of pointers into the perm_strs pool (char *) */
 	apol_vector_t *added_perms;
-	/** vector of pointers into the perm_bst BST (char *) */
+	/** vector of pointers into the perm_strs pool (char *) */
 	apol_vector_t *removed_perms;
 	/** pointer into policy's conditional list, needed to render
 	 * conditional expressions */
@@ -82,13 +82,13 @@ typedef struct pseudo_avrule
 	uint32_t spec;
 	/** pseudo-type values */
 	uint32_t source, target;
-	/** pointer into the class_bst BST */
+	/** pointer into the class_strs pool */
 	char *cls;
-	/** array of pointers into the perm_bst BST */
+	/** array of pointers into the perm_strs pool */
 	/* (use an array here to save space) */
 	char **perms;
 	size_t num_perms;
-	/** array of pointers into the bool_bst BST */
+	/** array of pointers into the bool_strs pool */
 	char *bools[5];
 	uint32_t bool_val;
 	uint32_t branch;
@@ -293,7 +293,7 @@ static const apol_vector_t *poldiff_get_avrule_vector(const poldiff_t * diff, av
 		errno = EINVAL;
 		return NULL;
 	}
-	if (diff->avrule_diffs[idx]->diffs_sorted == 0) {
+	if (diff->avrule_diffs[idx]->diffs_sorted == 0 && !diff->streaming) {
 		apol_vector_sort(diff->avrule_diffs[idx]->diffs, poldiff_avrule_cmp, NULL);
 		diff->avrule_diffs[idx]->diffs_sorted = 1;
 	}
@@ -611,6 +611,89 @@ int avrule_reset_neverallow(poldiff_t * diff)
 	return avrule_reset(diff, AVRULE_OFFSET_NEVERALLOW);
 }
 
+/**
+ * Remove from the AV rule differences those entries whose source
+ * or target type belongs to a pseudo-type affected by the latest
+ * type_map_build_targeted(), so that they may be recomputed.  All
+ * other entries are left as they are.
+ * @param diff The policy difference structure containing the differences
+ * to prune.
+ * @param idx Index into the avrule diffs array indicating which rule
+ * type to prune, one of AVRULE_OFFSET_ALLOW, etc.
+ * @return 0 on success and < 0 on error; if the call fails,
+ * errno will be set and the user should call poldiff_destroy() on diff.
+ */
+static int avrule_prune(poldiff_t * diff, avrule_offset_e idx)
+{
+	poldiff_avrule_summary_t *rs = diff->avrule_diffs[idx];
+	apol_vector_t *kept;
+	poldiff_avrule_t *a;
+	size_t i;
+	int which, error;
+
+	if ((kept = apol_vector_create_with_capacity(apol_vector_get_size(rs->diffs), poldiff_avrule_free)) == NULL) {
+		error = errno;
+		ERR(diff, "%s", strerror(error));
+		errno = error;
+		return -1;
+	}
+	/* walk backwards so that each removal is from the vector's end */
+	for (i = apol_vector_get_size(rs->diffs); i > 0; i--) {
+		a = apol_vector_get_element(rs->diffs, i - 1);
+		apol_vector_remove(rs->diffs, i - 1);
+		which = (a->form == POLDIFF_FORM_ADDED || a->form == POLDIFF_FORM_ADD_TYPE ? POLDIFF_POLICY_MOD : POLDIFF_POLICY_ORIG);
+		if (type_map_is_affected_name(diff, a->source, which) || type_map_is_affected_name(diff, a->target, which)) {
+			switch (a->form) {
+			case POLDIFF_FORM_ADDED:
+				rs->num_added--;
+				break;
+			case POLDIFF_FORM_ADD_TYPE:
+				rs->num_added_type--;
+				break;
+			case POLDIFF_FORM_REMOVED:
+				rs->num_removed--;
+				break;
+			case POLDIFF_FORM_REMOVE_TYPE:
+				rs->num_removed_type--;
+				break;
+			case POLDIFF_FORM_MODIFIED:
+				rs->num_modified--;
+				break;
+			default:
+				break;
+			}
+			poldiff_avrule_free(a);
+		} else {
+			/* cannot fail, given the capacity above */
+			apol_vector_append(kept, a);
+		}
+	}
+	apol_vector_destroy(&rs->diffs);
+	rs->diffs = kept;
+	rs->diffs_sorted = 0;
+	return 0;
+}
+
+int avrule_prune_allow(poldiff_t * diff)
+{
+	return avrule_prune(diff, AVRULE_OFFSET_ALLOW);
+}
+
+int avrule_prune_auditallow(poldiff_t * diff)
+{
+	return avrule_prune(diff, AVRULE_OFFSET_AUDITALLOW);
+}
+
+int avrule_prune_dontaudit(poldiff_t * diff)
+{
+	return avrule_prune(diff, AVRULE_OFFSET_DONTAUDIT);
+}
+
+int avrule_prune_neverallow(poldiff_t * diff)
+{
+	return avrule_prune(diff, AVRULE_OFFSET_NEVERALLOW);
+}
+
 static void avrule_free_item(void *item)
 {
 	pseudo_avrule_t *a = (pseudo_avrule_t *) item;
@@ -751,7 +834,7 @@ static int avrule_build_cond(poldiff_t * diff, const apol_policy_t * p, const qp
 			error = errno;
 			goto cleanup;
 		}
-		if (apol_bst_get_element(diff->bool_bst, (void *)bool_name, NULL, (void **)&pseudo_bool) < 0) {
+		if (apol_strpool_get_element(diff->bool_strs, bool_name, &pseudo_bool) < 0) {
 			error = EBADRQC;	/* should never get here */
 			ERR(diff, "%s", strerror(error));
 			assert(0);
@@ -853,6 +936,12 @@ static int avrule_add_to_bst(poldiff_t * diff, const apol_policy_t * p,
 	const qpol_cond_t *cond;
 	qpol_policy_t *q = apol_policy_get_qpol(p);
 	int retval = -1, error = 0, compval;
+	/* during a targeted re-diff, only rules involving an affected
+	 * type need to be compared; the rest already have their
+	 * results */
+	if (!type_map_is_affected(diff, source) && !type_map_is_affected(diff, target)) {
+		return 0;
+	}
 	if ((key = calloc(1, sizeof(*key))) == NULL) {
 		error = errno;
 		ERR(diff, "%s", strerror(error));
@@ -868,7 +957,7 @@ static int avrule_add_to_bst(poldiff_t * diff, const apol_policy_t * p,
 		error = errno;
 		goto cleanup;
 	}
-	if (apol_bst_get_element(diff->class_bst, (void *)class_name, NULL, (void **)&key->cls) < 0) {
+	if (apol_strpool_get_element(diff->class_strs, class_name, &key->cls) < 0) {
 		error = EBADRQC;       /* should never get here */
 		ERR(diff, "%s", strerror(error));
 		assert(0);
@@ -906,7 +995,7 @@ static int avrule_add_to_bst(poldiff_t * diff, const apol_policy_t * p,
 			error = errno;
 			goto cleanup;
 		}
-		if (apol_bst_get_element(diff->perm_bst, perm_name, NULL, (void **)&pseudo_perm) < 0) {
+		if (apol_strpool_get_element(diff->perm_strs, perm_name, &pseudo_perm) < 0) {
 			error = EBADRQC;	/* should never get here */
 			ERR(diff, "%s", strerror(error));
 			assert(0);
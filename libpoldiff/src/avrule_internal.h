@@ -87,6 +87,50 @@ extern "C"
  */
 	int avrule_reset_neverallow(poldiff_t * diff);
 
+/**
+ * Remove those AV allow rule differences that involve a type
+ * affected by the latest targeted type map build, so that they may
+ * be recomputed.
+ * @param diff The policy difference structure containing the differences
+ * to prune.
+ * @return 0 on success and < 0 on error; if the call fails,
+ * errno will be set and the user should call poldiff_destroy() on diff.
+ */
+	int avrule_prune_allow(poldiff_t * diff);
+
+/**
+ * Remove those AV auditallow rule differences that involve a type
+ * affected by the latest targeted type map build, so that they may
+ * be recomputed.
+ * @param diff The policy difference structure containing the differences
+ * to prune.
+ * @return 0 on success and < 0 on error; if the call fails,
+ * errno will be set and the user should call poldiff_destroy() on diff.
+ */
+	int avrule_prune_auditallow(poldiff_t * diff);
+
+/**
+ * Remove those AV dontaudit rule differences that involve a type
+ * affected by the latest targeted type map build, so that they may
+ * be recomputed.
+ * @param diff The policy difference structure containing the differences
+ * to prune.
+ * @return 0 on success and < 0 on error; if the call fails,
+ * errno will be set and the user should call poldiff_destroy() on diff.
+ */
+	int avrule_prune_dontaudit(poldiff_t * diff);
+
+/**
+ * Remove those AV neverallow rule differences that involve a type
+ * affected by the latest targeted type map build, so that they may
+ * be recomputed.
+ * @param diff The policy difference structure containing the differences
+ * to prune.
+ * @return 0 on success and < 0 on error; if the call fails,
+ * errno will be set and the user should call poldiff_destroy() on diff.
+ */
+	int avrule_prune_neverallow(poldiff_t * diff);
+
 /**
  * Get a vector of AV allow rules from the given policy, sorted.  This
  * function will remap source and target types to their pseudo-type
@@ -51,6 +51,9 @@ struct poldiff_component_record
 	poldiff_item_comp_fn_t comp;
 	poldiff_new_diff_fn_t new_diff;
 	poldiff_deep_diff_fn_t deep_diff;
+	/** if not NULL, removes only those results involving types
+	 * whose mapping changed, instead of resetting everything */
+	poldiff_reset_fn_t prune;
 };
 
 static const poldiff_component_record_t component_records[] = {
@@ -79,6 +82,7 @@ static const poldiff_component_record_t component_records[] = {
 	 avrule_comp,
 	 avrule_new_diff_allow,
 	 avrule_deep_diff_allow,
+	 avrule_prune_allow,
 	 },
 	{
 	 "Audit Allow Rules",
@@ -92,6 +96,7 @@ static const poldiff_component_record_t component_records[] = {
 	 avrule_comp,
 	 avrule_new_diff_auditallow,
 	 avrule_deep_diff_auditallow,
+	 avrule_prune_auditallow,
 	 },
 	{
 	 "Don't Audit Rules",
@@ -105,6 +110,7 @@ static const poldiff_component_record_t component_records[] = {
 	 avrule_comp,
 	 avrule_new_diff_dontaudit,
 	 avrule_deep_diff_dontaudit,
+	 avrule_prune_dontaudit,
 	 },
 	{
 	 "Never Allow Rules",
@@ -118,6 +124,7 @@ static const poldiff_component_record_t component_records[] = {
 	 avrule_comp,
 	 avrule_new_diff_neverallow,
 	 avrule_deep_diff_neverallow,
+	 avrule_prune_neverallow,
 	 },
 	{
 	 "bool",
@@ -248,6 +255,7 @@ static const poldiff_component_record_t component_records[] = {
 	 terule_comp,
 	 terule_new_diff_change,
 	 terule_deep_diff_change,
+	 terule_prune_change,
 	 },
 	{
 	 "Type Member Rules",
@@ -261,6 +269,7 @@ static const poldiff_component_record_t component_records[] = {
 	 terule_comp,
 	 terule_new_diff_member,
 	 terule_deep_diff_member,
+	 terule_prune_member,
 	 },
 	{
 	 "Type Transition Rules",
@@ -274,6 +283,7 @@ static const poldiff_component_record_t component_records[] = {
 	 terule_comp,
 	 terule_new_diff_trans,
 	 terule_deep_diff_trans,
+	 terule_prune_trans,
 	 },
 	{
 	 "type",
@@ -338,18 +348,20 @@ poldiff_t *poldiff_create(apol_policy_t * orig_policy, apol_policy_t * mod_polic
 	diff->mod_qpol = apol_policy_get_qpol(diff->mod_pol);
 	diff->fn = fn;
 	diff->handle_arg = callback_arg;
-	if ((diff->type_map = type_map_create()) == NULL) {
+	if ((diff->stats = qpol_stats_create()) == NULL || (diff->type_map = type_map_create()) == NULL) {
 		ERR(diff, "%s", strerror(ENOMEM));
 		poldiff_destroy(&diff);
 		errno = ENOMEM;
 		return NULL;
 	}
+	qpol_stats_begin(diff->stats, "infer type map");
 	if (type_map_infer(diff) < 0) {
 		error = errno;
 		poldiff_destroy(&diff);
 		errno = error;
 		return NULL;
 	}
+	qpol_stats_end(diff->stats);
 
 	if ((diff->attrib_diffs = attrib_summary_create()) == NULL ||
 	    (diff->avrule_diffs[AVRULE_OFFSET_ALLOW] = avrule_create()) == NULL ||
@@ -385,9 +397,9 @@ void poldiff_destroy(poldiff_t ** diff)
 		return;
 	apol_policy_destroy(&(*diff)->orig_pol);
 	apol_policy_destroy(&(*diff)->mod_pol);
-	apol_bst_destroy(&(*diff)->class_bst);
-	apol_bst_destroy(&(*diff)->perm_bst);
-	apol_bst_destroy(&(*diff)->bool_bst);
+	apol_strpool_destroy(&(*diff)->class_strs);
+	apol_strpool_destroy(&(*diff)->perm_strs);
+	apol_strpool_destroy(&(*diff)->bool_strs);
 
 	type_map_destroy(&(*diff)->type_map);
 	attrib_summary_destroy(&(*diff)->attrib_diffs);
@@ -409,10 +421,59 @@ void poldiff_destroy(poldiff_t ** diff)
 	terule_destroy(&(*diff)->terule_diffs[TERULE_OFFSET_MEMBER]);
 	terule_destroy(&(*diff)->terule_diffs[TERULE_OFFSET_TRANS]);
 	type_summary_destroy(&(*diff)->type_diffs);
+	qpol_stats_destroy(&(*diff)->stats);
 	free(*diff);
 	*diff = NULL;
 }
 
+int poldiff_set_stream_callback(poldiff_t * diff, poldiff_stream_fn_t fn, void *arg, int retain)
+{
+	if (diff == NULL) {
+		ERR(diff, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	diff->stream_fn = fn;
+	diff->stream_arg = arg;
+	diff->stream_retain = retain;
+	return 0;
+}
+
+/**
+ * Pass each result item that a component added since the last call
+ * to the stream callback.  If results are not being retained then
+ * destroy those items afterwards.
+ *
+ * @param diff Policy difference structure with a stream callback.
+ * @param component_record Record for the component being diffed.
+ * @param num_seen Reference to the number of result items already
+ * streamed.  This will be updated upon success.
+ *
+ * @return 0 on success, < 0 on error; errno will be set.
+ */
+static int poldiff_stream_new_results(poldiff_t * diff, const poldiff_component_record_t * component_record, size_t * num_seen)
+{
+	/* the results vector belongs to the component, so it is safe
+	 * to shrink it here */
+	apol_vector_t *v = (apol_vector_t *) component_record->get_results(diff);
+	size_t i, size;
+	if (v == NULL) {
+		return -1;
+	}
+	size = apol_vector_get_size(v);
+	for (i = *num_seen; i < size; i++) {
+		if (diff->stream_fn(diff, component_record, apol_vector_get_element(v, i), diff->stream_arg) < 0) {
+			return -1;
+		}
+	}
+	if (diff->stream_retain) {
+		*num_seen = size;
+	} else if (apol_vector_truncate(v, *num_seen) < 0) {
+		return -1;
+	}
+	return 0;
+}
+
 /**
  * Given a particular policy item record (e.g., one for object
  * classes), (re-)perform a diff of them between the two policies
@@ -432,7 +493,7 @@ static int poldiff_do_item_diff(poldiff_t * diff, const poldiff_component_record
 {
 	apol_vector_t *p1_v = NULL, *p2_v = NULL;
 	int error = 0, retv;
-	size_t x = 0, y = 0;
+	size_t x = 0, y = 0, num_seen = 0, depth;
 	void *item_x = NULL, *item_y = NULL;
 
 	if (!diff || !component_record) {
@@ -441,6 +502,8 @@ static int poldiff_do_item_diff(poldiff_t * diff, const poldiff_component_record
 		return -1;
 	}
 	diff->diff_status &= (~component_record->flag_bit);
+	depth = qpol_stats_get_depth(diff->stats);
+	qpol_stats_begin(diff->stats, component_record->item_name);
 
 	INFO(diff, "Getting %s items from original policy.", component_record->item_name);
 	p1_v = component_record->get_items(diff, diff->orig_pol);
@@ -456,72 +519,87 @@ static int poldiff_do_item_diff(poldiff_t * diff, const poldiff_component_record
 		goto err;
 	}
 
+	if (diff->stream_fn != NULL) {
+		const apol_vector_t *results = component_record->get_results(diff);
+		if (results == NULL) {
+			error = errno;
+			goto err;
+		}
+		num_seen = apol_vector_get_size(results);
+		diff->streaming = 1;
+	}
+
 	INFO(diff, "Finding differences in %s.", component_record->item_name);
-	for (x = 0, y = 0; x < apol_vector_get_size(p1_v);) {
-		if (y >= apol_vector_get_size(p2_v))
-			break;
-		item_x = apol_vector_get_element(p1_v, x);
-		item_y = apol_vector_get_element(p2_v, y);
-		retv = component_record->comp(item_x, item_y, diff);
+	qpol_stats_add(diff->stats, QPOL_STATS_RULES_SCANNED, apol_vector_get_size(p1_v) + apol_vector_get_size(p2_v));
+	for (x = 0, y = 0; x < apol_vector_get_size(p1_v) || y < apol_vector_get_size(p2_v);) {
+		if (y >= apol_vector_get_size(p2_v)) {
+			retv = -1;
+		} else if (x >= apol_vector_get_size(p1_v)) {
+			retv = 1;
+		} else {
+			retv = component_record->comp(apol_vector_get_element(p1_v, x), apol_vector_get_element(p2_v, y), diff);
+		}
 		if (retv < 0) {
+			item_x = apol_vector_get_element(p1_v, x);
 			if (component_record->new_diff(diff, POLDIFF_FORM_REMOVED, item_x)) {
 				error = errno;
 				goto err;
 			}
 			x++;
 		} else if (retv > 0) {
+			item_y = apol_vector_get_element(p2_v, y);
 			if (component_record->new_diff(diff, POLDIFF_FORM_ADDED, item_y)) {
 				error = errno;
 				goto err;
 			}
 			y++;
 		} else {
+			item_x = apol_vector_get_element(p1_v, x);
+			item_y = apol_vector_get_element(p2_v, y);
 			if (component_record->deep_diff(diff, item_x, item_y)) {
 				error = errno;
 				goto err;
 			}
+			/* for a diff, a match is an item found in both policies */
+			qpol_stats_add(diff->stats, QPOL_STATS_RULES_MATCHED, 1);
 			x++;
 			y++;
 		}
-	}
-	for (; x < apol_vector_get_size(p1_v); x++) {
-		item_x = apol_vector_get_element(p1_v, x);
-		if (component_record->new_diff(diff, POLDIFF_FORM_REMOVED, item_x)) {
-			error = errno;
-			goto err;
-		}
-	}
-	for (; y < apol_vector_get_size(p2_v); y++) {
-		item_y = apol_vector_get_element(p2_v, y);
-		if (component_record->new_diff(diff, POLDIFF_FORM_ADDED, item_y)) {
+		if (diff->stream_fn != NULL && poldiff_stream_new_results(diff, component_record, &num_seen) < 0) {
 			error = errno;
 			goto err;
 		}
 	}
 
+	diff->streaming = 0;
 	apol_vector_destroy(&p1_v);
 	apol_vector_destroy(&p2_v);
 	diff->diff_status |= component_record->flag_bit;
+	qpol_stats_end_to(diff->stats, depth);
 	return 0;
       err:
+	diff->streaming = 0;
 	apol_vector_destroy(&p1_v);
 	apol_vector_destroy(&p2_v);
+	qpol_stats_end_to(diff->stats, depth);
 	errno = error;
 	return -1;
 }
 
-int poldiff_run(poldiff_t * diff, uint32_t flags)
+/**
+ * Rebuild the policies if needed, then run each requested diff that
+ * has not yet been run.
+ *
+ * @param diff The difference structure.
+ * @param flags Bit-wise or'd set of POLDIFF_DIFF_* from poldiff.h.
+ *
+ * @return 0 on success or < 0 on error; if the call fails, errno
+ * will be set.
+ */
+static int poldiff_run_components(poldiff_t * diff, uint32_t flags)
 {
 	size_t i, num_items;
-
-	if (!flags)
-		return 0;	       /* nothing to do */
-
-	if (!diff) {
-		ERR(diff, "%s", strerror(EINVAL));
-		errno = EINVAL;
-		return -1;
-	}
+	int rebuilt = 0, targeted = 0, retv;
 
 	int policy_opts = diff->policy_opts;
 	if (flags & (POLDIFF_DIFF_AVRULES | POLDIFF_DIFF_TERULES)) {
@@ -542,27 +620,56 @@ int poldiff_run(poldiff_t * diff, uint32_t flags)
 		// force flushing of existing pointers into policies
 		diff->remapped = 1;
 		diff->policy_opts = policy_opts;
+		rebuilt = 1;
 	}
 
 	num_items = sizeof(component_records) / sizeof(poldiff_component_record_t);
 	if (diff->remapped) {
 		for (i = 0; i < num_items; i++) {
 			if (component_records[i].flag_bit & POLDIFF_DIFF_REMAPPED) {
+				/* retained results that are wanted again and
+				 * that can be patched are pruned after the
+				 * type map is rebuilt, rather than recomputed */
+				if (!rebuilt && component_records[i].prune != NULL &&
+				    (diff->stream_fn == NULL || diff->stream_retain) &&
+				    (flags & component_records[i].flag_bit) && (diff->diff_status & component_records[i].flag_bit)) {
+					targeted = 1;
+					continue;
+				}
 				INFO(diff, "Resetting %s diff.", component_records[i].item_name);
 				if (component_records[i].reset(diff))
 					return -1;
+				diff->diff_status &= ~(component_records[i].flag_bit);
 			}
 		}
-		diff->diff_status &= ~(POLDIFF_DIFF_REMAPPED);
 		diff->remapped = 0;
 	}
 
 	INFO(diff, "%s", "Building type map.");
-	if (type_map_build(diff)) {
+	qpol_stats_begin(diff->stats, "type map");
+	if (targeted) {
+		retv = type_map_build_targeted(diff);
+	} else {
+		retv = type_map_build(diff);
+	}
+	qpol_stats_end(diff->stats);
+	if (retv) {
 		return -1;
 	}
 
 	diff->line_numbers_enabled = 0;
+	if (targeted) {
+		for (i = 0; i < num_items; i++) {
+			if (component_records[i].prune != NULL && (flags & component_records[i].flag_bit) &&
+			    (diff->diff_status & component_records[i].flag_bit)) {
+				INFO(diff, "Updating %s diff.", component_records[i].item_name);
+				if (component_records[i].prune(diff) || poldiff_do_item_diff(diff, &(component_records[i]))) {
+					return -1;
+				}
+			}
+		}
+		type_map_clear_affected(diff);
+	}
 	for (i = 0; i < num_items; i++) {
 		/* item requested but not yet run */
 		if ((flags & component_records[i].flag_bit) && !(component_records[i].flag_bit & diff->diff_status)) {
@@ -576,6 +683,37 @@ int poldiff_run(poldiff_t * diff, uint32_t flags)
 	return 0;
 }
 
+int poldiff_run(poldiff_t * diff, uint32_t flags)
+{
+	size_t depth;
+	int retv;
+
+	if (!flags)
+		return 0;	       /* nothing to do */
+
+	if (!diff) {
+		ERR(diff, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+
+	depth = qpol_stats_get_depth(diff->stats);
+	qpol_stats_begin(diff->stats, "poldiff run");
+	retv = poldiff_run_components(diff, flags);
+	qpol_stats_end_to(diff->stats, depth);
+	return retv;
+}
+
+qpol_stats_t *poldiff_get_run_stats(const poldiff_t * diff)
+{
+	if (diff == NULL) {
+		ERR(diff, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return NULL;
+	}
+	return diff->stats;
+}
+
 int poldiff_is_run(const poldiff_t * diff, uint32_t flags)
 {
 	if (!flags)
@@ -663,14 +801,13 @@ int poldiff_build_bsts(poldiff_t * diff)
 	const qpol_class_t *cls;
 	qpol_bool_t *qbool;
 	const char *name;
-	char *new_name;
 	int retval = -1, error = 0;
-	if (diff->class_bst != NULL) {
+	if (diff->class_strs != NULL) {
 		return 0;
 	}
-	if ((diff->class_bst = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (diff->perm_bst = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (diff->bool_bst = apol_bst_create(apol_str_strcmp, free)) == NULL) {
+	if ((diff->class_strs = apol_strpool_create()) == NULL ||
+	    (diff->perm_strs = apol_strpool_create()) == NULL ||
+	    (diff->bool_strs = apol_strpool_create()) == NULL) {
 		error = errno;
 		ERR(diff, "%s", strerror(error));
 		goto cleanup;
@@ -689,8 +826,7 @@ int poldiff_build_bsts(poldiff_t * diff)
 				error = errno;
 				goto cleanup;
 			}
-			if ((new_name = strdup(name)) == NULL ||
-			    apol_bst_insert_and_get(diff->class_bst, (void **)&new_name, NULL) < 0) {
+			if (apol_strpool_insert(diff->class_strs, name, NULL) < 0) {
 				error = errno;
 				ERR(diff, "%s", strerror(error));
 				goto cleanup;
@@ -698,8 +834,7 @@ int poldiff_build_bsts(poldiff_t * diff)
 		}
 		for (j = 0; j < apol_vector_get_size(perms[i]); j++) {
 			name = (char *)apol_vector_get_element(perms[i], j);
-			if ((new_name = strdup(name)) == NULL ||
-			    apol_bst_insert_and_get(diff->perm_bst, (void **)&new_name, NULL) < 0) {
+			if (apol_strpool_insert(diff->perm_strs, name, NULL) < 0) {
 				error = errno;
 				ERR(diff, "%s", strerror(error));
 				goto cleanup;
@@ -711,8 +846,7 @@ int poldiff_build_bsts(poldiff_t * diff)
 				error = errno;
 				goto cleanup;
 			}
-			if ((new_name = strdup(name)) == NULL ||
-			    apol_bst_insert_and_get(diff->bool_bst, (void **)&new_name, NULL) < 0) {
+			if (apol_strpool_insert(diff->bool_strs, name, NULL) < 0) {
 				error = errno;
 				ERR(diff, "%s", strerror(error));
 				goto cleanup;
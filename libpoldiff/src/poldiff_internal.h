@@ -32,6 +32,7 @@ extern "C"
 
 #include <poldiff/poldiff.h>
 #include <apol/bst.h>
+#include <apol/strpool.h>
 
 	typedef enum
 	{
@@ -92,12 +93,12 @@ extern "C"
 		qpol_policy_t *mod_qpol;
 		/** non-zero if rules' line numbers are accurate */
 		int line_numbers_enabled;
-		/** BST of duplicated strings, used when making pseudo-rules */
-		apol_bst_t *class_bst;
-		/** BST of duplicated strings, used when making pseudo-rules */
-		apol_bst_t *perm_bst;
-		/** BST of duplicated strings, used when making pseudo-rules */
-		apol_bst_t *bool_bst;
+		/** pool of duplicated strings, used when making pseudo-rules */
+		apol_strpool_t *class_strs;
+		/** pool of duplicated strings, used when making pseudo-rules */
+		apol_strpool_t *perm_strs;
+		/** pool of duplicated strings, used when making pseudo-rules */
+		apol_strpool_t *bool_strs;
 		poldiff_handle_fn_t fn;
 		void *handle_arg;
 		/** set of POLDIF_DIFF_* bits for diffs run */
@@ -122,6 +123,18 @@ extern "C"
 		int policy_opts;
 		/** set if type mapping was changed since last run */
 		int remapped;
+		/** if non-NULL, function to receive differences as they
+		 *  are found */
+		poldiff_stream_fn_t stream_fn;
+		void *stream_arg;
+		/** if zero, destroy each difference once streamed */
+		int stream_retain;
+		/** non-zero while differences are being streamed; result
+		 *  vectors must not be re-sorted during this time */
+		int streaming;
+		/** phases of work done by poldiff_create() and
+		 *  poldiff_run() */
+		qpol_stats_t *stats;
 	};
 
 /**
@@ -52,7 +52,7 @@ struct poldiff_terule
 	uint32_t spec;
 	/* pointer into policy's symbol table */
 	const char *source, *target;
-	/** the class string is pointer into the class_bst BST */
+	/** the class string is pointer into the class_strs pool */
 	const char *cls;
 	poldiff_form_e form;
 	/* pointer into policy's symbol table */
@@ -78,9 +78,9 @@ typedef struct pseudo_terule
 	uint32_t spec;
 	/** pseudo-type values */
 	uint32_t source, target, default_type;
-	/** pointer into the class_bst BST */
+	/** pointer into the class_strs pool */
 	const char *cls;
-	/** array of pointers into the bool_bst BST */
+	/** array of pointers into the bool_strs pool */
 	const char *bools[5];
 	uint32_t bool_val;
 	uint32_t branch;
@@ -293,7 +293,7 @@ static const apol_vector_t *poldiff_get_terule_vector(const poldiff_t * diff, te
 		errno = EINVAL;
 		return NULL;
 	}
-	if (diff->terule_diffs[idx]->diffs_sorted == 0) {
+	if (diff->terule_diffs[idx]->diffs_sorted == 0 && !diff->streaming) {
 		apol_vector_sort(diff->terule_diffs[idx]->diffs, poldiff_terule_cmp, NULL);
 		diff->terule_diffs[idx]->diffs_sorted = 1;
 	}
@@ -496,6 +496,86 @@ int terule_reset_trans(poldiff_t * diff)
 	return terule_reset(diff, TERULE_OFFSET_TRANS);
 }
 
+/**
+ * Remove from the TE rule differences those entries whose source,
+ * target, or default type belongs to a pseudo-type affected by the
+ * latest type_map_build_targeted(), so that they may be recomputed.
+ * All other entries are left as they are.
+ * @param diff The policy difference structure containing the differences
+ * to prune.
+ * @param idx Index into the terule diffs array indicating which rule
+ * type to prune, one of TERULE_OFFSET_CHANGE, etc.
+ * @return 0 on success and < 0 on error; if the call fails,
+ * errno will be set and the user should call poldiff_destroy() on diff.
+ */
+static int terule_prune(poldiff_t * diff, terule_offset_e idx)
+{
+	poldiff_terule_summary_t *rs = diff->terule_diffs[idx];
+	apol_vector_t *kept;
+	poldiff_terule_t *a;
+	size_t i;
+	int which, error;
+
+	if ((kept = apol_vector_create_with_capacity(apol_vector_get_size(rs->diffs), poldiff_terule_free)) == NULL) {
+		error = errno;
+		ERR(diff, "%s", strerror(error));
+		errno = error;
+		return -1;
+	}
+	/* walk backwards so that each removal is from the vector's end */
+	for (i = apol_vector_get_size(rs->diffs); i > 0; i--) {
+		a = apol_vector_get_element(rs->diffs, i - 1);
+		apol_vector_remove(rs->diffs, i - 1);
+		which = (a->form == POLDIFF_FORM_ADDED || a->form == POLDIFF_FORM_ADD_TYPE ? POLDIFF_POLICY_MOD : POLDIFF_POLICY_ORIG);
+		if (type_map_is_affected_name(diff, a->source, which) || type_map_is_affected_name(diff, a->target, which) ||
+		    type_map_is_affected_name(diff, a->orig_default, POLDIFF_POLICY_ORIG) ||
+		    type_map_is_affected_name(diff, a->mod_default, POLDIFF_POLICY_MOD)) {
+			switch (a->form) {
+			case POLDIFF_FORM_ADDED:
+				rs->num_added--;
+				break;
+			case POLDIFF_FORM_ADD_TYPE:
+				rs->num_added_type--;
+				break;
+			case POLDIFF_FORM_REMOVED:
+				rs->num_removed--;
+				break;
+			case POLDIFF_FORM_REMOVE_TYPE:
+				rs->num_removed_type--;
+				break;
+			case POLDIFF_FORM_MODIFIED:
+				rs->num_modified--;
+				break;
+			default:
+				break;
+			}
+			poldiff_terule_free(a);
+		} else {
+			/* cannot fail, given the capacity above */
+			apol_vector_append(kept, a);
+		}
+	}
+	apol_vector_destroy(&rs->diffs);
+	rs->diffs = kept;
+	rs->diffs_sorted = 0;
+	return 0;
+}
+
+int terule_prune_change(poldiff_t * diff)
+{
+	return terule_prune(diff, TERULE_OFFSET_CHANGE);
+}
+
+int terule_prune_member(poldiff_t * diff)
+{
+	return terule_prune(diff, TERULE_OFFSET_MEMBER);
+}
+
+int terule_prune_trans(poldiff_t * diff)
+{
+	return terule_prune(diff, TERULE_OFFSET_TRANS);
+}
+
 static void terule_free_item(void *item)
 {
 	pseudo_terule_t *t = (pseudo_terule_t *) item;
@@ -606,7 +686,8 @@ static int terule_build_cond(const poldiff_t * diff, const apol_policy_t * p, co
 	qpol_bool_t *bools[5] = { NULL, NULL, NULL, NULL, NULL }, *qbool;
 	size_t i, j;
 	size_t num_bools = 0;
-	const char *bool_name, *pseudo_bool, *t;
+	const char *bool_name, *t;
+	char *pseudo_bool;
 	qpol_policy_t *q = apol_policy_get_qpol(p);
 	int retval = -1, error = 0, compval;
 	if (qpol_cond_get_expr_node_iter(q, cond, &iter) < 0) {
@@ -641,7 +722,7 @@ static int terule_build_cond(const poldiff_t * diff, const apol_policy_t * p, co
 			error = errno;
 			goto cleanup;
 		}
-		if (apol_bst_get_element(diff->bool_bst, (void *)bool_name, NULL, (void **)&pseudo_bool) < 0) {
+		if (apol_strpool_get_element(diff->bool_strs, bool_name, &pseudo_bool) < 0) {
 			error = EBADRQC;	/* should never get here */
 			ERR(diff, "%s", strerror(error));
 			assert(0);
@@ -710,6 +791,7 @@ static int terule_add_to_bst(poldiff_t * diff, const apol_policy_t * p,
 	const qpol_class_t *obj_class;
 	const qpol_type_t *default_type;
 	const char *class_name;
+	char *pseudo_class;
 	const qpol_cond_t *cond;
 	qpol_policy_t *q = apol_policy_get_qpol(p);
 	int retval = -1, error = 0, compval;
@@ -729,12 +811,13 @@ static int terule_add_to_bst(poldiff_t * diff, const apol_policy_t * p,
 		error = errno;
 		goto cleanup;
 	}
-	if (apol_bst_get_element(diff->class_bst, (void *)class_name, NULL, (void **)&key->cls) < 0) {
+	if (apol_strpool_get_element(diff->class_strs, class_name, &pseudo_class) < 0) {
 		error = EBADRQC;       /* should never get here */
 		ERR(diff, "%s", strerror(error));
 		assert(0);
 		goto cleanup;
 	}
+	key->cls = pseudo_class;
 	if ((key->default_type = type_map_lookup(diff, default_type, which)) == 0) {
 		error = errno;
 		ERR(diff, "%s", strerror(error));
@@ -1038,6 +1121,13 @@ static int terule_new_diff(poldiff_t * diff, poldiff_form_e form, const void *it
 	const char *orig_default = NULL, *mod_default = NULL;
 	int retval = -1, error = errno;
 
+	/* during a targeted re-diff, rules not involving an affected
+	 * type already have their results */
+	if (!type_map_is_affected(diff, rule->source) && !type_map_is_affected(diff, rule->target) &&
+	    !type_map_is_affected(diff, rule->default_type)) {
+		return 0;
+	}
+
 	/* check if form should really become ADD_TYPE / REMOVE_TYPE,
 	 * by seeing if the /other/ policy's reverse lookup is
 	 * empty */
@@ -1180,6 +1270,11 @@ static int terule_deep_diff(poldiff_t * diff, const void *x, const void *y, teru
 	poldiff_terule_t *pt = NULL;
 	int retval = -1, error = 0;
 
+	if (!type_map_is_affected(diff, r1->source) && !type_map_is_affected(diff, r1->target) &&
+	    !type_map_is_affected(diff, r1->default_type) && !type_map_is_affected(diff, r2->default_type)) {
+		return 0;
+	}
+
 	if (r1->default_type != r2->default_type) {
 		if ((pt = make_tediff(diff, POLDIFF_FORM_MODIFIED, r1)) == NULL) {
 			error = errno;
@@ -78,6 +78,39 @@ extern "C"
  */
 	int terule_reset_trans(poldiff_t * diff);
 
+/**
+ * Remove those TE type_change rule differences that involve a type
+ * affected by the latest targeted type map build, so that they may
+ * be recomputed.
+ * @param diff The policy difference structure containing the differences
+ * to prune.
+ * @return 0 on success and < 0 on error; if the call fails,
+ * errno will be set and the user should call poldiff_destroy() on diff.
+ */
+	int terule_prune_change(poldiff_t * diff);
+
+/**
+ * Remove those TE type_member rule differences that involve a type
+ * affected by the latest targeted type map build, so that they may
+ * be recomputed.
+ * @param diff The policy difference structure containing the differences
+ * to prune.
+ * @return 0 on success and < 0 on error; if the call fails,
+ * errno will be set and the user should call poldiff_destroy() on diff.
+ */
+	int terule_prune_member(poldiff_t * diff);
+
+/**
+ * Remove those TE type_transition rule differences that involve a type
+ * affected by the latest targeted type map build, so that they may
+ * be recomputed.
+ * @param diff The policy difference structure containing the differences
+ * to prune.
+ * @return 0 on success and < 0 on error; if the call fails,
+ * errno will be set and the user should call poldiff_destroy() on diff.
+ */
+	int terule_prune_trans(poldiff_t * diff);
+
 /**
  * Get a vector of type_change rules from the given policy, sorted.
  * This function will remap source and target types to their
@@ -159,7 +159,7 @@ const apol_vector_t *poldiff_get_type_vector(const poldiff_t * diff)
 	/* the elements of the results vector are not sorted by name,
 	 * but by pseudo-type value.  thus sort them by name as
 	 * necessary */
-	if (!diff->type_diffs->are_diffs_sorted) {
+	if (!diff->type_diffs->are_diffs_sorted && !diff->streaming) {
 		apol_vector_sort(diff->type_diffs->diffs, poldiff_type_comp, NULL);
 		diff->type_diffs->are_diffs_sorted = 1;
 	}
@@ -30,6 +30,7 @@
 
 #include "poldiff_internal.h"
 
+#include <apol/hashset.h>
 #include <apol/policy-query.h>
 #include <apol/util.h>
 #include <assert.h>
@@ -59,6 +60,10 @@ struct type_map
 	size_t num_mod_types;
 	/** vector of poldiff_type_remap_entry_t */
 	apol_vector_t *remap;
+	/** after type_map_build_targeted(), array indexed by pseudo
+	    value of flags set for pseudo-types whose members changed;
+	    NULL if all pseudo-types are to be considered changed */
+	char *affected;
 };
 
 /**
@@ -297,6 +302,7 @@ void type_map_destroy(type_map_t ** map)
 		apol_vector_destroy(&(*map)->pseudo_to_orig);
 		apol_vector_destroy(&(*map)->pseudo_to_mod);
 		apol_vector_destroy(&(*map)->remap);
+		free((*map)->affected);
 		free(*map);
 		*map = NULL;
 	}
@@ -383,6 +389,8 @@ int type_map_build(poldiff_t * diff)
 	map->num_mod_types = 0;
 	apol_vector_destroy(&map->pseudo_to_orig);
 	apol_vector_destroy(&map->pseudo_to_mod);
+	free(map->affected);
+	map->affected = NULL;
 
 	if (apol_type_get_by_query(diff->orig_pol, NULL, &ov) < 0 || apol_type_get_by_query(diff->mod_pol, NULL, &mv) < 0) {
 		error = errno;
@@ -573,168 +581,168 @@ int type_map_build(poldiff_t * diff)
 	return retval;
 }
 
-void poldiff_type_remap_flush(poldiff_t * diff)
-{
-	if (diff == NULL || diff->type_map == NULL) {
-		ERR(diff, "%s", strerror(EINVAL));
-		errno = EINVAL;
-		return;
-	}
-	apol_vector_destroy(&(diff->type_map->remap));
-	/* no error checking below */
-	diff->type_map->remap = apol_vector_create(type_remap_entry_free);
-	diff->remapped = 1;
-}
-
 /**
- * Convenience struct for comparing elements within arrays of primary types.
+ * Record that a type used to have pseudo value old_val and now has
+ * new_val.  A pseudo-type whose members went to (or came from) more
+ * than one place is marked as changed.
  */
-struct type_map_comp
+static void type_map_note_move(uint32_t * fwd, uint32_t * rev, char *old_changed, char *new_changed, uint32_t old_val,
+			       uint32_t new_val)
 {
-	poldiff_t *diff;
-	/** from which policy the first element came, either
-	 * POLDIFF_POLICY_ORIG or POLDIFF_POLICY_MOD */
-	int dir;
-};
-
-/**
- * Given two qpol_type_t pointers, both of which are primary types,
- * compare their names for equivalence.
- *
- * @param a Pointer to a qpol_type_t from a policy.
- * @param b Pointer to a qpol_type_t from a policy.
- * @param data Pointer to a type_map_comp struct.
- *
- * @return 0 if the names match, non-zero if not.
- */
-static int type_map_primary_comp(const void *a, const void *b, void *data)
-{
-	const qpol_type_t *ta = a;
-	const qpol_type_t *tb = b;
-	struct type_map_comp *c = (struct type_map_comp *)data;
-	poldiff_t *diff = c->diff;
-	int dir = c->dir;
-	const char *na, *nb;
-	if (dir == POLDIFF_POLICY_ORIG) {
-		if (qpol_type_get_name(diff->orig_qpol, ta, &na) < 0 || qpol_type_get_name(diff->mod_qpol, tb, &nb) < 0) {
-			return -1;
-		}
-	} else {
-		if (qpol_type_get_name(diff->mod_qpol, ta, &na) < 0 || qpol_type_get_name(diff->orig_qpol, tb, &nb) < 0) {
-			return -1;
-		}
+	if (fwd[old_val] == 0) {
+		fwd[old_val] = new_val;
+	} else if (fwd[old_val] != new_val) {
+		old_changed[old_val] = 1;
+	}
+	if (rev[new_val] == 0) {
+		rev[new_val] = old_val;
+	} else if (rev[new_val] != old_val) {
+		new_changed[new_val] = 1;
 	}
-	return strcmp(na, nb);
 }
 
 /**
- * Given two qpol_type_t pointers, both of which are primary types,
- * see if the first type matches any of the other type's aliases.
- *
- * @param a Pointer to a qpol_type_t from a policy.
- * @param b Pointer to a qpol_type_t from a policy.
- * @param data Pointer to a type_map_comp struct.
- *
- * @return 0 if b is a member of a's aliases, non-zero if not.
+ * Return non-zero if a pseudo-type's first member, which is the one
+ * whose name is shown in results, differs between two reverse maps.
  */
-static int type_map_prim_alias_comp(const void *a, const void *b, void *data)
-{
-	const qpol_type_t *ta = a;
-	const qpol_type_t *tb = b;
-	struct type_map_comp *c = (struct type_map_comp *)data;
-	poldiff_t *diff = c->diff;
-	int dir = c->dir;
-	const char *prim, *alias;
-	qpol_iterator_t *iter = NULL;
-	if (dir == POLDIFF_POLICY_ORIG) {
-		if (qpol_type_get_alias_iter(diff->orig_qpol, ta, &iter) < 0 || qpol_type_get_name(diff->mod_qpol, tb, &prim) < 0) {
-			qpol_iterator_destroy(&iter);
-			return -1;
-		}
-	} else {
-		if (qpol_type_get_alias_iter(diff->mod_qpol, ta, &iter) < 0 || qpol_type_get_name(diff->orig_qpol, tb, &prim) < 0) {
-			qpol_iterator_destroy(&iter);
-			return -1;
-		}
-	}
-	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
-		if (qpol_iterator_get_item(iter, (void **)&alias) < 0) {
-			qpol_iterator_destroy(&iter);
-			return -1;
-		}
-		if (strcmp(prim, alias) == 0) {
-			qpol_iterator_destroy(&iter);
-			return 0;
-		}
+static int type_map_first_differs(const apol_vector_t * old_v, const apol_vector_t * new_v)
+{
+	if (apol_vector_get_size(old_v) == 0 || apol_vector_get_size(new_v) == 0) {
+		return apol_vector_get_size(old_v) != apol_vector_get_size(new_v);
 	}
-	qpol_iterator_destroy(&iter);
-	return -1;
+	return apol_vector_get_element(old_v, 0) != apol_vector_get_element(new_v, 0);
 }
 
-/**
- * Given two qpol_type_t pointers, both of which are primary types,
- * see if the first type's aliases matches the second type's aliases.
- *
- * @param a Pointer to a qpol_type_t from a policy.
- * @param b Pointer to a qpol_type_t from a policy.
- * @param data Pointer to a type_map_comp struct.
- *
- * @return 0 if b is a member of a's aliases, non-zero if not.
- */
-static int type_map_prim_aliases_comp(const void *a, const void *b, void *data)
-{
-	qpol_type_t *ta = (qpol_type_t *) a;
-	qpol_type_t *tb = (qpol_type_t *) b;
-	struct type_map_comp *c = (struct type_map_comp *)data;
-	poldiff_t *diff = c->diff;
-	int dir = c->dir;
-	qpol_policy_t *p1, *p2;
-	qpol_iterator_t *iter1 = NULL, *iter2 = NULL;
-	apol_vector_t *v1 = NULL, *v2 = NULL;
-	size_t i;
+int type_map_build_targeted(poldiff_t * diff)
+{
+	type_map_t *map = diff->type_map;
+	uint32_t *old_orig = map->orig_to_pseudo, *old_mod = map->mod_to_pseudo;
+	apol_vector_t *old_to_orig = map->pseudo_to_orig, *old_to_mod = map->pseudo_to_mod;
+	uint32_t *fwd = NULL, *rev = NULL, o, n;
+	char *old_changed = NULL, *affected = NULL;
+	size_t i, num_old, num_new;
 	int retval = -1, error = 0;
-	if (dir == POLDIFF_POLICY_ORIG) {
-		p1 = diff->orig_qpol;
-		p2 = diff->mod_qpol;
-	} else {
-		p1 = diff->mod_qpol;
-		p2 = diff->orig_qpol;
-	}
-	if (qpol_type_get_alias_iter(p1, ta, &iter1) < 0) {
-		error = errno;
-		goto cleanup;
-	}
-	if ((v1 = apol_vector_create_from_iter(iter1, NULL)) == NULL) {
+
+	map->orig_to_pseudo = map->mod_to_pseudo = NULL;
+	map->pseudo_to_orig = map->pseudo_to_mod = NULL;
+	if (type_map_build(diff) < 0) {
 		error = errno;
-		ERR(diff, "%s", strerror(error));
 		goto cleanup;
 	}
-	if (qpol_type_get_alias_iter(p2, tb, &iter2) < 0) {
-		error = errno;
+	if (old_orig == NULL || old_mod == NULL) {
+		/* nothing to compare against, so everything changed */
+		retval = 0;
 		goto cleanup;
 	}
-	if ((v2 = apol_vector_create_from_iter(iter2, NULL)) == NULL) {
+
+	num_old = apol_vector_get_size(old_to_orig);
+	num_new = apol_vector_get_size(map->pseudo_to_orig);
+	if ((fwd = calloc(num_old + 1, sizeof(*fwd))) == NULL ||
+	    (rev = calloc(num_new + 1, sizeof(*rev))) == NULL ||
+	    (old_changed = calloc(num_old + 1, sizeof(*old_changed))) == NULL ||
+	    (affected = calloc(num_new + 1, sizeof(*affected))) == NULL) {
 		error = errno;
 		ERR(diff, "%s", strerror(error));
 		goto cleanup;
 	}
-	if (apol_vector_get_size(v1) == 0 || apol_vector_get_size(v2) == 0) {
-		retval = 1;
-		goto cleanup;
-	} else {
-		apol_vector_sort_uniquify(v1, apol_str_strcmp, NULL);
-		apol_vector_sort_uniquify(v2, apol_str_strcmp, NULL);
-		retval = apol_vector_compare(v1, v2, apol_str_strcmp, NULL, &i);
+
+	/* the policies are unchanged, so type values index the same
+	 * types before and after; attributes have no pseudo value */
+	for (i = 0; i < map->num_orig_types; i++) {
+		if ((o = old_orig[i]) != 0 && (n = map->orig_to_pseudo[i]) != 0) {
+			type_map_note_move(fwd, rev, old_changed, affected, o, n);
+		}
 	}
+	for (i = 0; i < map->num_mod_types; i++) {
+		if ((o = old_mod[i]) != 0 && (n = map->mod_to_pseudo[i]) != 0) {
+			type_map_note_move(fwd, rev, old_changed, affected, o, n);
+		}
+	}
+
+	/* a pseudo-type that kept exactly the same members is still
+	 * changed if a different name would now be shown for it */
+	for (n = 1; n <= num_new; n++) {
+		if (!affected[n] && (o = rev[n]) != 0 &&
+		    (type_map_first_differs(apol_vector_get_element(old_to_orig, o - 1),
+					    apol_vector_get_element(map->pseudo_to_orig, n - 1)) ||
+		     type_map_first_differs(apol_vector_get_element(old_to_mod, o - 1),
+					    apol_vector_get_element(map->pseudo_to_mod, n - 1)))) {
+			affected[n] = 1;
+		}
+	}
+
+	/* every type that left a changed pseudo-type taints the one it
+	 * joined */
+	for (i = 0; i < map->num_orig_types; i++) {
+		if ((o = old_orig[i]) != 0 && (n = map->orig_to_pseudo[i]) != 0 && old_changed[o]) {
+			affected[n] = 1;
+		}
+	}
+	for (i = 0; i < map->num_mod_types; i++) {
+		if ((o = old_mod[i]) != 0 && (n = map->mod_to_pseudo[i]) != 0 && old_changed[o]) {
+			affected[n] = 1;
+		}
+	}
+
+	map->affected = affected;
+	affected = NULL;
+	retval = 0;
       cleanup:
-	qpol_iterator_destroy(&iter1);
-	qpol_iterator_destroy(&iter2);
-	apol_vector_destroy(&v1);
-	apol_vector_destroy(&v2);
+	free(old_orig);
+	free(old_mod);
+	apol_vector_destroy(&old_to_orig);
+	apol_vector_destroy(&old_to_mod);
+	free(fwd);
+	free(rev);
+	free(old_changed);
+	free(affected);
 	errno = error;
 	return retval;
 }
 
+int type_map_is_affected(const poldiff_t * diff, uint32_t pseudo_val)
+{
+	const type_map_t *map = diff->type_map;
+	return map->affected == NULL || map->affected[pseudo_val];
+}
+
+int type_map_is_affected_name(const poldiff_t * diff, const char *name, int which_pol)
+{
+	const qpol_type_t *t;
+	qpol_policy_t *q = (which_pol == POLDIFF_POLICY_ORIG ? diff->orig_qpol : diff->mod_qpol);
+	uint32_t val;
+	if (diff->type_map->affected == NULL) {
+		return 1;
+	}
+	if (name == NULL) {
+		return 0;
+	}
+	if (qpol_policy_get_type_by_name(q, name, &t) < 0 || (val = type_map_lookup(diff, t, which_pol)) == 0) {
+		/* be conservative and recompute anything unresolvable */
+		return 1;
+	}
+	return diff->type_map->affected[val];
+}
+
+void type_map_clear_affected(poldiff_t * diff)
+{
+	free(diff->type_map->affected);
+	diff->type_map->affected = NULL;
+}
+
+void poldiff_type_remap_flush(poldiff_t * diff)
+{
+	if (diff == NULL || diff->type_map == NULL) {
+		ERR(diff, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return;
+	}
+	apol_vector_destroy(&(diff->type_map->remap));
+	/* no error checking below */
+	diff->type_map->remap = apol_vector_create(type_remap_entry_free);
+	diff->remapped = 1;
+}
+
 /**
  * If --enable-debug is given, then dump to stdout the type-map from
  * pseudo-types to the policy's type(s).
@@ -792,14 +800,208 @@ static int type_map_entry_append_qtypes(poldiff_t * diff, poldiff_type_remap_ent
 	return 0;
 }
 
+/**
+ * A name (either a primary name or an alias) of a type, indexed by
+ * type_map_infer().
+ */
+struct type_map_name
+{
+	const char *name;
+	/** index of the type within its policy's vector of types */
+	size_t idx;
+};
+
+/**
+ * A type's set of aliases, indexed by type_map_infer().  Types with
+ * the same set of aliases are chained together in increasing order
+ * of index; only the first of the chain is stored in the hash set.
+ */
+struct type_map_alias_set
+{
+	/** sorted vector of unique alias names (char *) */
+	apol_vector_t *aliases;
+	size_t idx;
+	struct type_map_alias_set *next, *tail;
+};
+
+static size_t type_map_name_hash(const void *elem, void *data __attribute__ ((unused)))
+{
+	return apol_str_hash(((const struct type_map_name *)elem)->name);
+}
+
+static int type_map_name_comp(const void *a, const void *b, void *data __attribute__ ((unused)))
+{
+	return strcmp(((const struct type_map_name *)a)->name, ((const struct type_map_name *)b)->name);
+}
+
+static size_t type_map_alias_set_hash(const void *elem, void *data __attribute__ ((unused)))
+{
+	const apol_vector_t *v = ((const struct type_map_alias_set *)elem)->aliases;
+	size_t hash = apol_vector_get_size(v), i;
+	for (i = 0; i < apol_vector_get_size(v); i++) {
+		hash = hash * 31 + apol_str_hash(apol_vector_get_element(v, i));
+	}
+	return hash;
+}
+
+static int type_map_alias_set_comp(const void *a, const void *b, void *data __attribute__ ((unused)))
+{
+	size_t i;
+	return apol_vector_compare(((const struct type_map_alias_set *)a)->aliases,
+				   ((const struct type_map_alias_set *)b)->aliases, apol_str_strcmp, NULL, &i);
+}
+
+/**
+ * Get the aliases of every type in a vector, each as a sorted vector
+ * of unique names.
+ *
+ * @param diff Policy difference structure, to report errors.
+ * @param q Policy containing the types.
+ * @param types Vector of qpol_type_t.
+ *
+ * @return An array of vectors of names (char *), one per element of
+ * types, or NULL on error.  The names belong to the policy.  The
+ * caller must destroy each vector and free the array afterwards.
+ */
+static apol_vector_t **type_map_get_aliases(poldiff_t * diff, const qpol_policy_t * q, const apol_vector_t * types)
+{
+	apol_vector_t **aliases;
+	qpol_iterator_t *iter = NULL;
+	size_t i, num_types = apol_vector_get_size(types);
+	int error;
+	if ((aliases = calloc(num_types + 1, sizeof(*aliases))) == NULL) {
+		error = errno;
+		ERR(diff, "%s", strerror(error));
+		errno = error;
+		return NULL;
+	}
+	for (i = 0; i < num_types; i++) {
+		if (qpol_type_get_alias_iter(q, apol_vector_get_element(types, i), &iter) < 0) {
+			error = errno;
+			goto err;
+		}
+		if ((aliases[i] = apol_vector_create_from_iter(iter, NULL)) == NULL) {
+			error = errno;
+			ERR(diff, "%s", strerror(error));
+			goto err;
+		}
+		qpol_iterator_destroy(&iter);
+		apol_vector_sort_uniquify(aliases[i], apol_str_strcmp, NULL);
+	}
+	return aliases;
+      err:
+	qpol_iterator_destroy(&iter);
+	for (i = 0; i < num_types; i++) {
+		apol_vector_destroy(&aliases[i]);
+	}
+	free(aliases);
+	errno = error;
+	return NULL;
+}
+
+/**
+ * Index the names of types.
+ *
+ * @param names Array into which to write the index's elements.  It
+ * must have room for every name being indexed, and it must outlive
+ * the returned hash set.
+ * @param types If non-NULL, a vector of primary types (qpol_type_t)
+ * whose names to index.
+ * @param q Policy containing the types.
+ * @param aliases If non-NULL, an array of alias names (as from
+ * type_map_get_aliases()) to index.
+ * @param num_types Number of types.
+ *
+ * @return A hash set of struct type_map_name, or NULL on error.  The
+ * caller must call apol_hashset_destroy() upon it afterwards.
+ */
+static apol_hashset_t *type_map_index_names(struct type_map_name *names, const apol_vector_t * types, const qpol_policy_t * q,
+					    apol_vector_t ** aliases, size_t num_types)
+{
+	apol_hashset_t *h;
+	size_t i, j, n = 0;
+	int error;
+	if ((h = apol_hashset_create(type_map_name_hash, type_map_name_comp, NULL)) == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < num_types; i++) {
+		if (types != NULL) {
+			if (qpol_type_get_name(q, apol_vector_get_element(types, i), &names[n].name) < 0) {
+				error = errno;
+				goto err;
+			}
+			names[n].idx = i;
+			if (apol_hashset_insert(h, names + n++, NULL) < 0) {
+				error = errno;
+				goto err;
+			}
+		}
+		for (j = 0; aliases != NULL && j < apol_vector_get_size(aliases[i]); j++) {
+			names[n].name = apol_vector_get_element(aliases[i], j);
+			names[n].idx = i;
+			if (apol_hashset_insert(h, names + n++, NULL) < 0) {
+				error = errno;
+				goto err;
+			}
+		}
+	}
+	return h;
+      err:
+	apol_hashset_destroy(&h);
+	errno = error;
+	return NULL;
+}
+
+/**
+ * Look up a name within an index built by type_map_index_names().
+ *
+ * @param h Index to search.
+ * @param name Name to find.
+ * @param done Array of flags marking types already mapped.
+ * @param idx Location to write the index of the type having the name.
+ *
+ * @return 0 if found and the type is not yet mapped, < 0 otherwise.
+ */
+static int type_map_index_find(const apol_hashset_t * h, const char *name, const char *done, size_t * idx)
+{
+	struct type_map_name key, *found;
+	key.name = name;
+	if (apol_hashset_get_element(h, &key, NULL, (void **)&found) < 0 || done[found->idx]) {
+		return -1;
+	}
+	*idx = found->idx;
+	return 0;
+}
+
+/**
+ * Create an inferred remap entry between two types, and mark both as
+ * mapped.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int type_map_infer_entry(poldiff_t * diff, const apol_vector_t * ov, const apol_vector_t * mv, char *orig_done,
+				char *mod_done, size_t i, size_t j)
+{
+	poldiff_type_remap_entry_t *entry;
+	if ((entry = poldiff_type_remap_entry_create(diff)) == NULL ||
+	    type_map_entry_append_qtypes(diff, entry, apol_vector_get_element(ov, i), apol_vector_get_element(mv, j)) < 0) {
+		return -1;
+	}
+	entry->inferred = 1;
+	orig_done[i] = 1;
+	mod_done[j] = 1;
+	return 0;
+}
+
 int type_map_infer(poldiff_t * diff)
 {
-	apol_vector_t *ov = NULL, *mv = NULL;
+	apol_vector_t *ov = NULL, *mv = NULL, **orig_aliases = NULL, **mod_aliases = NULL;
 	char *orig_done = NULL, *mod_done = NULL;
-	size_t num_orig, num_mod, i, j;
-	qpol_type_t *t, *u;
-	struct type_map_comp c = { diff, 0 };
-	poldiff_type_remap_entry_t *entry = NULL;
+	size_t num_orig, num_mod, num_orig_aliases = 0, num_mod_aliases = 0, i, j;
+	struct type_map_name *mod_name_nodes = NULL, *orig_alias_nodes = NULL, *mod_alias_nodes = NULL;
+	struct type_map_alias_set *set_nodes = NULL, key, *set;
+	apol_hashset_t *mod_names = NULL, *orig_alias_index = NULL, *mod_alias_index = NULL, *mod_sets = NULL;
+	const char *name;
 	int retval = -1, error = 0;
 
 	INFO(diff, "%s", "Inferring type remap.");
@@ -809,119 +1011,121 @@ int type_map_infer(poldiff_t * diff)
 	}
 	num_orig = apol_vector_get_size(ov);
 	num_mod = apol_vector_get_size(mv);
-	if ((orig_done = calloc(1, num_orig)) == NULL || (mod_done = calloc(1, num_mod)) == NULL) {
+	if ((orig_aliases = type_map_get_aliases(diff, diff->orig_qpol, ov)) == NULL ||
+	    (mod_aliases = type_map_get_aliases(diff, diff->mod_qpol, mv)) == NULL) {
+		error = errno;
+		goto cleanup;
+	}
+	for (i = 0; i < num_orig; i++) {
+		num_orig_aliases += apol_vector_get_size(orig_aliases[i]);
+	}
+	for (j = 0; j < num_mod; j++) {
+		num_mod_aliases += apol_vector_get_size(mod_aliases[j]);
+	}
+	if ((orig_done = calloc(1, num_orig + 1)) == NULL || (mod_done = calloc(1, num_mod + 1)) == NULL ||
+	    (mod_name_nodes = calloc(num_mod + 1, sizeof(*mod_name_nodes))) == NULL ||
+	    (orig_alias_nodes = calloc(num_orig_aliases + 1, sizeof(*orig_alias_nodes))) == NULL ||
+	    (mod_alias_nodes = calloc(num_mod_aliases + 1, sizeof(*mod_alias_nodes))) == NULL ||
+	    (set_nodes = calloc(num_mod + 1, sizeof(*set_nodes))) == NULL ||
+	    (mod_names = type_map_index_names(mod_name_nodes, mv, diff->mod_qpol, NULL, num_mod)) == NULL ||
+	    (orig_alias_index = type_map_index_names(orig_alias_nodes, NULL, NULL, orig_aliases, num_orig)) == NULL ||
+	    (mod_alias_index = type_map_index_names(mod_alias_nodes, NULL, NULL, mod_aliases, num_mod)) == NULL ||
+	    (mod_sets = apol_hashset_create(type_map_alias_set_hash, type_map_alias_set_comp, NULL)) == NULL) {
 		error = errno;
 		ERR(diff, "%s", strerror(error));
 		goto cleanup;
 	}
 
 	/* first map primary <--> primary */
-	c.dir = POLDIFF_POLICY_MOD;
 	for (i = 0; i < num_orig; i++) {
-		t = (qpol_type_t *) apol_vector_get_element(ov, i);
-		if (apol_vector_get_index(mv, t, type_map_primary_comp, &c, &j) < 0) {
+		if (qpol_type_get_name(diff->orig_qpol, apol_vector_get_element(ov, i), &name) < 0) {
+			error = errno;
+			goto cleanup;
+		}
+		if (type_map_index_find(mod_names, name, mod_done, &j) < 0) {
 			continue;
 		}
-		assert(!mod_done[j]);
-		u = (qpol_type_t *) apol_vector_get_element(mv, j);
-		if ((entry = poldiff_type_remap_entry_create(diff)) == NULL || type_map_entry_append_qtypes(diff, entry, t, u) < 0) {
+		if (type_map_infer_entry(diff, ov, mv, orig_done, mod_done, i, j) < 0) {
 			error = errno;
 			ERR(diff, "%s", strerror(error));
 			goto cleanup;
 		}
-		entry->inferred = 1;
-		orig_done[i] = 1;
-		mod_done[j] = 1;
 	}
 
 	/* now map primary -> primary's alias */
-	c.dir = POLDIFF_POLICY_MOD;
 	for (i = 0; i < num_orig; i++) {
 		if (orig_done[i]) {
 			continue;
 		}
-		t = (qpol_type_t *) apol_vector_get_element(ov, i);
-		u = NULL;
-		for (j = 0; j < num_mod; j++) {
-			if (mod_done[j]) {
-				continue;
-			}
-			u = (qpol_type_t *) apol_vector_get_element(mv, j);
-			if (type_map_prim_alias_comp(u, t, &c) == 0) {
-				break;
-			}
+		if (qpol_type_get_name(diff->orig_qpol, apol_vector_get_element(ov, i), &name) < 0) {
+			error = errno;
+			goto cleanup;
 		}
-		if (j >= num_mod) {
+		if (type_map_index_find(mod_alias_index, name, mod_done, &j) < 0) {
 			continue;
 		}
-		if ((entry = poldiff_type_remap_entry_create(diff)) == NULL || type_map_entry_append_qtypes(diff, entry, t, u) < 0) {
+		if (type_map_infer_entry(diff, ov, mv, orig_done, mod_done, i, j) < 0) {
 			error = errno;
 			ERR(diff, "%s", strerror(error));
 			goto cleanup;
 		}
-		entry->inferred = 1;
-		orig_done[i] = 1;
-		mod_done[j] = 1;
 	}
 
 	/* then map primary's alias <- primary */
-	c.dir = POLDIFF_POLICY_ORIG;
 	for (j = 0; j < num_mod; j++) {
 		if (mod_done[j]) {
 			continue;
 		}
-		u = (qpol_type_t *) apol_vector_get_element(mv, j);
-		t = NULL;
-		for (i = 0; i < num_orig; i++) {
-			if (orig_done[i]) {
-				continue;
-			}
-			t = (qpol_type_t *) apol_vector_get_element(ov, i);
-			if (type_map_prim_alias_comp(t, u, &c) == 0) {
-				break;
-			}
+		if (qpol_type_get_name(diff->mod_qpol, apol_vector_get_element(mv, j), &name) < 0) {
+			error = errno;
+			goto cleanup;
 		}
-		if (i >= num_orig) {
+		if (type_map_index_find(orig_alias_index, name, orig_done, &i) < 0) {
 			continue;
 		}
-		if ((entry = poldiff_type_remap_entry_create(diff)) == NULL || type_map_entry_append_qtypes(diff, entry, t, u) < 0) {
+		if (type_map_infer_entry(diff, ov, mv, orig_done, mod_done, i, j) < 0) {
 			error = errno;
 			ERR(diff, "%s", strerror(error));
 			goto cleanup;
 		}
-		entry->inferred = 1;
-		orig_done[i] = 1;
-		mod_done[j] = 1;
 	}
 
-	/* map alias <-> alias */
-	c.dir = POLDIFF_POLICY_MOD;
+	/* map alias <-> alias; each remaining original type is mapped to
+	 * the first remaining modified type with the same (non-empty)
+	 * set of aliases */
+	for (j = 0; j < num_mod; j++) {
+		if (mod_done[j] || apol_vector_get_size(mod_aliases[j]) == 0) {
+			continue;
+		}
+		set_nodes[j].aliases = mod_aliases[j];
+		set_nodes[j].idx = j;
+		set_nodes[j].tail = set_nodes + j;
+		if (apol_hashset_get_element(mod_sets, set_nodes + j, NULL, (void **)&set) == 0) {
+			set->tail->next = set_nodes + j;
+			set->tail = set_nodes + j;
+		} else if (apol_hashset_insert(mod_sets, set_nodes + j, NULL) < 0) {
+			error = errno;
+			ERR(diff, "%s", strerror(error));
+			goto cleanup;
+		}
+	}
 	for (i = 0; i < num_orig; i++) {
-		if (orig_done[i]) {
+		if (orig_done[i] || apol_vector_get_size(orig_aliases[i]) == 0) {
 			continue;
 		}
-		t = (qpol_type_t *) apol_vector_get_element(ov, i);
-		u = NULL;
-		for (j = 0; j < num_mod; j++) {
-			if (mod_done[j]) {
-				continue;
-			}
-			u = (qpol_type_t *) apol_vector_get_element(mv, j);
-			if (type_map_prim_aliases_comp(u, t, &c) == 0) {
-				break;
-			}
+		key.aliases = orig_aliases[i];
+		if (apol_hashset_get_element(mod_sets, &key, NULL, (void **)&set) < 0) {
+			continue;
 		}
-		if (j >= num_mod) {
+		for (; set != NULL && mod_done[set->idx]; set = set->next) ;
+		if (set == NULL) {
 			continue;
 		}
-		if ((entry = poldiff_type_remap_entry_create(diff)) == NULL || type_map_entry_append_qtypes(diff, entry, t, u) < 0) {
+		if (type_map_infer_entry(diff, ov, mv, orig_done, mod_done, i, set->idx) < 0) {
 			error = errno;
 			ERR(diff, "%s", strerror(error));
 			goto cleanup;
 		}
-		entry->inferred = 1;
-		orig_done[i] = 1;
-		mod_done[j] = 1;
 	}
 
 	type_remap_vector_dump(diff);
@@ -929,6 +1133,22 @@ int type_map_infer(poldiff_t * diff)
 	retval = 0;
 	diff->remapped = 1;
       cleanup:
+	apol_hashset_destroy(&mod_names);
+	apol_hashset_destroy(&orig_alias_index);
+	apol_hashset_destroy(&mod_alias_index);
+	apol_hashset_destroy(&mod_sets);
+	for (i = 0; orig_aliases != NULL && i < num_orig; i++) {
+		apol_vector_destroy(&orig_aliases[i]);
+	}
+	for (j = 0; mod_aliases != NULL && j < num_mod; j++) {
+		apol_vector_destroy(&mod_aliases[j]);
+	}
+	free(orig_aliases);
+	free(mod_aliases);
+	free(mod_name_nodes);
+	free(orig_alias_nodes);
+	free(mod_alias_nodes);
+	free(set_nodes);
 	apol_vector_destroy(&ov);
 	apol_vector_destroy(&mv);
 	free(orig_done);
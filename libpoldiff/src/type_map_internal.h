@@ -69,6 +69,55 @@ extern "C"
  */
 	int type_map_build(poldiff_t * diff);
 
+/**
+ *  Rebuild the type map, as per type_map_build(), and then compare
+ *  the new map against the previous one.  Each pseudo-type whose set
+ *  of member types changed (or whose displayed name changed) is
+ *  marked as affected; see type_map_is_affected().  If there was no
+ *  previous map then every pseudo-type is considered affected.  The
+ *  policies must not have been rebuilt since the previous map was
+ *  built.
+ *
+ *  @param diff The policy difference structure containing the
+ *  policies from which to construct the type map.
+ *  @return 0 on success and < 0 on error, if the call fails, errno will
+ *  be set.
+ */
+	int type_map_build_targeted(poldiff_t * diff);
+
+/**
+ *  Determine if a pseudo-type was affected by the most recent call to
+ *  type_map_build_targeted().
+ *
+ *  @param diff The policy difference structure containing the type map.
+ *  @param pseudo_val Pseudo-type value to check.
+ *
+ *  @return Non-zero if the pseudo-type's members changed, or if no
+ *  targeted build is in effect; 0 if it is unchanged.
+ */
+	int type_map_is_affected(const poldiff_t * diff, uint32_t pseudo_val);
+
+/**
+ *  Determine if a type, given by name, belongs to a pseudo-type that
+ *  was affected by the most recent call to type_map_build_targeted().
+ *
+ *  @param diff The policy difference structure containing the type map.
+ *  @param name Name of a primary type, or NULL.
+ *  @param which_pol One of POLDIFF_POLICY_ORIG or POLDIFF_POLICY_MOD.
+ *
+ *  @return Non-zero if the type was affected or if no targeted build
+ *  is in effect; 0 if it was not or if name is NULL.
+ */
+	int type_map_is_affected_name(const poldiff_t * diff, const char *name, int which_pol);
+
+/**
+ *  Forget the pseudo-types marked by type_map_build_targeted(), so
+ *  that all pseudo-types are once again considered affected.
+ *
+ *  @param diff The policy difference structure containing the type map.
+ */
+	void type_map_clear_affected(poldiff_t * diff);
+
 /**
  *  Clear away all type remap entries within the type map.  This
  *  function should be called some time after type_map_create().
@@ -323,6 +323,12 @@ int main()
 		,
 		{"Role Transition Rules", rules_roletrans_tests}
 		,
+		{"Streamed Rules", rules_stream_tests}
+		,
+		{"Remapped Rules", rules_remap_tests}
+		,
+		{"Inferred Type Map", rules_type_map_tests}
+		,
 		CU_TEST_INFO_NULL
 	};
 
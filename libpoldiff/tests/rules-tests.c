@@ -32,6 +32,7 @@
 
 #include <poldiff/poldiff.h>
 #include <apol/policy.h>
+#include <apol/type-query.h>
 #include <apol/vector.h>
 #include <apol/util.h>
 
@@ -904,6 +905,290 @@ void rules_roletrans_tests()
 	cleanup_test(answers);
 }
 
+static int stream_collect(const poldiff_t * d, const poldiff_component_record_t * rec, const void *item, void *arg)
+{
+	apol_vector_t *v = arg;
+	char *str = poldiff_component_record_get_to_string_fn(rec) (d, item);
+	if (str == NULL || apol_vector_append(v, str) < 0) {
+		free(str);
+		return -1;
+	}
+	return 0;
+}
+
+static apol_vector_t *results_to_strings(const poldiff_t * d, uint32_t flag)
+{
+	const poldiff_component_record_t *rec = poldiff_get_component_record(flag);
+	const apol_vector_t *results = poldiff_component_record_get_results_fn(rec) (d);
+	apol_vector_t *v = apol_vector_create(free);
+	size_t i;
+	for (i = 0; i < apol_vector_get_size(results); i++) {
+		apol_vector_append(v, poldiff_component_record_get_to_string_fn(rec) (d, apol_vector_get_element(results, i)));
+	}
+	return v;
+}
+
+/**
+ * Create a new policy difference between the rules test policies.
+ */
+static poldiff_t *create_rules_diff(void)
+{
+	apol_policy_path_t *orig_path, *mod_path;
+	apol_policy_t *orig, *mod;
+	poldiff_t *d;
+
+	orig_path = apol_policy_path_create(APOL_POLICY_PATH_TYPE_MONOLITHIC, RULES_ORIG_POLICY, NULL);
+	mod_path = apol_policy_path_create(APOL_POLICY_PATH_TYPE_MONOLITHIC, RULES_MOD_POLICY, NULL);
+	CU_ASSERT_FATAL(orig_path != NULL && mod_path != NULL);
+	orig = apol_policy_create_from_policy_path(orig_path, 0, NULL, NULL);
+	mod = apol_policy_create_from_policy_path(mod_path, 0, NULL, NULL);
+	apol_policy_path_destroy(&orig_path);
+	apol_policy_path_destroy(&mod_path);
+	CU_ASSERT_FATAL(orig != NULL && mod != NULL);
+	d = poldiff_create(orig, mod, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(d);
+	return d;
+}
+
+void rules_stream_tests()
+{
+	uint32_t flags[] = { POLDIFF_DIFF_AVALLOW, POLDIFF_DIFF_AVAUDITALLOW, POLDIFF_DIFF_AVDONTAUDIT,
+		POLDIFF_DIFF_TECHANGE, POLDIFF_DIFF_TEMEMBER, POLDIFF_DIFF_TETRANS, POLDIFF_DIFF_ROLE_ALLOWS
+	};
+	size_t i, first_diff = 0, stats[5], stream_stats[5];
+	poldiff_t *stream_diff;
+	apol_vector_t *streamed, *expected;
+
+	stream_diff = create_rules_diff();
+
+	for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		streamed = apol_vector_create(free);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(streamed);
+		CU_ASSERT(poldiff_set_stream_callback(stream_diff, stream_collect, streamed, 0) == 0);
+		CU_ASSERT(poldiff_run(stream_diff, flags[i]) == 0);
+
+		/* nothing is retained, but the statistics are still kept */
+		const poldiff_component_record_t *rec = poldiff_get_component_record(flags[i]);
+		CU_ASSERT(apol_vector_get_size(poldiff_component_record_get_results_fn(rec) (stream_diff)) == 0);
+		CU_ASSERT(poldiff_get_stats(diff, flags[i], stats) == 0);
+		CU_ASSERT(poldiff_get_stats(stream_diff, flags[i], stream_stats) == 0);
+		CU_ASSERT(memcmp(stats, stream_stats, sizeof(stats)) == 0);
+
+		/* the streamed items are the same as the retained ones */
+		expected = results_to_strings(diff, flags[i]);
+		apol_vector_sort(streamed, compare_str, NULL);
+		apol_vector_sort(expected, compare_str, NULL);
+		CU_ASSERT_FALSE(apol_vector_compare(streamed, expected, compare_str, NULL, &first_diff));
+		apol_vector_destroy(&expected);
+		apol_vector_destroy(&streamed);
+	}
+	poldiff_destroy(&stream_diff);
+}
+
+/**
+ * Check that two policy differences have the same results and
+ * statistics for a kind of rule.
+ */
+static void compare_rule_results(const poldiff_t * d1, const poldiff_t * d2, uint32_t flag)
+{
+	size_t first_diff = 0, stats1[5], stats2[5];
+	apol_vector_t *v1 = results_to_strings(d1, flag);
+	apol_vector_t *v2 = results_to_strings(d2, flag);
+	CU_ASSERT(poldiff_get_stats(d1, flag, stats1) == 0);
+	CU_ASSERT(poldiff_get_stats(d2, flag, stats2) == 0);
+	CU_ASSERT(memcmp(stats1, stats2, sizeof(stats1)) == 0);
+	apol_vector_sort(v1, compare_str, NULL);
+	apol_vector_sort(v2, compare_str, NULL);
+	CU_ASSERT_FALSE(apol_vector_compare(v1, v2, compare_str, NULL, &first_diff));
+	apol_vector_destroy(&v1);
+	apol_vector_destroy(&v2);
+}
+
+void rules_remap_tests()
+{
+	uint32_t flags[] = { POLDIFF_DIFF_AVALLOW, POLDIFF_DIFF_AVAUDITALLOW, POLDIFF_DIFF_AVDONTAUDIT,
+		POLDIFF_DIFF_TECHANGE, POLDIFF_DIFF_TEMEMBER, POLDIFF_DIFF_TETRANS
+	};
+	uint32_t all = POLDIFF_DIFF_AVRULES | POLDIFF_DIFF_TERULES;
+	size_t i;
+	poldiff_t *edited, *fresh;
+	apol_vector_t *orig_names, *mod_names, *entries;
+
+	edited = create_rules_diff();
+	fresh = create_rules_diff();
+	orig_names = apol_vector_create(NULL);
+	mod_names = apol_vector_create(NULL);
+	CU_ASSERT_FATAL(orig_names != NULL && mod_names != NULL);
+	apol_vector_append(orig_names, "potato_t");
+	apol_vector_append(mod_names, "pine_t");
+
+	/* adding a remap to an already run diff only recomputes the
+	 * affected rules, but must give the same answer as starting
+	 * over */
+	CU_ASSERT(poldiff_run(edited, all) == 0);
+	CU_ASSERT(poldiff_type_remap_create(edited, orig_names, mod_names) == 0);
+	CU_ASSERT(poldiff_run(edited, all) == 0);
+	CU_ASSERT(poldiff_type_remap_create(fresh, orig_names, mod_names) == 0);
+	CU_ASSERT(poldiff_run(fresh, all) == 0);
+	for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		compare_rule_results(edited, fresh, flags[i]);
+	}
+
+	/* likewise for removing it again */
+	entries = poldiff_type_remap_get_entries(edited);
+	CU_ASSERT_FATAL(entries != NULL && apol_vector_get_size(entries) > 0);
+	poldiff_type_remap_entry_remove(edited, apol_vector_get_element(entries, apol_vector_get_size(entries) - 1));
+	CU_ASSERT(poldiff_run(edited, all) == 0);
+	for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		compare_rule_results(edited, diff, flags[i]);
+	}
+
+	apol_vector_destroy(&orig_names);
+	apol_vector_destroy(&mod_names);
+	poldiff_destroy(&edited);
+	poldiff_destroy(&fresh);
+}
+
+/**
+ * Get a type's aliases as a sorted vector of names (char *) that
+ * belong to the policy.
+ */
+static apol_vector_t *type_map_get_aliases(const apol_policy_t * p, const qpol_type_t * type)
+{
+	qpol_policy_t *q = apol_policy_get_qpol(p);
+	qpol_iterator_t *iter = NULL;
+	apol_vector_t *v;
+	char *alias;
+	CU_ASSERT_FATAL(qpol_type_get_alias_iter(q, type, &iter) == 0);
+	v = apol_vector_create(NULL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		CU_ASSERT_FATAL(qpol_iterator_get_item(iter, (void **)&alias) == 0);
+		CU_ASSERT_FATAL(apol_vector_append(v, alias) == 0);
+	}
+	qpol_iterator_destroy(&iter);
+	apol_vector_sort_uniquify(v, apol_str_strcmp, NULL);
+	return v;
+}
+
+/**
+ * Infer the type map between the original and modified policies the
+ * slow way, by trying every pair of types in each of type map
+ * inference's passes: primary to primary, primary to alias, alias to
+ * primary, then alias set to alias set.
+ *
+ * @return Vector of mappings (char *), each of the form "orig -> mod".
+ */
+static apol_vector_t *type_map_expected(void)
+{
+	apol_vector_t *ov = NULL, *mv = NULL, **orig_aliases, **mod_aliases, *expected;
+	const char **orig_names, **mod_names;
+	char *orig_done, *mod_done, *s;
+	size_t num_orig, num_mod, i, j, idx, first_diff;
+	int pass;
+
+	CU_ASSERT_FATAL(apol_type_get_by_query(orig_policy, NULL, &ov) == 0);
+	CU_ASSERT_FATAL(apol_type_get_by_query(mod_policy, NULL, &mv) == 0);
+	num_orig = apol_vector_get_size(ov);
+	num_mod = apol_vector_get_size(mv);
+	orig_names = calloc(num_orig + 1, sizeof(*orig_names));
+	mod_names = calloc(num_mod + 1, sizeof(*mod_names));
+	orig_aliases = calloc(num_orig + 1, sizeof(*orig_aliases));
+	mod_aliases = calloc(num_mod + 1, sizeof(*mod_aliases));
+	orig_done = calloc(1, num_orig + 1);
+	mod_done = calloc(1, num_mod + 1);
+	expected = apol_vector_create(free);
+	CU_ASSERT_FATAL(orig_names != NULL && mod_names != NULL && orig_aliases != NULL && mod_aliases != NULL &&
+			orig_done != NULL && mod_done != NULL && expected != NULL);
+	for (i = 0; i < num_orig; i++) {
+		CU_ASSERT_FATAL(qpol_type_get_name(apol_policy_get_qpol(orig_policy), apol_vector_get_element(ov, i),
+						   orig_names + i) == 0);
+		orig_aliases[i] = type_map_get_aliases(orig_policy, apol_vector_get_element(ov, i));
+	}
+	for (j = 0; j < num_mod; j++) {
+		CU_ASSERT_FATAL(qpol_type_get_name(apol_policy_get_qpol(mod_policy), apol_vector_get_element(mv, j),
+						   mod_names + j) == 0);
+		mod_aliases[j] = type_map_get_aliases(mod_policy, apol_vector_get_element(mv, j));
+	}
+
+	for (pass = 0; pass < 4; pass++) {
+		for (i = 0; i < num_orig; i++) {
+			for (j = 0; j < num_mod && !orig_done[i]; j++) {
+				if (mod_done[j]) {
+					continue;
+				}
+				if ((pass == 0 && strcmp(orig_names[i], mod_names[j]) == 0) ||
+				    (pass == 1 && apol_vector_get_index(mod_aliases[j], orig_names[i], apol_str_strcmp, NULL, &idx) == 0) ||
+				    (pass == 2 && apol_vector_get_index(orig_aliases[i], mod_names[j], apol_str_strcmp, NULL, &idx) == 0) ||
+				    (pass == 3 && apol_vector_get_size(orig_aliases[i]) > 0 &&
+				     apol_vector_compare(orig_aliases[i], mod_aliases[j], apol_str_strcmp, NULL, &first_diff) == 0)) {
+					CU_ASSERT_FATAL(asprintf(&s, "%s -> %s", orig_names[i], mod_names[j]) >= 0);
+					CU_ASSERT_FATAL(apol_vector_append(expected, s) == 0);
+					orig_done[i] = 1;
+					mod_done[j] = 1;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < num_orig; i++) {
+		apol_vector_destroy(orig_aliases + i);
+	}
+	for (j = 0; j < num_mod; j++) {
+		apol_vector_destroy(mod_aliases + j);
+	}
+	free(orig_names);
+	free(mod_names);
+	free(orig_aliases);
+	free(mod_aliases);
+	free(orig_done);
+	free(mod_done);
+	apol_vector_destroy(&ov);
+	apol_vector_destroy(&mv);
+	return expected;
+}
+
+void rules_type_map_tests()
+{
+	apol_vector_t *entries, *orig_types, *mod_types, *inferred, *expected;
+	const poldiff_type_remap_entry_t *entry;
+	size_t i, first_diff = 0;
+	int test_result;
+	char *s;
+
+	entries = poldiff_type_remap_get_entries(diff);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(entries);
+	inferred = apol_vector_create(free);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(inferred);
+	for (i = 0; i < apol_vector_get_size(entries); i++) {
+		entry = apol_vector_get_element(entries, i);
+		if (poldiff_type_remap_entry_get_is_inferred(entry) != 1) {
+			continue;
+		}
+		/* inference only ever maps one type to one type */
+		orig_types = poldiff_type_remap_entry_get_original_types(diff, entry);
+		mod_types = poldiff_type_remap_entry_get_modified_types(diff, entry);
+		CU_ASSERT_FATAL(orig_types != NULL && mod_types != NULL);
+		CU_ASSERT_FATAL(apol_vector_get_size(orig_types) == 1 && apol_vector_get_size(mod_types) == 1);
+		CU_ASSERT_FATAL(asprintf(&s, "%s -> %s", (char *)apol_vector_get_element(orig_types, 0),
+					 (char *)apol_vector_get_element(mod_types, 0)) >= 0);
+		CU_ASSERT_FATAL(apol_vector_append(inferred, s) == 0);
+		apol_vector_destroy(&orig_types);
+		apol_vector_destroy(&mod_types);
+	}
+
+	expected = type_map_expected();
+	CU_ASSERT(apol_vector_get_size(expected) > 0);
+	apol_vector_sort(inferred, apol_str_strcmp, NULL);
+	apol_vector_sort(expected, apol_str_strcmp, NULL);
+	CU_ASSERT_FALSE(test_result = apol_vector_compare(inferred, expected, apol_str_strcmp, NULL, &first_diff));
+	if (test_result) {
+		print_test_failure(inferred, expected, first_diff, "Inferred Type Map");
+	}
+	apol_vector_destroy(&inferred);
+	apol_vector_destroy(&expected);
+}
+
 int rules_test_init()
 {
 	if (!(diff = init_poldiff(RULES_ORIG_POLICY, RULES_MOD_POLICY))) {
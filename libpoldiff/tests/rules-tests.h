@@ -31,6 +31,9 @@ void rules_avrules_tests();
 void rules_roleallow_tests();
 void rules_roletrans_tests();
 void rules_terules_tests();
+void rules_stream_tests();
+void rules_remap_tests();
+void rules_type_map_tests();
 
 void build_avrule_vecs();
 void build_terule_vecs();
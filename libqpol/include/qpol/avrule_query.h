@@ -63,6 +63,27 @@ extern "C"
  */
 	extern int qpol_policy_get_avrule_iter(const qpol_policy_t * policy, uint32_t rule_type_mask, qpol_iterator_t ** iter);
 
+/**
+ *  Get an iterator over the av rules in a policy of a rule type in
+ *  rule_type_mask whose source is exactly the given type.  Attributes
+ *  containing the type are not expanded; callers wanting those rules
+ *  must request each attribute separately.  If the policy was loaded
+ *  with QPOL_POLICY_OPTION_SORTED_RULES this is a binary search;
+ *  otherwise the entire rule table is scanned.
+ *  @param policy Policy from which to get the av rules.
+ *  @param rule_type_mask Bitwise or'ed set of QPOL_RULE_* values.
+ *  @param source Source type of the rules to return.
+ *  @param iter Iterator over items of type qpol_avrule_t returned.
+ *  The caller is responsible for calling qpol_iterator_destroy()
+ *  to free memory used by this iterator.
+ *  It is important to note that this iterator is only valid as long as
+ *  the policy is unmodifed.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *iter will be NULL.
+ */
+	extern int qpol_policy_get_avrule_iter_by_source(const qpol_policy_t * policy, uint32_t rule_type_mask,
+						   const qpol_type_t * source, qpol_iterator_t ** iter);
+
 /**
  *  Get the source type from an av rule.
  *  @param policy Policy from which the rule comes.
@@ -160,6 +181,39 @@ extern "C"
  */
 	extern int qpol_avrule_get_which_list(const qpol_policy_t * policy, const qpol_avrule_t * rule, uint32_t * which_list);
 
+/**
+ *  Compute the access vectors that a policy's av rules grant a source
+ *  type upon a target type and object class, in the manner of the
+ *  kernel's security_compute_av().  Rules whose source or target is
+ *  an attribute containing the respective type apply, as do
+ *  conditional rules that are currently enabled.  If the source type
+ *  is bounded by another type, then permissions that the rules do not
+ *  also grant the bounding type are removed from the allowed vector.
+ *  (If the target type is bounded too, then the bounding type is
+ *  checked against the target's bounding type.)  Constraints are not
+ *  considered.
+ *
+ *  Within each vector, bit i represents the permission whose value
+ *  within the class is i + 1; see qpol_class_get_perm_value().
+ *
+ *  @param policy Policy containing the rules.
+ *  @param source Source type.  If this is an alias then its primary
+ *  type is used.
+ *  @param target Target type.
+ *  @param obj_class Object class.
+ *  @param allowed Location to write the permissions that allow rules
+ *  grant.
+ *  @param auditallow Location to write the permissions whose grant is
+ *  audited.
+ *  @param auditdeny Location to write the permissions whose denial is
+ *  audited, i.e. the complement of those named by dontaudit rules.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set.
+ */
+	extern int qpol_policy_compute_av(const qpol_policy_t * policy, const qpol_type_t * source, const qpol_type_t * target,
+					  const qpol_class_t * obj_class, uint32_t * allowed, uint32_t * auditallow,
+					  uint32_t * auditdeny);
+
 #ifdef	__cplusplus
 }
 #endif
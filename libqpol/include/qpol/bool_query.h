@@ -85,7 +85,8 @@ extern "C"
 
 /**
  *  Set the state of a boolean and update the state of all conditionals
- *  using the boolean.
+ *  using the boolean.  Only those conditionals whose expressions
+ *  reference the boolean are re-evaluated.
  *  @param policy The policy with which the boolean is associated.
  *  The state of the policy is changed by this function.
  *  @param datum Boolean datum for which to set the state. Must be non-NULL.
@@ -95,6 +96,23 @@ extern "C"
  */
 	extern int qpol_bool_set_state(qpol_policy_t * policy, qpol_bool_t * datum, int state);
 
+/**
+ *  Set the states of several booleans at once, then update the state
+ *  of all conditionals using any of them.  This is faster than
+ *  calling qpol_bool_set_state() for each boolean, for a conditional
+ *  that uses several of the booleans is re-evaluated only once.
+ *  @param policy The policy with which the booleans are associated.
+ *  The state of the policy is changed by this function.
+ *  @param datums Array of boolean datums for which to set the state.
+ *  Each must be non-NULL.
+ *  @param states Array of values to which to set the state of the
+ *  corresponding boolean in datums.
+ *  @param num Number of elements in datums and states.
+ *  @return Returns 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set.
+ */
+	extern int qpol_bool_set_states(qpol_policy_t * policy, qpol_bool_t * const *datums, const int *states, size_t num);
+
 /**
  *  Set the state of a boolean but do not update the state of all conditionals
  *  using the boolean. The caller is responsible for calling
@@ -132,6 +132,22 @@ extern "C"
  */
 	extern int qpol_class_get_perm_iter(const qpol_policy_t * policy, const qpol_class_t * obj_class, qpol_iterator_t ** perms);
 
+/**
+ *  Get the integer value of one of a class's permissions, either
+ *  unique to the class or inherited from its common.  Permission
+ *  values range from 1 to 32; within an access vector, permission
+ *  value v is bit (v - 1).
+ *  @param policy The policy with which the class is associated.
+ *  @param obj_class The class whose permission to look up.
+ *  @param perm Name of the permission.
+ *  @param value Pointer to the integer to be set to the value.
+ *  @return Returns 0 on success and < 0 on failure; if the class has
+ *  no such permission then errno will be set to ENOENT.  On failure
+ *  *value will be 0.
+ */
+	extern int qpol_class_get_perm_value(const qpol_policy_t * policy, const qpol_class_t * obj_class, const char *perm,
+					     uint32_t * value);
+
 /**
  *  Get the name which identifies a class.
  *  @param policy The policy with which the class is associated.
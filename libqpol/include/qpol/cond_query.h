@@ -156,6 +156,100 @@ extern "C"
  */
 	extern int qpol_cond_eval(const qpol_policy_t * policy, const qpol_cond_t * cond, uint32_t * is_true);
 
+/**
+ *  Get an iterator over the conditionals whose expressions reference
+ *  a boolean.  The policy keeps an index from booleans to
+ *  conditionals, so this does not scan every conditional.
+ *  @param policy The policy associated with the boolean.
+ *  @param cond_bool The boolean whose conditionals to get.
+ *  @param iter Iterator over items of type qpol_cond_t returned, in
+ *  the order the conditionals appear in the policy.  The caller is
+ *  responsible for calling qpol_iterator_destroy() to free memory
+ *  used by this iterator.
+ *  It is important to note that this iterator is only valid as long as
+ *  the policy is unmodifed.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *iter will be NULL.
+ */
+	extern int qpol_bool_get_cond_iter(const qpol_policy_t * policy, const qpol_bool_t * cond_bool, qpol_iterator_t ** iter);
+
+/**
+ *  Get an iterator over the conditionals whose state would change if
+ *  the given booleans were set to the given states.  The policy is
+ *  not modified.  Only conditionals that reference a boolean whose
+ *  state would actually change are evaluated.  The result is relative
+ *  to the conditionals' current states, so if booleans were set with
+ *  qpol_bool_set_state_no_eval() then call
+ *  qpol_policy_reevaluate_conds() first.
+ *  @param policy The policy associated with the booleans.
+ *  @param datums Array of booleans to (hypothetically) set.
+ *  @param states Array of proposed states, one per boolean in datums.
+ *  @param num Number of elements in datums and states.
+ *  @param iter Iterator over items of type qpol_cond_t returned, in
+ *  the order the conditionals appear in the policy.  Use
+ *  qpol_cond_eval() for a conditional's current state; its proposed
+ *  state is the opposite.  The caller is responsible for calling
+ *  qpol_iterator_destroy() to free memory used by this iterator.
+ *  It is important to note that this iterator is only valid as long as
+ *  the policy is unmodifed.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *iter will be NULL.
+ */
+	extern int qpol_policy_get_what_if_cond_iter(const qpol_policy_t * policy, qpol_bool_t * const *datums,
+						     const int *states, size_t num, qpol_iterator_t ** iter);
+
+/**
+ *  Get iterators over the av rules that would become enabled and
+ *  disabled if the given booleans were set to the given states.  The
+ *  policy is not modified.  See qpol_policy_get_what_if_cond_iter()
+ *  for details.
+ *  @param policy The policy associated with the booleans.
+ *  @param datums Array of booleans to (hypothetically) set.
+ *  @param states Array of proposed states, one per boolean in datums.
+ *  @param num Number of elements in datums and states.
+ *  @param rule_type_mask Bitwise or'ed set of QPOL_RULE_* values
+ *  (see avrule_query.h) to include.
+ *  @param enabled Iterator over items of type qpol_avrule_t that
+ *  would become enabled.
+ *  @param disabled Iterator over items of type qpol_avrule_t that
+ *  would become disabled.
+ *  The caller is responsible for calling qpol_iterator_destroy()
+ *  on both iterators.
+ *  It is important to note that these iterators are only valid as
+ *  long as the policy is unmodifed.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *enabled and *disabled will be NULL.
+ */
+	extern int qpol_policy_get_what_if_av_iters(const qpol_policy_t * policy, qpol_bool_t * const *datums,
+						    const int *states, size_t num, uint32_t rule_type_mask,
+						    qpol_iterator_t ** enabled, qpol_iterator_t ** disabled);
+
+/**
+ *  Get iterators over the type rules that would become enabled and
+ *  disabled if the given booleans were set to the given states.  The
+ *  policy is not modified.  See qpol_policy_get_what_if_cond_iter()
+ *  for details.
+ *  @param policy The policy associated with the booleans.
+ *  @param datums Array of booleans to (hypothetically) set.
+ *  @param states Array of proposed states, one per boolean in datums.
+ *  @param num Number of elements in datums and states.
+ *  @param rule_type_mask Bitwise or'ed set of QPOL_RULE_TYPE_* values
+ *  (see terule_query.h) to include.
+ *  @param enabled Iterator over items of type qpol_terule_t that
+ *  would become enabled.
+ *  @param disabled Iterator over items of type qpol_terule_t that
+ *  would become disabled.
+ *  The caller is responsible for calling qpol_iterator_destroy()
+ *  on both iterators.
+ *  It is important to note that these iterators are only valid as
+ *  long as the policy is unmodifed.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *enabled and *disabled will be NULL.
+ */
+	extern int qpol_policy_get_what_if_te_iters(const qpol_policy_t * policy, qpol_bool_t * const *datums,
+						    const int *states, size_t num, uint32_t rule_type_mask,
+						    qpol_iterator_t ** enabled, qpol_iterator_t ** disabled);
+
 /* values identical to conditional.h in sepol */
 #define QPOL_COND_EXPR_BOOL	1      /* plain bool */
 #define QPOL_COND_EXPR_NOT	2      /* !bool */
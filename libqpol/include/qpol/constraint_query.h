@@ -223,6 +223,27 @@ extern "C"
 	extern int qpol_constraint_expr_node_get_names_iter(const qpol_policy_t * policy, const qpol_constraint_expr_node_t * expr,
 							    qpol_iterator_t ** iter);
 
+/**
+ *  Get the values of the users, roles, or types that a name test
+ *  matches, as the kernel sees them: attributes are replaced by their
+ *  types, and any '*', '~', and subtracted types have been applied.
+ *  Unlike qpol_constraint_expr_node_get_names_iter(), which returns
+ *  names as they were written, this describes what the expression
+ *  actually matches.
+ *  @param policy The policy from which the expression comes.
+ *  @param expr The expression node to query.  Must be of expression
+ *  type QPOL_CEXPR_TYPE_NAMES.
+ *  @param values Reference to an array of values, in increasing
+ *  order, allocated by this function.  The caller must call free()
+ *  afterwards.  Set to NULL if there are no values.
+ *  @param num_values Set to the number of values within the array.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set, *values will be NULL, and *num_values will be
+ *  0.
+ */
+	extern int qpol_constraint_expr_node_get_values(const qpol_policy_t * policy, const qpol_constraint_expr_node_t * expr,
+							uint32_t ** values, size_t * num_values);
+
 /**
  *  Get an iterator for the constraints on a class.
  *  @param policy The policy associated with the class.
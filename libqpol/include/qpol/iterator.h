@@ -68,6 +68,23 @@ extern "C"
  */
 	extern int qpol_iterator_next(qpol_iterator_t * iter);
 
+/**
+ *  Fetch up to max items from the iterator, advancing it past each
+ *  item fetched.  The result is the same as alternating calls to
+ *  qpol_iterator_get_item() and qpol_iterator_next(), but iterators
+ *  over rules, symbol tables and bitmaps fill the array directly from
+ *  the policy rather than dispatching once per item.  Ownership of
+ *  the returned items is as for qpol_iterator_get_item().
+ *  @param iter The iterator from which to fetch items.
+ *  @param out Array of at least max pointers into which to store the
+ *  items; the caller is responsible for safely casting each pointer.
+ *  @param max Maximum number of items to fetch.
+ *  @return Returns the number of items stored into out, which will be
+ *  0 once the iterator has reached its end, or < 0 on failure; if the
+ *  call fails, errno will be set.
+ */
+	extern int qpol_iterator_next_batch(qpol_iterator_t * iter, void **out, size_t max);
+
 /**
  *  Determine if an iterator is at the end.
  *  @param iter The iterator to check.
@@ -59,6 +59,7 @@ extern "C"
 #include <qpol/rbacrule_query.h>
 #include <qpol/ftrule_query.h>
 #include <qpol/role_query.h>
+#include <qpol/stats.h>
 #include <qpol/syn_rule_query.h>
 #include <qpol/terule_query.h>
 #include <qpol/type_query.h>
@@ -91,6 +92,16 @@ extern "C"
  */
 #define QPOL_POLICY_OPTION_MATCH_SYSTEM   0x00000004
 
+/**
+ *  After loading the policy, build a contiguous snapshot of all av
+ *  and type rules sorted by rule type, source, target, and class.
+ *  Rule iterators then walk this array instead of the avtab hash
+ *  buckets, and iterators restricted to a single source type use a
+ *  binary search.  This costs extra memory per rule; it has no
+ *  effect if QPOL_POLICY_OPTION_NO_RULES is also given.
+ */
+#define QPOL_POLICY_OPTION_SORTED_RULES   0x00000008
+
 /**
  *  List of capabilities a policy may have. This list represents
  *  features of policy that may differ from version to version or
@@ -133,6 +144,45 @@ extern "C"
 		QPOL_CAP_ROLETRANS
 	} qpol_capability_e;
 
+/**
+ *  Categories of memory reported by qpol_policy_get_memory_usage().
+ */
+	typedef enum qpol_memory_category
+	{
+		/** Symbol tables, their data, and the arrays that index them by value. */
+		QPOL_MEMORY_SYMBOLS = 0,
+		/** The unconditional access vector table. */
+		QPOL_MEMORY_AVTAB,
+		/** The conditional access vector table. */
+		QPOL_MEMORY_COND_AVTAB,
+		/** Conditional expressions and their rule lists. */
+		QPOL_MEMORY_CONDS,
+		/** Maps from types to their attributes and from attributes to their types. */
+		QPOL_MEMORY_ATTR_MAPS,
+		/** The extended image's syntactic rule table and master list. */
+		QPOL_MEMORY_SYN_RULES,
+		/** The extended image's sorted rule snapshot and conditional index. */
+		QPOL_MEMORY_RULE_INDEX,
+		/** The contents of the policy file and any saved base module image. */
+		QPOL_MEMORY_FILE_DATA,
+		/** Modules appended to the policy (symbols only). */
+		QPOL_MEMORY_MODULES,
+		QPOL_MEMORY_NUM_CATEGORIES
+	} qpol_memory_category_e;
+
+/**
+ *  Amount of memory used by one category of a policy.  Byte counts
+ *  are estimates computed from the sizes of the structures, and do
+ *  not include allocator overhead.
+ */
+	typedef struct qpol_memory_usage
+	{
+		/** number of bytes used */
+		size_t bytes;
+		/** number of objects (symbols, rules, nodes, etc.) */
+		size_t count;
+	} qpol_memory_usage_t;
+
 /**
  *  Open a policy from a passed in file path.
  *  @param filename The name of the file to open.
@@ -199,6 +249,65 @@ extern "C"
  */
 	extern int qpol_policy_reevaluate_conds(qpol_policy_t * policy);
 
+/**
+ *  Get the policy's conditional sequence number.  The number changes
+ *  whenever a conditional is re-evaluated, and thus whenever the set
+ *  of enabled conditional rules may have changed.  Callers that cache
+ *  results derived from the enabled rules may compare sequence
+ *  numbers to detect when their caches are stale.
+ *  @param policy The policy to query.
+ *  @param seqno Pointer to the integer to set to the sequence number.
+ *  @return Returns 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *seqno will be 0.
+ */
+	extern int qpol_policy_get_cond_seqno(const qpol_policy_t * policy, unsigned int *seqno);
+
+/**
+ *  Get the policy's rebuild sequence number.  The number changes
+ *  whenever qpol_policy_rebuild() replaces the policy, which frees
+ *  every type, rule, and other item previously returned by the
+ *  policy.  Callers that keep such items between calls must discard
+ *  them when the number changes.
+ *  @param policy The policy to query.
+ *  @param seqno Pointer to the integer to set to the sequence number.
+ *  @return Returns 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *seqno will be 0.
+ */
+	extern int qpol_policy_get_rebuild_seqno(const qpol_policy_t * policy, unsigned int *seqno);
+
+/**
+ *  Determine how much memory a policy uses, by walking its structures.
+ *  @param policy The policy to measure.
+ *  @param usage Array into which to write the usage of each category,
+ *  indexed by qpol_memory_category_e.
+ *  @return Returns 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and the contents of usage are undefined.
+ */
+	extern int qpol_policy_get_memory_usage(const qpol_policy_t * policy,
+						qpol_memory_usage_t usage[QPOL_MEMORY_NUM_CATEGORIES]);
+
+/**
+ *  Get a short human-readable name for a memory category.
+ *  @param category One of QPOL_MEMORY_*, other than
+ *  QPOL_MEMORY_NUM_CATEGORIES.
+ *  @return Name of the category, or NULL if the category is invalid.
+ *  The caller must not free the string.
+ */
+	extern const char *qpol_memory_category_get_name(qpol_memory_category_e category);
+
+/**
+ *  Get the object into which the policy records its phases of work.
+ *  Loading records a "load" phase, or a "rebuild" phase when
+ *  qpol_policy_rebuild() relinks a modular policy, with a nested
+ *  phase for each step of the load; libapol and others record their
+ *  queries and analyses into the same object.
+ *  @param policy The policy whose stats to get.
+ *  @return The policy's stats object, or NULL upon error.  The
+ *  caller must not destroy it; it is valid until the policy is
+ *  destroyed.
+ */
+	extern qpol_stats_t *qpol_policy_get_stats(const qpol_policy_t * policy);
+
 /**
  *  Append a module to a policy. The policy now owns the module.
  *  Note that the caller must still invoke qpol_policy_rebuild()
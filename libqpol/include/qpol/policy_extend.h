@@ -45,6 +45,27 @@ extern "C"
  */
 	extern int qpol_policy_build_syn_rule_table(qpol_policy_t * policy);
 
+/**
+ *  Build the sorted rule snapshot used by the av and type rule
+ *  iterators (see QPOL_POLICY_OPTION_SORTED_RULES).  This is done
+ *  automatically when the policy is opened with that option.
+ *  Subsequent calls to this function have no effect.
+ *  @param policy The policy for which to build the snapshot.
+ *  This policy will be modified by this call.
+ *  @return 0 on success and < 0 on error; if the call fails,
+ *  errno will be set.
+ */
+	extern int qpol_policy_build_sorted_rule_table(qpol_policy_t * policy);
+
+/**
+ *  Determine if the sorted rule snapshot has been built, either
+ *  because the policy was opened with QPOL_POLICY_OPTION_SORTED_RULES
+ *  or by qpol_policy_build_sorted_rule_table().
+ *  @param policy The policy to check.
+ *  @return 1 if the snapshot exists, 0 if not or if policy is NULL.
+ */
+	extern int qpol_policy_has_sorted_rule_table(const qpol_policy_t * policy);
+
 /* forward declarations: see avrule_query.h and terule_query.h */
 	struct qpol_avrule;
 	struct qpol_terule;
@@ -0,0 +1,224 @@
+/**
+ *  @file
+ *  Defines the public interface for recording the phases of work
+ *  done by the SETools libraries.  Each phase has a name, a start
+ *  time and duration, counts of the items it processed, and the
+ *  process's peak memory use when it ended.  Phases nest; the
+ *  counters of a finished phase are added to those of the phase that
+ *  encloses it.
+ *
+ *  Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef QPOL_STATS_H
+#define QPOL_STATS_H
+
+#ifdef	__cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdio.h>
+
+	typedef struct qpol_stats qpol_stats_t;
+
+/**
+ *  Kinds of items counted within a phase.
+ */
+	typedef enum qpol_stats_counter
+	{
+		/** Rules examined by a query or analysis. */
+		QPOL_STATS_RULES_SCANNED = 0,
+		/** Rules that satisfied a query, or results returned. */
+		QPOL_STATS_RULES_MATCHED,
+		/** Nodes of a graph expanded by a search. */
+		QPOL_STATS_NODES_EXPANDED,
+		/** Lookups answered from a cache. */
+		QPOL_STATS_CACHE_HITS,
+		/** Lookups that a cache could not answer. */
+		QPOL_STATS_CACHE_MISSES,
+		QPOL_STATS_NUM_COUNTERS
+	} qpol_stats_counter_e;
+
+/**
+ *  A finished phase.
+ */
+	typedef struct qpol_stats_phase
+	{
+		/** name of the phase, as given to qpol_stats_begin() */
+		const char *name;
+		/** number of phases that enclosed this one; 0 for an
+		 *  outermost phase */
+		size_t depth;
+		/** milliseconds from the creation of the stats object to
+		 *  the start of the phase */
+		double start_ms;
+		/** milliseconds from the start to the end of the phase */
+		double elapsed_ms;
+		/** items counted during the phase, including those of
+		 *  phases nested within it */
+		size_t counters[QPOL_STATS_NUM_COUNTERS];
+		/** peak resident set size of the process, in kilobytes,
+		 *  at the end of the phase, or -1 if unknown */
+		long peak_rss_kb;
+		/** growth of the peak resident set size during the
+		 *  phase, in kilobytes */
+		long peak_rss_growth_kb;
+	} qpol_stats_phase_t;
+
+/**
+ *  Function called each time a phase ends.
+ *  @param varg Value given to qpol_stats_set_callback().
+ *  @param phase The phase that ended.  It is only valid for the
+ *  duration of the call.
+ */
+	typedef void (*qpol_stats_fn_t) (void *varg, const qpol_stats_phase_t * phase);
+
+/**
+ *  Allocate an empty stats object.  Times of phases are measured from
+ *  this call.  Only the calling thread records phases and counts into
+ *  the object; qpol_stats_begin(), qpol_stats_end() and
+ *  qpol_stats_add() called by other threads do nothing, so that
+ *  analyses run in parallel do not interleave their phases.
+ *  @return A new stats object, or NULL upon error; if the call fails,
+ *  errno will be set.  The caller must call qpol_stats_destroy()
+ *  afterwards.
+ */
+	extern qpol_stats_t *qpol_stats_create(void);
+
+/**
+ *  Free a stats object.  Phases still open are discarded without
+ *  calling the callback.
+ *  @param stats Reference to the stats object to destroy.  The
+ *  pointer will be set to NULL afterwards.  Does nothing if the
+ *  pointer is NULL.
+ */
+	extern void qpol_stats_destroy(qpol_stats_t ** stats);
+
+/**
+ *  Set the function to be called each time a phase ends.
+ *  @param stats Stats object to modify.
+ *  @param fn Function to call, or NULL to stop calling one.
+ *  @param varg Arbitrary value passed to fn.
+ */
+	extern void qpol_stats_set_callback(qpol_stats_t * stats, qpol_stats_fn_t fn, void *varg);
+
+/**
+ *  Begin a phase nested within the innermost open phase, if any.
+ *  Every successful call must be followed by a call to
+ *  qpol_stats_end() or qpol_stats_end_to().
+ *  @param stats Stats object to modify.  If NULL, do nothing.
+ *  @param name Name of the phase.  The string is not copied, so it
+ *  must outlive the stats object; string literals are expected.
+ *  @return 0 on success, < 0 on error; if the call fails, errno will
+ *  be set.  Phases may be nested at most 16 deep.
+ */
+	extern int qpol_stats_begin(qpol_stats_t * stats, const char *name);
+
+/**
+ *  End the innermost open phase.  It is appended to the list of
+ *  finished phases, its counters are added to the enclosing phase,
+ *  and the callback, if any, is called.
+ *  @param stats Stats object to modify.  If NULL, do nothing.
+ */
+	extern void qpol_stats_end(qpol_stats_t * stats);
+
+/**
+ *  End open phases, innermost first, until only depth of them remain.
+ *  Used to end every phase begun since qpol_stats_get_depth()
+ *  returned depth, such as upon an error.
+ *  @param stats Stats object to modify.  If NULL, do nothing.
+ *  @param depth Number of phases to leave open.
+ */
+	extern void qpol_stats_end_to(qpol_stats_t * stats, size_t depth);
+
+/**
+ *  Get the number of phases currently open.
+ *  @param stats Stats object to query.
+ *  @return Number of open phases, or 0 if stats is NULL.
+ */
+	extern size_t qpol_stats_get_depth(const qpol_stats_t * stats);
+
+/**
+ *  Add to a counter of the innermost open phase.  Counts made while
+ *  no phase is open are only added to the totals.
+ *  @param stats Stats object to modify.  If NULL, do nothing.
+ *  @param counter Counter to increase.
+ *  @param n Amount to add.
+ */
+	extern void qpol_stats_add(qpol_stats_t * stats, qpol_stats_counter_e counter, size_t n);
+
+/**
+ *  Get the sum of all counts made into a stats object since it was
+ *  created or last cleared.
+ *  @param stats Stats object to query.
+ *  @param counter Counter to get.
+ *  @return The total, or 0 if stats is NULL.
+ */
+	extern size_t qpol_stats_get_total(const qpol_stats_t * stats, qpol_stats_counter_e counter);
+
+/**
+ *  Get the number of finished phases kept by a stats object.  Only
+ *  the most recent 1024 phases are kept.
+ *  @param stats Stats object to query.
+ *  @return Number of phases, or 0 if stats is NULL.
+ */
+	extern size_t qpol_stats_get_num_phases(const qpol_stats_t * stats);
+
+/**
+ *  Get a finished phase, in the order in which they ended; a phase
+ *  therefore follows the phases nested within it.
+ *  @param stats Stats object to query.
+ *  @param i Index of the phase, less than
+ *  qpol_stats_get_num_phases().
+ *  @return The phase, or NULL upon error.  The pointer is valid until
+ *  the next change to the stats object.
+ */
+	extern const qpol_stats_phase_t *qpol_stats_get_phase(const qpol_stats_t * stats, size_t i);
+
+/**
+ *  Discard all finished phases and zero the totals.  Open phases are
+ *  left open.
+ *  @param stats Stats object to modify.  If NULL, do nothing.
+ */
+	extern void qpol_stats_clear(qpol_stats_t * stats);
+
+/**
+ *  Get a short name for a counter, suitable as a column heading.
+ *  @param counter Counter whose name to get.
+ *  @return Name of the counter, or NULL if it is not valid.
+ */
+	extern const char *qpol_stats_counter_get_name(qpol_stats_counter_e counter);
+
+/**
+ *  Write the finished phases of a stats object as a table, one phase
+ *  per line and each enclosing phase before the phases nested within
+ *  it, followed by the totals.
+ *  @param stats Stats object to write.
+ *  @param title Text to write above the table, or NULL for none.
+ *  @param fp File to which to write.
+ *  @return 0 on success, < 0 on error; if the call fails, errno will
+ *  be set.
+ */
+	extern int qpol_stats_print(const qpol_stats_t * stats, const char *title, FILE * fp);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -58,6 +58,27 @@ extern "C"
  */
 	extern int qpol_policy_get_terule_iter(const qpol_policy_t * policy, uint32_t rule_type_mask, qpol_iterator_t ** iter);
 
+/**
+ *  Get an iterator over the type rules in a policy of a rule type in
+ *  rule_type_mask whose source is exactly the given type.  Attributes
+ *  containing the type are not expanded; callers wanting those rules
+ *  must request each attribute separately.  If the policy was loaded
+ *  with QPOL_POLICY_OPTION_SORTED_RULES this is a binary search;
+ *  otherwise the entire rule table is scanned.
+ *  @param policy Policy from which to get the type rules.
+ *  @param rule_type_mask Bitwise or'ed set of QPOL_RULE_TYPE_* values.
+ *  @param source Source type of the rules to return.
+ *  @param iter Iterator over items of type qpol_terule_t returned.
+ *  The caller is responsible for calling qpol_iterator_destroy()
+ *  to free memory used by this iterator.
+ *  It is important to note that this iterator is only valid as long as
+ *  the policy is unmodifed.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *iter will be NULL.
+ */
+	extern int qpol_policy_get_terule_iter_by_source(const qpol_policy_t * policy, uint32_t rule_type_mask,
+						   const qpol_type_t * source, qpol_iterator_t ** iter);
+
 /**
  *  Get the source type from a type rule.
  *  @param policy Policy from which the rule comes.
@@ -33,10 +33,23 @@
 #include <stdlib.h>
 #include "qpol_internal.h"
 
-int qpol_policy_get_avrule_iter(const qpol_policy_t * policy, uint32_t rule_type_mask, qpol_iterator_t ** iter)
+/**
+ *  Create an iterator over the avrules of the given types, optionally
+ *  restricted to a single source type.  Uses the sorted rule snapshot
+ *  if the policy has one and walks the avtab otherwise.
+ *  @param policy Policy from which to get the rules.
+ *  @param rule_type_mask Bitwise or'ed set of rule types to return.
+ *  @param source_val If non-zero, only return rules with this source
+ *  type value.
+ *  @param iter Iterator over the rules returned.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *iter will be NULL.
+ */
+static int avrule_iter_create(const qpol_policy_t * policy, uint32_t rule_type_mask, uint32_t source_val, qpol_iterator_t ** iter)
 {
 	policydb_t *db;
 	avtab_state_t *state;
+	int retv;
 
 	if (iter) {
 		*iter = NULL;
@@ -61,6 +74,10 @@ int qpol_policy_get_avrule_iter(const qpol_policy_t * policy, uint32_t rule_type
 		return STATUS_ERR;
 	}
 
+	retv = qpol_policy_get_sorted_rule_iter(policy, rule_type_mask, source_val, iter);
+	if (retv != STATUS_NODATA)
+		return retv;
+
 	db = &policy->p->p;
 
 	state = calloc(1, sizeof(avtab_state_t));
@@ -72,6 +89,7 @@ int qpol_policy_get_avrule_iter(const qpol_policy_t * policy, uint32_t rule_type
 	state->ucond_tab = &db->te_avtab;
 	state->cond_tab = &db->te_cond_avtab;
 	state->rule_type_mask = rule_type_mask;
+	state->source_val = source_val;
 	state->node = db->te_avtab.htable[0];
 
 	if (qpol_iterator_create
@@ -79,12 +97,37 @@ int qpol_policy_get_avrule_iter(const qpol_policy_t * policy, uint32_t rule_type
 		free(state);
 		return STATUS_ERR;
 	}
-	if (state->node == NULL || !(state->node->key.specified & state->rule_type_mask)) {
+	if (state->node == NULL || !avtab_state_match(state, state->node)) {
 		avtab_state_next(*iter);
 	}
 	return STATUS_SUCCESS;
 }
 
+int qpol_policy_get_avrule_iter(const qpol_policy_t * policy, uint32_t rule_type_mask, qpol_iterator_t ** iter)
+{
+	return avrule_iter_create(policy, rule_type_mask, 0, iter);
+}
+
+int qpol_policy_get_avrule_iter_by_source(const qpol_policy_t * policy, uint32_t rule_type_mask, const qpol_type_t * source,
+					  qpol_iterator_t ** iter)
+{
+	uint32_t source_val;
+
+	if (iter) {
+		*iter = NULL;
+	}
+	if (policy == NULL || source == NULL || iter == NULL) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	if (qpol_type_get_value(policy, source, &source_val) < 0) {
+		return STATUS_ERR;
+	}
+	return avrule_iter_create(policy, rule_type_mask, source_val, iter);
+}
+
 int qpol_avrule_get_source_type(const qpol_policy_t * policy, const qpol_avrule_t * rule, const qpol_type_t ** source)
 {
 	policydb_t *db = NULL;
@@ -286,3 +329,109 @@ int qpol_avrule_get_which_list(const qpol_policy_t * policy, const qpol_avrule_t
 
 	return STATUS_SUCCESS;
 }
+
+/**
+ * Accumulate the access vectors of all enabled av rules with exactly
+ * the given key.
+ */
+static void avrule_compute_key(const policydb_t * db, avtab_key_t * key, uint32_t * allowed, uint32_t * auditallow,
+			       uint32_t * auditdeny)
+{
+	avtab_ptr_t node;
+	int i;
+	for (i = 0; i < 2; i++) {
+		avtab_t *tab = (avtab_t *) (i == 0 ? &db->te_avtab : &db->te_cond_avtab);
+		for (node = avtab_search_node(tab, key); node != NULL; node = avtab_search_node_next(node, key->specified)) {
+			if (i == 1 && !(node->merged & QPOL_COND_RULE_ENABLED)) {
+				continue;
+			}
+			if (node->key.specified & AVTAB_ALLOWED) {
+				*allowed |= node->datum.data;
+			} else if (node->key.specified & AVTAB_AUDITALLOW) {
+				*auditallow |= node->datum.data;
+			} else if (node->key.specified & AVTAB_AUDITDENY) {
+				*auditdeny &= node->datum.data;
+			}
+		}
+	}
+}
+
+/**
+ * Accumulate the access vectors for a source type or attribute (as
+ * already set in the key) upon a target type and each attribute
+ * containing the target type.
+ */
+static void avrule_compute_targets(const policydb_t * db, avtab_key_t * key, uint32_t target_val, uint32_t * allowed,
+				   uint32_t * auditallow, uint32_t * auditdeny)
+{
+	const type_datum_t *target = db->type_val_to_struct[target_val - 1];
+	ebitmap_node_t *node;
+	uint32_t bit;
+	key->target_type = target_val;
+	avrule_compute_key(db, key, allowed, auditallow, auditdeny);
+	ebitmap_for_each_bit(&target->types, node, bit) {
+		if (ebitmap_node_get_bit(node, bit) && bit + 1 != target_val) {
+			key->target_type = bit + 1;
+			avrule_compute_key(db, key, allowed, auditallow, auditdeny);
+		}
+	}
+}
+
+/**
+ * Compute the access vectors for a source and target type value and
+ * class value, applying the source type's bounds.
+ */
+static void avrule_compute_te(const policydb_t * db, uint32_t source_val, uint32_t target_val, uint32_t class_val,
+			      uint32_t * allowed, uint32_t * auditallow, uint32_t * auditdeny)
+{
+	const type_datum_t *source = db->type_val_to_struct[source_val - 1];
+	const type_datum_t *target = db->type_val_to_struct[target_val - 1];
+	ebitmap_node_t *node;
+	avtab_key_t key;
+	uint32_t bit;
+
+	*allowed = *auditallow = 0;
+	*auditdeny = ~0U;
+	key.target_class = class_val;
+	key.specified = AVTAB_AV;
+	key.source_type = source_val;
+	avrule_compute_targets(db, &key, target_val, allowed, auditallow, auditdeny);
+	ebitmap_for_each_bit(&source->types, node, bit) {
+		if (ebitmap_node_get_bit(node, bit) && bit + 1 != source_val) {
+			key.source_type = bit + 1;
+			avrule_compute_targets(db, &key, target_val, allowed, auditallow, auditdeny);
+		}
+	}
+
+	if (source->flavor == TYPE_TYPE && source->bounds != 0) {
+		uint32_t bounded_allowed, bounded_auditallow, bounded_auditdeny;
+		uint32_t bounded_target = (target->flavor == TYPE_TYPE && target->bounds != 0 ? target->bounds : target_val);
+		avrule_compute_te(db, source->bounds, bounded_target, class_val, &bounded_allowed, &bounded_auditallow,
+				  &bounded_auditdeny);
+		*allowed &= bounded_allowed;
+	}
+}
+
+int qpol_policy_compute_av(const qpol_policy_t * policy, const qpol_type_t * source, const qpol_type_t * target,
+			   const qpol_class_t * obj_class, uint32_t * allowed, uint32_t * auditallow, uint32_t * auditdeny)
+{
+	uint32_t source_val, target_val, class_val;
+
+	if (policy == NULL || source == NULL || target == NULL || obj_class == NULL || allowed == NULL || auditallow == NULL ||
+	    auditdeny == NULL) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+	if (!qpol_policy_has_capability(policy, QPOL_CAP_RULES_LOADED)) {
+		ERR(policy, "%s", "Cannot compute access vectors: Rules not loaded");
+		errno = ENOTSUP;
+		return STATUS_ERR;
+	}
+	if (qpol_type_get_value(policy, source, &source_val) < 0 || qpol_type_get_value(policy, target, &target_val) < 0 ||
+	    qpol_class_get_value(policy, obj_class, &class_val) < 0) {
+		return STATUS_ERR;
+	}
+	avrule_compute_te(&policy->p->p, source_val, target_val, class_val, allowed, auditallow, auditdeny);
+	return STATUS_SUCCESS;
+}
@@ -134,9 +134,41 @@ int qpol_bool_get_state(const qpol_policy_t * policy, const qpol_bool_t * datum,
 	return STATUS_SUCCESS;
 }
 
+/**
+ *  Re-evaluate the conditionals that reference any of the given
+ *  booleans, updating the state of their rules.  If the policy has
+ *  no boolean index then re-evaluate every conditional.
+ *  @param policy Policy whose conditionals to update.
+ *  @param bool_vals Array of values of the booleans that changed.
+ *  @param num_vals Number of elements in bool_vals.
+ *  @return 0 on success, < 0 on failure; if the call fails, errno
+ *  will be set.
+ */
+static int bool_reevaluate_conds(qpol_policy_t * policy, const uint32_t * bool_vals, size_t num_vals)
+{
+	cond_node_t **conds = NULL;
+	size_t num_conds = 0, i;
+	int retv;
+
+	retv = qpol_policy_get_bool_conds(policy, bool_vals, num_vals, &conds, &num_conds);
+	if (retv == STATUS_NODATA)
+		return qpol_policy_reevaluate_conds(policy);
+	if (retv < 0)
+		return STATUS_ERR;     /* errno already set */
+	for (i = 0; i < num_conds; i++) {
+		if (qpol_policy_reevaluate_cond(policy, conds[i])) {
+			free(conds);
+			return STATUS_ERR;	/* errno already set */
+		}
+	}
+	free(conds);
+	return STATUS_SUCCESS;
+}
+
 int qpol_bool_set_state(qpol_policy_t * policy, qpol_bool_t * datum, int state)
 {
 	cond_bool_datum_t *internal_datum;
+	uint32_t value;
 
 	if (policy == NULL || datum == NULL) {
 		ERR(policy, "%s", strerror(EINVAL));
@@ -146,15 +178,57 @@ int qpol_bool_set_state(qpol_policy_t * policy, qpol_bool_t * datum, int state)
 
 	internal_datum = (cond_bool_datum_t *) datum;
 	internal_datum->state = state;
+	value = internal_datum->s.value;
 
 	/* re-evaluate conditionals to update the state of their rules */
-	if (qpol_policy_reevaluate_conds(policy)) {
+	if (bool_reevaluate_conds(policy, &value, 1)) {
 		return STATUS_ERR;     /* errno already set */
 	}
 
 	return STATUS_SUCCESS;
 }
 
+int qpol_bool_set_states(qpol_policy_t * policy, qpol_bool_t * const *datums, const int *states, size_t num)
+{
+	cond_bool_datum_t *internal_datum;
+	uint32_t *values = NULL;
+	size_t i;
+	int error, retv;
+
+	if (policy == NULL || (num && (datums == NULL || states == NULL))) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+	for (i = 0; i < num; i++) {
+		if (datums[i] == NULL) {
+			ERR(policy, "%s", strerror(EINVAL));
+			errno = EINVAL;
+			return STATUS_ERR;
+		}
+	}
+
+	if (!(values = malloc((num ? num : 1) * sizeof(*values)))) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return STATUS_ERR;
+	}
+	for (i = 0; i < num; i++) {
+		internal_datum = (cond_bool_datum_t *) datums[i];
+		internal_datum->state = states[i];
+		values[i] = internal_datum->s.value;
+	}
+
+	/* each affected conditional is re-evaluated only once, no
+	 * matter how many of its booleans changed */
+	retv = bool_reevaluate_conds(policy, values, num);
+	error = errno;
+	free(values);
+	errno = error;
+	return retv;
+}
+
 int qpol_bool_set_state_no_eval(qpol_policy_t * policy, qpol_bool_t * datum, int state)
 {
 	cond_bool_datum_t *internal_datum;
@@ -443,6 +443,34 @@ int qpol_class_get_common(const qpol_policy_t * policy, const qpol_class_t * obj
 	return STATUS_SUCCESS;
 }
 
+int qpol_class_get_perm_value(const qpol_policy_t * policy, const qpol_class_t * obj_class, const char *perm, uint32_t * value)
+{
+	class_datum_t *internal_datum = NULL;
+	perm_datum_t *perm_datum = NULL;
+
+	if (value != NULL)
+		*value = 0;
+	if (policy == NULL || obj_class == NULL || perm == NULL || value == NULL) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	internal_datum = (class_datum_t *) obj_class;
+	perm_datum = (perm_datum_t *) hashtab_search(internal_datum->permissions.table, (const hashtab_key_t) perm);
+	if (perm_datum == NULL && internal_datum->comdatum != NULL) {
+		perm_datum =
+			(perm_datum_t *) hashtab_search(internal_datum->comdatum->permissions.table, (const hashtab_key_t) perm);
+	}
+	if (perm_datum == NULL) {
+		errno = ENOENT;
+		return STATUS_ERR;
+	}
+	*value = perm_datum->s.value;
+
+	return STATUS_SUCCESS;
+}
+
 int qpol_class_get_perm_iter(const qpol_policy_t * policy, const qpol_class_t * obj_class, qpol_iterator_t ** perms)
 {
 	class_datum_t *internal_datum = NULL;
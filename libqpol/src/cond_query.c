@@ -618,3 +618,558 @@ int qpol_cond_expr_node_get_bool(const qpol_policy_t * policy, const qpol_cond_e
 	errno = error;
 	return STATUS_ERR;
 }
+
+typedef struct cond_array_state
+{
+	cond_node_t **conds;
+	size_t num;
+	size_t cur;
+} cond_array_state_t;
+
+static int cond_array_state_end(const qpol_iterator_t * iter)
+{
+	cond_array_state_t *cas = NULL;
+
+	if (!iter || !(cas = (cond_array_state_t *) qpol_iterator_state(iter))) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	return cas->cur >= cas->num ? 1 : 0;
+}
+
+static void *cond_array_state_get_cur(const qpol_iterator_t * iter)
+{
+	cond_array_state_t *cas = NULL;
+
+	if (!iter || !(cas = (cond_array_state_t *) qpol_iterator_state(iter)) || qpol_iterator_end(iter)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	return cas->conds[cas->cur];
+}
+
+static int cond_array_state_next(qpol_iterator_t * iter)
+{
+	cond_array_state_t *cas = NULL;
+
+	if (!iter || !(cas = (cond_array_state_t *) qpol_iterator_state(iter))) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	if (qpol_iterator_end(iter)) {
+		errno = ERANGE;
+		return STATUS_ERR;
+	}
+
+	cas->cur++;
+
+	return STATUS_SUCCESS;
+}
+
+static size_t cond_array_state_size(const qpol_iterator_t * iter)
+{
+	cond_array_state_t *cas = NULL;
+
+	if (!iter || !(cas = (cond_array_state_t *) qpol_iterator_state(iter))) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	return cas->num;
+}
+
+static void cond_array_state_free(void *state)
+{
+	cond_array_state_t *cas = (cond_array_state_t *) state;
+
+	if (!cas)
+		return;
+	free(cas->conds);
+	free(cas);
+}
+
+/**
+ *  Create an iterator over an array of conditionals.
+ *  @param policy Policy associated with the conditionals.
+ *  @param conds Array of conditionals.  The iterator takes ownership
+ *  of the array, even upon failure.
+ *  @param num Number of elements in conds.
+ *  @param iter Iterator over items of type qpol_cond_t returned.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *iter will be NULL.
+ */
+static int cond_array_iter_create(const qpol_policy_t * policy, cond_node_t ** conds, size_t num, qpol_iterator_t ** iter)
+{
+	cond_array_state_t *cas = NULL;
+	int error = 0;
+
+	if (!(cas = calloc(1, sizeof(cond_array_state_t)))) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		free(conds);
+		errno = error;
+		return STATUS_ERR;
+	}
+	cas->conds = conds;
+	cas->num = num;
+
+	if (qpol_iterator_create(policy, (void *)cas,
+				 cond_array_state_get_cur, cond_array_state_next, cond_array_state_end,
+				 cond_array_state_size, cond_array_state_free, iter)) {
+		error = errno;
+		cond_array_state_free(cas);
+		errno = error;
+		return STATUS_ERR;
+	}
+
+	return STATUS_SUCCESS;
+}
+
+/**
+ *  Get every conditional in the policy, in policy order.  Used when
+ *  the policy has no boolean index.
+ */
+static int cond_get_all(const qpol_policy_t * policy, cond_node_t *** conds, size_t * num)
+{
+	cond_node_t *cond;
+	size_t n = 0;
+	int error;
+
+	for (cond = policy->p->p.cond_list; cond; cond = cond->next)
+		n++;
+	if (!(*conds = malloc((n ? n : 1) * sizeof(**conds)))) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return STATUS_ERR;
+	}
+	*num = 0;
+	for (cond = policy->p->p.cond_list; cond; cond = cond->next)
+		(*conds)[(*num)++] = cond;
+	return STATUS_SUCCESS;
+}
+
+int qpol_bool_get_cond_iter(const qpol_policy_t * policy, const qpol_bool_t * cond_bool, qpol_iterator_t ** iter)
+{
+	cond_node_t **conds = NULL, **refs = NULL;
+	cond_expr_t *expr;
+	size_t num = 0, num_refs = 0, i;
+	uint32_t value;
+	int retv, error;
+
+	if (iter)
+		*iter = NULL;
+
+	if (!policy || !cond_bool || !iter) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	value = ((const cond_bool_datum_t *)cond_bool)->s.value;
+	retv = qpol_policy_get_bool_conds(policy, &value, 1, &conds, &num);
+	if (retv < 0)
+		return STATUS_ERR;     /* errno already set */
+	if (retv == STATUS_NODATA) {
+		/* no index, so scan every expression */
+		if (cond_get_all(policy, &refs, &num_refs))
+			return STATUS_ERR;	/* errno already set */
+		for (i = 0; i < num_refs; i++) {
+			for (expr = refs[i]->expr; expr; expr = expr->next) {
+				if (expr->expr_type == COND_BOOL && expr->bool == value) {
+					refs[num++] = refs[i];
+					break;
+				}
+			}
+		}
+		conds = refs;
+	}
+
+	if (cond_array_iter_create(policy, conds, num, iter)) {
+		error = errno;
+		*iter = NULL;
+		errno = error;
+		return STATUS_ERR;
+	}
+
+	return STATUS_SUCCESS;
+}
+
+/**
+ *  Evaluate a conditional expression using the given boolean states
+ *  rather than those within the policy.
+ *  @param expr Expression to evaluate.
+ *  @param states Array of boolean states, indexed by boolean value
+ *  minus one.
+ *  @param num_states Number of elements in states.
+ *  @return 0 or 1 for the result of the expression, or < 0 if the
+ *  expression is malformed.
+ */
+static int cond_what_if_eval(const cond_expr_t * expr, const unsigned char *states, size_t num_states)
+{
+	int stack[COND_EXPR_MAXDEPTH];
+	int sp = -1;
+
+	for (; expr; expr = expr->next) {
+		switch (expr->expr_type) {
+		case COND_BOOL:
+			if (sp == COND_EXPR_MAXDEPTH - 1 || expr->bool < 1 || expr->bool > num_states)
+				return -1;
+			stack[++sp] = states[expr->bool - 1];
+			break;
+		case COND_NOT:
+			if (sp < 0)
+				return -1;
+			stack[sp] = !stack[sp];
+			break;
+		case COND_OR:
+			if (sp < 1)
+				return -1;
+			sp--;
+			stack[sp] |= stack[sp + 1];
+			break;
+		case COND_AND:
+			if (sp < 1)
+				return -1;
+			sp--;
+			stack[sp] &= stack[sp + 1];
+			break;
+		case COND_XOR:
+			if (sp < 1)
+				return -1;
+			sp--;
+			stack[sp] ^= stack[sp + 1];
+			break;
+		case COND_EQ:
+			if (sp < 1)
+				return -1;
+			sp--;
+			stack[sp] = (stack[sp] == stack[sp + 1]);
+			break;
+		case COND_NEQ:
+			if (sp < 1)
+				return -1;
+			sp--;
+			stack[sp] = (stack[sp] != stack[sp + 1]);
+			break;
+		default:
+			return -1;
+		}
+	}
+	return (sp == 0 ? stack[0] : -1);
+}
+
+/**
+ *  Find the conditionals whose state would change if the given
+ *  booleans were set, without modifying the policy.  Only those
+ *  conditionals that reference a boolean whose state would actually
+ *  change are evaluated.
+ *  @param policy Policy to examine.
+ *  @param datums Array of booleans to set.
+ *  @param states Proposed states for each boolean in datums.
+ *  @param num Number of elements in datums and states.
+ *  @param flipped Reference to a newly allocated array of
+ *  conditionals whose state would change, in policy order.  The
+ *  caller must free() the array.
+ *  @param num_flipped Number of elements in *flipped.
+ *  @return 0 on success and < 0 on failure; if the call fails, errno
+ *  will be set.
+ */
+static int cond_what_if(const qpol_policy_t * policy, qpol_bool_t * const *datums, const int *states, size_t num,
+			cond_node_t *** flipped, size_t * num_flipped)
+{
+	const policydb_t *db = &policy->p->p;
+	const cond_bool_datum_t *datum;
+	unsigned char *proposed = NULL;
+	uint32_t *changed = NULL;
+	cond_node_t **conds = NULL;
+	size_t num_bools = db->p_bools.nprim, num_changed = 0, num_conds = 0, i, j;
+	int retv, state, error = 0;
+
+	*flipped = NULL;
+	*num_flipped = 0;
+
+	if (num && (!datums || !states)) {
+		error = EINVAL;
+		goto err;
+	}
+	if (!(proposed = malloc(num_bools ? num_bools : 1)) || !(changed = malloc((num ? num : 1) * sizeof(*changed)))) {
+		error = errno;
+		goto err;
+	}
+	for (i = 0; i < num_bools; i++)
+		proposed[i] = (db->bool_val_to_struct[i]->state ? 1 : 0);
+	for (i = 0; i < num; i++) {
+		if (!(datum = (const cond_bool_datum_t *)datums[i]) || datum->s.value < 1 || datum->s.value > num_bools) {
+			error = EINVAL;
+			goto err;
+		}
+		/* a boolean that keeps its state cannot flip anything */
+		if (proposed[datum->s.value - 1] != (states[i] ? 1 : 0)) {
+			proposed[datum->s.value - 1] = (states[i] ? 1 : 0);
+			changed[num_changed++] = datum->s.value;
+		}
+	}
+
+	retv = qpol_policy_get_bool_conds(policy, changed, num_changed, &conds, &num_conds);
+	if (retv < 0) {
+		error = errno;
+		goto err;
+	}
+	if (retv == STATUS_NODATA && num_changed > 0 && cond_get_all(policy, &conds, &num_conds)) {
+		error = errno;
+		goto err;
+	}
+
+	for (i = 0, j = 0; i < num_conds; i++) {
+		if ((state = cond_what_if_eval(conds[i]->expr, proposed, num_bools)) < 0) {
+			error = EILSEQ;
+			goto err;
+		}
+		if (state != (conds[i]->cur_state ? 1 : 0))
+			conds[j++] = conds[i];
+	}
+	*flipped = conds;
+	*num_flipped = j;
+	free(proposed);
+	free(changed);
+	return STATUS_SUCCESS;
+
+      err:
+	ERR(policy, "%s", strerror(error));
+	free(proposed);
+	free(changed);
+	free(conds);
+	errno = error;
+	return STATUS_ERR;
+}
+
+int qpol_policy_get_what_if_cond_iter(const qpol_policy_t * policy, qpol_bool_t * const *datums, const int *states, size_t num,
+				      qpol_iterator_t ** iter)
+{
+	cond_node_t **flipped = NULL;
+	size_t num_flipped = 0;
+	int error;
+
+	if (iter)
+		*iter = NULL;
+
+	if (!policy || !iter) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	if (cond_what_if(policy, datums, states, num, &flipped, &num_flipped))
+		return STATUS_ERR;     /* errno already set */
+
+	if (cond_array_iter_create(policy, flipped, num_flipped, iter)) {
+		error = errno;
+		*iter = NULL;
+		errno = error;
+		return STATUS_ERR;
+	}
+
+	return STATUS_SUCCESS;
+}
+
+/* iterates over the rules of several conditionals' rule lists, one
+ * list per conditional */
+typedef struct cond_lists_state
+{
+	cond_av_list_t **lists;
+	size_t num_lists;
+	size_t list;
+	cond_av_list_t *cur;
+	uint32_t rule_type_mask;
+} cond_lists_state_t;
+
+/**
+ *  Advance to the next rule, starting with cls->cur itself, that
+ *  matches the rule type mask, moving on to the following lists as
+ *  needed.
+ */
+static void cond_lists_state_seek(cond_lists_state_t * cls)
+{
+	while (1) {
+		for (; cls->cur; cls->cur = cls->cur->next) {
+			if (cls->cur->node->key.specified & cls->rule_type_mask)
+				return;
+		}
+		if (++cls->list >= cls->num_lists)
+			return;
+		cls->cur = cls->lists[cls->list];
+	}
+}
+
+static int cond_lists_state_end(const qpol_iterator_t * iter)
+{
+	cond_lists_state_t *cls = NULL;
+
+	if (!iter || !(cls = (cond_lists_state_t *) qpol_iterator_state(iter))) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	return cls->cur ? 0 : 1;
+}
+
+static void *cond_lists_state_get_cur(const qpol_iterator_t * iter)
+{
+	cond_lists_state_t *cls = NULL;
+
+	if (!iter || !(cls = (cond_lists_state_t *) qpol_iterator_state(iter)) || qpol_iterator_end(iter)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	return cls->cur->node;
+}
+
+static int cond_lists_state_next(qpol_iterator_t * iter)
+{
+	cond_lists_state_t *cls = NULL;
+
+	if (!iter || !(cls = (cond_lists_state_t *) qpol_iterator_state(iter))) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	if (qpol_iterator_end(iter)) {
+		errno = ERANGE;
+		return STATUS_ERR;
+	}
+
+	cls->cur = cls->cur->next;
+	cond_lists_state_seek(cls);
+
+	return STATUS_SUCCESS;
+}
+
+static size_t cond_lists_state_size(const qpol_iterator_t * iter)
+{
+	cond_lists_state_t *cls = NULL;
+	cond_av_list_t *tmp = NULL;
+	size_t count = 0, i;
+
+	if (!iter || !(cls = (cond_lists_state_t *) qpol_iterator_state(iter))) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	for (i = 0; i < cls->num_lists; i++) {
+		for (tmp = cls->lists[i]; tmp; tmp = tmp->next) {
+			if (tmp->node->key.specified & cls->rule_type_mask)
+				count++;
+		}
+	}
+
+	return count;
+}
+
+static void cond_lists_state_free(void *state)
+{
+	cond_lists_state_t *cls = (cond_lists_state_t *) state;
+
+	if (!cls)
+		return;
+	free(cls->lists);
+	free(cls);
+}
+
+/**
+ *  Get iterators over the rules that would become enabled and
+ *  disabled if the given booleans were set.  This implements both
+ *  qpol_policy_get_what_if_av_iters() and
+ *  qpol_policy_get_what_if_te_iters().
+ *  @param valid_mask Rule types that may appear in rule_type_mask.
+ */
+static int cond_what_if_rules(const qpol_policy_t * policy, qpol_bool_t * const *datums, const int *states, size_t num,
+			      uint32_t rule_type_mask, uint32_t valid_mask, qpol_iterator_t ** enabled,
+			      qpol_iterator_t ** disabled)
+{
+	cond_node_t **flipped = NULL;
+	cond_lists_state_t *cls[2] = { NULL, NULL };
+	qpol_iterator_t **iters[2];
+	size_t num_flipped = 0, i;
+	int k, new_state, error = 0;
+
+	iters[0] = enabled;
+	iters[1] = disabled;
+	if (enabled)
+		*enabled = NULL;
+	if (disabled)
+		*disabled = NULL;
+
+	if (!policy || !enabled || !disabled || (rule_type_mask & ~valid_mask)) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	if (cond_what_if(policy, datums, states, num, &flipped, &num_flipped))
+		return STATUS_ERR;     /* errno already set */
+
+	for (k = 0; k < 2; k++) {
+		if (!(cls[k] = calloc(1, sizeof(cond_lists_state_t))) ||
+		    !(cls[k]->lists = malloc((num_flipped ? num_flipped : 1) * sizeof(cond_av_list_t *)))) {
+			error = errno;
+			ERR(policy, "%s", strerror(error));
+			goto err;
+		}
+		cls[k]->num_lists = num_flipped;
+		cls[k]->rule_type_mask = rule_type_mask;
+	}
+	/* a conditional that becomes true enables its true list and
+	 * disables its false list, and vice versa */
+	for (i = 0; i < num_flipped; i++) {
+		new_state = !flipped[i]->cur_state;
+		cls[0]->lists[i] = (new_state ? flipped[i]->true_list : flipped[i]->false_list);
+		cls[1]->lists[i] = (new_state ? flipped[i]->false_list : flipped[i]->true_list);
+	}
+	free(flipped);
+	flipped = NULL;
+
+	for (k = 0; k < 2; k++) {
+		if (num_flipped > 0) {
+			cls[k]->cur = cls[k]->lists[0];
+			cond_lists_state_seek(cls[k]);
+		}
+		if (qpol_iterator_create(policy, (void *)cls[k],
+					 cond_lists_state_get_cur, cond_lists_state_next, cond_lists_state_end,
+					 cond_lists_state_size, cond_lists_state_free, iters[k])) {
+			error = errno;
+			goto err;
+		}
+		cls[k] = NULL;	       /* now owned by the iterator */
+	}
+
+	return STATUS_SUCCESS;
+
+      err:
+	free(flipped);
+	for (k = 0; k < 2; k++) {
+		cond_lists_state_free(cls[k]);
+		qpol_iterator_destroy(iters[k]);
+	}
+	errno = error;
+	return STATUS_ERR;
+}
+
+int qpol_policy_get_what_if_av_iters(const qpol_policy_t * policy, qpol_bool_t * const *datums, const int *states, size_t num,
+				     uint32_t rule_type_mask, qpol_iterator_t ** enabled, qpol_iterator_t ** disabled)
+{
+	return cond_what_if_rules(policy, datums, states, num, rule_type_mask,
+				  QPOL_RULE_ALLOW | QPOL_RULE_NEVERALLOW | QPOL_RULE_AUDITALLOW | QPOL_RULE_DONTAUDIT, enabled,
+				  disabled);
+}
+
+int qpol_policy_get_what_if_te_iters(const qpol_policy_t * policy, qpol_bool_t * const *datums, const int *states, size_t num,
+				     uint32_t rule_type_mask, qpol_iterator_t ** enabled, qpol_iterator_t ** disabled)
+{
+	return cond_what_if_rules(policy, datums, states, num, rule_type_mask,
+				  QPOL_RULE_TYPE_TRANS | QPOL_RULE_TYPE_CHANGE | QPOL_RULE_TYPE_MEMBER, enabled, disabled);
+}
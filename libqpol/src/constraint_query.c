@@ -841,6 +841,52 @@ int qpol_constraint_expr_node_get_names_iter(const qpol_policy_t * policy, const
 	return STATUS_SUCCESS;
 }
 
+int qpol_constraint_expr_node_get_values(const qpol_policy_t * policy, const qpol_constraint_expr_node_t * expr,
+					 uint32_t ** values, size_t * num_values)
+{
+	constraint_expr_t *internal_expr = NULL;
+	ebitmap_node_t *node = NULL;
+	uint32_t bit = 0;
+	size_t count = 0;
+
+	if (values)
+		*values = NULL;
+	if (num_values)
+		*num_values = 0;
+
+	if (!policy || !expr || !values || !num_values) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	internal_expr = (constraint_expr_t *) expr;
+	if (internal_expr->expr_type != QPOL_CEXPR_TYPE_NAMES) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	/* the expanded policy always holds the matching values in names;
+	 * type_names only records what was written */
+	ebitmap_for_each_bit(&internal_expr->names, node, bit) {
+		count += ebitmap_node_get_bit(node, bit);
+	}
+	if (count == 0)
+		return STATUS_SUCCESS;
+	if (!(*values = malloc(count * sizeof(uint32_t)))) {
+		ERR(policy, "%s", strerror(ENOMEM));
+		errno = ENOMEM;
+		return STATUS_ERR;
+	}
+	ebitmap_for_each_bit(&internal_expr->names, node, bit) {
+		if (ebitmap_node_get_bit(node, bit))
+			(*values)[(*num_values)++] = bit + 1;
+	}
+
+	return STATUS_SUCCESS;
+}
+
 typedef struct class_constr_state
 {
 	constraint_node_t *head;
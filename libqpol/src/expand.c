@@ -90,6 +90,7 @@ int qpol_expand_module(qpol_policy_t * base, int neverallows)
 	int rt, error = 0;
 
 	INFO(base, "%s", "Expanding policy. (Step 3 of 5)");
+	qpol_policy_step(base, "expand");
 	if (base == NULL) {
 		ERR(base, "%s", strerror(EINVAL));
 		errno = EINVAL;
@@ -33,6 +33,7 @@
 
 #include <stdlib.h>
 #include <errno.h>
+#include <limits.h>
 #include <string.h>
 
 #include <sepol/policydb/policydb.h>
@@ -57,6 +58,8 @@ struct qpol_iterator
 	int (*end) (const qpol_iterator_t * iter);
 	 size_t(*size) (const qpol_iterator_t * iter);
 	void (*free_fn) (void *x);
+	/** specialized bulk fetch routine, or NULL to use the generic one */
+	int (*next_batch) (qpol_iterator_t * iter, void **out, size_t max);
 };
 
 /**
@@ -106,6 +109,29 @@ int qpol_iterator_create(const qpol_policy_t * policy, void *state,
 	(*iter)->size = size;
 	(*iter)->free_fn = free_fn;
 
+	/* the common state types have fast bulk fetch routines that
+	 * walk the underlying sepol structures directly; select one
+	 * only if the iterator uses that state's stock accessors */
+	if (get_cur == avtab_state_get_cur && next == avtab_state_next && end == avtab_state_end) {
+		(*iter)->next_batch = avtab_state_next_batch;
+	} else if (get_cur == hash_state_get_cur && next == hash_state_next && end == hash_state_end) {
+		(*iter)->next_batch = hash_state_next_batch;
+	} else if (next == ebitmap_state_next && end == ebitmap_state_end) {
+		(*iter)->next_batch = ebitmap_state_next_batch;
+	}
+
+	return STATUS_SUCCESS;
+}
+
+int qpol_iterator_set_next_batch(qpol_iterator_t * iter, int (*next_batch) (qpol_iterator_t * iter, void **out, size_t max))
+{
+	if (iter == NULL) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	iter->next_batch = next_batch;
+
 	return STATUS_SUCCESS;
 }
 
@@ -215,6 +241,37 @@ int hash_state_next(qpol_iterator_t * iter)
 	return STATUS_SUCCESS;
 }
 
+/**
+ * Find the lowest set bit within an ebitmap that is strictly greater
+ * than the given bit.  Unlike repeated calls to ebitmap_get_bit(),
+ * which restart from the head of the node list for every bit, this
+ * walks the node list once and skips over clear words entirely.
+ *
+ * @param bmap Bitmap to search.
+ * @param bit Bit after which to begin searching.
+ *
+ * @return Next set bit, or bmap->highbit if there are no more set
+ * bits.
+ */
+static size_t ebitmap_state_find_next(const ebitmap_t * bmap, size_t bit)
+{
+	const ebitmap_node_t *node;
+	MAPTYPE map;
+	size_t start = bit + 1;
+
+	for (node = bmap->node; node != NULL; node = node->next) {
+		if (start >= node->startbit + MAPSIZE)
+			continue;
+		map = node->map;
+		if (start > node->startbit)
+			map &= ~(((MAPTYPE) 1 << (start - node->startbit)) - 1);
+		if (map != 0)
+			return node->startbit + __builtin_ctzll((unsigned long long)map);
+	}
+
+	return bmap->highbit;
+}
+
 int ebitmap_state_next(qpol_iterator_t * iter)
 {
 	ebitmap_state_t *es = NULL;
@@ -231,9 +288,7 @@ int ebitmap_state_next(qpol_iterator_t * iter)
 		return STATUS_ERR;
 	}
 
-	do {
-		es->cur++;
-	} while (es->cur < es->bmap->highbit && !ebitmap_get_bit(es->bmap, es->cur));
+	es->cur = ebitmap_state_find_next(es->bmap, es->cur);
 
 	return STATUS_SUCCESS;
 }
@@ -259,6 +314,49 @@ int ocon_state_next(qpol_iterator_t * iter)
 	return STATUS_SUCCESS;
 }
 
+/**
+ * Advance an avtab state to the next node whose rule type matches the
+ * state's mask, moving from the unconditional table to the
+ * conditional table as needed.  Upon reaching the end of the
+ * conditional table the state's node is set to NULL and its bucket to
+ * one past the last slot.
+ *
+ * @param state State to advance.
+ */
+static void avtab_state_advance(avtab_state_t * state)
+{
+	avtab_t *avtab = (state->which == QPOL_AVTAB_STATE_AV ? state->ucond_tab : state->cond_tab);
+	uint32_t nslot = (avtab->htable ? iterator_get_avtab_size(avtab) : 0);
+	uint32_t bucket = state->bucket;
+	avtab_ptr_t node = (state->node != NULL ? state->node->next : NULL);
+
+	for (;;) {
+		for (; node != NULL; node = node->next) {
+			if (avtab_state_match(state, node)) {
+				state->node = node;
+				state->bucket = bucket;
+				return;
+			}
+		}
+		if (++bucket < nslot) {
+			node = avtab->htable[bucket];
+			continue;
+		}
+		if (state->which == QPOL_AVTAB_STATE_COND) {
+			break;
+		}
+		/* done with the unconditional table; continue into the
+		 * conditional one */
+		avtab = state->cond_tab;
+		state->which = QPOL_AVTAB_STATE_COND;
+		nslot = (avtab->htable ? iterator_get_avtab_size(avtab) : 0);
+		bucket = 0;
+		node = (nslot > 0 ? avtab->htable[0] : NULL);
+	}
+	state->node = NULL;
+	state->bucket = nslot;
+}
+
 int avtab_state_next(qpol_iterator_t * iter)
 {
 	avtab_t *avtab;
@@ -277,31 +375,7 @@ int avtab_state_next(qpol_iterator_t * iter)
 		return STATUS_ERR;
 	}
 
-	do {
-		if (state->node != NULL && state->node->next != NULL) {
-			state->node = state->node->next;
-		} else {
-			/* find the next bucket */
-			do {
-				state->bucket++;
-				if (!avtab->htable || state->bucket >= iterator_get_avtab_size(avtab)) {
-					if (state->which == QPOL_AVTAB_STATE_AV) {
-						state->bucket = 0;
-						avtab = state->cond_tab;
-						state->which = QPOL_AVTAB_STATE_COND;
-					} else {
-						state->node = NULL;
-						break;
-					}
-				}
-				if (avtab->htable && avtab->htable[state->bucket] != NULL) {
-					state->node = avtab->htable[state->bucket];
-					break;
-				}
-			} while (avtab->htable && state->bucket < iterator_get_avtab_size(avtab));
-		}
-	} while (avtab->htable && state->bucket < iterator_get_avtab_size(avtab) &&
-		 state->node ? !(state->rule_type_mask & state->node->key.specified) : 0);
+	avtab_state_advance(state);
 
 	return STATUS_SUCCESS;
 }
@@ -444,7 +518,7 @@ size_t avtab_state_size(const qpol_iterator_t * iter)
 
 	for (bucket = 0; avtab->htable && bucket < iterator_get_avtab_size(avtab); bucket++) {
 		for (node = avtab->htable[bucket]; node; node = node->next) {
-			if (node->key.specified & state->rule_type_mask)
+			if (avtab_state_match(state, node))
 				count++;
 		}
 	}
@@ -453,7 +527,7 @@ size_t avtab_state_size(const qpol_iterator_t * iter)
 
 	for (bucket = 0; avtab->htable && bucket < iterator_get_avtab_size(avtab); bucket++) {
 		for (node = avtab->htable[bucket]; node; node = node->next) {
-			if (node->key.specified & state->rule_type_mask)
+			if (avtab_state_match(state, node))
 				count++;
 		}
 	}
@@ -461,6 +535,82 @@ size_t avtab_state_size(const qpol_iterator_t * iter)
 	return count;
 }
 
+int avtab_state_next_batch(qpol_iterator_t * iter, void **out, size_t max)
+{
+	avtab_state_t *state;
+	size_t count = 0;
+
+	if (iter == NULL || iter->state == NULL || out == NULL) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	state = iter->state;
+	while (count < max && state->node != NULL && !avtab_state_end(iter)) {
+		out[count++] = state->node;
+		avtab_state_advance(state);
+	}
+
+	return (int)count;
+}
+
+int hash_state_next_batch(qpol_iterator_t * iter, void **out, size_t max)
+{
+	hash_state_t *hs = NULL;
+	hashtab_t table;
+	hashtab_node_t *node;
+	unsigned int bucket;
+	size_t count = 0;
+
+	if (iter == NULL || iter->state == NULL || out == NULL) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	hs = (hash_state_t *) iter->state;
+	if (hash_state_end(iter))
+		return 0;
+
+	table = *(hs->table);
+	node = hs->node;
+	bucket = hs->bucket;
+	while (count < max && node != NULL) {
+		out[count++] = node->datum;
+		node = node->next;
+		while (node == NULL && ++bucket < table->size) {
+			node = table->htable[bucket];
+		}
+	}
+	hs->node = node;
+	hs->bucket = bucket;
+
+	return (int)count;
+}
+
+int ebitmap_state_next_batch(qpol_iterator_t * iter, void **out, size_t max)
+{
+	ebitmap_state_t *es = NULL;
+	size_t count = 0;
+	void *item;
+
+	if (iter == NULL || iter->state == NULL || out == NULL) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	es = (ebitmap_state_t *) iter->state;
+	while (count < max && es->cur < es->bmap->highbit) {
+		/* the item itself depends upon what the bitmap
+		 * represents, so defer to the iterator's accessor */
+		if ((item = iter->get_cur(iter)) == NULL)
+			return (count > 0 ? (int)count : STATUS_ERR);
+		out[count++] = item;
+		es->cur = ebitmap_state_find_next(es->bmap, es->cur);
+	}
+
+	return (int)count;
+}
+
 void qpol_iterator_destroy(qpol_iterator_t ** iter)
 {
 	if (iter == NULL || *iter == NULL)
@@ -510,6 +660,33 @@ int qpol_iterator_end(const qpol_iterator_t * iter)
 	return iter->end(iter);
 }
 
+int qpol_iterator_next_batch(qpol_iterator_t * iter, void **out, size_t max)
+{
+	size_t count = 0;
+
+	if (iter == NULL || iter->get_cur == NULL || iter->next == NULL || iter->end == NULL || out == NULL) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	/* results are returned as an int */
+	if (max > INT_MAX)
+		max = INT_MAX;
+
+	if (iter->next_batch != NULL)
+		return iter->next_batch(iter, out, max);
+
+	while (count < max && !iter->end(iter)) {
+		if ((out[count] = iter->get_cur(iter)) == NULL)
+			return (count > 0 ? (int)count : STATUS_ERR);
+		count++;
+		if (iter->next(iter))
+			return STATUS_ERR;
+	}
+
+	return (int)count;
+}
+
 int qpol_iterator_get_size(const qpol_iterator_t * iter, size_t * size)
 {
 	if (size != NULL)
@@ -70,6 +70,7 @@ extern "C"
 		uint32_t rule_type_mask;
 		avtab_t *ucond_tab;
 		avtab_t *cond_tab;
+		uint32_t source_val;	/* if non-zero, only rules with this source */
 		uint32_t bucket;
 		avtab_ptr_t node;
 #define QPOL_AVTAB_STATE_AV   0
@@ -77,12 +78,37 @@ extern "C"
 		unsigned which;
 	} avtab_state_t;
 
+/**
+ *  Determine if an avtab node is selected by an avtab iterator state.
+ *  @param state State whose rule type mask and source filter to apply.
+ *  @param node Node to check.
+ *  @return Non-zero if the node should be returned by the iterator.
+ */
+	static inline int avtab_state_match(const avtab_state_t * state, const avtab_ptr_t node)
+	{
+		return (node->key.specified & state->rule_type_mask) &&
+			(state->source_val == 0 || node->key.source_type == state->source_val);
+	}
+
 	int qpol_iterator_create(const qpol_policy_t * policy, void *state,
 				 void *(*get_cur) (const qpol_iterator_t * iter),
 				 int (*next) (qpol_iterator_t * iter),
 				 int (*end) (const qpol_iterator_t * iter),
 				 size_t(*size) (const qpol_iterator_t * iter), void (*free_fn) (void *x), qpol_iterator_t ** iter);
 
+/**
+ *  Override the bulk fetch routine used by qpol_iterator_next_batch().
+ *  qpol_iterator_create() already selects a specialized routine for
+ *  the stock avtab, hash and ebitmap states; iterators with other
+ *  state types may supply their own here.
+ *  @param iter Iterator to modify.
+ *  @param next_batch Routine that stores up to max items into out,
+ *  advancing past each, and returns the number stored or < 0 on
+ *  error.  If NULL the generic routine is used.
+ *  @return 0 on success and < 0 on failure.
+ */
+	int qpol_iterator_set_next_batch(qpol_iterator_t * iter, int (*next_batch) (qpol_iterator_t * iter, void **out, size_t max));
+
 	void *qpol_iterator_state(const qpol_iterator_t * iter);
 	const policydb_t *qpol_iterator_policy(const qpol_iterator_t * iter);
 
@@ -115,6 +141,10 @@ extern "C"
 	size_t perm_state_size(const qpol_iterator_t * iter);
 	size_t avtab_state_size(const qpol_iterator_t * iter);
 
+	int hash_state_next_batch(qpol_iterator_t * iter, void **out, size_t max);
+	int ebitmap_state_next_batch(qpol_iterator_t * iter, void **out, size_t max);
+	int avtab_state_next_batch(qpol_iterator_t * iter, void **out, size_t max);
+
 	void ebitmap_state_destroy(void *es);
 #ifdef	__cplusplus
 }
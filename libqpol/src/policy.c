@@ -172,6 +172,43 @@ static void qpol_handle_default_callback(void *varg __attribute__ ((unused)), co
 	fprintf(stderr, "\n");
 }
 
+/**
+ *  Begin the phase that encloses the steps of a load or rebuild,
+ *  unless the policy is already being loaded.
+ *  @param policy The policy being loaded.
+ *  @param name Name of the phase.
+ *  @return 1 if the phase was begun, in which case the caller must
+ *  call policy_load_end() afterwards, or 0 if not.
+ */
+static int policy_load_begin(qpol_policy_t * policy, const char *name)
+{
+	size_t depth = qpol_stats_get_depth(policy->stats);
+	if (policy->load_depth > 0 || qpol_stats_begin(policy->stats, name) < 0 || qpol_stats_get_depth(policy->stats) == depth)
+		return 0;
+	policy->load_depth = depth + 1;
+	return 1;
+}
+
+/**
+ *  End the phase begun by policy_load_begin(), along with the phase
+ *  of the last step.
+ *  @param policy The policy that was loaded.
+ */
+static void policy_load_end(qpol_policy_t * policy)
+{
+	if (policy->load_depth > 0)
+		qpol_stats_end_to(policy->stats, policy->load_depth - 1);
+	policy->load_depth = 0;
+}
+
+void qpol_policy_step(qpol_policy_t * policy, const char *name)
+{
+	if (policy == NULL || policy->load_depth == 0)
+		return;
+	qpol_stats_end_to(policy->stats, policy->load_depth);
+	qpol_stats_begin(policy->stats, name);
+}
+
 static int read_source_policy(qpol_policy_t * qpolicy, char *progname, int options)
 {
 	int load_rules = 1;
@@ -186,6 +223,7 @@ static int read_source_policy(qpol_policy_t * qpolicy, char *progname, int optio
 	mlspol = policydbp->mls;
 
 	INFO(qpolicy, "%s", "Parsing policy. (Step 1 of 5)");
+	qpol_policy_step(qpolicy, "parse");
 	init_scanner();
 	init_parser(1, load_rules);
 	errno = 0;
@@ -774,6 +812,59 @@ __asm__(".symver qpol_policy_rebuild_old,qpol_policy_rebuild@");
 __asm__(".symver qpol_policy_rebuild_opt,qpol_policy_rebuild@@VERS_1.3");
 #endif
 
+/**
+ * Get a copy of a modular policy's base module, into which modules
+ * may be linked.  Linking alters the base, so the pristine base is
+ * kept as an in-memory image from which each rebuild reads a fresh
+ * copy, rather than reopening the base module's file.
+ *
+ * @param policy Modular policy whose base to copy.
+ * @param base Location to write the copy.  The caller must call
+ * sepol_policydb_free() upon it afterwards.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int qpol_policy_copy_base(qpol_policy_t * policy, sepol_policydb_t ** base)
+{
+	sepol_policy_file_t *pfile = NULL;
+	qpol_module_t *mod = NULL;
+	int error = 0;
+
+	*base = NULL;
+	if (policy->base_image == NULL &&
+	    sepol_policydb_to_image(policy->sh, (policy->modules[0])->p, &policy->base_image, &policy->base_image_sz)) {
+		/* the base could not be serialized; fall back to
+		 * reopening it */
+		policy->base_image = NULL;
+		if (qpol_module_create_from_file((policy->modules[0])->path, &mod)) {
+			error = errno;
+			goto err;
+		}
+		*base = mod->p;
+		mod->p = NULL;
+		qpol_module_destroy(&mod);
+		return 0;
+	}
+	if (sepol_policydb_create(base) || sepol_policy_file_create(&pfile)) {
+		error = errno;
+		goto err;
+	}
+	sepol_policy_file_set_mem(pfile, policy->base_image, policy->base_image_sz);
+	sepol_policy_file_set_handle(pfile, policy->sh);
+	if (sepol_policydb_read(*base, pfile)) {
+		error = EIO;
+		goto err;
+	}
+	sepol_policy_file_free(pfile);
+	return 0;
+      err:
+	sepol_policy_file_free(pfile);
+	sepol_policydb_free(*base);
+	*base = NULL;
+	errno = error;
+	return -1;
+}
+
 /**
  * @brief Internal version of qpol_policy_rebuild() version 1.3
  *
@@ -785,9 +876,8 @@ int qpol_policy_rebuild_opt(qpol_policy_t * policy, const int options)
 {
 	sepol_policydb_t *old_p = NULL;
 	sepol_policydb_t **modules = NULL;
-	qpol_module_t *base = NULL;
 	size_t num_modules = 0, i;
-	int error = 0, old_options;
+	int error = 0, old_options, began;
 
 	if (!policy) {
 		ERR(NULL, "%s", strerror(EINVAL));
@@ -803,6 +893,22 @@ int qpol_policy_rebuild_opt(qpol_policy_t * policy, const int options)
 	if (options == policy->options && policy->modified == 0)
 		return STATUS_SUCCESS;
 
+	/* likewise if modules were toggled but the set of enabled modules
+	 * is again the one already linked; policy->ext is only set once a
+	 * link has succeeded, so the first build never takes this path */
+	if (options == policy->options && policy->type == QPOL_POLICY_MODULE_BINARY && policy->ext != NULL) {
+		for (i = 1; i < policy->num_modules; i++) {
+			if (!(policy->modules[i])->enabled != !(policy->modules[i])->linked)
+				break;
+		}
+		if (i >= policy->num_modules) {
+			policy->modified = 0;
+			return STATUS_SUCCESS;
+		}
+	}
+
+	began = policy_load_begin(policy, "rebuild");
+
 	/* cache old policy in case of failure */
 	old_p = policy->p;
 	policy->p = NULL;
@@ -828,21 +934,19 @@ int qpol_policy_rebuild_opt(qpol_policy_t * policy, const int options)
 				modules[num_modules++] = (policy->modules[i])->p;
 			}
 		}
-		/* have to reopen the base since link alters it */
-		if (qpol_module_create_from_file((policy->modules[0])->path, &base)) {
+		/* have to copy the base since link alters it */
+		qpol_policy_step(policy, "link");
+		if (qpol_policy_copy_base(policy, &(policy->p))) {
 			error = errno;
 			ERR(policy, "%s", strerror(error));
 			goto err;
 		}
-		/* take the policy from base and use as new base into which to link */
-		policy->p = base->p;
-		base->p = NULL;
-		qpol_module_destroy(&base);
 		if (sepol_link_modules(policy->sh, policy->p, modules, num_modules, 0)) {
 			error = EIO;
 			goto err;
 		}
 		free(modules);
+		modules = NULL;
 	} else {
 		/* repeat open process as if qpol_policy_open_from_memory() */
 		if (sepol_policydb_create(&(policy->p))) {
@@ -864,6 +968,7 @@ int qpol_policy_rebuild_opt(qpol_policy_t * policy, const int options)
 
 		/* link the source */
 		INFO(policy, "%s", "Linking source policy. (Step 2 of 5)");
+		qpol_policy_step(policy, "link");
 		if (sepol_link_modules(policy->sh, policy->p, NULL, 0, 0)) {
 			error = EIO;
 			goto err;
@@ -901,12 +1006,22 @@ int qpol_policy_rebuild_opt(qpol_policy_t * policy, const int options)
 	qpol_extended_image_destroy(&ext);
 
 	sepol_policydb_free(old_p);
+	for (i = 1; i < policy->num_modules; i++) {
+		(policy->modules[i])->linked = (policy->modules[i])->enabled;
+	}
+	policy->modified = 0;
+	policy->rebuild_seqno++;
+	if (began)
+		policy_load_end(policy);
 
 	return STATUS_SUCCESS;
 
       err:
+	if (began)
+		policy_load_end(policy);
 	free(modules);
 
+	sepol_policydb_free(policy->p);
 	policy->p = old_p;
 	policy->ext = ext;
 	policy->options = old_options;
@@ -985,6 +1100,14 @@ int qpol_policy_open_from_file_opt(const char *path, qpol_policy_t ** policy, qp
 	if ((*policy)->options & QPOL_POLICY_OPTION_NO_RULES)
 		(*policy)->options |= QPOL_POLICY_OPTION_NO_NEVERALLOWS;
 
+	if (!((*policy)->stats = qpol_stats_create())) {
+		error = errno;
+		ERR(NULL, "%s", strerror(error));
+		goto err;
+	}
+	policy_load_begin(*policy, "load");
+	qpol_policy_step(*policy, "read");
+
 	(*policy)->sh = sepol_handle_create();
 	if ((*policy)->sh == NULL) {
 		error = errno;
@@ -1083,6 +1206,7 @@ int qpol_policy_open_from_file_opt(const char *path, qpol_policy_t ** policy, qp
 
 		/* link the source */
 		INFO(*policy, "%s", "Linking source policy. (Step 2 of 5)");
+		qpol_policy_step(*policy, "link");
 		if (sepol_link_modules((*policy)->sh, (*policy)->p, NULL, 0, 0)) {
 			error = EIO;
 			goto err;
@@ -1118,6 +1242,7 @@ int qpol_policy_open_from_file_opt(const char *path, qpol_policy_t ** policy, qp
 		}
 	}
 
+	policy_load_end(*policy);
 	fclose(infile);
 	sepol_policy_file_free(pfile);
 	return retv;
@@ -1169,6 +1294,14 @@ int qpol_policy_open_from_memory_opt(qpol_policy_t ** policy, const char *fileda
 	if ((*policy)->options & QPOL_POLICY_OPTION_NO_RULES)
 		(*policy)->options |= QPOL_POLICY_OPTION_NO_NEVERALLOWS;
 
+	if (!((*policy)->stats = qpol_stats_create())) {
+		error = errno;
+		ERR(NULL, "%s", strerror(error));
+		goto err;
+	}
+	policy_load_begin(*policy, "load");
+	qpol_policy_step(*policy, "read");
+
 	(*policy)->sh = sepol_handle_create();
 	if ((*policy)->sh == NULL) {
 		error = errno;
@@ -1211,6 +1344,7 @@ int qpol_policy_open_from_memory_opt(qpol_policy_t ** policy, const char *fileda
 
 	/* link the source */
 	INFO(*policy, "%s", "Linking source policy. (Step 2 of 5)");
+	qpol_policy_step(*policy, "link");
 	if (sepol_link_modules((*policy)->sh, (*policy)->p, NULL, 0, 0)) {
 		error = EIO;
 		goto err;
@@ -1236,6 +1370,7 @@ int qpol_policy_open_from_memory_opt(qpol_policy_t ** policy, const char *fileda
 		goto err;
 	}
 
+	policy_load_end(*policy);
 	return 0;
       err:
 	qpol_policy_destroy(policy);
@@ -1285,6 +1420,8 @@ void qpol_policy_destroy(qpol_policy_t ** policy)
 			}
 			free((*policy)->modules);
 		}
+		free((*policy)->base_image);
+		qpol_stats_destroy(&((*policy)->stats));
 		if ((*policy)->file_data_type == QPOL_POLICY_FILE_DATA_TYPE_MEM) {
 			free((*policy)->file_data);
 		} else if ((*policy)->file_data_type == QPOL_POLICY_FILE_DATA_TYPE_MMAP) {
@@ -1295,11 +1432,45 @@ void qpol_policy_destroy(qpol_policy_t ** policy)
 	}
 }
 
+int qpol_policy_reevaluate_cond(qpol_policy_t * policy, cond_node_t * cond)
+{
+	cond_av_list_t *list_ptr = NULL;
+
+	cond->cur_state = cond_evaluate_expr(&policy->p->p, cond->expr);
+	if (cond->cur_state < 0) {
+		ERR(policy, "Error evaluating conditional: %s", strerror(EILSEQ));
+		errno = EILSEQ;
+		return STATUS_ERR;
+	}
+	policy->cond_seqno++;
+
+	/* walk true list */
+	for (list_ptr = cond->true_list; list_ptr; list_ptr = list_ptr->next) {
+		/* field not used (except by write),
+		 * now storing list and enabled flags */
+		if (cond->cur_state)
+			list_ptr->node->merged |= QPOL_COND_RULE_ENABLED;
+		else
+			list_ptr->node->merged &= ~(QPOL_COND_RULE_ENABLED);
+	}
+
+	/* walk false list */
+	for (list_ptr = cond->false_list; list_ptr; list_ptr = list_ptr->next) {
+		/* field not used (except by write),
+		 * now storing list and enabled flags */
+		if (!cond->cur_state)
+			list_ptr->node->merged |= QPOL_COND_RULE_ENABLED;
+		else
+			list_ptr->node->merged &= ~(QPOL_COND_RULE_ENABLED);
+	}
+
+	return STATUS_SUCCESS;
+}
+
 int qpol_policy_reevaluate_conds(qpol_policy_t * policy)
 {
 	policydb_t *db = NULL;
 	cond_node_t *cond = NULL;
-	cond_av_list_t *list_ptr = NULL;
 
 	if (!policy) {
 		ERR(policy, "%s", strerror(EINVAL));
@@ -1310,33 +1481,8 @@ int qpol_policy_reevaluate_conds(qpol_policy_t * policy)
 	db = &policy->p->p;
 
 	for (cond = db->cond_list; cond; cond = cond->next) {
-		/* evaluate cond */
-		cond->cur_state = cond_evaluate_expr(db, cond->expr);
-		if (cond->cur_state < 0) {
-			ERR(policy, "Error evaluating conditional: %s", strerror(EILSEQ));
-			errno = EILSEQ;
-			return STATUS_ERR;
-		}
-
-		/* walk true list */
-		for (list_ptr = cond->true_list; list_ptr; list_ptr = list_ptr->next) {
-			/* field not used (except by write),
-			 * now storing list and enabled flags */
-			if (cond->cur_state)
-				list_ptr->node->merged |= QPOL_COND_RULE_ENABLED;
-			else
-				list_ptr->node->merged &= ~(QPOL_COND_RULE_ENABLED);
-		}
-
-		/* walk false list */
-		for (list_ptr = cond->false_list; list_ptr; list_ptr = list_ptr->next) {
-			/* field not used (except by write),
-			 * now storing list and enabled flags */
-			if (!cond->cur_state)
-				list_ptr->node->merged |= QPOL_COND_RULE_ENABLED;
-			else
-				list_ptr->node->merged &= ~(QPOL_COND_RULE_ENABLED);
-		}
+		if (qpol_policy_reevaluate_cond(policy, cond))
+			return STATUS_ERR;     /* errno already set */
 	}
 
 	return STATUS_SUCCESS;
@@ -1505,6 +1651,267 @@ int qpol_policy_get_policy_version(const qpol_policy_t * policy, unsigned int *v
 	return STATUS_SUCCESS;
 }
 
+int qpol_policy_get_cond_seqno(const qpol_policy_t * policy, unsigned int *seqno)
+{
+	if (seqno != NULL)
+		*seqno = 0;
+
+	if (policy == NULL || seqno == NULL) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	*seqno = policy->cond_seqno;
+
+	return STATUS_SUCCESS;
+}
+
+int qpol_policy_get_rebuild_seqno(const qpol_policy_t * policy, unsigned int *seqno)
+{
+	if (seqno != NULL)
+		*seqno = 0;
+
+	if (policy == NULL || seqno == NULL) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	*seqno = policy->rebuild_seqno;
+
+	return STATUS_SUCCESS;
+}
+
+/******************** memory accounting ********************/
+
+static const char *const policy_memory_names[QPOL_MEMORY_NUM_CATEGORIES] = {
+	"symbols", "av table", "conditional av table", "conditionals", "attribute maps",
+	"syntactic rules", "rule index", "file data", "modules"
+};
+
+const char *qpol_memory_category_get_name(qpol_memory_category_e category)
+{
+	if ((int)category < 0 || category >= QPOL_MEMORY_NUM_CATEGORIES) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return policy_memory_names[category];
+}
+
+/**
+ * Return the number of bytes used by an ebitmap's nodes.
+ */
+static size_t policy_ebitmap_memory(const ebitmap_t * e)
+{
+	const ebitmap_node_t *n;
+	size_t bytes = 0;
+	for (n = e->node; n != NULL; n = n->next) {
+		bytes += sizeof(*n);
+	}
+	return bytes;
+}
+
+/** state while walking one symbol table */
+struct policy_symtab_memory
+{
+	/** which symbol table is being walked, or -1 for a class's
+	 *  permissions */
+	int sym;
+	size_t datum_size;
+	qpol_memory_usage_t usage;
+};
+
+static size_t policy_hashtab_memory(hashtab_t h, int sym, size_t datum_size, size_t * count);
+
+static int policy_symtab_memory_node(hashtab_key_t key, hashtab_datum_t datum, void *args)
+{
+	struct policy_symtab_memory *m = args;
+	size_t count = 0;
+	m->usage.bytes += sizeof(hashtab_node_t) + strlen(key) + 1 + m->datum_size;
+	m->usage.count++;
+	switch (m->sym) {
+	case SYM_COMMONS:{
+			common_datum_t *common = datum;
+			m->usage.bytes += policy_hashtab_memory(common->permissions.table, -1, sizeof(perm_datum_t), &count);
+			break;
+		}
+	case SYM_CLASSES:{
+			class_datum_t *cls = datum;
+			m->usage.bytes += policy_hashtab_memory(cls->permissions.table, -1, sizeof(perm_datum_t), &count);
+			break;
+		}
+	case SYM_ROLES:{
+			role_datum_t *role = datum;
+			m->usage.bytes += policy_ebitmap_memory(&role->dominates) + policy_ebitmap_memory(&role->types.types) +
+				policy_ebitmap_memory(&role->types.negset) + policy_ebitmap_memory(&role->roles);
+			break;
+		}
+	case SYM_TYPES:{
+			type_datum_t *type = datum;
+			m->usage.bytes += policy_ebitmap_memory(&type->types);
+			break;
+		}
+	case SYM_USERS:{
+			user_datum_t *user = datum;
+			m->usage.bytes += policy_ebitmap_memory(&user->roles.roles);
+			break;
+		}
+	case SYM_LEVELS:{
+			level_datum_t *level = datum;
+			if (level->level != NULL) {
+				m->usage.bytes += sizeof(*level->level) + policy_ebitmap_memory(&level->level->cat);
+			}
+			break;
+		}
+	default:
+		break;
+	}
+	m->usage.count += count;
+	return 0;
+}
+
+/**
+ * Return the number of bytes used by a symbol table's hash table,
+ * keys, and data, and add the number of symbols to count.
+ */
+static size_t policy_hashtab_memory(hashtab_t h, int sym, size_t datum_size, size_t * count)
+{
+	struct policy_symtab_memory m;
+	if (h == NULL) {
+		return 0;
+	}
+	memset(&m, 0, sizeof(m));
+	m.sym = sym;
+	m.datum_size = datum_size;
+	m.usage.bytes = sizeof(*h) + h->size * sizeof(hashtab_ptr_t);
+	hashtab_map(h, policy_symtab_memory_node, &m);
+	*count += m.usage.count;
+	return m.usage.bytes;
+}
+
+/**
+ * Add the memory used by a policydb's symbol tables, and by the arrays
+ * indexing them by value, to usage.
+ */
+static void policy_symbols_memory(const policydb_t * db, qpol_memory_usage_t * usage)
+{
+	static const size_t datum_sizes[SYM_NUM] = {
+		sizeof(common_datum_t), sizeof(class_datum_t), sizeof(role_datum_t), sizeof(type_datum_t),
+		sizeof(user_datum_t), sizeof(cond_bool_datum_t), sizeof(level_datum_t), sizeof(cat_datum_t)
+	};
+	int i;
+	for (i = 0; i < SYM_NUM; i++) {
+		usage->bytes += policy_hashtab_memory(db->symtab[i].table, i, datum_sizes[i], &usage->count);
+		if (db->sym_val_to_name[i] != NULL) {
+			usage->bytes += db->symtab[i].nprim * sizeof(char *);
+		}
+	}
+	if (db->class_val_to_struct != NULL)
+		usage->bytes += db->p_classes.nprim * sizeof(*db->class_val_to_struct);
+	if (db->role_val_to_struct != NULL)
+		usage->bytes += db->p_roles.nprim * sizeof(*db->role_val_to_struct);
+	if (db->user_val_to_struct != NULL)
+		usage->bytes += db->p_users.nprim * sizeof(*db->user_val_to_struct);
+	if (db->type_val_to_struct != NULL)
+		usage->bytes += db->p_types.nprim * sizeof(*db->type_val_to_struct);
+	if (db->bool_val_to_struct != NULL)
+		usage->bytes += db->p_bools.nprim * sizeof(*db->bool_val_to_struct);
+}
+
+static void policy_avtab_memory(const avtab_t * a, qpol_memory_usage_t * usage)
+{
+	usage->bytes += a->nslot * sizeof(avtab_ptr_t) + a->nel * sizeof(struct avtab_node);
+	usage->count += a->nel;
+}
+
+int qpol_policy_get_memory_usage(const qpol_policy_t * policy, qpol_memory_usage_t usage[QPOL_MEMORY_NUM_CATEGORIES])
+{
+	const policydb_t *db;
+	const cond_node_t *cond;
+	const cond_expr_t *expr;
+	const cond_av_list_t *l;
+	qpol_memory_usage_t *u;
+	size_t i;
+
+	if (policy == NULL || usage == NULL) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+	memset(usage, 0, QPOL_MEMORY_NUM_CATEGORIES * sizeof(*usage));
+	db = &policy->p->p;
+
+	policy_symbols_memory(db, usage + QPOL_MEMORY_SYMBOLS);
+	policy_avtab_memory(&db->te_avtab, usage + QPOL_MEMORY_AVTAB);
+	policy_avtab_memory(&db->te_cond_avtab, usage + QPOL_MEMORY_COND_AVTAB);
+
+	u = usage + QPOL_MEMORY_CONDS;
+	for (cond = db->cond_list; cond != NULL; cond = cond->next) {
+		u->bytes += sizeof(*cond);
+		u->count++;
+		for (expr = cond->expr; expr != NULL; expr = expr->next) {
+			u->bytes += sizeof(*expr);
+		}
+		for (l = cond->true_list; l != NULL; l = l->next) {
+			u->bytes += sizeof(*l);
+		}
+		for (l = cond->false_list; l != NULL; l = l->next) {
+			u->bytes += sizeof(*l);
+		}
+	}
+
+	u = usage + QPOL_MEMORY_ATTR_MAPS;
+	for (i = 0; i < db->p_types.nprim; i++) {
+		if (db->type_attr_map != NULL) {
+			u->bytes += sizeof(ebitmap_t) + policy_ebitmap_memory(&db->type_attr_map[i]);
+			u->count++;
+		}
+		if (db->attr_type_map != NULL) {
+			u->bytes += sizeof(ebitmap_t) + policy_ebitmap_memory(&db->attr_type_map[i]);
+			u->count++;
+		}
+	}
+
+	policy_extend_get_memory_usage(policy, usage);
+
+	u = usage + QPOL_MEMORY_FILE_DATA;
+	if (policy->file_data != NULL) {
+		u->bytes += policy->file_data_sz;
+		u->count++;
+	}
+	if (policy->base_image != NULL) {
+		u->bytes += policy->base_image_sz;
+		u->count++;
+	}
+
+	u = usage + QPOL_MEMORY_MODULES;
+	for (i = 0; i < policy->num_modules; i++) {
+		const qpol_module_t *mod = policy->modules[i];
+		qpol_memory_usage_t symbols = { 0, 0 };
+		u->bytes += sizeof(*mod) + sizeof(mod);
+		u->bytes += (mod->name ? strlen(mod->name) + 1 : 0) + (mod->path ? strlen(mod->path) + 1 : 0) +
+			(mod->version ? strlen(mod->version) + 1 : 0);
+		if (mod->p != NULL) {
+			policy_symbols_memory(&mod->p->p, &symbols);
+			u->bytes += symbols.bytes;
+		}
+		u->count++;
+	}
+
+	return STATUS_SUCCESS;
+}
+
+qpol_stats_t *qpol_policy_get_stats(const qpol_policy_t * policy)
+{
+	if (policy == NULL) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return NULL;
+	}
+	return policy->stats;
+}
+
 int qpol_policy_get_policy_handle_unknown(const qpol_policy_t * policy, unsigned int *handle_unknown)
 {
 	policydb_t *db;
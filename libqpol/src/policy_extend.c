@@ -44,6 +44,8 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include "qpol_internal.h"
 #include "iterator_internal.h"
 #include "syn_rule_internal.h"
@@ -100,11 +102,35 @@ typedef struct qpol_syn_rule_table
 	qpol_syn_rule_node_t **buckets;
 } qpol_syn_rule_table_t;
 
+/* one entry in the sorted rule snapshot; the key is copied out of the
+ * avtab node so that scans and searches need not dereference it */
+typedef struct qpol_sorted_rule
+{
+	uint16_t specified;	       /* rule type, without AVTAB_ENABLED */
+	uint16_t source;
+	uint16_t target;
+	uint16_t tclass;
+	uint32_t is_cond;
+	uint32_t order;		       /* position before sorting, to break ties */
+	avtab_ptr_t node;
+} qpol_sorted_rule_t;
+
 typedef struct qpol_extended_image
 {
 	qpol_syn_rule_table_t *syn_rule_table;
 	struct qpol_syn_rule **syn_rule_master_list;
 	size_t master_list_sz;
+	qpol_sorted_rule_t *sorted_rules;
+	size_t num_sorted_rules;
+	/* conditionals in policy order, and an index from each
+	 * boolean to the conditionals that reference it; the
+	 * ordinals for boolean value b are bool_conds[bool_cond_start[b]]
+	 * up to bool_conds[bool_cond_start[b + 1]] */
+	cond_node_t **conds;
+	size_t num_conds;
+	size_t *bool_cond_start;
+	uint32_t *bool_conds;
+	size_t num_index_bools;
 } qpol_extended_image_t;
 
 struct extend_bogus_alias_struct
@@ -190,6 +216,7 @@ static int qpol_policy_build_attrs_from_map(qpol_policy_t * policy)
 	int error = 0, retv;
 
 	INFO(policy, "%s", "Generating attributes for policy. (Step 4 of 5)");
+	qpol_policy_step(policy, "attributes");
 	if (policy == NULL) {
 		ERR(policy, "%s", strerror(EINVAL));
 		errno = EINVAL;
@@ -570,6 +597,7 @@ static int qpol_policy_add_cond_rule_traceback(qpol_policy_t * policy)
 	uint32_t rules = 0;
 
 	INFO(policy, "%s", "Building conditional rules tables. (Step 5 of 5)");
+	qpol_policy_step(policy, "conditional rules");
 	if (!policy) {
 		ERR(policy, "%s", strerror(EINVAL));
 		errno = EINVAL;
@@ -881,6 +909,7 @@ static int qpol_syn_rule_table_insert_sepol_avrule(qpol_policy_t * policy, qpol_
 int qpol_policy_build_syn_rule_table(qpol_policy_t * policy)
 {
 	int error = 0, created = 0;
+	size_t depth;
 	avrule_block_t *cur_block = NULL;
 	avrule_decl_t *decl = NULL;
 	avrule_t *cur_rule = NULL;
@@ -891,6 +920,7 @@ int qpol_policy_build_syn_rule_table(qpol_policy_t * policy)
 		errno = EINVAL;
 		return -1;
 	}
+	depth = qpol_stats_get_depth(policy->stats);
 
 	if (!policy->ext) {
 		policy->ext = calloc(1, sizeof(qpol_extended_image_t));
@@ -904,6 +934,7 @@ int qpol_policy_build_syn_rule_table(qpol_policy_t * policy)
 	if (policy->ext->syn_rule_table)
 		return 0;	       /* already built */
 
+	qpol_stats_begin(policy->stats, "syntactic rules");
 	policy->ext->syn_rule_table = calloc(1, sizeof(qpol_syn_rule_table_t));
 	if (!policy->ext->syn_rule_table) {
 		error = errno;
@@ -938,8 +969,10 @@ int qpol_policy_build_syn_rule_table(qpol_policy_t * policy)
 
 	if (policy->ext->master_list_sz == 0) {
 		policy->ext->syn_rule_master_list = NULL;
+		qpol_stats_end_to(policy->stats, depth);
 		return 0;	       /* policy is not a source policy */
 	}
+	qpol_stats_add(policy->stats, QPOL_STATS_RULES_SCANNED, policy->ext->master_list_sz);
 
 	INFO(policy, "%s", "Building syntactic rules tables.");
 
@@ -1032,15 +1065,287 @@ int qpol_policy_build_syn_rule_table(qpol_policy_t * policy)
 	fprintf(stderr, "                        min %zd, max %zd, stddev %g\n", min_items, max_items, stddev);
 #endif
 
+	qpol_stats_end_to(policy->stats, depth);
 	return 0;
 
       err:
 	if (policy->ext)
 		qpol_syn_rule_table_destroy(&policy->ext->syn_rule_table);
+	qpol_stats_end_to(policy->stats, depth);
+	errno = error;
+	return -1;
+}
+
+static int qpol_sorted_rule_comp(const void *a, const void *b)
+{
+	const qpol_sorted_rule_t *r1 = a;
+	const qpol_sorted_rule_t *r2 = b;
+
+	if (r1->specified != r2->specified)
+		return (r1->specified < r2->specified ? -1 : 1);
+	if (r1->source != r2->source)
+		return (r1->source < r2->source ? -1 : 1);
+	if (r1->target != r2->target)
+		return (r1->target < r2->target ? -1 : 1);
+	if (r1->tclass != r2->tclass)
+		return (r1->tclass < r2->tclass ? -1 : 1);
+	if (r1->is_cond != r2->is_cond)
+		return (int)r1->is_cond - (int)r2->is_cond;
+	/* conditional rules may share a key; qsort() is not stable, so
+	 * keep them in the order they were added */
+	return (r1->order < r2->order ? -1 : (r1->order > r2->order ? 1 : 0));
+}
+
+/**
+ *  Append every node of an avtab to the sorted rule array.
+ *  @param avtab Table whose nodes to append.
+ *  @param is_cond Non-zero if the table holds conditional rules.
+ *  @param rules Array with enough space for all nodes.
+ *  @param num Number of entries already in the array; updated by this call.
+ */
+static void qpol_sorted_rule_table_add_avtab(const avtab_t * avtab, int is_cond, qpol_sorted_rule_t * rules, size_t * num)
+{
+	uint32_t bucket, nslot;
+	avtab_ptr_t node;
+
+	if (!avtab->htable)
+		return;
+#ifdef SEPOL_DYNAMIC_AVTAB
+	nslot = avtab->nslot;
+#else
+	nslot = AVTAB_SIZE;
+#endif
+	for (bucket = 0; bucket < nslot; bucket++) {
+		for (node = avtab->htable[bucket]; node; node = node->next) {
+			qpol_sorted_rule_t *r = rules + *num;
+			r->order = (uint32_t) (*num)++;
+			r->specified = node->key.specified & ~AVTAB_ENABLED;
+			r->source = node->key.source_type;
+			r->target = node->key.target_type;
+			r->tclass = node->key.target_class;
+			r->is_cond = (is_cond != 0);
+			r->node = node;
+		}
+	}
+}
+
+int qpol_policy_build_sorted_rule_table(qpol_policy_t * policy)
+{
+	policydb_t *db;
+	qpol_sorted_rule_t *rules = NULL;
+	size_t num = 0;
+	int error;
+
+	if (!policy) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (!qpol_policy_has_capability(policy, QPOL_CAP_RULES_LOADED)) {
+		ERR(policy, "%s", "Cannot build sorted rule table: Rules not loaded");
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	if (!policy->ext) {
+		policy->ext = calloc(1, sizeof(qpol_extended_image_t));
+		if (!policy->ext) {
+			error = errno;
+			ERR(policy, "%s", strerror(error));
+			errno = error;
+			return -1;
+		}
+	}
+
+	if (policy->ext->sorted_rules)
+		return 0;	       /* already built */
+
+	db = &policy->p->p;
+	num = db->te_avtab.nel + db->te_cond_avtab.nel;
+	if (num == 0)
+		return 0;
+	if (!(rules = malloc(num * sizeof(*rules)))) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return -1;
+	}
+
+	qpol_stats_begin(policy->stats, "sorted rules");
+	num = 0;
+	qpol_sorted_rule_table_add_avtab(&db->te_avtab, 0, rules, &num);
+	qpol_sorted_rule_table_add_avtab(&db->te_cond_avtab, 1, rules, &num);
+	qsort(rules, num, sizeof(*rules), qpol_sorted_rule_comp);
+	qpol_stats_add(policy->stats, QPOL_STATS_RULES_SCANNED, num);
+	qpol_stats_end(policy->stats);
+
+	policy->ext->sorted_rules = rules;
+	policy->ext->num_sorted_rules = num;
+	return 0;
+}
+
+int qpol_policy_has_sorted_rule_table(const qpol_policy_t * policy)
+{
+	return policy != NULL && policy->ext != NULL && policy->ext->sorted_rules != NULL;
+}
+
+/**
+ *  Build the index from each boolean to the conditionals whose
+ *  expressions reference it, so that changing a boolean need only
+ *  re-evaluate those conditionals.  Subsequent calls have no effect.
+ *  @param policy The policy for which to build the index.
+ *  @return 0 on success, < 0 on failure; if the call fails, errno
+ *  will be set.
+ */
+static int qpol_policy_build_cond_index(qpol_policy_t * policy)
+{
+	policydb_t *db;
+	cond_node_t *cond;
+	cond_expr_t *expr;
+	cond_node_t **conds = NULL;
+	size_t *start = NULL, *fill = NULL;
+	uint32_t *bool_conds = NULL;
+	size_t num_conds = 0, num_bools, total, i, b;
+	int error;
+
+	if (!policy->ext) {
+		policy->ext = calloc(1, sizeof(qpol_extended_image_t));
+		if (!policy->ext) {
+			error = errno;
+			ERR(policy, "%s", strerror(error));
+			errno = error;
+			return -1;
+		}
+	}
+
+	if (policy->ext->bool_cond_start)
+		return 0;	       /* already built */
+
+	db = &policy->p->p;
+	num_bools = db->p_bools.nprim;
+	for (cond = db->cond_list; cond; cond = cond->next)
+		num_conds++;
+
+	/* start[b + 1] first counts the conditionals referencing
+	 * boolean b; fill[b] holds the ordinal plus one of the last
+	 * conditional counted, so that a boolean used twice within
+	 * one expression is only counted once */
+	if (!(conds = malloc((num_conds ? num_conds : 1) * sizeof(*conds))) ||
+	    !(start = calloc(num_bools + 2, sizeof(*start))) || !(fill = calloc(num_bools + 2, sizeof(*fill)))) {
+		error = errno;
+		goto err;
+	}
+	for (cond = db->cond_list, i = 0; cond; cond = cond->next, i++) {
+		conds[i] = cond;
+		for (expr = cond->expr; expr; expr = expr->next) {
+			b = expr->bool;
+			if (expr->expr_type != COND_BOOL || b < 1 || b > num_bools || fill[b] == i + 1)
+				continue;
+			fill[b] = i + 1;
+			start[b + 1]++;
+		}
+	}
+	for (b = 1; b < num_bools + 2; b++)
+		start[b] += start[b - 1];
+	total = start[num_bools + 1];
+
+	if (!(bool_conds = malloc((total ? total : 1) * sizeof(*bool_conds)))) {
+		error = errno;
+		goto err;
+	}
+	memcpy(fill, start, (num_bools + 2) * sizeof(*fill));
+	for (i = 0; i < num_conds; i++) {
+		for (expr = conds[i]->expr; expr; expr = expr->next) {
+			b = expr->bool;
+			if (expr->expr_type != COND_BOOL || b < 1 || b > num_bools)
+				continue;
+			/* ordinals are appended in increasing order, so a
+			 * repeat of this conditional is the last entry */
+			if (fill[b] > start[b] && bool_conds[fill[b] - 1] == i)
+				continue;
+			bool_conds[fill[b]++] = (uint32_t) i;
+		}
+	}
+	free(fill);
+
+	policy->ext->conds = conds;
+	policy->ext->num_conds = num_conds;
+	policy->ext->bool_cond_start = start;
+	policy->ext->bool_conds = bool_conds;
+	policy->ext->num_index_bools = num_bools;
+	return 0;
+
+      err:
+	ERR(policy, "%s", strerror(error));
+	free(conds);
+	free(start);
+	free(fill);
+	free(bool_conds);
 	errno = error;
 	return -1;
 }
 
+static int qpol_cond_ordinal_comp(const void *a, const void *b)
+{
+	uint32_t x = *((const uint32_t *)a), y = *((const uint32_t *)b);
+	return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+int qpol_policy_get_bool_conds(const qpol_policy_t * policy, const uint32_t * bool_vals, size_t num_vals,
+			       struct cond_node ***conds, size_t * num_conds)
+{
+	const qpol_extended_image_t *ext;
+	uint32_t *ords = NULL;
+	size_t total = 0, n = 0, i, j;
+	int error;
+
+	if (conds)
+		*conds = NULL;
+	if (num_conds)
+		*num_conds = 0;
+
+	if (!policy || (num_vals && !bool_vals) || !conds || !num_conds) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	ext = policy->ext;
+	if (!ext || !ext->bool_cond_start)
+		return STATUS_NODATA;
+
+	for (i = 0; i < num_vals; i++) {
+		if (bool_vals[i] < 1 || bool_vals[i] > ext->num_index_bools) {
+			ERR(policy, "%s", strerror(EINVAL));
+			errno = EINVAL;
+			return STATUS_ERR;
+		}
+		total += ext->bool_cond_start[bool_vals[i] + 1] - ext->bool_cond_start[bool_vals[i]];
+	}
+	if (!(ords = malloc((total ? total : 1) * sizeof(*ords))) || !(*conds = malloc((total ? total : 1) * sizeof(**conds)))) {
+		error = errno;
+		free(ords);
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return STATUS_ERR;
+	}
+	for (i = 0; i < num_vals; i++) {
+		for (j = ext->bool_cond_start[bool_vals[i]]; j < ext->bool_cond_start[bool_vals[i] + 1]; j++)
+			ords[n++] = ext->bool_conds[j];
+	}
+	/* the slice for a single boolean is already sorted and unique */
+	if (num_vals > 1)
+		qsort(ords, n, sizeof(*ords), qpol_cond_ordinal_comp);
+	for (i = 0; i < n; i++) {
+		if (i > 0 && ords[i] == ords[i - 1])
+			continue;
+		(*conds)[(*num_conds)++] = ext->conds[ords[i]];
+	}
+	free(ords);
+	return STATUS_SUCCESS;
+}
+
 /**
  *  Free all memory used by a qpol extended image and set it to NULL.
  *  @param ext The extended image to destroy.
@@ -1058,11 +1363,49 @@ void qpol_extended_image_destroy(qpol_extended_image_t ** ext)
 		qpol_syn_rule_destroy(&((*ext)->syn_rule_master_list[i]));
 	}
 	free((*ext)->syn_rule_master_list);
+	free((*ext)->sorted_rules);
+	free((*ext)->conds);
+	free((*ext)->bool_cond_start);
+	free((*ext)->bool_conds);
 
 	free(*ext);
 	*ext = NULL;
 }
 
+void policy_extend_get_memory_usage(const qpol_policy_t * policy, qpol_memory_usage_t * usage)
+{
+	const qpol_extended_image_t *ext = policy->ext;
+	const qpol_syn_rule_node_t *node;
+	const qpol_syn_rule_list_t *l;
+	qpol_memory_usage_t *u;
+	size_t i;
+
+	if (ext == NULL)
+		return;
+
+	u = usage + QPOL_MEMORY_SYN_RULES;
+	if (ext->syn_rule_table != NULL) {
+		u->bytes += sizeof(*ext->syn_rule_table) + QPOL_SYN_RULE_TABLE_SIZE * sizeof(*ext->syn_rule_table->buckets);
+		for (i = 0; i < QPOL_SYN_RULE_TABLE_SIZE; i++) {
+			for (node = ext->syn_rule_table->buckets[i]; node; node = node->next) {
+				u->bytes += sizeof(*node);
+				for (l = node->rules; l; l = l->next)
+					u->bytes += sizeof(*l);
+			}
+		}
+	}
+	u->bytes += ext->master_list_sz * (sizeof(*ext->syn_rule_master_list) + sizeof(struct qpol_syn_rule));
+	u->count += ext->master_list_sz;
+
+	u = usage + QPOL_MEMORY_RULE_INDEX;
+	u->bytes += ext->num_sorted_rules * sizeof(*ext->sorted_rules);
+	u->count += ext->num_sorted_rules;
+	if (ext->bool_cond_start != NULL) {
+		u->bytes += ext->num_conds * sizeof(*ext->conds) + (ext->num_index_bools + 2) * sizeof(*ext->bool_cond_start) +
+			ext->bool_cond_start[ext->num_index_bools + 1] * sizeof(*ext->bool_conds);
+	}
+}
+
 int policy_extend(qpol_policy_t * policy)
 {
 	int retv, error;
@@ -1111,6 +1454,12 @@ int policy_extend(qpol_policy_t * policy)
 		goto err;
 	}
 
+	retv = qpol_policy_build_cond_index(policy);
+	if (retv) {
+		error = errno;
+		goto err;
+	}
+
 	if (policy->options & QPOL_POLICY_OPTION_NO_RULES)
 		return STATUS_SUCCESS;
 
@@ -1120,6 +1469,14 @@ int policy_extend(qpol_policy_t * policy)
 		goto err;
 	}
 
+	if (policy->options & QPOL_POLICY_OPTION_SORTED_RULES) {
+		retv = qpol_policy_build_sorted_rule_table(policy);
+		if (retv) {
+			error = errno;
+			goto err;
+		}
+	}
+
 	return STATUS_SUCCESS;
 
       err:
@@ -1395,3 +1752,210 @@ int qpol_terule_get_syn_terule_iter(const qpol_policy_t * policy, const struct q
 	errno = error;
 	return -1;
 }
+
+/* at most one range per bit of the rule type mask */
+#define SORTED_RULE_STATE_MAX_RANGES 16
+
+typedef struct sorted_rule_state
+{
+	const qpol_sorted_rule_t *rules;
+	size_t start[SORTED_RULE_STATE_MAX_RANGES];
+	size_t stop[SORTED_RULE_STATE_MAX_RANGES];
+	size_t num_ranges;
+	size_t range;
+	size_t cur;
+} sorted_rule_state_t;
+
+/**
+ *  Find the first entry of a sorted rule array not less than the
+ *  given rule type and source.
+ *  @param rules Sorted array to search.
+ *  @param num Number of entries in the array.
+ *  @param specified Rule type of the key.
+ *  @param source Source type value of the key.
+ *  @return Index of the first entry at or after the key, or num if none.
+ */
+static size_t sorted_rule_lower_bound(const qpol_sorted_rule_t * rules, size_t num, uint32_t specified, uint32_t source)
+{
+	size_t lo = 0, hi = num, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (rules[mid].specified < specified || (rules[mid].specified == specified && rules[mid].source < source))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static int sorted_rule_state_end(const qpol_iterator_t * iter)
+{
+	sorted_rule_state_t *srs = NULL;
+
+	if (!iter || !(srs = qpol_iterator_state(iter))) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	return srs->range >= srs->num_ranges;
+}
+
+static void *sorted_rule_state_get_cur(const qpol_iterator_t * iter)
+{
+	sorted_rule_state_t *srs = NULL;
+
+	if (!iter || !(srs = qpol_iterator_state(iter)) || sorted_rule_state_end(iter)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	return srs->rules[srs->cur].node;
+}
+
+/**
+ *  Move a sorted rule state to its next entry, skipping to the start
+ *  of the next non-empty range as needed.
+ *  @param srs State to advance.
+ */
+static void sorted_rule_state_advance(sorted_rule_state_t * srs)
+{
+	if (++srs->cur < srs->stop[srs->range])
+		return;
+	while (++srs->range < srs->num_ranges) {
+		if (srs->start[srs->range] < srs->stop[srs->range]) {
+			srs->cur = srs->start[srs->range];
+			return;
+		}
+	}
+}
+
+static int sorted_rule_state_next(qpol_iterator_t * iter)
+{
+	sorted_rule_state_t *srs = NULL;
+
+	if (!iter || !(srs = qpol_iterator_state(iter))) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	if (sorted_rule_state_end(iter)) {
+		errno = ERANGE;
+		return STATUS_ERR;
+	}
+
+	sorted_rule_state_advance(srs);
+
+	return STATUS_SUCCESS;
+}
+
+static size_t sorted_rule_state_size(const qpol_iterator_t * iter)
+{
+	sorted_rule_state_t *srs = NULL;
+	size_t i, count = 0;
+
+	if (!iter || !(srs = qpol_iterator_state(iter))) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	for (i = 0; i < srs->num_ranges; i++)
+		count += srs->stop[i] - srs->start[i];
+
+	return count;
+}
+
+static int sorted_rule_state_next_batch(qpol_iterator_t * iter, void **out, size_t max)
+{
+	sorted_rule_state_t *srs = NULL;
+	size_t count = 0;
+
+	if (!iter || !(srs = qpol_iterator_state(iter)) || !out) {
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	if (max > INT_MAX)
+		max = INT_MAX;
+	while (count < max && srs->range < srs->num_ranges) {
+		size_t n = srs->stop[srs->range] - srs->cur;
+		if (n > max - count)
+			n = max - count;
+		for (; n > 0; n--)
+			out[count++] = srs->rules[srs->cur++].node;
+		if (srs->cur >= srs->stop[srs->range]) {
+			srs->cur--;
+			sorted_rule_state_advance(srs);
+		}
+	}
+
+	return (int)count;
+}
+
+int qpol_policy_get_sorted_rule_iter(const qpol_policy_t * policy, uint32_t rule_type_mask, uint32_t source_val,
+				     qpol_iterator_t ** iter)
+{
+	sorted_rule_state_t *srs = NULL;
+	const qpol_sorted_rule_t *rules;
+	size_t num, i;
+	uint32_t bit;
+	int error = 0;
+
+	if (iter)
+		*iter = NULL;
+
+	if (!policy || !iter) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	if (!policy->ext || !policy->ext->sorted_rules)
+		return STATUS_NODATA;
+
+	rules = policy->ext->sorted_rules;
+	num = policy->ext->num_sorted_rules;
+
+	if (!(srs = calloc(1, sizeof(sorted_rule_state_t)))) {
+		error = errno;
+		ERR(policy, "%s", strerror(error));
+		errno = error;
+		return STATUS_ERR;
+	}
+	srs->rules = rules;
+
+	/* the array is ordered by rule type then source, so each
+	 * requested rule type is one contiguous range */
+	for (i = 0; i < SORTED_RULE_STATE_MAX_RANGES; i++) {
+		bit = 1U << i;
+		if (!(rule_type_mask & bit))
+			continue;
+		if (source_val) {
+			srs->start[srs->num_ranges] = sorted_rule_lower_bound(rules, num, bit, source_val);
+			srs->stop[srs->num_ranges] = sorted_rule_lower_bound(rules, num, bit, source_val + 1);
+		} else {
+			srs->start[srs->num_ranges] = sorted_rule_lower_bound(rules, num, bit, 0);
+			srs->stop[srs->num_ranges] = sorted_rule_lower_bound(rules, num, bit + 1, 0);
+		}
+		srs->num_ranges++;
+	}
+	/* position on the first entry of the first non-empty range */
+	for (srs->range = 0; srs->range < srs->num_ranges; srs->range++) {
+		if (srs->start[srs->range] < srs->stop[srs->range])
+			break;
+	}
+	if (srs->range < srs->num_ranges)
+		srs->cur = srs->start[srs->range];
+
+	if (qpol_iterator_create(policy, (void *)srs,
+				 sorted_rule_state_get_cur, sorted_rule_state_next,
+				 sorted_rule_state_end, sorted_rule_state_size, free, iter)) {
+		error = errno;
+		free(srs);
+		errno = error;
+		return STATUS_ERR;
+	}
+	qpol_iterator_set_next_batch(*iter, sorted_rule_state_next_batch);
+
+	return STATUS_SUCCESS;
+}
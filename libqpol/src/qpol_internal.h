@@ -32,6 +32,7 @@ extern "C"
 
 #include <sepol/handle.h>
 #include <qpol/policy.h>
+#include <qpol/iterator.h>
 #include <stdio.h>
 
 #define STATUS_SUCCESS  0
@@ -53,6 +54,9 @@ extern "C"
 		int type;
 		struct sepol_policydb *p;
 		int enabled;
+		/** non-zero if the module is linked into its parent's
+		 *  current policy */
+		int linked;
 		struct qpol_policy *parent;
 	};
 
@@ -71,6 +75,22 @@ extern "C"
 		char *file_data;
 		size_t file_data_sz;
 		int file_data_type;
+		/** incremented whenever the enabled set of conditional
+		 *  rules may have changed */
+		unsigned int cond_seqno;
+		/** incremented whenever the policydb is replaced by a
+		 *  rebuild */
+		unsigned int rebuild_seqno;
+		/** image of the base module as read, before any linking;
+		 *  rebuilds link into a fresh copy read from this */
+		void *base_image;
+		size_t base_image_sz;
+		/** phases of work done upon the policy */
+		struct qpol_stats *stats;
+		/** while loading or rebuilding, the number of open phases
+		 *  within which each step of the load is a phase; 0
+		 *  otherwise */
+		size_t load_depth;
 	};
 /* qpol_policy_t.file_data_type will be one of the following to denote
  * the proper method of destroying the data:
@@ -81,6 +101,15 @@ extern "C"
 #define QPOL_POLICY_FILE_DATA_TYPE_MMAP 1
 #define QPOL_POLICY_FILE_DATA_TYPE_MEM  2
 
+/**
+ *  Begin the phase for a step of loading a policy, ending the phase of
+ *  the previous step.  Does nothing unless the policy is being loaded
+ *  or rebuilt.
+ *  @param policy The policy being loaded.
+ *  @param name Name of the step's phase; a string literal.
+ */
+	void qpol_policy_step(qpol_policy_t * policy, const char *name);
+
 /**
  *  Create an extended image for a policy. This function modifies the policydb
  *  by adding additional records and information about attributes, initial sids
@@ -93,6 +122,61 @@ extern "C"
  */
 	int policy_extend(qpol_policy_t * policy);
 
+/**
+ *  Add the memory used by a policy's extended image to the
+ *  QPOL_MEMORY_SYN_RULES and QPOL_MEMORY_RULE_INDEX categories.
+ *  @param policy The policy to measure.
+ *  @param usage Array of usage, indexed by qpol_memory_category_e, to
+ *  which to add.
+ */
+	void policy_extend_get_memory_usage(const qpol_policy_t * policy, qpol_memory_usage_t * usage);
+
+/**
+ *  Get an iterator over the policy's sorted rule snapshot (see
+ *  QPOL_POLICY_OPTION_SORTED_RULES).  Items are avtab nodes, so the
+ *  iterator may be returned as either an avrule or a terule iterator.
+ *  @param policy Policy whose snapshot to iterate.
+ *  @param rule_type_mask Bitwise or'ed set of rule types to return.
+ *  @param source_val If non-zero, only return rules whose source type
+ *  has this value.
+ *  @param iter Iterator over the selected rules returned.
+ *  @return 0 on success, STATUS_NODATA if the policy has no snapshot
+ *  (in which case *iter will be NULL and the caller should iterate
+ *  the avtab instead), and < 0 on failure; if the call fails, errno
+ *  will be set.
+ */
+	int qpol_policy_get_sorted_rule_iter(const qpol_policy_t * policy, uint32_t rule_type_mask, uint32_t source_val,
+					     qpol_iterator_t ** iter);
+
+	struct cond_node;
+
+/**
+ *  Get the distinct conditionals whose expressions reference any of
+ *  the given booleans, in the order they appear in the policy.
+ *  @param policy Policy whose boolean index to use.
+ *  @param bool_vals Array of boolean values (not indices).
+ *  @param num_vals Number of elements in bool_vals.
+ *  @param conds Reference to a newly allocated array of conditionals
+ *  returned.  The caller must free() the array but not its elements.
+ *  @param num_conds Number of elements in *conds returned.
+ *  @return 0 on success, STATUS_NODATA if the policy has no boolean
+ *  index (in which case *conds will be NULL and the caller should
+ *  consider every conditional), and < 0 on failure; if the call
+ *  fails, errno will be set.
+ */
+	int qpol_policy_get_bool_conds(const qpol_policy_t * policy, const uint32_t * bool_vals, size_t num_vals,
+				       struct cond_node ***conds, size_t * num_conds);
+
+/**
+ *  Evaluate a single conditional using the current boolean values
+ *  in the policy, then enable or disable its rules accordingly.
+ *  @param policy Policy containing the conditional.
+ *  @param cond Conditional to re-evaluate.
+ *  @return 0 on success, < 0 on failure; if the call fails, errno
+ *  will be set.
+ */
+	int qpol_policy_reevaluate_cond(qpol_policy_t * policy, struct cond_node *cond);
+
 	extern void qpol_handle_msg(const qpol_policy_t * policy, int level, const char *fmt, ...);
 	int qpol_is_file_binpol(FILE * fp);
 	int qpol_is_file_mod_pkg(FILE * fp);
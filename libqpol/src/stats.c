@@ -0,0 +1,297 @@
+/**
+ *  @file
+ *  Implementation of the interface for recording phases of work.
+ *
+ *  Copyright (C) 2010 Tresys Technology, LLC
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <qpol/stats.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+/** maximum number of phases open at once */
+#define QPOL_STATS_MAX_DEPTH 16
+/** number of finished phases kept */
+#define QPOL_STATS_MAX_PHASES 1024
+
+struct qpol_stats
+{
+	/** the thread that records into this object */
+	pthread_t owner;
+	struct timespec created;
+	/** open phases, outermost first */
+	qpol_stats_phase_t open[QPOL_STATS_MAX_DEPTH];
+	size_t depth;
+	/** ring of finished phases; the oldest is at first */
+	qpol_stats_phase_t phases[QPOL_STATS_MAX_PHASES];
+	size_t first, num_phases;
+	size_t totals[QPOL_STATS_NUM_COUNTERS];
+	qpol_stats_fn_t fn;
+	void *varg;
+};
+
+static const char *counter_names[QPOL_STATS_NUM_COUNTERS] = {
+	"scanned", "matched", "expanded", "hits", "misses"
+};
+
+static double stats_now_ms(const qpol_stats_t * stats)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - stats->created.tv_sec) * 1000.0 + (now.tv_nsec - stats->created.tv_nsec) / 1000000.0;
+}
+
+static long stats_peak_rss(void)
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) < 0) {
+		return -1;
+	}
+	return usage.ru_maxrss;
+}
+
+/**
+ *  Determine if the calling thread may record into a stats object.
+ */
+static int stats_is_recording(const qpol_stats_t * stats)
+{
+	return stats != NULL && pthread_equal(stats->owner, pthread_self());
+}
+
+qpol_stats_t *qpol_stats_create(void)
+{
+	qpol_stats_t *stats = calloc(1, sizeof(*stats));
+	if (stats == NULL) {
+		return NULL;
+	}
+	stats->owner = pthread_self();
+	clock_gettime(CLOCK_MONOTONIC, &stats->created);
+	return stats;
+}
+
+void qpol_stats_destroy(qpol_stats_t ** stats)
+{
+	if (stats != NULL && *stats != NULL) {
+		free(*stats);
+		*stats = NULL;
+	}
+}
+
+void qpol_stats_set_callback(qpol_stats_t * stats, qpol_stats_fn_t fn, void *varg)
+{
+	if (stats != NULL) {
+		stats->fn = fn;
+		stats->varg = varg;
+	}
+}
+
+int qpol_stats_begin(qpol_stats_t * stats, const char *name)
+{
+	qpol_stats_phase_t *phase;
+	if (!stats_is_recording(stats)) {
+		return 0;
+	}
+	if (name == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (stats->depth >= QPOL_STATS_MAX_DEPTH) {
+		errno = ERANGE;
+		return -1;
+	}
+	phase = stats->open + stats->depth;
+	memset(phase, 0, sizeof(*phase));
+	phase->name = name;
+	phase->depth = stats->depth;
+	phase->peak_rss_kb = stats_peak_rss();
+	phase->start_ms = stats_now_ms(stats);
+	stats->depth++;
+	return 0;
+}
+
+void qpol_stats_end(qpol_stats_t * stats)
+{
+	qpol_stats_phase_t *phase, *parent, *done;
+	size_t i;
+	long start_rss;
+	if (!stats_is_recording(stats) || stats->depth == 0) {
+		return;
+	}
+	stats->depth--;
+	phase = stats->open + stats->depth;
+	phase->elapsed_ms = stats_now_ms(stats) - phase->start_ms;
+	start_rss = phase->peak_rss_kb;
+	phase->peak_rss_kb = stats_peak_rss();
+	if (start_rss >= 0 && phase->peak_rss_kb >= 0) {
+		phase->peak_rss_growth_kb = phase->peak_rss_kb - start_rss;
+	}
+	if (stats->depth > 0) {
+		parent = phase - 1;
+		for (i = 0; i < QPOL_STATS_NUM_COUNTERS; i++) {
+			parent->counters[i] += phase->counters[i];
+		}
+	}
+
+	if (stats->num_phases < QPOL_STATS_MAX_PHASES) {
+		done = stats->phases + (stats->first + stats->num_phases) % QPOL_STATS_MAX_PHASES;
+		stats->num_phases++;
+	} else {
+		/* overwrite the oldest */
+		done = stats->phases + stats->first;
+		stats->first = (stats->first + 1) % QPOL_STATS_MAX_PHASES;
+	}
+	*done = *phase;
+	if (stats->fn != NULL) {
+		stats->fn(stats->varg, done);
+	}
+}
+
+void qpol_stats_end_to(qpol_stats_t * stats, size_t depth)
+{
+	while (stats_is_recording(stats) && stats->depth > depth) {
+		qpol_stats_end(stats);
+	}
+}
+
+size_t qpol_stats_get_depth(const qpol_stats_t * stats)
+{
+	if (stats == NULL) {
+		return 0;
+	}
+	return stats->depth;
+}
+
+void qpol_stats_add(qpol_stats_t * stats, qpol_stats_counter_e counter, size_t n)
+{
+	if (!stats_is_recording(stats) || counter < 0 || counter >= QPOL_STATS_NUM_COUNTERS) {
+		return;
+	}
+	stats->totals[counter] += n;
+	if (stats->depth > 0) {
+		stats->open[stats->depth - 1].counters[counter] += n;
+	}
+}
+
+size_t qpol_stats_get_total(const qpol_stats_t * stats, qpol_stats_counter_e counter)
+{
+	if (stats == NULL || counter < 0 || counter >= QPOL_STATS_NUM_COUNTERS) {
+		return 0;
+	}
+	return stats->totals[counter];
+}
+
+size_t qpol_stats_get_num_phases(const qpol_stats_t * stats)
+{
+	if (stats == NULL) {
+		return 0;
+	}
+	return stats->num_phases;
+}
+
+const qpol_stats_phase_t *qpol_stats_get_phase(const qpol_stats_t * stats, size_t i)
+{
+	if (stats == NULL || i >= stats->num_phases) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return stats->phases + (stats->first + i) % QPOL_STATS_MAX_PHASES;
+}
+
+void qpol_stats_clear(qpol_stats_t * stats)
+{
+	if (stats != NULL) {
+		stats->first = stats->num_phases = 0;
+		memset(stats->totals, 0, sizeof(stats->totals));
+	}
+}
+
+const char *qpol_stats_counter_get_name(qpol_stats_counter_e counter)
+{
+	if (counter < 0 || counter >= QPOL_STATS_NUM_COUNTERS) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return counter_names[counter];
+}
+
+static int stats_phase_comp(const void *a, const void *b)
+{
+	const qpol_stats_phase_t *p1 = *((const qpol_stats_phase_t * const *)a);
+	const qpol_stats_phase_t *p2 = *((const qpol_stats_phase_t * const *)b);
+	/* a phase starts no later than those nested within it */
+	if (p1->start_ms != p2->start_ms)
+		return (p1->start_ms < p2->start_ms ? -1 : 1);
+	if (p1->depth != p2->depth)
+		return (p1->depth < p2->depth ? -1 : 1);
+	return (p1 < p2 ? -1 : (p1 > p2 ? 1 : 0));
+}
+
+int qpol_stats_print(const qpol_stats_t * stats, const char *title, FILE * fp)
+{
+	const qpol_stats_phase_t **sorted = NULL;
+	size_t i, j, num;
+	int indent;
+
+	if (stats == NULL || fp == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	num = stats->num_phases;
+	if (num > 0 && (sorted = malloc(num * sizeof(*sorted))) == NULL) {
+		return -1;
+	}
+	for (i = 0; i < num; i++) {
+		sorted[i] = qpol_stats_get_phase(stats, i);
+	}
+	qsort(sorted, num, sizeof(*sorted), stats_phase_comp);
+
+	if (title != NULL) {
+		fprintf(fp, "\n%s\n", title);
+	}
+	fprintf(fp, "%-36s %12s %12s %12s", "phase", "start_ms", "elapsed_ms", "peak_rss_kb");
+	for (j = 0; j < QPOL_STATS_NUM_COUNTERS; j++) {
+		fprintf(fp, " %10s", counter_names[j]);
+	}
+	fprintf(fp, "\n");
+	for (i = 0; i < num; i++) {
+		indent = (int)(2 * sorted[i]->depth);
+		fprintf(fp, "%*s%-*s %12.3f %12.3f %12ld", indent, "", 36 - indent, sorted[i]->name, sorted[i]->start_ms,
+			sorted[i]->elapsed_ms, sorted[i]->peak_rss_kb);
+		for (j = 0; j < QPOL_STATS_NUM_COUNTERS; j++) {
+			fprintf(fp, " %10zu", sorted[i]->counters[j]);
+		}
+		fprintf(fp, "\n");
+	}
+	fprintf(fp, "%-36s %12s %12s %12ld", "total", "", "", stats_peak_rss());
+	for (j = 0; j < QPOL_STATS_NUM_COUNTERS; j++) {
+		fprintf(fp, " %10zu", stats->totals[j]);
+	}
+	fprintf(fp, "\n");
+	free(sorted);
+	if (ferror(fp)) {
+		errno = EIO;
+		return -1;
+	}
+	return 0;
+}
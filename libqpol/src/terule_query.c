@@ -33,10 +33,23 @@
 #include <stdlib.h>
 #include "qpol_internal.h"
 
-int qpol_policy_get_terule_iter(const qpol_policy_t * policy, uint32_t rule_type_mask, qpol_iterator_t ** iter)
+/**
+ *  Create an iterator over the terules of the given types, optionally
+ *  restricted to a single source type.  Uses the sorted rule snapshot
+ *  if the policy has one and walks the avtab otherwise.
+ *  @param policy Policy from which to get the rules.
+ *  @param rule_type_mask Bitwise or'ed set of rule types to return.
+ *  @param source_val If non-zero, only return rules with this source
+ *  type value.
+ *  @param iter Iterator over the rules returned.
+ *  @return 0 on success and < 0 on failure; if the call fails,
+ *  errno will be set and *iter will be NULL.
+ */
+static int terule_iter_create(const qpol_policy_t * policy, uint32_t rule_type_mask, uint32_t source_val, qpol_iterator_t ** iter)
 {
 	policydb_t *db;
 	avtab_state_t *state;
+	int retv;
 
 	if (iter) {
 		*iter = NULL;
@@ -55,6 +68,10 @@ int qpol_policy_get_terule_iter(const qpol_policy_t * policy, uint32_t rule_type
 	}
 #endif
 
+	retv = qpol_policy_get_sorted_rule_iter(policy, rule_type_mask, source_val, iter);
+	if (retv != STATUS_NODATA)
+		return retv;
+
 	db = &policy->p->p;
 
 	state = calloc(1, sizeof(avtab_state_t));
@@ -66,6 +83,7 @@ int qpol_policy_get_terule_iter(const qpol_policy_t * policy, uint32_t rule_type
 	state->ucond_tab = &db->te_avtab;
 	state->cond_tab = &db->te_cond_avtab;
 	state->rule_type_mask = rule_type_mask;
+	state->source_val = source_val;
 	state->node = db->te_avtab.htable[0];
 
 	if (qpol_iterator_create
@@ -73,12 +91,37 @@ int qpol_policy_get_terule_iter(const qpol_policy_t * policy, uint32_t rule_type
 		free(state);
 		return STATUS_ERR;
 	}
-	if (state->node == NULL || !(state->node->key.specified & state->rule_type_mask)) {
+	if (state->node == NULL || !avtab_state_match(state, state->node)) {
 		avtab_state_next(*iter);
 	}
 	return STATUS_SUCCESS;
 }
 
+int qpol_policy_get_terule_iter(const qpol_policy_t * policy, uint32_t rule_type_mask, qpol_iterator_t ** iter)
+{
+	return terule_iter_create(policy, rule_type_mask, 0, iter);
+}
+
+int qpol_policy_get_terule_iter_by_source(const qpol_policy_t * policy, uint32_t rule_type_mask, const qpol_type_t * source,
+					  qpol_iterator_t ** iter)
+{
+	uint32_t source_val;
+
+	if (iter) {
+		*iter = NULL;
+	}
+	if (policy == NULL || source == NULL || iter == NULL) {
+		ERR(policy, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return STATUS_ERR;
+	}
+
+	if (qpol_type_get_value(policy, source, &source_val) < 0) {
+		return STATUS_ERR;
+	}
+	return terule_iter_create(policy, rule_type_mask, source_val, iter);
+}
+
 int qpol_terule_get_source_type(const qpol_policy_t * policy, const qpol_terule_t * rule, const qpol_type_t ** source)
 {
 	policydb_t *db = NULL;
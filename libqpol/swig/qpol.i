@@ -310,6 +310,7 @@ typedef struct qpol_module {} qpol_module_t;
 #define QPOL_POLICY_OPTION_NO_NEVERALLOWS 0x00000001
 #define QPOL_POLICY_OPTION_NO_RULES       0x00000002
 #define QPOL_POLICY_OPTION_MATCH_SYSTEM   0x00000004
+#define QPOL_POLICY_OPTION_SORTED_RULES   0x00000008
 typedef struct qpol_policy {} qpol_policy_t;
 typedef void (*qpol_callback_fn_t) (void *varg, struct qpol_policy * policy, int level, const char *fmt, va_list va_args);
 #define QPOL_POLICY_UNKNOWN       -1
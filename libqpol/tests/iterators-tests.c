@@ -27,6 +27,7 @@
 
 #include <CUnit/CUnit.h>
 #include <qpol/policy.h>
+#include <qpol/policy_extend.h>
 #include <stdio.h>
 
 #define SOURCE_POLICY TEST_POLICIES "/snapshots/fc4_targeted.policy.conf"
@@ -65,9 +66,277 @@ static void iterators_alias(void)
 	qpol_iterator_destroy(&iter);
 }
 
+/**
+ * Walk two iterators over the same list, one item at a time and in
+ * small batches, and check that both yield identical sequences.
+ */
+static void iterators_check_batch(qpol_iterator_t * one, qpol_iterator_t * batched)
+{
+	void *items[7];
+	size_t one_size, batch_size, total = 0;
+	int i, num_items;
+
+	CU_ASSERT_FATAL(qpol_iterator_get_size(one, &one_size) == 0);
+	CU_ASSERT_FATAL(qpol_iterator_get_size(batched, &batch_size) == 0);
+	CU_ASSERT(one_size == batch_size);
+	while ((num_items = qpol_iterator_next_batch(batched, items, sizeof(items) / sizeof(items[0]))) > 0) {
+		for (i = 0; i < num_items; i++) {
+			void *v;
+			CU_ASSERT_FATAL(!qpol_iterator_end(one));
+			CU_ASSERT_FATAL(qpol_iterator_get_item(one, &v) == 0);
+			CU_ASSERT(v == items[i]);
+			CU_ASSERT_FATAL(qpol_iterator_next(one) == 0);
+			total++;
+		}
+	}
+	CU_ASSERT(num_items == 0);
+	CU_ASSERT(qpol_iterator_end(one));
+	CU_ASSERT(qpol_iterator_end(batched));
+	CU_ASSERT(total == one_size);
+}
+
+static void iterators_batch(void)
+{
+	qpol_policy_t *rule_qp = NULL;
+	qpol_iterator_t *one = NULL, *batched = NULL;
+	const qpol_role_t *role;
+
+	/* symbol table iterators */
+	CU_ASSERT_FATAL(qpol_policy_get_bool_iter(qp, &one) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_bool_iter(qp, &batched) == 0);
+	iterators_check_batch(one, batched);
+	qpol_iterator_destroy(&one);
+	qpol_iterator_destroy(&batched);
+
+	CU_ASSERT_FATAL(qpol_policy_get_type_iter(qp, &one) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_type_iter(qp, &batched) == 0);
+	iterators_check_batch(one, batched);
+	qpol_iterator_destroy(&one);
+	qpol_iterator_destroy(&batched);
+
+	/* bitmap iterators */
+	CU_ASSERT_FATAL(qpol_policy_get_role_by_name(qp, "system_r", &role) == 0);
+	CU_ASSERT_FATAL(qpol_role_get_type_iter(qp, role, &one) == 0);
+	CU_ASSERT_FATAL(qpol_role_get_type_iter(qp, role, &batched) == 0);
+	iterators_check_batch(one, batched);
+	qpol_iterator_destroy(&one);
+	qpol_iterator_destroy(&batched);
+
+	/* avtab iterators, both conditional and unconditional rules */
+	CU_ASSERT_FATAL(qpol_policy_open_from_file(SOURCE_POLICY, &rule_qp, NULL, NULL, QPOL_POLICY_OPTION_NO_NEVERALLOWS) >= 0);
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter(rule_qp, QPOL_RULE_ALLOW | QPOL_RULE_DONTAUDIT, &one) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter(rule_qp, QPOL_RULE_ALLOW | QPOL_RULE_DONTAUDIT, &batched) == 0);
+	iterators_check_batch(one, batched);
+	qpol_iterator_destroy(&one);
+	qpol_iterator_destroy(&batched);
+
+	CU_ASSERT_FATAL(qpol_policy_get_terule_iter(rule_qp, QPOL_RULE_TYPE_TRANS, &one) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_terule_iter(rule_qp, QPOL_RULE_TYPE_TRANS, &batched) == 0);
+	iterators_check_batch(one, batched);
+	qpol_iterator_destroy(&one);
+	qpol_iterator_destroy(&batched);
+	qpol_policy_destroy(&rule_qp);
+}
+
+/* Fill key with the rule type, source, target, and class values of an av rule. */
+static void iterators_avrule_key(qpol_policy_t * q, const qpol_avrule_t * rule, uint32_t key[4])
+{
+	const qpol_type_t *source, *target;
+	const qpol_class_t *obj_class;
+	CU_ASSERT_FATAL(qpol_avrule_get_rule_type(q, rule, key) == 0);
+	CU_ASSERT_FATAL(qpol_avrule_get_source_type(q, rule, &source) == 0);
+	CU_ASSERT_FATAL(qpol_avrule_get_target_type(q, rule, &target) == 0);
+	CU_ASSERT_FATAL(qpol_avrule_get_object_class(q, rule, &obj_class) == 0);
+	CU_ASSERT_FATAL(qpol_type_get_value(q, source, key + 1) == 0);
+	CU_ASSERT_FATAL(qpol_type_get_value(q, target, key + 2) == 0);
+	CU_ASSERT_FATAL(qpol_class_get_value(q, obj_class, key + 3) == 0);
+}
+
+/* Count the rules from an av rule iterator whose source has the given value. */
+static size_t iterators_count_source(qpol_policy_t * q, qpol_iterator_t * iter, uint32_t source_val)
+{
+	size_t count = 0;
+	uint32_t key[4];
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		void *v;
+		CU_ASSERT_FATAL(qpol_iterator_get_item(iter, &v) == 0);
+		iterators_avrule_key(q, v, key);
+		if (key[1] == source_val) {
+			count++;
+		}
+	}
+	return count;
+}
+
+static void iterators_sorted_rules(void)
+{
+	qpol_policy_t *plain_qp = NULL, *sorted_qp = NULL;
+	qpol_iterator_t *iter = NULL, *batched = NULL;
+	const uint32_t mask = QPOL_RULE_ALLOW | QPOL_RULE_DONTAUDIT;
+	size_t plain_size, sorted_size, count, n;
+	uint32_t key[4], prev[4] = { 0, 0, 0, 0 };
+	const qpol_type_t *source;
+	const char *source_name;
+	void *v;
+	int i;
+
+	CU_ASSERT_FATAL(qpol_policy_open_from_file(SOURCE_POLICY, &plain_qp, NULL, NULL, QPOL_POLICY_OPTION_NO_NEVERALLOWS) >= 0);
+	CU_ASSERT_FATAL(qpol_policy_open_from_file
+			(SOURCE_POLICY, &sorted_qp, NULL, NULL,
+			 QPOL_POLICY_OPTION_NO_NEVERALLOWS | QPOL_POLICY_OPTION_SORTED_RULES) >= 0);
+	CU_ASSERT(!qpol_policy_has_sorted_rule_table(plain_qp));
+	CU_ASSERT(qpol_policy_has_sorted_rule_table(sorted_qp));
+
+	/* the snapshot holds the same rules as the avtab */
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter(plain_qp, mask, &iter) == 0);
+	CU_ASSERT_FATAL(qpol_iterator_get_size(iter, &plain_size) == 0);
+	qpol_iterator_destroy(&iter);
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter(sorted_qp, mask, &iter) == 0);
+	CU_ASSERT_FATAL(qpol_iterator_get_size(iter, &sorted_size) == 0);
+	CU_ASSERT(plain_size == sorted_size);
+
+	/* and returns them ordered by rule type, source, target, class */
+	count = 0;
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		CU_ASSERT_FATAL(qpol_iterator_get_item(iter, &v) == 0);
+		iterators_avrule_key(sorted_qp, v, key);
+		i = 0;
+		while (i < 4 && key[i] == prev[i]) {
+			i++;
+		}
+		CU_ASSERT(i == 4 || key[i] > prev[i]);
+		prev[0] = key[0];
+		prev[1] = key[1];
+		prev[2] = key[2];
+		prev[3] = key[3];
+		count++;
+	}
+	CU_ASSERT(count == sorted_size);
+	qpol_iterator_destroy(&iter);
+
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter(sorted_qp, mask, &iter) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter(sorted_qp, mask, &batched) == 0);
+	iterators_check_batch(iter, batched);
+	qpol_iterator_destroy(&iter);
+	qpol_iterator_destroy(&batched);
+
+	/* source restricted iterators, with and without the snapshot,
+	 * using the source of an arbitrary rule */
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter(plain_qp, mask, &iter) == 0);
+	CU_ASSERT_FATAL(qpol_iterator_get_item(iter, &v) == 0);
+	CU_ASSERT_FATAL(qpol_avrule_get_source_type(plain_qp, v, &source) == 0);
+	CU_ASSERT_FATAL(qpol_type_get_name(plain_qp, source, &source_name) == 0);
+	CU_ASSERT_FATAL(qpol_type_get_value(plain_qp, source, key + 1) == 0);
+	count = iterators_count_source(plain_qp, iter, key[1]);
+	qpol_iterator_destroy(&iter);
+	CU_ASSERT(count > 0);
+
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter_by_source(plain_qp, mask, source, &iter) == 0);
+	CU_ASSERT_FATAL(qpol_iterator_get_size(iter, &n) == 0);
+	CU_ASSERT(n == count);
+	CU_ASSERT(iterators_count_source(plain_qp, iter, key[1]) == count);
+	qpol_iterator_destroy(&iter);
+
+	CU_ASSERT_FATAL(qpol_policy_get_type_by_name(sorted_qp, source_name, &source) == 0);
+	CU_ASSERT_FATAL(qpol_type_get_value(sorted_qp, source, key + 1) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter_by_source(sorted_qp, mask, source, &iter) == 0);
+	CU_ASSERT_FATAL(qpol_iterator_get_size(iter, &n) == 0);
+	CU_ASSERT(n == count);
+	CU_ASSERT(iterators_count_source(sorted_qp, iter, key[1]) == count);
+	qpol_iterator_destroy(&iter);
+
+	qpol_policy_destroy(&plain_qp);
+	qpol_policy_destroy(&sorted_qp);
+}
+
+/**
+ * Count the enabled conditional av rules within a policy.
+ */
+static size_t iterators_count_enabled(qpol_policy_t * q)
+{
+	qpol_iterator_t *iter = NULL;
+	size_t count = 0;
+	uint32_t is_enabled;
+	void *v;
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter(q, QPOL_RULE_ALLOW, &iter) == 0);
+	for (; !qpol_iterator_end(iter); qpol_iterator_next(iter)) {
+		CU_ASSERT_FATAL(qpol_iterator_get_item(iter, &v) == 0);
+		CU_ASSERT_FATAL(qpol_avrule_get_is_enabled(q, v, &is_enabled) == 0);
+		if (is_enabled)
+			count++;
+	}
+	qpol_iterator_destroy(&iter);
+	return count;
+}
+
+static void iterators_bool_what_if(void)
+{
+	qpol_policy_t *q = NULL;
+	qpol_iterator_t *bool_iter = NULL, *iter = NULL, *enabled = NULL, *disabled = NULL;
+	qpol_bool_t *b;
+	size_t num_conds, num_flipped, num_enabled, num_disabled, before, after;
+	int state, new_state;
+	void *v;
+
+	CU_ASSERT_FATAL(qpol_policy_open_from_file(SOURCE_POLICY, &q, NULL, NULL, QPOL_POLICY_OPTION_NO_NEVERALLOWS) >= 0);
+	CU_ASSERT_FATAL(qpol_policy_get_bool_iter(q, &bool_iter) == 0);
+	for (; !qpol_iterator_end(bool_iter); qpol_iterator_next(bool_iter)) {
+		CU_ASSERT_FATAL(qpol_iterator_get_item(bool_iter, &v) == 0);
+		b = (qpol_bool_t *) v;
+		CU_ASSERT_FATAL(qpol_bool_get_state(q, b, &state) == 0);
+		new_state = !state;
+
+		/* every conditional that would flip references the boolean */
+		CU_ASSERT_FATAL(qpol_bool_get_cond_iter(q, b, &iter) == 0);
+		CU_ASSERT_FATAL(qpol_iterator_get_size(iter, &num_conds) == 0);
+		qpol_iterator_destroy(&iter);
+		CU_ASSERT_FATAL(qpol_policy_get_what_if_cond_iter(q, &b, &new_state, 1, &iter) == 0);
+		CU_ASSERT_FATAL(qpol_iterator_get_size(iter, &num_flipped) == 0);
+		CU_ASSERT(num_flipped <= num_conds);
+
+		CU_ASSERT_FATAL(qpol_policy_get_what_if_av_iters(q, &b, &new_state, 1, QPOL_RULE_ALLOW, &enabled, &disabled) == 0);
+		CU_ASSERT_FATAL(qpol_iterator_get_size(enabled, &num_enabled) == 0);
+		CU_ASSERT_FATAL(qpol_iterator_get_size(disabled, &num_disabled) == 0);
+		qpol_iterator_destroy(&enabled);
+		qpol_iterator_destroy(&disabled);
+
+		/* the prediction must match what committing the change
+		 * actually does */
+		qpol_iterator_destroy(&iter);
+		before = iterators_count_enabled(q);
+		CU_ASSERT_FATAL(qpol_bool_set_state(q, b, new_state) == 0);
+		after = iterators_count_enabled(q);
+		CU_ASSERT(after + num_disabled == before + num_enabled);
+
+		/* afterwards the same change would flip nothing */
+		CU_ASSERT_FATAL(qpol_policy_get_what_if_cond_iter(q, &b, &new_state, 1, &iter) == 0);
+		CU_ASSERT_FATAL(qpol_iterator_get_size(iter, &num_flipped) == 0);
+		CU_ASSERT(num_flipped == 0);
+		qpol_iterator_destroy(&iter);
+
+		/* setting several booleans at once matches setting them
+		 * one by one */
+		CU_ASSERT_FATAL(qpol_bool_set_states(q, &b, &state, 1) == 0);
+		CU_ASSERT(iterators_count_enabled(q) == before);
+	}
+	qpol_iterator_destroy(&bool_iter);
+
+	/* a full re-evaluation agrees with the incremental ones */
+	before = iterators_count_enabled(q);
+	CU_ASSERT_FATAL(qpol_policy_reevaluate_conds(q) == 0);
+	CU_ASSERT(iterators_count_enabled(q) == before);
+	qpol_policy_destroy(&q);
+}
+
 CU_TestInfo iterators_tests[] = {
 	{"alias iterator", iterators_alias}
 	,
+	{"batch fetch", iterators_batch}
+	,
+	{"sorted rules", iterators_sorted_rules}
+	,
+	{"boolean what-if", iterators_bool_what_if}
+	,
 	CU_TEST_INFO_NULL
 };
 
@@ -26,13 +26,18 @@
 #include <config.h>
 
 #include <CUnit/CUnit.h>
+#include <qpol/avrule_query.h>
+#include <qpol/module.h>
 #include <qpol/policy.h>
 #include "../src/qpol_internal.h"
+#include <glob.h>
 #include <stdio.h>
 
 #define BROKEN_ALIAS_POLICY TEST_POLICIES "/setools-3.3/policy-features/broken-alias-mod.21"
 #define NOT_BROKEN_ALIAS_POLICY TEST_POLICIES "/setools-3.3/policy-features/not-broken-alias-mod.21"
 #define NOGENFS_POLICY TEST_POLICIES "/setools-3.3/policy-features/nogenfscon-policy.21"
+#define BASE_MODULE_POLICY TEST_POLICIES "/policy-versions/base-8.pp"
+#define MODULES_GLOB TEST_POLICIES "/setools-3.1/modules/*.pp"
 
 static void policy_features_alias_count(void *varg, const qpol_policy_t * policy
 					__attribute__ ((unused)), int level, const char *fmt, va_list va_args)
@@ -126,11 +131,221 @@ static void policy_features_nogenfscon_iter(void)
 	qpol_policy_destroy(&qp);
 }
 
+/** Test that a base module opened without any other modules is
+ *  linked and expanded, both when opened and when rebuilt. */
+static void policy_features_lone_base(void)
+{
+	qpol_policy_t *qp = NULL;
+	const qpol_type_t *type = NULL;
+	const char *name;
+
+	int policy_type = qpol_policy_open_from_file(BASE_MODULE_POLICY, &qp, NULL, NULL, QPOL_POLICY_OPTION_NO_NEVERALLOWS);
+	CU_ASSERT_FATAL(policy_type == QPOL_POLICY_MODULE_BINARY);
+	CU_ASSERT_FATAL(qpol_policy_get_type_by_name(qp, "root_t", &type) == 0);
+	CU_ASSERT_FATAL(qpol_type_get_name(qp, type, &name) == 0);
+	CU_ASSERT_STRING_EQUAL(name, "root_t");
+
+	/* a rebuild with nothing changed keeps the linked policy */
+	CU_ASSERT_FATAL(qpol_policy_rebuild(qp, QPOL_POLICY_OPTION_NO_NEVERALLOWS) == 0);
+	type = NULL;
+	CU_ASSERT(qpol_policy_get_type_by_name(qp, "root_t", &type) == 0 && type != NULL);
+	qpol_policy_destroy(&qp);
+}
+
+static size_t policy_features_count_avrules(const qpol_policy_t * qp)
+{
+	qpol_iterator_t *iter = NULL;
+	size_t n = 0;
+	CU_ASSERT_FATAL(qpol_policy_get_avrule_iter(qp, QPOL_RULE_ALLOW | QPOL_RULE_NEVERALLOW | QPOL_RULE_AUDITALLOW |
+						    QPOL_RULE_DONTAUDIT, &iter) == 0);
+	CU_ASSERT_FATAL(qpol_iterator_get_size(iter, &n) == 0);
+	qpol_iterator_destroy(&iter);
+	return n;
+}
+
+/** Return non-zero if every module's enabled flag matches whether it
+ *  is linked into the current policy. */
+static int policy_features_modules_linked(const qpol_policy_t * qp)
+{
+	size_t i;
+	for (i = 1; i < qp->num_modules; i++) {
+		if (!qp->modules[i]->enabled != !qp->modules[i]->linked) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/** Test that toggling modules relinks the policy only when the set
+ *  of enabled modules differs from the one already linked, and that
+ *  a failed rebuild leaves the linked flags describing the policy
+ *  that is still in place. */
+static void policy_features_module_toggle(void)
+{
+	qpol_policy_t *qp = NULL;
+	qpol_module_t *mod = NULL, *dup = NULL;
+	const char *path;
+	glob_t g;
+	size_t i, all_rules, chosen = 0;
+	unsigned int seqno, seqno2;
+	int type, base = -1;
+
+	CU_ASSERT_FATAL(glob(MODULES_GLOB, 0, NULL, &g) == 0);
+	for (i = 0; i < g.gl_pathc && base < 0; i++) {
+		CU_ASSERT_FATAL(qpol_module_create_from_file(g.gl_pathv[i], &mod) == 0);
+		CU_ASSERT_FATAL(qpol_module_get_type(mod, &type) == 0);
+		if (type == QPOL_MODULE_BASE) {
+			base = (int)i;
+		}
+		qpol_module_destroy(&mod);
+	}
+	CU_ASSERT_FATAL(base >= 0);
+	CU_ASSERT_FATAL(qpol_policy_open_from_file(g.gl_pathv[base], &qp, NULL, NULL, QPOL_POLICY_OPTION_NO_NEVERALLOWS) ==
+			QPOL_POLICY_MODULE_BINARY);
+	for (i = 0; i < g.gl_pathc; i++) {
+		if ((int)i == base) {
+			continue;
+		}
+		CU_ASSERT_FATAL(qpol_module_create_from_file(g.gl_pathv[i], &mod) == 0);
+		CU_ASSERT_FATAL(qpol_policy_append_module(qp, mod) == 0);
+		mod = NULL;
+	}
+	globfree(&g);
+	CU_ASSERT_FATAL(qp->num_modules > 1);
+	CU_ASSERT_FATAL(qpol_policy_rebuild(qp, QPOL_POLICY_OPTION_NO_NEVERALLOWS) == 0);
+	CU_ASSERT(policy_features_modules_linked(qp));
+	all_rules = policy_features_count_avrules(qp);
+
+	/* find a module whose rules disappear when it is disabled */
+	for (i = 1; i < qp->num_modules && chosen == 0; i++) {
+		CU_ASSERT_FATAL(qpol_module_set_enabled(qp->modules[i], 0) == 0);
+		CU_ASSERT_FATAL(qpol_policy_rebuild(qp, QPOL_POLICY_OPTION_NO_NEVERALLOWS) == 0);
+		CU_ASSERT(policy_features_modules_linked(qp));
+		CU_ASSERT(!qp->modules[i]->linked);
+		if (policy_features_count_avrules(qp) < all_rules) {
+			chosen = i;
+		}
+		/* enabling it again relinks and brings the rules back */
+		CU_ASSERT_FATAL(qpol_module_set_enabled(qp->modules[i], 1) == 0);
+		CU_ASSERT_FATAL(qpol_policy_rebuild(qp, QPOL_POLICY_OPTION_NO_NEVERALLOWS) == 0);
+		CU_ASSERT(policy_features_modules_linked(qp));
+		CU_ASSERT(policy_features_count_avrules(qp) == all_rules);
+	}
+	CU_ASSERT_FATAL(chosen > 0);
+
+	/* toggling a module off and on again before rebuilding does not
+	 * relink, and its rules are still there */
+	CU_ASSERT_FATAL(qpol_policy_get_rebuild_seqno(qp, &seqno) == 0);
+	CU_ASSERT_FATAL(qpol_module_set_enabled(qp->modules[chosen], 0) == 0);
+	CU_ASSERT_FATAL(qpol_module_set_enabled(qp->modules[chosen], 1) == 0);
+	CU_ASSERT_FATAL(qpol_policy_rebuild(qp, QPOL_POLICY_OPTION_NO_NEVERALLOWS) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_rebuild_seqno(qp, &seqno2) == 0);
+	CU_ASSERT(seqno2 == seqno);
+	CU_ASSERT(policy_features_count_avrules(qp) == all_rules);
+
+	/* a second copy of a module redeclares its symbols, so linking
+	 * fails and the previous policy stays in place */
+	CU_ASSERT_FATAL(qpol_module_get_path(qp->modules[chosen], &path) == 0);
+	CU_ASSERT_FATAL(qpol_module_create_from_file(path, &dup) == 0);
+	CU_ASSERT_FATAL(qpol_policy_append_module(qp, dup) == 0);
+	CU_ASSERT(qpol_policy_rebuild(qp, QPOL_POLICY_OPTION_NO_NEVERALLOWS) < 0);
+	CU_ASSERT_FATAL(qpol_policy_get_rebuild_seqno(qp, &seqno2) == 0);
+	CU_ASSERT(seqno2 == seqno);
+	CU_ASSERT(!dup->linked);
+	CU_ASSERT(policy_features_count_avrules(qp) == all_rules);
+
+	/* disabling the copy again matches the linked policy, so the
+	 * rebuild is skipped */
+	CU_ASSERT_FATAL(qpol_module_set_enabled(dup, 0) == 0);
+	CU_ASSERT_FATAL(qpol_policy_rebuild(qp, QPOL_POLICY_OPTION_NO_NEVERALLOWS) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_rebuild_seqno(qp, &seqno2) == 0);
+	CU_ASSERT(seqno2 == seqno);
+	CU_ASSERT(policy_features_modules_linked(qp));
+
+	/* and a real toggle after the failure relinks with the flags
+	 * following the new policy */
+	CU_ASSERT_FATAL(qpol_module_set_enabled(qp->modules[chosen], 0) == 0);
+	CU_ASSERT_FATAL(qpol_policy_rebuild(qp, QPOL_POLICY_OPTION_NO_NEVERALLOWS) == 0);
+	CU_ASSERT_FATAL(qpol_policy_get_rebuild_seqno(qp, &seqno2) == 0);
+	CU_ASSERT(seqno2 != seqno);
+	CU_ASSERT(policy_features_modules_linked(qp));
+	CU_ASSERT(policy_features_count_avrules(qp) < all_rules);
+	qpol_policy_destroy(&qp);
+}
+
+static void policy_features_count_phases(void *varg, const qpol_stats_phase_t * phase __attribute__ ((unused)))
+{
+	size_t *num_ended = (size_t *) varg;
+	(*num_ended)++;
+}
+
+/** Test that loading a policy records its phases, and that counts
+ *  made within a nested phase are added to the enclosing one. */
+static void policy_features_stats(void)
+{
+	qpol_policy_t *qp = NULL;
+	qpol_stats_t *stats;
+	const qpol_stats_phase_t *phase;
+	size_t num_ended = 0, num_phases;
+
+	int policy_type = qpol_policy_open_from_file(NOGENFS_POLICY, &qp, NULL, NULL, QPOL_POLICY_OPTION_NO_RULES);
+	CU_ASSERT_FATAL(policy_type == QPOL_POLICY_KERNEL_BINARY);
+	stats = qpol_policy_get_stats(qp);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(stats);
+	CU_ASSERT(qpol_stats_get_depth(stats) == 0);
+
+	/* the whole load ends last, after the steps nested within it */
+	num_phases = qpol_stats_get_num_phases(stats);
+	CU_ASSERT_FATAL(num_phases > 1);
+	phase = qpol_stats_get_phase(stats, num_phases - 1);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(phase);
+	CU_ASSERT_STRING_EQUAL(phase->name, "load");
+	CU_ASSERT(phase->depth == 0);
+	CU_ASSERT(phase->elapsed_ms >= 0);
+	phase = qpol_stats_get_phase(stats, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(phase);
+	CU_ASSERT_STRING_EQUAL(phase->name, "read");
+	CU_ASSERT(phase->depth == 1);
+	CU_ASSERT_PTR_NULL(qpol_stats_get_phase(stats, num_phases));
+
+	qpol_stats_clear(stats);
+	CU_ASSERT(qpol_stats_get_num_phases(stats) == 0);
+	qpol_stats_set_callback(stats, policy_features_count_phases, &num_ended);
+	CU_ASSERT(qpol_stats_begin(stats, "outer") == 0);
+	qpol_stats_add(stats, QPOL_STATS_RULES_SCANNED, 3);
+	CU_ASSERT(qpol_stats_begin(stats, "inner") == 0);
+	qpol_stats_add(stats, QPOL_STATS_RULES_SCANNED, 2);
+	qpol_stats_add(stats, QPOL_STATS_CACHE_HITS, 1);
+	CU_ASSERT(qpol_stats_get_depth(stats) == 2);
+	qpol_stats_end_to(stats, 0);
+	CU_ASSERT(num_ended == 2);
+	CU_ASSERT(qpol_stats_get_num_phases(stats) == 2);
+	phase = qpol_stats_get_phase(stats, 0);
+	CU_ASSERT_STRING_EQUAL(phase->name, "inner");
+	CU_ASSERT(phase->counters[QPOL_STATS_RULES_SCANNED] == 2);
+	phase = qpol_stats_get_phase(stats, 1);
+	CU_ASSERT_STRING_EQUAL(phase->name, "outer");
+	CU_ASSERT(phase->counters[QPOL_STATS_RULES_SCANNED] == 5);
+	CU_ASSERT(phase->counters[QPOL_STATS_CACHE_HITS] == 1);
+	CU_ASSERT(qpol_stats_get_total(stats, QPOL_STATS_RULES_SCANNED) == 5);
+
+	/* ending with nothing open does nothing */
+	qpol_stats_end(stats);
+	CU_ASSERT(qpol_stats_get_num_phases(stats) == 2);
+	qpol_policy_destroy(&qp);
+}
+
 CU_TestInfo policy_features_tests[] = {
 	{"invalid alias", policy_features_invalid_alias}
 	,
 	{"No genfscon", policy_features_nogenfscon_iter}
 	,
+	{"phase stats", policy_features_stats}
+	,
+	{"lone base module", policy_features_lone_base}
+	,
+	{"module toggling", policy_features_module_toggle}
+	,
 	CU_TEST_INFO_NULL
 };
 
@@ -27,6 +27,7 @@
 #ifndef SEAUDIT_AVC_MESSAGE_H
 #define SEAUDIT_AVC_MESSAGE_H
 
+#include <apol/policy.h>
 #include <apol/vector.h>
 
 #ifdef  __cplusplus
@@ -367,6 +368,21 @@ extern "C"
  */
 	extern int seaudit_avc_message_get_cap(const seaudit_avc_message_t * avc);
 
+/**
+ * Determine if a policy allows all of the permissions named by an
+ * avc message, as computed by apol_compute_av().  This takes into
+ * account the policy's current boolean values, type bounds, and
+ * constraints.  Permissive domains do not count as allowing.
+ *
+ * @param avc AVC message to check.
+ * @param policy Policy to check against.  It must have rules loaded.
+ *
+ * @return 1 if every permission is allowed, 0 if any is not, or < 0
+ * upon error (including if the message's contexts, class, or
+ * permissions do not exist within the policy).
+ */
+	extern int seaudit_avc_message_is_allowed(const seaudit_avc_message_t * avc, apol_policy_t * policy);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -0,0 +1,117 @@
+/**
+ *  @file
+ *  Public interface for following an audit log file as it grows.  A
+ *  follower remembers how much of the file it has read, so that it
+ *  only parses newly appended lines.  It notices when the file is
+ *  rotated (renamed away and replaced) or truncated, and then
+ *  reopens it from the beginning.  Where the system supports inotify
+ *  the follower also provides a file descriptor that becomes
+ *  readable whenever the file may have changed, so that callers need
+ *  not poll.
+ *
+ *  Copyright (C) 2003-2007 Tresys Technology, LLC
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SEAUDIT_FOLLOW_H
+#define SEAUDIT_FOLLOW_H
+
+#ifdef  __cplusplus
+extern "C"
+{
+#endif
+
+#include "log.h"
+#include <stdlib.h>
+
+	typedef struct seaudit_follower seaudit_follower_t;
+
+/**
+ * Create a follower that appends messages from a log file into a
+ * seaudit log.  Nothing is read until seaudit_follower_read() or
+ * seaudit_follower_wait() is called.
+ *
+ * @param log Audit log to which append messages.  The follower does
+ * not take ownership of the log; it must remain valid for the
+ * lifetime of the follower.
+ * @param path Path to the log file.  The file need not exist yet.
+ * @param offset Number of bytes at the start of the file that have
+ * already been parsed (e.g., by seaudit_log_parse()).  Pass 0 to
+ * parse the entire file.
+ *
+ * @return A newly allocated follower, or NULL upon error.  The caller
+ * must call seaudit_follower_destroy() afterwards.
+ */
+	extern seaudit_follower_t *seaudit_follower_create(seaudit_log_t * log, const char *path, size_t offset);
+
+/**
+ * Close the file being followed and free all memory used by the
+ * follower.  This does not destroy the follower's log.
+ *
+ * @param follower Reference to a follower to destroy.  The pointer
+ * will be set to NULL afterwards.
+ */
+	extern void seaudit_follower_destroy(seaudit_follower_t ** follower);
+
+/**
+ * Get a file descriptor that becomes readable when the followed file
+ * may have changed.  Callers may add this descriptor to their own
+ * select() or poll() loop (or main loop), and then call
+ * seaudit_follower_read() when it is readable.  Do not read from or
+ * close the descriptor.
+ *
+ * @param follower Follower to query.
+ *
+ * @return A file descriptor, or -1 if the system cannot notify of
+ * changes.  In the latter case callers must instead call
+ * seaudit_follower_read() periodically.
+ */
+	extern int seaudit_follower_get_fd(const seaudit_follower_t * follower);
+
+/**
+ * Parse all complete lines appended to the followed file since the
+ * last read.  If the file was truncated then parse it from the
+ * beginning.  If the path now names a different file (i.e., the log
+ * was rotated) then finish reading the old file and then parse the
+ * new one from the beginning.  Models watching the log are notified
+ * only if messages were added.  This function does not block.
+ *
+ * @param follower Follower to read.
+ *
+ * @return Number of messages (including malformed ones) added to the
+ * log, or < 0 on error.
+ */
+	extern int seaudit_follower_read(seaudit_follower_t * follower);
+
+/**
+ * Wait until the followed file may have changed, or until a timeout
+ * expires, and then call seaudit_follower_read().
+ *
+ * @param follower Follower to read.
+ * @param timeout Maximum number of milliseconds to wait, or a
+ * negative value to wait indefinitely.  If the system cannot notify
+ * of changes then this function always sleeps for the full timeout,
+ * or for one second if the timeout is negative.
+ *
+ * @return Number of messages added to the log, or < 0 on error.
+ */
+	extern int seaudit_follower_wait(seaudit_follower_t * follower, int timeout);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
@@ -25,6 +25,8 @@
 
 #include "seaudit_internal.h"
 
+#include <apol/compute-av.h>
+#include <apol/mls_range.h>
 #include <apol/util.h>
 
 #include <errno.h>
@@ -340,6 +342,80 @@ int seaudit_avc_message_get_cap(const seaudit_avc_message_t * avc)
 	return avc->capability;
 }
 
+/**
+ * Build a context from one side of an avc message.
+ */
+static apol_context_t *avc_message_get_context(apol_policy_t * policy, const char *user, const char *role, const char *type,
+					       const char *mls_lvl, const char *mls_clr)
+{
+	apol_context_t *context = NULL;
+	apol_mls_range_t *range = NULL;
+	char *range_str = NULL;
+	int error = 0;
+
+	if ((context = apol_context_create()) == NULL || apol_context_set_user(policy, context, user) < 0 ||
+	    apol_context_set_role(policy, context, role) < 0 || apol_context_set_type(policy, context, type) < 0) {
+		error = errno;
+		goto err;
+	}
+	if (apol_policy_is_mls(policy) && mls_lvl != NULL) {
+		if (mls_clr != NULL) {
+			if (asprintf(&range_str, "%s-%s", mls_lvl, mls_clr) < 0) {
+				range_str = NULL;
+				error = errno;
+				goto err;
+			}
+		} else if ((range_str = strdup(mls_lvl)) == NULL) {
+			error = errno;
+			goto err;
+		}
+		if ((range = apol_mls_range_create_from_string(policy, range_str)) == NULL ||
+		    apol_context_set_range(policy, context, range) < 0) {
+			error = errno;
+			apol_mls_range_destroy(&range);
+			goto err;
+		}
+	}
+	free(range_str);
+	return context;
+      err:
+	free(range_str);
+	apol_context_destroy(&context);
+	errno = error;
+	return NULL;
+}
+
+int seaudit_avc_message_is_allowed(const seaudit_avc_message_t * avc, apol_policy_t * policy)
+{
+	apol_context_t *scontext = NULL, *tcontext = NULL;
+	apol_av_decision_t avd;
+	uint32_t requested;
+	int retval = -1, error = 0;
+
+	if (avc == NULL || policy == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (avc->suser == NULL || avc->srole == NULL || avc->stype == NULL || avc->tuser == NULL || avc->trole == NULL ||
+	    avc->ttype == NULL || avc->tclass == NULL || avc->perms == NULL) {
+		errno = ENOENT;
+		return -1;
+	}
+	if ((scontext = avc_message_get_context(policy, avc->suser, avc->srole, avc->stype, avc->smls_lvl, avc->smls_clr)) == NULL ||
+	    (tcontext = avc_message_get_context(policy, avc->tuser, avc->trole, avc->ttype, avc->tmls_lvl, avc->tmls_clr)) == NULL ||
+	    apol_class_perms_to_av(policy, avc->tclass, avc->perms, &requested) < 0 ||
+	    apol_compute_av(policy, scontext, tcontext, avc->tclass, &avd) < 0) {
+		error = errno;
+		goto cleanup;
+	}
+	retval = ((avd.allowed & requested) == requested);
+      cleanup:
+	apol_context_destroy(&scontext);
+	apol_context_destroy(&tcontext);
+	errno = error;
+	return retval;
+}
+
 /******************** protected functions below ********************/
 
 seaudit_avc_message_t *avc_message_create(void)
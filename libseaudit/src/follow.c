@@ -0,0 +1,419 @@
+/**
+ *  @file
+ *  Implementation of following an audit log file as it grows.
+ *
+ *  Copyright (C) 2003-2007 Tresys Technology, LLC
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include "seaudit_internal.h"
+
+#include <seaudit/follow.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+/** number of bytes to read from the file at a time */
+#define FOLLOW_READ_SIZE 65536
+/** milliseconds to sleep while waiting, if inotify is unavailable */
+#define FOLLOW_POLL_INTERVAL 1000
+
+struct seaudit_follower
+{
+	seaudit_log_t *log;
+	/** path to the log file */
+	char *path;
+	/** descriptor of the file being followed, or -1 if the path
+	 *  did not exist when last checked */
+	int fd;
+	/** identity of the file open on fd */
+	dev_t dev;
+	ino_t ino;
+	/** number of bytes read from the file so far */
+	off_t offset;
+	/** trailing bytes that do not yet form a complete line */
+	char *partial;
+	size_t partial_len, partial_size;
+	/** inotify instance, or -1 if unavailable */
+	int notify_fd;
+	/** inotify watches upon the open file and upon its directory */
+	int file_wd, dir_wd;
+};
+
+/**
+ * Append bytes read from the file to the partial line buffer, then
+ * parse every complete line within it.
+ *
+ * @return 0 on success, > 0 on warnings, < 0 on error.
+ */
+static int follow_consume(seaudit_follower_t * f, const char *buf, size_t len)
+{
+	char *line, *nl;
+	size_t remaining;
+	int retval, has_warnings = 0;
+	if (f->partial_len + len + 1 > f->partial_size) {
+		size_t new_size = (f->partial_size == 0 ? FOLLOW_READ_SIZE : f->partial_size);
+		char *p;
+		while (new_size < f->partial_len + len + 1) {
+			new_size *= 2;
+		}
+		if ((p = realloc(f->partial, new_size)) == NULL) {
+			ERR(f->log, "%s", strerror(errno));
+			return -1;
+		}
+		f->partial = p;
+		f->partial_size = new_size;
+	}
+	memcpy(f->partial + f->partial_len, buf, len);
+	f->partial_len += len;
+
+	line = f->partial;
+	remaining = f->partial_len;
+	while ((nl = memchr(line, '\n', remaining)) != NULL) {
+		*nl = '\0';
+		remaining -= (nl + 1 - line);
+		if ((retval = log_parse_line(f->log, line)) < 0) {
+			return -1;
+		} else if (retval > 0) {
+			has_warnings = 1;
+		}
+		line = nl + 1;
+	}
+	memmove(f->partial, line, remaining);
+	f->partial_len = remaining;
+	return has_warnings;
+}
+
+/**
+ * Parse whatever remains in the partial line buffer as a final line;
+ * this is done when the file is about to be closed.
+ *
+ * @return 0 on success, > 0 on warnings, < 0 on error.
+ */
+static int follow_flush(seaudit_follower_t * f)
+{
+	int retval = 0;
+	if (f->partial_len > 0) {
+		f->partial[f->partial_len] = '\0';
+		retval = log_parse_line(f->log, f->partial);
+		f->partial_len = 0;
+	}
+	return retval;
+}
+
+/**
+ * Read from the open file until its end, parsing complete lines.
+ *
+ * @return 0 on success, > 0 on warnings, < 0 on error.
+ */
+static int follow_drain(seaudit_follower_t * f)
+{
+	char buf[FOLLOW_READ_SIZE];
+	ssize_t len;
+	int retval, has_warnings = 0;
+	while (1) {
+		len = read(f->fd, buf, sizeof(buf));
+		if (len < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			ERR(f->log, "%s: %s", f->path, strerror(errno));
+			return -1;
+		}
+		if (len == 0) {
+			break;
+		}
+		f->offset += len;
+		if ((retval = follow_consume(f, buf, (size_t) len)) < 0) {
+			return -1;
+		} else if (retval > 0) {
+			has_warnings = 1;
+		}
+	}
+	return has_warnings;
+}
+
+static void follow_close(seaudit_follower_t * f)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+	if (f->notify_fd >= 0 && f->file_wd >= 0) {
+		inotify_rm_watch(f->notify_fd, f->file_wd);
+	}
+#endif
+	f->file_wd = -1;
+	if (f->fd >= 0) {
+		close(f->fd);
+	}
+	f->fd = -1;
+	f->offset = 0;
+	f->partial_len = 0;
+}
+
+/**
+ * Open the file currently named by the follower's path.  If no such
+ * file exists then leave the follower without a file.
+ *
+ * @return 0 on success (even if the file does not exist), < 0 on
+ * error.
+ */
+static int follow_open(seaudit_follower_t * f)
+{
+	struct stat sb;
+	int error;
+	assert(f->fd < 0);
+	if ((f->fd = open(f->path, O_RDONLY)) < 0) {
+		if (errno == ENOENT) {
+			return 0;
+		}
+		error = errno;
+		ERR(f->log, "%s: %s", f->path, strerror(error));
+		errno = error;
+		return -1;
+	}
+	if (fstat(f->fd, &sb) < 0) {
+		error = errno;
+		ERR(f->log, "%s: %s", f->path, strerror(error));
+		close(f->fd);
+		f->fd = -1;
+		errno = error;
+		return -1;
+	}
+	f->dev = sb.st_dev;
+	f->ino = sb.st_ino;
+	f->offset = 0;
+#ifdef HAVE_SYS_INOTIFY_H
+	if (f->notify_fd >= 0) {
+		/* failure to watch the file is not fatal, for the
+		 * directory watch and periodic reads still work */
+		f->file_wd = inotify_add_watch(f->notify_fd, f->path, IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF | IN_ATTRIB);
+	}
+#endif
+	return 0;
+}
+
+seaudit_follower_t *seaudit_follower_create(seaudit_log_t * log, const char *path, size_t offset)
+{
+	seaudit_follower_t *f = NULL;
+	int error = 0;
+	if (log == NULL || path == NULL || path[0] == '\0') {
+		ERR(log, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((f = calloc(1, sizeof(*f))) == NULL || (f->path = strdup(path)) == NULL) {
+		error = errno;
+		ERR(log, "%s", strerror(error));
+		goto err;
+	}
+	f->log = log;
+	f->fd = f->notify_fd = f->file_wd = f->dir_wd = -1;
+#ifdef HAVE_SYS_INOTIFY_H
+	if ((f->notify_fd = inotify_init()) >= 0) {
+		char *dir, *slash;
+		fcntl(f->notify_fd, F_SETFL, fcntl(f->notify_fd, F_GETFL) | O_NONBLOCK);
+		fcntl(f->notify_fd, F_SETFD, FD_CLOEXEC);
+		/* watch the directory, to learn when a rotated log's
+		 * replacement is created */
+		if ((dir = strdup(path)) == NULL) {
+			error = errno;
+			ERR(log, "%s", strerror(error));
+			goto err;
+		}
+		if ((slash = strrchr(dir, '/')) == NULL) {
+			strcpy(dir, ".");
+		} else if (slash == dir) {
+			slash[1] = '\0';
+		} else {
+			*slash = '\0';
+		}
+		f->dir_wd = inotify_add_watch(f->notify_fd, dir, IN_CREATE | IN_MOVED_TO);
+		free(dir);
+	}
+#endif
+	if (follow_open(f) < 0) {
+		error = errno;
+		goto err;
+	}
+	if (f->fd >= 0 && offset > 0) {
+		struct stat sb;
+		/* if the file shrank since it was parsed then it was
+		 * truncated, so start over */
+		if (fstat(f->fd, &sb) == 0 && (off_t) offset <= sb.st_size && lseek(f->fd, (off_t) offset, SEEK_SET) >= 0) {
+			f->offset = (off_t) offset;
+		}
+	}
+	return f;
+      err:
+	seaudit_follower_destroy(&f);
+	errno = error;
+	return NULL;
+}
+
+void seaudit_follower_destroy(seaudit_follower_t ** follower)
+{
+	if (follower == NULL || *follower == NULL) {
+		return;
+	}
+	follow_close(*follower);
+	if ((*follower)->notify_fd >= 0) {
+		close((*follower)->notify_fd);
+	}
+	free((*follower)->path);
+	free((*follower)->partial);
+	free(*follower);
+	*follower = NULL;
+}
+
+int seaudit_follower_get_fd(const seaudit_follower_t * follower)
+{
+	if (follower == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	return follower->notify_fd;
+}
+
+/**
+ * Discard pending inotify events.  They only signal that something
+ * may have changed; the follower determines what changed by
+ * examining the file itself.
+ */
+static void follow_clear_events(seaudit_follower_t * f)
+{
+	char buf[4096];
+	if (f->notify_fd < 0) {
+		return;
+	}
+	while (read(f->notify_fd, buf, sizeof(buf)) > 0) ;
+}
+
+int seaudit_follower_read(seaudit_follower_t * follower)
+{
+	seaudit_follower_t *f = follower;
+	struct stat sb;
+	size_t before, after, i;
+	int retval, has_warnings = 0, error = 0;
+	if (f == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	follow_clear_events(f);
+	before = apol_vector_get_size(f->log->messages) + apol_vector_get_size(f->log->malformed_msgs);
+
+	if (f->fd >= 0) {
+		if (fstat(f->fd, &sb) < 0) {
+			error = errno;
+			ERR(f->log, "%s: %s", f->path, strerror(error));
+			goto err;
+		}
+		if ((size_t) sb.st_size < f->offset) {
+			INFO(f->log, "%s was truncated; reading it from the beginning.", f->path);
+			if (lseek(f->fd, 0, SEEK_SET) < 0) {
+				error = errno;
+				ERR(f->log, "%s: %s", f->path, strerror(error));
+				goto err;
+			}
+			f->offset = 0;
+			f->partial_len = 0;
+		}
+		if ((retval = follow_drain(f)) < 0) {
+			error = errno;
+			goto err;
+		} else if (retval > 0) {
+			has_warnings = 1;
+		}
+	}
+
+	/* if the path now names some other file, then the log was
+	 * rotated; the old file has been read to its end above */
+	if (stat(f->path, &sb) == 0 && (f->fd < 0 || sb.st_dev != f->dev || sb.st_ino != f->ino)) {
+		if (f->fd >= 0) {
+			INFO(f->log, "%s was rotated; reading the new file.", f->path);
+			if ((retval = follow_flush(f)) < 0) {
+				error = errno;
+				goto err;
+			} else if (retval > 0) {
+				has_warnings = 1;
+			}
+			follow_close(f);
+		}
+		if (follow_open(f) < 0) {
+			error = errno;
+			goto err;
+		}
+		if (f->fd >= 0) {
+			if ((retval = follow_drain(f)) < 0) {
+				error = errno;
+				goto err;
+			} else if (retval > 0) {
+				has_warnings = 1;
+			}
+		}
+	}
+
+	after = apol_vector_get_size(f->log->messages) + apol_vector_get_size(f->log->malformed_msgs);
+	if (after > before) {
+		for (i = 0; i < apol_vector_get_size(f->log->models); i++) {
+			seaudit_model_t *m = apol_vector_get_element(f->log->models, i);
+			model_notify_log_changed(m, f->log);
+		}
+	}
+	if (has_warnings) {
+		WARN(f->log, "%s", "Audit log was parsed, but there were one or more invalid message found within it.");
+	}
+	return (int)(after - before);
+      err:
+	/* messages parsed before the error are still in the log */
+	for (i = 0; i < apol_vector_get_size(f->log->models); i++) {
+		seaudit_model_t *m = apol_vector_get_element(f->log->models, i);
+		model_notify_log_changed(m, f->log);
+	}
+	errno = error;
+	return -1;
+}
+
+int seaudit_follower_wait(seaudit_follower_t * follower, int timeout)
+{
+	if (follower == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (follower->notify_fd >= 0) {
+		struct pollfd pfd;
+		pfd.fd = follower->notify_fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, timeout) < 0 && errno != EINTR) {
+			ERR(follower->log, "%s", strerror(errno));
+			return -1;
+		}
+	} else {
+		poll(NULL, 0, (timeout < 0 ? FOLLOW_POLL_INTERVAL : timeout));
+	}
+	return seaudit_follower_read(follower);
+}
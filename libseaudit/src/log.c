@@ -45,16 +45,16 @@ seaudit_log_t *seaudit_log_create(seaudit_handle_fn_t fn, void *callback_arg)
 	if ((log->messages = apol_vector_create(message_free)) == NULL ||
 	    (log->malformed_msgs = apol_vector_create(free)) == NULL ||
 	    (log->models = apol_vector_create(NULL)) == NULL ||
-	    (log->types = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->classes = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->roles = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->users = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->perms = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->mls_lvl = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->mls_clr = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->hosts = apol_bst_create(apol_str_strcmp, free)) == NULL
-	    || (log->bools = apol_bst_create(apol_str_strcmp, free)) == NULL
-	    || (log->managers = apol_bst_create(apol_str_strcmp, free)) == NULL) {
+	    (log->types = apol_strpool_create()) == NULL ||
+	    (log->classes = apol_strpool_create()) == NULL ||
+	    (log->roles = apol_strpool_create()) == NULL ||
+	    (log->users = apol_strpool_create()) == NULL ||
+	    (log->perms = apol_strpool_create()) == NULL ||
+	    (log->mls_lvl = apol_strpool_create()) == NULL ||
+	    (log->mls_clr = apol_strpool_create()) == NULL ||
+	    (log->hosts = apol_strpool_create()) == NULL
+	    || (log->bools = apol_strpool_create()) == NULL
+	    || (log->managers = apol_strpool_create()) == NULL) {
 		error = errno;
 		seaudit_log_destroy(&log);
 		errno = error;
@@ -76,16 +76,16 @@ void seaudit_log_destroy(seaudit_log_t ** log)
 	apol_vector_destroy(&(*log)->messages);
 	apol_vector_destroy(&(*log)->malformed_msgs);
 	apol_vector_destroy(&(*log)->models);
-	apol_bst_destroy(&(*log)->types);
-	apol_bst_destroy(&(*log)->classes);
-	apol_bst_destroy(&(*log)->roles);
-	apol_bst_destroy(&(*log)->users);
-	apol_bst_destroy(&(*log)->perms);
-	apol_bst_destroy(&(*log)->hosts);
-	apol_bst_destroy(&(*log)->bools);
-	apol_bst_destroy(&(*log)->managers);
-	apol_bst_destroy(&(*log)->mls_lvl);
-	apol_bst_destroy(&(*log)->mls_clr);
+	apol_strpool_destroy(&(*log)->types);
+	apol_strpool_destroy(&(*log)->classes);
+	apol_strpool_destroy(&(*log)->roles);
+	apol_strpool_destroy(&(*log)->users);
+	apol_strpool_destroy(&(*log)->perms);
+	apol_strpool_destroy(&(*log)->hosts);
+	apol_strpool_destroy(&(*log)->bools);
+	apol_strpool_destroy(&(*log)->managers);
+	apol_strpool_destroy(&(*log)->mls_lvl);
+	apol_strpool_destroy(&(*log)->mls_clr);
 	free(*log);
 	*log = NULL;
 }
@@ -98,28 +98,28 @@ void seaudit_log_clear(seaudit_log_t * log)
 	}
 	apol_vector_destroy(&log->messages);
 	apol_vector_destroy(&log->malformed_msgs);
-	apol_bst_destroy(&log->types);
-	apol_bst_destroy(&log->classes);
-	apol_bst_destroy(&log->roles);
-	apol_bst_destroy(&log->users);
-	apol_bst_destroy(&log->perms);
-	apol_bst_destroy(&log->hosts);
-	apol_bst_destroy(&log->bools);
-	apol_bst_destroy(&log->managers);
-	apol_bst_destroy(&log->mls_lvl);
-	apol_bst_destroy(&log->mls_clr);
+	apol_strpool_destroy(&log->types);
+	apol_strpool_destroy(&log->classes);
+	apol_strpool_destroy(&log->roles);
+	apol_strpool_destroy(&log->users);
+	apol_strpool_destroy(&log->perms);
+	apol_strpool_destroy(&log->hosts);
+	apol_strpool_destroy(&log->bools);
+	apol_strpool_destroy(&log->managers);
+	apol_strpool_destroy(&log->mls_lvl);
+	apol_strpool_destroy(&log->mls_clr);
 	if ((log->messages = apol_vector_create(message_free)) == NULL ||
 	    (log->malformed_msgs = apol_vector_create(free)) == NULL ||
-	    (log->types = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->classes = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->roles = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->users = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->perms = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->mls_lvl = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->mls_clr = apol_bst_create(apol_str_strcmp, free)) == NULL ||
-	    (log->hosts = apol_bst_create(apol_str_strcmp, free)) == NULL
-	    || (log->bools = apol_bst_create(apol_str_strcmp, free)) == NULL
-	    || (log->managers = apol_bst_create(apol_str_strcmp, free)) == NULL) {
+	    (log->types = apol_strpool_create()) == NULL ||
+	    (log->classes = apol_strpool_create()) == NULL ||
+	    (log->roles = apol_strpool_create()) == NULL ||
+	    (log->users = apol_strpool_create()) == NULL ||
+	    (log->perms = apol_strpool_create()) == NULL ||
+	    (log->mls_lvl = apol_strpool_create()) == NULL ||
+	    (log->mls_clr = apol_strpool_create()) == NULL ||
+	    (log->hosts = apol_strpool_create()) == NULL
+	    || (log->bools = apol_strpool_create()) == NULL
+	    || (log->managers = apol_strpool_create()) == NULL) {
 		/* hopefully will never get here... */
 		return;
 	}
@@ -135,7 +135,7 @@ apol_vector_t *seaudit_log_get_users(const seaudit_log_t * log)
 		errno = EINVAL;
 		return NULL;
 	}
-	return apol_bst_get_vector(log->users, 0);
+	return apol_strpool_get_vector(log->users);
 }
 
 apol_vector_t *seaudit_log_get_roles(const seaudit_log_t * log)
@@ -144,7 +144,7 @@ apol_vector_t *seaudit_log_get_roles(const seaudit_log_t * log)
 		errno = EINVAL;
 		return NULL;
 	}
-	return apol_bst_get_vector(log->roles, 0);
+	return apol_strpool_get_vector(log->roles);
 }
 
 apol_vector_t *seaudit_log_get_types(const seaudit_log_t * log)
@@ -153,7 +153,7 @@ apol_vector_t *seaudit_log_get_types(const seaudit_log_t * log)
 		errno = EINVAL;
 		return NULL;
 	}
-	return apol_bst_get_vector(log->types, 0);
+	return apol_strpool_get_vector(log->types);
 }
 
 apol_vector_t *seaudit_log_get_mls_lvl(const seaudit_log_t * log)
@@ -162,7 +162,7 @@ apol_vector_t *seaudit_log_get_mls_lvl(const seaudit_log_t * log)
 		errno = EINVAL;
 		return NULL;
 	}
-	return apol_bst_get_vector(log->mls_lvl, 0);
+	return apol_strpool_get_vector(log->mls_lvl);
 }
 
 apol_vector_t *seaudit_log_get_mls_clr(const seaudit_log_t * log)
@@ -171,7 +171,7 @@ apol_vector_t *seaudit_log_get_mls_clr(const seaudit_log_t * log)
 		errno = EINVAL;
 		return NULL;
 	}
-	return apol_bst_get_vector(log->mls_clr, 0);
+	return apol_strpool_get_vector(log->mls_clr);
 }
 
 apol_vector_t *seaudit_log_get_classes(const seaudit_log_t * log)
@@ -180,7 +180,7 @@ apol_vector_t *seaudit_log_get_classes(const seaudit_log_t * log)
 		errno = EINVAL;
 		return NULL;
 	}
-	return apol_bst_get_vector(log->classes, 0);
+	return apol_strpool_get_vector(log->classes);
 }
 
 /******************** protected functions below ********************/
@@ -191,8 +191,8 @@ static int model_sort(const seaudit_log_t * log, seaudit_model_t * model)
 			goto cleanup;
 		}
 	}
-	apol_vector_sort(sup, message_comp, model);
-	if (apol_vector_cat(sup, unsup) < 0) {
+	/* a stable sort keeps messages that compare equal in log order */
+	if (apol_vector_sort_parallel(sup, message_comp, model, 0) < 0 || apol_vector_cat(sup, unsup) < 0) {
 		error = errno;
 		ERR(log, "%s", strerror(error));
 		goto cleanup;
@@ -180,7 +180,7 @@ static int insert_hostname(const seaudit_log_t * log, const apol_vector_t * toke
 		return 1;
 	}
 	(*position)++;
-	if ((host = strdup(s)) == NULL || apol_bst_insert_and_get(log->hosts, (void **)&host, NULL) < 0) {
+	if (apol_strpool_insert(log->hosts, s, &host) < 0) {
 		int error = errno;
 		ERR(log, "%s", strerror(error));
 		errno = error;
@@ -209,7 +209,7 @@ static int insert_standard_msg_header(const seaudit_log_t * log, const apol_vect
 static int insert_manager(const seaudit_log_t * log, seaudit_message_t * msg, const char *manager)
 {
 	char *m;
-	if ((m = strdup(manager)) == NULL || apol_bst_insert_and_get(log->managers, (void **)&m, NULL) < 0) {
+	if (apol_strpool_insert(log->managers, manager, &m) < 0) {
 		int error = errno;
 		ERR(log, "%s", strerror(error));
 		errno = error;
@@ -236,7 +236,7 @@ static int parse_context(seaudit_log_t * log, char *token, char **user, char **r
 		goto out;
 	}
 
-	if ((s = strdup(context_user_get(con))) == NULL || apol_bst_insert_and_get(log->users, (void **)&s, NULL) < 0) {
+	if (apol_strpool_insert(log->users, context_user_get(con), &s) < 0) {
 		error = errno;
 		ERR(log, "%s", strerror(error));
 		errno = error;
@@ -245,7 +245,7 @@ static int parse_context(seaudit_log_t * log, char *token, char **user, char **r
 	}
 	*user = s;
 
-	if ((s = strdup(context_role_get(con))) == NULL || apol_bst_insert_and_get(log->roles, (void **)&s, NULL) < 0) {
+	if (apol_strpool_insert(log->roles, context_role_get(con), &s) < 0) {
 		error = errno;
 		ERR(log, "%s", strerror(error));
 		errno = error;
@@ -254,7 +254,7 @@ static int parse_context(seaudit_log_t * log, char *token, char **user, char **r
 	}
 	*role = s;
 
-	if ((s = strdup(context_type_get(con))) == NULL || apol_bst_insert_and_get(log->types, (void **)&s, NULL) < 0) {
+	if (apol_strpool_insert(log->types, context_type_get(con), &s) < 0) {
 		error = errno;
 		ERR(log, "%s", strerror(error));
 		errno = error;
@@ -271,7 +271,7 @@ static int parse_context(seaudit_log_t * log, char *token, char **user, char **r
 			/* level and clearance are the same */
 			clr = lvl;
 
-		if ((s = strdup(lvl)) == NULL || apol_bst_insert_and_get(log->mls_lvl, (void **)&s, NULL) < 0) {
+		if (apol_strpool_insert(log->mls_lvl, lvl, &s) < 0) {
 			error = errno;
 			ERR(log, "%s", strerror(error));
 			errno = error;
@@ -280,7 +280,7 @@ static int parse_context(seaudit_log_t * log, char *token, char **user, char **r
 		}
 		*mls_lvl = s;
 
-		if ((s = strdup(clr)) == NULL || apol_bst_insert_and_get(log->mls_clr, (void **)&s, NULL) < 0) {
+		if (apol_strpool_insert(log->mls_clr, clr, &s) < 0) {
 			error = errno;
 			ERR(log, "%s", strerror(error));
 			errno = error;
@@ -354,8 +354,7 @@ static int avc_msg_insert_perms(const seaudit_log_t * log, apol_vector_t * token
 			return 0;
 		}
 
-		if ((perm = strdup(s)) == NULL ||
-		    apol_bst_insert_and_get(log->perms, (void **)&perm, NULL) < 0 || apol_vector_append(avc->perms, perm) < 0) {
+		if (apol_strpool_insert(log->perms, s, &perm) < 0 || apol_vector_append(avc->perms, perm) < 0) {
 			error = errno;
 			ERR(log, "%s", strerror(error));
 			errno = error;
@@ -479,7 +478,7 @@ static int avc_msg_insert_tcon(seaudit_log_t * log, seaudit_avc_message_t * avc,
 static int avc_msg_insert_tclass(seaudit_log_t * log, seaudit_avc_message_t * avc, const char *tmp)
 {
 	char *tclass;
-	if ((tclass = strdup(tmp)) == NULL || apol_bst_insert_and_get(log->classes, (void **)&tclass, NULL) < 0) {
+	if (apol_strpool_insert(log->classes, tmp, &tclass) < 0) {
 		int error = errno;
 		ERR(log, "%s", strerror(error));
 		errno = error;
@@ -1447,6 +1446,16 @@ int seaudit_log_parse(seaudit_log_t * log, FILE * syslog)
 	return has_warnings;
 }
 
+int log_parse_line(seaudit_log_t * log, char *line)
+{
+	if (!log->tz_initialized) {
+		tzset();
+		log->tz_initialized = 1;
+	}
+	apol_str_trim(line);
+	return seaudit_log_parse_line(log, line);
+}
+
 int seaudit_log_parse_buffer(seaudit_log_t * log, const char *buffer, const size_t bufsize)
 {
 	const char *s;
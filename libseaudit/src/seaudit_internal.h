@@ -38,6 +38,7 @@
 #include <seaudit/sort.h>
 
 #include <apol/bst.h>
+#include <apol/strpool.h>
 #include <apol/vector.h>
 
 #include <libxml/uri.h>
@@ -55,9 +56,10 @@ struct seaudit_log
 	apol_vector_t *malformed_msgs;
 	/** vector of seaudit_model_t that are watching this log */
 	apol_vector_t *models;
-	apol_bst_t *types, *classes, *roles, *users;
-	apol_bst_t *perms, *hosts, *bools, *managers;
-	apol_bst_t *mls_lvl, *mls_clr;
+	/** pools of strings referenced by this log's messages */
+	apol_strpool_t *types, *classes, *roles, *users;
+	apol_strpool_t *perms, *hosts, *bools, *managers;
+	apol_strpool_t *mls_lvl, *mls_clr;
 	seaudit_log_type_e logtype;
 	seaudit_handle_fn_t fn;
 	void *handle_arg;
@@ -67,6 +69,17 @@ struct seaudit_log
 	int next_line;
 };
 
+/**
+ * Parse a single line from an audit log into a log, without
+ * notifying the log's models.  The line may be modified.
+ *
+ * @param log Audit log to which append messages.
+ * @param line Nul-terminated line to parse.
+ *
+ * @return 0 on success, > 0 on warnings, < 0 on error.
+ */
+int log_parse_line(seaudit_log_t * log, char *line);
+
 /**
  * Notify a log that model is now watching it.
  *
@@ -223,7 +236,7 @@ struct seaudit_avc_message
 	long tm_stmp_nano;
 	/** audit header serial number */
 	unsigned int serial;
-	/** pointers into log->perms BST (hence char *) */
+	/** pointers into log->perms pool (hence char *) */
 	apol_vector_t *perms;
 	/** key for an IPC call */
 	int key;
@@ -0,0 +1,247 @@
+/**
+ *  @file
+ *
+ *  Test libseaudit's ability to follow a log file as it grows, is
+ *  rotated, and is truncated.
+ *
+ *  Copyright (C) 2007 Tresys Technology, LLC
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <CUnit/CUnit.h>
+#include <seaudit/follow.h>
+#include <seaudit/log.h>
+#include <seaudit/model.h>
+#include <seaudit/parse.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FOLLOW_LOG TEST_POLICIES "/setools-3.0/seaudit/messages-FC5"
+
+/** contents of FOLLOW_LOG */
+static char *log_data = NULL;
+static size_t log_size = 0;
+
+/** temporary file that is written to and followed */
+static char follow_path[] = "/tmp/seaudit-follow-XXXXXX";
+static char *rotate_path = NULL;
+
+/**
+ * Count the messages, including malformed ones, within a log.
+ */
+static size_t follow_count(seaudit_log_t * l)
+{
+	seaudit_model_t *m = seaudit_model_create(NULL, l);
+	apol_vector_t *v;
+	size_t count;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(m);
+	v = seaudit_model_get_messages(l, m);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	count = apol_vector_get_size(v);
+	apol_vector_destroy(&v);
+	v = seaudit_model_get_malformed_messages(l, m);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	count += apol_vector_get_size(v);
+	apol_vector_destroy(&v);
+	seaudit_model_destroy(&m);
+	return count;
+}
+
+/**
+ * Count the messages that result from parsing the first len bytes of
+ * the test log in one pass.
+ */
+static size_t follow_expected(size_t len)
+{
+	seaudit_log_t *l = seaudit_log_create(NULL, NULL);
+	size_t count;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(l);
+	CU_ASSERT(seaudit_log_parse_buffer(l, log_data, len) >= 0);
+	count = follow_count(l);
+	seaudit_log_destroy(&l);
+	return count;
+}
+
+static void follow_write(const char *path, const char *mode, const char *data, size_t len)
+{
+	FILE *f = fopen(path, mode);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	CU_ASSERT(fwrite(data, 1, len, f) == len);
+	fclose(f);
+}
+
+/**
+ * Return the length of the test log's first half, rounded up to the
+ * end of a line.
+ */
+static size_t follow_half(void)
+{
+	char *nl = memchr(log_data + log_size / 2, '\n', log_size - log_size / 2);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(nl);
+	return nl - log_data + 1;
+}
+
+static void follow_append()
+{
+	seaudit_log_t *l = seaudit_log_create(NULL, NULL);
+	seaudit_follower_t *f;
+	/* split in the middle of a line, which must not be parsed until
+	 * it is completed */
+	size_t split = log_size / 2, total;
+	int first, second;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(l);
+	follow_write(follow_path, "w", "", 0);
+	f = seaudit_follower_create(l, follow_path, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	CU_ASSERT(seaudit_follower_read(f) == 0);
+
+	follow_write(follow_path, "a", log_data, split);
+	first = seaudit_follower_read(f);
+	CU_ASSERT(first > 0);
+	CU_ASSERT(seaudit_follower_read(f) == 0);
+	follow_write(follow_path, "a", log_data + split, log_size - split);
+	second = seaudit_follower_read(f);
+	CU_ASSERT(second > 0);
+
+	total = follow_expected(log_size);
+	CU_ASSERT((size_t) (first + second) == total);
+	CU_ASSERT(follow_count(l) == total);
+	seaudit_follower_destroy(&f);
+	CU_ASSERT_PTR_NULL(f);
+	seaudit_log_destroy(&l);
+}
+
+static void follow_offset()
+{
+	seaudit_log_t *l = seaudit_log_create(NULL, NULL);
+	seaudit_follower_t *f;
+	size_t half = follow_half();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(l);
+	follow_write(follow_path, "w", log_data, log_size);
+	/* pretend that the first half was already parsed elsewhere */
+	f = seaudit_follower_create(l, follow_path, half);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	CU_ASSERT(seaudit_follower_read(f) > 0);
+	CU_ASSERT(follow_count(l) < follow_expected(log_size));
+	seaudit_follower_destroy(&f);
+	seaudit_log_destroy(&l);
+}
+
+static void follow_rotate()
+{
+	seaudit_log_t *l = seaudit_log_create(NULL, NULL);
+	seaudit_follower_t *f;
+	size_t total = follow_expected(log_size);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(l);
+	follow_write(follow_path, "w", log_data, log_size);
+	f = seaudit_follower_create(l, follow_path, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	CU_ASSERT(seaudit_follower_read(f) == (int)total);
+
+	/* move the old file away and start a new one in its place */
+	CU_ASSERT(rename(follow_path, rotate_path) == 0);
+	CU_ASSERT(seaudit_follower_read(f) == 0);
+	follow_write(follow_path, "w", log_data, log_size);
+	CU_ASSERT(seaudit_follower_read(f) == (int)total);
+	CU_ASSERT(follow_count(l) == total * 2);
+	unlink(rotate_path);
+
+	seaudit_follower_destroy(&f);
+	seaudit_log_destroy(&l);
+}
+
+static void follow_truncate()
+{
+	seaudit_log_t *l = seaudit_log_create(NULL, NULL);
+	seaudit_follower_t *f;
+	size_t half = follow_half();
+	size_t total = follow_expected(log_size);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(l);
+	follow_write(follow_path, "w", log_data, log_size);
+	f = seaudit_follower_create(l, follow_path, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	CU_ASSERT(seaudit_follower_read(f) == (int)total);
+
+	/* rewrite the same file with less data than was already read */
+	follow_write(follow_path, "w", log_data, half);
+	CU_ASSERT(seaudit_follower_read(f) == (int)follow_expected(half));
+
+	seaudit_follower_destroy(&f);
+	seaudit_log_destroy(&l);
+}
+
+static void follow_wait()
+{
+	seaudit_log_t *l = seaudit_log_create(NULL, NULL);
+	seaudit_follower_t *f;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(l);
+	follow_write(follow_path, "w", "", 0);
+	f = seaudit_follower_create(l, follow_path, 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	CU_ASSERT(seaudit_follower_wait(f, 0) == 0);
+	follow_write(follow_path, "a", log_data, log_size);
+	CU_ASSERT(seaudit_follower_wait(f, 5000) == (int)follow_expected(log_size));
+	seaudit_follower_destroy(&f);
+	seaudit_log_destroy(&l);
+}
+
+CU_TestInfo follow_tests[] = {
+	{"append", follow_append},
+	{"start offset", follow_offset},
+	{"rotate", follow_rotate},
+	{"truncate", follow_truncate},
+	{"wait", follow_wait},
+	CU_TEST_INFO_NULL
+};
+
+int follow_init()
+{
+	FILE *f;
+	int fd;
+	if ((f = fopen(FOLLOW_LOG, "r")) == NULL) {
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	log_size = ftell(f);
+	rewind(f);
+	if ((log_data = malloc(log_size)) == NULL || fread(log_data, 1, log_size, f) != log_size) {
+		fclose(f);
+		return 1;
+	}
+	fclose(f);
+	if ((fd = mkstemp(follow_path)) < 0) {
+		return 1;
+	}
+	close(fd);
+	if (asprintf(&rotate_path, "%s.1", follow_path) < 0) {
+		rotate_path = NULL;
+		return 1;
+	}
+	return 0;
+}
+
+int follow_cleanup()
+{
+	unlink(follow_path);
+	free(rotate_path);
+	free(log_data);
+	return 0;
+}
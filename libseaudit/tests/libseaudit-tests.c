@@ -29,7 +29,9 @@
 #include <CUnit/Basic.h>
 
 #include "filters.h"
+#include "follow.h"
 #include "parse_file.h"
+#include "verdict.h"
 
 int main(void)
 {
@@ -42,6 +44,10 @@ int main(void)
 		,
 		{"Filters", filters_init, filters_cleanup, filters_tests}
 		,
+		{"Follow", follow_init, follow_cleanup, follow_tests}
+		,
+		{"Verdict", verdict_init, verdict_cleanup, verdict_tests}
+		,
 		CU_SUITE_INFO_NULL
 	};
 
@@ -0,0 +1,125 @@
+/**
+ *  @file
+ *
+ *  Test whether a policy allows the permissions named by AVC
+ *  messages.
+ *
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <CUnit/CUnit.h>
+#include <apol/policy.h>
+#include <apol/policy-path.h>
+#include <seaudit/avc_message.h>
+#include <seaudit/log.h>
+#include <seaudit/message.h>
+#include <seaudit/model.h>
+#include <seaudit/parse.h>
+
+#include <string.h>
+
+#define POLICY TEST_POLICIES "/snapshots/fc4_targeted.policy.conf"
+
+/* one message per verdict: the targeted policy lets unconfined_t
+ * read etc_t files, never grants a file type access to anything, and
+ * does not have a no_such_t type at all */
+static const char log_lines[] =
+	"Jun  1 12:00:00 host kernel: audit(1149163200.000:1): avc:  granted  { read } for  pid=1 comm=\"cat\" "
+	"name=\"motd\" dev=hda1 ino=2 scontext=system_u:system_r:unconfined_t tcontext=system_u:object_r:etc_t tclass=file\n"
+	"Jun  1 12:00:01 host kernel: audit(1149163201.000:2): avc:  denied  { write } for  pid=1 comm=\"cat\" "
+	"name=\"shadow\" dev=hda1 ino=3 scontext=system_u:object_r:etc_t tcontext=system_u:object_r:shadow_t tclass=file\n"
+	"Jun  1 12:00:02 host kernel: audit(1149163202.000:3): avc:  denied  { read } for  pid=1 comm=\"cat\" "
+	"name=\"motd\" dev=hda1 ino=2 scontext=system_u:system_r:no_such_t tcontext=system_u:object_r:etc_t tclass=file\n";
+
+static apol_policy_t *p = NULL;
+static seaudit_log_t *l = NULL;
+static seaudit_model_t *m = NULL;
+
+/**
+ * Find the AVC message whose source type is stype.
+ */
+static const seaudit_avc_message_t *verdict_get_message(const apol_vector_t * v, const char *stype)
+{
+	size_t i;
+	for (i = 0; i < apol_vector_get_size(v); i++) {
+		seaudit_message_t *msg = apol_vector_get_element(v, i);
+		seaudit_message_type_e type;
+		seaudit_avc_message_t *avc = seaudit_message_get_data(msg, &type);
+		if (type == SEAUDIT_MESSAGE_TYPE_AVC && strcmp(seaudit_avc_message_get_source_type(avc), stype) == 0) {
+			return avc;
+		}
+	}
+	return NULL;
+}
+
+static void verdict_is_allowed(void)
+{
+	apol_vector_t *v = seaudit_model_get_messages(l, m);
+	const seaudit_avc_message_t *avc;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	CU_ASSERT_EQUAL(apol_vector_get_size(v), 3);
+
+	avc = verdict_get_message(v, "unconfined_t");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(avc);
+	CU_ASSERT_EQUAL(seaudit_avc_message_is_allowed(avc, p), 1);
+
+	avc = verdict_get_message(v, "etc_t");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(avc);
+	CU_ASSERT_EQUAL(seaudit_avc_message_is_allowed(avc, p), 0);
+
+	avc = verdict_get_message(v, "no_such_t");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(avc);
+	CU_ASSERT(seaudit_avc_message_is_allowed(avc, p) < 0);
+
+	CU_ASSERT(seaudit_avc_message_is_allowed(avc, NULL) < 0);
+	apol_vector_destroy(&v);
+}
+
+CU_TestInfo verdict_tests[] = {
+	{"is allowed", verdict_is_allowed},
+	CU_TEST_INFO_NULL
+};
+
+int verdict_init()
+{
+	apol_policy_path_t *ppath = apol_policy_path_create(APOL_POLICY_PATH_TYPE_MONOLITHIC, POLICY, NULL);
+	if (ppath == NULL) {
+		return 1;
+	}
+	if ((p = apol_policy_create_from_policy_path(ppath, QPOL_POLICY_OPTION_NO_NEVERALLOWS, NULL, NULL)) == NULL) {
+		apol_policy_path_destroy(&ppath);
+		return 1;
+	}
+	apol_policy_path_destroy(&ppath);
+
+	if ((l = seaudit_log_create(NULL, NULL)) == NULL || (m = seaudit_model_create("verdict", l)) == NULL) {
+		return 1;
+	}
+	if (seaudit_log_parse_buffer(l, log_lines, strlen(log_lines)) != 0) {
+		return 1;
+	}
+	return 0;
+}
+
+int verdict_cleanup()
+{
+	seaudit_model_destroy(&m);
+	seaudit_log_destroy(&l);
+	apol_policy_destroy(&p);
+	return 0;
+}
@@ -134,6 +134,24 @@ class sefs_db:public sefs_fclist
 	 */
 	void save(const char *filename) throw(std::invalid_argument, std::runtime_error);
 
+	/**
+	 * Bring the database up to date with the filesystem \a fs,
+	 * which should be rooted at the same directory from which
+	 * the database was built.  Only entries whose inode, device,
+	 * or timestamps differ from those stored are re-read from
+	 * the filesystem, and entries that no longer exist are
+	 * removed.  If the database was loaded from a file, then the
+	 * file is modified in place; there is no need to call save()
+	 * afterwards.  The update is done within a single
+	 * transaction, so upon error the database is unchanged.
+	 * @param fs Filesystem from which to update.
+	 * @exception std::invalid_argument No filesystem given, or
+	 * the filesystem and database differ in their use of MLS.
+	 * @exception std::runtime_error Error while reading the
+	 * filesystem or writing the database.
+	 */
+	void update(sefs_filesystem * fs) throw(std::invalid_argument, std::runtime_error);
+
 	/**
 	 * Get the creation time of a sefs database.
 	 * @return Creation time of the database, or 0 on error.
@@ -155,6 +173,23 @@ class sefs_db:public sefs_fclist
 	 */
 	void upgradeToDB2() throw(std::runtime_error);
 
+	/**
+	 * Upgrade an existing version 2 database to version 3, by
+	 * adding indexes upon the paths table.  If the database
+	 * cannot be written then warn and continue without them.
+	 *
+	 * @return True if the database is now version 3, false if
+	 * the upgrade failed and was rolled back.
+	 */
+	bool upgradeToDB3();
+
+	/**
+	 * Upgrade an existing version 3 database to version 4, by
+	 * adding file timestamps to the paths table.  If the database
+	 * cannot be written then warn and continue without them.
+	 */
+	void upgradeToDB4();
+
 	const struct sefs_context_node *getContextNode(const sefs_entry * entry);
 	sefs_entry *getEntry(const struct sefs_context_node *context, uint32_t objectClass, const char *path, ino64_t inode,
 			     const char *dev) throw(std::bad_alloc);
@@ -192,6 +227,12 @@ extern "C"
  */
 	extern int sefs_db_save(sefs_db_t * db, const char *filename);
 
+/**
+ * Bring a database up to date with a filesystem.
+ * @see sefs_db::update()
+ */
+	extern int sefs_db_update(sefs_db_t * db, sefs_filesystem_t * fs);
+
 /**
  * Get the creation time of a sefs database.
  * @see sefs_db::getCTime()
@@ -27,15 +27,18 @@
 #include <config.h>
 
 #include "sefs_internal.hh"
+#include "new_ftw.h"
 
 #include <sefs/db.hh>
 #include <sefs/filesystem.hh>
 #include <sefs/entry.hh>
 #include <apol/util.h>
 
+#include <selinux/context.h>
 #include <sqlite3.h>
 
 #include <assert.h>
+#include <ctype.h>
 #include <errno.h>
 #include <string.h>
 #include <time.h>
@@ -43,19 +46,30 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
-#define DB_MAX_VERSION "2"
+#define DB_MAX_VERSION "4"
 
 #define DB_SCHEMA_NONMLS \
 	"CREATE TABLE users (user_id INTEGER PRIMARY KEY, user_name varchar (24));" \
 	"CREATE TABLE roles (role_id INTEGER PRIMARY KEY, role_name varchar (24));" \
 	"CREATE TABLE types (type_id INTEGER PRIMARY KEY, type_name varchar (48));" \
 	"CREATE TABLE devs (dev_id INTEGER PRIMARY KEY, dev_name varchar (32));" \
-	"CREATE TABLE paths (path varchar (128) PRIMARY KEY, ino int(64), dev int, user int, role int, type int, range int, obj_class int, symlink_target varchar (128));" \
+	"CREATE TABLE paths (path varchar (128) PRIMARY KEY, ino int(64), dev int, user int, role int, type int, range int, obj_class int, symlink_target varchar (128), mtime int(64), ctime int(64));" \
 	"CREATE TABLE info (key varchar, value varchar);"
 
 #define DB_SCHEMA_MLS DB_SCHEMA_NONMLS \
 	"CREATE TABLE mls (mls_id INTEGER PRIMARY KEY, mls_range varchar (64));"
 
+// secondary indexes upon the paths table, added in version 3; these
+// are created after the table has been populated
+#define DB_INDEXES \
+	"CREATE INDEX IF NOT EXISTS paths_user ON paths (user);" \
+	"CREATE INDEX IF NOT EXISTS paths_role ON paths (role);" \
+	"CREATE INDEX IF NOT EXISTS paths_type ON paths (type);" \
+	"CREATE INDEX IF NOT EXISTS paths_range ON paths (range);" \
+	"CREATE INDEX IF NOT EXISTS paths_obj_class ON paths (obj_class);" \
+	"CREATE INDEX IF NOT EXISTS paths_ino ON paths (ino);" \
+	"CREATE INDEX IF NOT EXISTS paths_dev ON paths (dev);"
+
 // wrapper functions to go between non-OO land into OO member functions
 
 inline struct sefs_context_node *db_get_context(sefs_db * db, const char *user, const char *role, const char *type,
@@ -133,80 +147,64 @@ static int db_copy_table(void *arg, int argc __attribute__ ((unused)), char *arg
 }
 
 /**
- * Callback invoked when selecting a user (for a sefs_query).
+ * Determine if a user name matches a sefs_query.
  */
-static void db_user_compare(sqlite3_context * context, int argc __attribute__ ((unused)), sqlite3_value ** argv)
+static bool db_user_match(const struct db_query_arg *q, const char *text)
 {
-	void *arg = sqlite3_user_data(context);
-	struct db_query_arg *q = static_cast < struct db_query_arg *>(arg);
-	assert(sqlite3_value_type(argv[0]) == SQLITE_TEXT);
-	const char *text = reinterpret_cast < const char *>(sqlite3_value_text(argv[0]));
-	bool retval = query_str_compare(text, q->user, q->reuser, q->regex);
-	sqlite3_result_int(context, (retval ? 1 : 0));
+	return query_str_compare(text, q->user, q->reuser, q->regex);
 }
 
 /**
- * Callback invoked when selecting a role (for a sefs_query).
+ * Determine if a role name matches a sefs_query.
  */
-static void db_role_compare(sqlite3_context * context, int argc __attribute__ ((unused)), sqlite3_value ** argv)
+static bool db_role_match(const struct db_query_arg *q, const char *text)
 {
-	void *arg = sqlite3_user_data(context);
-	struct db_query_arg *q = static_cast < struct db_query_arg *>(arg);
-	assert(sqlite3_value_type(argv[0]) == SQLITE_TEXT);
-	const char *text = reinterpret_cast < const char *>(sqlite3_value_text(argv[0]));
-	bool retval = query_str_compare(text, q->role, q->rerole, q->regex);
-	sqlite3_result_int(context, (retval ? 1 : 0));
+	return query_str_compare(text, q->role, q->rerole, q->regex);
 }
 
 /**
- * Callback invoked when selecting a type (for a sefs_query).
+ * Determine if a type name matches a sefs_query.
  */
-static void db_type_compare(sqlite3_context * context, int argc __attribute__ ((unused)), sqlite3_value ** argv)
+static bool db_type_match(const struct db_query_arg *q, const char *text)
 {
-	void *arg = sqlite3_user_data(context);
-	struct db_query_arg *q = static_cast < struct db_query_arg *>(arg);
-	assert(sqlite3_value_type(argv[0]) == SQLITE_TEXT);
-	const char *text = reinterpret_cast < const char *>(sqlite3_value_text(argv[0]));
-	bool retval;
 	if (q->type_list != NULL)
 	{
 		assert(q->policy != NULL);
 		size_t index;
-		retval = (apol_vector_get_index(q->type_list, text, apol_str_strcmp, NULL, &index) >= 0);
-		if (retval)
+		if (apol_vector_get_index(q->type_list, text, apol_str_strcmp, NULL, &index) >= 0)
 		{
-			sqlite3_result_int(context, 1);
-			return;
+			return true;
 		}
 	}
-	retval = query_str_compare(text, q->type, q->retype, q->regex);
-	sqlite3_result_int(context, (retval ? 1 : 0));
+	return query_str_compare(text, q->type, q->retype, q->regex);
 }
 
 /**
- * Callback invoked when selecting a range (for a sefs_query).
+ * Determine if an MLS range matches a sefs_query.
  */
-static void db_range_compare(sqlite3_context * context, int argc __attribute__ ((unused)), sqlite3_value ** argv)
+static bool db_range_match(const struct db_query_arg *q, const char *text)
 {
-	void *arg = sqlite3_user_data(context);
-	struct db_query_arg *q = static_cast < struct db_query_arg *>(arg);
-	assert(sqlite3_value_type(argv[0]) == SQLITE_TEXT);
-	const char *text = reinterpret_cast < const char *>(sqlite3_value_text(argv[0]));
-	bool retval;
 	if (q->apol_range == NULL)
 	{
-		retval = query_str_compare(text, q->range, q->rerange, q->regex);
+		return query_str_compare(text, q->range, q->rerange, q->regex);
 	}
-	else
+	assert(q->policy != NULL);
+	apol_mls_range_t *db_range = apol_mls_range_create_from_string(q->policy, text);
+	if (db_range == NULL)
 	{
-		assert(q->policy != NULL);
-		apol_mls_range_t *db_range = apol_mls_range_create_from_string(q->policy, text);
-		int ret;
-		ret = apol_mls_range_compare(q->policy, q->apol_range, db_range, q->rangeMatch);
-		apol_mls_range_destroy(&db_range);
-		retval = (ret > 0);
+		return false;
 	}
-	sqlite3_result_int(context, (retval ? 1 : 0));
+	int ret = apol_mls_range_compare(q->policy, q->apol_range, db_range, q->rangeMatch);
+	apol_mls_range_destroy(&db_range);
+	return (ret > 0);
+}
+
+/**
+ * Determine if a device name matches a sefs_query.
+ */
+static bool db_dev_match(const struct db_query_arg *q, const char *text)
+{
+	return query_str_compare(text, q->dev, q->redev, q->regex);
 }
 
 /**
@@ -223,16 +221,205 @@ static void db_path_compare(sqlite3_context * context, int argc __attribute__ ((
 }
 
 /**
- * Callback invoked when selecting a device name (for a sefs_query).
+ * One symbol criterion of a sefs_query.  The symbol tables (users,
+ * roles, etc.) are tiny compared to the paths table, so each
+ * criterion is resolved against its symbol table once, and the
+ * paths table is then searched through its index for the matching
+ * IDs.
  */
-static void db_dev_compare(sqlite3_context * context, int argc __attribute__ ((unused)), sqlite3_value ** argv)
+struct db_id_filter
 {
-	void *arg = sqlite3_user_data(context);
-	struct db_query_arg *q = static_cast < struct db_query_arg *>(arg);
-	assert(sqlite3_value_type(argv[0]) == SQLITE_TEXT);
-	const char *text = reinterpret_cast < const char *>(sqlite3_value_text(argv[0]));
-	bool retval = query_str_compare(text, q->dev, q->redev, q->regex);
-	sqlite3_result_int(context, (retval ? 1 : 0));
+	/** query string for this criterion, or NULL if not set */
+	const char *str;
+	/** function that determines if a symbol name matches */
+	bool (*match) (const struct db_query_arg * q, const char *text);
+	/** statement that selects each symbol's ID and name */
+	const char *symbol_select;
+	/** column of the paths table holding the symbol's ID */
+	const char *column;
+};
+
+struct db_id_arg
+{
+	const struct db_query_arg *q;
+	const struct db_id_filter *filter;
+	char *ids;
+	size_t len;
+	size_t num_ids;
+};
+
+/**
+ * Callback invoked upon each row of a symbol table while compiling a
+ * sefs_query.  Collect the IDs of those symbols that match.
+ */
+static int db_id_callback(void *arg, int argc __attribute__ ((unused)), char *argv[], char *column_names[]
+			  __attribute__ ((unused)))
+{
+	struct db_id_arg *a = static_cast < struct db_id_arg *>(arg);
+	if (argv[1] == NULL || !a->filter->match(a->q, argv[1]))
+	{
+		return 0;
+	}
+	if (apol_str_appendf(&a->ids, &a->len, "%s%s", (a->num_ids > 0 ? ", " : ""), argv[0]) < 0)
+	{
+		return -1;
+	}
+	a->num_ids++;
+	return 0;
+}
+
+/**
+ * Resolve a symbol criterion into the set of matching IDs, and then
+ * append to a select statement a test upon those IDs.
+ *
+ * @return 0 on success, 1 if no symbol matched (thus the query cannot
+ * return any rows), or < 0 on error.  Upon error errmsg may be set
+ * to a string that must be freed with sqlite3_free().
+ */
+static int db_append_id_filter(struct sqlite3 *db, const struct db_query_arg *q, const struct db_id_filter *filter,
+			       char **stmt, size_t * len, bool * where_added, char **errmsg)
+{
+	struct db_id_arg a;
+	memset(&a, 0, sizeof(a));
+	a.q = q;
+	a.filter = filter;
+	if (sqlite3_exec(db, filter->symbol_select, db_id_callback, &a, errmsg) != SQLITE_OK)
+	{
+		free(a.ids);
+		return -1;
+	}
+	if (a.num_ids == 0)
+	{
+		return 1;
+	}
+	int rc;
+	if (a.num_ids == 1)
+	{
+		rc = apol_str_appendf(stmt, len, "%s (%s = %s)", (*where_added ? " AND" : " WHERE"), filter->column, a.ids);
+	}
+	else
+	{
+		rc = apol_str_appendf(stmt, len, "%s (%s IN (%s))", (*where_added ? " AND" : " WHERE"), filter->column, a.ids);
+	}
+	free(a.ids);
+	if (rc < 0)
+	{
+		return -1;
+	}
+	*where_added = true;
+	return 0;
+}
+
+/**
+ * Find the literal string with which every match of an anchored
+ * extended regular expression must begin.  For example, the prefix
+ * of "^/usr/lib/.*\.so" is "/usr/lib/".
+ *
+ * @return An allocated prefix that the caller must free, or NULL if
+ * the expression is not anchored or has no literal prefix.
+ */
+static char *db_regex_literal_prefix(const char *re)
+{
+	if (re[0] != '^' || strchr(re, '|') != NULL)
+	{
+		return NULL;
+	}
+	char *prefix = static_cast < char *>(malloc(strlen(re)));
+	if (prefix == NULL)
+	{
+		return NULL;
+	}
+	size_t n = 0;
+	const char *s = re + 1;
+	while (*s != '\0')
+	{
+		char c = *s;
+		size_t adv = 1;
+		if (c == '\\')
+		{
+			// only an escaped punctuation character is a literal
+			if (s[1] == '\0' || !ispunct(static_cast < unsigned char >(s[1])))
+			{
+				break;
+			}
+			c = s[1];
+			adv = 2;
+		}
+		else if (strchr(".[]()*+?{}^$", c) != NULL)
+		{
+			break;
+		}
+		// a character that may repeat zero times is not part of
+		// the prefix
+		if (s[adv] == '*' || s[adv] == '?' || s[adv] == '{')
+		{
+			break;
+		}
+		prefix[n++] = c;
+		s += adv;
+		if (*s == '+')
+		{
+			break;
+		}
+	}
+	if (n == 0)
+	{
+		free(prefix);
+		return NULL;
+	}
+	prefix[n] = '\0';
+	return prefix;
+}
+
+/**
+ * Build the clause that selects paths for a sefs_query.  An exact
+ * path becomes an equality test, and a regular expression with a
+ * literal prefix is bounded to a range of the paths table's primary
+ * key before path_compare() checks each remaining row.
+ *
+ * @return A clause that the caller must free with sqlite3_free(), or
+ * NULL upon error.
+ */
+static char *db_path_clause(const struct db_query_arg *q, bool where_added)
+{
+	const char *conj = (where_added ? " AND" : " WHERE");
+	if (!q->regex)
+	{
+		return sqlite3_mprintf("%s (paths.path = %Q)", conj, q->path);
+	}
+	char *lower = db_regex_literal_prefix(q->path);
+	if (lower == NULL)
+	{
+		return sqlite3_mprintf("%s (path_compare(paths.path))", conj);
+	}
+	// the upper bound is the shortest string greater than every
+	// string that begins with the prefix
+	char *upper = strdup(lower);
+	if (upper == NULL)
+	{
+		free(lower);
+		return NULL;
+	}
+	size_t n = strlen(upper);
+	while (n > 0 && static_cast < unsigned char >(upper[n - 1]) == 0xff)
+	{
+		n--;
+	}
+	upper[n] = '\0';
+	char *clause;
+	if (n == 0)
+	{
+		clause = sqlite3_mprintf("%s (paths.path >= %Q AND path_compare(paths.path))", conj, lower);
+	}
+	else
+	{
+		upper[n - 1]++;
+		clause = sqlite3_mprintf("%s (paths.path >= %Q AND paths.path < %Q AND path_compare(paths.path))", conj, lower,
+					 upper);
+	}
+	free(lower);
+	free(upper);
+	return clause;
 }
 
 /**
@@ -352,6 +539,100 @@ static int db_strindex_comp(const void *a, const void *b, void *arg __attribute_
 	return strcmp(n1->str, n2->str);
 }
 
+struct db_load_arg
+{
+	apol_bst_t *tree;
+	int *next_id;
+};
+
+/**
+ * Callback invoked upon each row of a symbol table when loading an
+ * existing database's symbols.  The symbol name is stored in the
+ * same allocation as its strindex, so that freeing the strindex also
+ * frees the name.
+ */
+static int db_load_symbol(void *arg, int argc __attribute__ ((unused)), char *argv[], char *column_names[]
+			  __attribute__ ((unused)))
+{
+	struct db_load_arg *l = static_cast < struct db_load_arg *>(arg);
+	const char *name = (argv[1] == NULL ? "" : argv[1]);
+	size_t len = strlen(name) + 1;
+	struct strindex *st = static_cast < struct strindex *>(malloc(sizeof(*st) + len));
+	if (st == NULL)
+	{
+		return -1;
+	}
+	char *str = reinterpret_cast < char *>(st + 1);
+	memcpy(str, name, len);
+	st->str = str;
+	st->id = atoi(argv[0]);
+	if (st->id >= *(l->next_id))
+	{
+		*(l->next_id) = st->id + 1;
+	}
+	int rc = apol_bst_insert(l->tree, st, NULL);
+	if (rc != 0)
+	{
+		// either an error or a duplicate name
+		free(st);
+	}
+	return (rc < 0 ? -1 : 0);
+}
+
+/**
+ * Convert a file timestamp into the number of nanoseconds stored
+ * within the database.
+ */
+static long long db_timestamp(const struct timespec &ts)
+{
+	return static_cast < long long >(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * Determine the target of a symbolic link, as stored within the
+ * database.
+ *
+ * @param path Path to the file.
+ * @param sb Status of the file.
+ * @param link_target Buffer to which write the target, or the empty
+ * string if the file is not a symbolic link.
+ */
+static void db_link_target(const char *path, const struct stat64 *sb, char link_target[128])
+{
+	link_target[0] = '\0';
+	if (S_ISLNK(sb->st_mode))
+	{
+		ssize_t len = readlink(path, link_target, 127);
+		link_target[(len < 0 ? 0 : len)] = '\0';
+	}
+}
+
+/**
+ * Get the status of a file itself, rather than of the target of a
+ * symbolic link.  The timestamps and link target stored within the
+ * database come from this status, both when the database is created
+ * and when it is updated, because the context stored with them is
+ * likewise read without following links.  If the file cannot be
+ * examined then warn and clear the status.
+ *
+ * @param db Database, to report warnings.
+ * @param path Path to the file.
+ * @param sb Buffer to which write the status.
+ */
+static void db_lstat(sefs_db * db, const char *path, struct stat64 *sb)
+{
+	if (lstat64(path, sb) == -1)
+	{
+		/* Ignoring the file allows the index to be built when
+		   investigating broken systems.  Also see new_ftw.c
+		   comment regarding "lstat calls go through the
+		   wrapper function" to stop index hanging on broken
+		   files. */
+		memset(sb, 0, sizeof(*sb));
+		SEFS_WARN(db, "Could not stat file: %s - ignoring", path);
+	}
+}
+
 class db_convert
 {
       public:
@@ -444,6 +725,20 @@ class db_convert
 		free(insert_stmt);
 		return result->id;
 	}
+	/**
+	 * Read the symbols already within a table of the target
+	 * database, so that getID() reuses their IDs and allocates
+	 * new IDs after them.
+	 */
+	void load(const char *select_stmt, apol_bst_t * tree, int &id) throw(std::runtime_error)
+	{
+		struct db_load_arg l = { tree, &id };
+		if (sqlite3_exec(_target_db, select_stmt, db_load_symbol, &l, &_errmsg) != SQLITE_OK)
+		{
+			SEFS_ERR(_db, "%s", _errmsg);
+			throw std::runtime_error(_errmsg);
+		}
+	}
 	apol_bst_t *_user, *_role, *_type, *_range, *_dev;
 	int _user_id, _role_id, _type_id, _range_id, _dev_id;
 	bool _isMLS;
@@ -477,31 +772,14 @@ int db_create_from_filesystem(sefs_fclist * fclist __attribute__ ((unused)), con
 		char link_target[128] = "";
 		// determine the link target as necessary
 		struct stat64 sb;
-		if (stat64(path, &sb) == -1)
-		{
-			/* If sym link broken/file not found, then ignore as this will allow
-			   the index to be built. Useful when investigating broken systems.
-			   Also see new_ftw.c comment regarding "lstat calls go through the
-			   wrapper function" to stop index hanging on broken files. */
-			link_target[127] = '\0';
-			sb.st_mode = 0;
-			SEFS_WARN(dbc->_db, "Could not stat file: %s - ignoring", path);
-		}
-		if (S_ISLNK(sb.st_mode))
-		{
-			if (readlink(path, link_target, 128) == 0)
-			{
-				SEFS_ERR(dbc->_db, "%s", strerror(errno));
-				throw std::bad_alloc();
-			}
-			link_target[127] = '\0';
-		}
+		db_lstat(dbc->_db, path, &sb);
+		db_link_target(path, &sb, link_target);
 
 		char *insert_stmt = NULL;
 		if (asprintf
-		    (&insert_stmt, "INSERT INTO paths VALUES ('%s', %lu, %d, %d, %d, %d, %d, %u, '%s')", path,
+		    (&insert_stmt, "INSERT INTO paths VALUES ('%s', %lu, %d, %d, %d, %d, %d, %u, '%s', %lld, %lld)", path,
 		     static_cast < long unsigned int >(inode), dev_id, user_id, role_id, type_id, range_id, objclass,
-		     link_target) < 0)
+		     link_target, db_timestamp(sb.st_mtim), db_timestamp(sb.st_ctim)) < 0)
 		{
 			SEFS_ERR(dbc->_db, "%s", strerror(errno));
 			throw std::bad_alloc();
@@ -521,6 +799,290 @@ int db_create_from_filesystem(sefs_fclist * fclist __attribute__ ((unused)), con
 	return 0;
 }
 
+/******************** update a db from a filesystem ********************/
+
+struct db_update_dev
+{
+	dev_t dev;
+	const char *dev_name;	       //< pointer into the filesystem's dev_tree
+};
+
+struct db_update_arg
+{
+	sefs_db *db;
+	sefs_filesystem *fs;
+	db_convert *dbc;
+	/** statement that selects the stored status of a path */
+	struct sqlite3_stmt *select_stmt;
+	/** statement that inserts or replaces a path's row */
+	struct sqlite3_stmt *insert_stmt;
+	/** vector of db_update_dev, caching device names */
+	apol_vector_t *devs;
+	/** vector of paths (char *) of directories whose entries may
+	 *  have been removed since the database was written */
+	apol_vector_t *changed_dirs;
+	size_t num_unchanged, num_updated;
+};
+
+/**
+ * Get the name of a device, consulting the filesystem only the first
+ * time each device is seen.
+ */
+static const char *db_update_dev_name(struct db_update_arg *u, dev_t dev) throw(std::runtime_error)
+{
+	for (size_t i = 0; i < apol_vector_get_size(u->devs); i++)
+	{
+		struct db_update_dev *d = static_cast < struct db_update_dev *>(apol_vector_get_element(u->devs, i));
+		if (d->dev == dev)
+		{
+			return d->dev_name;
+		}
+	}
+	struct db_update_dev *d = static_cast < struct db_update_dev *>(malloc(sizeof(*d)));
+	if (d == NULL || apol_vector_append(u->devs, d) < 0)
+	{
+		SEFS_ERR(u->db, "%s", strerror(errno));
+		free(d);
+		throw std::runtime_error(strerror(errno));
+	}
+	d->dev = dev;
+	if ((d->dev_name = u->fs->getDevName(dev)) == NULL)
+	{
+		d->dev_name = "<unknown>";
+	}
+	return d->dev_name;
+}
+
+/**
+ * Callback invoked upon each file while updating a database.  If the
+ * file's inode, device, and timestamps match those stored then the
+ * file is unchanged; every change to a file's context also changes
+ * its ctime.  Otherwise read its context and rewrite its row.
+ */
+static int db_update_handler(const char *fpath, const struct stat64 *sb, int typeflag __attribute__ ((unused)),
+			     struct FTW *ftwbuf __attribute__ ((unused)), void *data)
+{
+	struct db_update_arg *u = static_cast < struct db_update_arg *>(data);
+	db_convert *dbc = u->dbc;
+	try
+	{
+		const char *dev = db_update_dev_name(u, sb->st_dev);
+		int dev_id = dbc->getID(dev, dbc->_dev, dbc->_dev_id, "devs");
+		// the walk follows symbolic links, as when the database
+		// was created; timestamps come from the file itself
+		struct stat64 lsb;
+		db_lstat(u->db, fpath, &lsb);
+		long long mtime = db_timestamp(lsb.st_mtim);
+		long long ctime = db_timestamp(lsb.st_ctim);
+
+		sqlite3_reset(u->select_stmt);
+		sqlite3_bind_text(u->select_stmt, 1, fpath, -1, SQLITE_STATIC);
+		int rc = sqlite3_step(u->select_stmt);
+		bool found = false, unchanged = false, was_dir = false;
+		if (rc == SQLITE_ROW)
+		{
+			found = true;
+			was_dir = (sqlite3_column_int(u->select_stmt, 4) == QPOL_CLASS_DIR);
+			unchanged = (sqlite3_column_type(u->select_stmt, 3) != SQLITE_NULL &&
+				     sqlite3_column_int64(u->select_stmt, 0) == static_cast < sqlite3_int64 > (sb->st_ino) &&
+				     sqlite3_column_int(u->select_stmt, 1) == dev_id &&
+				     sqlite3_column_int64(u->select_stmt, 2) == mtime &&
+				     sqlite3_column_int64(u->select_stmt, 3) == ctime);
+		}
+		else if (rc != SQLITE_DONE)
+		{
+			SEFS_ERR(u->db, "%s", sqlite3_errmsg(sqlite3_db_handle(u->select_stmt)));
+			throw std::runtime_error(sqlite3_errmsg(sqlite3_db_handle(u->select_stmt)));
+		}
+		sqlite3_reset(u->select_stmt);
+		if (unchanged)
+		{
+			u->num_unchanged++;
+			return 0;
+		}
+		if (found && was_dir)
+		{
+			char *s = strdup(fpath);
+			if (s == NULL || apol_vector_append(u->changed_dirs, s) < 0)
+			{
+				SEFS_ERR(u->db, "%s", strerror(errno));
+				free(s);
+				throw std::runtime_error(strerror(errno));
+			}
+		}
+
+		security_context_t scon;
+		if (filesystem_lgetfilecon(fpath, &scon) < 0)
+		{
+			SEFS_ERR(u->db, "Could not read SELinux file context for %s.", fpath);
+			return -1;
+		}
+		context_t con;
+		if ((con = context_new(scon)) == 0)
+		{
+			SEFS_ERR(u->db, "%s", strerror(errno));
+			freecon(scon);
+			return -1;
+		}
+		freecon(scon);
+		const char *range = context_range_get(con);
+		struct sefs_context_node *node = NULL;
+		try
+		{
+			node = db_get_context(u->db, context_user_get(con), context_role_get(con), context_type_get(con), range);
+		}
+		catch(...)
+		{
+			context_free(con);
+			throw;
+		}
+		context_free(con);
+
+		int user_id = dbc->getID(node->user, dbc->_user, dbc->_user_id, "users");
+		int role_id = dbc->getID(node->role, dbc->_role, dbc->_role_id, "roles");
+		int type_id = dbc->getID(node->type, dbc->_type, dbc->_type_id, "types");
+		int range_id = 0;
+		if (dbc->_isMLS)
+		{
+			range_id = dbc->getID((node->range == NULL ? "" : node->range), dbc->_range, dbc->_range_id, "mls");
+		}
+		char link_target[128];
+		db_link_target(fpath, &lsb, link_target);
+
+		sqlite3_stmt *ins = u->insert_stmt;
+		sqlite3_reset(ins);
+		sqlite3_bind_text(ins, 1, fpath, -1, SQLITE_STATIC);
+		sqlite3_bind_int64(ins, 2, static_cast < sqlite3_int64 > (sb->st_ino));
+		sqlite3_bind_int(ins, 3, dev_id);
+		sqlite3_bind_int(ins, 4, user_id);
+		sqlite3_bind_int(ins, 5, role_id);
+		sqlite3_bind_int(ins, 6, type_id);
+		sqlite3_bind_int(ins, 7, range_id);
+		sqlite3_bind_int(ins, 8, static_cast < int >(filesystem_stat_to_objclass(sb)));
+		sqlite3_bind_text(ins, 9, link_target, -1, SQLITE_STATIC);
+		sqlite3_bind_int64(ins, 10, mtime);
+		sqlite3_bind_int64(ins, 11, ctime);
+		if (sqlite3_step(ins) != SQLITE_DONE)
+		{
+			SEFS_ERR(u->db, "%s", sqlite3_errmsg(sqlite3_db_handle(ins)));
+			throw std::runtime_error(sqlite3_errmsg(sqlite3_db_handle(ins)));
+		}
+		sqlite3_reset(ins);
+		u->num_updated++;
+	}
+	catch(...)
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Remove the rows for entries that no longer exist within a directory
+ * whose contents have changed, along with everything beneath them.
+ *
+ * @return Number of rows removed.
+ * @exception std::runtime_error Error while writing to the database.
+ */
+static size_t db_update_remove_stale(sefs_db * db, struct sqlite3 *sdb, const char *dir) throw(std::runtime_error)
+{
+	char *base = NULL, *children = NULL;
+	apol_vector_t *stale = NULL;
+	sqlite3_stmt *stmt = NULL;
+	size_t num_removed = 0;
+	try
+	{
+		if ((base = strdup(dir)) == NULL || (stale = apol_vector_create(free)) == NULL)
+		{
+			SEFS_ERR(db, "%s", strerror(errno));
+			throw std::runtime_error(strerror(errno));
+		}
+		size_t len = strlen(base);
+		if (len > 0 && base[len - 1] == '/')
+		{
+			base[--len] = '\0';
+		}
+		// everything beneath dir sorts between "dir/" and "dir0"
+		children = sqlite3_mprintf("SELECT path FROM paths WHERE path > %Q || '/' AND path < %Q || '0'", base, base);
+		if (children == NULL)
+		{
+			SEFS_ERR(db, "%s", strerror(ENOMEM));
+			throw std::runtime_error(strerror(ENOMEM));
+		}
+		if (sqlite3_prepare_v2(sdb, children, -1, &stmt, NULL) != SQLITE_OK)
+		{
+			SEFS_ERR(db, "%s", sqlite3_errmsg(sdb));
+			throw std::runtime_error(sqlite3_errmsg(sdb));
+		}
+		int rc;
+		while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+		{
+			const char *path = reinterpret_cast < const char *>(sqlite3_column_text(stmt, 0));
+			struct stat64 sb;
+			// only consider direct children; deeper entries are
+			// either checked by their own directory or removed
+			// along with their ancestor
+			if (strchr(path + len + 1, '/') != NULL)
+			{
+				continue;
+			}
+			if (lstat64(path, &sb) == 0 || (errno != ENOENT && errno != ENOTDIR))
+			{
+				continue;
+			}
+			char *s = strdup(path);
+			if (s == NULL || apol_vector_append(stale, s) < 0)
+			{
+				SEFS_ERR(db, "%s", strerror(errno));
+				free(s);
+				throw std::runtime_error(strerror(errno));
+			}
+		}
+		if (rc != SQLITE_DONE)
+		{
+			SEFS_ERR(db, "%s", sqlite3_errmsg(sdb));
+			throw std::runtime_error(sqlite3_errmsg(sdb));
+		}
+		sqlite3_finalize(stmt);
+		stmt = NULL;
+
+		for (size_t i = 0; i < apol_vector_get_size(stale); i++)
+		{
+			const char *path = static_cast < const char *>(apol_vector_get_element(stale, i));
+			char *del = sqlite3_mprintf("DELETE FROM paths WHERE path = %Q OR (path > %Q || '/' AND path < %Q || '0')",
+						    path, path, path);
+			if (del == NULL)
+			{
+				SEFS_ERR(db, "%s", strerror(ENOMEM));
+				throw std::runtime_error(strerror(ENOMEM));
+			}
+			char *errmsg = NULL;
+			rc = sqlite3_exec(sdb, del, NULL, NULL, &errmsg);
+			sqlite3_free(del);
+			if (rc != SQLITE_OK)
+			{
+				SEFS_ERR(db, "%s", errmsg);
+				std::runtime_error e(errmsg);
+				sqlite3_free(errmsg);
+				throw e;
+			}
+			num_removed += static_cast < size_t > (sqlite3_changes(sdb));
+		}
+	}
+	catch(...)
+	{
+		sqlite3_finalize(stmt);
+		sqlite3_free(children);
+		apol_vector_destroy(&stale);
+		free(base);
+		throw;
+	}
+	sqlite3_free(children);
+	apol_vector_destroy(&stale);
+	free(base);
+	return num_removed;
+}
+
 /******************** public functions below ********************/
 
 sefs_db::sefs_db(sefs_filesystem * fs, sefs_callback_fn_t msg_callback, void *varg)throw(std::invalid_argument, std::runtime_error):sefs_fclist
@@ -564,6 +1126,11 @@ sefs_db::sefs_db(sefs_filesystem * fs, sefs_callback_fn_t msg_callback, void *va
 		{
 			throw std::runtime_error(strerror(errno));
 		}
+		if (sqlite3_exec(_db, DB_INDEXES, NULL, NULL, &errmsg) != SQLITE_OK)
+		{
+			SEFS_ERR(this, "%s", errmsg);
+			throw std::runtime_error(errmsg);
+		}
 
 		// store metadata about the database
 		const char *dbversion = DB_MAX_VERSION;
@@ -630,21 +1197,33 @@ sefs_db::sefs_db(const char *filename, sefs_callback_fn_t msg_callback, void *va
 
 	char *errmsg = NULL;
 
-	const char *select_stmt = "SELECT * FROM info WHERE key = 'dbversion' AND value >= " DB_MAX_VERSION;
-	bool answer = false;
-	if (sqlite3_exec(_db, select_stmt, db_row_exist_callback, &answer, &errmsg) != SQLITE_OK)
+	const char *select_stmt = "SELECT value FROM info WHERE key = 'dbversion'";
+	int version = 0;
+	if (sqlite3_exec(_db, select_stmt, db_count_callback, &version, &errmsg) != SQLITE_OK)
 	{
 		SEFS_ERR(this, "%s", errmsg);
 		sqlite3_free(errmsg);
 		sqlite3_close(_db);
 		throw std::runtime_error(strerror(errno));
 	}
-	if (!answer)
+	if (version < 2)
 	{
 		SEFS_INFO(this, "Upgrading database %s.", filename);
 		SEFS_WARN(this, "%s is a pre-libsefs-4.0 database and will be upgraded.", filename);
 		upgradeToDB2();
 	}
+	// each upgrade builds upon the previous one, so stop at the
+	// first that fails and leave the version for a later open to
+	// try again
+	bool upgraded = true;
+	if (version < 3)
+	{
+		upgraded = upgradeToDB3();
+	}
+	if (version < 4 && upgraded)
+	{
+		upgradeToDB4();
+	}
 
 	// get ctime from db
 	_ctime = 0;
@@ -755,67 +1334,37 @@ int sefs_db::runQueryMap(sefs_query * query, sefs_fclist_map_fn_t fn, void *data
 			throw std::runtime_error(strerror(errno));
 		}
 
-		if (q.user != NULL)
-		{
-			if (sqlite3_create_function(_db, "user_compare", 1, SQLITE_UTF8, &q, db_user_compare, NULL, NULL) !=
-			    SQLITE_OK)
-			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
-			}
-			if (apol_str_appendf(&select_stmt, &len,
-					     "%s (user_compare(users.user_name))", (where_added ? " AND" : " WHERE")) < 0)
-			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
-			}
-			where_added = true;
-		}
-
-		if (q.role != NULL)
+		// resolve symbol criteria into ID sets first; if any
+		// criterion matches no symbol then there is nothing to
+		// select
+		struct db_id_filter filters[] = {
+			{q.user, db_user_match, "SELECT user_id, user_name FROM users", "paths.user"},
+			{q.role, db_role_match, "SELECT role_id, role_name FROM roles", "paths.role"},
+			{q.type, db_type_match, "SELECT type_id, type_name FROM types", "paths.type"},
+			{(q.db_is_mls ? q.range : NULL), db_range_match, "SELECT mls_id, mls_range FROM mls", "paths.range"},
+			{q.dev, db_dev_match, "SELECT dev_id, dev_name FROM devs", "paths.dev"}
+		};
+		bool no_match = false;
+		for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]) && !no_match; i++)
 		{
-			if (sqlite3_create_function(_db, "role_compare", 1, SQLITE_UTF8, &q, db_role_compare, NULL, NULL) !=
-			    SQLITE_OK)
+			if (filters[i].str == NULL || filters[i].str[0] == '\0')
 			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
+				continue;
 			}
-			if (apol_str_appendf(&select_stmt, &len,
-					     "%s (role_compare(roles.role_name))", (where_added ? " AND" : " WHERE")) < 0)
+			int rc = db_append_id_filter(_db, &q, filters + i, &select_stmt, &len, &where_added, &errmsg);
+			if (rc < 0)
 			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
+				const char *msg = (errmsg != NULL ? errmsg : strerror(errno));
+				SEFS_ERR(this, "%s", msg);
+				throw std::runtime_error(msg);
 			}
-			where_added = true;
+			no_match = (rc > 0);
 		}
 
-		if (q.type != NULL)
+		if (query != NULL && query->_objclass != 0)
 		{
-			if (sqlite3_create_function(_db, "type_compare", 1, SQLITE_UTF8, &q, db_type_compare, NULL, NULL) !=
-			    SQLITE_OK)
-			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
-			}
 			if (apol_str_appendf(&select_stmt, &len,
-					     "%s (type_compare(types.type_name))", (where_added ? " AND" : " WHERE")) < 0)
-			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
-			}
-			where_added = true;
-		}
-
-		if (q.db_is_mls && q.range != NULL)
-		{
-			if (sqlite3_create_function(_db, "range_compare", 1, SQLITE_UTF8, &q, db_range_compare, NULL, NULL) !=
-			    SQLITE_OK)
-			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
-			}
-			if (apol_str_appendf(&select_stmt, &len,
-					     "%s (range_compare(mls.mls_range))", (where_added ? " AND" : " WHERE")) < 0)
+					     "%s (paths.obj_class = %d)", (where_added ? " AND" : " WHERE"), query->_objclass) < 0)
 			{
 				SEFS_ERR(this, "%s", strerror(errno));
 				throw std::runtime_error(strerror(errno));
@@ -823,27 +1372,23 @@ int sefs_db::runQueryMap(sefs_query * query, sefs_fclist_map_fn_t fn, void *data
 			where_added = true;
 		}
 
-		if (query->_objclass != 0)
+		if (q.path != NULL && q.path[0] != '\0')
 		{
-			if (apol_str_appendf(&select_stmt, &len,
-					     "%s (paths.obj_class = %d)", (where_added ? " AND" : " WHERE"), query->_objclass) < 0)
+			if (q.regex &&
+			    sqlite3_create_function(_db, "path_compare", 1, SQLITE_UTF8, &q, db_path_compare, NULL, NULL) != SQLITE_OK)
 			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
+				SEFS_ERR(this, "%s", sqlite3_errmsg(_db));
+				throw std::runtime_error(sqlite3_errmsg(_db));
 			}
-			where_added = true;
-		}
-
-		if (q.path != NULL)
-		{
-			if (sqlite3_create_function(_db, "path_compare", 1, SQLITE_UTF8, &q, db_path_compare, NULL, NULL) !=
-			    SQLITE_OK)
+			char *path_clause = db_path_clause(&q, where_added);
+			if (path_clause == NULL)
 			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
+				SEFS_ERR(this, "%s", strerror(ENOMEM));
+				throw std::runtime_error(strerror(ENOMEM));
 			}
-			if (apol_str_appendf(&select_stmt, &len,
-					     "%s (path_compare(paths.path))", (where_added ? " AND" : " WHERE")) < 0)
+			int rc = apol_str_append(&select_stmt, &len, path_clause);
+			sqlite3_free(path_clause);
+			if (rc < 0)
 			{
 				SEFS_ERR(this, "%s", strerror(errno));
 				throw std::runtime_error(strerror(errno));
@@ -851,7 +1396,7 @@ int sefs_db::runQueryMap(sefs_query * query, sefs_fclist_map_fn_t fn, void *data
 			where_added = true;
 		}
 
-		if (query->_inode != 0)
+		if (query != NULL && query->_inode != 0)
 		{
 			if (apol_str_appendf(&select_stmt, &len,
 					     "%s (paths.ino = %lu)", (where_added ? " AND" : " WHERE"),
@@ -863,23 +1408,6 @@ int sefs_db::runQueryMap(sefs_query * query, sefs_fclist_map_fn_t fn, void *data
 			where_added = true;
 		}
 
-		if (query->_dev != 0)
-		{
-			if (sqlite3_create_function(_db, "dev_compare", 1, SQLITE_UTF8, &q, db_dev_compare, NULL, NULL) !=
-			    SQLITE_OK)
-			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
-			}
-			if (apol_str_appendf(&select_stmt, &len,
-					     "%s (dev_compare(devs.dev_name)", (where_added ? " AND" : " WHERE")) < 0)
-			{
-				SEFS_ERR(this, "%s", strerror(errno));
-				throw std::runtime_error(strerror(errno));
-			}
-			where_added = true;
-		}
-
 		if (apol_str_appendf(&select_stmt, &len,
 				     "%s (paths.user = users.user_id AND paths.role = roles.role_id AND paths.type = types.type_id",
 				     (where_added ? " AND" : " WHERE")) < 0)
@@ -898,11 +1426,14 @@ int sefs_db::runQueryMap(sefs_query * query, sefs_fclist_map_fn_t fn, void *data
 			throw std::runtime_error(strerror(errno));
 		}
 
-		int rc = sqlite3_exec(_db, select_stmt, db_query_callback, &q, &errmsg);
-		if (rc != SQLITE_OK && (rc != SQLITE_ABORT || !q.aborted))
+		if (!no_match)
 		{
-			SEFS_ERR(this, "%s", errmsg);
-			throw std::runtime_error(errmsg);
+			int rc = sqlite3_exec(_db, select_stmt, db_query_callback, &q, &errmsg);
+			if (rc != SQLITE_OK && (rc != SQLITE_ABORT || !q.aborted))
+			{
+				SEFS_ERR(this, "%s", errmsg);
+				throw std::runtime_error(errmsg);
+			}
 		}
 	}
 	catch(...)
@@ -968,8 +1499,9 @@ void sefs_db::save(const char *filename) throw(std::invalid_argument, std::runti
 			SEFS_ERR(this, "%s", sqlite3_errmsg(diskdb.db));
 			throw std::runtime_error(sqlite3_errmsg(diskdb.db));
 		}
-		if (sqlite3_exec(_db, "SELECT sql FROM sqlite_master WHERE sql NOT NULL", db_copy_schema, &diskdb, &diskdb.errmsg)
-		    != SQLITE_OK)
+		if (sqlite3_exec
+		    (_db, "SELECT sql FROM sqlite_master WHERE type = 'table' AND sql NOT NULL", db_copy_schema, &diskdb,
+		     &diskdb.errmsg) != SQLITE_OK)
 		{
 			SEFS_ERR(this, "%s", diskdb.errmsg);
 			throw std::runtime_error(diskdb.errmsg);
@@ -1015,6 +1547,23 @@ void sefs_db::save(const char *filename) throw(std::invalid_argument, std::runti
 			throw std::runtime_error(diskdb.errmsg);
 		}
 		in_transaction = false;
+
+		// build the indexes only after the data has been copied,
+		// which is much faster than updating them row by row
+		if (sqlite3_open(filename, &(diskdb.db)) != SQLITE_OK)
+		{
+			SEFS_ERR(this, "%s", sqlite3_errmsg(diskdb.db));
+			throw std::runtime_error(sqlite3_errmsg(diskdb.db));
+		}
+		if (sqlite3_exec
+		    (_db, "SELECT sql FROM sqlite_master WHERE type = 'index' AND sql NOT NULL", db_copy_schema, &diskdb,
+		     &diskdb.errmsg) != SQLITE_OK)
+		{
+			SEFS_ERR(this, "%s", diskdb.errmsg);
+			throw std::runtime_error(diskdb.errmsg);
+		}
+		sqlite3_close(diskdb.db);
+		diskdb.db = NULL;
 	}
 	catch(...)
 	{
@@ -1033,10 +1582,131 @@ void sefs_db::save(const char *filename) throw(std::invalid_argument, std::runti
 		sqlite3_free(diskdb.errmsg);
 		throw;
 	}
-	//      sqlite3_close(diskdb.db);  don't close the database -- it's pointing to this->_db
 	sqlite3_free(diskdb.errmsg);
 }
 
+void sefs_db::update(sefs_filesystem * fs) throw(std::invalid_argument, std::runtime_error)
+{
+	if (fs == NULL)
+	{
+		errno = EINVAL;
+		SEFS_ERR(this, "%s", strerror(EINVAL));
+		throw std::invalid_argument(strerror(EINVAL));
+	}
+	if (fs->isMLS() != isMLS())
+	{
+		errno = EINVAL;
+		SEFS_ERR(this, "%s", "The database and the filesystem do not agree on the use of MLS.");
+		throw std::invalid_argument(strerror(EINVAL));
+	}
+
+	SEFS_INFO(this, "Updating database from filesystem %s.", fs->root());
+	struct db_update_arg u;
+	memset(&u, 0, sizeof(u));
+	u.db = this;
+	u.fs = fs;
+	db_convert *dbc = NULL;
+	char *errmsg = NULL;
+	bool in_transaction = false;
+	size_t num_removed = 0;
+
+	try
+	{
+		// a single transaction makes the update all or nothing,
+		// and spares sqlite from syncing each row to disk
+		if (sqlite3_exec(_db, "BEGIN TRANSACTION", NULL, NULL, &errmsg) != SQLITE_OK)
+		{
+			SEFS_ERR(this, "%s", errmsg);
+			throw std::runtime_error(errmsg);
+		}
+		in_transaction = true;
+
+		dbc = new db_convert(this, _db);
+		dbc->_isMLS = isMLS();
+		dbc->load("SELECT user_id, user_name FROM users", dbc->_user, dbc->_user_id);
+		dbc->load("SELECT role_id, role_name FROM roles", dbc->_role, dbc->_role_id);
+		dbc->load("SELECT type_id, type_name FROM types", dbc->_type, dbc->_type_id);
+		if (dbc->_isMLS)
+		{
+			dbc->load("SELECT mls_id, mls_range FROM mls", dbc->_range, dbc->_range_id);
+		}
+		dbc->load("SELECT dev_id, dev_name FROM devs", dbc->_dev, dbc->_dev_id);
+		u.dbc = dbc;
+
+		if ((u.devs = apol_vector_create(free)) == NULL || (u.changed_dirs = apol_vector_create(free)) == NULL)
+		{
+			SEFS_ERR(this, "%s", strerror(errno));
+			throw std::runtime_error(strerror(errno));
+		}
+		if (sqlite3_prepare_v2(_db, "SELECT ino, dev, mtime, ctime, obj_class FROM paths WHERE path = ?", -1,
+				       &u.select_stmt, NULL) != SQLITE_OK ||
+		    sqlite3_prepare_v2(_db,
+				       "INSERT OR REPLACE INTO paths (path, ino, dev, user, role, type, range, obj_class, symlink_target, mtime, ctime) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+				       -1, &u.insert_stmt, NULL) != SQLITE_OK)
+		{
+			SEFS_ERR(this, "%s", sqlite3_errmsg(_db));
+			throw std::runtime_error(sqlite3_errmsg(_db));
+		}
+
+		if (new_nftw64(fs->root(), db_update_handler, 1024, 0, &u) != 0)
+		{
+			throw std::runtime_error(strerror(errno));
+		}
+
+		for (size_t i = 0; i < apol_vector_get_size(u.changed_dirs); i++)
+		{
+			const char *dir = static_cast < const char *>(apol_vector_get_element(u.changed_dirs, i));
+			num_removed += db_update_remove_stale(this, _db, dir);
+		}
+
+		_ctime = time(NULL);
+		char datetime[32];
+		ctime_r(&_ctime, datetime);
+		char *info_update = sqlite3_mprintf("UPDATE info SET value = %Q WHERE key = 'datetime'", datetime);
+		if (info_update == NULL)
+		{
+			SEFS_ERR(this, "%s", strerror(ENOMEM));
+			throw std::runtime_error(strerror(ENOMEM));
+		}
+		int rc = sqlite3_exec(_db, info_update, NULL, NULL, &errmsg);
+		sqlite3_free(info_update);
+		if (rc != SQLITE_OK)
+		{
+			SEFS_ERR(this, "%s", errmsg);
+			throw std::runtime_error(errmsg);
+		}
+
+		if (sqlite3_exec(_db, "END TRANSACTION", NULL, NULL, &errmsg) != SQLITE_OK)
+		{
+			SEFS_ERR(this, "%s", errmsg);
+			throw std::runtime_error(errmsg);
+		}
+		in_transaction = false;
+	}
+	catch(...)
+	{
+		sqlite3_finalize(u.select_stmt);
+		sqlite3_finalize(u.insert_stmt);
+		if (in_transaction)
+		{
+			sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+		}
+		apol_vector_destroy(&u.devs);
+		apol_vector_destroy(&u.changed_dirs);
+		delete dbc;
+		sqlite3_free(errmsg);
+		throw;
+	}
+
+	sqlite3_finalize(u.select_stmt);
+	sqlite3_finalize(u.insert_stmt);
+	apol_vector_destroy(&u.devs);
+	apol_vector_destroy(&u.changed_dirs);
+	delete dbc;
+	SEFS_INFO(this, "Updated %zu entries and removed %zu entries; %zu entries were unchanged.", u.num_updated, num_removed,
+		  u.num_unchanged);
+}
+
 time_t sefs_db::getCTime() const
 {
 	return _ctime;
@@ -1195,8 +1865,8 @@ void sefs_db::upgradeToDB2() throw(std::runtime_error)
 	if (asprintf(&alter_stmt, "DROP TABLE inodes; DROP TABLE paths;"	// drop the old tables
 		     "ALTER TABLE new_paths RENAME TO paths;"	// move ver 2 paths table as main table
 		     "UPDATE info SET value = '%s' WHERE key = 'datetime';"
-		     "UPDATE info SET value = '%s' WHERE key = 'dbversion';"
-		     "END TRANSACTION;" "VACUUM", datetime, DB_MAX_VERSION) < 0)
+		     "UPDATE info SET value = '2' WHERE key = 'dbversion';"
+		     "END TRANSACTION;" "VACUUM", datetime) < 0)
 	{
 		SEFS_ERR(this, "%s", errmsg);
 		sqlite3_free(errmsg);
@@ -1214,6 +1884,39 @@ void sefs_db::upgradeToDB2() throw(std::runtime_error)
 	free(alter_stmt);
 }
 
+bool sefs_db::upgradeToDB3()
+{
+	// Version 3 only adds indexes, so the database remains usable
+	// (albeit slower to query) if it cannot be written.
+	char *errmsg = NULL;
+	if (sqlite3_exec(_db, "BEGIN TRANSACTION;" DB_INDEXES "UPDATE info SET value = '3' WHERE key = 'dbversion';"
+			 "END TRANSACTION", NULL, NULL, &errmsg) != SQLITE_OK)
+	{
+		SEFS_WARN(this, "Could not add indexes to the database: %s", errmsg);
+		sqlite3_free(errmsg);
+		sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+		return false;
+	}
+	return true;
+}
+
+void sefs_db::upgradeToDB4()
+{
+	// Version 4 adds file timestamps, which only update() needs;
+	// rows from older versions lack them, and so they will be
+	// rewritten by the first update.
+	char *errmsg = NULL;
+	if (sqlite3_exec(_db, "BEGIN TRANSACTION;"
+			 "ALTER TABLE paths ADD COLUMN mtime int(64);"
+			 "ALTER TABLE paths ADD COLUMN ctime int(64);"
+			 "UPDATE info SET value = '4' WHERE key = 'dbversion';" "END TRANSACTION", NULL, NULL, &errmsg) != SQLITE_OK)
+	{
+		SEFS_WARN(this, "Could not add timestamps to the database: %s", errmsg);
+		sqlite3_free(errmsg);
+		sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+	}
+}
+
 sefs_entry *sefs_db::getEntry(const struct sefs_context_node *context, uint32_t objectClass, const char *path, ino64_t inode,
 			      const char *dev) throw(std::bad_alloc)
 {
@@ -1292,6 +1995,25 @@ int sefs_db_save(sefs_db_t * db, const char *filename)
 	return 0;
 }
 
+int sefs_db_update(sefs_db_t * db, sefs_filesystem_t * fs)
+{
+	if (db == NULL)
+	{
+		SEFS_ERR(NULL, "%s", strerror(EINVAL));
+		errno = EINVAL;
+		return -1;
+	}
+	try
+	{
+		db->update(fs);
+	}
+	catch(...)
+	{
+		return -1;
+	}
+	return 0;
+}
+
 time_t sefs_db_get_ctime(sefs_db_t * db)
 {
 	if (db == NULL)
@@ -50,7 +50,7 @@ extern int lgetfilecon_raw(const char *, security_context_t *) __attribute__ ((w
  * does indeed have the new functions then use them; otherwise
  * fallback to the originals.
  */
-static int filesystem_lgetfilecon(const char *path, security_context_t * context)
+int filesystem_lgetfilecon(const char *path, security_context_t * context)
 {
 	if (lgetfilecon_raw != NULL)
 	{
@@ -251,7 +251,7 @@ inline bool filesystem_is_query_match(sefs_filesystem * fs, const sefs_query * q
 	return fs->isQueryMatch(query, path, dev, sb, type_list, range);
 }
 
-static uint32_t filesystem_stat_to_objclass(const struct stat64 *sb)
+uint32_t filesystem_stat_to_objclass(const struct stat64 *sb)
 {
 	if (S_ISREG(sb->st_mode))
 	{
@@ -28,6 +28,8 @@
 #include <apol/bst.h>
 #include <sefs/fclist.hh>
 #include <regex.h>
+#include <selinux/selinux.h>
+#include <sys/stat.h>
 
 /**
  * Given a policy containing types, generate and return a vector of
@@ -66,6 +68,28 @@ apol_vector_t *query_create_candidate_type(apol_policy_t * policy, const char *s
  */
 bool query_str_compare(const char *target, const char *str, const regex_t * regex, const bool regex_flag);
 
+/**
+ * Read the raw SELinux file context of a path, without following
+ * symbolic links.
+ *
+ * @param path Path to read.
+ * @param context Location to write the allocated context.  The
+ * caller must call freecon() upon it afterwards.
+ *
+ * @return 0 on success, < 0 on error.
+ */
+int filesystem_lgetfilecon(const char *path, security_context_t * context);
+
+/**
+ * Determine the object class (one of QPOL_CLASS_BLK_FILE, etc.) of a
+ * file from its mode.
+ *
+ * @param sb Status of the file.
+ *
+ * @return Object class of the file.
+ */
+uint32_t filesystem_stat_to_objclass(const struct stat64 *sb);
+
 // rather than having each sefs_entry having its own apol_context_t
 // object, build a cache of nodes to save space
 struct sefs_context_node
@@ -0,0 +1,445 @@
+/**
+ *  @file
+ *
+ *  Test querying and upgrading sefs databases.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <config.h>
+
+#include <CUnit/CUnit.h>
+#include <apol/util.h>
+#include <qpol/genfscon_query.h>
+#include <sefs/db.hh>
+#include <sefs/entry.hh>
+#include <sefs/filesystem.hh>
+#include <sefs/query.hh>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static char db_dir[] = "/tmp/sefs-db-tests-XXXXXX";
+static char *old_db = NULL, *new_db = NULL;
+
+/**
+ * A version 2 database, as written before paths were indexed and
+ * before timestamps were stored.
+ */
+static const char *old_db_sql =
+	"CREATE TABLE users (user_id INTEGER PRIMARY KEY, user_name varchar (24));"
+	"CREATE TABLE roles (role_id INTEGER PRIMARY KEY, role_name varchar (24));"
+	"CREATE TABLE types (type_id INTEGER PRIMARY KEY, type_name varchar (48));"
+	"CREATE TABLE devs (dev_id INTEGER PRIMARY KEY, dev_name varchar (32));"
+	"CREATE TABLE paths (path varchar (128) PRIMARY KEY, ino int(64), dev int, user int, role int, type int, range int, obj_class int, symlink_target varchar (128));"
+	"CREATE TABLE info (key varchar, value varchar);"
+	"INSERT INTO info VALUES ('dbversion', '2');"
+	"INSERT INTO info VALUES ('datetime', 'Thu Jan  1 00:00:00 2009');"
+	"INSERT INTO users VALUES (0, 'system_u');"
+	"INSERT INTO roles VALUES (0, 'object_r');"
+	"INSERT INTO types VALUES (0, 'etc_t');"
+	"INSERT INTO types VALUES (1, 'bin_t');"
+	"INSERT INTO types VALUES (2, 'lib_t');"
+	"INSERT INTO devs VALUES (0, '/dev/sda1');"
+	"INSERT INTO paths VALUES ('/etc', 1, 0, 0, 0, 0, 0, 7, '');"
+	"INSERT INTO paths VALUES ('/etc/passwd', 2, 0, 0, 0, 0, 0, 6, '');"
+	"INSERT INTO paths VALUES ('/usr/bin', 3, 0, 0, 0, 1, 0, 7, '');"
+	"INSERT INTO paths VALUES ('/usr/bin/ls', 4, 0, 0, 0, 1, 0, 6, '');"
+	"INSERT INTO paths VALUES ('/usr/lib', 5, 0, 0, 0, 2, 0, 7, '');"
+	"INSERT INTO paths VALUES ('/usr/lib/libc.so', 6, 0, 0, 0, 2, 0, 6, '');"
+	"INSERT INTO paths VALUES ('/usr/lib/libm.so', 7, 0, 0, 0, 2, 0, 6, '');"
+	"INSERT INTO paths VALUES ('/usr/lib/libm.so.6', 8, 0, 0, 0, 2, 0, 9, 'libm.so');"
+	"INSERT INTO paths VALUES ('/usr/lib64', 9, 0, 0, 0, 2, 0, 7, '');"
+	"INSERT INTO paths VALUES ('/usr/lib64/libz.so', 10, 0, 0, 0, 2, 0, 6, '');"
+	"INSERT INTO paths VALUES ('/usr/libexec/helper', 11, 0, 0, 0, 1, 0, 6, '');";
+
+struct db_query_case
+{
+	const char *path;
+	bool regex;
+	const char *type;
+	/** expected paths, in the order returned, ending with NULL */
+	const char *expected[12];
+};
+
+static const struct db_query_case db_query_cases[] = {
+	{NULL, false, NULL,
+	 {"/etc", "/etc/passwd", "/usr/bin", "/usr/bin/ls", "/usr/lib", "/usr/lib/libc.so", "/usr/lib/libm.so",
+	  "/usr/lib/libm.so.6", "/usr/lib64", "/usr/lib64/libz.so", "/usr/libexec/helper", NULL}},
+	{"/etc/passwd", false, NULL, {"/etc/passwd", NULL}},
+	{"/usr/lib", false, NULL, {"/usr/lib", NULL}},
+	{"/usr/lib/", false, NULL, {NULL}},
+	{"^/usr/lib/", true, NULL, {"/usr/lib/libc.so", "/usr/lib/libm.so", "/usr/lib/libm.so.6", NULL}},
+	{"^/usr/lib", true, NULL,
+	 {"/usr/lib", "/usr/lib/libc.so", "/usr/lib/libm.so", "/usr/lib/libm.so.6", "/usr/lib64", "/usr/lib64/libz.so",
+	  "/usr/libexec/helper", NULL}},
+	{"^/usr/lib", true, "lib_t",
+	 {"/usr/lib", "/usr/lib/libc.so", "/usr/lib/libm.so", "/usr/lib/libm.so.6", "/usr/lib64", "/usr/lib64/libz.so",
+	  NULL}},
+	{"^/usr/lib/libm\\.so", true, NULL, {"/usr/lib/libm.so", "/usr/lib/libm.so.6", NULL}},
+	{"^/usr/li+b/", true, NULL, {"/usr/lib/libc.so", "/usr/lib/libm.so", "/usr/lib/libm.so.6", NULL}},
+	{"^/usr/lib/lib[cm]", true, NULL, {"/usr/lib/libc.so", "/usr/lib/libm.so", "/usr/lib/libm.so.6", NULL}},
+	{"^/usr/bin|^/etc", true, NULL, {"/etc", "/etc/passwd", "/usr/bin", "/usr/bin/ls", NULL}},
+	{"\\.so$", true, NULL, {"/usr/lib/libc.so", "/usr/lib/libm.so", "/usr/lib64/libz.so", NULL}},
+	{NULL, false, "bin_t", {"/usr/bin", "/usr/bin/ls", "/usr/libexec/helper", NULL}},
+	{"/usr/bin/ls", false, "bin_t", {"/usr/bin/ls", NULL}},
+	{"/usr/bin/ls", false, "etc_t", {NULL}},
+	{NULL, false, "nosuch_t", {NULL}},
+	{NULL, false, NULL, {NULL}}
+};
+
+static void db_check_queries(sefs_db * db)
+{
+	for (const struct db_query_case * c = db_query_cases; c->path != NULL || c->type != NULL || c->expected[0] != NULL;
+	     c++)
+	{
+		sefs_query *q = new sefs_query();
+		q->path(c->path);
+		q->type(c->type, false);
+		q->regex(c->regex);
+		apol_vector_t *entries = NULL;
+		try
+		{
+			entries = db->runQuery(q);
+		}
+		catch(...)
+		{
+			CU_ASSERT(0);
+		}
+		delete q;
+		CU_ASSERT_PTR_NOT_NULL_FATAL(entries);
+		size_t i;
+		for (i = 0; c->expected[i] != NULL && i < apol_vector_get_size(entries); i++)
+		{
+			sefs_entry *e = static_cast < sefs_entry * >(apol_vector_get_element(entries, i));
+			CU_ASSERT_STRING_EQUAL(e->path(), c->expected[i]);
+			if (c->type != NULL)
+			{
+				CU_ASSERT_STRING_EQUAL(apol_context_get_type(e->context()), c->type);
+			}
+		}
+		CU_ASSERT(c->expected[i] == NULL && i == apol_vector_get_size(entries));
+		apol_vector_destroy(&entries);
+	}
+}
+
+static int db_count_callback(void *arg, int argc __attribute__ ((unused)), char **argv, char **column_names
+			     __attribute__ ((unused)))
+{
+	*(static_cast < int *>(arg)) = atoi(argv[0]);
+	return 0;
+}
+
+/**
+ * Read a count directly from a database file.
+ */
+static int db_count(const char *filename, const char *select_stmt)
+{
+	struct sqlite3 *sdb = NULL;
+	int count = -1;
+	CU_ASSERT_FATAL(sqlite3_open(filename, &sdb) == SQLITE_OK);
+	CU_ASSERT(sqlite3_exec(sdb, select_stmt, db_count_callback, &count, NULL) == SQLITE_OK);
+	sqlite3_close(sdb);
+	return count;
+}
+
+static void db_upgrade()
+{
+	sefs_db *db = NULL;
+	try
+	{
+		db = new sefs_db(old_db, NULL, NULL);
+	}
+	catch(...)
+	{
+		CU_ASSERT_FATAL(0);
+	}
+	CU_ASSERT_FALSE(db->isMLS());
+	db_check_queries(db);
+	delete db;
+
+	// opening the database upgraded it in place
+	CU_ASSERT(db_count(old_db, "SELECT value FROM info WHERE key = 'dbversion'") == 4);
+	CU_ASSERT(db_count(old_db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name LIKE 'paths_%'") == 7);
+	CU_ASSERT(db_count(old_db, "SELECT COUNT(*) FROM paths") == 11);
+}
+
+static void db_saved()
+{
+	sefs_db *db = NULL;
+	try
+	{
+		db = new sefs_db(old_db, NULL, NULL);
+		db->save(new_db);
+	}
+	catch(...)
+	{
+		delete db;
+		CU_ASSERT_FATAL(0);
+	}
+	delete db;
+	db = NULL;
+
+	// a saved database holds the same entries and indexes
+	CU_ASSERT(sefs_db::isDB(new_db));
+	CU_ASSERT(db_count(new_db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name LIKE 'paths_%'") == 7);
+	try
+	{
+		db = new sefs_db(new_db, NULL, NULL);
+	}
+	catch(...)
+	{
+		CU_ASSERT_FATAL(0);
+	}
+	db_check_queries(db);
+	delete db;
+}
+
+static int db_describe_entry(sefs_fclist * fclist __attribute__ ((unused)), const sefs_entry * e, void *data)
+{
+	apol_vector_t *v = static_cast < apol_vector_t * >(data);
+	char *s = NULL;
+	if (asprintf(&s, "%s %s %u %lu %s", e->path(), apol_context_get_type(e->context()), e->objectClass(),
+		     static_cast < unsigned long >(e->inode()), e->dev()) < 0)
+	{
+		return -1;
+	}
+	if (apol_vector_append(v, s) < 0)
+	{
+		free(s);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Describe every entry of a file context list, sorted by path.
+ */
+static apol_vector_t *db_describe(sefs_fclist * fclist)
+{
+	apol_vector_t *v = apol_vector_create(free);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(v);
+	int retval = -1;
+	try
+	{
+		retval = fclist->runQueryMap(NULL, db_describe_entry, v);
+	}
+	catch(...)
+	{
+	}
+	CU_ASSERT(retval >= 0);
+	apol_vector_sort(v, apol_str_strcmp, NULL);
+	return v;
+}
+
+/**
+ * Check that a database holds exactly the entries of a filesystem.
+ */
+static void db_compare_fs(sefs_db * db, sefs_filesystem * fs)
+{
+	apol_vector_t *v = db_describe(db);
+	apol_vector_t *w = db_describe(fs);
+	CU_ASSERT(apol_vector_get_size(v) == apol_vector_get_size(w));
+	for (size_t i = 0; i < apol_vector_get_size(v) && i < apol_vector_get_size(w); i++)
+	{
+		CU_ASSERT_STRING_EQUAL(static_cast < char *>(apol_vector_get_element(v, i)),
+				       static_cast < char *>(apol_vector_get_element(w, i)));
+	}
+	apol_vector_destroy(&v);
+	apol_vector_destroy(&w);
+}
+
+static char *db_tree_path(const char *root, const char *name)
+{
+	char *s = NULL;
+	CU_ASSERT_FATAL(asprintf(&s, "%s/%s", root, name) >= 0);
+	return s;
+}
+
+static void db_tree_file(const char *root, const char *name)
+{
+	char *s = db_tree_path(root, name);
+	FILE *f = fopen(s, "w");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	fprintf(f, "%s\n", name);
+	fclose(f);
+	free(s);
+}
+
+static void db_tree_link(const char *root, const char *target, const char *name)
+{
+	char *s = db_tree_path(root, name);
+	unlink(s);
+	CU_ASSERT(symlink(target, s) == 0);
+	free(s);
+}
+
+static void db_tree_remove(const char *root, const char *name)
+{
+	char *s = db_tree_path(root, name);
+	CU_ASSERT(remove(s) == 0);
+	free(s);
+}
+
+static void db_update()
+{
+	char *root = db_tree_path(db_dir, "tree");
+	CU_ASSERT_FATAL(mkdir(root, 0755) == 0);
+	db_tree_file(root, "a");
+	db_tree_file(root, "b");
+	char *sub = db_tree_path(root, "sub");
+	CU_ASSERT_FATAL(mkdir(sub, 0755) == 0);
+	db_tree_file(root, "sub/c");
+	db_tree_file(root, "sub/d");
+	db_tree_link(root, "a", "link");
+	db_tree_link(root, "sub", "dirlink");
+
+	sefs_filesystem *fs = NULL;
+	try
+	{
+		fs = new sefs_filesystem(root, NULL, NULL);
+	}
+	catch(...)
+	{
+		// the filesystem holding the test directory does not
+		// support SELinux contexts, so there is nothing to index
+	}
+	sefs_db *db = NULL;
+	if (fs != NULL)
+	{
+		try
+		{
+			db = new sefs_db(fs, NULL, NULL);
+		}
+		catch(...)
+		{
+			CU_ASSERT(0);
+		}
+	}
+
+	if (db != NULL)
+	{
+		db_compare_fs(db, fs);
+
+		// an update with nothing changed must not alter
+		// anything, including symbolic links
+		try
+		{
+			db->update(fs);
+		}
+		catch(...)
+		{
+			CU_ASSERT(0);
+		}
+		db_compare_fs(db, fs);
+
+		// add, remove, and relink files; then remove a whole
+		// directory
+		db_tree_file(root, "e");
+		db_tree_file(root, "sub/f");
+		db_tree_remove(root, "b");
+		db_tree_remove(root, "sub/c");
+		db_tree_link(root, "e", "link");
+		try
+		{
+			db->update(fs);
+		}
+		catch(...)
+		{
+			CU_ASSERT(0);
+		}
+		db_compare_fs(db, fs);
+
+		db_tree_remove(root, "dirlink");
+		db_tree_remove(root, "sub/d");
+		db_tree_remove(root, "sub/f");
+		db_tree_remove(root, "sub");
+		db_tree_link(root, "a", "link");
+		try
+		{
+			db->update(fs);
+		}
+		catch(...)
+		{
+			CU_ASSERT(0);
+		}
+		db_compare_fs(db, fs);
+	}
+	delete db;
+	delete fs;
+
+	// remove whatever remains of the tree
+	const char *names[] = { "dirlink", "link", "a", "b", "e", "sub/c", "sub/d", "sub/f", "sub", NULL };
+	for (const char **name = names; *name != NULL; name++)
+	{
+		char *s = db_tree_path(root, *name);
+		remove(s);
+		free(s);
+	}
+	rmdir(root);
+	free(sub);
+	free(root);
+}
+
+CU_TestInfo db_tests[] = {
+	{"db upgrade and query", db_upgrade}
+	,
+	{"db save and query", db_saved}
+	,
+	{"db update", db_update}
+	,
+	CU_TEST_INFO_NULL
+};
+
+int db_init()
+{
+	if (mkdtemp(db_dir) == NULL)
+	{
+		return 1;
+	}
+	if (asprintf(&old_db, "%s/old.db", db_dir) < 0 || asprintf(&new_db, "%s/new.db", db_dir) < 0)
+	{
+		return 1;
+	}
+	struct sqlite3 *sdb = NULL;
+	if (sqlite3_open(old_db, &sdb) != SQLITE_OK)
+	{
+		sqlite3_close(sdb);
+		return 1;
+	}
+	int rc = sqlite3_exec(sdb, old_db_sql, NULL, NULL, NULL);
+	sqlite3_close(sdb);
+	return (rc == SQLITE_OK ? 0 : 1);
+}
+
+int db_cleanup()
+{
+	if (old_db != NULL)
+	{
+		unlink(old_db);
+	}
+	if (new_db != NULL)
+	{
+		unlink(new_db);
+	}
+	free(old_db);
+	free(new_db);
+	old_db = new_db = NULL;
+	rmdir(db_dir);
+	return 0;
+}
@@ -28,6 +28,7 @@
 #include <CUnit/CUnit.h>
 #include <CUnit/Basic.h>
 
+#include "db-tests.hh"
 #include "fcfile-tests.hh"
 
 int main(void)
@@ -40,6 +41,8 @@ int main(void)
 	CU_SuiteInfo suites[] = {
 		{"fcfile", fcfile_init, fcfile_cleanup, fcfile_tests}
 		,
+		{"db", db_init, db_cleanup, db_tests}
+		,
 		CU_SUITE_INFO_NULL
 	};
 
@@ -118,6 +118,7 @@ static const struct view_column_record column_data[] = {
 	{PID_FIELD, "PID", "12345", seaudit_sort_by_pid},
 	{INODE_FIELD, "Inode", "123456", seaudit_sort_by_inode},
 	{PATH_FIELD, "Path", "/home/gburdell/foo", seaudit_sort_by_path},
+	{VERDICT_FIELD, "Verdict", "Allowed", NULL},
 	{OTHER_FIELD, "Other", "Lorem ipsum dolor sit amet, consectetur", NULL}
 };
 
@@ -539,6 +540,23 @@ static void message_view_store_get_value(GtkTreeModel * tree_model, GtkTreeIter
 		message_view_to_utf8(value, seaudit_avc_message_get_path(avc));
 		return;
 	}
+	case VERDICT_FIELD:
+	{
+		/* blank if there is no policy or the message does not
+		 * apply to it */
+		apol_policy_t *policy = toplevel_get_policy(view->top);
+		const char *verdict = "";
+		if (policy != NULL) {
+			int allowed = seaudit_avc_message_is_allowed(avc, policy);
+			if (allowed > 0) {
+				verdict = "Allowed";
+			} else if (allowed == 0) {
+				verdict = "Denied";
+			}
+		}
+		message_view_to_utf8(value, verdict);
+		return;
+	}
 	default:		       /* FALLTHROUGH */
 		break;
 	}
@@ -660,6 +678,28 @@ static void message_view_dialog_change(GtkTreeModel * tree_model,
 	gtk_dialog_set_response_sensitive(d->dialog, LFORWARD, FALSE);
 }
 
+/**
+ * Append to a message dialog whether or not the loaded policy allows
+ * an AVC message's permissions.
+ */
+static void message_view_insert_verdict(GtkTextBuffer * buffer, GtkTextIter * text_iter, const seaudit_avc_message_t * avc,
+					apol_policy_t * policy)
+{
+	const char *verdict;
+	switch (seaudit_avc_message_is_allowed(avc, policy)) {
+	case 1:
+		verdict = "(allowed by the loaded policy)\n";
+		break;
+	case 0:
+		verdict = "(denied by the loaded policy)\n";
+		break;
+	default:
+		verdict = "(not applicable to the loaded policy)\n";
+		break;
+	}
+	gtk_text_buffer_insert(buffer, text_iter, verdict, -1);
+}
+
 static void message_view_dialog_response(GtkDialog * dialog, gint response, gpointer user_data)
 {
 	_msg_user_data_t *d = (_msg_user_data_t *) user_data;
@@ -669,6 +709,7 @@ static void message_view_dialog_response(GtkDialog * dialog, gint response, gpoi
 	size_t i;
 	gboolean go_back = FALSE;
 	gboolean go_forward = FALSE;
+	apol_policy_t *policy;
 
 	gtk_text_buffer_set_text(d->buffer, "", -1);
 	p = apol_vector_get_element(d->messages, 0);
@@ -717,8 +758,11 @@ static void message_view_dialog_response(GtkDialog * dialog, gint response, gpoi
 	gtk_dialog_set_response_sensitive(dialog, LFORWARD, go_forward);
 
 	gtk_text_buffer_get_start_iter(d->buffer, &text_iter);
+	policy = toplevel_get_policy(d->view->top);
 	for (i = 0; i < apol_vector_get_size(d->messages); i++) {
 		char *s;
+		seaudit_message_type_e type;
+		void *data;
 		p = apol_vector_get_element(d->messages, i);
 		message_view_store_get_iter(GTK_TREE_MODEL(d->view->store), &tree_iter, p);
 		if ((s = seaudit_message_to_string(tree_iter.user_data)) == NULL) {
@@ -729,6 +773,10 @@ static void message_view_dialog_response(GtkDialog * dialog, gint response, gpoi
 		gtk_text_buffer_insert(d->buffer, &text_iter, s, -1);
 		gtk_text_buffer_insert(d->buffer, &text_iter, "\n", -1);
 		free(s);
+		data = seaudit_message_get_data(tree_iter.user_data, &type);
+		if (policy != NULL && type == SEAUDIT_MESSAGE_TYPE_AVC) {
+			message_view_insert_verdict(d->buffer, &text_iter, data, policy);
+		}
 	}
 }
 
@@ -74,6 +74,7 @@ static const struct visible_field default_visible_fields[] = {
 	{PID_FIELD, "pid_field", 0},
 	{INODE_FIELD, "inode_field", 0},
 	{PATH_FIELD, "path_field", 0},
+	{VERDICT_FIELD, "verdict_field", 0},
 	{OTHER_FIELD, "other_field", 1}
 };
 
@@ -41,7 +41,7 @@ typedef enum preference_field
 	TUSER_FIELD, TROLE_FIELD, TTYPE_FIELD, TMLS_LVL_FIELD, TMLS_CLR_FIELD,
 	OBJCLASS_FIELD, PERM_FIELD,
 	EXECUTABLE_FIELD, COMMAND_FIELD, NAME_FIELD,
-	PID_FIELD, INODE_FIELD, PATH_FIELD, OTHER_FIELD
+	PID_FIELD, INODE_FIELD, PATH_FIELD, VERDICT_FIELD, OTHER_FIELD
 } preference_field_e;
 
 /**
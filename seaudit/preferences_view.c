@@ -90,6 +90,7 @@ static const struct pref_toggle pref_toggle_map[] = {
 	{"PIDCheck", PID_FIELD},
 	{"InodeCheck", INODE_FIELD},
 	{"PathCheck", PATH_FIELD},
+	{"VerdictCheck", VERDICT_FIELD},
 	{"OtherCheck", OTHER_FIELD}
 };
 static const size_t num_toggles = sizeof(pref_toggle_map) / sizeof(pref_toggle_map[0]);
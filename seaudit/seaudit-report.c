@@ -31,6 +31,7 @@
 
 #include <config.h>
 
+#include <seaudit/follow.h>
 #include <seaudit/log.h>
 #include <seaudit/parse.h>
 #include <seaudit/report.h>
@@ -39,6 +40,7 @@
 
 #include <errno.h>
 #include <getopt.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -56,6 +58,7 @@ static struct option const longopts[] = {
 	{"output", required_argument, NULL, 'o'},
 	{"stylesheet", required_argument, NULL, OPT_STYLESHEET},
 	{"stdin", no_argument, NULL, 's'},
+	{"follow", no_argument, NULL, 'f'},
 	{"config", required_argument, NULL, 'c'},
 	{"help", no_argument, NULL, 'h'},
 	{"version", no_argument, NULL, 'V'},
@@ -73,6 +76,12 @@ static apol_vector_t *logs = NULL;
  */
 static seaudit_log_t *first_log = NULL;
 
+/**
+ * Vector of seaudit_follower_t, one per log file, if the --follow
+ * option was given; otherwise NULL.
+ */
+static apol_vector_t *followers = NULL;
+
 /**
  * Model that incorporates all of the logs within the logs vector.
  */
@@ -98,6 +107,8 @@ static void seaudit_report_info_usage(const char *program_name, int brief)
 	}
 	printf("Generate a customized SELinux log report.\n\n");
 	printf("  -s, --stdin              read log data from standard input\n");
+	printf("  -f, --follow             keep reading the log files as they grow,\n");
+	printf("                           rewriting the report whenever messages are added\n");
 	printf("  -m, --malformed          include malformed log messages\n");
 	printf("  -o FILE, --output=FILE   output to FILE\n");
 	printf("  -c FILE, --config=FILE   read configuration from FILE\n");
@@ -113,16 +124,19 @@ static void seaudit_report_info_usage(const char *program_name, int brief)
 static void parse_command_line_args(int argc, char **argv)
 {
 	int optc, i;
-	int do_malformed = 0, do_style = 0, read_stdin = 0;
+	int do_malformed = 0, do_style = 0, read_stdin = 0, do_follow = 0;
 	seaudit_report_format_e format = SEAUDIT_REPORT_FORMAT_TEXT;
 	char *configfile = NULL, *stylesheet = NULL;
 
 	/* get option arguments */
-	while ((optc = getopt_long(argc, argv, "smo:c:hV", longopts, NULL)) != -1) {
+	while ((optc = getopt_long(argc, argv, "sfmo:c:hV", longopts, NULL)) != -1) {
 		switch (optc) {
 		case 's':	       /* read LOGFILES from standard input */
 			read_stdin = 1;
 			break;
+		case 'f':	       /* follow LOGFILES as they grow */
+			do_follow = 1;
+			break;
 		case 'm':	       /* include malformed messages */
 			do_malformed = 1;
 			break;
@@ -162,6 +176,11 @@ static void parse_command_line_args(int argc, char **argv)
 		exit(-1);
 	}
 
+	if (read_stdin && do_follow) {
+		fprintf(stderr, "ERROR: The --follow option cannot be used with --stdin.\n");
+		exit(-1);
+	}
+
 	if (!read_stdin && optind >= argc) {
 		/* display usage and handle error */
 		seaudit_report_info_usage(argv[0], 1);
@@ -191,22 +210,21 @@ static void parse_command_line_args(int argc, char **argv)
 	} else {
 		/* Parse given filenames */
 		FILE *f;
-		seaudit_log_t *l;
-		if ((f = fopen(argv[optind], "r")) == NULL) {
+		seaudit_log_t *l = first_log;
+		seaudit_follower_t *follower;
+		if (do_follow && (followers = apol_vector_create(NULL)) == NULL) {
 			fprintf(stderr, "ERROR: %s\n", strerror(errno));
 			exit(-1);
 		}
-		if (seaudit_log_parse(first_log, f) < 0) {
-			exit(-1);
-		}
-		fclose(f);
-		for (i = optind + 1; i < argc; i++) {
-			if ((l = seaudit_log_create(NULL, NULL)) == NULL || seaudit_model_append_log(model, l) < 0) {
-				exit(-1);
-			}
-			if (apol_vector_append(logs, l) < 0) {
-				fprintf(stderr, "ERROR: %s\n", strerror(errno));
-				exit(-1);
+		for (i = optind; i < argc; i++) {
+			if (i > optind) {
+				if ((l = seaudit_log_create(NULL, NULL)) == NULL || seaudit_model_append_log(model, l) < 0) {
+					exit(-1);
+				}
+				if (apol_vector_append(logs, l) < 0) {
+					fprintf(stderr, "ERROR: %s\n", strerror(errno));
+					exit(-1);
+				}
 			}
 			if ((f = fopen(argv[i], "r")) == NULL) {
 				fprintf(stderr, "ERROR: %s\n", strerror(errno));
@@ -215,6 +233,15 @@ static void parse_command_line_args(int argc, char **argv)
 			if (seaudit_log_parse(l, f) < 0) {
 				exit(-1);
 			}
+			if (do_follow) {
+				/* resume from wherever the initial parse stopped */
+				long offset = ftell(f);
+				if ((follower = seaudit_follower_create(l, argv[i], (offset < 0 ? 0 : (size_t) offset))) == NULL ||
+				    apol_vector_append(followers, follower) < 0) {
+					fprintf(stderr, "ERROR: %s\n", strerror(errno));
+					exit(-1);
+				}
+			}
 			fclose(f);
 		}
 	}
@@ -228,6 +255,51 @@ static void parse_command_line_args(int argc, char **argv)
 	}
 }
 
+/**
+ * Wait for the followed log files to grow, and rewrite the report
+ * each time messages are added.  If the system can notify of file
+ * changes then sleep until that happens; otherwise check the files
+ * once a second.  This function only returns upon error.
+ */
+static void follow_logs(void)
+{
+	size_t i, num_followers = apol_vector_get_size(followers);
+	struct pollfd *fds;
+	nfds_t num_fds = 0;
+	if ((fds = calloc(num_followers, sizeof(*fds))) == NULL) {
+		fprintf(stderr, "ERROR: %s\n", strerror(errno));
+		return;
+	}
+	for (i = 0; i < num_followers; i++) {
+		int fd = seaudit_follower_get_fd(apol_vector_get_element(followers, i));
+		if (fd >= 0) {
+			fds[num_fds].fd = fd;
+			fds[num_fds].events = POLLIN;
+			num_fds++;
+		}
+	}
+	while (1) {
+		int added = 0, retval;
+		/* only block indefinitely if every file has a change
+		 * notifier */
+		if (poll(fds, num_fds, (num_fds == num_followers ? -1 : 1000)) < 0 && errno != EINTR) {
+			fprintf(stderr, "ERROR: %s\n", strerror(errno));
+			break;
+		}
+		for (i = 0; i < num_followers; i++) {
+			if ((retval = seaudit_follower_read(apol_vector_get_element(followers, i))) < 0) {
+				goto err;
+			}
+			added += retval;
+		}
+		if (added > 0 && seaudit_report_write(first_log, report, outfile) < 0) {
+			goto err;
+		}
+	}
+      err:
+	free(fds);
+}
+
 int main(int argc, char **argv)
 {
 	size_t i;
@@ -235,6 +307,10 @@ int main(int argc, char **argv)
 	if (seaudit_report_write(first_log, report, outfile) < 0) {
 		return -1;
 	}
+	if (followers != NULL) {
+		follow_logs();
+		return -1;
+	}
 	seaudit_report_destroy(&report);
 	seaudit_model_destroy(&model);
 	for (i = 0; i < apol_vector_get_size(logs); i++) {
@@ -30,6 +30,7 @@
 #include "toplevel.h"
 
 #include <apol/util.h>
+#include <seaudit/follow.h>
 #include <seaudit/model.h>
 #include <seaudit/parse.h>
 #include <seaudit/util.h>
@@ -48,7 +49,8 @@ struct seaudit
 	apol_policy_t *policy;
 	apol_policy_path_t *policy_path;
 	seaudit_log_t *log;
-	FILE *file;
+	/** follows the log file for real-time monitoring */
+	seaudit_follower_t *follower;
 	char *log_path;
 	size_t num_log_messages;
 	const struct tm *first, *last;
@@ -99,17 +101,22 @@ apol_policy_path_t *seaudit_get_policy_path(seaudit_t * s)
 
 void seaudit_set_log(seaudit_t * s, seaudit_log_t * log, FILE * f, const char *filename)
 {
-	if (s->file != NULL) {
-		fclose(s->file);
-		s->file = NULL;
-	}
+	seaudit_follower_destroy(&s->follower);
 	if (log != NULL) {
 		seaudit_model_t *model = NULL;
 		apol_vector_t *messages = NULL;
+		seaudit_follower_t *follower = NULL;
 		char *t = NULL;
+		long offset = (f != NULL ? ftell(f) : 0);
+		if (f != NULL) {
+			fclose(f);
+		}
+		/* resume following from wherever the initial parse
+		 * stopped */
 		if ((model = seaudit_model_create(NULL, log)) == NULL ||
 		    (messages = seaudit_model_get_messages(log, model)) == NULL ||
-		    (t = strdup(filename)) == NULL || preferences_add_recent_log(s->prefs, filename) < 0) {
+		    (t = strdup(filename)) == NULL || preferences_add_recent_log(s->prefs, filename) < 0 ||
+		    (follower = seaudit_follower_create(log, filename, (offset < 0 ? 0 : (size_t) offset))) == NULL) {
 			toplevel_ERR(s->top, "%s", strerror(errno));
 			seaudit_log_destroy(&log);
 			seaudit_model_destroy(&model);
@@ -121,7 +128,7 @@ void seaudit_set_log(seaudit_t * s, seaudit_log_t * log, FILE * f, const char *f
 		 * s->log_path */
 		seaudit_log_destroy(&s->log);
 		s->log = log;
-		s->file = f;
+		s->follower = follower;
 		free(s->log_path);
 		s->log_path = t;
 		s->num_log_messages = apol_vector_get_size(messages);
@@ -136,6 +143,9 @@ void seaudit_set_log(seaudit_t * s, seaudit_log_t * log, FILE * f, const char *f
 		seaudit_model_destroy(&model);
 		apol_vector_destroy(&messages);
 	} else {
+		if (f != NULL) {
+			fclose(f);
+		}
 		seaudit_log_destroy(&s->log);
 		free(s->log_path);
 		s->log_path = NULL;
@@ -144,9 +154,21 @@ void seaudit_set_log(seaudit_t * s, seaudit_log_t * log, FILE * f, const char *f
 	}
 }
 
-int seaudit_parse_log(seaudit_t * s)
+int seaudit_follow_log(seaudit_t * s)
 {
-	return seaudit_log_parse(s->log, s->file);
+	if (s->follower == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	return seaudit_follower_read(s->follower);
+}
+
+int seaudit_get_log_fd(seaudit_t * s)
+{
+	if (s->follower == NULL) {
+		return -1;
+	}
+	return seaudit_follower_get_fd(s->follower);
 }
 
 seaudit_log_t *seaudit_get_log(seaudit_t * s)
@@ -241,10 +263,8 @@ static void seaudit_destroy(seaudit_t ** s)
 {
 	if (s != NULL && *s != NULL) {
 		apol_policy_destroy(&(*s)->policy);
+		seaudit_follower_destroy(&(*s)->follower);
 		seaudit_log_destroy(&(*s)->log);
-		if ((*s)->file != NULL) {
-			fclose((*s)->file);
-		}
 		preferences_destroy(&(*s)->prefs);
 		toplevel_destroy(&(*s)->top);
 		free((*s)->policy_path);
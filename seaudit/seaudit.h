@@ -88,22 +88,37 @@ apol_policy_path_t *seaudit_get_policy_path(seaudit_t * s);
  * @param s seaudit object to modify.
  * @param log New log file for seaudit.  If NULL then seaudit has no
  * log files opened.  Afterwards seaudit takes ownership of the log.
- * @param f File handler that was used to open the log.  Afterwards
- * seaudit takes ownership of this handler.
+ * @param f File handler that was used to open the log.  Its current
+ * position marks how much of the file has been parsed; subsequent
+ * calls to seaudit_follow_log() resume from there.  Afterwards
+ * seaudit closes this handler.
  * @param filename If log is not NULL, then add this filename to the
  * most recently used files.
  */
 void seaudit_set_log(seaudit_t * s, seaudit_log_t * log, FILE * f, const char *filename);
 
 /**
- * Command seaudit to (re)parse its log file.
+ * Command seaudit to parse any lines appended to its log file since
+ * the last call.  If the log file was rotated or truncated then it is
+ * reopened and parsed from the beginning.
  *
  * @param s seaudit object containing the log.
  *
- * @return 0 if log parsed cleanly, < 0 upon errors, or > 0 if there
- * were warnings.
+ * @return Number of messages added to the log, or < 0 upon errors.
  */
-int seaudit_parse_log(seaudit_t * s);
+int seaudit_follow_log(seaudit_t * s);
+
+/**
+ * Get a file descriptor that becomes readable whenever the log file
+ * may have changed, so that the caller need not poll it.
+ *
+ * @param s seaudit object containing the log.
+ *
+ * @return A file descriptor, or -1 if there is no log or if the
+ * system cannot notify of file changes.  Do not read from or close
+ * the descriptor.
+ */
+int seaudit_get_log_fd(seaudit_t * s);
 
 /**
  * Retrieve the currently loaded log file.
@@ -511,32 +511,53 @@ struct log_run_datum
  * To make this function fully thread-safe requires making this entire
  * function synchronized, and then employ locking every time
  * do_monitor_log and monitor_id are set.
+ *
+ * @param top Toplevel whose log to update.
+ *
+ * @return 0 on success, < 0 on error.  Upon error monitoring has been
+ * disabled and monitor_id cleared; the caller must not reschedule
+ * itself.
+ */
+static int toplevel_monitor_log_update(toplevel_t * top)
+{
+	int retval;
+	gint i = gtk_notebook_get_n_pages(top->notebook) - 1;
+	retval = seaudit_follow_log(top->s);
+	if (retval < 0) {
+		GtkCheckMenuItem *w;
+		toplevel_ERR(top, "Error while monitoring log: %s", strerror(errno));
+		w = GTK_CHECK_MENU_ITEM(glade_xml_get_widget(top->xml, "MonitorLog"));
+		top->do_monitor_log = 0;
+		top->monitor_id = 0;
+		gtk_check_menu_item_set_active(w, 0);
+		return -1;
+	}
+	if (retval == 0) {
+		/* nothing new, so do not bother refreshing the views */
+		return 0;
+	}
+	while (i >= 0) {
+		GtkWidget *child = gtk_notebook_get_nth_page(top->notebook, i);
+		GtkWidget *tab = gtk_notebook_get_tab_label(top->notebook, child);
+		message_view_t *v = g_object_get_data(G_OBJECT(tab), "view-object");
+		message_view_update_rows(v);
+		i--;
+	}
+	return 0;
+}
+
+/**
+ * Callback used when the system cannot notify of log file changes.
+ * Check the log, then reschedule another timer callback.
  */
 static gboolean toplevel_monitor_log_timer(gpointer data)
 {
 	toplevel_t *top = (toplevel_t *) data;
 	if (top->do_monitor_log) {
-		int retval;
-		gint i = gtk_notebook_get_n_pages(top->notebook) - 1;
 		uint delay;
-		retval = seaudit_parse_log(top->s);
-		if (retval < 0) {
-			GtkCheckMenuItem *w;
-			toplevel_ERR(top, "Error while monitoring log: %s", strerror(errno));
-			w = GTK_CHECK_MENU_ITEM(glade_xml_get_widget(top->xml, "MonitorLog"));
-			top->monitor_id = 0;
-			gtk_check_menu_item_set_active(w, 0);
+		if (toplevel_monitor_log_update(top) < 0) {
 			return FALSE;
 		}
-		while (i >= 0) {
-			GtkWidget *child = gtk_notebook_get_nth_page(top->notebook, i);
-			GtkWidget *tab = gtk_notebook_get_tab_label(top->notebook, child);
-			message_view_t *v = g_object_get_data(G_OBJECT(tab), "view-object");
-			message_view_update_rows(v);
-			i--;
-		}
-
-		/* reschedule another timer callback */
 		delay = preferences_get_real_time_interval(toplevel_get_prefs(top));
 		top->monitor_id = g_timeout_add(delay, toplevel_monitor_log_timer, top);
 	} else {
@@ -546,10 +567,30 @@ static gboolean toplevel_monitor_log_timer(gpointer data)
 }
 
 /**
- * Enable or disable the log monitoring feature.  While enabled, the
- * log file will be periodically polled; new lines will be parsed and
- * inserted into the seaudit log object.  All models and their views
- * will then be notified of the changes.
+ * Callback invoked by the main loop whenever the log's change
+ * notification descriptor becomes readable.
+ */
+static gboolean toplevel_monitor_log_notify(GIOChannel * source __attribute__ ((unused)), GIOCondition condition
+					    __attribute__ ((unused)), gpointer data)
+{
+	toplevel_t *top = (toplevel_t *) data;
+	if (top->do_monitor_log) {
+		if (toplevel_monitor_log_update(top) < 0) {
+			return FALSE;
+		}
+		return TRUE;
+	}
+	top->monitor_id = 0;
+	return FALSE;
+}
+
+/**
+ * Enable or disable the log monitoring feature.  While enabled, new
+ * lines appended to the log file will be parsed and inserted into
+ * the seaudit log object.  All models and their views will then be
+ * notified of the changes.  Where supported the main loop is woken
+ * up by the system whenever the file changes; otherwise the file is
+ * polled periodically.
  *
  * @param top Toplevel object whose widgets to update.
  */
@@ -560,8 +601,21 @@ static void toplevel_monitor_log(toplevel_t * top)
 	if (top->do_monitor_log) {
 		gtk_label_set_markup(label, "Monitor Status: <span foreground=\"green\">ON</span>");
 		if (top->monitor_id == 0) {
-			uint delay = preferences_get_real_time_interval(toplevel_get_prefs(top));
-			top->monitor_id = g_timeout_add(delay, toplevel_monitor_log_timer, top);
+			int fd;
+			/* catch up on anything written while monitoring
+			 * was off; upon error monitoring is now disabled */
+			if (toplevel_monitor_log_update(top) < 0 || !top->do_monitor_log) {
+				return;
+			}
+			if ((fd = seaudit_get_log_fd(top->s)) >= 0) {
+				GIOChannel *channel = g_io_channel_unix_new(fd);
+				top->monitor_id = g_io_add_watch(channel, G_IO_IN, toplevel_monitor_log_notify, top);
+				/* the watch holds its own reference */
+				g_io_channel_unref(channel);
+			} else {
+				uint delay = preferences_get_real_time_interval(toplevel_get_prefs(top));
+				top->monitor_id = g_timeout_add(delay, toplevel_monitor_log_timer, top);
+			}
 		}
 	} else {
 		if (top->monitor_id > 0) {
@@ -575,9 +629,8 @@ static void toplevel_monitor_log(toplevel_t * top)
 /**
  * Thread that loads and parses a log file.  It will write to
  * progress_seaudit_handle_func() its status during the load.  Note
- * that the file handle is not closed upon completion; it is left open
- * so that subsequent calls to seaudit_log_parse(), such as
- * forreal-time monitoring.
+ * that the file handle is not closed upon completion; its position
+ * tells seaudit_set_log() where real-time monitoring should resume.
  *
  * @param data Pointer to a struct log_run_datum, for control
  * information.
@@ -723,6 +776,9 @@ int toplevel_open_policy(toplevel_t * top, apol_policy_path_t * path)
 	toplevel_update_title_bar(top);
 	toplevel_update_status_bar(top);
 	policy_view_update(top->pv, path);
+	/* repaint so that the message views' verdict columns reflect
+	 * the new policy */
+	gtk_widget_queue_draw(GTK_WIDGET(top->w));
 	return 0;
 }
 
@@ -766,7 +766,9 @@ int sechk_lib_run_modules(sechk_lib_t * lib)
 			errno = ENOTSUP;
 			return -1;
 		}
+		qpol_stats_begin(apol_policy_get_stats(lib->policy), mod->name);
 		retv = run_fn(mod, lib->policy, NULL);
+		qpol_stats_end(apol_policy_get_stats(lib->policy));
 
 		if (retv < 0) {
 			/* module failure */
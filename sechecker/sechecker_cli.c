@@ -38,7 +38,7 @@ extern sechk_module_name_reg_t sechk_register_list[];
 
 enum opt_values
 {
-	OPT_FCFILE = 256, OPT_MIN_SEV
+	OPT_FCFILE = 256, OPT_MIN_SEV, OPT_TIMING
 };
 
 /* command line options struct */
@@ -53,6 +53,7 @@ static struct option const longopts[] = {
 	{"fcfile", required_argument, NULL, OPT_FCFILE},
 	{"module", required_argument, NULL, 'm'},
 	{"min-sev", required_argument, NULL, OPT_MIN_SEV},
+	{"timing", no_argument, NULL, OPT_TIMING},
 	{NULL, 0, NULL, 0}
 };
 
@@ -77,6 +78,7 @@ void usage(const char *arg0, bool brief)
 		printf("   -s, --short                  print short output\n");
 		printf("   -v, --verbose                print verbose output\n");
 		printf("   --min-sev={low|med|high}     set the minimum severity to report\n");
+		printf("   --timing                     print the time taken by each phase of work\n");
 		printf("\n");
 		printf("   -l, --list                   print a list of profiles and modules and exit\n");
 		printf("   -h[MODULE], --help[=MODULE]  print this help text or help for MODULE\n");
@@ -129,6 +131,7 @@ int main(int argc, char **argv)
 	sechk_module_t *mod = NULL;
 	bool list_stop = false;
 	bool module_help = false;
+	bool timing = false;
 	apol_vector_t *policy_mods = NULL;
 
 	while ((optc = getopt_long(argc, argv, "p:m:qsvlh::V", longopts, NULL)) != -1) {
@@ -180,6 +183,9 @@ int main(int argc, char **argv)
 			}
 			minsev = strdup(optarg);
 			break;
+		case OPT_TIMING:
+			timing = true;
+			break;
 		case 'l':
 			list_stop = true;
 			break;
@@ -340,6 +346,9 @@ int main(int argc, char **argv)
 	if (sechk_lib_print_modules_report(lib))
 		goto exit_err;
 
+	if (timing)
+		qpol_stats_print(apol_policy_get_stats(lib->policy), "Timing:", stderr);
+
       exit:
 	free(fcpath);
 	apol_vector_destroy(&policy_mods);
@@ -39,6 +39,7 @@ using namespace std;
 
 static struct option const longopts[] = {
 	{"directory", required_argument, NULL, 'd'},
+	{"update", no_argument, NULL, 'u'},
 	{"help", no_argument, NULL, 'h'},
 	{"version", no_argument, NULL, 'V'},
 	{NULL, 0, NULL, 0}
@@ -55,6 +56,7 @@ static void usage(const char *program_name, bool brief)
 	cout << "Index SELinux contexts on the filesystem." << endl;
 	cout << endl;
 	cout << "  -d DIR, --directory=DIR  start scanning at directory DIR (default \"/\")" << endl;
+	cout << "  -u, --update             update FILE in place, re-reading only changed files" << endl;
 	cout << "  -h, --help               print this help text and exit" << endl;
 	cout << "  -V, --version            print version information and exit" << endl;
 }
@@ -64,14 +66,18 @@ int main(int argc, char *argv[])
 	int optc;
 
 	char *outfilename = NULL, *dir = "/";
+	bool update = false;
 
-	while ((optc = getopt_long(argc, argv, "d:hV", longopts, NULL)) != -1)
+	while ((optc = getopt_long(argc, argv, "d:uhV", longopts, NULL)) != -1)
 	{
 		switch (optc)
 		{
 		case 'd':	       // starting directory
 			dir = optarg;
 			break;
+		case 'u':
+			update = true;
+			break;
 		case 'h':
 			usage(argv[0], false);
 			exit(0);
@@ -104,8 +110,18 @@ int main(int argc, char *argv[])
 	try
 	{
 		fs = new sefs_filesystem(dir, NULL, NULL);
-		db = new sefs_db(fs, NULL, NULL);
-		db->save(outfilename);
+		if (update && sefs_db::isDB(outfilename))
+		{
+			// the database is modified in place, so there is
+			// nothing to save afterwards
+			db = new sefs_db(outfilename, NULL, NULL);
+			db->update(fs);
+		}
+		else
+		{
+			db = new sefs_db(fs, NULL, NULL);
+			db->save(outfilename);
+		}
 	}
 	catch(...)
 	{
@@ -70,7 +70,7 @@ enum opt_values
 	OPT_INITIALSID, OPT_FS_USE, OPT_GENFSCON,
 	OPT_NETIFCON, OPT_NODECON, OPT_PORTCON, OPT_PROTOCOL,
 	OPT_PERMISSIVE, OPT_POLCAP,
-	OPT_ALL, OPT_STATS, OPT_CONSTRAIN
+	OPT_ALL, OPT_STATS, OPT_MEMORY, OPT_TIMING, OPT_CONSTRAIN
 };
 
 static struct option const longopts[] = {
@@ -93,6 +93,8 @@ static struct option const longopts[] = {
 	{"portcon", optional_argument, NULL, OPT_PORTCON},
 	{"protocol", required_argument, NULL, OPT_PROTOCOL},
 	{"stats", no_argument, NULL, OPT_STATS},
+	{"memory", no_argument, NULL, OPT_MEMORY},
+	{"timing", no_argument, NULL, OPT_TIMING},
 	{"all", no_argument, NULL, OPT_ALL},
 	{"line-breaks", no_argument, NULL, 'l'},
 	{"expand", no_argument, NULL, 'x'},
@@ -139,6 +141,8 @@ void usage(const char *program_name, int brief)
 	printf("OPTIONS:\n");
 	printf("  -x, --expand                     show more info for specified components\n");
 	printf("  --stats                          print useful policy statistics\n");
+	printf("  --memory                         print memory used by the loaded policy\n");
+	printf("  --timing                         print the time taken by each phase of work\n");
 	printf("  -l, --line-breaks                print line breaks in constrain statements\n");
 	printf("  -h, --help                       print this help text and exit\n");
 	printf("  -V, --version                    print version information and exit\n");
@@ -420,6 +424,36 @@ static int print_stats(FILE * fp, const apol_policy_t * policydb)
 	return retval;
 }
 
+/**
+ * Prints the memory used by each part of a loaded policy.
+ *
+ * @param fp Reference to a file to which to print memory usage
+ * @param policydb Reference to a policy
+ *
+ * @return 0 on success, < 0 on error.
+ */
+static int print_memory(FILE * fp, const apol_policy_t * policydb)
+{
+	apol_vector_t *v = NULL;
+	size_t i, total = 0;
+
+	assert(policydb != NULL);
+	if ((v = apol_policy_get_memory_usage(policydb)) == NULL) {
+		ERR(policydb, "%s", strerror(errno));
+		return -1;
+	}
+	fprintf(fp, "\nMemory used by policy file: %s\n\n", policy_file);
+	fprintf(fp, "   %-26s %12s %10s\n", "Category", "Bytes", "Count");
+	for (i = 0; i < apol_vector_get_size(v); i++) {
+		const apol_memory_usage_t *u = apol_vector_get_element(v, i);
+		fprintf(fp, "   %-26s %12zd %10zd\n", u->name, u->bytes, u->count);
+		total += u->bytes;
+	}
+	fprintf(fp, "   %-26s %12zd\n\n", "Total", total);
+	apol_vector_destroy(&v);
+	return 0;
+}
+
 /**
  * Prints statistics regarding a policy's object classes.
  * If this function is given a name, it will attempt to
@@ -1664,7 +1698,7 @@ cleanup:	// close and destroy iterators etc.
 int main(int argc, char **argv)
 {
 	int rc = 0;
-	int classes, types, attribs, roles, users, all, expand, stats, rt, optc, isids, bools, sens, cats, fsuse, genfs, netif,
+	int classes, types, attribs, roles, users, all, expand, stats, memory, timing, rt, optc, isids, bools, sens, cats, fsuse, genfs, netif,
 		node, port, permissives, polcaps, constrain, linebreaks;
 	apol_policy_t *policydb = NULL;
 	apol_policy_path_t *pol_path = NULL;
@@ -1676,7 +1710,7 @@ int main(int argc, char **argv)
 
 	class_name = type_name = attrib_name = role_name = user_name = isid_name = bool_name = sens_name = cat_name = fsuse_type =
 		genfs_type = netif_name = node_addr = port_num = permissive_name = polcap_name = NULL;
-	classes = types = attribs = roles = users = all = expand = stats = isids = bools = sens = cats = fsuse = genfs = netif =
+	classes = types = attribs = roles = users = all = expand = stats = memory = timing = isids = bools = sens = cats = fsuse = genfs = netif =
 		node = port = permissives = polcaps = constrain = linebreaks = 0;
 	while ((optc = getopt_long(argc, argv, "c::t::a::r::u::b::lxhV", longopts, NULL)) != -1) {
 		switch (optc) {
@@ -1781,6 +1815,12 @@ int main(int argc, char **argv)
 		case OPT_STATS:
 			stats = 1;
 			break;
+		case OPT_MEMORY:
+			memory = 1;
+			break;
+		case OPT_TIMING:
+			timing = 1;
+			break;
 		case 'h':	       /* help */
 			usage(argv[0], 0);
 			exit(0);
@@ -1800,11 +1840,11 @@ int main(int argc, char **argv)
 	}
 
 	/* if no options, then show stats */
-	if (classes + types + attribs + roles + users + isids + bools + sens + cats + fsuse + genfs + netif + node + port + permissives + polcaps + constrain + all < 1) {
+	if (classes + types + attribs + roles + users + isids + bools + sens + cats + fsuse + genfs + netif + node + port + permissives + polcaps + constrain + memory + all < 1) {
 		stats = 1;
 	}
 
-	int policy_load_options = ((stats || all) ? 0 : QPOL_POLICY_OPTION_NO_RULES);
+	int policy_load_options = ((stats || memory || all) ? 0 : QPOL_POLICY_OPTION_NO_RULES);
 
 	if (argc - optind < 1) {
 		rt = qpol_default_policy_find(&policy_file);
@@ -1904,6 +1944,10 @@ int main(int argc, char **argv)
 		rc = print_polcaps(stdout, polcap_name, expand, policydb);
 	if (constrain || all)
 		rc = print_constraints(stdout, expand, policydb, linebreaks);
+	if (memory)
+		rc = print_memory(stdout, policydb);
+	if (timing)
+		qpol_stats_print(apol_policy_get_stats(policydb), "Timing:", stderr);
 
 	apol_policy_destroy(&policydb);
 	apol_policy_path_destroy(&pol_path);
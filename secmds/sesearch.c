@@ -55,7 +55,7 @@ enum opt_values
 {
 	RULE_NEVERALLOW = 256, RULE_AUDIT, RULE_AUDITALLOW, RULE_DONTAUDIT,
 	RULE_ROLE_ALLOW, RULE_ROLE_TRANS, RULE_RANGE_TRANS, RULE_ALL,
-	EXPR_ROLE_SOURCE, EXPR_ROLE_TARGET
+	EXPR_ROLE_SOURCE, EXPR_ROLE_TARGET, OPT_TIMING
 };
 
 static struct option const longopts[] = {
@@ -84,6 +84,7 @@ static struct option const longopts[] = {
 	{"linenum", no_argument, NULL, 'n'},
 	{"semantic", no_argument, NULL, 'S'},
 	{"show_cond", no_argument, NULL, 'C'},
+	{"timing", no_argument, NULL, OPT_TIMING},
 	{"help", no_argument, NULL, 'h'},
 	{"version", no_argument, NULL, 'V'},
 	{NULL, 0, NULL, 0}
@@ -114,6 +115,7 @@ typedef struct options
 	bool role_trans;
 	bool useregex;
 	bool show_cond;
+	bool timing;
 	apol_vector_t *perm_vector;
 } options_t;
 
@@ -151,6 +153,7 @@ void usage(const char *program_name, int brief)
 	printf("  -n, --linenum             show line number for each rule if available\n");
 	printf("  -S, --semantic            search rules semantically instead of syntactically\n");
 	printf("  -C, --show_cond           show conditional expression for conditional rules\n");
+	printf("  --timing                  print the time taken by each phase of work\n");
 	printf("  -h, --help                print this help text and exit\n");
 	printf("  -V, --version             print version information and exit\n");
 	printf("\n");
@@ -263,13 +266,14 @@ static int perform_av_query(const apol_policy_t * policy, const options_t * opt,
 	return -1;
 }
 
-static void print_syn_av_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v)
+static void print_syn_av_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v,
+				 apol_render_sink_t * out)
 {
 	qpol_policy_t *q = apol_policy_get_qpol(policy);
 	size_t i, num_rules = 0;
 	const apol_vector_t *syn_list = NULL;
 	const qpol_syn_avrule_t *rule = NULL;
-	char *tmp = NULL, *rule_str = NULL, *expr = NULL;
+	char *tmp = NULL, *expr = NULL;
 	char enable_char = ' ', branch_char = ' ';
 	const qpol_cond_t *cond = NULL;
 	uint32_t enabled = 0, is_true = 0;
@@ -282,7 +286,7 @@ static void print_syn_av_results(const apol_policy_t * policy, const options_t *
 	if (!(num_rules = apol_vector_get_size(syn_list)))
 		goto cleanup;
 
-	fprintf(stdout, "Found %zd syntactic av rules:\n", num_rules);
+	apol_render_sink_appendf(out, "Found %zd syntactic av rules:\n", num_rules);
 
 	for (i = 0; i < num_rules; i++) {
 		rule = apol_vector_get_element(syn_list, i);
@@ -306,33 +310,33 @@ static void print_syn_av_results(const apol_policy_t * policy, const options_t *
 					goto cleanup;
 			}
 		}
-		if (!(rule_str = apol_syn_avrule_render(policy, rule)))
-			goto cleanup;
 		if (opt->lineno) {
 			if (qpol_syn_avrule_get_lineno(q, rule, &lineno))
 				goto cleanup;
-			fprintf(stdout, "%c%c [%7lu] %s %s\n", enable_char, branch_char, lineno, rule_str, expr ? expr : "");
-		} else {
-			fprintf(stdout, "%c%c %s %s\n", enable_char, branch_char, rule_str, expr ? expr : "");
+			if (apol_render_sink_appendf(out, "%c%c [%7lu] ", enable_char, branch_char, lineno) < 0)
+				goto cleanup;
+		} else if (apol_render_sink_appendf(out, "%c%c ", enable_char, branch_char) < 0) {
+			goto cleanup;
 		}
-		free(rule_str);
-		rule_str = NULL;
+		if (apol_syn_avrule_render_to_sink(policy, rule, out) < 0 ||
+		    apol_render_sink_appendf(out, " %s\n", expr ? expr : "") < 0)
+			goto cleanup;
 		free(expr);
 		expr = NULL;
 	}
 
       cleanup:
 	free(tmp);
-	free(rule_str);
 	free(expr);
 }
 
-static void print_av_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v)
+static void print_av_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v,
+				 apol_render_sink_t * out)
 {
 	qpol_policy_t *q = apol_policy_get_qpol(policy);
 	size_t i, num_rules = 0;
 	const qpol_avrule_t *rule = NULL;
-	char *tmp = NULL, *rule_str = NULL, *expr = NULL;
+	char *tmp = NULL, *expr = NULL;
 	char enable_char = ' ', branch_char = ' ';
 	qpol_iterator_t *iter = NULL;
 	const qpol_cond_t *cond = NULL;
@@ -344,7 +348,7 @@ static void print_av_results(const apol_policy_t * policy, const options_t * opt
 	if (!(num_rules = apol_vector_get_size(v)))
 		return;
 
-	fprintf(stdout, "Found %zd semantic av rules:\n", num_rules);
+	apol_render_sink_appendf(out, "Found %zd semantic av rules:\n", num_rules);
 
 	for (i = 0; i < num_rules; i++) {
 		enable_char = branch_char = ' ';
@@ -372,18 +376,16 @@ static void print_av_results(const apol_policy_t * policy, const options_t * opt
 					goto cleanup;
 			}
 		}
-		if (!(rule_str = apol_avrule_render(policy, rule)))
+		if (apol_render_sink_appendf(out, "%c%c ", enable_char, branch_char) < 0 ||
+		    apol_avrule_render_to_sink(policy, rule, out) < 0 ||
+		    apol_render_sink_appendf(out, " %s\n", expr ? expr : "") < 0)
 			goto cleanup;
-		fprintf(stdout, "%c%c %s %s\n", enable_char, branch_char, rule_str, expr ? expr : "");
-		free(rule_str);
-		rule_str = NULL;
 		free(expr);
 		expr = NULL;
 	}
 
       cleanup:
 	free(tmp);
-	free(rule_str);
 	free(expr);
 }
 
@@ -466,13 +468,14 @@ static int perform_te_query(const apol_policy_t * policy, const options_t * opt,
 	return -1;
 }
 
-static void print_syn_te_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v)
+static void print_syn_te_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v,
+				 apol_render_sink_t * out)
 {
 	qpol_policy_t *q = apol_policy_get_qpol(policy);
 	size_t i, num_rules = 0;
 	const apol_vector_t *syn_list = NULL;
 	const qpol_syn_terule_t *rule = NULL;
-	char *tmp = NULL, *rule_str = NULL, *expr = NULL;
+	char *tmp = NULL, *expr = NULL;
 	char enable_char = ' ', branch_char = ' ';
 	const qpol_cond_t *cond = NULL;
 	uint32_t enabled = 0, is_true = 0;
@@ -485,7 +488,7 @@ static void print_syn_te_results(const apol_policy_t * policy, const options_t *
 	if (!(num_rules = apol_vector_get_size(syn_list)))
 		goto cleanup;
 
-	fprintf(stdout, "Found %zd syntactic te rules:\n", num_rules);
+	apol_render_sink_appendf(out, "Found %zd syntactic te rules:\n", num_rules);
 
 	for (i = 0; i < num_rules; i++) {
 		rule = apol_vector_get_element(syn_list, i);
@@ -509,33 +512,33 @@ static void print_syn_te_results(const apol_policy_t * policy, const options_t *
 					goto cleanup;
 			}
 		}
-		if (!(rule_str = apol_syn_terule_render(policy, rule)))
-			goto cleanup;
 		if (opt->lineno) {
 			if (qpol_syn_terule_get_lineno(q, rule, &lineno))
 				goto cleanup;
-			fprintf(stdout, "%c%c [%7lu] %s %s\n", enable_char, branch_char, lineno, rule_str, expr ? expr : "");
-		} else {
-			fprintf(stdout, "%c%c %s %s\n", enable_char, branch_char, rule_str, expr ? expr : "");
+			if (apol_render_sink_appendf(out, "%c%c [%7lu] ", enable_char, branch_char, lineno) < 0)
+				goto cleanup;
+		} else if (apol_render_sink_appendf(out, "%c%c ", enable_char, branch_char) < 0) {
+			goto cleanup;
 		}
-		free(rule_str);
-		rule_str = NULL;
+		if (apol_syn_terule_render_to_sink(policy, rule, out) < 0 ||
+		    apol_render_sink_appendf(out, " %s\n", expr ? expr : "") < 0)
+			goto cleanup;
 		free(expr);
 		expr = NULL;
 	}
 
       cleanup:
 	free(tmp);
-	free(rule_str);
 	free(expr);
 }
 
-static void print_te_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v)
+static void print_te_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v,
+				 apol_render_sink_t * out)
 {
 	qpol_policy_t *q = apol_policy_get_qpol(policy);
 	size_t i, num_rules = 0;
 	const qpol_terule_t *rule = NULL;
-	char *tmp = NULL, *rule_str = NULL, *expr = NULL;
+	char *tmp = NULL, *expr = NULL;
 	char enable_char = ' ', branch_char = ' ';
 	qpol_iterator_t *iter = NULL;
 	const qpol_cond_t *cond = NULL;
@@ -547,7 +550,7 @@ static void print_te_results(const apol_policy_t * policy, const options_t * opt
 	if (!(num_rules = apol_vector_get_size(v)))
 		goto cleanup;
 
-	fprintf(stdout, "Found %zd semantic te rules:\n", num_rules);
+	apol_render_sink_appendf(out, "Found %zd semantic te rules:\n", num_rules);
 
 	for (i = 0; i < num_rules; i++) {
 		enable_char = branch_char = ' ';
@@ -577,18 +580,16 @@ static void print_te_results(const apol_policy_t * policy, const options_t * opt
 					goto cleanup;
 			}
 		}
-		if (!(rule_str = apol_terule_render(policy, rule)))
+		if (apol_render_sink_appendf(out, "%c%c ", enable_char, branch_char) < 0 ||
+		    apol_terule_render_to_sink(policy, rule, out) < 0 ||
+		    apol_render_sink_appendf(out, " %s\n", expr ? expr : "") < 0)
 			goto cleanup;
-		fprintf(stdout, "%c%c %s %s\n", enable_char, branch_char, rule_str, expr ? expr : "");
-		free(rule_str);
-		rule_str = NULL;
 		free(expr);
 		expr = NULL;
 	}
 
       cleanup:
 	free(tmp);
-	free(rule_str);
 	free(expr);
 }
 
@@ -673,7 +674,8 @@ static int perform_ft_query(const apol_policy_t * policy, const options_t * opt,
 	return -1;
 }
 
-static void print_ft_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v)
+static void print_ft_results(const apol_policy_t * policy, const options_t * opt, const apol_vector_t * v,
+				 apol_render_sink_t * out)
 {
 	size_t i, num_filename_trans = 0;
 	const qpol_filename_trans_t *filename_trans = NULL;
@@ -683,7 +685,7 @@ static void print_ft_results(const apol_policy_t * policy, const options_t * opt
 	if (!(num_filename_trans = apol_vector_get_size(v)))
 		goto cleanup;
 
-	fprintf(stdout, "Found %zd named file transition rules:\n", num_filename_trans);
+	apol_render_sink_appendf(out, "Found %zd named file transition rules:\n", num_filename_trans);
 
 	for (i = 0; i < num_filename_trans; i++) {
 		if (!(filename_trans = apol_vector_get_element(v, i)))
@@ -691,7 +693,8 @@ static void print_ft_results(const apol_policy_t * policy, const options_t * opt
 
 		if (!(filename_trans_str = apol_filename_trans_render(policy, filename_trans)))
 			goto cleanup;
-		fprintf(stdout, "%s\n", filename_trans_str);
+		if (apol_render_sink_appendf(out, "%s\n", filename_trans_str) < 0)
+			goto cleanup;
 		free(filename_trans_str);
 		filename_trans_str = NULL;
 	}
@@ -752,11 +755,11 @@ static int perform_ra_query(const apol_policy_t * policy, const options_t * opt,
 	return -1;
 }
 
-static void print_ra_results(const apol_policy_t * policy, const options_t * opt __attribute__ ((unused)), const apol_vector_t * v)
+static void print_ra_results(const apol_policy_t * policy, const options_t * opt __attribute__ ((unused)),
+			     const apol_vector_t * v, apol_render_sink_t * out)
 {
 	size_t i, num_rules = 0;
 	const qpol_role_allow_t *rule = NULL;
-	char *tmp = NULL;
 
 	if (!policy || !v)
 		return;
@@ -764,16 +767,14 @@ static void print_ra_results(const apol_policy_t * policy, const options_t * opt
 	if (!(num_rules = apol_vector_get_size(v)))
 		return;
 
-	fprintf(stdout, "Found %zd role allow rules:\n", num_rules);
+	apol_render_sink_appendf(out, "Found %zd role allow rules:\n", num_rules);
 
 	for (i = 0; i < num_rules; i++) {
 		if (!(rule = apol_vector_get_element(v, i)))
 			break;
-		if (!(tmp = apol_role_allow_render(policy, rule)))
+		if (apol_render_sink_append(out, "   ") < 0 || apol_role_allow_render_to_sink(policy, rule, out) < 0 ||
+		    apol_render_sink_putc(out, '\n') < 0)
 			break;
-		fprintf(stdout, "   %s\n", tmp);
-		free(tmp);
-		tmp = NULL;
 	}
 }
 
@@ -837,11 +838,11 @@ static int perform_rt_query(const apol_policy_t * policy, const options_t * opt,
 	return -1;
 }
 
-static void print_rt_results(const apol_policy_t * policy, const options_t * opt __attribute__ ((unused)), const apol_vector_t * v)
+static void print_rt_results(const apol_policy_t * policy, const options_t * opt __attribute__ ((unused)),
+			     const apol_vector_t * v, apol_render_sink_t * out)
 {
 	size_t i, num_rules = 0;
 	const qpol_role_trans_t *rule = NULL;
-	char *tmp = NULL;
 
 	if (!policy || !v)
 		return;
@@ -849,16 +850,14 @@ static void print_rt_results(const apol_policy_t * policy, const options_t * opt
 	if (!(num_rules = apol_vector_get_size(v)))
 		return;
 
-	fprintf(stdout, "Found %zd role_transition rules:\n", num_rules);
+	apol_render_sink_appendf(out, "Found %zd role_transition rules:\n", num_rules);
 
 	for (i = 0; i < num_rules; i++) {
 		if (!(rule = apol_vector_get_element(v, i)))
 			break;
-		if (!(tmp = apol_role_trans_render(policy, rule)))
+		if (apol_render_sink_append(out, "   ") < 0 || apol_role_trans_render_to_sink(policy, rule, out) < 0 ||
+		    apol_render_sink_putc(out, '\n') < 0)
 			break;
-		fprintf(stdout, "   %s\n", tmp);
-		free(tmp);
-		tmp = NULL;
 	}
 }
 
@@ -934,12 +933,11 @@ static int perform_range_query(const apol_policy_t * policy, const options_t * o
 	return -1;
 }
 
-static void print_range_results(const apol_policy_t * policy, const options_t * opt
-				__attribute__ ((unused)), const apol_vector_t * v)
+static void print_range_results(const apol_policy_t * policy, const options_t * opt __attribute__ ((unused)),
+				const apol_vector_t * v, apol_render_sink_t * out)
 {
 	size_t i, num_rules = 0;
 	const qpol_range_trans_t *rule = NULL;
-	char *tmp = NULL;
 
 	if (!policy || !v)
 		return;
@@ -947,16 +945,14 @@ static void print_range_results(const apol_policy_t * policy, const options_t *
 	if (!(num_rules = apol_vector_get_size(v)))
 		return;
 
-	fprintf(stdout, "Found %zd range_transition rules:\n", num_rules);
+	apol_render_sink_appendf(out, "Found %zd range_transition rules:\n", num_rules);
 
 	for (i = 0; i < num_rules; i++) {
 		if (!(rule = apol_vector_get_element(v, i)))
 			break;
-		if (!(tmp = apol_range_trans_render(policy, rule)))
+		if (apol_render_sink_append(out, "   ") < 0 || apol_range_trans_render_to_sink(policy, rule, out) < 0 ||
+		    apol_render_sink_putc(out, '\n') < 0)
 			break;
-		fprintf(stdout, "   %s\n", tmp);
-		free(tmp);
-		tmp = NULL;
 	}
 }
 
@@ -967,6 +963,7 @@ int main(int argc, char **argv)
 
 	apol_policy_t *policy = NULL;
 	apol_vector_t *v = NULL;
+	apol_render_sink_t *out = NULL;
 	apol_policy_path_t *pol_path = NULL;
 	apol_vector_t *mod_paths = NULL;
 	apol_policy_path_type_e path_type = APOL_POLICY_PATH_TYPE_MONOLITHIC;
@@ -1120,6 +1117,9 @@ int main(int argc, char **argv)
 		case 'C':
 			cmd_opts.show_cond = true;
 			break;
+		case OPT_TIMING:
+			cmd_opts.timing = true;
+			break;
 		case 'h':	       /* help */
 			usage(argv[0], 0);
 			exit(0);
@@ -1249,16 +1249,21 @@ int main(int argc, char **argv)
 		cmd_opts.lineno = 0;
 	}
 
+	if (!(out = apol_render_sink_create_file(stdout))) {
+		ERR(policy, "%s", strerror(errno));
+		goto cleanup;
+	}
+
 	if (perform_av_query(policy, &cmd_opts, &v)) {
 		rt = 1;
 		goto cleanup;
 	}
 	if (v) {
 		if (!cmd_opts.semantic && qpol_policy_has_capability(apol_policy_get_qpol(policy), QPOL_CAP_SYN_RULES))
-			print_syn_av_results(policy, &cmd_opts, v);
+			print_syn_av_results(policy, &cmd_opts, v, out);
 		else
-			print_av_results(policy, &cmd_opts, v);
-		fprintf(stdout, "\n");
+			print_av_results(policy, &cmd_opts, v, out);
+		apol_render_sink_putc(out, '\n');
 	}
 	apol_vector_destroy(&v);
 	if (perform_te_query(policy, &cmd_opts, &v)) {
@@ -1267,10 +1272,10 @@ int main(int argc, char **argv)
 	}
 	if (v) {
 		if (!cmd_opts.semantic && qpol_policy_has_capability(apol_policy_get_qpol(policy), QPOL_CAP_SYN_RULES))
-			print_syn_te_results(policy, &cmd_opts, v);
+			print_syn_te_results(policy, &cmd_opts, v, out);
 		else
-			print_te_results(policy, &cmd_opts, v);
-		fprintf(stdout, "\n");
+			print_te_results(policy, &cmd_opts, v, out);
+		apol_render_sink_putc(out, '\n');
 	}
 
 	apol_vector_destroy(&v);
@@ -1279,8 +1284,8 @@ int main(int argc, char **argv)
 		goto cleanup;
 	}
 	if (v) {
-		print_ft_results(policy, &cmd_opts, v);
-		fprintf(stdout, "\n");
+		print_ft_results(policy, &cmd_opts, v, out);
+		apol_render_sink_putc(out, '\n');
 	}
 
 	apol_vector_destroy(&v);
@@ -1289,8 +1294,8 @@ int main(int argc, char **argv)
 		goto cleanup;
 	}
 	if (v) {
-		print_ra_results(policy, &cmd_opts, v);
-		fprintf(stdout, "\n");
+		print_ra_results(policy, &cmd_opts, v, out);
+		apol_render_sink_putc(out, '\n');
 	}
 	apol_vector_destroy(&v);
 	if (perform_rt_query(policy, &cmd_opts, &v)) {
@@ -1298,8 +1303,8 @@ int main(int argc, char **argv)
 		goto cleanup;
 	}
 	if (v) {
-		print_rt_results(policy, &cmd_opts, v);
-		fprintf(stdout, "\n");
+		print_rt_results(policy, &cmd_opts, v, out);
+		apol_render_sink_putc(out, '\n');
 	}
 	apol_vector_destroy(&v);
 	if (perform_range_query(policy, &cmd_opts, &v)) {
@@ -1307,12 +1312,20 @@ int main(int argc, char **argv)
 		goto cleanup;
 	}
 	if (v) {
-		print_range_results(policy, &cmd_opts, v);
-		fprintf(stdout, "\n");
+		print_range_results(policy, &cmd_opts, v, out);
+		apol_render_sink_putc(out, '\n');
 	}
 	apol_vector_destroy(&v);
+	if (apol_render_sink_flush(out) < 0) {
+		ERR(policy, "%s", strerror(errno));
+		rt = 1;
+		goto cleanup;
+	}
 	rt = 0;
       cleanup:
+	apol_render_sink_destroy(&out);
+	if (cmd_opts.timing && policy != NULL)
+		qpol_stats_print(apol_policy_get_stats(policy), "Timing:", stderr);
 	apol_policy_destroy(&policy);
 	apol_policy_path_destroy(&pol_path);
 	free(cmd_opts.src_name);
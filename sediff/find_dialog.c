@@ -74,6 +74,18 @@ static void find_dialog_search(find_dialog_t * f)
 	}
 	if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(f->forward))) {
 		text_found = gtk_text_iter_forward_search(&iter, search_text, GTK_TEXT_SEARCH_VISIBLE_ONLY, &start, &end, NULL);
+		if (!text_found) {
+			/* the results may not yet all be rendered; render
+			 * through the next match, if any, and search again.
+			 * rendering invalidates iterators. */
+			gint offset = gtk_text_iter_get_offset(&iter);
+			if (toplevel_render_match(f->top, search_text)) {
+				gtk_text_buffer_get_iter_at_offset(tb, &iter, offset);
+				text_found =
+					gtk_text_iter_forward_search(&iter, search_text, GTK_TEXT_SEARCH_VISIBLE_ONLY, &start, &end,
+								     NULL);
+			}
+		}
 		if (!text_found) {
 			/* wrap search */
 			gtk_text_buffer_get_start_iter(tb, &iter);
@@ -37,7 +37,13 @@ typedef GtkTextBuffer *(*get_buffer_fn_t) (result_item_t * item, poldiff_form_e
 typedef int (*is_render_slow_fn_t) (result_item_t * item, poldiff_form_e form);
 typedef void (*get_forms_fn_t) (result_item_t * item, int forms[5]);
 typedef void (*set_current_sort_fn_t) (result_item_t * item, poldiff_form_e form, results_sort_e sort, results_sort_dir_e dir);
-typedef void (*print_diff_fn_t) (result_item_t * item, GtkTextBuffer * tb, poldiff_form_e form);
+typedef int (*render_more_fn_t) (result_item_t * item, poldiff_form_e form, const char *text);
+typedef apol_vector_t *(*sort_fn_t) (result_item_t * item, poldiff_form_e form);
+typedef int (*print_row_fn_t) (result_item_t * item, GtkTextBuffer * tb, GtkTextIter * iter, poldiff_form_e form,
+			       const void *elem, GString * string);
+
+/** number of rows that multi buffer items render at a time */
+#define RESULT_ITEM_MULTI_PAGE_ROWS 500
 
 struct result_item
 {
@@ -65,6 +71,9 @@ struct result_item
 	poldiff_run_fn_t poldiff_run;
 	get_buffer_fn_t get_buffer;
 	is_render_slow_fn_t is_render_slow;
+	/** if the result item always renders all of its buffer then
+	    this can be NULL */
+	render_more_fn_t render_more;
 	get_forms_fn_t get_forms;
 	/** if the result item cannot be sorted then this will be an array
 	    of zeroes */
@@ -78,8 +87,13 @@ struct result_item
 			int has_line_numbers[SEDIFFX_POLICY_NUM];
 			int cached[5];
 			GtkTextBuffer *buffers[5];
+			/** sorted results for each form; rows are
+			    rendered from these on demand */
 			apol_vector_t *items[5];
-			print_diff_fn_t print_diff;
+			/** number of rows of items[] rendered so far */
+			size_t rendered[5];
+			sort_fn_t sort;
+			print_row_fn_t print_row;
 		} multi;
 	} data;
 };
@@ -695,11 +709,43 @@ static void result_item_multi_poldiff_run(result_item_t * item, poldiff_t * diff
 }
 
 /**
- * Render the buffer if it has not yet been cached, then return it.
+ * Append rows of the sorted results to the form's buffer, up to (but
+ * not including) row end.
+ */
+static void result_item_multi_render_rows(result_item_t * item, poldiff_form_e form, size_t end)
+{
+	int f = form_reverse_map[form];
+	GtkTextBuffer *tb = item->data.multi.buffers[f];
+	apol_vector_t *rows = item->data.multi.items[f];
+	GtkTextIter iter;
+	GString *string = g_string_new("");
+	size_t i;
+	if (end > apol_vector_get_size(rows)) {
+		end = apol_vector_get_size(rows);
+	}
+	gtk_text_buffer_get_end_iter(tb, &iter);
+	for (i = item->data.multi.rendered[f]; i < end; i++) {
+		if (item->data.multi.print_row(item, tb, &iter, form, apol_vector_get_element(rows, i), string) < 0) {
+			break;
+		}
+	}
+	item->data.multi.rendered[f] = i;
+	g_string_free(string, TRUE);
+}
+
+/**
+ * Sort the results and render the first page of the buffer if it has
+ * not yet been cached, then return it.  Further rows are rendered by
+ * result_item_multi_render_more() as they are needed, so that
+ * showing many thousands of results does not render them all.  Rows
+ * are never removed once rendered; the buffer keeps growing as the
+ * user scrolls or searches towards its end, until the results are
+ * sorted again.
  */
 static GtkTextBuffer *result_item_multi_get_buffer(result_item_t * item, poldiff_form_e form)
 {
 	GtkTextBuffer *tb;
+	int f;
 	if (form == POLDIFF_FORM_NONE) {
 		/* just use the global single_buffer when printing the
 		 * summary */
@@ -707,17 +753,64 @@ static GtkTextBuffer *result_item_multi_get_buffer(result_item_t * item, poldiff
 		result_item_print_summary(item, single_buffer);
 		tb = single_buffer;
 	} else {
-		tb = item->data.multi.buffers[form_reverse_map[form]];
-		if (!item->data.multi.cached[form_reverse_map[form]]) {
+		f = form_reverse_map[form];
+		tb = item->data.multi.buffers[f];
+		if (!item->data.multi.cached[f]) {
 			util_text_buffer_clear(tb);
 			result_item_print_header(item, tb, form);
-			item->data.multi.print_diff(item, tb, form);
-			item->data.multi.cached[form_reverse_map[form]] = 1;
+			apol_vector_destroy(&item->data.multi.items[f]);
+			item->data.multi.rendered[f] = 0;
+			if ((item->data.multi.items[f] = item->data.multi.sort(item, form)) != NULL) {
+				result_item_multi_render_rows(item, form, RESULT_ITEM_MULTI_PAGE_ROWS);
+			}
+			item->data.multi.cached[f] = 1;
 		}
 	}
 	return tb;
 }
 
+/**
+ * Render another page of rows.  If text is given, then instead render
+ * through the first unrendered row whose string contains the text.
+ */
+static int result_item_multi_render_more(result_item_t * item, poldiff_form_e form, const char *text)
+{
+	int f;
+	size_t i, num_rows;
+	char *s;
+	int found;
+	if (form == POLDIFF_FORM_NONE) {
+		return 0;
+	}
+	f = form_reverse_map[form];
+	if (!item->data.multi.cached[f] || item->data.multi.items[f] == NULL) {
+		return 0;
+	}
+	num_rows = apol_vector_get_size(item->data.multi.items[f]);
+	i = item->data.multi.rendered[f];
+	if (i >= num_rows) {
+		return 0;
+	}
+	if (text != NULL) {
+		for (found = 0; !found && i < num_rows; i++) {
+			if ((s = item->get_string(item->diff, apol_vector_get_element(item->data.multi.items[f], i))) == NULL) {
+				return 0;
+			}
+			found = (strstr(s, text) != NULL);
+			free(s);
+		}
+		if (!found) {
+			return 0;
+		}
+		/* render the rest of the page containing the match */
+		i = i - 1 + RESULT_ITEM_MULTI_PAGE_ROWS;
+	} else {
+		i += RESULT_ITEM_MULTI_PAGE_ROWS;
+	}
+	result_item_multi_render_rows(item, form, i);
+	return 1;
+}
+
 /**
  * If the item is cached or if there are less than 50 things to show,
  * then rendering is considered to be fast.
@@ -769,6 +862,7 @@ static result_item_t *result_item_multi_create(GtkTextTagTable * table)
 	item->poldiff_run = result_item_multi_poldiff_run;
 	item->get_buffer = result_item_multi_get_buffer;
 	item->is_render_slow = result_item_multi_is_render_slow;
+	item->render_more = result_item_multi_render_more;
 	item->get_forms = result_item_role_trans_get_forms;	/* [sic] */
 	item->set_current_sort = result_item_multi_set_current_sort;
 	int i;
@@ -860,47 +954,36 @@ static apol_vector_t *result_item_avrule_sort(result_item_t * item, poldiff_form
 	return v;
 }
 
-static void result_item_avrule_print_diff(result_item_t * item, GtkTextBuffer * tb, poldiff_form_e form)
+static int result_item_avrule_print_row(result_item_t * item, GtkTextBuffer * tb, GtkTextIter * iter, poldiff_form_e form,
+					const void *elem, GString * string)
 {
-	GtkTextIter iter;
-	size_t i;
-	void *elem;
 	char *s;
-	GString *string = g_string_new("");
 	const apol_vector_t *syn_linenos;
-	apol_vector_t *rules = result_item_avrule_sort(item, form);
 	char *orig_prefix;
 	char *mod_prefix;
 
-	apol_vector_destroy(&item->data.multi.items[form_reverse_map[form]]);
-	item->data.multi.items[form_reverse_map[form]] = rules;
-	gtk_text_buffer_get_end_iter(tb, &iter);
-	for (i = 0; i < apol_vector_get_size(rules); i++) {
-		elem = apol_vector_get_element(rules, i);
-		if ((s = poldiff_avrule_to_string(item->diff, elem)) == NULL) {
-			goto cleanup;
-		}
-		result_item_print_string_avrule(tb, &iter, s, 1);
-		if (form != POLDIFF_FORM_MODIFIED) {
-			orig_prefix = NULL;
-			mod_prefix = NULL;
-		} else {
-			orig_prefix = "op: ";
-			mod_prefix = "mp: ";
-		}
-		if (item->data.multi.has_line_numbers[SEDIFFX_POLICY_ORIG] &&
-		    (syn_linenos = poldiff_avrule_get_orig_line_numbers((poldiff_avrule_t *) elem)) != NULL) {
-			result_item_print_linenos(tb, &iter, orig_prefix, syn_linenos, "line-pol_orig", string);
-		}
-		if (item->data.multi.has_line_numbers[SEDIFFX_POLICY_MOD] &&
-		    (syn_linenos = poldiff_avrule_get_mod_line_numbers((poldiff_avrule_t *) elem)) != NULL) {
-			result_item_print_linenos(tb, &iter, mod_prefix, syn_linenos, "line-pol_mod", string);
-		}
-		free(s);
-		gtk_text_buffer_insert(tb, &iter, "\n", -1);
+	if ((s = poldiff_avrule_to_string(item->diff, elem)) == NULL) {
+		return -1;
 	}
-      cleanup:
-	g_string_free(string, TRUE);
+	result_item_print_string_avrule(tb, iter, s, 1);
+	if (form != POLDIFF_FORM_MODIFIED) {
+		orig_prefix = NULL;
+		mod_prefix = NULL;
+	} else {
+		orig_prefix = "op: ";
+		mod_prefix = "mp: ";
+	}
+	if (item->data.multi.has_line_numbers[SEDIFFX_POLICY_ORIG] &&
+	    (syn_linenos = poldiff_avrule_get_orig_line_numbers((poldiff_avrule_t *) elem)) != NULL) {
+		result_item_print_linenos(tb, iter, orig_prefix, syn_linenos, "line-pol_orig", string);
+	}
+	if (item->data.multi.has_line_numbers[SEDIFFX_POLICY_MOD] &&
+	    (syn_linenos = poldiff_avrule_get_mod_line_numbers((poldiff_avrule_t *) elem)) != NULL) {
+		result_item_print_linenos(tb, iter, mod_prefix, syn_linenos, "line-pol_mod", string);
+	}
+	free(s);
+	gtk_text_buffer_insert(tb, iter, "\n", -1);
+	return 0;
 }
 
 /**
@@ -955,7 +1038,8 @@ static result_item_t *result_item_create_from_flag(GtkTextTagTable * table, uint
 	item->get_form = poldiff_component_record_get_form_fn(rec);
 	item->get_string = poldiff_component_record_get_to_string_fn(rec);
 	item->get_buffer = result_item_avrule_get_buffer;
-	item->data.multi.print_diff = result_item_avrule_print_diff;
+	item->data.multi.sort = result_item_avrule_sort;
+	item->data.multi.print_row = result_item_avrule_print_row;
 	item->policy_changed = result_item_avrule_policy_changed;
 	return item;
 }
@@ -1052,47 +1136,37 @@ static apol_vector_t *result_item_terule_sort(result_item_t * item, poldiff_form
 	return v;
 }
 
-static void result_item_terule_print_diff(result_item_t * item, GtkTextBuffer * tb, poldiff_form_e form)
+static int result_item_terule_print_row(result_item_t * item, GtkTextBuffer * tb, GtkTextIter * iter, poldiff_form_e form,
+					const void *elem, GString * string)
 {
-	GtkTextIter iter;
-	size_t i;
-	void *elem;
 	char *s;
-	GString *string = g_string_new("");
 	apol_vector_t *syn_linenos;
-	apol_vector_t *rules = result_item_terule_sort(item, form);
 	char *orig_prefix;
 	char *mod_prefix;
 
-	gtk_text_buffer_get_end_iter(tb, &iter);
-	for (i = 0; i < apol_vector_get_size(rules); i++) {
-		elem = apol_vector_get_element(rules, i);
-		if ((s = poldiff_terule_to_string(item->diff, elem)) == NULL) {
-			goto cleanup;
-		}
-		if (form != POLDIFF_FORM_MODIFIED) {
-			orig_prefix = NULL;
-			mod_prefix = NULL;
-			result_item_print_string(tb, &iter, s, 1);
-		} else {
-			orig_prefix = "op: ";
-			mod_prefix = "mp: ";
-			result_item_print_string_inline(tb, &iter, s, 1);
-		}
-		if (item->data.multi.has_line_numbers[SEDIFFX_POLICY_ORIG] &&
-		    (syn_linenos = poldiff_terule_get_orig_line_numbers((poldiff_terule_t *) elem)) != NULL) {
-			result_item_print_linenos(tb, &iter, orig_prefix, syn_linenos, "line-pol_orig", string);
-		}
-		if (item->data.multi.has_line_numbers[SEDIFFX_POLICY_MOD] &&
-		    (syn_linenos = poldiff_terule_get_mod_line_numbers((poldiff_terule_t *) elem)) != NULL) {
-			result_item_print_linenos(tb, &iter, mod_prefix, syn_linenos, "line-pol_mod", string);
-		}
-		free(s);
-		gtk_text_buffer_insert(tb, &iter, "\n", -1);
+	if ((s = poldiff_terule_to_string(item->diff, elem)) == NULL) {
+		return -1;
 	}
-      cleanup:
-	apol_vector_destroy(&rules);
-	g_string_free(string, TRUE);
+	if (form != POLDIFF_FORM_MODIFIED) {
+		orig_prefix = NULL;
+		mod_prefix = NULL;
+		result_item_print_string(tb, iter, s, 1);
+	} else {
+		orig_prefix = "op: ";
+		mod_prefix = "mp: ";
+		result_item_print_string_inline(tb, iter, s, 1);
+	}
+	if (item->data.multi.has_line_numbers[SEDIFFX_POLICY_ORIG] &&
+	    (syn_linenos = poldiff_terule_get_orig_line_numbers((poldiff_terule_t *) elem)) != NULL) {
+		result_item_print_linenos(tb, iter, orig_prefix, syn_linenos, "line-pol_orig", string);
+	}
+	if (item->data.multi.has_line_numbers[SEDIFFX_POLICY_MOD] &&
+	    (syn_linenos = poldiff_terule_get_mod_line_numbers((poldiff_terule_t *) elem)) != NULL) {
+		result_item_print_linenos(tb, iter, mod_prefix, syn_linenos, "line-pol_mod", string);
+	}
+	free(s);
+	gtk_text_buffer_insert(tb, iter, "\n", -1);
+	return 0;
 }
 
 static result_item_t *result_item_create_terules_from_flag(GtkTextTagTable * table, uint32_t flag)
@@ -1107,7 +1181,8 @@ static result_item_t *result_item_create_terules_from_flag(GtkTextTagTable * tab
 	item->get_vector = poldiff_component_record_get_results_fn(rec);
 	item->get_form = poldiff_component_record_get_form_fn(rec);
 	item->get_string = poldiff_component_record_get_to_string_fn(rec);
-	item->data.multi.print_diff = result_item_terule_print_diff;
+	item->data.multi.sort = result_item_terule_sort;
+	item->data.multi.print_row = result_item_terule_print_row;
 	return item;
 }
 
@@ -1162,6 +1237,22 @@ int result_item_is_render_slow(result_item_t * item, poldiff_form_e form)
 	return item->is_render_slow(item, form);
 }
 
+int result_item_render_more(result_item_t * item, poldiff_form_e form)
+{
+	if (item->render_more == NULL) {
+		return 0;
+	}
+	return item->render_more(item, form, NULL);
+}
+
+int result_item_render_match(result_item_t * item, poldiff_form_e form, const char *text)
+{
+	if (item->render_more == NULL) {
+		return 0;
+	}
+	return item->render_more(item, form, text);
+}
+
 void result_item_poldiff_run(result_item_t * item, poldiff_t * diff, int incremental)
 {
 	item->poldiff_run(item, diff, incremental);
@@ -126,6 +126,34 @@ GtkTextBuffer *result_item_get_buffer(result_item_t * item, poldiff_form_e form)
  */
 int result_item_is_render_slow(result_item_t * item, poldiff_form_e form);
 
+/**
+ * Some result items (e.g., AV rules) have too many results to render
+ * all at once, so their buffers initially hold only the first rows.
+ * Append the next rows to the buffer previously returned by
+ * result_item_get_buffer().  This only defers rendering: rows already
+ * in the buffer stay there, so scrolling through every result still
+ * renders them all.
+ *
+ * @param item Result item whose buffer to extend.
+ * @param form Form currently displayed.
+ *
+ * @return Non-zero if rows were appended, zero if every row has
+ * already been rendered.
+ */
+int result_item_render_more(result_item_t * item, poldiff_form_e form);
+
+/**
+ * Search the rows not yet rendered for some text.  If a row contains
+ * it, append rows to the buffer through that row.
+ *
+ * @param item Result item whose results to search.
+ * @param form Form currently displayed.
+ * @param text Text to find.
+ *
+ * @return Non-zero if a match was found and rendered, zero if not.
+ */
+int result_item_render_match(result_item_t * item, poldiff_form_e form, const char *text);
+
 /**
  * Determine if a result item is capable of being run according to the
  * given policies.  For example, for binary policies prior to version
@@ -102,6 +102,7 @@ static gboolean results_on_line_event(GtkTextTag * tag, GObject * event_object,
 				      GdkEvent * event, const GtkTextIter * iter, gpointer user_data);
 static gboolean results_on_popup_menu(GtkWidget * widget, gpointer user_data);
 static gboolean results_on_text_view_motion(GtkWidget * widget, GdkEventMotion * event, gpointer user_data);
+static void results_on_scroll(GtkAdjustment * adj, gpointer user_data);
 /**
  * Callback whenever the user double-clicks a row in the summary tree.
  */
@@ -147,6 +148,7 @@ results_t *results_create(toplevel_t * top)
 	GtkTextView *text_view;
 	gint size;
 	PangoTabArray *tabs;
+	GtkAdjustment *vadj;
 
 	if ((r = calloc(1, sizeof(*r))) == NULL) {
 		return NULL;
@@ -188,6 +190,9 @@ results_t *results_create(toplevel_t * top)
 						  PANGO_TAB_LEFT, 6 * size, PANGO_TAB_LEFT, 9 * size, PANGO_TAB_LEFT, 12 * size);
 	gtk_text_view_set_tabs(r->view, tabs);
 	gtk_text_view_set_buffer(r->view, r->main_buffer);
+	/* render more rows of long results as the view nears their end */
+	vadj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(gtk_widget_get_parent(GTK_WIDGET(r->view))));
+	g_signal_connect(G_OBJECT(vadj), "value-changed", G_CALLBACK(results_on_scroll), r);
 
 	r->key_buffer = gtk_text_buffer_new(tag_table);
 	text_view = GTK_TEXT_VIEW(glade_xml_get_widget(r->xml, "toplevel key view"));
@@ -702,6 +707,28 @@ void results_sort(results_t * r, results_sort_e field, results_sort_dir_e direct
 	}
 }
 
+/**
+ * Callback invoked when the results view scrolls.  If the view is
+ * within a page of the end of its buffer, and the current result item
+ * has more rows to show, render them.
+ */
+static void results_on_scroll(GtkAdjustment * adj, gpointer user_data)
+{
+	results_t *r = (results_t *) user_data;
+	if (r->current_item != NULL && r->current_form != POLDIFF_FORM_NONE &&
+	    adj->value + 2 * adj->page_size >= adj->upper) {
+		result_item_render_more(r->current_item, r->current_form);
+	}
+}
+
+int results_render_match(results_t * r, const char *text)
+{
+	if (r->current_item == NULL || r->current_form == POLDIFF_FORM_NONE) {
+		return 0;
+	}
+	return result_item_render_match(r->current_item, r->current_form, text);
+}
+
 GtkTextView *results_get_text_view(results_t * r)
 {
 	return r->view;
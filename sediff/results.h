@@ -109,6 +109,18 @@ void results_switch_to_page(results_t * r);
  */
 void results_sort(results_t * r, results_sort_e field, results_sort_dir_e direction);
 
+/**
+ * Search the currently displayed results that have not yet been
+ * rendered for some text.  If found, render them through the
+ * matching result, so that it may then be found within the text view.
+ *
+ * @param r Results object to search.
+ * @param text Text to find.
+ *
+ * @return Non-zero if a match was found and rendered, zero if not.
+ */
+int results_render_match(results_t * r, const char *text);
+
 /**
  * Get the currently showing text view for the results object.
  *
@@ -43,7 +43,7 @@ enum opt_values
 	DIFF_AUDITALLOW, DIFF_DONTAUDIT, DIFF_NEVERALLOW,
 	DIFF_TYPE_CHANGE, DIFF_TYPE_MEMBER, DIFF_TYPE_TRANS,
 	DIFF_ROLE_TRANS, DIFF_ROLE_ALLOW, DIFF_RANGE_TRANS,
-	OPT_STATS
+	OPT_STATS, OPT_STREAM, OPT_TIMING
 };
 
 /* command line options struct */
@@ -67,6 +67,8 @@ static struct option const longopts[] = {
 	{"role_allow", no_argument, NULL, DIFF_ROLE_ALLOW},
 	{"range_trans", no_argument, NULL, DIFF_RANGE_TRANS},
 	{"stats", no_argument, NULL, OPT_STATS},
+	{"stream", no_argument, NULL, OPT_STREAM},
+	{"timing", no_argument, NULL, OPT_TIMING},
 	{"quiet", no_argument, NULL, 'q'},
 	{"help", no_argument, NULL, 'h'},
 	{"version", no_argument, NULL, 'V'},
@@ -104,6 +106,8 @@ static void usage(const char *prog_name, int brief)
 	printf("\n");
 	printf("  -q, --quiet        suppress status output for elements with no differences\n");
 	printf("  --stats            print only statistics\n");
+	printf("  --stream           print differences as they are found, then statistics\n");
+	printf("  --timing           print the time taken by each phase of work\n");
 	printf("  -h, --help         print this help text and exit\n");
 	printf("  -V, --version      print version information and exit\n\n");
 }
@@ -152,6 +156,30 @@ static void print_rule_section(const poldiff_t * diff, const poldiff_component_r
 	}
 }
 
+/**
+ * Stream callback that prints each difference as soon as it is found,
+ * preceded by a header whenever the kind of difference changes.
+ */
+static int print_stream_item(const poldiff_t * diff, const poldiff_component_record_t * rec, const void *item, void *arg)
+{
+	const poldiff_component_record_t **last_rec = arg;
+	char *str = NULL;
+
+	if (rec != *last_rec) {
+		if (*last_rec != NULL)
+			printf("\n");
+		printf("%s:\n", poldiff_component_record_get_label(rec));
+		*last_rec = rec;
+	}
+	if ((str = poldiff_component_record_get_to_string_fn(rec) (diff, item)) == NULL) {
+		return -1;
+	}
+	print_diff_string(str, 1);
+	printf("\n");
+	free(str);
+	return 0;
+}
+
 #define PRINT_ADDED_REMOVED 1
 #define PRINT_MODIFIED  2
 #define PRINT_ALL 4
@@ -406,7 +434,7 @@ static void print_diff(const poldiff_t * diff, uint32_t flags, int stats, int qu
 
 int main(int argc, char **argv)
 {
-	int optc = 0, quiet = 0, stats = 0, default_all = 0;
+	int optc = 0, quiet = 0, stats = 0, stream = 0, timing = 0, default_all = 0;
 	uint32_t flags = 0;
 	apol_policy_t *orig_policy = NULL, *mod_policy = NULL;
 	apol_policy_path_type_e orig_path_type = APOL_POLICY_PATH_TYPE_MONOLITHIC;
@@ -481,6 +509,12 @@ int main(int argc, char **argv)
 		case OPT_STATS:
 			stats = 1;
 			break;
+		case OPT_STREAM:
+			stream = 1;
+			break;
+		case OPT_TIMING:
+			timing = 1;
+			break;
 		case 'q':
 			quiet = 1;
 			break;
@@ -624,14 +658,34 @@ int main(int argc, char **argv)
 	/* poldiff now owns the policies */
 	orig_policy = mod_policy = NULL;
 
+	/* when streaming, differences are printed and then discarded
+	 * as they are found; only the statistics are kept */
+	const poldiff_component_record_t *last_rec = NULL;
+	if (stream && !stats && poldiff_set_stream_callback(diff, print_stream_item, &last_rec, 0)) {
+		ERR(NULL, "%s", strerror(errno));
+		goto err;
+	}
+
 	if (poldiff_run(diff, flags)) {
 		goto err;
 	}
 
-	print_diff(diff, flags, stats, quiet);
+	if (stream && !stats) {
+		if (last_rec != NULL)
+			printf("\n");
+		print_diff(diff, flags, 1, quiet);
+	} else {
+		print_diff(diff, flags, stats, quiet);
+	}
 
 	total = get_diff_total(diff, flags);
 
+	if (timing) {
+		qpol_stats_print(qpol_policy_get_stats(orig_qpol), "Timing of original policy:", stderr);
+		qpol_stats_print(qpol_policy_get_stats(mod_qpol), "Timing of modified policy:", stderr);
+		qpol_stats_print(poldiff_get_run_stats(diff), "Timing of differences:", stderr);
+	}
+
 	apol_policy_path_destroy(&orig_pol_path);
 	apol_policy_path_destroy(&mod_pol_path);
 	poldiff_destroy(&diff);
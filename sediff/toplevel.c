@@ -426,6 +426,14 @@ GtkTextView *toplevel_get_text_view(toplevel_t * top)
 	return NULL;
 }
 
+int toplevel_render_match(toplevel_t * top, const char *text)
+{
+	if (gtk_notebook_get_current_page(top->notebook) != 0) {
+		return 0;
+	}
+	return results_render_match(top->results, text);
+}
+
 poldiff_t *toplevel_get_poldiff(toplevel_t * top)
 {
 	return sediffx_get_poldiff(top->s, progress_poldiff_handle_func, top->progress);
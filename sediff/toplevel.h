@@ -159,6 +159,19 @@ GtkWindow *toplevel_get_window(toplevel_t * top);
  */
 GtkTextView *toplevel_get_text_view(toplevel_t * top);
 
+/**
+ * Search the results that have not yet been rendered into the
+ * currently showing text view for some text, and render them through
+ * the first match.  This does nothing unless the results page is
+ * showing.
+ *
+ * @param top Toplevel containing results.
+ * @param text Text to find.
+ *
+ * @return Non-zero if a match was rendered, zero if not.
+ */
+int toplevel_render_match(toplevel_t * top, const char *text);
+
 /**
  * Retrieve the currently active poldiff object.  If policies have not
  * yet been loaded then this returns NULL.  Note that the poldiff